@@ -28,6 +28,7 @@
 
 #include "abd.h"
 #include "abd_serialization.h"
+#include "gnunet-service-abd_cache.h"
 #include "gnunet_abd_service.h"
 #include "gnunet_protocols.h"
 #include "gnunet_statistics_service.h"
@@ -39,6 +40,17 @@
 
 #define GNUNET_ABD_MAX_LENGTH 255
 
+/**
+ * How many delegation lookup results do we keep?
+ */
+#define ABD_CACHE_SIZE 4096
+
+/**
+ * For how long do we keep a delegation lookup result at most?
+ */
+#define ABD_CACHE_MAX_TTL GNUNET_TIME_relative_multiply ( \
+          GNUNET_TIME_UNIT_MINUTES, 5)
+
 struct VerifyRequestHandle;
 
 struct DelegationSetQueueEntry;
@@ -147,9 +159,9 @@ struct DelegationSetQueueEntry
   struct DelegationSetQueueEntry *prev;
 
   /**
-   * GNS handle
+   * Lookup handle
    */
-  struct GNUNET_GNS_LookupRequest *lookup_request;
+  struct ABD_CacheLookup *lookup_request;
 
   /**
    * Verify handle
@@ -373,7 +385,7 @@ cleanup_dsq_entry (struct DelegationSetQueueEntry *ds_entry)
   }
   if (NULL != ds_entry->lookup_request)
   {
-    GNUNET_GNS_lookup_cancel (ds_entry->lookup_request);
+    ABD_cache_lookup_cancel (ds_entry->lookup_request);
     ds_entry->lookup_request = NULL;
   }
   if (NULL != ds_entry->delegation_chain_entry)
@@ -444,6 +456,7 @@ shutdown_task (void *cls)
     cleanup_handle (vrh);
   }
 
+  ABD_cache_done ();
   if (NULL != gns)
   {
     GNUNET_GNS_disconnect (gns);
@@ -970,13 +983,11 @@ forward_resolution (void *cls,
                 GNUNET_CRYPTO_public_key_to_string (&del->issuer_key));
 
     ds_entry->lookup_request =
-      GNUNET_GNS_lookup (gns,
-                         GNUNET_GNS_EMPTY_LABEL_AT,
-                         &del->issuer_key,
-                         GNUNET_GNSRECORD_TYPE_DELEGATE,
-                         GNUNET_GNS_LO_DEFAULT,
-                         &forward_resolution,
-                         ds_entry);
+      ABD_cache_lookup (GNUNET_GNS_EMPTY_LABEL_AT,
+                        &del->issuer_key,
+                        GNUNET_GNSRECORD_TYPE_DELEGATE,
+                        &forward_resolution,
+                        ds_entry);
     GNUNET_free (del);
   }
 
@@ -1221,13 +1232,11 @@ backward_resolution (void *cls,
       vrh->pending_lookups++;
       ds_entry->handle = vrh;
       ds_entry->lookup_request =
-        GNUNET_GNS_lookup (gns,
-                           lookup_attribute,
-                           ds_entry->issuer_key, // issuer_key,
-                           GNUNET_GNSRECORD_TYPE_ATTRIBUTE,
-                           GNUNET_GNS_LO_DEFAULT,
-                           &backward_resolution,
-                           ds_entry);
+        ABD_cache_lookup (lookup_attribute,
+                          ds_entry->issuer_key, // issuer_key,
+                          GNUNET_GNSRECORD_TYPE_ATTRIBUTE,
+                          &backward_resolution,
+                          ds_entry);
 
       GNUNET_free (lookup_attribute);
     }
@@ -1316,13 +1325,11 @@ delegation_chain_bw_resolution_start (void *cls)
   // Start with backward resolution
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Start Backward Resolution\n");
 
-  ds_entry->lookup_request = GNUNET_GNS_lookup (gns,
-                                                issuer_attribute_name,
-                                                &vrh->issuer_key, // issuer_key,
-                                                GNUNET_GNSRECORD_TYPE_ATTRIBUTE,
-                                                GNUNET_GNS_LO_DEFAULT,
-                                                &backward_resolution,
-                                                ds_entry);
+  ds_entry->lookup_request = ABD_cache_lookup (issuer_attribute_name,
+                                               &vrh->issuer_key, // issuer_key,
+                                               GNUNET_GNSRECORD_TYPE_ATTRIBUTE,
+                                               &backward_resolution,
+                                               ds_entry);
   return 0;
 }
 
@@ -1409,13 +1416,11 @@ delegation_chain_fw_resolution_start (void *cls)
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Start Forward Resolution\n");
 
     ds_entry->lookup_request =
-      GNUNET_GNS_lookup (gns,
-                         GNUNET_GNS_EMPTY_LABEL_AT,
-                         &del_entry->delegate->issuer_key, // issuer_key,
-                         GNUNET_GNSRECORD_TYPE_DELEGATE,
-                         GNUNET_GNS_LO_DEFAULT,
-                         &forward_resolution,
-                         ds_entry);
+      ABD_cache_lookup (GNUNET_GNS_EMPTY_LABEL_AT,
+                        &del_entry->delegate->issuer_key, // issuer_key,
+                        GNUNET_GNSRECORD_TYPE_DELEGATE,
+                        &forward_resolution,
+                        ds_entry);
   }
   return 0;
 }
@@ -1757,6 +1762,10 @@ run (void *cls,
   }
 
   statistics = GNUNET_STATISTICS_create ("abd", c);
+  ABD_cache_init (gns,
+                  ABD_CACHE_SIZE,
+                  ABD_CACHE_MAX_TTL,
+                  statistics);
   GNUNET_SCHEDULER_add_shutdown (&shutdown_task, NULL);
 }
 
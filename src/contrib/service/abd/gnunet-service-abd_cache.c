@@ -0,0 +1,485 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+*/
+/**
+ * @file abd/gnunet-service-abd_cache.c
+ * @brief cache of the delegation records the ABD service resolved
+ *
+ * Verifying many credentials against the same issuer walks the same
+ * delegations over and over, and a single bidirectional search may
+ * ask for the same records from several branches.  We keep the
+ * records of every (zone, label, type) we looked up until they
+ * expire, and let lookups that arrive while GNS is still resolving
+ * wait for that result instead of starting another lookup.  Empty
+ * results are not kept, so new delegations are found right away.
+ */
+#include "platform.h"
+#include "gnunet-service-abd_cache.h"
+
+
+/**
+ * Records of one (zone, label, type), or the lookup for them.
+ */
+struct CacheEntry
+{
+  /**
+   * Kept in a DLL of complete entries, most recently used first.
+   */
+  struct CacheEntry *next;
+
+  /**
+   * Kept in a DLL of complete entries, most recently used first.
+   */
+  struct CacheEntry *prev;
+
+  /**
+   * Lookups waiting for the records.
+   */
+  struct ABD_CacheLookup *waiting_head;
+
+  /**
+   * Lookups waiting for the records.
+   */
+  struct ABD_CacheLookup *waiting_tail;
+
+  /**
+   * GNS lookup for the records, NULL once we have them.
+   */
+  struct GNUNET_GNS_LookupRequest *lr;
+
+  /**
+   * The records, their data follows the array.
+   */
+  struct GNUNET_GNSRECORD_Data *rd;
+
+  /**
+   * Number of records in @e rd.
+   */
+  unsigned int rd_count;
+
+  /**
+   * When do we have to look the records up again?
+   */
+  struct GNUNET_TIME_Absolute expiration;
+
+  /**
+   * Key in #entries.
+   */
+  struct GNUNET_HashCode key;
+
+  /**
+   * Are we passing the records GNS just resolved to the waiting
+   * lookups?  Then the entry must stay, even if it expired.
+   */
+  bool delivering;
+};
+
+
+/**
+ * Handle for a pending lookup.
+ */
+struct ABD_CacheLookup
+{
+  /**
+   * Kept in a DLL at @e entry.
+   */
+  struct ABD_CacheLookup *next;
+
+  /**
+   * Kept in a DLL at @e entry.
+   */
+  struct ABD_CacheLookup *prev;
+
+  /**
+   * The entry we are waiting for.
+   */
+  struct CacheEntry *entry;
+
+  /**
+   * Task passing the records of a complete entry to @e proc.
+   */
+  struct GNUNET_SCHEDULER_Task *task;
+
+  /**
+   * Function to call with the records.
+   */
+  GNUNET_GNS_LookupResultProcessor proc;
+
+  /**
+   * Closure for @e proc.
+   */
+  void *proc_cls;
+};
+
+
+/**
+ * Handle to GNS.
+ */
+static struct GNUNET_GNS_Handle *gns;
+
+/**
+ * Handle for statistics, can be NULL.
+ */
+static struct GNUNET_STATISTICS_Handle *cache_stats;
+
+/**
+ * Maps the hash of (zone, label, type) to the `struct CacheEntry`.
+ */
+static struct GNUNET_CONTAINER_MultiHashMap *entries;
+
+/**
+ * Complete entries, most recently used first.
+ */
+static struct CacheEntry *lru_head;
+
+/**
+ * Complete entries, most recently used first.
+ */
+static struct CacheEntry *lru_tail;
+
+/**
+ * Number of entries in the LRU list.
+ */
+static unsigned int lru_size;
+
+/**
+ * Maximum value for #lru_size.
+ */
+static unsigned int lru_max;
+
+/**
+ * Maximum time to keep records.
+ */
+static struct GNUNET_TIME_Relative cache_max_ttl;
+
+
+/**
+ * Remove @a ce from the cache and free it.  There must not be
+ * any lookups waiting for it.
+ *
+ * @param ce entry to free
+ */
+static void
+free_entry (struct CacheEntry *ce)
+{
+  GNUNET_assert (NULL == ce->waiting_head);
+  GNUNET_assert (GNUNET_YES ==
+                 GNUNET_CONTAINER_multihashmap_remove (entries,
+                                                       &ce->key,
+                                                       ce));
+  if (NULL != ce->lr)
+  {
+    GNUNET_GNS_lookup_cancel (ce->lr);
+  }
+  else
+  {
+    GNUNET_CONTAINER_DLL_remove (lru_head,
+                                 lru_tail,
+                                 ce);
+    lru_size--;
+  }
+  GNUNET_free (ce->rd);
+  GNUNET_free (ce);
+}
+
+
+/**
+ * Pass the records of a complete entry to a lookup.
+ *
+ * @param cls the `struct ABD_CacheLookup`
+ */
+static void
+deliver (void *cls)
+{
+  struct ABD_CacheLookup *cl = cls;
+  struct CacheEntry *ce = cl->entry;
+
+  cl->task = NULL;
+  GNUNET_CONTAINER_DLL_remove (ce->waiting_head,
+                               ce->waiting_tail,
+                               cl);
+  cl->proc (cl->proc_cls,
+            ce->rd_count,
+            ce->rd);
+  GNUNET_free (cl);
+}
+
+
+/**
+ * Drop least recently used entries until the cache is small
+ * enough.  Entries with lookups waiting for them stay.
+ */
+static void
+trim_cache (void)
+{
+  struct CacheEntry *ce = lru_tail;
+  struct CacheEntry *prev;
+
+  while ( (lru_size > lru_max) &&
+          (NULL != ce) )
+  {
+    prev = ce->prev;
+    if (NULL == ce->waiting_head)
+      free_entry (ce);
+    ce = prev;
+  }
+}
+
+
+/**
+ * GNS resolved the records of an entry.
+ *
+ * @param cls the `struct CacheEntry`
+ * @param rd_count number of records in @a rd
+ * @param rd the records
+ */
+static void
+handle_gns_result (void *cls,
+                   uint32_t rd_count,
+                   const struct GNUNET_GNSRECORD_Data *rd)
+{
+  struct CacheEntry *ce = cls;
+  struct ABD_CacheLookup *cl;
+  size_t data_size = 0;
+  char *data;
+
+  ce->lr = NULL;
+  for (uint32_t i = 0; i < rd_count; i++)
+    data_size += rd[i].data_size;
+  ce->rd = GNUNET_malloc (rd_count * sizeof (struct GNUNET_GNSRECORD_Data)
+                          + data_size);
+  ce->rd_count = rd_count;
+  data = (char *) &ce->rd[rd_count];
+  for (uint32_t i = 0; i < rd_count; i++)
+  {
+    ce->rd[i] = rd[i];
+    ce->rd[i].data = data;
+    GNUNET_memcpy (data,
+                   rd[i].data,
+                   rd[i].data_size);
+    data += rd[i].data_size;
+  }
+  if (0 == rd_count)
+    ce->expiration = GNUNET_TIME_UNIT_ZERO_ABS;
+  else
+    ce->expiration = GNUNET_TIME_absolute_min (
+      GNUNET_GNSRECORD_record_get_expiration_time (rd_count,
+                                                   rd,
+                                                   GNUNET_TIME_UNIT_ZERO_ABS),
+      GNUNET_TIME_relative_to_absolute (cache_max_ttl));
+  GNUNET_CONTAINER_DLL_insert (lru_head,
+                               lru_tail,
+                               ce);
+  lru_size++;
+  /* the processors may cancel other lookups waiting here, or add
+     lookups for these records, which get their own #deliver task;
+     #ABD_cache_lookup() must not free the entry meanwhile */
+  ce->delivering = true;
+  while ( (NULL != (cl = ce->waiting_head)) &&
+          (NULL == cl->task) )
+  {
+    GNUNET_CONTAINER_DLL_remove (ce->waiting_head,
+                                 ce->waiting_tail,
+                                 cl);
+    cl->proc (cl->proc_cls,
+              ce->rd_count,
+              ce->rd);
+    GNUNET_free (cl);
+  }
+  ce->delivering = false;
+  if ( (NULL == ce->waiting_head) &&
+       GNUNET_TIME_absolute_is_past (ce->expiration) )
+    free_entry (ce);
+  else
+    trim_cache ();
+}
+
+
+void
+ABD_cache_init (struct GNUNET_GNS_Handle *g,
+                unsigned int max_entries,
+                struct GNUNET_TIME_Relative max_ttl,
+                struct GNUNET_STATISTICS_Handle *stats)
+{
+  gns = g;
+  lru_max = max_entries;
+  cache_max_ttl = max_ttl;
+  cache_stats = stats;
+  entries = GNUNET_CONTAINER_multihashmap_create (16,
+                                                  GNUNET_NO);
+}
+
+
+/**
+ * Drop the lookups waiting for an entry and free it.
+ *
+ * @param cls NULL
+ * @param key unused
+ * @param value the `struct CacheEntry`
+ * @return #GNUNET_OK to continue to iterate
+ */
+static enum GNUNET_GenericReturnValue
+free_entry_it (void *cls,
+               const struct GNUNET_HashCode *key,
+               void *value)
+{
+  struct CacheEntry *ce = value;
+  struct ABD_CacheLookup *cl;
+
+  (void) cls;
+  (void) key;
+  while (NULL != (cl = ce->waiting_head))
+  {
+    if (NULL != cl->task)
+      GNUNET_SCHEDULER_cancel (cl->task);
+    GNUNET_CONTAINER_DLL_remove (ce->waiting_head,
+                                 ce->waiting_tail,
+                                 cl);
+    GNUNET_free (cl);
+  }
+  free_entry (ce);
+  return GNUNET_OK;
+}
+
+
+void
+ABD_cache_done ()
+{
+  if (NULL == entries)
+    return;
+  GNUNET_CONTAINER_multihashmap_iterate (entries,
+                                         &free_entry_it,
+                                         NULL);
+  GNUNET_break (0 == lru_size);
+  GNUNET_CONTAINER_multihashmap_destroy (entries);
+  entries = NULL;
+  cache_stats = NULL;
+  gns = NULL;
+}
+
+
+struct ABD_CacheLookup *
+ABD_cache_lookup (const char *label,
+                  const struct GNUNET_CRYPTO_PublicKey *zone,
+                  uint32_t type,
+                  GNUNET_GNS_LookupResultProcessor proc,
+                  void *proc_cls)
+{
+  struct GNUNET_HashContext *hc;
+  struct GNUNET_HashCode key;
+  struct CacheEntry *ce;
+  struct ABD_CacheLookup *cl;
+  uint32_t ntype = htonl (type);
+
+  hc = GNUNET_CRYPTO_hash_context_start ();
+  GNUNET_CRYPTO_hash_context_read (hc,
+                                   zone,
+                                   GNUNET_CRYPTO_public_key_get_length (zone));
+  GNUNET_CRYPTO_hash_context_read (hc,
+                                   &ntype,
+                                   sizeof (ntype));
+  GNUNET_CRYPTO_hash_context_read (hc,
+                                   label,
+                                   strlen (label));
+  GNUNET_CRYPTO_hash_context_finish (hc,
+                                     &key);
+  ce = GNUNET_CONTAINER_multihashmap_get (entries,
+                                          &key);
+  if ( (NULL != ce) &&
+       (NULL == ce->lr) &&
+       (NULL == ce->waiting_head) &&
+       (! ce->delivering) &&
+       GNUNET_TIME_absolute_is_past (ce->expiration) )
+  {
+    free_entry (ce);
+    ce = NULL;
+  }
+  cl = GNUNET_new (struct ABD_CacheLookup);
+  cl->proc = proc;
+  cl->proc_cls = proc_cls;
+  if (NULL == ce)
+  {
+    GNUNET_STATISTICS_update (cache_stats,
+                              "# delegation cache misses",
+                              1,
+                              GNUNET_NO);
+    ce = GNUNET_new (struct CacheEntry);
+    ce->key = key;
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multihashmap_put (
+                     entries,
+                     &ce->key,
+                     ce,
+                     GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST));
+    ce->lr = GNUNET_GNS_lookup (gns,
+                                label,
+                                zone,
+                                type,
+                                GNUNET_GNS_LO_DEFAULT,
+                                &handle_gns_result,
+                                ce);
+  }
+  else if (NULL != ce->lr)
+  {
+    GNUNET_STATISTICS_update (cache_stats,
+                              "# delegation lookups coalesced",
+                              1,
+                              GNUNET_NO);
+  }
+  else
+  {
+    GNUNET_STATISTICS_update (cache_stats,
+                              "# delegation cache hits",
+                              1,
+                              GNUNET_NO);
+    GNUNET_CONTAINER_DLL_remove (lru_head,
+                                 lru_tail,
+                                 ce);
+    GNUNET_CONTAINER_DLL_insert (lru_head,
+                                 lru_tail,
+                                 ce);
+    cl->task = GNUNET_SCHEDULER_add_now (&deliver,
+                                         cl);
+  }
+  cl->entry = ce;
+  GNUNET_CONTAINER_DLL_insert_tail (ce->waiting_head,
+                                    ce->waiting_tail,
+                                    cl);
+  return cl;
+}
+
+
+void
+ABD_cache_lookup_cancel (struct ABD_CacheLookup *cl)
+{
+  struct CacheEntry *ce = cl->entry;
+
+  if (NULL != cl->task)
+    GNUNET_SCHEDULER_cancel (cl->task);
+  GNUNET_CONTAINER_DLL_remove (ce->waiting_head,
+                               ce->waiting_tail,
+                               cl);
+  GNUNET_free (cl);
+  if ( (NULL != ce->lr) &&
+       (NULL == ce->waiting_head) )
+    free_entry (ce);
+}
+
+
+/* end of gnunet-service-abd_cache.c */
@@ -0,0 +1,92 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+*/
+/**
+ * @file abd/gnunet-service-abd_cache.h
+ * @brief cache of the delegation records the ABD service resolved
+ */
+#ifndef GNUNET_SERVICE_ABD_CACHE_H
+#define GNUNET_SERVICE_ABD_CACHE_H
+
+#include "gnunet_util_lib.h"
+#include "gnunet_gns_service.h"
+#include "gnunet_statistics_service.h"
+
+
+/**
+ * Handle for a pending lookup.
+ */
+struct ABD_CacheLookup;
+
+
+/**
+ * Initialize the cache.
+ *
+ * @param gns handle to GNS, used for lookups that miss the cache
+ * @param max_entries maximum number of results to keep
+ * @param max_ttl maximum time to keep a result, even if its
+ *        records are valid for longer
+ * @param stats handle for statistics, can be NULL
+ */
+void
+ABD_cache_init (struct GNUNET_GNS_Handle *gns,
+                unsigned int max_entries,
+                struct GNUNET_TIME_Relative max_ttl,
+                struct GNUNET_STATISTICS_Handle *stats);
+
+
+/**
+ * Cancel all lookups and forget all results.
+ */
+void
+ABD_cache_done (void);
+
+
+/**
+ * Look up the records of type @a type under @a label in @a zone,
+ * like #GNUNET_GNS_lookup() with #GNUNET_GNS_LO_DEFAULT.  Results
+ * are kept until their records expire, and concurrent lookups of
+ * the same records share one GNS lookup.  @a proc is never called
+ * before this function returns.
+ *
+ * @param label label to look up
+ * @param zone zone to look in
+ * @param type record type to look up
+ * @param proc function to call with the result
+ * @param proc_cls closure for @a proc
+ * @return handle to cancel the lookup
+ */
+struct ABD_CacheLookup *
+ABD_cache_lookup (const char *label,
+                  const struct GNUNET_CRYPTO_PublicKey *zone,
+                  uint32_t type,
+                  GNUNET_GNS_LookupResultProcessor proc,
+                  void *proc_cls);
+
+
+/**
+ * Cancel a lookup; its processor will not be called.
+ *
+ * @param cl the lookup
+ */
+void
+ABD_cache_lookup_cancel (struct ABD_CacheLookup *cl);
+
+
+#endif
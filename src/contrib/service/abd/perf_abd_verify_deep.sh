@@ -0,0 +1,90 @@
+#!/usr/bin/env bash
+# Verify credentials of many subjects over a deep chain of delegations,
+# measuring the first (cold) and the second (warm) round of verifications.
+trap "gnunet-arm -e -c test_abd_lookup.conf" SIGINT
+
+LOCATION=$(which gnunet-config)
+if [ -z $LOCATION ]
+then
+  LOCATION="gnunet-config"
+fi
+$LOCATION --version 1> /dev/null
+if test $? != 0
+then
+	echo "GNUnet command line tools cannot be found, check environmental variables PATH and GNUNET_PREFIX"
+	exit 77
+fi
+
+rm -rf `gnunet-config -c test_abd_lookup.conf -s PATHS -o GNUNET_HOME -f`
+
+#   (1) I0.a <- I1.a
+#   (2) I1.a <- I2.a
+#   ...
+#   (DEPTH-1) I(DEPTH-2).a <- I(DEPTH-1).a
+#   (DEPTH) I(DEPTH-1).a <- S0, S1, ..., S(SUBJECTS-1)
+DEPTH=8
+SUBJECTS=16
+
+which timeout > /dev/null 2>&1 && DO_TIMEOUT="timeout 30"
+gnunet-arm -s -c test_abd_lookup.conf
+
+key ()
+{
+  gnunet-identity -d -c test_abd_lookup.conf | awk -v n="$1" '$1 == n {print $3}'
+}
+
+for i in $(seq 0 $((DEPTH - 1)))
+do
+  gnunet-identity -C i$i -c test_abd_lookup.conf
+done
+for s in $(seq 0 $((SUBJECTS - 1)))
+do
+  gnunet-identity -C s$s -c test_abd_lookup.conf
+done
+ISSUER_KEY=$(key i0)
+
+for i in $(seq 1 $((DEPTH - 1)))
+do
+  gnunet-abd --createIssuerSide --ego=i$((i - 1)) --attribute="a" --subject="$(key i$i) a" --ttl=5m -c test_abd_lookup.conf
+done
+for s in $(seq 0 $((SUBJECTS - 1)))
+do
+  SIGNED=`$DO_TIMEOUT gnunet-abd --signSubjectSide --ego=i$((DEPTH - 1)) --attribute="a" --subject="$(key s$s)" --ttl="2030-12-12 10:00:00" -c test_abd_lookup.conf`
+  gnunet-abd --createSubjectSide --ego=s$s --import="$SIGNED" --private -c test_abd_lookup.conf
+done
+
+RES=0
+verify_all ()
+{
+  START=$(date +%s%N)
+  for s in $(seq 0 $((SUBJECTS - 1)))
+  do
+    DELS=`$DO_TIMEOUT gnunet-abd --collect --issuer=$ISSUER_KEY --attribute="a" --ego=s$s -c test_abd_lookup.conf | paste -d, -s - -`
+    $DO_TIMEOUT gnunet-abd --verify --issuer=$ISSUER_KEY --attribute="a" --subject=$(key s$s) --delegate="$DELS" -c test_abd_lookup.conf > /dev/null || RES=1
+  done
+  END=$(date +%s%N)
+  echo "$1: $SUBJECTS subjects collected and verified over $DEPTH delegations in $(( (END - START) / 1000000 )) ms"
+}
+
+verify_all "cold"
+verify_all "warm"
+gnunet-statistics -s abd -c test_abd_lookup.conf
+
+# Cleanup properly
+for i in $(seq 0 $((DEPTH - 2)))
+do
+  gnunet-namestore -z i$i -d -n "a" -t ATTR -c test_abd_lookup.conf
+done
+for s in $(seq 0 $((SUBJECTS - 1)))
+do
+  gnunet-namestore -z s$s -d -n "@" -t DEL -c test_abd_lookup.conf
+done
+gnunet-arm -e -c test_abd_lookup.conf
+
+if [ "$RES" == 0 ]
+then
+  exit 0
+else
+  echo "FAIL: Failed to verify credential."
+  exit 1
+fi
@@ -370,6 +370,8 @@ ogg_demux_and_decode ()
   int eos = 0;
   static int total_links;
   static int gran_offset;
+  static int lost_packet;
+  int po;
 
   while (1 == ogg_sync_pageout (&oy, &og))
   {
@@ -394,8 +396,16 @@ ogg_demux_and_decode ()
                 "Reading page that ends at %" PRId64 "\n",
                 page_granule);
     /*Extract all available packets*/
-    while (1 == ogg_stream_packetout (&os, &op))
+    while (0 != (po = ogg_stream_packetout (&os, &op)))
     {
+      if (-1 == po)
+      {
+        /* a page did not make it (or was dropped by the jitter buffer) */
+        GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                    "Hole in the stream, concealing\n");
+        lost_packet = 1;
+        continue;
+      }
       /*OggOpus streams are identified by a magic string in the initial
          stream header.*/
       if (op.b_o_s && (op.bytes >= 8) && ! memcmp (op.packet, "OpusHead", 8))
@@ -514,6 +524,38 @@ ogg_demux_and_decode ()
           eos = 1;         /* don't care for anything except opus eos */
         }
 
+        /*Conceal a lost packet: recover it from the in-band FEC data the
+           record helper adds to this packet, or fall back to PLC.*/
+        if (lost_packet)
+        {
+          int lost_size;
+
+          lost_packet = 0;
+          lost_size = opus_packet_get_nb_samples (
+            (const unsigned char *) op.packet,
+            op.bytes,
+            SAMPLING_RATE);
+          if ((0 < lost_size) && (lost_size <= MAX_FRAME_SIZE))
+          {
+            ret = opus_decode_float (dec,
+                                     (const unsigned char *) op.packet,
+                                     op.bytes,
+                                     pcm_buffer,
+                                     lost_size, 1);
+            if (0 > ret)
+              ret = opus_decode_float (dec,
+                                       NULL,
+                                       0,
+                                       pcm_buffer,
+                                       lost_size, 0);
+            if (0 < ret)
+            {
+              frame_size = ret;
+              link_out += audio_write (ret);
+            }
+          }
+        }
+
         /*Decode Opus packet*/
         ret = opus_decode_float (dec,
                                  (const unsigned char *) op.packet,
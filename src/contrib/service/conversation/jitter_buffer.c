@@ -0,0 +1,325 @@
+/*
+   This file is part of GNUnet
+   Copyright (C) 2026 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file conversation/jitter_buffer.c
+ * @brief adaptive reordering jitter buffer for audio frames
+ *
+ * Frames that arrive in order are released immediately.  If a frame
+ * is missing, its successors are held back for at most the target
+ * delay, which follows the smoothed inter-arrival jitter (estimated
+ * as in RFC 3550, section 6.4.1).  Frames arriving after their slot
+ * was skipped are dropped, so the playback helper sees a gap and can
+ * conceal it.
+ */
+#include "platform.h"
+#include "jitter_buffer.h"
+
+
+/**
+ * How many times the jitter estimate do we wait for a missing frame?
+ */
+#define JITTER_MULTIPLIER 4
+
+
+/**
+ * A frame in the jitter buffer.
+ */
+struct Frame
+{
+  /**
+   * Kept in a DLL sorted by @e seq.
+   */
+  struct Frame *next;
+
+  /**
+   * Kept in a DLL sorted by @e seq.
+   */
+  struct Frame *prev;
+
+  /**
+   * Until when do we hold this frame back if its
+   * predecessor is missing?
+   */
+  struct GNUNET_TIME_Absolute deadline;
+
+  /**
+   * Number of bytes of data following this struct.
+   */
+  size_t data_size;
+
+  /**
+   * Sequence number of the frame.
+   */
+  uint32_t seq;
+
+  /* followed by data_size bytes of data */
+};
+
+
+/**
+ * Handle for a jitter buffer.
+ */
+struct CONVERSATION_JITTER_Buffer
+{
+  /**
+   * Head of frames sorted by sequence number.
+   */
+  struct Frame *head;
+
+  /**
+   * Tail of frames sorted by sequence number.
+   */
+  struct Frame *tail;
+
+  /**
+   * Statistics we keep.
+   */
+  struct CONVERSATION_JITTER_Statistics stats;
+
+  /**
+   * Lower bound for the target delay.
+   */
+  struct GNUNET_TIME_Relative min_delay;
+
+  /**
+   * Upper bound for the target delay.
+   */
+  struct GNUNET_TIME_Relative max_delay;
+
+  /**
+   * Smoothed jitter estimate in microseconds, times 16.
+   */
+  uint64_t jitter16;
+
+  /**
+   * Relative transit time of the last frame with a media time.
+   */
+  int64_t last_transit;
+
+  /**
+   * Sequence number of the next frame to play.
+   */
+  uint32_t next_seq;
+
+  /**
+   * Is @e next_seq valid?
+   */
+  bool have_next;
+
+  /**
+   * Is @e last_transit valid?
+   */
+  bool have_transit;
+};
+
+
+/**
+ * Compare sequence numbers with wrap-around.
+ *
+ * @param a first sequence number
+ * @param b second sequence number
+ * @return negative if @a a is before @a b, 0 if equal, positive otherwise
+ */
+static int32_t
+seq_cmp (uint32_t a,
+         uint32_t b)
+{
+  return (int32_t) (a - b);
+}
+
+
+struct CONVERSATION_JITTER_Buffer *
+CONVERSATION_JITTER_create (struct GNUNET_TIME_Relative min_delay,
+                            struct GNUNET_TIME_Relative max_delay)
+{
+  struct CONVERSATION_JITTER_Buffer *jb;
+
+  jb = GNUNET_new (struct CONVERSATION_JITTER_Buffer);
+  jb->min_delay = min_delay;
+  jb->max_delay = GNUNET_TIME_relative_max (min_delay,
+                                            max_delay);
+  jb->stats.target_delay = min_delay;
+  return jb;
+}
+
+
+/**
+ * Update the jitter estimate and the target delay with the
+ * transit time of a new frame.
+ *
+ * @param jb the jitter buffer
+ * @param now arrival time of the frame
+ * @param media_time sender timestamp of the frame in microseconds
+ */
+static void
+update_jitter (struct CONVERSATION_JITTER_Buffer *jb,
+               struct GNUNET_TIME_Absolute now,
+               uint64_t media_time)
+{
+  int64_t transit;
+  uint64_t d;
+  struct GNUNET_TIME_Relative target;
+
+  transit = (int64_t) (now.abs_value_us - media_time);
+  if (jb->have_transit)
+  {
+    d = (transit > jb->last_transit)
+        ? (uint64_t) (transit - jb->last_transit)
+        : (uint64_t) (jb->last_transit - transit);
+    /* J += (|D| - J) / 16, with J kept scaled by 16 */
+    jb->jitter16 = jb->jitter16 + d - (jb->jitter16 + 8) / 16;
+  }
+  jb->last_transit = transit;
+  jb->have_transit = true;
+  jb->stats.jitter.rel_value_us = jb->jitter16 / 16;
+  target = GNUNET_TIME_relative_add (
+    jb->min_delay,
+    GNUNET_TIME_relative_multiply (jb->stats.jitter,
+                                   JITTER_MULTIPLIER));
+  jb->stats.target_delay = GNUNET_TIME_relative_min (target,
+                                                     jb->max_delay);
+}
+
+
+enum GNUNET_GenericReturnValue
+CONVERSATION_JITTER_insert (struct CONVERSATION_JITTER_Buffer *jb,
+                            struct GNUNET_TIME_Absolute now,
+                            uint32_t seq,
+                            uint64_t media_time,
+                            const void *data,
+                            size_t data_size)
+{
+  struct Frame *pos;
+  struct Frame *f;
+
+  if (jb->have_next &&
+      (seq_cmp (seq, jb->next_seq) < 0))
+  {
+    jb->stats.frames_late++;
+    return GNUNET_NO;
+  }
+  /* frames mostly arrive in order, so search from the tail */
+  for (pos = jb->tail; NULL != pos; pos = pos->prev)
+    if (seq_cmp (pos->seq, seq) <= 0)
+      break;
+  if ((NULL != pos) &&
+      (pos->seq == seq))
+  {
+    jb->stats.frames_duplicate++;
+    return GNUNET_NO;
+  }
+  if (CONVERSATION_JITTER_NO_MEDIA_TIME != media_time)
+    update_jitter (jb,
+                   now,
+                   media_time);
+  f = GNUNET_malloc (sizeof (struct Frame) + data_size);
+  f->seq = seq;
+  f->data_size = data_size;
+  f->deadline = GNUNET_TIME_absolute_add (now,
+                                          jb->stats.target_delay);
+  GNUNET_memcpy (&f[1],
+                 data,
+                 data_size);
+  GNUNET_CONTAINER_DLL_insert_after (jb->head,
+                                     jb->tail,
+                                     pos,
+                                     f);
+  jb->stats.frames_received++;
+  return GNUNET_OK;
+}
+
+
+struct GNUNET_TIME_Absolute
+CONVERSATION_JITTER_drain (struct CONVERSATION_JITTER_Buffer *jb,
+                           struct GNUNET_TIME_Absolute now,
+                           CONVERSATION_JITTER_PlayCallback cb,
+                           void *cb_cls)
+{
+  struct Frame *f;
+
+  while (NULL != (f = jb->head))
+  {
+    if (! jb->have_next)
+    {
+      /* hold the very first frame back, an earlier one may be in flight */
+      if (GNUNET_TIME_absolute_cmp (now, <, f->deadline))
+        return f->deadline;
+      jb->next_seq = f->seq;
+      jb->have_next = true;
+    }
+    if (f->seq != jb->next_seq)
+    {
+      if (GNUNET_TIME_absolute_cmp (now, <, f->deadline))
+        return f->deadline;
+      /* give up on the missing frames */
+      jb->stats.frames_lost += (uint32_t) (f->seq - jb->next_seq);
+      jb->next_seq = f->seq;
+    }
+    GNUNET_CONTAINER_DLL_remove (jb->head,
+                                 jb->tail,
+                                 f);
+    jb->next_seq++;
+    jb->stats.frames_played++;
+    cb (cb_cls,
+        f->seq,
+        &f[1],
+        f->data_size);
+    GNUNET_free (f);
+  }
+  return GNUNET_TIME_UNIT_FOREVER_ABS;
+}
+
+
+void
+CONVERSATION_JITTER_reset (struct CONVERSATION_JITTER_Buffer *jb)
+{
+  struct Frame *f;
+
+  while (NULL != (f = jb->head))
+  {
+    GNUNET_CONTAINER_DLL_remove (jb->head,
+                                 jb->tail,
+                                 f);
+    GNUNET_free (f);
+  }
+  jb->have_next = false;
+  jb->have_transit = false;
+}
+
+
+void
+CONVERSATION_JITTER_get_statistics (
+  const struct CONVERSATION_JITTER_Buffer *jb,
+  struct CONVERSATION_JITTER_Statistics *stats)
+{
+  *stats = jb->stats;
+}
+
+
+void
+CONVERSATION_JITTER_destroy (struct CONVERSATION_JITTER_Buffer *jb)
+{
+  CONVERSATION_JITTER_reset (jb);
+  GNUNET_free (jb);
+}
+
+
+/* end of jitter_buffer.c */
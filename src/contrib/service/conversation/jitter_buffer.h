@@ -0,0 +1,186 @@
+/*
+   This file is part of GNUnet
+   Copyright (C) 2026 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file conversation/jitter_buffer.h
+ * @brief adaptive reordering jitter buffer for audio frames
+ */
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include "gnunet_util_lib.h"
+
+
+/**
+ * Media time value to pass if a frame carries no usable timestamp.
+ */
+#define CONVERSATION_JITTER_NO_MEDIA_TIME UINT64_MAX
+
+
+/**
+ * Handle for a jitter buffer.
+ */
+struct CONVERSATION_JITTER_Buffer;
+
+
+/**
+ * Statistics about a jitter buffer.
+ */
+struct CONVERSATION_JITTER_Statistics
+{
+  /**
+   * Number of frames accepted into the buffer.
+   */
+  uint64_t frames_received;
+
+  /**
+   * Number of frames handed out for playback.
+   */
+  uint64_t frames_played;
+
+  /**
+   * Number of frames dropped because they arrived after
+   * their successors were already played.
+   */
+  uint64_t frames_late;
+
+  /**
+   * Number of duplicate frames dropped.
+   */
+  uint64_t frames_duplicate;
+
+  /**
+   * Number of frames skipped because they did not arrive
+   * within the target delay.
+   */
+  uint64_t frames_lost;
+
+  /**
+   * Current smoothed inter-arrival jitter estimate.
+   */
+  struct GNUNET_TIME_Relative jitter;
+
+  /**
+   * Current target delay we wait for missing frames.
+   */
+  struct GNUNET_TIME_Relative target_delay;
+};
+
+
+/**
+ * Function called with a frame that is due for playback.
+ * Frames are delivered in sequence number order.
+ *
+ * @param cls closure
+ * @param seq sequence number of the frame
+ * @param data frame data
+ * @param data_size number of bytes in @a data
+ */
+typedef void
+(*CONVERSATION_JITTER_PlayCallback)(void *cls,
+                                    uint32_t seq,
+                                    const void *data,
+                                    size_t data_size);
+
+
+/**
+ * Create a jitter buffer.  The target delay adapts to the measured
+ * inter-arrival jitter within the given bounds.
+ *
+ * @param min_delay lower bound for the target delay
+ * @param max_delay upper bound for the target delay
+ * @return the jitter buffer
+ */
+struct CONVERSATION_JITTER_Buffer *
+CONVERSATION_JITTER_create (struct GNUNET_TIME_Relative min_delay,
+                            struct GNUNET_TIME_Relative max_delay);
+
+
+/**
+ * Add a frame to the jitter buffer.
+ *
+ * @param jb the jitter buffer
+ * @param now arrival time of the frame
+ * @param seq sequence number of the frame
+ * @param media_time sender timestamp of the frame in microseconds,
+ *        or #CONVERSATION_JITTER_NO_MEDIA_TIME
+ * @param data frame data, copied
+ * @param data_size number of bytes in @a data
+ * @return #GNUNET_OK if the frame was queued,
+ *         #GNUNET_NO if it was dropped as late or duplicate
+ */
+enum GNUNET_GenericReturnValue
+CONVERSATION_JITTER_insert (struct CONVERSATION_JITTER_Buffer *jb,
+                            struct GNUNET_TIME_Absolute now,
+                            uint32_t seq,
+                            uint64_t media_time,
+                            const void *data,
+                            size_t data_size);
+
+
+/**
+ * Hand out all frames that are due for playback at @a now.
+ *
+ * @param jb the jitter buffer
+ * @param now current time
+ * @param cb function to call with each frame
+ * @param cb_cls closure for @a cb
+ * @return time at which we should call this function again,
+ *         #GNUNET_TIME_UNIT_FOREVER_ABS if the buffer is empty
+ */
+struct GNUNET_TIME_Absolute
+CONVERSATION_JITTER_drain (struct CONVERSATION_JITTER_Buffer *jb,
+                           struct GNUNET_TIME_Absolute now,
+                           CONVERSATION_JITTER_PlayCallback cb,
+                           void *cb_cls);
+
+
+/**
+ * Drop all buffered frames and forget the playback position,
+ * for example when the call is suspended.
+ *
+ * @param jb the jitter buffer
+ */
+void
+CONVERSATION_JITTER_reset (struct CONVERSATION_JITTER_Buffer *jb);
+
+
+/**
+ * Obtain statistics about the jitter buffer.
+ *
+ * @param jb the jitter buffer
+ * @param[out] stats set to the current statistics
+ */
+void
+CONVERSATION_JITTER_get_statistics (
+  const struct CONVERSATION_JITTER_Buffer *jb,
+  struct CONVERSATION_JITTER_Statistics *stats);
+
+
+/**
+ * Destroy a jitter buffer.
+ *
+ * @param jb the jitter buffer
+ */
+void
+CONVERSATION_JITTER_destroy (struct CONVERSATION_JITTER_Buffer *jb);
+
+
+#endif
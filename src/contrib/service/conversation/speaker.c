@@ -28,6 +28,25 @@
 #include "platform.h"
 #include "gnunet_speaker_lib.h"
 #include "conversation.h"
+#include "jitter_buffer.h"
+
+
+/**
+ * Default lower bound for the jitter buffer delay.
+ */
+#define DEFAULT_JITTER_MIN_DELAY GNUNET_TIME_relative_multiply ( \
+    GNUNET_TIME_UNIT_MILLISECONDS, 20)
+
+/**
+ * Default upper bound for the jitter buffer delay.
+ */
+#define DEFAULT_JITTER_MAX_DELAY GNUNET_TIME_relative_multiply ( \
+    GNUNET_TIME_UNIT_MILLISECONDS, 400)
+
+/**
+ * Size of the fixed part of an Ogg page header.
+ */
+#define OGG_PAGE_HEADER_SIZE 27
 
 
 /**
@@ -44,6 +63,16 @@ struct Speaker
    * Handle for the playback helper
    */
   struct GNUNET_HELPER_Handle *playback_helper;
+
+  /**
+   * Jitter buffer reordering the Ogg pages we receive.
+   */
+  struct CONVERSATION_JITTER_Buffer *jb;
+
+  /**
+   * Task to release frames held back by @e jb.
+   */
+  struct GNUNET_SCHEDULER_Task *drain_task;
 };
 
 
@@ -92,6 +121,12 @@ disable (void *cls)
     GNUNET_break (0);
     return;
   }
+  if (NULL != spe->drain_task)
+  {
+    GNUNET_SCHEDULER_cancel (spe->drain_task);
+    spe->drain_task = NULL;
+  }
+  CONVERSATION_JITTER_reset (spe->jb);
   GNUNET_break (GNUNET_OK ==
                 GNUNET_HELPER_kill (spe->playback_helper, GNUNET_NO));
   GNUNET_HELPER_destroy (spe->playback_helper);
@@ -111,12 +146,93 @@ destroy (void *cls)
 
   if (NULL != spe->playback_helper)
     disable (spe);
+  CONVERSATION_JITTER_destroy (spe->jb);
+  GNUNET_free (spe);
+}
+
+
+/**
+ * Pass audio data on to the playback helper.
+ *
+ * @param cls clsoure with the `struct Speaker`
+ * @param seq sequence number of the frame, unused
+ * @param data audio data to play
+ * @param data_size number of bytes in @a data
+ */
+static void
+send_to_helper (void *cls,
+                uint32_t seq,
+                const void *data,
+                size_t data_size)
+{
+  struct Speaker *spe = cls;
+  char buf[sizeof(struct AudioMessage) + data_size];
+  struct AudioMessage *am;
+
+  (void) seq;
+  am = (struct AudioMessage *) buf;
+  am->header.size = htons (sizeof(struct AudioMessage) + data_size);
+  am->header.type = htons (GNUNET_MESSAGE_TYPE_CONVERSATION_AUDIO);
+  GNUNET_memcpy (&am[1], data, data_size);
+  (void) GNUNET_HELPER_send (spe->playback_helper,
+                             &am->header,
+                             GNUNET_NO,
+                             NULL, NULL);
+}
+
+
+/**
+ * Release the frames from the jitter buffer that are due and
+ * schedule ourselves again for the next deadline.
+ *
+ * @param cls clsoure with the `struct Speaker`
+ */
+static void
+drain_jitter_buffer (void *cls)
+{
+  struct Speaker *spe = cls;
+  struct GNUNET_TIME_Absolute next;
+
+  spe->drain_task = NULL;
+  next = CONVERSATION_JITTER_drain (spe->jb,
+                                    GNUNET_TIME_absolute_get (),
+                                    &send_to_helper,
+                                    spe);
+  if (GNUNET_TIME_absolute_is_never (next))
+    return;
+  spe->drain_task = GNUNET_SCHEDULER_add_at (next,
+                                             &drain_jitter_buffer,
+                                             spe);
+}
+
+
+/**
+ * Read a little-endian integer from an Ogg page header.
+ *
+ * @param p start of the integer
+ * @param len number of bytes of the integer
+ * @return the integer in host byte order
+ */
+static uint64_t
+read_le (const unsigned char *p,
+         unsigned int len)
+{
+  uint64_t v = 0;
+
+  for (unsigned int i = len; i > 0; i--)
+    v = (v << 8) | p[i - 1];
+  return v;
 }
 
 
 /**
  * Function to cause a speaker to play audio data.
  *
+ * The record helper sends one Ogg page per message.  We use the page
+ * sequence number to reorder pages in the jitter buffer and the
+ * granule position (48 kHz samples for Opus) as the media time for
+ * the jitter estimate.  Anything else is played as it arrives.
+ *
  * @param cls clsoure with the `struct Speaker`
  * @param data_size number of bytes in @a data
  * @param data audio data to play, format is
@@ -128,22 +244,35 @@ play (void *cls,
       const void *data)
 {
   struct Speaker *spe = cls;
-  char buf[sizeof(struct AudioMessage) + data_size];
-  struct AudioMessage *am;
+  const unsigned char *page = data;
+  uint64_t granule;
+  uint64_t media_time;
 
   if (NULL == spe->playback_helper)
   {
     GNUNET_break (0);
     return;
   }
-  am = (struct AudioMessage *) buf;
-  am->header.size = htons (sizeof(struct AudioMessage) + data_size);
-  am->header.type = htons (GNUNET_MESSAGE_TYPE_CONVERSATION_AUDIO);
-  GNUNET_memcpy (&am[1], data, data_size);
-  (void) GNUNET_HELPER_send (spe->playback_helper,
-                             &am->header,
-                             GNUNET_NO,
-                             NULL, NULL);
+  if ((data_size < OGG_PAGE_HEADER_SIZE) ||
+      (0 != memcmp (page, "OggS", 4)))
+  {
+    send_to_helper (spe, 0, data, data_size);
+    return;
+  }
+  granule = read_le (&page[6], 8);
+  if ((0 == granule) || (UINT64_MAX == granule))
+    media_time = CONVERSATION_JITTER_NO_MEDIA_TIME;
+  else
+    media_time = granule * 1000LLU / 48LLU;
+  (void) CONVERSATION_JITTER_insert (spe->jb,
+                                     GNUNET_TIME_absolute_get (),
+                                     (uint32_t) read_le (&page[18], 4),
+                                     media_time,
+                                     data,
+                                     data_size);
+  if (NULL != spe->drain_task)
+    GNUNET_SCHEDULER_cancel (spe->drain_task);
+  drain_jitter_buffer (spe);
 }
 
 
@@ -160,9 +289,25 @@ GNUNET_SPEAKER_create_from_hardware (const struct
 {
   struct GNUNET_SPEAKER_Handle *speaker;
   struct Speaker *spe;
+  struct GNUNET_TIME_Relative min_delay;
+  struct GNUNET_TIME_Relative max_delay;
 
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_time (cfg,
+                                           "CONVERSATION",
+                                           "JITTER_MIN_DELAY",
+                                           &min_delay))
+    min_delay = DEFAULT_JITTER_MIN_DELAY;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_time (cfg,
+                                           "CONVERSATION",
+                                           "JITTER_MAX_DELAY",
+                                           &max_delay))
+    max_delay = DEFAULT_JITTER_MAX_DELAY;
   spe = GNUNET_new (struct Speaker);
   spe->cfg = cfg;
+  spe->jb = CONVERSATION_JITTER_create (min_delay,
+                                        max_delay);
   speaker = GNUNET_new (struct GNUNET_SPEAKER_Handle);
   speaker->cls = spe;
   speaker->enable_speaker = &enable;
@@ -0,0 +1,220 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/**
+ * @file conversation/test_conversation_jitter.c
+ * @brief testcase for jitter_buffer.c
+ *
+ * Replays a jitter trace (one-way delays of a bursty path, with a
+ * few lost frames) against the jitter buffer on a simulated clock
+ * and reports the resulting end-to-end latency and loss.
+ */
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "jitter_buffer.h"
+
+/**
+ * Interval between frames in ms (matches the record helper).
+ */
+#define FRAME_MS 40
+
+/**
+ * Number of frames to send.
+ */
+#define NUM_FRAMES 1500
+
+/**
+ * Marker for a frame lost on the path.
+ */
+#define LOST -1
+
+/**
+ * One-way delays in ms, replayed cyclically.
+ */
+static const int trace[] = {
+  52, 55, 51, 60, 58, 53, 120, 96, 71, 54,
+  52, 50, 57, LOST, 55, 53, 61, 140, 118, 90,
+  62, 55, 52, 51, 54, 58, 53, 52, 75, 56,
+  53, 51, 250, 212, 171, 131, 92, 57, 54, 52,
+  55, LOST, LOST, 53, 52, 59, 54, 51, 52, 55
+};
+
+/**
+ * Arrival of a frame.
+ */
+struct Arrival
+{
+  uint64_t at_us;
+  uint32_t seq;
+};
+
+static struct GNUNET_TIME_Absolute sim_now;
+
+static uint64_t send_time_us[NUM_FRAMES];
+
+static uint32_t last_played;
+
+static unsigned int played;
+
+static int ordered = GNUNET_YES;
+
+static uint64_t latency_sum_us;
+
+static uint64_t latency_max_us;
+
+
+static int
+cmp_arrival (const void *a,
+             const void *b)
+{
+  const struct Arrival *x = a;
+  const struct Arrival *y = b;
+
+  if (x->at_us < y->at_us)
+    return -1;
+  if (x->at_us > y->at_us)
+    return 1;
+  return 0;
+}
+
+
+static void
+play_cb (void *cls,
+         uint32_t seq,
+         const void *data,
+         size_t data_size)
+{
+  uint64_t latency;
+
+  (void) cls;
+  GNUNET_assert (sizeof (seq) == data_size);
+  GNUNET_assert (0 == memcmp (data, &seq, sizeof (seq)));
+  if ((0 != played) && (seq <= last_played))
+    ordered = GNUNET_NO;
+  last_played = seq;
+  played++;
+  latency = sim_now.abs_value_us - send_time_us[seq];
+  latency_sum_us += latency;
+  latency_max_us = GNUNET_MAX (latency_max_us, latency);
+}
+
+
+/**
+ * Drain the buffer at every deadline up to @a until.
+ */
+static void
+advance (struct CONVERSATION_JITTER_Buffer *jb,
+         struct GNUNET_TIME_Absolute until)
+{
+  struct GNUNET_TIME_Absolute next;
+
+  while (1)
+  {
+    next = CONVERSATION_JITTER_drain (jb, sim_now, &play_cb, NULL);
+    if (GNUNET_TIME_absolute_is_never (next) ||
+        GNUNET_TIME_absolute_cmp (next, >, until))
+      break;
+    sim_now = next;
+  }
+  sim_now = until;
+}
+
+
+int
+main (int argc,
+      char *argv[])
+{
+  struct CONVERSATION_JITTER_Buffer *jb;
+  struct CONVERSATION_JITTER_Statistics st;
+  struct Arrival arrivals[NUM_FRAMES];
+  unsigned int num_arrivals = 0;
+  unsigned int dropped = 0;
+
+  (void) argc;
+  GNUNET_log_setup ("test-conversation-jitter",
+                    "WARNING",
+                    NULL);
+  for (uint32_t i = 0; i < NUM_FRAMES; i++)
+  {
+    int delay = trace[i % (sizeof (trace) / sizeof (trace[0]))];
+
+    send_time_us[i] = 1000000LLU + i * FRAME_MS * 1000LLU;
+    if (LOST == delay)
+    {
+      dropped++;
+      continue;
+    }
+    arrivals[num_arrivals].at_us = send_time_us[i] + delay * 1000LLU;
+    arrivals[num_arrivals].seq = i;
+    num_arrivals++;
+  }
+  qsort (arrivals,
+         num_arrivals,
+         sizeof (struct Arrival),
+         &cmp_arrival);
+  jb = CONVERSATION_JITTER_create (GNUNET_TIME_relative_multiply (
+                                     GNUNET_TIME_UNIT_MILLISECONDS, 20),
+                                   GNUNET_TIME_relative_multiply (
+                                     GNUNET_TIME_UNIT_MILLISECONDS, 400));
+  sim_now.abs_value_us = 0;
+  for (unsigned int i = 0; i < num_arrivals; i++)
+  {
+    struct GNUNET_TIME_Absolute at = { .abs_value_us = arrivals[i].at_us };
+
+    advance (jb, at);
+    (void) CONVERSATION_JITTER_insert (jb,
+                                       sim_now,
+                                       arrivals[i].seq,
+                                       send_time_us[arrivals[i].seq],
+                                       &arrivals[i].seq,
+                                       sizeof (arrivals[i].seq));
+  }
+  advance (jb, GNUNET_TIME_UNIT_FOREVER_ABS);
+  CONVERSATION_JITTER_get_statistics (jb, &st);
+  CONVERSATION_JITTER_destroy (jb);
+  fprintf (stderr,
+           "%u frames sent, %u lost on path, %u played, %llu late, %llu concealed\n",
+           NUM_FRAMES,
+           dropped,
+           played,
+           (unsigned long long) st.frames_late,
+           (unsigned long long) st.frames_lost);
+  fprintf (stderr,
+           "End-to-end latency: %llu us average, %llu us maximum, final jitter %s\n",
+           (unsigned long long) (latency_sum_us / GNUNET_MAX (played, 1)),
+           (unsigned long long) latency_max_us,
+           GNUNET_TIME_relative2s (st.jitter, GNUNET_NO));
+  if (GNUNET_YES != ordered)
+  {
+    fprintf (stderr, "Frames were played out of order\n");
+    return 1;
+  }
+  if ((played != st.frames_played) ||
+      (played + st.frames_lost != NUM_FRAMES) ||
+      (st.frames_lost < dropped) ||
+      (st.frames_lost - dropped != st.frames_late))
+  {
+    fprintf (stderr, "Inconsistent frame accounting\n");
+    return 1;
+  }
+  return 0;
+}
+
+
+/* end of test_conversation_jitter.c */
@@ -1422,8 +1422,9 @@ keygen_round2_new_element (void *cls,
   gcry_mpi_t tmp;
   gcry_mpi_t public_key_share;
   gcry_mpi_t preshare;
-  gcry_mpi_t prod;
-  gcry_mpi_t j_to_k;
+  gcry_mpi_t *coeff_commitments;
+  gcry_mpi_t *share_commitments;
+  enum GNUNET_GenericReturnValue feldman_ok;
 
   if (NULL == element)
   {
@@ -1561,39 +1562,35 @@ keygen_round2_new_element (void *cls,
     gcry_mpi_release (presigma);
   }
 
-  GNUNET_assert (NULL != (prod = gcry_mpi_new (0)));
-  GNUNET_assert (NULL != (j_to_k = gcry_mpi_new (0)));
   // validate that the polynomial sharing matches the additive sharing
+  coeff_commitments = GNUNET_new_array (ks->threshold,
+                                        gcry_mpi_t);
+  for (j = 0; j < ks->threshold; j++)
+    coeff_commitments[j] = keygen_reveal_get_exp_coeff (ks, d, j);
+  share_commitments = GNUNET_new_array (ks->num_peers,
+                                        gcry_mpi_t);
   for (j = 0; j < ks->num_peers; j++)
+    share_commitments[j] = keygen_reveal_get_exp_preshare (ks, d, j);
+  feldman_ok = GNUNET_SECRETSHARING_feldman_verify (coeff_commitments,
+                                                    ks->threshold,
+                                                    share_commitments,
+                                                    ks->num_peers,
+                                                    elgamal_p,
+                                                    &j);
+  for (unsigned int k = 0; k < ks->threshold; k++)
+    gcry_mpi_release (coeff_commitments[k]);
+  for (unsigned int k = 0; k < ks->num_peers; k++)
+    gcry_mpi_release (share_commitments[k]);
+  GNUNET_free (coeff_commitments);
+  GNUNET_free (share_commitments);
+  if (GNUNET_OK != feldman_ok)
   {
-    unsigned int k;
-    int cmp_result_tmp;
-    gcry_mpi_t exp_preshare;
-    gcry_mpi_set_ui (prod, 1);
-    for (k = 0; k < ks->threshold; k++)
-    {
-      // Using pow(double,double) is a bit sketchy.
-      // We count players from 1, but shares from 0.
-      gcry_mpi_t tmp_exp;
-      gcry_mpi_set_ui (j_to_k, (unsigned int) pow (j + 1, k));
-      tmp_exp = keygen_reveal_get_exp_coeff (ks, d, k);
-      gcry_mpi_powm (tmp_exp, tmp_exp, j_to_k, elgamal_p);
-      gcry_mpi_mulm (prod, prod, tmp_exp, elgamal_p);
-      gcry_mpi_release (tmp_exp);
-    }
-    exp_preshare = keygen_reveal_get_exp_preshare (ks, d, j);
-    gcry_mpi_mod (exp_preshare, exp_preshare, elgamal_p);
-    cmp_result_tmp = gcry_mpi_cmp (prod, exp_preshare);
-    gcry_mpi_release (exp_preshare);
-    exp_preshare = NULL;
-    if (0 != cmp_result_tmp)
-    {
-      GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
-                  "P%u: reveal data from P%u incorrect\n",
-                  ks->local_peer_idx, j);
-      /* no need for further verification, round2 stays invalid ... */
-      return;
-    }
+    GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
+                "P%u: reveal data from P%u incorrect\n",
+                ks->local_peer_idx, j);
+    /* no need for further verification, round2 stays invalid ... */
+    gcry_mpi_release (preshare);
+    return;
   }
 
   // TODO: verify proof of fair encryption (once implemented)
@@ -1613,8 +1610,6 @@ keygen_round2_new_element (void *cls,
   info->round2_valid = GNUNET_YES;
 
   gcry_mpi_release (preshare);
-  gcry_mpi_release (prod);
-  gcry_mpi_release (j_to_k);
 }
 
 
@@ -1934,6 +1929,8 @@ decrypt_new_element (void *cls,
   gcry_mpi_t tmp1;
   /* temporary variable (for comparison) #2 */
   gcry_mpi_t tmp2;
+  gcry_mpi_t bases[2];
+  gcry_mpi_t exps[2];
 
   if (NULL == element)
   {
@@ -2020,12 +2017,23 @@ decrypt_new_element (void *cls,
   GNUNET_assert (NULL != (tmp1 = gcry_mpi_new (0)));
   GNUNET_assert (NULL != (tmp2 = gcry_mpi_new (0)));
 
-  // tmp1 = g^r
-  gcry_mpi_powm (tmp1, elgamal_g, r, elgamal_p);
-
-  // tmp2 = g^\beta * \sigma^challenge
-  gcry_mpi_powm (tmp2, sigma, challenge, elgamal_p);
-  gcry_mpi_mulm (tmp2, tmp2, commit1, elgamal_p);
+  /* Check g^r = g^\beta * \sigma^challenge as
+   * g^r * (\sigma^-1)^challenge = g^\beta, which shares the
+   * squarings of both exponentiations. */
+  gcry_mpi_mod (tmp2, commit1, elgamal_p);
+  if (0 == gcry_mpi_invm (sigma, sigma, elgamal_p))
+  {
+    /* not invertible, cannot match anything reduced mod p */
+    gcry_mpi_set (tmp1, elgamal_p);
+  }
+  else
+  {
+    bases[0] = elgamal_g;
+    exps[0] = r;
+    bases[1] = sigma;
+    exps[1] = challenge;
+    GNUNET_SECRETSHARING_mpi_multi_powm (tmp1, bases, exps, 2, elgamal_p);
+  }
 
   if (0 != gcry_mpi_cmp (tmp1, tmp2))
   {
@@ -2046,11 +2054,21 @@ decrypt_new_element (void *cls,
   }
 
 
-  gcry_mpi_powm (tmp1, c1, r, elgamal_p);
-
-  gcry_mpi_powm (tmp2, w, challenge, elgamal_p);
-  gcry_mpi_mulm (tmp2, tmp2, commit2, elgamal_p);
-
+  /* c1^r = commit2 * w^challenge, the same way */
+  gcry_mpi_mod (tmp2, commit2, elgamal_p);
+  if (0 == gcry_mpi_invm (tmp1, w, elgamal_p))
+  {
+    /* not invertible, cannot match anything reduced mod p */
+    gcry_mpi_set (tmp1, elgamal_p);
+  }
+  else
+  {
+    bases[0] = c1;
+    exps[0] = r;
+    bases[1] = tmp1;
+    exps[1] = challenge;
+    GNUNET_SECRETSHARING_mpi_multi_powm (tmp1, bases, exps, 2, elgamal_p);
+  }
 
   if (0 != gcry_mpi_cmp (tmp1, tmp2))
   {
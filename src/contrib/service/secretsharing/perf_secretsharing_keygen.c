@@ -0,0 +1,308 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file secretsharing/perf_secretsharing_keygen.c
+ * @brief measure the verification of the Feldman commitments a peer
+ *        does during key generation, for growing numbers of peers,
+ *        comparing one exponentiation per peer and coefficient with
+ *        the batched check, as well as the check of a decryption proof
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "secretsharing.h"
+
+/**
+ * Number of decryption proof checks to time.
+ */
+#define PROOFS 200
+
+
+static gcry_mpi_t elgamal_p;
+
+static gcry_mpi_t elgamal_q;
+
+static gcry_mpi_t elgamal_g;
+
+
+static void
+report (const char *mode,
+        unsigned int num_peers,
+        struct GNUNET_TIME_Relative dur)
+{
+  /* the result of GNUNET_STRINGS_relative_time_to_string() is static */
+  printf ("%s, %u peers: %s per dealer, ",
+          mode,
+          num_peers,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES));
+  printf ("%s per key generation\n",
+          GNUNET_STRINGS_relative_time_to_string (
+            GNUNET_TIME_relative_multiply (dur,
+                                           num_peers),
+            GNUNET_YES));
+}
+
+
+/**
+ * Pick a random exponent in [0, q).
+ */
+static gcry_mpi_t
+random_exponent (void)
+{
+  gcry_mpi_t v;
+
+  GNUNET_assert (NULL != (v = gcry_mpi_new (0)));
+  gcry_mpi_randomize (v,
+                      GNUNET_SECRETSHARING_ELGAMAL_BITS - 1,
+                      GCRY_WEAK_RANDOM);
+  gcry_mpi_mod (v, v, elgamal_q);
+  return v;
+}
+
+
+/**
+ * Check the commitments of one dealer with one exponentiation per
+ * peer and coefficient, as the service used to.
+ */
+static enum GNUNET_GenericReturnValue
+verify_naive (const gcry_mpi_t *coeffs,
+              unsigned int threshold,
+              const gcry_mpi_t *shares,
+              unsigned int num_peers)
+{
+  enum GNUNET_GenericReturnValue ret = GNUNET_OK;
+  gcry_mpi_t prod;
+  gcry_mpi_t j_to_k;
+  gcry_mpi_t tmp;
+
+  GNUNET_assert (NULL != (prod = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (j_to_k = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (tmp = gcry_mpi_new (0)));
+  for (unsigned int j = 0; j < num_peers; j++)
+  {
+    gcry_mpi_set_ui (prod, 1);
+    gcry_mpi_set_ui (j_to_k, 1);
+    for (unsigned int k = 0; k < threshold; k++)
+    {
+      gcry_mpi_powm (tmp, coeffs[k], j_to_k, elgamal_p);
+      gcry_mpi_mulm (prod, prod, tmp, elgamal_p);
+      gcry_mpi_mul_ui (j_to_k, j_to_k, j + 1);
+    }
+    if (0 != gcry_mpi_cmp (prod, shares[j]))
+      ret = GNUNET_SYSERR;
+  }
+  gcry_mpi_release (prod);
+  gcry_mpi_release (j_to_k);
+  gcry_mpi_release (tmp);
+  return ret;
+}
+
+
+static void
+perf_feldman (unsigned int num_peers)
+{
+  unsigned int threshold = num_peers / 2 + 1;
+  gcry_mpi_t coeffs[threshold];
+  gcry_mpi_t commits[threshold];
+  gcry_mpi_t shares[num_peers];
+  gcry_mpi_t x;
+  gcry_mpi_t s;
+  struct GNUNET_TIME_Absolute start;
+  unsigned int bad;
+
+  for (unsigned int k = 0; k < threshold; k++)
+  {
+    coeffs[k] = random_exponent ();
+    GNUNET_assert (NULL != (commits[k] = gcry_mpi_new (0)));
+    gcry_mpi_powm (commits[k], elgamal_g, coeffs[k], elgamal_p);
+  }
+  GNUNET_assert (NULL != (x = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (s = gcry_mpi_new (0)));
+  for (unsigned int j = 0; j < num_peers; j++)
+  {
+    /* s = f(j+1) mod q */
+    gcry_mpi_set_ui (x, j + 1);
+    gcry_mpi_set (s, coeffs[threshold - 1]);
+    for (unsigned int k = threshold - 1; k > 0; k--)
+    {
+      gcry_mpi_mulm (s, s, x, elgamal_q);
+      gcry_mpi_addm (s, s, coeffs[k - 1], elgamal_q);
+    }
+    GNUNET_assert (NULL != (shares[j] = gcry_mpi_new (0)));
+    gcry_mpi_powm (shares[j], elgamal_g, s, elgamal_p);
+  }
+
+  start = GNUNET_TIME_absolute_get ();
+  GNUNET_assert (GNUNET_OK ==
+                 verify_naive (commits, threshold, shares, num_peers));
+  report ("one exponentiation per coefficient",
+          num_peers,
+          GNUNET_TIME_absolute_get_duration (start));
+  start = GNUNET_TIME_absolute_get ();
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_SECRETSHARING_feldman_verify (commits,
+                                                      threshold,
+                                                      shares,
+                                                      num_peers,
+                                                      elgamal_p,
+                                                      &bad));
+  report ("GNUNET_SECRETSHARING_feldman_verify",
+          num_peers,
+          GNUNET_TIME_absolute_get_duration (start));
+
+  /* a wrong share must be found */
+  gcry_mpi_mulm (shares[num_peers / 3],
+                 shares[num_peers / 3],
+                 elgamal_g,
+                 elgamal_p);
+  GNUNET_assert (GNUNET_SYSERR ==
+                 GNUNET_SECRETSHARING_feldman_verify (commits,
+                                                      threshold,
+                                                      shares,
+                                                      num_peers,
+                                                      elgamal_p,
+                                                      &bad));
+  GNUNET_assert (num_peers / 3 == bad);
+  /* as must a share outside of the group generated by g */
+  gcry_mpi_sub (shares[num_peers / 3], elgamal_p, shares[num_peers / 3]);
+  GNUNET_assert (GNUNET_SYSERR ==
+                 GNUNET_SECRETSHARING_feldman_verify (commits,
+                                                      threshold,
+                                                      shares,
+                                                      num_peers,
+                                                      elgamal_p,
+                                                      &bad));
+  GNUNET_assert (num_peers / 3 == bad);
+
+  for (unsigned int k = 0; k < threshold; k++)
+  {
+    gcry_mpi_release (coeffs[k]);
+    gcry_mpi_release (commits[k]);
+  }
+  for (unsigned int j = 0; j < num_peers; j++)
+    gcry_mpi_release (shares[j]);
+  gcry_mpi_release (x);
+  gcry_mpi_release (s);
+}
+
+
+/**
+ * Check g^r = commit * sigma^c for a proof of a partial decryption,
+ * with two exponentiations and with one multi-exponentiation.
+ */
+static void
+perf_proof (void)
+{
+  gcry_mpi_t beta = random_exponent ();
+  gcry_mpi_t share = random_exponent ();
+  gcry_mpi_t c = random_exponent ();
+  gcry_mpi_t r;
+  gcry_mpi_t sigma;
+  gcry_mpi_t sigma_inv;
+  gcry_mpi_t commit;
+  gcry_mpi_t tmp1;
+  gcry_mpi_t tmp2;
+  gcry_mpi_t bases[2];
+  gcry_mpi_t exps[2];
+  struct GNUNET_TIME_Absolute start;
+
+  GNUNET_assert (NULL != (r = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (sigma = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (sigma_inv = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (commit = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (tmp1 = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (tmp2 = gcry_mpi_new (0)));
+  /* r = beta + c * share */
+  gcry_mpi_mulm (r, c, share, elgamal_q);
+  gcry_mpi_addm (r, r, beta, elgamal_q);
+  gcry_mpi_powm (sigma, elgamal_g, share, elgamal_p);
+  gcry_mpi_powm (commit, elgamal_g, beta, elgamal_p);
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < PROOFS; i++)
+  {
+    gcry_mpi_powm (tmp1, elgamal_g, r, elgamal_p);
+    gcry_mpi_powm (tmp2, sigma, c, elgamal_p);
+    gcry_mpi_mulm (tmp2, tmp2, commit, elgamal_p);
+    GNUNET_assert (0 == gcry_mpi_cmp (tmp1, tmp2));
+  }
+  printf ("proof, two exponentiations: %s per check\n",
+          GNUNET_STRINGS_relative_time_to_string (
+            GNUNET_TIME_relative_divide (
+              GNUNET_TIME_absolute_get_duration (start),
+              PROOFS),
+            GNUNET_YES));
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < PROOFS; i++)
+  {
+    GNUNET_assert (gcry_mpi_invm (sigma_inv, sigma, elgamal_p));
+    bases[0] = elgamal_g;
+    exps[0] = r;
+    bases[1] = sigma_inv;
+    exps[1] = c;
+    GNUNET_SECRETSHARING_mpi_multi_powm (tmp1, bases, exps, 2, elgamal_p);
+    GNUNET_assert (0 == gcry_mpi_cmp (tmp1, commit));
+  }
+  printf ("proof, multi-exponentiation: %s per check\n",
+          GNUNET_STRINGS_relative_time_to_string (
+            GNUNET_TIME_relative_divide (
+              GNUNET_TIME_absolute_get_duration (start),
+              PROOFS),
+            GNUNET_YES));
+  gcry_mpi_release (beta);
+  gcry_mpi_release (share);
+  gcry_mpi_release (c);
+  gcry_mpi_release (r);
+  gcry_mpi_release (sigma);
+  gcry_mpi_release (sigma_inv);
+  gcry_mpi_release (commit);
+  gcry_mpi_release (tmp1);
+  gcry_mpi_release (tmp2);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  GNUNET_log_setup ("perf-secretsharing-keygen",
+                    "WARNING",
+                    NULL);
+  GNUNET_assert (0 == gcry_mpi_scan (&elgamal_q, GCRYMPI_FMT_HEX,
+                                     GNUNET_SECRETSHARING_ELGAMAL_Q_HEX, 0,
+                                     NULL));
+  GNUNET_assert (0 == gcry_mpi_scan (&elgamal_p, GCRYMPI_FMT_HEX,
+                                     GNUNET_SECRETSHARING_ELGAMAL_P_HEX, 0,
+                                     NULL));
+  GNUNET_assert (0 == gcry_mpi_scan (&elgamal_g, GCRYMPI_FMT_HEX,
+                                     GNUNET_SECRETSHARING_ELGAMAL_G_HEX, 0,
+                                     NULL));
+  for (unsigned int n = 4; n <= 64; n *= 2)
+    perf_feldman (n);
+  perf_proof ();
+  gcry_mpi_release (elgamal_p);
+  gcry_mpi_release (elgamal_q);
+  gcry_mpi_release (elgamal_g);
+  return 0;
+}
+
+
+/* end of perf_secretsharing_keygen.c */
@@ -224,4 +224,50 @@ struct GNUNET_SECRETSHARING_Share
 };
 
 
+/**
+ * Compute @a result = prod_i @a bases[i]^@a exps[i] mod @a mod, sharing
+ * the squarings between all bases (simultaneous multi-exponentiation).
+ *
+ * @param[out] result where to store the result, may be one of @a bases
+ * @param bases the bases
+ * @param exps the exponents, non-negative
+ * @param len number of entries in @a bases and @a exps
+ * @param mod the modulus
+ */
+void
+GNUNET_SECRETSHARING_mpi_multi_powm (gcry_mpi_t result,
+                                     const gcry_mpi_t *bases,
+                                     const gcry_mpi_t *exps,
+                                     unsigned int len,
+                                     gcry_mpi_t mod);
+
+
+/**
+ * Check that the commitments to the shares of a Feldman VSS match
+ * the commitments to the polynomial coefficients, that is
+ * g^{s_j} = prod_k (g^{a_k})^{(j+1)^k} for all j.  The shares are
+ * checked together using a random linear combination; only if that
+ * fails are they checked one by one to find the culprit.
+ *
+ * All commitments must be in the subgroup of order (p-1)/2 of Z_p^*,
+ * @a p must be a safe prime.
+ *
+ * @param coeff_commitments g^{a_k} for the @a threshold coefficients
+ * @param threshold number of coefficients
+ * @param share_commitments g^{s_j} for the shares of the @a num_peers peers
+ * @param num_peers number of shares
+ * @param p the safe prime
+ * @param[out] bad_peer set to the index of a share that does not match,
+ *             or to @a num_peers if a coefficient commitment is invalid
+ * @return #GNUNET_OK if all shares match
+ */
+enum GNUNET_GenericReturnValue
+GNUNET_SECRETSHARING_feldman_verify (const gcry_mpi_t *coeff_commitments,
+                                     unsigned int threshold,
+                                     const gcry_mpi_t *share_commitments,
+                                     unsigned int num_peers,
+                                     gcry_mpi_t p,
+                                     unsigned int *bad_peer);
+
+
 #endif
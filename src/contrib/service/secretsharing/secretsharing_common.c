@@ -21,6 +21,21 @@
 #include "platform.h"
 #include "secretsharing.h"
 
+/**
+ * Width of the windows of exponent bits used by
+ * #GNUNET_SECRETSHARING_mpi_multi_powm() for long exponents.
+ */
+#define MULTI_POWM_WINDOW 4
+
+/**
+ * Number of bits of the random factors used to combine the
+ * checks in #GNUNET_SECRETSHARING_feldman_verify().  The dealer
+ * must not be able to predict them, or it could craft bad shares
+ * whose errors cancel out.
+ */
+#define BATCH_BITS 64
+
+
 /**
  * Read a share from its binary representation.
  *
@@ -157,3 +172,348 @@ GNUNET_SECRETSHARING_share_destroy (struct GNUNET_SECRETSHARING_Share *share)
   share->peers = NULL;
   GNUNET_free (share);
 }
+
+
+void
+GNUNET_SECRETSHARING_mpi_multi_powm (gcry_mpi_t result,
+                                     const gcry_mpi_t *bases,
+                                     const gcry_mpi_t *exps,
+                                     unsigned int len,
+                                     gcry_mpi_t mod)
+{
+  unsigned int nbits = 0;
+  unsigned int w;
+  unsigned int tsize;
+  gcry_mpi_t *table;
+  bool started = false;
+
+  for (unsigned int i = 0; i < len; i++)
+    nbits = GNUNET_MAX (nbits,
+                        gcry_mpi_get_nbits (exps[i]));
+  /* precomputing the powers only pays off for long exponents */
+  w = (nbits >= 256) ? MULTI_POWM_WINDOW : 1;
+  nbits = (nbits + w - 1) / w * w;
+  tsize = (1U << w) - 1;
+  /* table[i * tsize + d - 1] = bases[i]^d */
+  table = GNUNET_new_array (len * tsize,
+                            gcry_mpi_t);
+  for (unsigned int i = 0; i < len; i++)
+  {
+    GNUNET_assert (NULL != (table[i * tsize] = gcry_mpi_new (0)));
+    gcry_mpi_mod (table[i * tsize], bases[i], mod);
+    for (unsigned int d = 1; d < tsize; d++)
+    {
+      GNUNET_assert (NULL != (table[i * tsize + d] = gcry_mpi_new (0)));
+      gcry_mpi_mulm (table[i * tsize + d],
+                     table[i * tsize + d - 1],
+                     table[i * tsize],
+                     mod);
+    }
+  }
+  gcry_mpi_set_ui (result, 1);
+  for (unsigned int pos = nbits; pos > 0; pos -= w)
+  {
+    if (started)
+      for (unsigned int s = 0; s < w; s++)
+        gcry_mpi_mulm (result, result, result, mod);
+    for (unsigned int i = 0; i < len; i++)
+    {
+      unsigned int digit = 0;
+
+      for (unsigned int b = 0; b < w; b++)
+        if (gcry_mpi_test_bit (exps[i], pos - w + b))
+          digit |= 1U << b;
+      if (0 == digit)
+        continue;
+      gcry_mpi_mulm (result, result, table[i * tsize + digit - 1], mod);
+      started = true;
+    }
+  }
+  for (unsigned int i = 0; i < len * tsize; i++)
+    gcry_mpi_release (table[i]);
+  GNUNET_free (table);
+}
+
+
+/**
+ * Number of 64-bit limbs used by mpi_jacobi().
+ */
+#define JACOBI_LIMBS (GNUNET_SECRETSHARING_ELGAMAL_BITS / 64 + 1)
+
+
+/**
+ * Load @a v into little-endian limbs.
+ *
+ * @param[out] w where to store the limbs
+ * @param v number to load, must fit into #JACOBI_LIMBS limbs
+ */
+static void
+limbs_load (uint64_t w[JACOBI_LIMBS],
+            gcry_mpi_t v)
+{
+  unsigned char buf[JACOBI_LIMBS * 8];
+  size_t len;
+
+  memset (w, 0, JACOBI_LIMBS * sizeof (uint64_t));
+  GNUNET_assert (0 == gcry_mpi_print (GCRYMPI_FMT_USG,
+                                      buf,
+                                      sizeof (buf),
+                                      &len,
+                                      v));
+  for (size_t i = 0; i < len; i++)
+    w[(len - 1 - i) / 8] |= ((uint64_t) buf[i]) << (8 * ((len - 1 - i) % 8));
+}
+
+
+/**
+ * Compute the Jacobi symbol (@a x / @a n) with the binary algorithm,
+ * which only needs shifts and subtractions; for a prime @a n this tells
+ * whether @a x is a quadratic residue at a fraction of the cost of an
+ * exponentiation.  Works on plain limbs, as going through the MPI API
+ * for every step would cost as much as the exponentiation.
+ *
+ * @param x number to look at
+ * @param n odd modulus of at most #GNUNET_SECRETSHARING_ELGAMAL_BITS bits
+ * @return -1, 0 or 1
+ */
+static int
+mpi_jacobi (gcry_mpi_t x,
+            gcry_mpi_t n)
+{
+  uint64_t wa[JACOBI_LIMBS];
+  uint64_t wm[JACOBI_LIMBS];
+  uint64_t *a = wa;
+  uint64_t *m = wm;
+  unsigned int len = JACOBI_LIMBS;
+  gcry_mpi_t r;
+  int t = 1;
+
+  GNUNET_assert (NULL != (r = gcry_mpi_new (0)));
+  gcry_mpi_mod (r, x, n);
+  limbs_load (a, r);
+  limbs_load (m, n);
+  gcry_mpi_release (r);
+  while (1)
+  {
+    unsigned int z;
+    unsigned int zl;
+    unsigned int zb;
+    uint64_t *tmp;
+    uint64_t borrow;
+    int cmp;
+
+    /* both only get smaller, drop leading zero limbs */
+    while ( (len > 0) &&
+            (0 == a[len - 1]) &&
+            (0 == m[len - 1]) )
+      len--;
+    for (zl = 0; zl < len; zl++)
+      if (0 != a[zl])
+        break;
+    if (zl == len)
+      break; /* a is zero */
+    for (zb = 0; 0 == ((a[zl] >> zb) & 1); zb++)
+      ;
+    z = 64 * zl + zb;
+    if (0 != z)
+    {
+      for (unsigned int i = 0; i < len; i++)
+      {
+        uint64_t lo = (i + zl < len) ? a[i + zl] : 0;
+        uint64_t hi = (i + zl + 1 < len) ? a[i + zl + 1] : 0;
+
+        a[i] = (0 == zb) ? lo : ((lo >> zb) | (hi << (64 - zb)));
+      }
+      if ( (1 == (z & 1)) &&
+           ( (3 == (m[0] & 7)) ||
+             (5 == (m[0] & 7)) ) )
+        t = -t;
+    }
+    /* both odd now; (a/m) = ((a-m)/m), swapping by reciprocity */
+    cmp = 0;
+    for (unsigned int i = len; i > 0; i--)
+      if (a[i - 1] != m[i - 1])
+      {
+        cmp = (a[i - 1] < m[i - 1]) ? -1 : 1;
+        break;
+      }
+    if (cmp < 0)
+    {
+      tmp = a;
+      a = m;
+      m = tmp;
+      if ( (3 == (a[0] & 3)) &&
+           (3 == (m[0] & 3)) )
+        t = -t;
+    }
+    borrow = 0;
+    for (unsigned int i = 0; i < len; i++)
+    {
+      uint64_t d = a[i] - m[i] - borrow;
+
+      borrow = (a[i] < m[i]) || ( (a[i] == m[i]) && (0 != borrow) );
+      a[i] = d;
+    }
+  }
+  /* gcd must be 1 */
+  if ( (0 == len) ||
+       (1 != m[0]) )
+    return 0;
+  for (unsigned int i = 1; i < len; i++)
+    if (0 != m[i])
+      return 0;
+  return t;
+}
+
+
+/**
+ * Check the shares one by one, evaluating the polynomial in the
+ * exponent at x = j+1 with Horner's rule.  The exponents are small,
+ * so this is cheap as long as there are few peers.
+ *
+ * @param coeff_commitments g^{a_k} for the @a threshold coefficients
+ * @param threshold number of coefficients
+ * @param share_commitments g^{s_j} for the shares of the @a num_peers peers
+ * @param num_peers number of shares
+ * @param p the modulus
+ * @return index of the first share that does not match, @a num_peers if
+ *         all match
+ */
+static unsigned int
+find_bad_share (const gcry_mpi_t *coeff_commitments,
+                unsigned int threshold,
+                const gcry_mpi_t *share_commitments,
+                unsigned int num_peers,
+                gcry_mpi_t p)
+{
+  gcry_mpi_t x;
+  gcry_mpi_t lhs;
+  gcry_mpi_t rhs;
+  unsigned int j;
+
+  GNUNET_assert (NULL != (x = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (lhs = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (rhs = gcry_mpi_new (0)));
+  for (j = 0; j < num_peers; j++)
+  {
+    gcry_mpi_set_ui (x, j + 1);
+    gcry_mpi_mod (rhs, coeff_commitments[threshold - 1], p);
+    for (unsigned int k = threshold - 1; k > 0; k--)
+    {
+      gcry_mpi_powm (rhs, rhs, x, p);
+      gcry_mpi_mulm (rhs, rhs, coeff_commitments[k - 1], p);
+    }
+    gcry_mpi_mod (lhs, share_commitments[j], p);
+    if (0 != gcry_mpi_cmp (lhs, rhs))
+      break;
+  }
+  gcry_mpi_release (x);
+  gcry_mpi_release (lhs);
+  gcry_mpi_release (rhs);
+  return j;
+}
+
+
+enum GNUNET_GenericReturnValue
+GNUNET_SECRETSHARING_feldman_verify (const gcry_mpi_t *coeff_commitments,
+                                     unsigned int threshold,
+                                     const gcry_mpi_t *share_commitments,
+                                     unsigned int num_peers,
+                                     gcry_mpi_t p,
+                                     unsigned int *bad_peer)
+{
+  enum GNUNET_GenericReturnValue ret = GNUNET_OK;
+  gcry_mpi_t *r;
+  gcry_mpi_t *e;
+  gcry_mpi_t x;
+  gcry_mpi_t lhs;
+  gcry_mpi_t rhs;
+  unsigned int nbits;
+
+  GNUNET_assert (threshold > 0);
+  /* Rough cost in multiplications: checking the shares one by one
+   * needs log2 (num_peers) squarings per coefficient and share, the
+   * batched check about 50 for each Jacobi symbol, 32 per share, and
+   * exponents of log2 (num_peers) bits per coefficient. */
+  nbits = 1;
+  while ((1U << nbits) <= num_peers)
+    nbits++;
+  if ((unsigned long long) num_peers * (threshold - 1) * (3 * nbits / 2 + 1)
+      <= 50ULL * (num_peers + threshold) + 32ULL * num_peers
+      + (64ULL + (threshold - 1) * nbits) * (1 + threshold / 4))
+  {
+    *bad_peer = find_bad_share (coeff_commitments,
+                                threshold,
+                                share_commitments,
+                                num_peers,
+                                p);
+    return (*bad_peer == num_peers) ? GNUNET_OK : GNUNET_SYSERR;
+  }
+  /* The random linear combination is only sound in a group of prime
+   * order.  For a safe prime, that is the quadratic residues, and honest
+   * commitments are always in it. */
+  for (unsigned int k = 0; k < threshold; k++)
+    if (1 != mpi_jacobi (coeff_commitments[k], p))
+    {
+      *bad_peer = num_peers;
+      return GNUNET_SYSERR;
+    }
+  for (unsigned int j = 0; j < num_peers; j++)
+    if (1 != mpi_jacobi (share_commitments[j], p))
+    {
+      *bad_peer = j;
+      return GNUNET_SYSERR;
+    }
+
+  /* check prod_j (g^{s_j})^{r_j} = prod_k (g^{a_k})^{e_k}
+   * with e_k = sum_j r_j (j+1)^k, computed as exact integers */
+  r = GNUNET_new_array (num_peers,
+                        gcry_mpi_t);
+  e = GNUNET_new_array (threshold,
+                        gcry_mpi_t);
+  for (unsigned int k = 0; k < threshold; k++)
+    GNUNET_assert (NULL != (e[k] = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (x = gcry_mpi_new (0)));
+  for (unsigned int j = 0; j < num_peers; j++)
+  {
+    GNUNET_assert (NULL != (r[j] = gcry_mpi_new (BATCH_BITS)));
+    gcry_mpi_randomize (r[j], BATCH_BITS, GCRY_STRONG_RANDOM);
+    gcry_mpi_set (x, r[j]);
+    for (unsigned int k = 0; k < threshold; k++)
+    {
+      gcry_mpi_add (e[k], e[k], x);
+      gcry_mpi_mul_ui (x, x, j + 1);
+    }
+  }
+  GNUNET_assert (NULL != (lhs = gcry_mpi_new (0)));
+  GNUNET_assert (NULL != (rhs = gcry_mpi_new (0)));
+  GNUNET_SECRETSHARING_mpi_multi_powm (lhs,
+                                       share_commitments,
+                                       r,
+                                       num_peers,
+                                       p);
+  GNUNET_SECRETSHARING_mpi_multi_powm (rhs,
+                                       coeff_commitments,
+                                       e,
+                                       threshold,
+                                       p);
+  if (0 != gcry_mpi_cmp (lhs, rhs))
+  {
+    ret = GNUNET_SYSERR;
+    *bad_peer = find_bad_share (coeff_commitments,
+                                threshold,
+                                share_commitments,
+                                num_peers,
+                                p);
+  }
+  for (unsigned int j = 0; j < num_peers; j++)
+    gcry_mpi_release (r[j]);
+  for (unsigned int k = 0; k < threshold; k++)
+    gcry_mpi_release (e[k]);
+  GNUNET_free (r);
+  GNUNET_free (e);
+  gcry_mpi_release (x);
+  gcry_mpi_release (lhs);
+  gcry_mpi_release (rhs);
+  return ret;
+}
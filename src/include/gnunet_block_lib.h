@@ -100,6 +100,47 @@ GNUNET_BLOCK_mingle_hash (const struct GNUNET_HashCode *in,
                           struct GNUNET_HashCode *hc);
 
 
+/**
+ * Key for #GNUNET_BLOCK_mingle_hash_keyed(), derived once from a
+ * mingle number.
+ */
+struct GNUNET_BLOCK_MingleKey
+{
+  /**
+   * Key material, one word per 64 bits of a `struct GNUNET_HashCode`.
+   */
+  uint64_t k[8];
+};
+
+
+/**
+ * Derive the key for #GNUNET_BLOCK_mingle_hash_keyed() from
+ * the @a mingle_number.
+ *
+ * @param mingle_number number for hash permutation
+ * @param[out] key set to the derived key
+ */
+void
+GNUNET_BLOCK_mingle_key_init (uint32_t mingle_number,
+                              struct GNUNET_BLOCK_MingleKey *key);
+
+
+/**
+ * Mingle hash with a key to produce different bits.  Much cheaper
+ * than #GNUNET_BLOCK_mingle_hash() as @a in is already a hash and
+ * only needs to be permuted, but produces different results.  Both
+ * sides of an exchange must agree on which function to use.
+ *
+ * @param in original hash code
+ * @param key key derived from the mingle number
+ * @param hc where to store the result
+ */
+void
+GNUNET_BLOCK_mingle_hash_keyed (const struct GNUNET_HashCode *in,
+                                const struct GNUNET_BLOCK_MingleKey *key,
+                                struct GNUNET_HashCode *hc);
+
+
 /**
  * Create a block context.  Loads the block plugins.
  *
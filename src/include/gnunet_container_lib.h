@@ -2262,7 +2262,8 @@ typedef enum GNUNET_GenericReturnValue
 
 /**
  * @ingroup heap
- * Iterate over all entries in the heap.
+ * Iterate over all entries in the heap, in no particular order.
+ * The @a iterator must not modify the heap.
  *
  * @param heap the heap
  * @param iterator function to call on each entry
@@ -720,7 +720,8 @@ struct GNUNET_CRYPTO_CsBlindingNonce
 /**
  * @ingroup crypto
  * Seed a weak random generator. Only #GNUNET_CRYPTO_QUALITY_WEAK-mode generator
- * can be seeded.
+ * can be seeded.  The seed only applies to the calling thread, and
+ * its output is reproducible until the next call.
  *
  * @param seed the seed to use
  */
@@ -268,6 +268,55 @@ typedef void
                     void *cont_cls);
 
 
+/**
+ * A processor over the items removed by #PluginRemoveBatch.
+ *
+ * @param cls closure
+ * @param key key of the removed content
+ * @param size number of bytes of the removed content
+ * @param type type of the removed content
+ * @param priority priority of the removed content
+ * @param expiration expiration time of the removed content
+ * @return #GNUNET_OK to continue removing items,
+ *         #GNUNET_NO to stop after this item
+ */
+typedef enum GNUNET_GenericReturnValue
+(*PluginRemovedProcessor)(void *cls,
+                          const struct GNUNET_HashCode *key,
+                          uint32_t size,
+                          enum GNUNET_BLOCK_Type type,
+                          uint32_t priority,
+                          struct GNUNET_TIME_Absolute expiration);
+
+
+/**
+ * Remove up to @a limit items from the datastore in one go, calling
+ * @a proc with each item after it was removed.  Without @a
+ * low_priority, only items that expired before @a now are removed,
+ * those that expired first go first.  With @a low_priority, the
+ * items with the lowest priority are removed whether or not they
+ * expired; plugins that cannot efficiently order by priority may
+ * remove the oldest items instead, as with #PluginGetRandom for
+ * expiration.
+ *
+ * @param cls closure
+ * @param now current time
+ * @param low_priority true to remove low-priority items,
+ *        false to remove only expired items
+ * @param limit maximum number of items to remove
+ * @param proc function to call on each removed item
+ * @param proc_cls closure for @a proc
+ * @return number of items removed
+ */
+typedef unsigned int
+(*PluginRemoveBatch) (void *cls,
+                      struct GNUNET_TIME_Absolute now,
+                      bool low_priority,
+                      unsigned int limit,
+                      PluginRemovedProcessor proc,
+                      void *proc_cls);
+
+
 /**
  * Get a random item (additional constraints may apply depending on
  * the specific implementation).  Calls @a proc with all values ZERO or
@@ -376,6 +425,12 @@ struct GNUNET_DATASTORE_PluginFunctions
    * Function to remove an item from the database.
    */
   PluginRemoveKey remove_key;
+
+  /**
+   * Function to remove expired or low-priority items from the
+   * database in batches.
+   */
+  PluginRemoveBatch remove_batch;
 };
 
 #endif
@@ -65,7 +65,9 @@ enum GNUNET_DNS_Flags
    * (for monitoring).  Clients that set this flag must then
    * call "GNUNET_DNS_request_forward" when they process a request
    * for the first time.  Calling "GNUNET_DNS_request_answer" is
-   * not allowed for MONITOR peers.
+   * not allowed for MONITOR peers, and dropping has no effect: the
+   * request does not wait for monitors.  Monitors that do not keep
+   * up miss requests.
    */
   GNUNET_DNS_FLAG_REQUEST_MONITOR = 1,
 
@@ -94,7 +96,7 @@ enum GNUNET_DNS_Flags
    * returned to the network.  Clients that set this flag must then
    * call "GNUNET_DNS_request_forward" when they process a request
    * for the last time.  Calling "GNUNET_DNS_request_answer" is
-   * not allowed for MONITOR peers.
+   * not allowed for MONITOR peers, and dropping has no effect.
    */
   GNUNET_DNS_FLAG_RESPONSE_MONITOR = 8
 };
@@ -513,6 +513,29 @@ char *
 GNUNET_GNSRECORD_string_normalize (const char *src);
 
 
+/**
+ * Size of a buffer that fits most normalized labels, for use
+ * with #GNUNET_GNSRECORD_string_normalize_buf().
+ */
+#define GNUNET_GNSRECORD_LABEL_BUFFER_SIZE 256
+
+
+/**
+ * Normalize a UTF-8 string to a GNS name without allocating
+ * if the result fits into @a buf.
+ *
+ * @param src source string
+ * @param buf buffer for the result
+ * @param buf_size size of @a buf
+ * @return @a buf, a freshly allocated result if @a buf is too
+ *         small, or NULL on error
+ */
+char *
+GNUNET_GNSRECORD_string_normalize_buf (const char *src,
+                                       char *buf,
+                                       size_t buf_size);
+
+
 /**
  * Convert a zone to a string (for printing debug messages).
  * This is one of the very few calls in the entire API that is
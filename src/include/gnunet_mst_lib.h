@@ -134,6 +134,43 @@ GNUNET_MST_read (struct GNUNET_MessageStreamTokenizer *mst,
                  int one_shot);
 
 
+/**
+ * Obtain a region of the internal buffer of @a mst that the caller
+ * may read data into directly, avoiding a copy through an
+ * intermediate buffer.  The region is only valid until the next call
+ * on @a mst.  After filling (a prefix of) it, the caller must call
+ * #GNUNET_MST_receive_commit().
+ *
+ * @param mst tokenizer to use
+ * @param[out] size set to the number of bytes available at the result
+ * @return pointer to the free space in the buffer of @a mst
+ */
+void *
+GNUNET_MST_receive_buffer (struct GNUNET_MessageStreamTokenizer *mst,
+                           size_t *size);
+
+
+/**
+ * Add @a size bytes that were written into the region returned by
+ * #GNUNET_MST_receive_buffer() to the stream and call the callback
+ * for all complete messages.
+ *
+ * @param mst tokenizer to use
+ * @param size number of bytes written into the receive buffer
+ * @param purge should any excess bytes in the buffer be discarded
+ *       (i.e. for packet-based services like UDP)
+ * @param one_shot only call callback once, keep rest of message in buffer
+ * @return #GNUNET_OK if we are done processing (need more data)
+ *         #GNUNET_NO if one_shot was set and we have another message ready
+ *         #GNUNET_SYSERR if the data stream is corrupt
+ */
+enum GNUNET_GenericReturnValue
+GNUNET_MST_receive_commit (struct GNUNET_MessageStreamTokenizer *mst,
+                           size_t size,
+                           int purge,
+                           int one_shot);
+
+
 /**
  * Obtain the next message from the @a mst, assuming that
  * there are more unprocessed messages in the internal buffer
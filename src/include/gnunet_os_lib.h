@@ -403,6 +403,91 @@ void
 GNUNET_OS_network_interfaces_list (GNUNET_OS_NetworkInterfaceProcessor proc,
                                    void *proc_cls);
 
+
+/**
+ * Kinds of changes reported by a network interface monitor.
+ */
+enum GNUNET_OS_NetworkInterfaceChange
+{
+  /**
+   * An address appeared on an interface.
+   */
+  GNUNET_OS_NIC_ADDED,
+
+  /**
+   * An address disappeared from an interface.
+   */
+  GNUNET_OS_NIC_REMOVED,
+
+  /**
+   * All changes found in one scan were reported.  All other
+   * arguments of the callback are NULL or zero.
+   */
+  GNUNET_OS_NIC_SYNCED
+};
+
+
+/**
+ * Callback function invoked for each change of the network interfaces.
+ * Must not stop the monitor.
+ *
+ * @param cls closure
+ * @param change what happened
+ * @param name name of the interface (can be NULL for unknown)
+ * @param isDefault is this presumably the default interface
+ * @param addr address of this interface
+ * @param broadcast_addr the broadcast address (can be NULL for unknown or unassigned)
+ * @param netmask the network mask (can be NULL for unknown or unassigned)
+ * @param addrlen length of the address
+ */
+typedef void
+(*GNUNET_OS_NetworkInterfaceMonitorCallback)(
+  void *cls,
+  enum GNUNET_OS_NetworkInterfaceChange change,
+  const char *name,
+  int isDefault,
+  const struct sockaddr *addr,
+  const struct sockaddr *broadcast_addr,
+  const struct sockaddr *netmask,
+  socklen_t addrlen);
+
+
+/**
+ * Handle to a monitor of the network interfaces.
+ */
+struct GNUNET_OS_NetworkInterfaceMonitor;
+
+
+/**
+ * @brief Monitor the network interfaces for changes
+ *
+ * Reports all current addresses as added (followed by
+ * #GNUNET_OS_NIC_SYNCED) before returning, and afterwards the
+ * differences whenever the addresses change.  Changes are
+ * noticed via rtnetlink where available, otherwise the
+ * interfaces are scanned every @a poll_freq.
+ *
+ * @param poll_freq how often to scan if we are not notified of changes
+ * @param cb function to call on changes
+ * @param cb_cls closure for @a cb
+ * @return handle to stop the monitor
+ */
+struct GNUNET_OS_NetworkInterfaceMonitor *
+GNUNET_OS_network_interfaces_monitor_start (
+  struct GNUNET_TIME_Relative poll_freq,
+  GNUNET_OS_NetworkInterfaceMonitorCallback cb,
+  void *cb_cls);
+
+
+/**
+ * Stop monitoring the network interfaces.
+ *
+ * @param mon monitor to stop
+ */
+void
+GNUNET_OS_network_interfaces_monitor_stop (
+  struct GNUNET_OS_NetworkInterfaceMonitor *mon);
+
 #ifndef HAVE_SYSCONF
 #define HAVE_SYSCONF 0
 #endif
@@ -416,6 +416,11 @@ typedef int
  * signal will only shut down one scheduler; applications should
  * always only create a single scheduler.
  *
+ * The event loop uses select() unless the environment variable
+ * "GNUNET_SCHEDULER_DRIVER" is set to "io_uring" and the kernel
+ * supports io_uring, in which case readiness notifications and the
+ * asynchronous I/O operations below are handled by an io_uring.
+ *
  * @param task task to run first (and immediately)
  * @param task_cls closure of @a task
  */
@@ -924,6 +929,122 @@ void
 GNUNET_SCHEDULER_begin_async_scope (struct GNUNET_AsyncScopeId *aid);
 
 
+/**
+ * Handle for an asynchronous read or write operation.
+ */
+struct GNUNET_SCHEDULER_AsyncIo;
+
+
+/**
+ * Function called once an asynchronous read or write operation
+ * completed.
+ *
+ * @param cls closure
+ * @param result number of bytes transferred, or -1 on error
+ *        (in which case errno is set)
+ */
+typedef void
+(*GNUNET_SCHEDULER_AsyncIoCallback) (void *cls,
+                                     ssize_t result);
+
+
+/**
+ * Read from a file without blocking the scheduler.  With the io_uring
+ * event loop the read is submitted to the kernel and completes in the
+ * background; otherwise it is performed from a task scheduled with
+ * #GNUNET_SCHEDULER_add_now().  Either way @a cb runs as a scheduler
+ * task.  @a buf must remain valid until @a cb was called or the
+ * operation was cancelled.
+ *
+ * @param fh file to read from
+ * @param offset position to read from, -1 for the current file position
+ * @param buf buffer to read into
+ * @param len number of bytes to read at most
+ * @param cb function to call with the result
+ * @param cb_cls closure for @a cb
+ * @return handle to cancel the operation
+ */
+struct GNUNET_SCHEDULER_AsyncIo *
+GNUNET_SCHEDULER_file_read_async (const struct GNUNET_DISK_FileHandle *fh,
+                                  off_t offset,
+                                  void *buf,
+                                  size_t len,
+                                  GNUNET_SCHEDULER_AsyncIoCallback cb,
+                                  void *cb_cls);
+
+
+/**
+ * Write to a file without blocking the scheduler.
+ * See #GNUNET_SCHEDULER_file_read_async().
+ *
+ * @param fh file to write to
+ * @param offset position to write at, -1 for the current file position
+ * @param buf data to write
+ * @param len number of bytes in @a buf
+ * @param cb function to call with the result
+ * @param cb_cls closure for @a cb
+ * @return handle to cancel the operation
+ */
+struct GNUNET_SCHEDULER_AsyncIo *
+GNUNET_SCHEDULER_file_write_async (const struct GNUNET_DISK_FileHandle *fh,
+                                   off_t offset,
+                                   const void *buf,
+                                   size_t len,
+                                   GNUNET_SCHEDULER_AsyncIoCallback cb,
+                                   void *cb_cls);
+
+
+/**
+ * Receive from a socket once data is available.  With the io_uring
+ * event loop readiness and the receive are a single submission;
+ * otherwise this waits using #GNUNET_SCHEDULER_add_read_net() and
+ * then calls recv().  @a cb runs as a scheduler task.
+ *
+ * @param sock socket to receive from
+ * @param buf buffer to receive into
+ * @param len size of @a buf
+ * @param cb function to call with the result
+ * @param cb_cls closure for @a cb
+ * @return handle to cancel the operation
+ */
+struct GNUNET_SCHEDULER_AsyncIo *
+GNUNET_SCHEDULER_net_recv_async (struct GNUNET_NETWORK_Handle *sock,
+                                 void *buf,
+                                 size_t len,
+                                 GNUNET_SCHEDULER_AsyncIoCallback cb,
+                                 void *cb_cls);
+
+
+/**
+ * Send on a socket once it is writable.
+ * See #GNUNET_SCHEDULER_net_recv_async().
+ *
+ * @param sock socket to send on
+ * @param buf data to send
+ * @param len number of bytes in @a buf
+ * @param cb function to call with the result
+ * @param cb_cls closure for @a cb
+ * @return handle to cancel the operation
+ */
+struct GNUNET_SCHEDULER_AsyncIo *
+GNUNET_SCHEDULER_net_send_async (struct GNUNET_NETWORK_Handle *sock,
+                                 const void *buf,
+                                 size_t len,
+                                 GNUNET_SCHEDULER_AsyncIoCallback cb,
+                                 void *cb_cls);
+
+
+/**
+ * Cancel an asynchronous operation whose callback was not yet
+ * called.  Once this returns, the kernel no longer accesses the
+ * buffer of the operation.
+ *
+ * @param aio operation to cancel
+ */
+void
+GNUNET_SCHEDULER_async_io_cancel (struct GNUNET_SCHEDULER_AsyncIo *aio);
+
+
 #if 0                           /* keep Emacsens' auto-indent happy */
 {
 #endif
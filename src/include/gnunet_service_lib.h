@@ -92,7 +92,16 @@ enum GNUNET_SERVICE_Options
    * Instead of listening on lsocks passed by the parent,
    * close them *after* opening our own listen socket(s).
    */
-  GNUNET_SERVICE_OPTION_CLOSE_LSOCKS = 4
+  GNUNET_SERVICE_OPTION_CLOSE_LSOCKS = 4,
+
+  /**
+   * If a handler calls #GNUNET_SERVICE_client_continue() before it
+   * returns, pass the next message already received from the client
+   * to the handlers right away instead of in a new task.  Only for
+   * services whose handlers do not expect tasks they schedule to run
+   * before the next message from the same client is processed.
+   */
+  GNUNET_SERVICE_OPTION_INLINE_CONTINUE = 8
 };
 
 
@@ -433,7 +442,10 @@ GNUNET_SERVICE_resume (struct GNUNET_SERVICE_Handle *sh);
 
 /**
  * Continue receiving further messages from the given client.
- * Must be called after each message received.
+ * Must be called after each message received.  With
+ * #GNUNET_SERVICE_OPTION_INLINE_CONTINUE, a call from within
+ * the handler makes the next message be processed once the
+ * handler returns.
  *
  * @param c the client to continue receiving from
  */
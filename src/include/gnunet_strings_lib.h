@@ -180,6 +180,25 @@ char*
 GNUNET_STRINGS_utf8_normalize (const char *input);
 
 
+/**
+ * Normalize the utf-8 input string to NFC, writing the result to a
+ * caller-provided buffer.  Input that is already in NFC, such as
+ * plain ASCII, is copied without consulting libunistring.
+ *
+ * @param input input string
+ * @param[out] output where to write the 0-terminated result
+ * @param[in,out] output_len size of @a output; set to the length of
+ *             the result (without 0-terminator) on success, or to
+ *             the size @a output would need if it is too small
+ * @return #GNUNET_OK on success, #GNUNET_NO if @a output is too small,
+ *         #GNUNET_SYSERR on error
+ */
+enum GNUNET_GenericReturnValue
+GNUNET_STRINGS_utf8_normalize_buf (const char *input,
+                                   char *output,
+                                   size_t *output_len);
+
+
 /**
  * Convert the len bytes-long UTF-8 string
  * given in input to the given charset.
@@ -956,6 +956,24 @@ GNUNET_TUN_sockaddr_cmp (const struct sockaddr *sa,
                          int include_port);
 
 
+/**
+ * Compute a keyed 32-bit hash over a flow tuple, to pick the bucket
+ * of a connection table.  This is FNV-1a seeded with @a key followed
+ * by a 64-bit finalizer, cheap enough to be run on every packet.
+ * Use a random @a key, so that remote parties cannot choose flows
+ * that all land in the same bucket.
+ *
+ * @param key random key of the table
+ * @param buf tuple to hash
+ * @param len number of bytes in @a buf
+ * @return bucket selector for @a buf
+ */
+uint32_t
+GNUNET_TUN_flow_hash (uint64_t key,
+                      const void *buf,
+                      size_t len);
+
+
 /**
  * Compute the CADET port given a service descriptor
  * (returned from #GNUNET_TUN_service_name_to_hash) and
@@ -29,6 +29,18 @@
 #include "gnunet_block_plugin.h"
 
 
+/**
+ * Precedes the mutator in the serialized state of groups that
+ * mingle with #GNUNET_BLOCK_mingle_hash_keyed() instead of the
+ * (much slower) #GNUNET_BLOCK_mingle_hash(), in network byte order.
+ * The state of other groups starts with the mutator, so older peers
+ * and their groups keep using #GNUNET_BLOCK_mingle_hash().  Only a
+ * legacy group whose random mutator happens to equal this value
+ * (one in 2^32) is misread.
+ */
+#define BF_KEYED_MAGIC 0x4b424631U /* "KBF1" */
+
+
 /**
  * Internal data structure for a block group.
  */
@@ -48,9 +60,44 @@ struct BfGroupInternals
    * Size of @a bf.
    */
   uint32_t bf_size;
+
+  /**
+   * Key derived from @e bf_mutator, only valid if @e keyed is set.
+   */
+  struct GNUNET_BLOCK_MingleKey key;
+
+  /**
+   * True if the group uses #GNUNET_BLOCK_mingle_hash_keyed() and
+   * serializes with #BF_KEYED_MAGIC.
+   */
+  bool keyed;
 };
 
 
+/**
+ * Mingle @a in with the mutator of @a gi, using the function
+ * selected by the group format.
+ *
+ * @param gi group to mingle for
+ * @param in hash to mingle
+ * @param[out] mhash set to the mingled hash
+ */
+static void
+bf_mingle (const struct BfGroupInternals *gi,
+           const struct GNUNET_HashCode *in,
+           struct GNUNET_HashCode *mhash)
+{
+  if (gi->keyed)
+    GNUNET_BLOCK_mingle_hash_keyed (in,
+                                    &gi->key,
+                                    mhash);
+  else
+    GNUNET_BLOCK_mingle_hash (in,
+                              gi->bf_mutator,
+                              mhash);
+}
+
+
 /**
  * Serialize state of a block group.
  *
@@ -66,23 +113,33 @@ bf_group_serialize_cb (struct GNUNET_BLOCK_Group *bg,
                        size_t *raw_data_size)
 {
   struct BfGroupInternals *gi = bg->internal_cls;
-  void *raw;
+  size_t hdr_size;
+  char *raw;
 
-  raw = GNUNET_malloc (gi->bf_size + sizeof (uint32_t));
+  hdr_size = gi->keyed ? 2 * sizeof (uint32_t) : sizeof (uint32_t);
+  raw = GNUNET_malloc (hdr_size + gi->bf_size);
   if (GNUNET_OK !=
       GNUNET_CONTAINER_bloomfilter_get_raw_data (gi->bf,
-                                                 raw + sizeof (uint32_t),
+                                                 raw + hdr_size,
                                                  gi->bf_size))
   {
     GNUNET_free (raw);
     GNUNET_break (0);
     return GNUNET_SYSERR;
   }
-  memcpy (raw,
+  if (gi->keyed)
+  {
+    uint32_t magic = htonl (BF_KEYED_MAGIC);
+
+    memcpy (raw,
+            &magic,
+            sizeof (uint32_t));
+  }
+  memcpy (raw + hdr_size - sizeof (uint32_t),
           &gi->bf_mutator,
           sizeof (uint32_t));
   *raw_data = raw;
-  *raw_data_size = gi->bf_size + sizeof (uint32_t);
+  *raw_data_size = hdr_size + gi->bf_size;
   return GNUNET_OK;
 }
 
@@ -106,9 +163,9 @@ bf_group_mark_seen_cb (struct GNUNET_BLOCK_Group *bg,
   {
     struct GNUNET_HashCode mhash;
 
-    GNUNET_BLOCK_mingle_hash (&seen_results[i],
-                              gi->bf_mutator,
-                              &mhash);
+    bf_mingle (gi,
+               &seen_results[i],
+               &mhash);
     GNUNET_CONTAINER_bloomfilter_add (gi->bf,
                                       &mhash);
   }
@@ -131,7 +188,8 @@ bf_group_merge_cb (struct GNUNET_BLOCK_Group *bg1,
   struct BfGroupInternals *gi1 = bg1->internal_cls;
   struct BfGroupInternals *gi2 = bg2->internal_cls;
 
-  if (gi1->bf_mutator != gi2->bf_mutator)
+  if ( (gi1->bf_mutator != gi2->bf_mutator) ||
+       (gi1->keyed != gi2->keyed) )
     return GNUNET_NO;
   if (gi1->bf_size != gi2->bf_size)
     return GNUNET_NO;
@@ -180,6 +238,7 @@ GNUNET_BLOCK_GROUP_bf_create (void *cls,
   struct BfGroupInternals *gi;
   struct GNUNET_BLOCK_Group *bg;
   uint32_t nonce;
+  bool keyed;
 
   if ( (NULL != raw_data) &&
        (raw_data_size < sizeof (nonce)) )
@@ -189,6 +248,18 @@ GNUNET_BLOCK_GROUP_bf_create (void *cls,
   }
   if (NULL != raw_data)
   {
+    uint32_t magic;
+
+    memcpy (&magic,
+            raw_data,
+            sizeof (magic));
+    keyed = ( (raw_data_size >= 2 * sizeof (nonce)) &&
+              (BF_KEYED_MAGIC == ntohl (magic)) );
+    if (keyed)
+    {
+      raw_data += sizeof (magic);
+      raw_data_size -= sizeof (magic);
+    }
     memcpy (&nonce,
             raw_data,
             sizeof (nonce));
@@ -199,6 +270,7 @@ GNUNET_BLOCK_GROUP_bf_create (void *cls,
   {
     nonce = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_NONCE,
                                       UINT32_MAX);
+    keyed = true;
   }
   gi = GNUNET_new (struct BfGroupInternals);
   gi->bf = GNUNET_CONTAINER_bloomfilter_init ((bf_size != raw_data_size) ?
@@ -207,6 +279,10 @@ GNUNET_BLOCK_GROUP_bf_create (void *cls,
                                               bf_k);
   gi->bf_mutator = nonce;
   gi->bf_size = bf_size;
+  gi->keyed = keyed;
+  if (gi->keyed)
+    GNUNET_BLOCK_mingle_key_init (nonce,
+                                  &gi->key);
   bg = GNUNET_new (struct GNUNET_BLOCK_Group);
   bg->type = type;
   bg->serialize_cb = &bf_group_serialize_cb;
@@ -238,9 +314,9 @@ GNUNET_BLOCK_GROUP_bf_test_and_set (struct GNUNET_BLOCK_Group *bg,
   if (NULL == bg)
     return GNUNET_NO;
   gi = bg->internal_cls;
-  GNUNET_BLOCK_mingle_hash (hc,
-                            gi->bf_mutator,
-                            &mhash);
+  bf_mingle (gi,
+             hc,
+             &mhash);
   if (GNUNET_YES ==
       GNUNET_CONTAINER_bloomfilter_test (gi->bf,
                                          &mhash))
@@ -108,6 +108,55 @@ GNUNET_BLOCK_mingle_hash (const struct GNUNET_HashCode *in,
 }
 
 
+void
+GNUNET_BLOCK_mingle_key_init (uint32_t mingle_number,
+                              struct GNUNET_BLOCK_MingleKey *key)
+{
+  struct GNUNET_HashCode h;
+  uint64_t w[8];
+  uint32_t nbo = htonl (mingle_number);
+
+  GNUNET_static_assert (sizeof (h) == sizeof (w));
+  GNUNET_CRYPTO_hash (&nbo,
+                      sizeof (nbo),
+                      &h);
+  memcpy (w,
+          &h,
+          sizeof (w));
+  for (unsigned int i = 0; i < 8; i++)
+    key->k[i] = GNUNET_ntohll (w[i]);
+}
+
+
+void
+GNUNET_BLOCK_mingle_hash_keyed (const struct GNUNET_HashCode *in,
+                                const struct GNUNET_BLOCK_MingleKey *key,
+                                struct GNUNET_HashCode *hc)
+{
+  uint64_t w[8];
+
+  memcpy (w,
+          in,
+          sizeof (w));
+  for (unsigned int i = 0; i < 8; i++)
+  {
+    /* XOR in the key, then the 64-bit finalizer of MurmurHash3 so that
+       every input bit affects every output bit of the word */
+    uint64_t x = GNUNET_ntohll (w[i]) ^ key->k[i];
+
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdLLU;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53LLU;
+    x ^= x >> 33;
+    w[i] = GNUNET_htonll (x);
+  }
+  memcpy (hc,
+          w,
+          sizeof (w));
+}
+
+
 /**
  * Add a plugin to the list managed by the block library.
  *
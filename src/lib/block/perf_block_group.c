@@ -0,0 +1,282 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file block/perf_block_group.c
+ * @brief measure the cost of maintaining the seen-set of a Bloom filter
+ *        block group for a request with many results, comparing the
+ *        hash-based and the keyed mingle function as well as rebuilding
+ *        the group on every retransmission with adding only new results
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "gnunet_block_group_lib.h"
+
+/**
+ * Number of results seen over the lifetime of the request.
+ */
+#define NUM_RESULTS (64 * 1024)
+
+/**
+ * Number of retransmissions of the request, spread evenly over
+ * the arrival of the results.
+ */
+#define RETRIES 64
+
+/**
+ * K-value for the Bloom filter, as used by the block plugins.
+ */
+#define BF_K 16
+
+/**
+ * Mutator of our groups; with the top bit set, which older peers
+ * set at random, to check that it does not select the mingle function.
+ */
+#define MUTATOR 0x92345678U
+
+/**
+ * Marks the serialized state of groups using the keyed mingle
+ * function, see bg_bf.c.
+ */
+#define KEYED_MAGIC 0x4b424631U
+
+
+static struct GNUNET_HashCode results[NUM_RESULTS];
+
+
+/**
+ * Create a group sized for @a count results, as received from a peer.
+ *
+ * @param keyed true for a group using the keyed mingle function,
+ *        false for one from an older peer
+ * @param count number of results to size the group for
+ */
+static struct GNUNET_BLOCK_Group *
+make_group (bool keyed,
+            unsigned int count)
+{
+  struct GNUNET_BLOCK_Group *bg;
+  uint32_t raw[2] = {
+    htonl (KEYED_MAGIC),
+    MUTATOR
+  };
+
+  bg = GNUNET_BLOCK_GROUP_bf_create (NULL,
+                                     GNUNET_BLOCK_GROUP_compute_bloomfilter_size
+                                       (count,
+                                       BF_K),
+                                     BF_K,
+                                     GNUNET_BLOCK_TYPE_TEST,
+                                     keyed ? &raw[0] : &raw[1],
+                                     keyed ? sizeof (raw) : sizeof (raw[1]));
+  GNUNET_assert (NULL != bg);
+  return bg;
+}
+
+
+static void
+report (const char *mode,
+        struct GNUNET_TIME_Absolute start,
+        unsigned long long ops)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %llu insertions in %s (%llu/s)\n",
+          mode,
+          ops,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          ops * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+/**
+ * Create a fresh group with all results seen so far for every
+ * retransmission, as the DHT used to.
+ */
+static void
+perf_rebuild (const char *mode,
+              bool keyed)
+{
+  struct GNUNET_TIME_Absolute start;
+  unsigned long long ops = 0;
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int r = 1; r <= RETRIES; r++)
+  {
+    unsigned int seen = NUM_RESULTS / RETRIES * r;
+    struct GNUNET_BLOCK_Group *bg;
+
+    bg = make_group (keyed,
+                     seen);
+    GNUNET_BLOCK_group_set_seen (bg,
+                                 results,
+                                 seen);
+    GNUNET_BLOCK_group_destroy (bg);
+    ops += seen;
+  }
+  report (mode,
+          start,
+          ops);
+}
+
+
+/**
+ * Keep the group across retransmissions, only adding new results
+ * and re-creating the group when it needs to grow.
+ */
+static void
+perf_incremental (const char *mode,
+                  bool keyed)
+{
+  struct GNUNET_TIME_Absolute start;
+  struct GNUNET_BLOCK_Group *bg = NULL;
+  unsigned int bg_seen_count = 0;
+  unsigned int bg_seen_size = 0;
+  unsigned long long ops = 0;
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int r = 1; r <= RETRIES; r++)
+  {
+    unsigned int seen = NUM_RESULTS / RETRIES * r;
+
+    if ( (NULL == bg) ||
+         (GNUNET_BLOCK_GROUP_compute_bloomfilter_size (seen,
+                                                       BF_K) >
+          GNUNET_BLOCK_GROUP_compute_bloomfilter_size (bg_seen_size,
+                                                       BF_K)) )
+    {
+      GNUNET_BLOCK_group_destroy (bg);
+      bg_seen_size = 2 * seen;
+      bg_seen_count = 0;
+      bg = make_group (keyed,
+                       bg_seen_size);
+    }
+    GNUNET_BLOCK_group_set_seen (bg,
+                                 &results[bg_seen_count],
+                                 seen - bg_seen_count);
+    ops += seen - bg_seen_count;
+    bg_seen_count = seen;
+  }
+  GNUNET_BLOCK_group_destroy (bg);
+  report (mode,
+          start,
+          ops);
+}
+
+
+/**
+ * Check that every seen result is filtered, also after passing the
+ * group on, and that a group from an older peer uses the hash mingle
+ * function regardless of its mutator.
+ *
+ * @param keyed passed to make_group()
+ */
+static void
+check_filter (bool keyed)
+{
+  struct GNUNET_BLOCK_Group *bg;
+  struct GNUNET_BLOCK_Group *bg2;
+  void *raw;
+  size_t raw_size;
+  size_t bf_size;
+
+  bf_size = GNUNET_BLOCK_GROUP_compute_bloomfilter_size (NUM_RESULTS / RETRIES,
+                                                         BF_K);
+  bg = make_group (keyed,
+                   NUM_RESULTS / RETRIES);
+  GNUNET_BLOCK_group_set_seen (bg,
+                               results,
+                               NUM_RESULTS / RETRIES);
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_BLOCK_group_serialize (bg,
+                                               &raw,
+                                               &raw_size));
+  GNUNET_assert (raw_size == bf_size
+                 + (keyed ? 2 : 1) * sizeof (uint32_t));
+  if (! keyed)
+  {
+    struct GNUNET_CONTAINER_BloomFilter *bf;
+
+    bf = GNUNET_CONTAINER_bloomfilter_init ((const char *) raw
+                                            + sizeof (uint32_t),
+                                            bf_size,
+                                            BF_K);
+    for (unsigned int i = 0; i < NUM_RESULTS / RETRIES; i++)
+    {
+      struct GNUNET_HashCode mhash;
+
+      GNUNET_BLOCK_mingle_hash (&results[i],
+                                MUTATOR,
+                                &mhash);
+      GNUNET_assert (GNUNET_YES ==
+                     GNUNET_CONTAINER_bloomfilter_test (bf,
+                                                        &mhash));
+    }
+    GNUNET_CONTAINER_bloomfilter_free (bf);
+  }
+  bg2 = GNUNET_BLOCK_GROUP_bf_create (NULL,
+                                      bf_size,
+                                      BF_K,
+                                      GNUNET_BLOCK_TYPE_TEST,
+                                      raw,
+                                      raw_size);
+  GNUNET_free (raw);
+  for (unsigned int i = 0; i < NUM_RESULTS / RETRIES; i++)
+  {
+    GNUNET_assert (GNUNET_YES ==
+                   GNUNET_BLOCK_GROUP_bf_test_and_set (bg,
+                                                       &results[i]));
+    GNUNET_assert (GNUNET_YES ==
+                   GNUNET_BLOCK_GROUP_bf_test_and_set (bg2,
+                                                       &results[i]));
+  }
+  GNUNET_BLOCK_group_destroy (bg);
+  GNUNET_BLOCK_group_destroy (bg2);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  GNUNET_log_setup ("perf-block-group",
+                    "WARNING",
+                    NULL);
+  for (unsigned int i = 0; i < NUM_RESULTS; i++)
+    GNUNET_CRYPTO_hash (&i,
+                        sizeof (i),
+                        &results[i]);
+  check_filter (false);
+  check_filter (true);
+  perf_rebuild ("rebuild, hash mingle",
+                false);
+  perf_rebuild ("rebuild, keyed mingle",
+                true);
+  perf_incremental ("incremental, hash mingle",
+                    false);
+  perf_incremental ("incremental, keyed mingle",
+                    true);
+  return 0;
+}
+
+
+/* end of perf_block_group.c */
@@ -279,11 +279,14 @@ GNUNET_GNSRECORD_block_sign (const struct
 {
   struct GNUNET_CRYPTO_PublicKey pkey;
   enum GNUNET_GenericReturnValue res = GNUNET_SYSERR;
+  char norm_buf[GNUNET_GNSRECORD_LABEL_BUFFER_SIZE];
   char *norm_label;
 
   GNUNET_CRYPTO_key_get_public (key,
                                 &pkey);
-  norm_label = GNUNET_GNSRECORD_string_normalize (label);
+  norm_label = GNUNET_GNSRECORD_string_normalize_buf (label,
+                                                      norm_buf,
+                                                      sizeof (norm_buf));
 
   switch (ntohl (key->type))
   {
@@ -302,7 +305,8 @@ GNUNET_GNSRECORD_block_sign (const struct
   default:
     GNUNET_assert (0);
   }
-  GNUNET_free (norm_label);
+  if (norm_buf != norm_label)
+    GNUNET_free (norm_label);
   return res;
 }
 
@@ -545,11 +549,14 @@ GNUNET_GNSRECORD_block_create (const struct GNUNET_CRYPTO_PrivateKey *key,
 {
   struct GNUNET_CRYPTO_PublicKey pkey;
   enum GNUNET_GenericReturnValue res = GNUNET_SYSERR;
+  char norm_buf[GNUNET_GNSRECORD_LABEL_BUFFER_SIZE];
   char *norm_label;
 
   GNUNET_CRYPTO_key_get_public (key,
                                 &pkey);
-  norm_label = GNUNET_GNSRECORD_string_normalize (label);
+  norm_label = GNUNET_GNSRECORD_string_normalize_buf (label,
+                                                      norm_buf,
+                                                      sizeof (norm_buf));
 
   switch (ntohl (key->type))
   {
@@ -576,7 +583,8 @@ GNUNET_GNSRECORD_block_create (const struct GNUNET_CRYPTO_PrivateKey *key,
   default:
     GNUNET_assert (0);
   }
-  GNUNET_free (norm_label);
+  if (norm_buf != norm_label)
+    GNUNET_free (norm_label);
   return res;
 }
 
@@ -610,12 +618,15 @@ block_create2 (const struct GNUNET_CRYPTO_PrivateKey *pkey,
   const struct GNUNET_CRYPTO_EcdsaPrivateKey *key;
   struct GNUNET_CRYPTO_EddsaPublicKey edpubkey;
   enum GNUNET_GenericReturnValue res = GNUNET_SYSERR;
+  char norm_buf[GNUNET_GNSRECORD_LABEL_BUFFER_SIZE];
   char *norm_label;
 #define CSIZE 64
   static struct KeyCacheLine cache[CSIZE];
   struct KeyCacheLine *line;
 
-  norm_label = GNUNET_GNSRECORD_string_normalize (label);
+  norm_label = GNUNET_GNSRECORD_string_normalize_buf (label,
+                                                      norm_buf,
+                                                      sizeof (norm_buf));
 
   if (GNUNET_PUBLIC_KEY_TYPE_ECDSA == ntohl (pkey->type))
   {
@@ -654,7 +665,8 @@ block_create2 (const struct GNUNET_CRYPTO_PrivateKey *pkey,
                               sign);
   }
 #undef CSIZE
-  GNUNET_free (norm_label);
+  if (norm_buf != norm_label)
+    GNUNET_free (norm_label);
   return res;
 }
 
@@ -991,9 +1003,12 @@ GNUNET_GNSRECORD_block_decrypt (const struct GNUNET_GNSRECORD_Block *block,
                                 void *proc_cls)
 {
   enum GNUNET_GenericReturnValue res = GNUNET_SYSERR;
+  char norm_buf[GNUNET_GNSRECORD_LABEL_BUFFER_SIZE];
   char *norm_label;
 
-  norm_label = GNUNET_GNSRECORD_string_normalize (label);
+  norm_label = GNUNET_GNSRECORD_string_normalize_buf (label,
+                                                      norm_buf,
+                                                      sizeof (norm_buf));
   switch (ntohl (zone_key->type))
   {
   case GNUNET_PUBLIC_KEY_TYPE_ECDSA:
@@ -1009,7 +1024,8 @@ GNUNET_GNSRECORD_block_decrypt (const struct GNUNET_GNSRECORD_Block *block,
   default:
     res = GNUNET_SYSERR;
   }
-  GNUNET_free (norm_label);
+  if (norm_buf != norm_label)
+    GNUNET_free (norm_label);
   return res;
 }
 
@@ -1027,10 +1043,8 @@ GNUNET_GNSRECORD_query_from_private_key (const struct
                                          const char *label,
                                          struct GNUNET_HashCode *query)
 {
-  char *norm_label;
   struct GNUNET_CRYPTO_PublicKey pub;
 
-  norm_label = GNUNET_GNSRECORD_string_normalize (label);
   switch (ntohl (zone->type))
   {
   case GNUNET_GNSRECORD_TYPE_PKEY:
@@ -1039,13 +1053,12 @@ GNUNET_GNSRECORD_query_from_private_key (const struct
     GNUNET_CRYPTO_key_get_public (zone,
                                   &pub);
     GNUNET_GNSRECORD_query_from_public_key (&pub,
-                                            norm_label,
+                                            label,
                                             query);
     break;
   default:
     GNUNET_assert (0);
   }
-  GNUNET_free (norm_label);
 }
 
 
@@ -1055,10 +1068,13 @@ GNUNET_GNSRECORD_query_from_public_key (const struct
                                         const char *label,
                                         struct GNUNET_HashCode *query)
 {
+  char norm_buf[GNUNET_GNSRECORD_LABEL_BUFFER_SIZE];
   char *norm_label;
   struct GNUNET_CRYPTO_PublicKey pd;
 
-  norm_label = GNUNET_GNSRECORD_string_normalize (label);
+  norm_label = GNUNET_GNSRECORD_string_normalize_buf (label,
+                                                      norm_buf,
+                                                      sizeof (norm_buf));
 
   switch (ntohl (pub->type))
   {
@@ -1085,7 +1101,8 @@ GNUNET_GNSRECORD_query_from_public_key (const struct
   default:
     GNUNET_assert (0);
   }
-  GNUNET_free (norm_label);
+  if (norm_buf != norm_label)
+    GNUNET_free (norm_label);
 }
 
 
@@ -40,6 +40,28 @@ GNUNET_GNSRECORD_string_normalize (const char *src)
 }
 
 
+char *
+GNUNET_GNSRECORD_string_normalize_buf (const char *src,
+                                       char *buf,
+                                       size_t buf_size)
+{
+  size_t len = buf_size;
+
+  /*FIXME: We may want to follow RFC5890/RFC5891 */
+  switch (GNUNET_STRINGS_utf8_normalize_buf (src,
+                                             buf,
+                                             &len))
+  {
+  case GNUNET_OK:
+    return buf;
+  case GNUNET_NO:
+    return GNUNET_STRINGS_utf8_normalize (src);
+  default:
+    return NULL;
+  }
+}
+
+
 enum GNUNET_GenericReturnValue
 GNUNET_GNSRECORD_label_check (const char*label, char **emsg)
 {
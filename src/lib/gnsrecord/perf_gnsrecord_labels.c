@@ -0,0 +1,257 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file gnsrecord/perf_gnsrecord_labels.c
+ * @brief measure the per-label work of the namestore (label check
+ *        and normalization on import, lookup and zone iteration)
+ *        and of GNS (query derivation, block creation and
+ *        decryption) for #NUM_LABELS distinct labels of each kind
+ */
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "gnunet_gnsrecord_lib.h"
+
+/**
+ * How many distinct labels do we process per kind?
+ */
+#define NUM_LABELS (100 * 1000)
+
+/**
+ * How many of the labels do we derive queries and sign and
+ * decrypt blocks for?  These are bound by public key operations
+ * and much slower than everything else we measure.
+ */
+#define NUM_BLOCKS 1000
+
+#define TEST_RECORD_TYPE 1234
+
+#define TEST_RECORD_DATALEN 123
+
+
+/**
+ * Kinds of labels, from the common case to the rare one.  We
+ * append a number to each prefix to get distinct labels.
+ */
+static const struct
+{
+  const char *kind;
+  const char *prefix;
+} kinds[] = {
+  { "ASCII", "www-mirror" },
+  { "Latin-1", "b\xc3\xbc" "cher-caf\xc3\xa9" },
+  { "Greek", "\xce\xb4\xce\xbf\xce\xba\xce\xb9\xce\xbc\xce\xae" }
+};
+
+
+/**
+ * Number of records we saw in decrypted blocks.
+ */
+static unsigned long long decrypted;
+
+
+static void
+report (const char *mode,
+        const char *kind,
+        unsigned int count,
+        struct GNUNET_TIME_Absolute start)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s, %s: %u labels in %s (%llu/s)\n",
+          mode,
+          kind,
+          count,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          count * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+static void
+count_records (void *cls,
+               unsigned int rd_count,
+               const struct GNUNET_GNSRECORD_Data *rd)
+{
+  (void) cls;
+  (void) rd;
+  decrypted += rd_count;
+}
+
+
+/**
+ * Run all measurements for the labels in @a names.
+ *
+ * @param kind what kind of labels these are
+ * @param names #NUM_LABELS labels
+ * @param zone zone to create the blocks in
+ * @param rd record to put into the blocks
+ * @return number of bytes of normalized labels, to keep the
+ *         compiler from dropping the work
+ */
+static size_t
+perf_labels (const char *kind,
+             char *const *names,
+             const struct GNUNET_CRYPTO_PrivateKey *zone,
+             const struct GNUNET_GNSRECORD_Data *rd)
+{
+  struct GNUNET_CRYPTO_PublicKey zone_pub;
+  struct GNUNET_GNSRECORD_Block *blocks[NUM_BLOCKS];
+  struct GNUNET_TIME_Absolute start;
+  struct GNUNET_TIME_Absolute expire;
+  struct GNUNET_HashCode query;
+  char buf[GNUNET_GNSRECORD_LABEL_BUFFER_SIZE];
+  char *emsg;
+  size_t total = 0;
+
+  /* what the namestore did per record set before it used a buffer */
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_LABELS; i++)
+  {
+    char *norm;
+
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_GNSRECORD_label_check (names[i],
+                                                 &emsg));
+    norm = GNUNET_GNSRECORD_string_normalize (names[i]);
+    GNUNET_assert (NULL != norm);
+    total += strlen (norm);
+    GNUNET_free (norm);
+  }
+  report ("check and normalize",
+          kind,
+          NUM_LABELS,
+          start);
+  /* what the namestore does per record set now */
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_LABELS; i++)
+  {
+    char *norm;
+
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_GNSRECORD_label_check (names[i],
+                                                 &emsg));
+    norm = GNUNET_GNSRECORD_string_normalize_buf (names[i],
+                                                  buf,
+                                                  sizeof (buf));
+    GNUNET_assert (buf == norm);
+    total += strlen (norm);
+  }
+  report ("check and normalize into buffer",
+          kind,
+          NUM_LABELS,
+          start);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_BLOCKS; i++)
+  {
+    GNUNET_GNSRECORD_query_from_private_key (zone,
+                                             names[i],
+                                             &query);
+    total += query.bits[0] & 1;
+  }
+  report ("derive query",
+          kind,
+          NUM_BLOCKS,
+          start);
+  expire.abs_value_us = rd->expiration_time;
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_BLOCKS; i++)
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_GNSRECORD_block_create (zone,
+                                                  expire,
+                                                  names[i],
+                                                  rd,
+                                                  1,
+                                                  &blocks[i]));
+  report ("create block",
+          kind,
+          NUM_BLOCKS,
+          start);
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CRYPTO_key_get_public (zone,
+                                               &zone_pub));
+  decrypted = 0;
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_BLOCKS; i++)
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_GNSRECORD_block_decrypt (blocks[i],
+                                                   &zone_pub,
+                                                   names[i],
+                                                   &count_records,
+                                                   NULL));
+  report ("decrypt block",
+          kind,
+          NUM_BLOCKS,
+          start);
+  GNUNET_assert (NUM_BLOCKS == decrypted);
+  for (unsigned int i = 0; i < NUM_BLOCKS; i++)
+    GNUNET_free (blocks[i]);
+  return total;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  struct GNUNET_CRYPTO_PrivateKey zone;
+  struct GNUNET_GNSRECORD_Data rd;
+  char data[TEST_RECORD_DATALEN];
+  char **names;
+  size_t total = 0;
+
+  GNUNET_log_setup ("perf-gnsrecord-labels",
+                    "WARNING",
+                    NULL);
+  zone.type = htonl (GNUNET_GNSRECORD_TYPE_PKEY);
+  GNUNET_CRYPTO_ecdsa_key_create (&zone.ecdsa_key);
+  memset (data,
+          'a',
+          sizeof (data));
+  memset (&rd,
+          0,
+          sizeof (rd));
+  rd.expiration_time = GNUNET_TIME_relative_to_absolute (
+    GNUNET_TIME_UNIT_HOURS).abs_value_us;
+  rd.record_type = TEST_RECORD_TYPE;
+  rd.data_size = sizeof (data);
+  rd.data = data;
+  names = GNUNET_new_array (NUM_LABELS,
+                            char *);
+  for (unsigned int k = 0; k < sizeof (kinds) / sizeof (kinds[0]); k++)
+  {
+    for (unsigned int i = 0; i < NUM_LABELS; i++)
+      GNUNET_asprintf (&names[i],
+                       "%s%u",
+                       kinds[k].prefix,
+                       i);
+    total += perf_labels (kinds[k].kind,
+                          names,
+                          &zone,
+                          &rd);
+    for (unsigned int i = 0; i < NUM_LABELS; i++)
+      GNUNET_free (names[i]);
+  }
+  GNUNET_free (names);
+  return (0 == total) ? 1 : 0;
+}
+
+
+/* end of perf_gnsrecord_labels.c */
@@ -21,6 +21,12 @@
 /**
  * @file util/container_heap.c
  * @brief Implementation of a heap
+ *
+ * The heap is a d-ary heap kept in an array of (cost, node) pairs,
+ * so that sifting only compares costs stored next to each other.
+ * The nodes handed out to the caller are allocated separately and
+ * know their index in the array, so that they can be updated and
+ * removed in O(log n).
  * @author Nathan Evans
  * @author Christian Grothoff
  */
@@ -34,6 +40,18 @@
 
 #define EXTRA_CHECKS 0
 
+/**
+ * Number of children of each node.  With four children, the
+ * entries of all children of a node fit into one or two cache lines.
+ */
+#define HEAP_ARITY 4
+
+/**
+ * Initial size of the array.
+ */
+#define HEAP_MIN_LENGTH 16
+
+
 /**
  * Node in the heap.
  */
@@ -45,51 +63,54 @@ struct GNUNET_CONTAINER_HeapNode
   struct GNUNET_CONTAINER_Heap *heap;
 
   /**
-   * Parent node.
-   */
-  struct GNUNET_CONTAINER_HeapNode *parent;
-
-  /**
-   * Left child.
+   * Our element.
    */
-  struct GNUNET_CONTAINER_HeapNode *left_child;
+  void *element;
 
   /**
-   * Right child.
+   * Position of the node in the array of the heap.
    */
-  struct GNUNET_CONTAINER_HeapNode *right_child;
+  unsigned int index;
+};
 
-  /**
-   * Our element.
-   */
-  void *element;
 
+/**
+ * Entry in the array of a heap.
+ */
+struct HeapEntry
+{
   /**
-   * Cost for this element.
+   * Cost of the node.
    */
   GNUNET_CONTAINER_HeapCostType cost;
 
   /**
-   * Number of elements below this node in the heap
-   * (excluding this node itself).
+   * The node, whose @e index is the position of this entry.
    */
-  unsigned int tree_size;
+  struct GNUNET_CONTAINER_HeapNode *node;
 };
 
+
 /**
  * Handle to a node in a heap.
  */
 struct GNUNET_CONTAINER_Heap
 {
   /**
-   * Root of the heap.
+   * Entries of the heap, the children of the entry at index i
+   * are at indices #HEAP_ARITY * i + 1 to #HEAP_ARITY * i + #HEAP_ARITY.
    */
-  struct GNUNET_CONTAINER_HeapNode *root;
+  struct HeapEntry *array;
 
   /**
-   * Current position of our random walk.
+   * Allocated length of @e array.
    */
-  struct GNUNET_CONTAINER_HeapNode *walk_pos;
+  unsigned int array_length;
+
+  /**
+   * Current position of our random walk, 0 for the root.
+   */
+  unsigned int walk_pos;
 
   /**
    * Number of elements in the heap.
@@ -103,33 +124,148 @@ struct GNUNET_CONTAINER_Heap
 };
 
 
+/**
+ * Does a node with cost @a a belong closer to the root
+ * than one with cost @a b?
+ *
+ * @param heap the heap
+ * @param a first cost
+ * @param b second cost
+ * @return true if @a a is strictly before @a b
+ */
+static inline bool
+is_before (const struct GNUNET_CONTAINER_Heap *heap,
+           GNUNET_CONTAINER_HeapCostType a,
+           GNUNET_CONTAINER_HeapCostType b)
+{
+  if (GNUNET_CONTAINER_HEAP_ORDER_MAX == heap->order)
+    return a > b;
+  return a < b;
+}
+
+
 #if EXTRA_CHECKS
 /**
- * Check if internal invariants hold for the given node.
+ * Check if internal invariants hold for the given heap.
  *
- * @param node subtree to check
+ * @param heap heap to check
  */
 static void
-check (const struct GNUNET_CONTAINER_HeapNode *node)
+check (const struct GNUNET_CONTAINER_Heap *heap)
 {
-  if (NULL == node)
-    return;
-  GNUNET_assert (node->tree_size ==
-                 ((node->left_child ==
-                   NULL) ? 0 : 1 + node->left_child->tree_size)
-                 + ((node->right_child ==
-                     NULL) ? 0 : 1 + node->right_child->tree_size));
-  check (node->left_child);
-  check (node->right_child);
+  for (unsigned int i = 0; i < heap->size; i++)
+  {
+    GNUNET_assert (heap->array[i].node->index == i);
+    GNUNET_assert (heap->array[i].node->heap == heap);
+    if (i > 0)
+      GNUNET_assert (! is_before (heap,
+                                  heap->array[i].cost,
+                                  heap->array[(i - 1) / HEAP_ARITY].cost));
+  }
 }
 
 
-#define CHECK(n) check (n)
+#define CHECK(h) check (h)
 #else
-#define CHECK(n) do {} while (0)
+#define CHECK(h) do {} while (0)
 #endif
 
 
+/**
+ * Move the entry at @a pos towards the root until its parent
+ * is not after it.
+ *
+ * @param heap heap to modify
+ * @param pos index of the entry to move
+ */
+static void
+sift_up (struct GNUNET_CONTAINER_Heap *heap,
+         unsigned int pos)
+{
+  struct HeapEntry e = heap->array[pos];
+
+  while (pos > 0)
+  {
+    unsigned int parent = (pos - 1) / HEAP_ARITY;
+
+    if (! is_before (heap,
+                     e.cost,
+                     heap->array[parent].cost))
+      break;
+    heap->array[pos] = heap->array[parent];
+    heap->array[pos].node->index = pos;
+    pos = parent;
+  }
+  heap->array[pos] = e;
+  e.node->index = pos;
+}
+
+
+/**
+ * Move the entry at @a pos towards the leaves until none
+ * of its children is before it.
+ *
+ * @param heap heap to modify
+ * @param pos index of the entry to move
+ */
+static void
+sift_down (struct GNUNET_CONTAINER_Heap *heap,
+           unsigned int pos)
+{
+  struct HeapEntry e = heap->array[pos];
+
+  while (1)
+  {
+    unsigned long long first = (unsigned long long) pos * HEAP_ARITY + 1;
+    unsigned int last;
+    unsigned int best;
+
+    if (first >= heap->size)
+      break;
+    last = (unsigned int) GNUNET_MIN (first + HEAP_ARITY,
+                                      heap->size);
+    best = (unsigned int) first;
+    for (unsigned int c = best + 1; c < last; c++)
+      if (is_before (heap,
+                     heap->array[c].cost,
+                     heap->array[best].cost))
+        best = c;
+    if (! is_before (heap,
+                     heap->array[best].cost,
+                     e.cost))
+      break;
+    heap->array[pos] = heap->array[best];
+    heap->array[pos].node->index = pos;
+    pos = best;
+  }
+  heap->array[pos] = e;
+  e.node->index = pos;
+}
+
+
+/**
+ * Restore the heap property for the entry at @a pos after its
+ * cost changed or it was replaced.
+ *
+ * @param heap heap to modify
+ * @param pos index of the entry
+ */
+static void
+sift (struct GNUNET_CONTAINER_Heap *heap,
+      unsigned int pos)
+{
+  if ( (pos > 0) &&
+       is_before (heap,
+                  heap->array[pos].cost,
+                  heap->array[(pos - 1) / HEAP_ARITY].cost) )
+    sift_up (heap,
+             pos);
+  else
+    sift_down (heap,
+               pos);
+}
+
+
 struct GNUNET_CONTAINER_Heap *
 GNUNET_CONTAINER_heap_create (enum GNUNET_CONTAINER_HeapOrder order)
 {
@@ -145,6 +281,9 @@ void
 GNUNET_CONTAINER_heap_destroy (struct GNUNET_CONTAINER_Heap *heap)
 {
   GNUNET_break (heap->size == 0);
+  GNUNET_array_grow (heap->array,
+                     heap->array_length,
+                     0);
   GNUNET_free (heap);
 }
 
@@ -152,9 +291,9 @@ GNUNET_CONTAINER_heap_destroy (struct GNUNET_CONTAINER_Heap *heap)
 void *
 GNUNET_CONTAINER_heap_peek (const struct GNUNET_CONTAINER_Heap *heap)
 {
-  if (heap->root == NULL)
+  if (0 == heap->size)
     return NULL;
-  return heap->root->element;
+  return heap->array[0].node->element;
 }
 
 
@@ -172,12 +311,12 @@ GNUNET_CONTAINER_heap_peek2 (const struct GNUNET_CONTAINER_Heap *heap,
                              void **element,
                              GNUNET_CONTAINER_HeapCostType *cost)
 {
-  if (NULL == heap->root)
+  if (0 == heap->size)
     return GNUNET_NO;
   if (NULL != element)
-    *element = heap->root->element;
+    *element = heap->array[0].node->element;
   if (NULL != cost)
-    *cost = heap->root->cost;
+    *cost = heap->array[0].cost;
   return GNUNET_YES;
 }
 
@@ -193,33 +332,7 @@ GNUNET_CONTAINER_HeapCostType
 GNUNET_CONTAINER_heap_node_get_cost (const struct GNUNET_CONTAINER_HeapNode
                                      *node)
 {
-  return node->cost;
-}
-
-
-/**
- * Iterate over the children of the given node.
- *
- * @param heap argument to give to iterator
- * @param node node to iterate over
- * @param iterator function to call on each node
- * @param iterator_cls closure for iterator
- * @return GNUNET_YES to continue to iterate
- */
-static int
-node_iterator (const struct GNUNET_CONTAINER_Heap *heap,
-               struct GNUNET_CONTAINER_HeapNode *node,
-               GNUNET_CONTAINER_HeapIterator iterator, void *iterator_cls)
-{
-  if (node == NULL)
-    return GNUNET_YES;
-  if (GNUNET_YES !=
-      node_iterator (heap, node->left_child, iterator, iterator_cls))
-    return GNUNET_NO;
-  if (GNUNET_YES !=
-      node_iterator (heap, node->right_child, iterator, iterator_cls))
-    return GNUNET_NO;
-  return iterator (iterator_cls, node, node->element, node->cost);
+  return node->heap->array[node->index].cost;
 }
 
 
@@ -228,93 +341,43 @@ GNUNET_CONTAINER_heap_iterate (const struct GNUNET_CONTAINER_Heap *heap,
                                GNUNET_CONTAINER_HeapIterator iterator,
                                void *iterator_cls)
 {
-  (void) node_iterator (heap, heap->root, iterator, iterator_cls);
+  for (unsigned int i = 0; i < heap->size; i++)
+  {
+    const struct HeapEntry *e = &heap->array[i];
+
+    if (GNUNET_YES !=
+        iterator (iterator_cls,
+                  e->node,
+                  e->node->element,
+                  e->cost))
+      return;
+  }
 }
 
 
 void *
 GNUNET_CONTAINER_heap_walk_get_next (struct GNUNET_CONTAINER_Heap *heap)
 {
-  struct GNUNET_CONTAINER_HeapNode *pos;
-  void *element;
+  unsigned int pos;
+  unsigned long long next;
 
-  if (heap->root == NULL)
+  if (0 == heap->size)
     return NULL;
   pos = heap->walk_pos;
-  if (pos == NULL)
-    pos = heap->root;
-  element = pos->element;
-  heap->walk_pos =
-    (0 ==
-     GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
-                               2)) ? pos->right_child : pos->left_child;
-  return element;
-}
-
-
-/**
- * Insert the given node 'node' into the subtree starting
- * at 'pos' (while keeping the tree somewhat balanced).
- *
- * @param heap heap to modify
- * @param pos existing tree
- * @param node node to insert (which may be a subtree itself)
- */
-static void
-insert_node (struct GNUNET_CONTAINER_Heap *heap,
-             struct GNUNET_CONTAINER_HeapNode *pos,
-             struct GNUNET_CONTAINER_HeapNode *node)
-{
-  struct GNUNET_CONTAINER_HeapNode *parent;
-
-  GNUNET_assert (node->parent == NULL);
-  while ((heap->order == GNUNET_CONTAINER_HEAP_ORDER_MAX) ? (pos->cost >=
-                                                             node->cost)
-         : (pos->cost <= node->cost))
-  {
-    /* node is descendent of pos */
-    pos->tree_size += (1 + node->tree_size);
-    if (pos->left_child == NULL)
-    {
-      pos->left_child = node;
-      node->parent = pos;
-      return;
-    }
-    if (pos->right_child == NULL)
-    {
-      pos->right_child = node;
-      node->parent = pos;
-      return;
-    }
-    /* keep it balanced by descending into smaller subtree */
-    if (pos->left_child->tree_size < pos->right_child->tree_size)
-      pos = pos->left_child;
-    else
-      pos = pos->right_child;
-  }
-  /* make 'node' parent of 'pos' */
-  parent = pos->parent;
-  pos->parent = NULL;
-  node->parent = parent;
-  if (NULL == parent)
-  {
-    heap->root = node;
-  }
-  else
-  {
-    if (parent->left_child == pos)
-      parent->left_child = node;
-    else
-      parent->right_child = node;
-  }
-  /* insert 'pos' below 'node' */
-  insert_node (heap, node, pos);
-  CHECK (pos);
+  if (pos >= heap->size)
+    pos = 0;
+  next = (unsigned long long) pos * HEAP_ARITY + 1
+         + GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                     HEAP_ARITY);
+  /* start again at the root after a leaf */
+  heap->walk_pos = (next < heap->size) ? (unsigned int) next : 0;
+  return heap->array[pos].node->element;
 }
 
 
 struct GNUNET_CONTAINER_HeapNode *
-GNUNET_CONTAINER_heap_insert (struct GNUNET_CONTAINER_Heap *heap, void *element,
+GNUNET_CONTAINER_heap_insert (struct GNUNET_CONTAINER_Heap *heap,
+                              void *element,
                               GNUNET_CONTAINER_HeapCostType cost)
 {
   struct GNUNET_CONTAINER_HeapNode *node;
@@ -322,131 +385,68 @@ GNUNET_CONTAINER_heap_insert (struct GNUNET_CONTAINER_Heap *heap, void *element,
   node = GNUNET_new (struct GNUNET_CONTAINER_HeapNode);
   node->heap = heap;
   node->element = element;
-  node->cost = cost;
+  if (heap->size == heap->array_length)
+    GNUNET_array_grow (heap->array,
+                       heap->array_length,
+                       GNUNET_MAX (HEAP_MIN_LENGTH,
+                                   2 * heap->array_length));
+  heap->array[heap->size].cost = cost;
+  heap->array[heap->size].node = node;
   heap->size++;
-  if (NULL == heap->root)
-    heap->root = node;
-  else
-    insert_node (heap, heap->root, node);
-  GNUNET_assert (heap->size == heap->root->tree_size + 1);
-  CHECK (heap->root);
+  sift_up (heap,
+           heap->size - 1);
+  CHECK (heap);
   return node;
 }
 
 
 /**
- * Remove root of the heap.
+ * Remove the entry at @a pos from the array of @a heap,
+ * and free its node.
  *
  * @param heap heap to modify
- * @return element data stored at the root node, NULL if heap is empty
+ * @param pos index of the entry to remove
+ * @return element data stored at the node
  */
-void *
-GNUNET_CONTAINER_heap_remove_root (struct GNUNET_CONTAINER_Heap *heap)
+static void *
+remove_at (struct GNUNET_CONTAINER_Heap *heap,
+           unsigned int pos)
 {
-  void *ret;
-  struct GNUNET_CONTAINER_HeapNode *root;
+  struct GNUNET_CONTAINER_HeapNode *node = heap->array[pos].node;
+  void *ret = node->element;
 
-  if (NULL == (root = heap->root))
-    return NULL;
   heap->size--;
-  ret = root->element;
-  if (root->left_child == NULL)
+  if (pos != heap->size)
   {
-    heap->root = root->right_child;
-    if (root->right_child != NULL)
-      root->right_child->parent = NULL;
+    heap->array[pos] = heap->array[heap->size];
+    heap->array[pos].node->index = pos;
+    sift (heap,
+          pos);
   }
-  else if (root->right_child == NULL)
-  {
-    heap->root = root->left_child;
-    root->left_child->parent = NULL;
-  }
-  else
-  {
-    root->left_child->parent = NULL;
-    root->right_child->parent = NULL;
-    heap->root = root->left_child;
-    insert_node (heap, heap->root, root->right_child);
-  }
-  if (heap->walk_pos == root)
-    heap->walk_pos = heap->root;
-  GNUNET_free (root);
-#if EXTRA_CHECKS
-  GNUNET_assert (((heap->size == 0) && (heap->root == NULL)) ||
-                 (heap->size == heap->root->tree_size + 1));
-  CHECK (heap->root);
-#endif
+  if ( (heap->array_length > HEAP_MIN_LENGTH) &&
+       (heap->size < heap->array_length / 4) )
+    GNUNET_array_grow (heap->array,
+                       heap->array_length,
+                       heap->array_length / 2);
+  GNUNET_free (node);
+  CHECK (heap);
   return ret;
 }
 
 
 /**
- * Remove the given node 'node' from the tree and update
- * the 'tree_size' fields accordingly.  Preserves the
- * children of 'node' and does NOT change the overall
- * 'size' field of the tree.
+ * Remove root of the heap.
+ *
+ * @param heap heap to modify
+ * @return element data stored at the root node, NULL if heap is empty
  */
-static void
-remove_node (struct GNUNET_CONTAINER_HeapNode *node)
+void *
+GNUNET_CONTAINER_heap_remove_root (struct GNUNET_CONTAINER_Heap *heap)
 {
-  struct GNUNET_CONTAINER_HeapNode *ancestor;
-  struct GNUNET_CONTAINER_Heap *heap = node->heap;
-
-  /* update 'size' of the ancestors */
-  ancestor = node;
-  while (NULL != (ancestor = ancestor->parent))
-    ancestor->tree_size--;
-
-  /* update 'size' of node itself */
-  if (node->left_child != NULL)
-    node->tree_size -= (1 + node->left_child->tree_size);
-  if (node->right_child != NULL)
-    node->tree_size -= (1 + node->right_child->tree_size);
-
-  /* unlink 'node' itself and insert children in its place */
-  if (node->parent == NULL)
-  {
-    if (node->left_child != NULL)
-    {
-      heap->root = node->left_child;
-      node->left_child->parent = NULL;
-      if (node->right_child != NULL)
-      {
-        node->right_child->parent = NULL;
-        insert_node (heap, heap->root, node->right_child);
-      }
-    }
-    else
-    {
-      heap->root = node->right_child;
-      if (node->right_child != NULL)
-        node->right_child->parent = NULL;
-    }
-  }
-  else
-  {
-    if (node->parent->left_child == node)
-      node->parent->left_child = NULL;
-    else
-      node->parent->right_child = NULL;
-    if (node->left_child != NULL)
-    {
-      node->left_child->parent = NULL;
-      node->parent->tree_size -= (1 + node->left_child->tree_size);
-      insert_node (heap, node->parent, node->left_child);
-    }
-    if (node->right_child != NULL)
-    {
-      node->right_child->parent = NULL;
-      node->parent->tree_size -= (1 + node->right_child->tree_size);
-      insert_node (heap, node->parent, node->right_child);
-    }
-  }
-  node->parent = NULL;
-  node->left_child = NULL;
-  node->right_child = NULL;
-  GNUNET_assert (node->tree_size == 0);
-  CHECK (heap->root);
+  if (0 == heap->size)
+    return NULL;
+  return remove_at (heap,
+                    0);
 }
 
 
@@ -459,25 +459,8 @@ remove_node (struct GNUNET_CONTAINER_HeapNode *node)
 void *
 GNUNET_CONTAINER_heap_remove_node (struct GNUNET_CONTAINER_HeapNode *node)
 {
-  void *ret;
-  struct GNUNET_CONTAINER_Heap *heap;
-
-  heap = node->heap;
-  CHECK (heap->root);
-  if (heap->walk_pos == node)
-    (void) GNUNET_CONTAINER_heap_walk_get_next (heap);
-  remove_node (node);
-  heap->size--;
-  ret = node->element;
-  if (heap->walk_pos == node)
-    heap->walk_pos = NULL;
-  GNUNET_free (node);
-#if EXTRA_CHECKS
-  CHECK (heap->root);
-  GNUNET_assert (((heap->size == 0) && (heap->root == NULL)) ||
-                 (heap->size == heap->root->tree_size + 1));
-#endif
-  return ret;
+  return remove_at (node->heap,
+                    node->index);
 }
 
 
@@ -487,14 +470,10 @@ GNUNET_CONTAINER_heap_update_cost (struct GNUNET_CONTAINER_HeapNode *node,
 {
   struct GNUNET_CONTAINER_Heap *heap = node->heap;
 
-  remove_node (node);
-  node->cost = new_cost;
-  if (NULL == heap->root)
-    heap->root = node;
-  else
-    insert_node (heap,
-                 heap->root,
-                 node);
+  heap->array[node->index].cost = new_cost;
+  sift (heap,
+        node->index);
+  CHECK (heap);
 }
 
 
@@ -28,6 +28,7 @@
 #include "platform.h"
 #include "gnunet_util_lib.h"
 #include <gcrypt.h>
+#include <pthread.h>
 
 #define LOG(kind, ...) GNUNET_log_from (kind, "util-crypto-random", __VA_ARGS__)
 
@@ -35,69 +36,370 @@
   GNUNET_log_from_strerror (kind, "util-crypto-random", syscall)
 
 
-/* TODO: ndurner, move this to plibc? */
-/* The code is derived from glibc, obviously */
-#if ! HAVE_RANDOM || ! HAVE_SRANDOM
-#ifdef RANDOM
-#undef RANDOM
-#endif
-#ifdef SRANDOM
-#undef SRANDOM
-#endif
-#define RANDOM() glibc_weak_rand32 ()
-#define SRANDOM(s) glibc_weak_srand32 (s)
-#if defined(RAND_MAX)
-#undef RAND_MAX
+/**
+ * Size of the key of the ChaCha20 generators.
+ */
+#define RNG_KEY_SIZE crypto_stream_chacha20_KEYBYTES
+
+/**
+ * How much key stream do we generate at once?  The first
+ * #RNG_KEY_SIZE bytes of it replace the key, so that output
+ * that was handed out cannot be reconstructed from the state.
+ */
+#define RNG_BUFFER_SIZE 1024
+
+/**
+ * After how many bytes of output do we mix fresh entropy from
+ * the operating system into the key?
+ */
+#define RNG_RESEED_INTERVAL (1024 * 1024)
+
+
+/**
+ * State of a ChaCha20-based generator.  The generators are per
+ * thread, so they need no locking, unless the compiler lacks
+ * thread-local storage (see #rng_lock).
+ */
+struct RandomState
+{
+  /**
+   * Key stream not yet handed out is at the end of the buffer,
+   * everything before it has been zeroed.
+   */
+  unsigned char buf[RNG_BUFFER_SIZE];
+
+  /**
+   * Key for the next key stream.
+   */
+  unsigned char key[RNG_KEY_SIZE];
+
+  /**
+   * Number of bytes left at the end of @e buf.
+   */
+  size_t avail;
+
+  /**
+   * Number of bytes generated since the last reseed.
+   */
+  uint64_t since_reseed;
+
+  /**
+   * Value of #fork_generation when we were last seeded.
+   */
+  unsigned int generation;
+
+  /**
+   * Were we seeded from the operating system (or the caller)?
+   */
+  bool seeded;
+
+  /**
+   * Were we seeded by #GNUNET_CRYPTO_seed_weak_random()?  Then we
+   * must never reseed, as the caller wants a reproducible sequence.
+   */
+  bool fixed;
+};
+
+
+/**
+ * Generator for #GNUNET_CRYPTO_QUALITY_NONCE.
+ */
+static GNUNET_THREAD_LOCAL struct RandomState nonce_rng;
+
+/**
+ * Generator for #GNUNET_CRYPTO_QUALITY_WEAK.
+ */
+static GNUNET_THREAD_LOCAL struct RandomState weak_rng;
+
+/**
+ * Incremented in the child after a fork(), so that parent and child
+ * do not produce the same numbers.
+ */
+static volatile unsigned int fork_generation;
+
+#if HAVE_THREAD_LOCAL_GCC
+#define RNG_LOCK() do {} while (0)
+#define RNG_UNLOCK() do {} while (0)
+#else
+/**
+ * Without thread-local storage, all threads share #nonce_rng and
+ * #weak_rng, so we must serialize access to them.
+ */
+static pthread_mutex_t rng_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define RNG_LOCK() GNUNET_assert (0 == pthread_mutex_lock (&rng_lock))
+#define RNG_UNLOCK() GNUNET_assert (0 == pthread_mutex_unlock (&rng_lock))
 #endif
-#define RAND_MAX 0x7fffffff /* Hopefully this is correct */
 
 
-static int32_t glibc_weak_rand32_state = 1;
+/**
+ * Called in the parent process before fork(), so that no other
+ * thread holds #rng_lock in the child.
+ */
+static void
+rng_atfork_prepare (void)
+{
+  RNG_LOCK ();
+}
 
 
-void
-glibc_weak_srand32 (int32_t s)
+/**
+ * Called in the parent process after fork().
+ */
+static void
+rng_atfork_parent (void)
 {
-  glibc_weak_rand32_state = s;
+  RNG_UNLOCK ();
 }
 
 
-int32_t
-glibc_weak_rand32 ()
+/**
+ * Called in the child process after fork().
+ */
+static void
+rng_atfork_child (void)
 {
-  int32_t val = glibc_weak_rand32_state;
+  fork_generation++;
+  RNG_UNLOCK ();
+}
 
-  val = ((glibc_weak_rand32_state * 1103515245) + 12345) & 0x7fffffff;
-  glibc_weak_rand32_state = val;
-  return val;
+
+/**
+ * Mix entropy from the operating system into the key of @a rs.
+ *
+ * @param[in,out] rs generator to reseed
+ */
+static void
+rng_reseed (struct RandomState *rs)
+{
+  unsigned char seed[RNG_KEY_SIZE];
+
+  randombytes_buf (seed,
+                   sizeof (seed));
+  for (unsigned int i = 0; i < RNG_KEY_SIZE; i++)
+    rs->key[i] ^= seed[i];
+  GNUNET_CRYPTO_zero_keys (seed,
+                           sizeof (seed));
+  rs->generation = fork_generation;
+  rs->since_reseed = 0;
+  rs->seeded = true;
 }
 
 
-#endif
+/**
+ * Generate the next block of key stream of @a rs, replacing its key.
+ *
+ * @param[in,out] rs generator to refill
+ */
+static void
+rng_refill (struct RandomState *rs)
+{
+  static const unsigned char nonce[crypto_stream_chacha20_NONCEBYTES];
+
+  if ( (! rs->fixed) &&
+       ( (! rs->seeded) ||
+         (rs->since_reseed >= RNG_RESEED_INTERVAL) ) )
+    rng_reseed (rs);
+  crypto_stream_chacha20 (rs->buf,
+                          sizeof (rs->buf),
+                          nonce,
+                          rs->key);
+  memcpy (rs->key,
+          rs->buf,
+          RNG_KEY_SIZE);
+  GNUNET_CRYPTO_zero_keys (rs->buf,
+                           RNG_KEY_SIZE);
+  rs->avail = sizeof (rs->buf) - RNG_KEY_SIZE;
+  rs->since_reseed += sizeof (rs->buf);
+}
+
 
 /**
- * Create a cryptographically weak pseudo-random number in the interval of 0 to 1.
+ * Fill @a buffer with the output of @a rs.
  *
- * @return number between 0 and 1.
+ * @param[in,out] rs generator to use
+ * @param[out] buffer where to write the output
+ * @param length number of bytes to write
  */
-static double
-get_weak_random (void)
+static void
+rng_read (struct RandomState *rs,
+          void *buffer,
+          size_t length)
 {
-  return(random () / (double) RAND_MAX);
+  /* use a different nonce than rng_refill() for bulk output */
+  static const unsigned char bulk_nonce[crypto_stream_chacha20_NONCEBYTES] =
+  { 1 };
+  unsigned char *dst = buffer;
+
+  if ( (! rs->fixed) &&
+       (rs->generation != fork_generation) )
+  {
+    /* we were forked, the parent may hand out the same bytes */
+    GNUNET_CRYPTO_zero_keys (rs->buf,
+                             sizeof (rs->buf));
+    rs->avail = 0;
+    rs->seeded = false;
+  }
+  if (length >= RNG_BUFFER_SIZE)
+  {
+    unsigned char bulk_key[RNG_KEY_SIZE];
+
+    /* one-time key from our output, so that the state we keep
+       cannot reproduce this output */
+    rng_read (rs,
+              bulk_key,
+              sizeof (bulk_key));
+    crypto_stream_chacha20 (dst,
+                            length,
+                            bulk_nonce,
+                            bulk_key);
+    GNUNET_CRYPTO_zero_keys (bulk_key,
+                             sizeof (bulk_key));
+    rs->since_reseed += length;
+    return;
+  }
+  while (length > 0)
+  {
+    unsigned char *src;
+    size_t n;
+
+    if (0 == rs->avail)
+      rng_refill (rs);
+    n = GNUNET_MIN (length,
+                    rs->avail);
+    src = &rs->buf[sizeof (rs->buf) - rs->avail];
+    memcpy (dst,
+            src,
+            n);
+    memset (src,
+            0,
+            n);
+    rs->avail -= n;
+    dst += n;
+    length -= n;
+  }
 }
 
 
-void
-GNUNET_CRYPTO_seed_weak_random (int32_t seed)
+/**
+ * Get the generator for @a mode.
+ *
+ * @param mode #GNUNET_CRYPTO_QUALITY_WEAK or #GNUNET_CRYPTO_QUALITY_NONCE
+ * @return the generator of the calling thread
+ */
+static struct RandomState *
+rng_get (enum GNUNET_CRYPTO_Quality mode)
+{
+  if (GNUNET_CRYPTO_QUALITY_WEAK == mode)
+    return &weak_rng;
+  return &nonce_rng;
+}
+
+
+/**
+ * Produce an unbiased number in [0,i[ from @a rs.  Uses the
+ * multiply-and-shift method by Lemire, which only needs a division
+ * if the first number drawn might have to be rejected.
+ *
+ * @param[in,out] rs generator to use
+ * @param i the upper limit (exclusive)
+ * @return a random value in the interval [0,i[
+ */
+static uint32_t
+rng_u32 (struct RandomState *rs,
+         uint32_t i)
 {
-#ifdef OPENBSD
-  srandom_deterministic (seed);
+  uint32_t x;
+  uint64_t m;
+
+  rng_read (rs,
+            &x,
+            sizeof (x));
+  m = (uint64_t) x * i;
+  if ((uint32_t) m < i)
+  {
+    uint32_t t = (-i) % i;
+
+    while ((uint32_t) m < t)
+    {
+      rng_read (rs,
+                &x,
+                sizeof (x));
+      m = (uint64_t) x * i;
+    }
+  }
+  return (uint32_t) (m >> 32);
+}
+
+
+/**
+ * Produce an unbiased number in [0,max[ from @a rs.
+ *
+ * @param[in,out] rs generator to use
+ * @param max the upper limit (exclusive)
+ * @return a random value in the interval [0,max[
+ */
+static uint64_t
+rng_u64 (struct RandomState *rs,
+         uint64_t max)
+{
+  uint64_t x;
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 m;
+
+  rng_read (rs,
+            &x,
+            sizeof (x));
+  m = (unsigned __int128) x * max;
+  if ((uint64_t) m < max)
+  {
+    uint64_t t = (-max) % max;
+
+    while ((uint64_t) m < t)
+    {
+      rng_read (rs,
+                &x,
+                sizeof (x));
+      m = (unsigned __int128) x * max;
+    }
+  }
+  return (uint64_t) (m >> 64);
 #else
-  srandom (seed);
+  uint64_t ul = UINT64_MAX - (UINT64_MAX % max);
+
+  do
+  {
+    rng_read (rs,
+              &x,
+              sizeof (x));
+  }
+  while (x >= ul);
+  return x % max;
 #endif
 }
 
 
+/**
+ * Seed the #GNUNET_CRYPTO_QUALITY_WEAK generator of the calling
+ * thread, making its output reproducible.
+ *
+ * @param seed the seed to use
+ */
+void
+GNUNET_CRYPTO_seed_weak_random (int32_t seed)
+{
+  RNG_LOCK ();
+  GNUNET_CRYPTO_zero_keys (&weak_rng,
+                           sizeof (weak_rng));
+  memcpy (weak_rng.key,
+          &seed,
+          sizeof (seed));
+  weak_rng.seeded = true;
+  weak_rng.fixed = true;
+  RNG_UNLOCK ();
+}
+
+
 /**
  * @ingroup crypto
  * Zero out @a buffer, securely against compiler optimizations.
@@ -149,16 +451,12 @@ GNUNET_CRYPTO_random_block (enum GNUNET_CRYPTO_Quality mode,
     return;
 
   case GNUNET_CRYPTO_QUALITY_NONCE:
-    gcry_create_nonce (buffer, length);
-    return;
-
   case GNUNET_CRYPTO_QUALITY_WEAK:
-    /* see http://lists.gnupg.org/pipermail/gcrypt-devel/2004-May/000613.html */
-#ifdef gcry_fast_random_poll
-    if ((invokeCount++ % 256) == 0)
-      gcry_fast_random_poll ();
-#endif
-    gcry_randomize (buffer, length, GCRY_WEAK_RANDOM);
+    RNG_LOCK ();
+    rng_read (rng_get (mode),
+              buffer,
+              length);
+    RNG_UNLOCK ();
     return;
 
   default:
@@ -205,18 +503,11 @@ GNUNET_CRYPTO_random_u32 (enum GNUNET_CRYPTO_Quality mode,
     return ret % i;
 
   case GNUNET_CRYPTO_QUALITY_NONCE:
-    ul = UINT32_MAX - (UINT32_MAX % i);
-    do
-    {
-      gcry_create_nonce (&ret, sizeof(ret));
-    }
-    while (ret >= ul);
-    return ret % i;
-
   case GNUNET_CRYPTO_QUALITY_WEAK:
-    ret = i * get_weak_random ();
-    if (ret >= i)
-      ret = i - 1;
+    RNG_LOCK ();
+    ret = rng_u32 (rng_get (mode),
+                   i);
+    RNG_UNLOCK ();
     return ret;
 
   default:
@@ -280,19 +571,11 @@ GNUNET_CRYPTO_random_u64 (enum GNUNET_CRYPTO_Quality mode,
     return ret % max;
 
   case GNUNET_CRYPTO_QUALITY_NONCE:
-    ul = UINT64_MAX - (UINT64_MAX % max);
-    do
-    {
-      gcry_create_nonce (&ret, sizeof(ret));
-    }
-    while (ret >= ul);
-
-    return ret % max;
-
   case GNUNET_CRYPTO_QUALITY_WEAK:
-    ret = max * get_weak_random ();
-    if (ret >= max)
-      ret = max - 1;
+    RNG_LOCK ();
+    ret = rng_u64 (rng_get (mode),
+                   max);
+    RNG_UNLOCK ();
     return ret;
 
   default:
@@ -392,9 +675,9 @@ GNUNET_CRYPTO_random_init ()
              gcry_strerror (rc));
   gcry_control (GCRYCTL_INITIALIZATION_FINISHED, 0);
   gcry_fast_random_poll ();
-  GNUNET_CRYPTO_seed_weak_random (
-    time (NULL)
-    ^ GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_NONCE, UINT32_MAX));
+  (void) pthread_atfork (&rng_atfork_prepare,
+                         &rng_atfork_parent,
+                         &rng_atfork_child);
 }
 
 void
@@ -292,11 +292,15 @@ static void
 helper_read (void *cls)
 {
   struct GNUNET_HELPER_Handle *h = cls;
-  char buf[GNUNET_MAX_MESSAGE_SIZE] GNUNET_ALIGN;
+  void *buf;
+  size_t left;
   ssize_t t;
 
   h->read_task = NULL;
-  t = GNUNET_DISK_file_read (h->fh_from_helper, &buf, sizeof(buf));
+  /* read directly into the tokenizer, avoiding a copy */
+  buf = GNUNET_MST_receive_buffer (h->mst,
+                                   &left);
+  t = GNUNET_DISK_file_read (h->fh_from_helper, buf, left);
   if (t < 0)
   {
     /* On read-error, restart the helper */
@@ -350,7 +354,7 @@ helper_read (void *cls)
                                                  &helper_read,
                                                  h);
   if (GNUNET_SYSERR ==
-      GNUNET_MST_from_buffer (h->mst, buf, t, GNUNET_NO, GNUNET_NO))
+      GNUNET_MST_receive_commit (h->mst, t, GNUNET_NO, GNUNET_NO))
   {
     GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
                 _ ("Failed to parse inbound message from helper `%s'\n"),
@@ -37,6 +37,12 @@
 
 #define LOG(kind, ...) GNUNET_log_from (kind, "util-mst", __VA_ARGS__)
 
+/**
+ * Minimum amount of free space we offer to callers that read
+ * directly into our buffer.
+ */
+#define MST_READ_SIZE 4096
+
 
 /**
  * Handle to a message stream tokenizer.
@@ -72,6 +78,17 @@ struct GNUNET_MessageStreamTokenizer
    * Beginning of the buffer.  Typed like this to force alignment.
    */
   struct GNUNET_MessageHeader *hdr;
+
+  /**
+   * Aligned buffer for delivering single complete messages that
+   * sit at an unaligned offset in @e hdr, NULL until needed.
+   */
+  struct GNUNET_MessageHeader *scratch;
+
+  /**
+   * Size of @e scratch.
+   */
+  size_t scratch_size;
 };
 
 
@@ -97,6 +114,64 @@ GNUNET_MST_create (GNUNET_MessageTokenizerCallback cb,
 }
 
 
+/**
+ * Grow the buffer of @a mst to at least @a size bytes.  Grows
+ * geometrically so that a stream of increasing message sizes does
+ * not cause a reallocation per message.
+ *
+ * @param mst tokenizer to grow
+ * @param size minimum buffer size required
+ */
+static void
+grow_buffer (struct GNUNET_MessageStreamTokenizer *mst,
+             size_t size)
+{
+  size_t nsize;
+
+  if (mst->curr_buf >= size)
+    return;
+  nsize = GNUNET_MAX (size,
+                      GNUNET_MIN (2 * mst->curr_buf,
+                                  GNUNET_MAX_MESSAGE_SIZE));
+  mst->hdr = GNUNET_realloc (mst->hdr,
+                             nsize);
+  mst->curr_buf = nsize;
+}
+
+
+/**
+ * Deliver a complete message that starts at the unaligned offset
+ * @a off in the buffer of @a mst by copying just this message into
+ * the aligned scratch buffer.  This is cheaper than moving all
+ * remaining buffered data, which would be repeated for every message
+ * if the message sizes are not multiples of the alignment.
+ *
+ * @param mst tokenizer to use
+ * @param msg message to deliver
+ * @param want size of @a msg
+ * @return result of the callback
+ */
+static int
+deliver_unaligned (struct GNUNET_MessageStreamTokenizer *mst,
+                   const char *msg,
+                   uint16_t want)
+{
+  if (mst->scratch_size < want)
+  {
+    GNUNET_free (mst->scratch);
+    mst->scratch_size = GNUNET_MAX (want,
+                                    GNUNET_MIN (2 * mst->scratch_size,
+                                                GNUNET_MAX_MESSAGE_SIZE));
+    mst->scratch = GNUNET_malloc (mst->scratch_size);
+  }
+  GNUNET_memcpy (mst->scratch,
+                 msg,
+                 want);
+  return mst->cb (mst->cb_cls,
+                  mst->scratch);
+}
+
+
 enum GNUNET_GenericReturnValue
 GNUNET_MST_from_buffer (struct GNUNET_MessageStreamTokenizer *mst,
                         const char *buf,
@@ -125,6 +200,47 @@ GNUNET_MST_from_buffer (struct GNUNET_MessageStreamTokenizer *mst,
   {
 do_align:
     GNUNET_assert (mst->pos >= mst->off);
+    if ((0 != (mst->off % ALIGN_FACTOR)) &&
+        (mst->pos - mst->off >= sizeof(struct GNUNET_MessageHeader)))
+    {
+      struct GNUNET_MessageHeader uh;
+
+      /* complete message at unaligned offset? deliver it from scratch */
+      GNUNET_memcpy (&uh,
+                     &ibuf[mst->off],
+                     sizeof(uh));
+      want = ntohs (uh.size);
+      if ((want >= sizeof(struct GNUNET_MessageHeader)) &&
+          (mst->pos - mst->off >= want))
+      {
+        if (one_shot == GNUNET_SYSERR)
+        {
+          ret = GNUNET_NO;
+          goto copy;
+        }
+        if (one_shot == GNUNET_YES)
+          one_shot = GNUNET_SYSERR;
+        mst->off += want;
+        if (GNUNET_OK !=
+            (cbret = deliver_unaligned (mst,
+                                        &ibuf[mst->off - want],
+                                        want)))
+        {
+          if (GNUNET_SYSERR == cbret)
+            GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
+                        "Failure processing message of type %u and size %u\n",
+                        ntohs (uh.type),
+                        want);
+          return GNUNET_SYSERR;
+        }
+        if (mst->off == mst->pos)
+        {
+          mst->off = 0;
+          mst->pos = 0;
+        }
+        continue;
+      }
+    }
     if ((mst->curr_buf - mst->off < sizeof(struct GNUNET_MessageHeader)) ||
         (0 != (mst->off % ALIGN_FACTOR)))
     {
@@ -181,10 +297,9 @@ do_align:
     {
       /* need to get more space by growing buffer */
       GNUNET_assert (0 == mst->off);
-      mst->hdr = GNUNET_realloc (mst->hdr,
-                                 want);
+      grow_buffer (mst,
+                   want);
       ibuf = (char *) mst->hdr;
-      mst->curr_buf = want;
     }
     hdr = (const struct GNUNET_MessageHeader *) &ibuf[mst->off];
     if (mst->pos - mst->off < want)
@@ -295,10 +410,9 @@ copy:
   {
     if (size + mst->pos > mst->curr_buf)
     {
-      mst->hdr = GNUNET_realloc (mst->hdr,
-                                 size + mst->pos);
+      grow_buffer (mst,
+                   size + mst->pos);
       ibuf = (char *) mst->hdr;
-      mst->curr_buf = size + mst->pos;
     }
     GNUNET_assert (size + mst->pos <= mst->curr_buf);
     GNUNET_memcpy (&ibuf[mst->pos],
@@ -342,12 +456,12 @@ GNUNET_MST_read (struct GNUNET_MessageStreamTokenizer *mst,
 {
   ssize_t ret;
   size_t left;
-  char *buf;
+  void *buf;
 
-  left = mst->curr_buf - mst->pos;
-  buf = (char *) mst->hdr;
+  buf = GNUNET_MST_receive_buffer (mst,
+                                   &left);
   ret = GNUNET_NETWORK_socket_recv (sock,
-                                    &buf[mst->pos],
+                                    buf,
                                     left);
   if (-1 == ret)
   {
@@ -363,7 +477,56 @@ GNUNET_MST_read (struct GNUNET_MessageStreamTokenizer *mst,
     /* other side closed connection, treat as error */
     return GNUNET_SYSERR;
   }
-  mst->pos += ret;
+  return GNUNET_MST_receive_commit (mst,
+                                    ret,
+                                    purge,
+                                    one_shot);
+}
+
+
+void *
+GNUNET_MST_receive_buffer (struct GNUNET_MessageStreamTokenizer *mst,
+                           size_t *size)
+{
+  char *ibuf;
+
+  GNUNET_assert (mst->off <= mst->pos);
+  if (mst->off == mst->pos)
+  {
+    /* buffer is empty, start from the beginning */
+    mst->off = 0;
+    mst->pos = 0;
+  }
+  ibuf = (char *) mst->hdr;
+  if ((mst->curr_buf - mst->pos < MST_READ_SIZE) &&
+      (mst->off > 0))
+  {
+    /* only a fragment is left before @e pos, move it to the front */
+    mst->pos -= mst->off;
+    memmove (ibuf,
+             &ibuf[mst->off],
+             mst->pos);
+    mst->off = 0;
+  }
+  if (mst->curr_buf - mst->pos < MST_READ_SIZE)
+  {
+    grow_buffer (mst,
+                 mst->pos + MST_READ_SIZE);
+    ibuf = (char *) mst->hdr;
+  }
+  *size = mst->curr_buf - mst->pos;
+  return &ibuf[mst->pos];
+}
+
+
+enum GNUNET_GenericReturnValue
+GNUNET_MST_receive_commit (struct GNUNET_MessageStreamTokenizer *mst,
+                           size_t size,
+                           int purge,
+                           int one_shot)
+{
+  GNUNET_assert (mst->pos + size <= mst->curr_buf);
+  mst->pos += size;
   return GNUNET_MST_from_buffer (mst,
                                  NULL,
                                  0,
@@ -404,6 +567,7 @@ void
 GNUNET_MST_destroy (struct GNUNET_MessageStreamTokenizer *mst)
 {
   GNUNET_free (mst->hdr);
+  GNUNET_free (mst->scratch);
   GNUNET_free (mst);
 }
 
@@ -27,7 +27,8 @@
 #include "gnunet_util_lib.h"
 
 /**
- * How frequently do we scan the interfaces for changes to the addresses?
+ * How frequently do we scan the interfaces for changes to the addresses
+ * if we are not notified about changes?
  */
 #define INTERFACE_PROCESSING_INTERVAL GNUNET_TIME_relative_multiply ( \
           GNUNET_TIME_UNIT_MINUTES, 2)
@@ -71,29 +72,23 @@ GNUNET_NT_to_string (enum GNUNET_NetworkType net)
 struct NT_Network
 {
   /**
-   * Kept in a DLL.
+   * Network address, masked to @e prefix_len bits.
    */
-  struct NT_Network *next;
-
-  /**
-   * Kept in a DLL.
-   */
-  struct NT_Network *prev;
-
-  /**
-   * Network address.
-   */
-  struct sockaddr *network;
+  union
+  {
+    struct in_addr v4;
+    struct in6_addr v6;
+  } network;
 
   /**
-   * Netmask to determine what is in the LAN.
+   * Address family of @e network.
    */
-  struct sockaddr *netmask;
+  sa_family_t af;
 
   /**
-   * How long are @e network and @e netmask?
+   * Length of the network prefix in bits.
    */
-  socklen_t length;
+  unsigned int prefix_len;
 };
 
 
@@ -103,197 +98,392 @@ struct NT_Network
 struct GNUNET_NT_InterfaceScanner
 {
   /**
-   * Head of LAN networks list.
+   * Our LAN networks, indexed by the hash of their family, prefix
+   * and prefix length, see #network_key().  There may be several
+   * entries for the same network if several addresses are in it.
+   */
+  struct GNUNET_CONTAINER_MultiHashMap32 *nets;
+
+  /**
+   * Monitor telling us about changes of the interfaces.
    */
-  struct NT_Network *net_head;
+  struct GNUNET_OS_NetworkInterfaceMonitor *mon;
 
   /**
-   * Tail of LAN networks list.
+   * Number of IPv4 networks in @e nets for each prefix length.
    */
-  struct NT_Network *net_tail;
+  unsigned int v4_prefix_cnt[33];
 
   /**
-   * Task for periodically refreshing our LAN network list.
+   * Number of IPv6 networks in @e nets for each prefix length.
    */
-  struct GNUNET_SCHEDULER_Task *interface_task;
+  unsigned int v6_prefix_cnt[129];
 };
 
 
 /**
- * Delete all entries from the current network list.
+ * Mask @a addr to its first @a prefix_len bits.
  *
- * @param is scanner to clean up
+ * @param af address family, AF_INET or AF_INET6
+ * @param addr address to mask, a `struct in_addr` or `struct in6_addr`
+ * @param prefix_len number of bits to keep
+ * @param[out] net set to the masked address
  */
 static void
-delete_networks (struct GNUNET_NT_InterfaceScanner *is)
+mask_address (sa_family_t af,
+              const void *addr,
+              unsigned int prefix_len,
+              struct NT_Network *net)
+{
+  memset (net,
+          0,
+          sizeof (*net));
+  net->af = af;
+  net->prefix_len = prefix_len;
+  if (AF_INET == af)
+  {
+    uint32_t a;
+
+    memcpy (&a,
+            addr,
+            sizeof (a));
+    if (0 != prefix_len)
+      net->network.v4.s_addr
+        = a & htonl (UINT32_MAX << (32 - prefix_len));
+    return;
+  }
+  {
+    const uint8_t *a = addr;
+    uint8_t *n = net->network.v6.s6_addr;
+
+    memcpy (n,
+            a,
+            prefix_len / 8);
+    if (0 != prefix_len % 8)
+      n[prefix_len / 8] = a[prefix_len / 8]
+                          & (uint8_t) (0xFF << (8 - prefix_len % 8));
+  }
+}
+
+
+/**
+ * Compute the key of @a net in the index.
+ *
+ * @param net network to compute the key for
+ * @return key for the #GNUNET_NT_InterfaceScanner.nets map
+ */
+static uint32_t
+network_key (const struct NT_Network *net)
+{
+  uint32_t w[4];
+  uint32_t key = net->prefix_len;
+
+  if (AF_INET == net->af)
+    return (ntohl (net->network.v4.s_addr) * 0x9E3779B1U) ^ key;
+  memcpy (w,
+          &net->network.v6,
+          sizeof (w));
+  for (unsigned int i = 0; i < 4; i++)
+    key = (key ^ w[i]) * 0x9E3779B1U;
+  return key;
+}
+
+
+/**
+ * Compute the prefix length of a netmask, counting the leading one
+ * bits.
+ *
+ * @param mask the netmask
+ * @param len number of bytes in @a mask
+ * @return the prefix length
+ */
+static unsigned int
+prefix_length (const uint8_t *mask,
+               size_t len)
 {
-  struct NT_Network *cur;
+  unsigned int bits = 0;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    uint8_t b = mask[i];
+
+    if (0xFF == b)
+    {
+      bits += 8;
+      continue;
+    }
+    while (0 != (b & 0x80))
+    {
+      bits++;
+      b <<= 1;
+    }
+    break;
+  }
+  return bits;
+}
+
 
-  while (NULL != (cur = is->net_head))
+/**
+ * Compute the network of an interface.
+ *
+ * @param addr address of the interface
+ * @param netmask netmask of the interface, can be NULL
+ * @param[out] net set to the network
+ * @return #GNUNET_OK on success, #GNUNET_NO if the address
+ *         is to be ignored
+ */
+static enum GNUNET_GenericReturnValue
+interface_network (const struct sockaddr *addr,
+                   const struct sockaddr *netmask,
+                   struct NT_Network *net)
+{
+  if (NULL == netmask)
+    return GNUNET_NO;
+  switch (addr->sa_family)
   {
-    GNUNET_CONTAINER_DLL_remove (is->net_head,
-                                 is->net_tail,
-                                 cur);
-    GNUNET_free (cur);
+  case AF_INET:
+    {
+      const struct sockaddr_in *a4 = (const struct sockaddr_in *) addr;
+      const struct sockaddr_in *m4 = (const struct sockaddr_in *) netmask;
+
+      /* Skipping IPv4 loopback addresses since we have special check  */
+      if ((a4->sin_addr.s_addr & htonl (0xff000000)) == htonl (0x7f000000))
+        return GNUNET_NO;
+      mask_address (AF_INET,
+                    &a4->sin_addr,
+                    prefix_length ((const uint8_t *) &m4->sin_addr,
+                                   sizeof (m4->sin_addr)),
+                    net);
+      return GNUNET_OK;
+    }
+
+  case AF_INET6:
+    {
+      const struct sockaddr_in6 *a6 = (const struct sockaddr_in6 *) addr;
+      const struct sockaddr_in6 *m6 = (const struct sockaddr_in6 *) netmask;
+
+      /* Skipping IPv6 loopback addresses since we have special check  */
+      if (IN6_IS_ADDR_LOOPBACK (&a6->sin6_addr))
+        return GNUNET_NO;
+      mask_address (AF_INET6,
+                    &a6->sin6_addr,
+                    prefix_length (m6->sin6_addr.s6_addr,
+                                   sizeof (m6->sin6_addr)),
+                    net);
+      return GNUNET_OK;
+    }
+
+  default:
+    /* odd / unsupported address family */
+    return GNUNET_NO;
   }
 }
 
 
 /**
- * Function invoked for each interface found.  Adds the interface's
- * network addresses to the respective DLL, so we can distinguish
- * between LAN and WAN.
+ * Closure for #match_network().
+ */
+struct MatchContext
+{
+  /**
+   * Network we are looking for.
+   */
+  const struct NT_Network *net;
+
+  /**
+   * Matching entry, NULL if none was found.
+   */
+  struct NT_Network *found;
+};
+
+
+/**
+ * Check if @a value is the network we are looking for.
+ *
+ * @param cls a `struct MatchContext`
+ * @param key unused
+ * @param value a `struct NT_Network`
+ * @return #GNUNET_NO if we found a match
+ */
+static enum GNUNET_GenericReturnValue
+match_network (void *cls,
+               uint32_t key,
+               void *value)
+{
+  struct MatchContext *mc = cls;
+  struct NT_Network *net = value;
+
+  (void) key;
+  if ( (net->af != mc->net->af) ||
+       (net->prefix_len != mc->net->prefix_len) ||
+       (0 != memcmp (&net->network,
+                     &mc->net->network,
+                     sizeof (net->network))) )
+    return GNUNET_YES;
+  mc->found = net;
+  return GNUNET_NO;
+}
+
+
+/**
+ * Find an entry for @a net in the index.
+ *
+ * @param is the scanner
+ * @param net network to look up
+ * @return the entry, NULL if @a net is not one of our networks
+ */
+static struct NT_Network *
+find_network (struct GNUNET_NT_InterfaceScanner *is,
+              const struct NT_Network *net)
+{
+  struct MatchContext mc = {
+    .net = net
+  };
+
+  GNUNET_CONTAINER_multihashmap32_get_multiple (is->nets,
+                                                network_key (net),
+                                                &match_network,
+                                                &mc);
+  return mc.found;
+}
+
+
+/**
+ * Get the counter of networks with the prefix length of @a net.
+ *
+ * @param is the scanner
+ * @param net the network
+ * @return the counter
+ */
+static unsigned int *
+prefix_cnt (struct GNUNET_NT_InterfaceScanner *is,
+            const struct NT_Network *net)
+{
+  if (AF_INET == net->af)
+    return &is->v4_prefix_cnt[net->prefix_len];
+  return &is->v6_prefix_cnt[net->prefix_len];
+}
+
+
+/**
+ * Function invoked for each change of our interfaces.  Adds or
+ * removes the interface's network to our index, so we can
+ * distinguish between LAN and WAN.
  *
  * @param cls closure with the `struct GNUNET_NT_InterfaceScanner`
+ * @param change what happened
  * @param name name of the interface (can be NULL for unknown)
  * @param isDefault is this presumably the default interface
- * @param addr address of this interface (can be NULL for unknown or unassigned)
+ * @param addr address of this interface
  * @param broadcast_addr the broadcast address (can be NULL for unknown or unassigned)
  * @param netmask the network mask (can be NULL for unknown or unassigned)
  * @param addrlen length of the address
- * @return #GNUNET_OK to continue iteration
  */
-static int
-interface_proc (void *cls,
-                const char *name,
-                int isDefault,
-                const struct sockaddr *addr,
-                const struct sockaddr *broadcast_addr,
-                const struct sockaddr *netmask,
-                socklen_t addrlen)
+static void
+interface_change_cb (void *cls,
+                     enum GNUNET_OS_NetworkInterfaceChange change,
+                     const char *name,
+                     int isDefault,
+                     const struct sockaddr *addr,
+                     const struct sockaddr *broadcast_addr,
+                     const struct sockaddr *netmask,
+                     socklen_t addrlen)
 {
   struct GNUNET_NT_InterfaceScanner *is = cls;
-  /* Calculate network */
-  struct NT_Network *net = NULL;
+  struct NT_Network tmp;
+  struct NT_Network *net;
 
   (void) name;
   (void) isDefault;
   (void) broadcast_addr;
-
-  /* Skipping IPv4 loopback addresses since we have special check  */
-  if (addr->sa_family == AF_INET)
-  {
-    const struct sockaddr_in *a4 = (const struct sockaddr_in *) addr;
-
-    if ((a4->sin_addr.s_addr & htonl (0xff000000)) == htonl (0x7f000000))
-      return GNUNET_OK;
-  }
-  /* Skipping IPv6 loopback addresses since we have special check  */
-  if (addr->sa_family == AF_INET6)
+  (void) addrlen;
+  if (GNUNET_OS_NIC_SYNCED == change)
+    return;
+  if (GNUNET_OK !=
+      interface_network (addr,
+                         netmask,
+                         &tmp))
+    return;
+  if (GNUNET_OS_NIC_REMOVED == change)
   {
-    const struct sockaddr_in6 *a6 = (const struct sockaddr_in6 *) addr;
-    if (IN6_IS_ADDR_LOOPBACK (&a6->sin6_addr))
-      return GNUNET_OK;
-  }
-
-  if (addr->sa_family == AF_INET)
-  {
-    const struct sockaddr_in *addr4 = (const struct sockaddr_in *) addr;
-    const struct sockaddr_in *netmask4 = (const struct sockaddr_in *) netmask;
-    struct sockaddr_in *tmp;
-    struct sockaddr_in network4;
-
-    net = GNUNET_malloc (sizeof(struct NT_Network) + 2 * sizeof(struct
-                                                                sockaddr_in));
-    tmp = (struct sockaddr_in *) &net[1];
-    net->network = (struct sockaddr *) &tmp[0];
-    net->netmask = (struct sockaddr *) &tmp[1];
-    net->length = addrlen;
-
-    memset (&network4,
-            0,
-            sizeof(network4));
-    network4.sin_family = AF_INET;
-#if HAVE_SOCKADDR_IN_SIN_LEN
-    network4.sin_len = sizeof(network4);
-#endif
-    network4.sin_addr.s_addr = (addr4->sin_addr.s_addr
-                                & netmask4->sin_addr.s_addr);
-
-    GNUNET_memcpy (net->netmask,
-                   netmask4,
-                   sizeof(struct sockaddr_in));
-    GNUNET_memcpy (net->network,
-                   &network4,
-                   sizeof(struct sockaddr_in));
-  }
-
-  if (addr->sa_family == AF_INET6)
-  {
-    const struct sockaddr_in6 *addr6 = (const struct sockaddr_in6 *) addr;
-    const struct sockaddr_in6 *netmask6 = (const struct sockaddr_in6 *) netmask;
-    struct sockaddr_in6 *tmp;
-    struct sockaddr_in6 network6;
-
-    net = GNUNET_malloc (sizeof(struct NT_Network) + 2 * sizeof(struct
-                                                                sockaddr_in6));
-    tmp = (struct sockaddr_in6 *) &net[1];
-    net->network = (struct sockaddr *) &tmp[0];
-    net->netmask = (struct sockaddr *) &tmp[1];
-    net->length = addrlen;
-
-    memset (&network6, 0, sizeof(network6));
-    network6.sin6_family = AF_INET6;
-#if HAVE_SOCKADDR_IN_SIN_LEN
-    network6.sin6_len = sizeof(network6);
-#endif
+    net = find_network (is,
+                        &tmp);
+    if (NULL == net)
     {
-      unsigned int c;
-      uint32_t *addr_elem = (uint32_t *) &addr6->sin6_addr;
-      uint32_t *mask_elem = (uint32_t *) &netmask6->sin6_addr;
-      uint32_t *net_elem = (uint32_t *) &network6.sin6_addr;
-      for (c = 0; c < 4; c++)
-        net_elem[c] = addr_elem[c] & mask_elem[c];
-
-      GNUNET_memcpy (net->netmask,
-                     netmask6,
-                     sizeof(struct sockaddr_in6));
-      GNUNET_memcpy (net->network,
-                     &network6,
-                     sizeof(struct sockaddr_in6));
+      GNUNET_break (0);
+      return;
     }
+    GNUNET_assert (GNUNET_YES ==
+                   GNUNET_CONTAINER_multihashmap32_remove (is->nets,
+                                                           network_key (net),
+                                                           net));
+    (*prefix_cnt (is,
+                  net))--;
+    GNUNET_free (net);
+    return;
   }
-  if (NULL == net)
-    return GNUNET_OK; /* odd / unsupported address family */
-
-  /* Store in list */
+  net = GNUNET_new (struct NT_Network);
+  *net = tmp;
 #if VERBOSE_NT
-  char *netmask = GNUNET_strdup (GNUNET_a2s ((struct sockaddr *) net->netmask,
-                                             addrlen));
   GNUNET_log_from (GNUNET_ERROR_TYPE_DEBUG,
                    "nt",
-                   "Adding network `%s', netmask `%s'\n",
-                   GNUNET_a2s ((struct sockaddr *) net->network,
+                   "Adding network `%s/%u'\n",
+                   GNUNET_a2s (addr,
                                addrlen),
-                   netmask);
-  GNUNET_free (netmask);
+                   net->prefix_len);
 #endif
-  GNUNET_CONTAINER_DLL_insert (is->net_head,
-                               is->net_tail,
-                               net);
-
-  return GNUNET_OK;
+  (*prefix_cnt (is,
+                net))++;
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONTAINER_multihashmap32_put (
+                   is->nets,
+                   network_key (net),
+                   net,
+                   GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
 }
 
 
 /**
- * Periodically get list of network addresses from our interfaces.
+ * Check if @a addr is in one of our networks, looking up its
+ * prefix for each prefix length we have networks with.
  *
- * @param cls closure
+ * @param is the scanner
+ * @param af address family of @a addr
+ * @param addr a `struct in_addr` or `struct in6_addr`
+ * @return #GNUNET_YES if @a addr is in a LAN
  */
-static void
-get_addresses (void *cls)
+static enum GNUNET_GenericReturnValue
+in_local_network (struct GNUNET_NT_InterfaceScanner *is,
+                  sa_family_t af,
+                  const void *addr)
 {
-  struct GNUNET_NT_InterfaceScanner *is = cls;
+  const unsigned int *cnt;
+  unsigned int max;
+  struct NT_Network net;
 
-  is->interface_task = NULL;
-  delete_networks (is);
-  GNUNET_OS_network_interfaces_list (&interface_proc,
-                                     is);
-  is->interface_task = GNUNET_SCHEDULER_add_delayed (
-    INTERFACE_PROCESSING_INTERVAL,
-    &get_addresses,
-    is);
+  if (AF_INET == af)
+  {
+    cnt = is->v4_prefix_cnt;
+    max = 32;
+  }
+  else
+  {
+    cnt = is->v6_prefix_cnt;
+    max = 128;
+  }
+  for (unsigned int plen = 0; plen <= max; plen++)
+  {
+    if (0 == cnt[plen])
+      continue;
+    mask_address (af,
+                  addr,
+                  plen,
+                  &net);
+    if (NULL != find_network (is,
+                              &net))
+      return GNUNET_YES;
+  }
+  return GNUNET_NO;
 }
 
 
@@ -310,7 +500,6 @@ GNUNET_NT_scanner_get_type (struct GNUNET_NT_InterfaceScanner *is,
                             const struct sockaddr *addr,
                             socklen_t addrlen)
 {
-  struct NT_Network *cur = is->net_head;
   enum GNUNET_NetworkType type = GNUNET_NT_UNSPECIFIED;
 
   switch (addr->sa_family)
@@ -325,6 +514,12 @@ GNUNET_NT_scanner_get_type (struct GNUNET_NT_InterfaceScanner *is,
 
       if ((a4->sin_addr.s_addr & htonl (0xff000000)) == htonl (0x7f000000))
         type = GNUNET_NT_LOOPBACK;
+      else if ( (sizeof (*a4) == addrlen) &&
+                (GNUNET_YES ==
+                 in_local_network (is,
+                                   AF_INET,
+                                   &a4->sin_addr)) )
+        type = GNUNET_NT_LAN;
       break;
     }
 
@@ -334,6 +529,12 @@ GNUNET_NT_scanner_get_type (struct GNUNET_NT_InterfaceScanner *is,
 
       if (IN6_IS_ADDR_LOOPBACK (&a6->sin6_addr))
         type = GNUNET_NT_LOOPBACK;
+      else if ( (sizeof (*a6) == addrlen) &&
+                (GNUNET_YES ==
+                 in_local_network (is,
+                                   AF_INET6,
+                                   &a6->sin6_addr)) )
+        type = GNUNET_NT_LAN;
       break;
     }
 
@@ -342,49 +543,6 @@ GNUNET_NT_scanner_get_type (struct GNUNET_NT_InterfaceScanner *is,
     break;
   }
 
-  /* Check local networks */
-  while ((NULL != cur) && (GNUNET_NT_UNSPECIFIED == type))
-  {
-    if (addrlen != cur->length)
-    {
-      cur = cur->next;
-      continue;
-    }
-    if (addr->sa_family == AF_INET)
-    {
-      const struct sockaddr_in *a4 = (const struct sockaddr_in *) addr;
-      const struct sockaddr_in *net4 = (const struct
-                                        sockaddr_in *) cur->network;
-      const struct sockaddr_in *mask4 = (const struct
-                                         sockaddr_in *) cur->netmask;
-
-      if (((a4->sin_addr.s_addr & mask4->sin_addr.s_addr)) ==
-          net4->sin_addr.s_addr)
-        type = GNUNET_NT_LAN;
-    }
-    if (addr->sa_family == AF_INET6)
-    {
-      const struct sockaddr_in6 *a6 = (const struct sockaddr_in6 *) addr;
-      const struct sockaddr_in6 *net6 = (const struct
-                                         sockaddr_in6 *) cur->network;
-      const struct sockaddr_in6 *mask6 = (const struct
-                                          sockaddr_in6 *) cur->netmask;
-
-      int res = GNUNET_YES;
-      int c = 0;
-      uint32_t *addr_elem = (uint32_t *) &a6->sin6_addr;
-      uint32_t *mask_elem = (uint32_t *) &mask6->sin6_addr;
-      uint32_t *net_elem = (uint32_t *) &net6->sin6_addr;
-      for (c = 0; c < 4; c++)
-        if ((addr_elem[c] & mask_elem[c]) != net_elem[c])
-          res = GNUNET_NO;
-
-      if (res == GNUNET_YES)
-        type = GNUNET_NT_LAN;
-    }
-    cur = cur->next;
-  }
-
   /* no local network found for this address, default: WAN */
   if (type == GNUNET_NT_UNSPECIFIED)
     type = GNUNET_NT_WAN;
@@ -409,16 +567,35 @@ GNUNET_NT_scanner_init ()
   struct GNUNET_NT_InterfaceScanner *is;
 
   is = GNUNET_new (struct GNUNET_NT_InterfaceScanner);
-  GNUNET_OS_network_interfaces_list (&interface_proc,
-                                     is);
-  is->interface_task = GNUNET_SCHEDULER_add_delayed (
+  is->nets = GNUNET_CONTAINER_multihashmap32_create (16);
+  is->mon = GNUNET_OS_network_interfaces_monitor_start (
     INTERFACE_PROCESSING_INTERVAL,
-    &get_addresses,
+    &interface_change_cb,
     is);
   return is;
 }
 
 
+/**
+ * Free an entry of the network index.
+ *
+ * @param cls unused
+ * @param key unused
+ * @param value a `struct NT_Network` to free
+ * @return #GNUNET_OK (continue to iterate)
+ */
+static enum GNUNET_GenericReturnValue
+free_network (void *cls,
+              uint32_t key,
+              void *value)
+{
+  (void) cls;
+  (void) key;
+  GNUNET_free (value);
+  return GNUNET_OK;
+}
+
+
 /**
  * Client is done with the interface scanner, release resources.
  *
@@ -427,12 +604,11 @@ GNUNET_NT_scanner_init ()
 void
 GNUNET_NT_scanner_done (struct GNUNET_NT_InterfaceScanner *is)
 {
-  if (NULL != is->interface_task)
-  {
-    GNUNET_SCHEDULER_cancel (is->interface_task);
-    is->interface_task = NULL;
-  }
-  delete_networks (is);
+  GNUNET_OS_network_interfaces_monitor_stop (is->mon);
+  GNUNET_CONTAINER_multihashmap32_iterate (is->nets,
+                                           &free_network,
+                                           NULL);
+  GNUNET_CONTAINER_multihashmap32_destroy (is->nets);
   GNUNET_free (is);
 }
 
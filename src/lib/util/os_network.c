@@ -30,9 +30,19 @@
 
 #include "platform.h"
 #include "gnunet_util_lib.h"
+#if HAVE_LINUX_RTNETLINK_H
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#define USE_RTNETLINK 1
+#else
+#define USE_RTNETLINK 0
+#endif
 
 
 #define LOG(kind, ...) GNUNET_log_from (kind, "util-os-network", __VA_ARGS__)
+#define LOG_STRERROR(kind, syscall) GNUNET_log_from_strerror (kind, \
+                                                             "util-os-network", \
+                                                             syscall)
 #define LOG_STRERROR_FILE(kind, syscall, \
                           filename) GNUNET_log_from_strerror_file (kind, \
                                                                    "util-os-network", \
@@ -441,4 +451,541 @@ GNUNET_OS_network_interfaces_list (GNUNET_OS_NetworkInterfaceProcessor proc,
 }
 
 
+#if USE_RTNETLINK
+/**
+ * How long do we wait after a netlink notification before scanning
+ * the interfaces?  Changes usually come in bursts (link, then
+ * addresses), so this avoids scanning for every message.
+ */
+#define NETLINK_SETTLE_DELAY GNUNET_TIME_relative_multiply ( \
+          GNUNET_TIME_UNIT_MILLISECONDS, 50)
+#endif
+
+
+/**
+ * An address of an interface as seen by the last scan of a
+ * `struct GNUNET_OS_NetworkInterfaceMonitor`.
+ */
+struct MonitorEntry
+{
+  /**
+   * Kept in a DLL.
+   */
+  struct MonitorEntry *next;
+
+  /**
+   * Kept in a DLL.
+   */
+  struct MonitorEntry *prev;
+
+  /**
+   * Name of the interface, NULL for unknown.
+   */
+  char *name;
+
+  /**
+   * Address of the interface.
+   */
+  struct sockaddr_storage addr;
+
+  /**
+   * Broadcast address, valid if @e have_broadcast is set.
+   */
+  struct sockaddr_storage broadcast;
+
+  /**
+   * Netmask, valid if @e have_netmask is set.
+   */
+  struct sockaddr_storage netmask;
+
+  /**
+   * Number of bytes in @e addr, @e broadcast and @e netmask.
+   */
+  socklen_t addrlen;
+
+  /**
+   * Is this presumably the default interface?
+   */
+  int isDefault;
+
+  /**
+   * Do we know the broadcast address?
+   */
+  bool have_broadcast;
+
+  /**
+   * Do we know the netmask?
+   */
+  bool have_netmask;
+
+  /**
+   * Was the entry found in the current scan?
+   */
+  bool found;
+};
+
+
+/**
+ * Handle to a monitor of the network interfaces.
+ */
+struct GNUNET_OS_NetworkInterfaceMonitor
+{
+  /**
+   * Function to call on changes.
+   */
+  GNUNET_OS_NetworkInterfaceMonitorCallback cb;
+
+  /**
+   * Closure for @e cb.
+   */
+  void *cb_cls;
+
+  /**
+   * Head of the addresses we know about.
+   */
+  struct MonitorEntry *e_head;
+
+  /**
+   * Tail of the addresses we know about.
+   */
+  struct MonitorEntry *e_tail;
+
+  /**
+   * Head of the addresses added in the current scan.
+   */
+  struct MonitorEntry *n_head;
+
+  /**
+   * Tail of the addresses added in the current scan.
+   */
+  struct MonitorEntry *n_tail;
+
+  /**
+   * Task for the next scan.
+   */
+  struct GNUNET_SCHEDULER_Task *scan_task;
+
+  /**
+   * How often do we scan if we do not get change notifications?
+   */
+  struct GNUNET_TIME_Relative poll_freq;
+
+#if USE_RTNETLINK
+  /**
+   * Netlink socket notifying us about changes, NULL if unavailable.
+   */
+  struct GNUNET_NETWORK_Handle *nl;
+
+  /**
+   * Task reading from @e nl.
+   */
+  struct GNUNET_SCHEDULER_Task *nl_task;
+#endif
+};
+
+
+/**
+ * Compare the optional socket address @a sa with what we stored.
+ *
+ * @param have do we have a stored address
+ * @param stored the stored address
+ * @param sa address to compare, can be NULL
+ * @param addrlen number of bytes in @a sa
+ * @return true if both are NULL or the same
+ */
+static bool
+same_opt_addr (bool have,
+               const struct sockaddr_storage *stored,
+               const struct sockaddr *sa,
+               socklen_t addrlen)
+{
+  if (NULL == sa)
+    return ! have;
+  return have &&
+         (0 == memcmp (stored,
+                       sa,
+                       addrlen));
+}
+
+
+/**
+ * Function invoked for each interface found during a scan of
+ * a monitor.  Marks known entries as found and records new ones.
+ *
+ * @param cls the `struct GNUNET_OS_NetworkInterfaceMonitor`
+ * @param name name of the interface (can be NULL for unknown)
+ * @param isDefault is this presumably the default interface
+ * @param addr address of this interface (can be NULL for unknown or unassigned)
+ * @param broadcast_addr the broadcast address (can be NULL for unknown or unassigned)
+ * @param netmask the network mask (can be NULL for unknown or unassigned)
+ * @param addrlen length of the address
+ * @return #GNUNET_OK to continue iteration
+ */
+static enum GNUNET_GenericReturnValue
+monitor_proc (void *cls,
+              const char *name,
+              int isDefault,
+              const struct sockaddr *addr,
+              const struct sockaddr *broadcast_addr,
+              const struct sockaddr *netmask,
+              socklen_t addrlen)
+{
+  struct GNUNET_OS_NetworkInterfaceMonitor *mon = cls;
+  struct MonitorEntry *e;
+
+  if ( (NULL == addr) ||
+       (addrlen > sizeof (e->addr)) )
+    return GNUNET_OK;
+  for (e = mon->e_head; NULL != e; e = e->next)
+  {
+    if ( (! e->found) &&
+         (e->addrlen == addrlen) &&
+         (e->isDefault == isDefault) &&
+         (0 == memcmp (&e->addr,
+                       addr,
+                       addrlen)) &&
+         same_opt_addr (e->have_broadcast,
+                        &e->broadcast,
+                        broadcast_addr,
+                        addrlen) &&
+         same_opt_addr (e->have_netmask,
+                        &e->netmask,
+                        netmask,
+                        addrlen) &&
+         ( ( (NULL == name) &&
+             (NULL == e->name) ) ||
+           ( (NULL != name) &&
+             (NULL != e->name) &&
+             (0 == strcmp (name,
+                           e->name)) ) ) )
+    {
+      e->found = true;
+      return GNUNET_OK;
+    }
+  }
+  e = GNUNET_new (struct MonitorEntry);
+  if (NULL != name)
+    e->name = GNUNET_strdup (name);
+  e->isDefault = isDefault;
+  e->addrlen = addrlen;
+  GNUNET_memcpy (&e->addr,
+                 addr,
+                 addrlen);
+  if (NULL != broadcast_addr)
+  {
+    e->have_broadcast = true;
+    GNUNET_memcpy (&e->broadcast,
+                   broadcast_addr,
+                   addrlen);
+  }
+  if (NULL != netmask)
+  {
+    e->have_netmask = true;
+    GNUNET_memcpy (&e->netmask,
+                   netmask,
+                   addrlen);
+  }
+  e->found = true;
+  GNUNET_CONTAINER_DLL_insert_tail (mon->n_head,
+                                    mon->n_tail,
+                                    e);
+  return GNUNET_OK;
+}
+
+
+/**
+ * Tell the monitor's callback about @a e.
+ *
+ * @param mon the monitor
+ * @param change what happened to @a e
+ * @param e the entry
+ */
+static void
+notify_entry (struct GNUNET_OS_NetworkInterfaceMonitor *mon,
+              enum GNUNET_OS_NetworkInterfaceChange change,
+              const struct MonitorEntry *e)
+{
+  mon->cb (mon->cb_cls,
+           change,
+           e->name,
+           e->isDefault,
+           (const struct sockaddr *) &e->addr,
+           e->have_broadcast
+           ? (const struct sockaddr *) &e->broadcast
+           : NULL,
+           e->have_netmask
+           ? (const struct sockaddr *) &e->netmask
+           : NULL,
+           e->addrlen);
+}
+
+
+/**
+ * Scan the interfaces and report the differences to the last scan.
+ * Removals are reported before additions, so an address that merely
+ * changed its properties is first removed and then added again.
+ *
+ * @param mon the monitor
+ * @param initial is this the first scan
+ */
+static void
+monitor_scan (struct GNUNET_OS_NetworkInterfaceMonitor *mon,
+              bool initial)
+{
+  struct MonitorEntry *e;
+  struct MonitorEntry *next;
+  bool changed = false;
+
+  for (e = mon->e_head; NULL != e; e = e->next)
+    e->found = false;
+  GNUNET_OS_network_interfaces_list (&monitor_proc,
+                                     mon);
+  for (e = mon->e_head; NULL != e; e = next)
+  {
+    next = e->next;
+    if (e->found)
+      continue;
+    changed = true;
+    GNUNET_CONTAINER_DLL_remove (mon->e_head,
+                                 mon->e_tail,
+                                 e);
+    notify_entry (mon,
+                  GNUNET_OS_NIC_REMOVED,
+                  e);
+    GNUNET_free (e->name);
+    GNUNET_free (e);
+  }
+  while (NULL != (e = mon->n_head))
+  {
+    changed = true;
+    GNUNET_CONTAINER_DLL_remove (mon->n_head,
+                                 mon->n_tail,
+                                 e);
+    GNUNET_CONTAINER_DLL_insert_tail (mon->e_head,
+                                      mon->e_tail,
+                                      e);
+    notify_entry (mon,
+                  GNUNET_OS_NIC_ADDED,
+                  e);
+  }
+  if (changed || initial)
+    mon->cb (mon->cb_cls,
+             GNUNET_OS_NIC_SYNCED,
+             NULL,
+             GNUNET_NO,
+             NULL,
+             NULL,
+             NULL,
+             0);
+}
+
+
+/**
+ * Do we get notified about changes of the interfaces, or do
+ * we have to poll?
+ *
+ * @param mon the monitor
+ * @return true if we get notified
+ */
+static bool
+have_notifications (const struct GNUNET_OS_NetworkInterfaceMonitor *mon)
+{
+#if USE_RTNETLINK
+  return NULL != mon->nl;
+#else
+  (void) mon;
+  return false;
+#endif
+}
+
+
+/**
+ * Task scanning the interfaces, either periodically or after we
+ * were notified of a change.
+ *
+ * @param cls the `struct GNUNET_OS_NetworkInterfaceMonitor`
+ */
+static void
+do_monitor_scan (void *cls)
+{
+  struct GNUNET_OS_NetworkInterfaceMonitor *mon = cls;
+
+  mon->scan_task = NULL;
+  if (! have_notifications (mon))
+    mon->scan_task = GNUNET_SCHEDULER_add_delayed (mon->poll_freq,
+                                                   &do_monitor_scan,
+                                                   mon);
+  monitor_scan (mon,
+                false);
+}
+
+
+#if USE_RTNETLINK
+/**
+ * The netlink socket is readable.  Drain it and schedule a scan.
+ * We do not parse the messages: the groups we joined only carry
+ * link and address changes, and a scan gives us all the details
+ * (and the broadcast address) in a portable format.
+ *
+ * @param cls the `struct GNUNET_OS_NetworkInterfaceMonitor`
+ */
+static void
+netlink_read (void *cls)
+{
+  struct GNUNET_OS_NetworkInterfaceMonitor *mon = cls;
+  char buf[8192] __attribute__ ((aligned (NLMSG_ALIGNTO)));
+  ssize_t ret;
+  bool seen = false;
+
+  mon->nl_task = NULL;
+  while (1)
+  {
+    ret = GNUNET_NETWORK_socket_recv (mon->nl,
+                                      buf,
+                                      sizeof (buf));
+    if (ret > 0)
+    {
+      seen = true;
+      continue;
+    }
+    if ( (-1 == ret) &&
+         (ENOBUFS == errno) )
+    {
+      /* we lost notifications, so we must scan */
+      seen = true;
+      continue;
+    }
+    if ( (-1 == ret) &&
+         (EINTR == errno) )
+      continue;
+    break;
+  }
+  if ( (-1 == ret) &&
+       (EAGAIN != errno) &&
+       (EWOULDBLOCK != errno) )
+  {
+    /* socket is broken, fall back to polling */
+    LOG_STRERROR (GNUNET_ERROR_TYPE_WARNING,
+                  "recv");
+    GNUNET_break (GNUNET_OK ==
+                  GNUNET_NETWORK_socket_close (mon->nl));
+    mon->nl = NULL;
+    if (NULL != mon->scan_task)
+      GNUNET_SCHEDULER_cancel (mon->scan_task);
+    mon->scan_task = GNUNET_SCHEDULER_add_now (&do_monitor_scan,
+                                               mon);
+    return;
+  }
+  mon->nl_task = GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                                mon->nl,
+                                                &netlink_read,
+                                                mon);
+  if ( seen &&
+       (NULL == mon->scan_task) )
+    mon->scan_task = GNUNET_SCHEDULER_add_delayed (NETLINK_SETTLE_DELAY,
+                                                   &do_monitor_scan,
+                                                   mon);
+}
+
+
+/**
+ * Subscribe to link and address changes via rtnetlink.
+ *
+ * @param[in,out] mon monitor to set up
+ * @return #GNUNET_OK on success
+ */
+static enum GNUNET_GenericReturnValue
+netlink_open (struct GNUNET_OS_NetworkInterfaceMonitor *mon)
+{
+  struct sockaddr_nl snl;
+  int fd;
+
+  fd = socket (AF_NETLINK,
+               SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC,
+               NETLINK_ROUTE);
+  if (-1 == fd)
+  {
+    LOG_STRERROR (GNUNET_ERROR_TYPE_INFO,
+                  "socket");
+    return GNUNET_SYSERR;
+  }
+  memset (&snl,
+          0,
+          sizeof (snl));
+  snl.nl_family = AF_NETLINK;
+  snl.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+  if (0 != bind (fd,
+                 (const struct sockaddr *) &snl,
+                 sizeof (snl)))
+  {
+    LOG_STRERROR (GNUNET_ERROR_TYPE_INFO,
+                  "bind");
+    GNUNET_break (0 == close (fd));
+    return GNUNET_SYSERR;
+  }
+  mon->nl = GNUNET_NETWORK_socket_box_native (fd);
+  mon->nl_task = GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                                mon->nl,
+                                                &netlink_read,
+                                                mon);
+  return GNUNET_OK;
+}
+
+
+#endif
+
+
+struct GNUNET_OS_NetworkInterfaceMonitor *
+GNUNET_OS_network_interfaces_monitor_start (
+  struct GNUNET_TIME_Relative poll_freq,
+  GNUNET_OS_NetworkInterfaceMonitorCallback cb,
+  void *cb_cls)
+{
+  struct GNUNET_OS_NetworkInterfaceMonitor *mon;
+
+  mon = GNUNET_new (struct GNUNET_OS_NetworkInterfaceMonitor);
+  mon->cb = cb;
+  mon->cb_cls = cb_cls;
+  mon->poll_freq = poll_freq;
+#if USE_RTNETLINK
+  /* subscribe before the first scan so that we cannot miss changes */
+  (void) netlink_open (mon);
+#endif
+  if (! have_notifications (mon))
+    mon->scan_task = GNUNET_SCHEDULER_add_delayed (poll_freq,
+                                                   &do_monitor_scan,
+                                                   mon);
+  monitor_scan (mon,
+                true);
+  return mon;
+}
+
+
+void
+GNUNET_OS_network_interfaces_monitor_stop (
+  struct GNUNET_OS_NetworkInterfaceMonitor *mon)
+{
+  struct MonitorEntry *e;
+
+#if USE_RTNETLINK
+  if (NULL != mon->nl_task)
+    GNUNET_SCHEDULER_cancel (mon->nl_task);
+  if (NULL != mon->nl)
+    GNUNET_break (GNUNET_OK ==
+                  GNUNET_NETWORK_socket_close (mon->nl));
+#endif
+  if (NULL != mon->scan_task)
+    GNUNET_SCHEDULER_cancel (mon->scan_task);
+  while (NULL != (e = mon->e_head))
+  {
+    GNUNET_CONTAINER_DLL_remove (mon->e_head,
+                                 mon->e_tail,
+                                 e);
+    GNUNET_free (e->name);
+    GNUNET_free (e);
+  }
+  GNUNET_free (mon);
+}
+
+
 /* end of os_network.c */
@@ -0,0 +1,413 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file util/perf_container_heap.c
+ * @brief measure the heap with a million elements, comparing the array
+ *        heap of container_heap.c with the pointer-linked binary tree
+ *        it used to be (a copy of which is included here)
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+
+/**
+ * Number of elements in the heap.
+ */
+#define NUM_ELEMENTS (1024 * 1024)
+
+
+/* ******************** the old tree heap ******************** */
+
+struct TreeHeap;
+
+struct TreeNode
+{
+  struct TreeHeap *heap;
+
+  struct TreeNode *parent;
+
+  struct TreeNode *left_child;
+
+  struct TreeNode *right_child;
+
+  void *element;
+
+  GNUNET_CONTAINER_HeapCostType cost;
+
+  unsigned int tree_size;
+};
+
+
+struct TreeHeap
+{
+  struct TreeNode *root;
+
+  unsigned int size;
+
+  enum GNUNET_CONTAINER_HeapOrder order;
+};
+
+
+static void
+tree_insert_node (struct TreeHeap *heap,
+                  struct TreeNode *pos,
+                  struct TreeNode *node)
+{
+  struct TreeNode *parent;
+
+  while ((heap->order == GNUNET_CONTAINER_HEAP_ORDER_MAX)
+         ? (pos->cost >= node->cost)
+         : (pos->cost <= node->cost))
+  {
+    pos->tree_size += (1 + node->tree_size);
+    if (pos->left_child == NULL)
+    {
+      pos->left_child = node;
+      node->parent = pos;
+      return;
+    }
+    if (pos->right_child == NULL)
+    {
+      pos->right_child = node;
+      node->parent = pos;
+      return;
+    }
+    if (pos->left_child->tree_size < pos->right_child->tree_size)
+      pos = pos->left_child;
+    else
+      pos = pos->right_child;
+  }
+  parent = pos->parent;
+  pos->parent = NULL;
+  node->parent = parent;
+  if (NULL == parent)
+    heap->root = node;
+  else if (parent->left_child == pos)
+    parent->left_child = node;
+  else
+    parent->right_child = node;
+  tree_insert_node (heap, node, pos);
+}
+
+
+static struct TreeNode *
+tree_insert (struct TreeHeap *heap,
+             void *element,
+             GNUNET_CONTAINER_HeapCostType cost)
+{
+  struct TreeNode *node;
+
+  node = GNUNET_new (struct TreeNode);
+  node->heap = heap;
+  node->element = element;
+  node->cost = cost;
+  heap->size++;
+  if (NULL == heap->root)
+    heap->root = node;
+  else
+    tree_insert_node (heap, heap->root, node);
+  return node;
+}
+
+
+static void *
+tree_remove_root (struct TreeHeap *heap)
+{
+  void *ret;
+  struct TreeNode *root;
+
+  if (NULL == (root = heap->root))
+    return NULL;
+  heap->size--;
+  ret = root->element;
+  if (root->left_child == NULL)
+  {
+    heap->root = root->right_child;
+    if (root->right_child != NULL)
+      root->right_child->parent = NULL;
+  }
+  else if (root->right_child == NULL)
+  {
+    heap->root = root->left_child;
+    root->left_child->parent = NULL;
+  }
+  else
+  {
+    root->left_child->parent = NULL;
+    root->right_child->parent = NULL;
+    heap->root = root->left_child;
+    tree_insert_node (heap, heap->root, root->right_child);
+  }
+  GNUNET_free (root);
+  return ret;
+}
+
+
+static void
+tree_unlink_node (struct TreeNode *node)
+{
+  struct TreeNode *ancestor;
+  struct TreeHeap *heap = node->heap;
+
+  ancestor = node;
+  while (NULL != (ancestor = ancestor->parent))
+    ancestor->tree_size--;
+  if (node->left_child != NULL)
+    node->tree_size -= (1 + node->left_child->tree_size);
+  if (node->right_child != NULL)
+    node->tree_size -= (1 + node->right_child->tree_size);
+  if (node->parent == NULL)
+  {
+    if (node->left_child != NULL)
+    {
+      heap->root = node->left_child;
+      node->left_child->parent = NULL;
+      if (node->right_child != NULL)
+      {
+        node->right_child->parent = NULL;
+        tree_insert_node (heap, heap->root, node->right_child);
+      }
+    }
+    else
+    {
+      heap->root = node->right_child;
+      if (node->right_child != NULL)
+        node->right_child->parent = NULL;
+    }
+  }
+  else
+  {
+    if (node->parent->left_child == node)
+      node->parent->left_child = NULL;
+    else
+      node->parent->right_child = NULL;
+    if (node->left_child != NULL)
+    {
+      node->left_child->parent = NULL;
+      node->parent->tree_size -= (1 + node->left_child->tree_size);
+      tree_insert_node (heap, node->parent, node->left_child);
+    }
+    if (node->right_child != NULL)
+    {
+      node->right_child->parent = NULL;
+      node->parent->tree_size -= (1 + node->right_child->tree_size);
+      tree_insert_node (heap, node->parent, node->right_child);
+    }
+  }
+  node->parent = NULL;
+  node->left_child = NULL;
+  node->right_child = NULL;
+}
+
+
+static void *
+tree_remove_node (struct TreeNode *node)
+{
+  void *ret = node->element;
+
+  tree_unlink_node (node);
+  node->heap->size--;
+  GNUNET_free (node);
+  return ret;
+}
+
+
+static void
+tree_update_cost (struct TreeNode *node,
+                  GNUNET_CONTAINER_HeapCostType new_cost)
+{
+  struct TreeHeap *heap = node->heap;
+
+  tree_unlink_node (node);
+  node->cost = new_cost;
+  if (NULL == heap->root)
+    heap->root = node;
+  else
+    tree_insert_node (heap, heap->root, node);
+}
+
+
+/* ******************** measurements ******************** */
+
+static GNUNET_CONTAINER_HeapCostType costs[NUM_ELEMENTS];
+
+static uint32_t picks[NUM_ELEMENTS];
+
+static unsigned int *removal_order;
+
+static struct TreeNode *tree_nodes[NUM_ELEMENTS];
+
+static struct GNUNET_CONTAINER_HeapNode *heap_nodes[NUM_ELEMENTS];
+
+
+static void
+report (const char *mode,
+        struct GNUNET_TIME_Absolute start,
+        unsigned long long ops)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %llu operations in %s (%llu/s)\n",
+          mode,
+          ops,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          ops * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+static void
+perf_tree (void)
+{
+  struct TreeHeap heap = {
+    .order = GNUNET_CONTAINER_HEAP_ORDER_MIN
+  };
+  struct GNUNET_TIME_Absolute start;
+  GNUNET_CONTAINER_HeapCostType now = UINT32_MAX;
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_ELEMENTS; i++)
+    tree_nodes[i] = tree_insert (&heap,
+                                 &tree_nodes[i],
+                                 costs[i]);
+  report ("tree, insert",
+          start,
+          NUM_ELEMENTS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_ELEMENTS; i++)
+    tree_update_cost (tree_nodes[picks[i]],
+                      costs[(i + 1) % NUM_ELEMENTS]);
+  report ("tree, update to random cost",
+          start,
+          NUM_ELEMENTS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_ELEMENTS; i++)
+    tree_update_cost (tree_nodes[picks[i]],
+                      now++);
+  report ("tree, update to latest (LRU)",
+          start,
+          NUM_ELEMENTS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_ELEMENTS / 2; i++)
+  {
+    unsigned int r = removal_order[i];
+
+    GNUNET_assert (&tree_nodes[r] ==
+                   tree_remove_node (tree_nodes[r]));
+  }
+  report ("tree, remove node",
+          start,
+          NUM_ELEMENTS / 2);
+  start = GNUNET_TIME_absolute_get ();
+  while (NULL != tree_remove_root (&heap))
+    ;
+  report ("tree, remove root",
+          start,
+          NUM_ELEMENTS - NUM_ELEMENTS / 2);
+}
+
+
+static void
+perf_heap (void)
+{
+  struct GNUNET_CONTAINER_Heap *heap;
+  struct GNUNET_TIME_Absolute start;
+  GNUNET_CONTAINER_HeapCostType now = UINT32_MAX;
+  GNUNET_CONTAINER_HeapCostType last = 0;
+  GNUNET_CONTAINER_HeapCostType cost;
+  void *element;
+
+  heap = GNUNET_CONTAINER_heap_create (GNUNET_CONTAINER_HEAP_ORDER_MIN);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_ELEMENTS; i++)
+    heap_nodes[i] = GNUNET_CONTAINER_heap_insert (heap,
+                                                  &heap_nodes[i],
+                                                  costs[i]);
+  report ("array, insert",
+          start,
+          NUM_ELEMENTS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_ELEMENTS; i++)
+    GNUNET_CONTAINER_heap_update_cost (heap_nodes[picks[i]],
+                                       costs[(i + 1) % NUM_ELEMENTS]);
+  report ("array, update to random cost",
+          start,
+          NUM_ELEMENTS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_ELEMENTS; i++)
+    GNUNET_CONTAINER_heap_update_cost (heap_nodes[picks[i]],
+                                       now++);
+  report ("array, update to latest (LRU)",
+          start,
+          NUM_ELEMENTS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_ELEMENTS / 2; i++)
+  {
+    unsigned int r = removal_order[i];
+
+    GNUNET_assert (&heap_nodes[r] ==
+                   GNUNET_CONTAINER_heap_remove_node (heap_nodes[r]));
+  }
+  report ("array, remove node",
+          start,
+          NUM_ELEMENTS / 2);
+  start = GNUNET_TIME_absolute_get ();
+  while (GNUNET_YES ==
+         GNUNET_CONTAINER_heap_peek2 (heap,
+                                      &element,
+                                      &cost))
+  {
+    GNUNET_assert (cost >= last);
+    last = cost;
+    GNUNET_assert (element ==
+                   GNUNET_CONTAINER_heap_remove_root (heap));
+  }
+  report ("array, remove root",
+          start,
+          NUM_ELEMENTS - NUM_ELEMENTS / 2);
+  GNUNET_CONTAINER_heap_destroy (heap);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  GNUNET_log_setup ("perf-container-heap",
+                    "WARNING",
+                    NULL);
+  for (unsigned int i = 0; i < NUM_ELEMENTS; i++)
+  {
+    costs[i] = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                         UINT32_MAX);
+    picks[i] = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                         NUM_ELEMENTS);
+  }
+  removal_order = GNUNET_CRYPTO_random_permute (GNUNET_CRYPTO_QUALITY_WEAK,
+                                                NUM_ELEMENTS);
+  perf_tree ();
+  perf_heap ();
+  GNUNET_free (removal_order);
+  return 0;
+}
+
+
+/* end of perf_container_heap.c */
@@ -0,0 +1,324 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file util/perf_crypto_random.c
+ * @brief measure the throughput of GNUNET_CRYPTO_random_*() for weak and
+ *        nonce quality, comparing the per-thread ChaCha20 generators with
+ *        calling into libgcrypt for every number, as we used to
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include <gcrypt.h>
+#include <pthread.h>
+
+/**
+ * Number of integers to draw.
+ */
+#define NUM_INTS (1024 * 1024)
+
+/**
+ * Number of small blocks to draw.
+ */
+#define NUM_BLOCKS (64 * 1024)
+
+/**
+ * Number of permutations of #PERMUTE_SIZE elements.
+ */
+#define NUM_PERMUTES 64
+
+/**
+ * Size of the permutations.
+ */
+#define PERMUTE_SIZE 1024
+
+/**
+ * Number of threads drawing numbers concurrently.
+ */
+#define NUM_THREADS 4
+
+
+static void
+report (const char *mode,
+        struct GNUNET_TIME_Absolute start,
+        unsigned long long ops)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %llu in %s (%llu/s)\n",
+          mode,
+          ops,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          ops * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+/**
+ * A nonce-quality number in [0,i[, drawn from libgcrypt.
+ */
+static uint32_t
+gcry_nonce_u32 (uint32_t i)
+{
+  uint32_t ul = UINT32_MAX - (UINT32_MAX % i);
+  uint32_t ret;
+
+  do
+  {
+    gcry_create_nonce (&ret, sizeof(ret));
+  }
+  while (ret >= ul);
+  return ret % i;
+}
+
+
+/**
+ * A weak number in [0,i[, drawn from random().
+ */
+static uint32_t
+libc_weak_u32 (uint32_t i)
+{
+  uint32_t ret;
+
+  ret = i * (random () / (double) RAND_MAX);
+  if (ret >= i)
+    ret = i - 1;
+  return ret;
+}
+
+
+static void
+perf_u32 (void)
+{
+  struct GNUNET_TIME_Absolute start;
+  uint32_t sum = 0;
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_INTS; n++)
+    sum += gcry_nonce_u32 (1000);
+  report ("u32, gcry_create_nonce",
+          start,
+          NUM_INTS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_INTS; n++)
+    sum += GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_NONCE,
+                                     1000);
+  report ("u32, nonce",
+          start,
+          NUM_INTS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_INTS; n++)
+    sum += libc_weak_u32 (1000);
+  report ("u32, random",
+          start,
+          NUM_INTS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_INTS; n++)
+    sum += GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                     1000);
+  report ("u32, weak",
+          start,
+          NUM_INTS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_INTS; n++)
+    sum += GNUNET_CRYPTO_random_u64 (GNUNET_CRYPTO_QUALITY_NONCE,
+                                     UINT64_MAX / 3);
+  report ("u64, nonce",
+          start,
+          NUM_INTS);
+  /* keep the compiler from dropping the loops */
+  GNUNET_assert (0 != sum);
+}
+
+
+static void
+perf_block (void)
+{
+  struct GNUNET_TIME_Absolute start;
+  struct GNUNET_HashCode hc;
+  static char big[64 * 1024];
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_BLOCKS; n++)
+    gcry_randomize (&hc, sizeof (hc), GCRY_WEAK_RANDOM);
+  report ("64 byte blocks, gcry_randomize",
+          start,
+          NUM_BLOCKS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_BLOCKS; n++)
+    GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_WEAK,
+                                &hc,
+                                sizeof (hc));
+  report ("64 byte blocks, weak",
+          start,
+          NUM_BLOCKS);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_BLOCKS / 256; n++)
+    gcry_create_nonce (big, sizeof (big));
+  report ("64 KiB blocks, gcry_create_nonce",
+          start,
+          NUM_BLOCKS / 256);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_BLOCKS / 256; n++)
+    GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_NONCE,
+                                big,
+                                sizeof (big));
+  report ("64 KiB blocks, nonce",
+          start,
+          NUM_BLOCKS / 256);
+}
+
+
+static void
+perf_permute (void)
+{
+  struct GNUNET_TIME_Absolute start;
+  unsigned int *perm;
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_PERMUTES; n++)
+  {
+    perm = GNUNET_malloc (PERMUTE_SIZE * sizeof(unsigned int));
+    for (unsigned int i = 0; i < PERMUTE_SIZE; i++)
+      perm[i] = i;
+    for (unsigned int i = PERMUTE_SIZE - 1; i > 0; i--)
+    {
+      uint32_t x = gcry_nonce_u32 (i + 1);
+      unsigned int tmp = perm[x];
+
+      perm[x] = perm[i];
+      perm[i] = tmp;
+    }
+    GNUNET_free (perm);
+  }
+  report ("permutations, gcry_create_nonce",
+          start,
+          NUM_PERMUTES);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_PERMUTES; n++)
+  {
+    perm = GNUNET_CRYPTO_random_permute (GNUNET_CRYPTO_QUALITY_NONCE,
+                                         PERMUTE_SIZE);
+    GNUNET_free (perm);
+  }
+  report ("permutations, nonce",
+          start,
+          NUM_PERMUTES);
+}
+
+
+static void *
+draw_gcry (void *cls)
+{
+  uint32_t *sum = cls;
+
+  for (unsigned int n = 0; n < NUM_INTS / NUM_THREADS; n++)
+    *sum += gcry_nonce_u32 (1000);
+  return NULL;
+}
+
+
+static void *
+draw_nonce (void *cls)
+{
+  uint32_t *sum = cls;
+
+  for (unsigned int n = 0; n < NUM_INTS / NUM_THREADS; n++)
+    *sum += GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_NONCE,
+                                      1000);
+  return NULL;
+}
+
+
+static void
+perf_threads (const char *mode,
+              void *(*draw)(void *cls))
+{
+  struct GNUNET_TIME_Absolute start;
+  pthread_t threads[NUM_THREADS];
+  uint32_t sums[NUM_THREADS];
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int t = 0; t < NUM_THREADS; t++)
+  {
+    sums[t] = 0;
+    GNUNET_assert (0 == pthread_create (&threads[t],
+                                        NULL,
+                                        draw,
+                                        &sums[t]));
+  }
+  for (unsigned int t = 0; t < NUM_THREADS; t++)
+    GNUNET_assert (0 == pthread_join (threads[t],
+                                      NULL));
+  report (mode,
+          start,
+          NUM_INTS);
+}
+
+
+/**
+ * Check that the weak generator can be seeded and that small
+ * ranges come out evenly.
+ */
+static void
+check_output (void)
+{
+  uint32_t a[16];
+  unsigned int counts[3] = { 0, 0, 0 };
+
+  GNUNET_CRYPTO_seed_weak_random (42);
+  for (unsigned int i = 0; i < 16; i++)
+    a[i] = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                     UINT32_MAX);
+  GNUNET_CRYPTO_seed_weak_random (42);
+  for (unsigned int i = 0; i < 16; i++)
+    GNUNET_assert (a[i] ==
+                   GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                             UINT32_MAX));
+  for (unsigned int i = 0; i < 3 * 100000; i++)
+    counts[GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_NONCE,
+                                     3)]++;
+  for (unsigned int i = 0; i < 3; i++)
+    GNUNET_assert ( (counts[i] > 99000) &&
+                    (counts[i] < 101000) );
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  GNUNET_log_setup ("perf-crypto-random",
+                    "WARNING",
+                    NULL);
+  check_output ();
+  perf_u32 ();
+  perf_block ();
+  perf_permute ();
+  perf_threads ("u32, gcry_create_nonce, 4 threads",
+                &draw_gcry);
+  perf_threads ("u32, nonce, 4 threads",
+                &draw_nonce);
+  return 0;
+}
+
+
+/* end of perf_crypto_random.c */
@@ -0,0 +1,251 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file util/perf_mst.c
+ * @brief measure throughput of the message stream tokenizer
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+
+/**
+ * Number of messages in the stream.
+ */
+#define NUM_MESSAGES (1024 * 1024)
+
+/**
+ * How many times do we tokenize the stream per mode?
+ */
+#define ROUNDS 4
+
+/**
+ * Size of the chunks the stream is delivered in, mimicking
+ * what a socket read typically returns.
+ */
+#define CHUNK_SIZE (16 * 1024)
+
+
+static unsigned long long received_cnt;
+
+static unsigned long long received_bytes;
+
+
+static int
+check_cb (void *cls,
+          const struct GNUNET_MessageHeader *msg)
+{
+  (void) cls;
+  received_cnt++;
+  received_bytes += ntohs (msg->size);
+  return GNUNET_OK;
+}
+
+
+/**
+ * Build a stream of @e NUM_MESSAGES messages of random sizes.
+ *
+ * @param align make all sizes multiples of this, 1 for sizes
+ *        that are mostly not multiples of the alignment
+ * @param[out] size set to the size of the stream
+ * @return the stream
+ */
+static char *
+make_stream (uint16_t align,
+             size_t *size)
+{
+  char *stream;
+  size_t off;
+  uint32_t seed = 42;
+
+  stream = GNUNET_malloc_large (NUM_MESSAGES * 512);
+  GNUNET_assert (NULL != stream);
+  off = 0;
+  for (unsigned int i = 0; i < NUM_MESSAGES; i++)
+  {
+    struct GNUNET_MessageHeader hdr;
+    uint16_t msize;
+
+    seed = seed * 1103515245 + 12345;
+    msize = sizeof (hdr) + (seed >> 16) % 500;
+    msize += (align - msize % align) % align;
+    hdr.size = htons (msize);
+    hdr.type = htons (i % 1024);
+    GNUNET_memcpy (&stream[off],
+                   &hdr,
+                   sizeof (hdr));
+    memset (&stream[off + sizeof (hdr)],
+            (int) i,
+            msize - sizeof (hdr));
+    off += msize;
+  }
+  *size = off;
+  return stream;
+}
+
+
+/**
+ * Feed the stream through #GNUNET_MST_from_buffer(), as a caller
+ * with its own read buffer would.
+ */
+static void
+perf_from_buffer (const char *stream,
+                  size_t size)
+{
+  struct GNUNET_MessageStreamTokenizer *mst;
+
+  mst = GNUNET_MST_create (&check_cb,
+                           NULL);
+  for (size_t off = 0; off < size; off += CHUNK_SIZE)
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_MST_from_buffer (mst,
+                                           &stream[off],
+                                           GNUNET_MIN (CHUNK_SIZE,
+                                                       size - off),
+                                           GNUNET_NO,
+                                           GNUNET_NO));
+  GNUNET_MST_destroy (mst);
+}
+
+
+/**
+ * Feed the stream by writing directly into the buffer returned
+ * by #GNUNET_MST_receive_buffer(), as #GNUNET_MST_read() does.
+ */
+static void
+perf_receive_buffer (const char *stream,
+                     size_t size)
+{
+  struct GNUNET_MessageStreamTokenizer *mst;
+  size_t off;
+
+  mst = GNUNET_MST_create (&check_cb,
+                           NULL);
+  off = 0;
+  while (off < size)
+  {
+    void *buf;
+    size_t left;
+    size_t n;
+
+    buf = GNUNET_MST_receive_buffer (mst,
+                                     &left);
+    n = GNUNET_MIN (GNUNET_MIN (left,
+                                CHUNK_SIZE),
+                    size - off);
+    GNUNET_memcpy (buf,
+                   &stream[off],
+                   n);
+    off += n;
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_MST_receive_commit (mst,
+                                              n,
+                                              GNUNET_NO,
+                                              GNUNET_NO));
+  }
+  GNUNET_MST_destroy (mst);
+}
+
+
+static void
+report (const char *mode,
+        struct GNUNET_TIME_Absolute start,
+        size_t size)
+{
+  struct GNUNET_TIME_Relative dur;
+  uint64_t us;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  us = GNUNET_MAX (1, dur.rel_value_us);
+  GNUNET_assert (ROUNDS * (unsigned long long) NUM_MESSAGES == received_cnt);
+  GNUNET_assert (ROUNDS * (unsigned long long) size == received_bytes);
+  printf ("%s: %llu messages in %s (%llu msg/s, %llu MB/s)\n",
+          mode,
+          received_cnt,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          (unsigned long long) (received_cnt * 1000000LLU / us),
+          (unsigned long long) (received_bytes / us));
+  received_cnt = 0;
+  received_bytes = 0;
+}
+
+
+/**
+ * Tokenize a stream in both modes.
+ *
+ * @param sizes description of the message sizes
+ * @param align passed to make_stream()
+ */
+static void
+perf_stream (const char *sizes,
+             uint16_t align)
+{
+  struct GNUNET_TIME_Absolute start;
+  char mode[64];
+  char *stream;
+  size_t size;
+
+  stream = make_stream (align,
+                        &size);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < ROUNDS; i++)
+    perf_from_buffer (stream,
+                      size);
+  GNUNET_snprintf (mode,
+                   sizeof (mode),
+                   "from_buffer, %s",
+                   sizes);
+  report (mode,
+          start,
+          size);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < ROUNDS; i++)
+    perf_receive_buffer (stream,
+                         size);
+  GNUNET_snprintf (mode,
+                   sizeof (mode),
+                   "receive_buffer, %s",
+                   sizes);
+  report (mode,
+          start,
+          size);
+  GNUNET_free (stream);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  GNUNET_log_setup ("perf-mst",
+                    "WARNING",
+                    NULL);
+  /* messages at unaligned offsets in the buffer of the tokenizer are
+     copied one by one into its scratch buffer; with aligned sizes
+     that never happens, which shows what the copies cost */
+  perf_stream ("unaligned sizes",
+               1);
+  perf_stream ("sizes aligned to 8 bytes",
+               8);
+  return 0;
+}
+
+
+/* end of perf_mst.c */
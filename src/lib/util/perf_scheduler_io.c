@@ -0,0 +1,418 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file util/perf_scheduler_io.c
+ * @brief measure file and socket I/O through the scheduler, comparing
+ *        blocking I/O and readiness notifications with the asynchronous
+ *        operations.  Run with GNUNET_SCHEDULER_DRIVER=io_uring to use
+ *        the io_uring event loop.
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+
+/**
+ * Size of one file block.
+ */
+#define FILE_BLOCK (64 * 1024)
+
+/**
+ * Number of blocks written and read.
+ */
+#define FILE_BLOCKS 256
+
+/**
+ * How many asynchronous file operations do we keep in flight?
+ */
+#define QUEUE_DEPTH 8
+
+/**
+ * Size of the messages exchanged over the socket pair.
+ */
+#define PING_SIZE 64
+
+/**
+ * Number of round trips over the socket pair.
+ */
+#define ROUND_TRIPS 20000
+
+
+static struct GNUNET_DISK_FileHandle *fh;
+
+static char *fn;
+
+static char blocks[QUEUE_DEPTH][FILE_BLOCK];
+
+static unsigned int next_block;
+
+static unsigned int done_blocks;
+
+static int writing;
+
+static struct GNUNET_NETWORK_Handle *sa;
+
+static struct GNUNET_NETWORK_Handle *sb;
+
+static char ping[PING_SIZE];
+
+static char buf_a[PING_SIZE];
+
+static char buf_b[PING_SIZE];
+
+static unsigned int trips;
+
+static int use_async;
+
+static struct GNUNET_SCHEDULER_Task *b_task;
+
+static struct GNUNET_SCHEDULER_AsyncIo *b_aio;
+
+static struct GNUNET_TIME_Absolute start;
+
+
+static void
+report (const char *what,
+        unsigned long long n,
+        const char *unit)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %llu %s in %s (%llu %s/s)\n",
+          what,
+          n,
+          unit,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          n * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us),
+          unit);
+}
+
+
+static void
+run_net (void *cls);
+
+
+static void
+file_io_done (void *cls,
+              ssize_t ret);
+
+
+static void
+submit_block (unsigned int slot)
+{
+  off_t off = (off_t) next_block * FILE_BLOCK;
+
+  next_block++;
+  if (writing)
+    GNUNET_SCHEDULER_file_write_async (fh,
+                                       off,
+                                       blocks[slot],
+                                       FILE_BLOCK,
+                                       &file_io_done,
+                                       (void *) (uintptr_t) slot);
+  else
+    GNUNET_SCHEDULER_file_read_async (fh,
+                                      off,
+                                      blocks[slot],
+                                      FILE_BLOCK,
+                                      &file_io_done,
+                                      (void *) (uintptr_t) slot);
+}
+
+
+static void
+start_file_async (void)
+{
+  next_block = 0;
+  done_blocks = 0;
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < QUEUE_DEPTH; i++)
+    submit_block (i);
+}
+
+
+static void
+file_io_done (void *cls,
+              ssize_t ret)
+{
+  unsigned int slot = (unsigned int) (uintptr_t) cls;
+
+  GNUNET_assert (FILE_BLOCK == ret);
+  done_blocks++;
+  if (next_block < FILE_BLOCKS)
+  {
+    submit_block (slot);
+    return;
+  }
+  if (done_blocks < FILE_BLOCKS)
+    return;
+  report (writing ? "async file write" : "async file read",
+          FILE_BLOCKS * (unsigned long long) FILE_BLOCK / 1024,
+          "KiB");
+  if (writing)
+  {
+    writing = GNUNET_NO;
+    start_file_async ();
+    return;
+  }
+  GNUNET_SCHEDULER_add_now (&run_net,
+                            NULL);
+}
+
+
+static void
+run_file (void *cls)
+{
+  (void) cls;
+  memset (blocks,
+          42,
+          sizeof (blocks));
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < FILE_BLOCKS; i++)
+    GNUNET_assert (FILE_BLOCK ==
+                   GNUNET_DISK_file_write (fh,
+                                           blocks[i % QUEUE_DEPTH],
+                                           FILE_BLOCK));
+  report ("blocking file write",
+          FILE_BLOCKS * (unsigned long long) FILE_BLOCK / 1024,
+          "KiB");
+  GNUNET_assert (0 == GNUNET_DISK_file_seek (fh,
+                                             0,
+                                             GNUNET_DISK_SEEK_SET));
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < FILE_BLOCKS; i++)
+    GNUNET_assert (FILE_BLOCK ==
+                   GNUNET_DISK_file_read (fh,
+                                          blocks[i % QUEUE_DEPTH],
+                                          FILE_BLOCK));
+  report ("blocking file read",
+          FILE_BLOCKS * (unsigned long long) FILE_BLOCK / 1024,
+          "KiB");
+  writing = GNUNET_YES;
+  start_file_async ();
+}
+
+
+static void
+a_send (void);
+
+
+static void
+b_wait (void);
+
+
+static void
+a_received (void *cls,
+            ssize_t ret)
+{
+  (void) cls;
+  GNUNET_assert (PING_SIZE == ret);
+  trips++;
+  if (trips < ROUND_TRIPS)
+  {
+    a_send ();
+    return;
+  }
+  report (use_async ? "async socket round trips" : "select socket round trips",
+          trips,
+          "trips");
+  if (NULL != b_task)
+  {
+    GNUNET_SCHEDULER_cancel (b_task);
+    b_task = NULL;
+  }
+  if (NULL != b_aio)
+  {
+    GNUNET_SCHEDULER_async_io_cancel (b_aio);
+    b_aio = NULL;
+  }
+  if (! use_async)
+  {
+    GNUNET_SCHEDULER_add_now (&run_net,
+                              &use_async);
+    return;
+  }
+  GNUNET_break (GNUNET_OK == GNUNET_NETWORK_socket_close (sa));
+  GNUNET_break (GNUNET_OK == GNUNET_NETWORK_socket_close (sb));
+}
+
+
+static void
+a_readable (void *cls)
+{
+  (void) cls;
+  a_received (NULL,
+              GNUNET_NETWORK_socket_recv (sa,
+                                          buf_a,
+                                          sizeof (buf_a)));
+}
+
+
+static void
+a_sent (void *cls,
+        ssize_t ret)
+{
+  (void) cls;
+  GNUNET_assert (PING_SIZE == ret);
+  if (use_async)
+    GNUNET_SCHEDULER_net_recv_async (sa,
+                                     buf_a,
+                                     sizeof (buf_a),
+                                     &a_received,
+                                     NULL);
+  else
+    GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                   sa,
+                                   &a_readable,
+                                   NULL);
+}
+
+
+static void
+a_send (void)
+{
+  if (use_async)
+  {
+    GNUNET_SCHEDULER_net_send_async (sa,
+                                     ping,
+                                     sizeof (ping),
+                                     &a_sent,
+                                     NULL);
+    return;
+  }
+  a_sent (NULL,
+          GNUNET_NETWORK_socket_send (sa,
+                                      ping,
+                                      sizeof (ping)));
+}
+
+
+static void
+b_sent (void *cls,
+        ssize_t ret)
+{
+  (void) cls;
+  b_aio = NULL;
+  GNUNET_assert (PING_SIZE == ret);
+  b_wait ();
+}
+
+
+static void
+b_received (void *cls,
+            ssize_t ret)
+{
+  (void) cls;
+  b_aio = NULL;
+  GNUNET_assert (PING_SIZE == ret);
+  if (use_async)
+  {
+    b_aio = GNUNET_SCHEDULER_net_send_async (sb,
+                                             buf_b,
+                                             ret,
+                                             &b_sent,
+                                             NULL);
+    return;
+  }
+  b_sent (NULL,
+          GNUNET_NETWORK_socket_send (sb,
+                                      buf_b,
+                                      ret));
+}
+
+
+static void
+b_readable (void *cls)
+{
+  (void) cls;
+  b_task = NULL;
+  b_received (NULL,
+              GNUNET_NETWORK_socket_recv (sb,
+                                          buf_b,
+                                          sizeof (buf_b)));
+}
+
+
+static void
+b_wait (void)
+{
+  if (use_async)
+    b_aio = GNUNET_SCHEDULER_net_recv_async (sb,
+                                             buf_b,
+                                             sizeof (buf_b),
+                                             &b_received,
+                                             NULL);
+  else
+    b_task = GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                            sb,
+                                            &b_readable,
+                                            NULL);
+}
+
+
+static void
+run_net (void *cls)
+{
+  use_async = (NULL != cls);
+  trips = 0;
+  start = GNUNET_TIME_absolute_get ();
+  b_wait ();
+  a_send ();
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  int sv[2];
+
+  GNUNET_log_setup ("perf-scheduler-io",
+                    "WARNING",
+                    NULL);
+  printf ("Using %s event loop\n",
+          (NULL != getenv ("GNUNET_SCHEDULER_DRIVER"))
+          ? getenv ("GNUNET_SCHEDULER_DRIVER")
+          : "select");
+  fn = GNUNET_DISK_mktemp ("perf-scheduler-io");
+  GNUNET_assert (NULL != fn);
+  fh = GNUNET_DISK_file_open (fn,
+                              GNUNET_DISK_OPEN_READWRITE
+                              | GNUNET_DISK_OPEN_TRUNCATE,
+                              GNUNET_DISK_PERM_USER_READ
+                              | GNUNET_DISK_PERM_USER_WRITE);
+  GNUNET_assert (NULL != fh);
+  GNUNET_assert (0 == socketpair (AF_UNIX,
+                                  SOCK_STREAM,
+                                  0,
+                                  sv));
+  sa = GNUNET_NETWORK_socket_box_native (sv[0]);
+  sb = GNUNET_NETWORK_socket_box_native (sv[1]);
+  GNUNET_SCHEDULER_run (&run_file,
+                        NULL);
+  GNUNET_break (GNUNET_OK == GNUNET_DISK_file_close (fh));
+  GNUNET_break (0 == unlink (fn));
+  GNUNET_free (fn);
+  return 0;
+}
+
+
+/* end of perf_scheduler_io.c */
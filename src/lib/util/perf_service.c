@@ -0,0 +1,254 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file util/perf_service.c
+ * @brief measure how fast a service processes a burst of small
+ *        messages from a client, with and without
+ *        #GNUNET_SERVICE_OPTION_INLINE_CONTINUE; the client writes
+ *        all messages at once from another thread, so that we only
+ *        measure the service
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include <pthread.h>
+
+/**
+ * Message type we use for testing.
+ */
+#define MY_TYPE 256
+
+/**
+ * Number of messages the client sends.
+ */
+#define NUM_MESSAGES 100000
+
+/**
+ * Every how many messages does the handler continue later
+ * instead of right away?
+ */
+#define ASYNC_EVERY 1000
+
+
+GNUNET_NETWORK_STRUCT_BEGIN
+
+struct MyMessage
+{
+  struct GNUNET_MessageHeader header;
+  uint32_t x GNUNET_PACKED;
+};
+
+GNUNET_NETWORK_STRUCT_END
+
+
+static struct MyMessage burst[NUM_MESSAGES];
+
+static pthread_t writer;
+
+static struct GNUNET_TIME_Absolute start;
+
+static unsigned int received;
+
+static int global_ret;
+
+
+/**
+ * Continue a client later, as a handler waiting for another
+ * subsystem would.
+ *
+ * @param cls the `struct GNUNET_SERVICE_Client`
+ */
+static void
+continue_later (void *cls)
+{
+  struct GNUNET_SERVICE_Client *client = cls;
+
+  GNUNET_SERVICE_client_continue (client);
+}
+
+
+static void
+handle_my (void *cls,
+           const struct MyMessage *msg)
+{
+  struct GNUNET_SERVICE_Client *client = cls;
+
+  if (received != ntohl (msg->x))
+  {
+    GNUNET_break (0);
+    global_ret = 1;
+  }
+  received++;
+  if (0 == received % ASYNC_EVERY)
+    (void) GNUNET_SCHEDULER_add_now (&continue_later,
+                                     client);
+  else
+    GNUNET_SERVICE_client_continue (client);
+}
+
+
+static void *
+connect_cb (void *cls,
+            struct GNUNET_SERVICE_Client *c,
+            struct GNUNET_MQ_Handle *mq_)
+{
+  start = GNUNET_TIME_absolute_get ();
+  return c;
+}
+
+
+static void
+disconnect_cb (void *cls,
+               struct GNUNET_SERVICE_Client *c,
+               void *internal_cls)
+{
+  const char *mode = cls;
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %u messages in %s (%llu/s)\n",
+          mode,
+          received,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          received * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+  if (NUM_MESSAGES != received)
+    global_ret = 1;
+  GNUNET_assert (0 == pthread_join (writer,
+                                    NULL));
+  GNUNET_SCHEDULER_shutdown ();
+}
+
+
+/**
+ * Connect to the service and write all messages at once.
+ *
+ * @param cls the port of the service
+ * @return NULL
+ */
+static void *
+write_burst (void *cls)
+{
+  const unsigned long long *port = cls;
+  struct sockaddr_in sa = {
+    .sin_family = AF_INET,
+    .sin_port = htons ((uint16_t) *port),
+    .sin_addr.s_addr = htonl (INADDR_LOOPBACK)
+  };
+  const char *pos = (const char *) burst;
+  size_t left = sizeof (burst);
+  int fd;
+
+  fd = socket (AF_INET,
+               SOCK_STREAM,
+               0);
+  GNUNET_assert (-1 != fd);
+  GNUNET_assert (0 == connect (fd,
+                               (const struct sockaddr *) &sa,
+                               sizeof (sa)));
+  while (left > 0)
+  {
+    ssize_t ret = send (fd,
+                        pos,
+                        left,
+                        0);
+
+    GNUNET_assert (ret > 0);
+    pos += ret;
+    left -= ret;
+  }
+  GNUNET_break (0 == close (fd));
+  return NULL;
+}
+
+
+static void
+service_init (void *cls,
+              const struct GNUNET_CONFIGURATION_Handle *cfg,
+              struct GNUNET_SERVICE_Handle *sh)
+{
+  static unsigned long long port;
+
+  received = 0;
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONFIGURATION_get_value_number (cfg,
+                                                        "test_service",
+                                                        "PORT",
+                                                        &port));
+  GNUNET_assert (0 == pthread_create (&writer,
+                                      NULL,
+                                      &write_burst,
+                                      &port));
+}
+
+
+static void
+run (const char *mode,
+     enum GNUNET_SERVICE_Options options)
+{
+  struct GNUNET_MQ_MessageHandler handlers[] = {
+    GNUNET_MQ_hd_fixed_size (my,
+                             MY_TYPE,
+                             struct MyMessage,
+                             NULL),
+    GNUNET_MQ_handler_end ()
+  };
+  char *const argv[] = {
+    (char *) "perf_service",
+    (char *) "-c", (char *) "test_service_data.conf",
+    NULL
+  };
+
+  GNUNET_assert (0 ==
+                 GNUNET_SERVICE_run_ (3,
+                                      argv,
+                                      "test_service",
+                                      options,
+                                      &service_init,
+                                      &connect_cb,
+                                      &disconnect_cb,
+                                      (void *) mode,
+                                      handlers));
+}
+
+
+int
+main (int argc,
+      char *argv[])
+{
+  GNUNET_log_setup ("perf-service",
+                    "WARNING",
+                    NULL);
+  for (unsigned int i = 0; i < NUM_MESSAGES; i++)
+  {
+    burst[i].header.size = htons (sizeof (struct MyMessage));
+    burst[i].header.type = htons (MY_TYPE);
+    burst[i].x = htonl (i);
+  }
+  run ("continue in new task",
+       GNUNET_SERVICE_OPTION_NONE);
+  run ("continue inline",
+       GNUNET_SERVICE_OPTION_INLINE_CONTINUE);
+  return global_ret;
+}
+
+
+/* end of perf_service.c */
@@ -0,0 +1,125 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file util/perf_strings.c
+ * @brief measure UTF-8 normalization and case mapping of labels,
+ *        as GNS and the namestore do for every name they handle
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+
+/**
+ * How many labels do we process per mode?
+ */
+#define ROUNDS (1024 * 1024)
+
+
+/**
+ * Labels we process, from the common case to the rare one.
+ */
+static const struct
+{
+  const char *kind;
+  const char *label;
+} labels[] = {
+  { "ASCII", "www-mirror42" },
+  { "Latin-1", "b\xc3\xbc" "cher-caf\xc3\xa9" },
+  { "Greek", "\xce\xb4\xce\xbf\xce\xba\xce\xb9\xce\xbc\xce\xae" },
+  { "decomposed", "cafe\xcc\x81" }
+};
+
+
+static void
+report (const char *mode,
+        const char *kind,
+        struct GNUNET_TIME_Absolute start)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s, %s: %u labels in %s (%llu/s)\n",
+          mode,
+          kind,
+          ROUNDS,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          ROUNDS * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  struct GNUNET_TIME_Absolute start;
+  char buf[256];
+  size_t len;
+  size_t total;
+
+  GNUNET_log_setup ("perf-strings",
+                    "WARNING",
+                    NULL);
+  total = 0;
+  for (unsigned int l = 0; l < sizeof (labels) / sizeof (labels[0]); l++)
+  {
+    start = GNUNET_TIME_absolute_get ();
+    for (unsigned int i = 0; i < ROUNDS; i++)
+    {
+      char *norm;
+
+      norm = GNUNET_STRINGS_utf8_normalize (labels[l].label);
+      GNUNET_assert (NULL != norm);
+      total += strlen (norm);
+      GNUNET_free (norm);
+    }
+    report ("normalize",
+            labels[l].kind,
+            start);
+    start = GNUNET_TIME_absolute_get ();
+    for (unsigned int i = 0; i < ROUNDS; i++)
+    {
+      len = sizeof (buf);
+      GNUNET_assert (GNUNET_OK ==
+                     GNUNET_STRINGS_utf8_normalize_buf (labels[l].label,
+                                                        buf,
+                                                        &len));
+      total += len;
+    }
+    report ("normalize into buffer",
+            labels[l].kind,
+            start);
+    start = GNUNET_TIME_absolute_get ();
+    for (unsigned int i = 0; i < ROUNDS; i++)
+    {
+      GNUNET_assert (GNUNET_OK ==
+                     GNUNET_STRINGS_utf8_tolower (labels[l].label,
+                                                  buf));
+      total += strlen (buf);
+    }
+    report ("lower case",
+            labels[l].kind,
+            start);
+  }
+  return (0 == total) ? 1 : 0;
+}
+
+
+/* end of perf_strings.c */
@@ -25,6 +25,7 @@
 
 #include "platform.h"
 #include "gnunet_util_lib.h"
+#include "scheduler_uring.h"
 // DEBUG
 #include <inttypes.h>
 
@@ -732,6 +733,11 @@ GNUNET_SCHEDULER_run (GNUNET_SCHEDULER_TaskCallback task,
     .timeout = GNUNET_TIME_absolute_get ()
   };
 
+  if ((NULL == scheduler_select) &&
+      (GNUNET_OK ==
+       GNUNET_SCHEDULER_uring_run_ (task,
+                                    task_cls)))
+    return;
   driver = GNUNET_SCHEDULER_driver_select ();
   driver->cls = &context;
   sh = GNUNET_SCHEDULER_driver_init (driver);
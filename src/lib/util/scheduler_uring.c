@@ -0,0 +1,1185 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file util/scheduler_uring.c
+ * @brief io_uring based event loop for the scheduler, and asynchronous
+ *        file and socket I/O that completes into scheduler tasks
+ *
+ * The ring is driven with the raw system calls so that we do not
+ * depend on liburing.  If the kernel (or a seccomp policy) does not
+ * allow io_uring, or the loop was not requested, the scheduler keeps
+ * using select() and the asynchronous operations are emulated with
+ * ordinary tasks.
+ */
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "scheduler_uring.h"
+
+#if HAVE_LINUX_IO_URING_H
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <signal.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define USE_IO_URING 1
+#endif
+#endif
+#ifndef USE_IO_URING
+#define USE_IO_URING 0
+#endif
+
+#define LOG(kind, ...) GNUNET_log_from (kind, "util-scheduler-uring", \
+                                        __VA_ARGS__)
+
+#define LOG_STRERROR(kind, syscall) \
+  GNUNET_log_from_strerror (kind, "util-scheduler-uring", syscall)
+
+
+/**
+ * Type of an asynchronous operation.
+ */
+enum AsyncIoType
+{
+  AIO_FILE_READ,
+  AIO_FILE_WRITE,
+  AIO_NET_RECV,
+  AIO_NET_SEND
+};
+
+
+/**
+ * What kind of object is referenced by the user data of a
+ * submission.  Must be the first member of those objects.
+ */
+enum UringKind
+{
+  UK_POLL,
+  UK_IO
+};
+
+
+/**
+ * An asynchronous read or write operation.
+ */
+struct GNUNET_SCHEDULER_AsyncIo
+{
+  /**
+   * Always #UK_IO.
+   */
+  enum UringKind kind;
+
+  /**
+   * What to do.
+   */
+  enum AsyncIoType type;
+
+  /**
+   * File handle for file operations.
+   */
+  const struct GNUNET_DISK_FileHandle *fh;
+
+  /**
+   * Socket for network operations.
+   */
+  struct GNUNET_NETWORK_Handle *sock;
+
+  /**
+   * Where to read from or write to in the file, -1 for the
+   * current position.
+   */
+  off_t offset;
+
+  /**
+   * Buffer to read into or write from.
+   */
+  char *buf;
+
+  /**
+   * Size of @e buf.
+   */
+  size_t len;
+
+  /**
+   * Function to call with the result.
+   */
+  GNUNET_SCHEDULER_AsyncIoCallback cb;
+
+  /**
+   * Closure for @e cb.
+   */
+  void *cb_cls;
+
+  /**
+   * Task that performs the operation (without io_uring), keeps the
+   * scheduler alive while the kernel works on it, or reports the
+   * completion.
+   */
+  struct GNUNET_SCHEDULER_Task *task;
+
+  /**
+   * Result to report.
+   */
+  ssize_t result;
+
+  /**
+   * errno to report if @e result is -1.
+   */
+  int error;
+
+  /**
+   * Was the operation submitted to the ring and we are still waiting
+   * for its completion?
+   */
+  bool in_kernel;
+};
+
+
+/**
+ * Complete @a aio by calling its callback from a task.
+ *
+ * @param cls the `struct GNUNET_SCHEDULER_AsyncIo`
+ */
+static void
+complete_io (void *cls)
+{
+  struct GNUNET_SCHEDULER_AsyncIo *aio = cls;
+  GNUNET_SCHEDULER_AsyncIoCallback cb = aio->cb;
+  void *cb_cls = aio->cb_cls;
+  ssize_t result = aio->result;
+  int error = aio->error;
+
+  aio->task = NULL;
+  GNUNET_free (aio);
+  errno = error;
+  cb (cb_cls,
+      result);
+}
+
+
+#if USE_IO_URING
+
+/**
+ * Number of submission queue entries of the ring.
+ */
+#define RING_ENTRIES 256
+
+
+/**
+ * An event the io_uring driver is waiting for on behalf of a task.
+ */
+struct UringPoll
+{
+  /**
+   * Always #UK_POLL.
+   */
+  enum UringKind kind;
+
+  /**
+   * Kept in a DLL.
+   */
+  struct UringPoll *prev;
+
+  /**
+   * Kept in a DLL.
+   */
+  struct UringPoll *next;
+
+  /**
+   * The task the event is related to.
+   */
+  struct GNUNET_SCHEDULER_Task *task;
+
+  /**
+   * Information about the file descriptor.
+   */
+  struct GNUNET_SCHEDULER_FdInfo *fdi;
+
+  /**
+   * The event types the task waits for.
+   */
+  enum GNUNET_SCHEDULER_EventType et;
+
+  /**
+   * Did the kernel report the event already?
+   */
+  bool fired;
+
+  /**
+   * Was the task deleted while the poll was still armed?  Then we
+   * free this entry when the kernel reports the cancellation.
+   */
+  bool cancelled;
+};
+
+
+/**
+ * State of the io_uring event loop.
+ */
+struct UringContext
+{
+  /**
+   * File descriptor of the ring.
+   */
+  int fd;
+
+  /**
+   * Mapping of the submission queue ring.
+   */
+  void *sq_ptr;
+
+  /**
+   * Size of @e sq_ptr.
+   */
+  size_t sq_len;
+
+  /**
+   * Mapping of the completion queue ring, may be @e sq_ptr.
+   */
+  void *cq_ptr;
+
+  /**
+   * Size of @e cq_ptr.
+   */
+  size_t cq_len;
+
+  /**
+   * Submission queue entries.
+   */
+  struct io_uring_sqe *sqes;
+
+  /**
+   * Size of the mapping of @e sqes.
+   */
+  size_t sqes_len;
+
+  unsigned int *sq_head;
+
+  unsigned int *sq_tail;
+
+  unsigned int *sq_mask;
+
+  unsigned int *sq_entries;
+
+  unsigned int *sq_array;
+
+  unsigned int *cq_head;
+
+  unsigned int *cq_tail;
+
+  unsigned int *cq_mask;
+
+  struct io_uring_cqe *cqes;
+
+  /**
+   * Our tail of the submission queue, published to the kernel
+   * in #ring_enter().
+   */
+  unsigned int sq_tail_local;
+
+  /**
+   * Events we are waiting for (or that fired and were not yet deleted).
+   */
+  struct UringPoll *poll_head;
+
+  /**
+   * Events we are waiting for (or that fired and were not yet deleted).
+   */
+  struct UringPoll *poll_tail;
+
+  /**
+   * When the scheduler wants to wake up next.
+   */
+  struct GNUNET_TIME_Absolute timeout;
+
+  /**
+   * Number of submissions with user data whose completion we
+   * still expect.
+   */
+  unsigned int inflight;
+
+  /**
+   * Number of asynchronous operations submitted and not cancelled.
+   */
+  unsigned int io_active;
+
+  /**
+   * Operation #GNUNET_SCHEDULER_async_io_cancel() waits for.
+   */
+  struct GNUNET_SCHEDULER_AsyncIo *cancel_target;
+};
+
+
+/**
+ * The ring of the running io_uring event loop, NULL if the scheduler
+ * uses select().
+ */
+static struct UringContext *active_ring;
+
+
+/**
+ * Publish queued submissions and optionally wait for completions.
+ *
+ * @param ctx ring to use
+ * @param wait #GNUNET_YES to wait for at least one completion
+ * @param timeout how long to wait at most
+ * @return #GNUNET_OK on success (including timeouts and signals)
+ */
+static enum GNUNET_GenericReturnValue
+ring_enter (struct UringContext *ctx,
+            int wait,
+            struct GNUNET_TIME_Relative timeout)
+{
+  struct io_uring_getevents_arg arg;
+  struct __kernel_timespec ts;
+  unsigned int to_submit;
+  long ret;
+
+  __atomic_store_n (ctx->sq_tail,
+                    ctx->sq_tail_local,
+                    __ATOMIC_RELEASE);
+  to_submit = ctx->sq_tail_local - __atomic_load_n (ctx->sq_head,
+                                                    __ATOMIC_ACQUIRE);
+  if ((0 == to_submit) &&
+      (GNUNET_YES != wait))
+    return GNUNET_OK;
+  memset (&arg,
+          0,
+          sizeof (arg));
+  arg.sigmask_sz = _NSIG / 8;
+  if (! GNUNET_TIME_relative_is_forever (timeout))
+  {
+    ts.tv_sec = timeout.rel_value_us / GNUNET_TIME_UNIT_SECONDS.rel_value_us;
+    ts.tv_nsec = (timeout.rel_value_us
+                  % GNUNET_TIME_UNIT_SECONDS.rel_value_us) * 1000;
+    arg.ts = (uint64_t) (uintptr_t) &ts;
+  }
+  ret = syscall (__NR_io_uring_enter,
+                 ctx->fd,
+                 to_submit,
+                 (GNUNET_YES == wait) ? 1 : 0,
+                 (GNUNET_YES == wait)
+                 ? IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG
+                 : 0,
+                 (GNUNET_YES == wait) ? &arg : NULL,
+                 (GNUNET_YES == wait) ? sizeof (arg) : 0);
+  if ((ret < 0) &&
+      (EINTR != errno) &&
+      (ETIME != errno) &&
+      (EBUSY != errno) &&
+      (EAGAIN != errno))
+  {
+    LOG_STRERROR (GNUNET_ERROR_TYPE_ERROR,
+                  "io_uring_enter");
+    return GNUNET_SYSERR;
+  }
+  return GNUNET_OK;
+}
+
+
+/**
+ * Obtain a free submission queue entry, flushing the queue to
+ * the kernel if it is full.
+ *
+ * @param ctx ring to use
+ * @return cleared entry
+ */
+static struct io_uring_sqe *
+ring_get_sqe (struct UringContext *ctx)
+{
+  struct io_uring_sqe *sqe;
+  unsigned int idx;
+
+  while (ctx->sq_tail_local - __atomic_load_n (ctx->sq_head,
+                                               __ATOMIC_ACQUIRE)
+         >= *ctx->sq_entries)
+    GNUNET_assert (GNUNET_OK ==
+                   ring_enter (ctx,
+                               GNUNET_NO,
+                               GNUNET_TIME_UNIT_ZERO));
+  idx = ctx->sq_tail_local & *ctx->sq_mask;
+  sqe = &ctx->sqes[idx];
+  memset (sqe,
+          0,
+          sizeof (*sqe));
+  ctx->sq_array[idx] = idx;
+  ctx->sq_tail_local++;
+  return sqe;
+}
+
+
+/**
+ * Queue a request to cancel the submission with @a user_data.
+ *
+ * @param ctx ring to use
+ * @param opcode #IORING_OP_POLL_REMOVE or #IORING_OP_ASYNC_CANCEL
+ * @param user_data user data of the submission to cancel
+ */
+static void
+ring_cancel (struct UringContext *ctx,
+             uint8_t opcode,
+             void *user_data)
+{
+  struct io_uring_sqe *sqe;
+
+  sqe = ring_get_sqe (ctx);
+  sqe->opcode = opcode;
+  sqe->fd = -1;
+  sqe->addr = (uint64_t) (uintptr_t) user_data;
+  /* completion of the cancellation itself is ignored */
+  sqe->user_data = 0;
+}
+
+
+/**
+ * Submit @a aio to the ring.
+ *
+ * @param ctx ring to use
+ * @param aio operation to submit
+ */
+static void
+ring_submit_io (struct UringContext *ctx,
+                struct GNUNET_SCHEDULER_AsyncIo *aio)
+{
+  struct io_uring_sqe *sqe;
+
+  sqe = ring_get_sqe (ctx);
+  switch (aio->type)
+  {
+  case AIO_FILE_READ:
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = aio->fh->fd;
+    sqe->off = (-1 == aio->offset) ? (uint64_t) -1 : (uint64_t) aio->offset;
+    break;
+  case AIO_FILE_WRITE:
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = aio->fh->fd;
+    sqe->off = (-1 == aio->offset) ? (uint64_t) -1 : (uint64_t) aio->offset;
+    break;
+  case AIO_NET_RECV:
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = GNUNET_NETWORK_get_fd (aio->sock);
+    break;
+  case AIO_NET_SEND:
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = GNUNET_NETWORK_get_fd (aio->sock);
+#ifdef MSG_NOSIGNAL
+    sqe->msg_flags = MSG_NOSIGNAL;
+#endif
+    break;
+  }
+  sqe->addr = (uint64_t) (uintptr_t) aio->buf;
+  sqe->len = aio->len;
+  sqe->user_data = (uint64_t) (uintptr_t) aio;
+  aio->in_kernel = true;
+  ctx->inflight++;
+  ctx->io_active++;
+}
+
+
+/**
+ * Process one completion.
+ *
+ * @param ctx ring the completion is from
+ * @param cqe the completion
+ */
+static void
+handle_cqe (struct UringContext *ctx,
+            const struct io_uring_cqe *cqe)
+{
+  enum UringKind *kind = (enum UringKind *) (uintptr_t) cqe->user_data;
+
+  if (NULL == kind)
+    return; /* completion of a cancellation request */
+  GNUNET_assert (ctx->inflight > 0);
+  ctx->inflight--;
+  switch (*kind)
+  {
+  case UK_POLL:
+    {
+      struct UringPoll *up = (struct UringPoll *) kind;
+
+      if (up->cancelled)
+      {
+        GNUNET_free (up);
+        return;
+      }
+      if (cqe->res < 0)
+        LOG (GNUNET_ERROR_TYPE_WARNING,
+             "poll on %d failed: %s\n",
+             up->fdi->sock,
+             strerror (-cqe->res));
+      /* like select(), report errors and hang-ups as readiness and
+         let the task find out */
+      if ((0 != (GNUNET_SCHEDULER_ET_IN & up->et)) &&
+          ((cqe->res < 0) ||
+           (0 != (cqe->res & (POLLIN | POLLHUP | POLLERR)))))
+        up->fdi->et |= GNUNET_SCHEDULER_ET_IN;
+      if ((0 != (GNUNET_SCHEDULER_ET_OUT & up->et)) &&
+          ((cqe->res < 0) ||
+           (0 != (cqe->res & (POLLOUT | POLLHUP | POLLERR)))))
+        up->fdi->et |= GNUNET_SCHEDULER_ET_OUT;
+      up->fired = true;
+      GNUNET_SCHEDULER_task_ready (up->task,
+                                   up->fdi);
+      return;
+    }
+  case UK_IO:
+    {
+      struct GNUNET_SCHEDULER_AsyncIo *aio
+        = (struct GNUNET_SCHEDULER_AsyncIo *) kind;
+
+      aio->in_kernel = false;
+      if (aio == ctx->cancel_target)
+      {
+        ctx->cancel_target = NULL;
+        GNUNET_free (aio);
+        return;
+      }
+      GNUNET_assert (ctx->io_active > 0);
+      ctx->io_active--;
+      if (cqe->res < 0)
+      {
+        aio->result = -1;
+        aio->error = -cqe->res;
+      }
+      else
+      {
+        aio->result = cqe->res;
+        aio->error = 0;
+      }
+      GNUNET_SCHEDULER_cancel (aio->task);
+      aio->task = GNUNET_SCHEDULER_add_now (&complete_io,
+                                            aio);
+      return;
+    }
+  }
+  GNUNET_assert (0);
+}
+
+
+/**
+ * Process all available completions.
+ *
+ * @param ctx ring to reap
+ */
+static void
+ring_reap (struct UringContext *ctx)
+{
+  unsigned int head;
+
+  head = *ctx->cq_head;
+  while (head != __atomic_load_n (ctx->cq_tail,
+                                  __ATOMIC_ACQUIRE))
+  {
+    struct io_uring_cqe cqe;
+
+    cqe = ctx->cqes[head & *ctx->cq_mask];
+    head++;
+    /* release the slot before handling, handlers may enter the ring */
+    __atomic_store_n (ctx->cq_head,
+                      head,
+                      __ATOMIC_RELEASE);
+    handle_cqe (ctx,
+                &cqe);
+  }
+}
+
+
+/**
+ * Unmap and close the ring.
+ *
+ * @param ctx ring to tear down
+ */
+static void
+ring_teardown (struct UringContext *ctx)
+{
+  if ((NULL != ctx->sqes) &&
+      (MAP_FAILED != (void *) ctx->sqes))
+    munmap (ctx->sqes,
+            ctx->sqes_len);
+  if ((NULL != ctx->cq_ptr) &&
+      (MAP_FAILED != ctx->cq_ptr) &&
+      (ctx->cq_ptr != ctx->sq_ptr))
+    munmap (ctx->cq_ptr,
+            ctx->cq_len);
+  if ((NULL != ctx->sq_ptr) &&
+      (MAP_FAILED != ctx->sq_ptr))
+    munmap (ctx->sq_ptr,
+            ctx->sq_len);
+  GNUNET_break (0 == close (ctx->fd));
+}
+
+
+/**
+ * Create the ring and map its queues.
+ *
+ * @param ctx ring to set up
+ * @return #GNUNET_OK on success, #GNUNET_SYSERR if io_uring is not
+ *         available or lacks the features we need
+ */
+static enum GNUNET_GenericReturnValue
+ring_setup (struct UringContext *ctx)
+{
+  struct io_uring_params p;
+  char *sq;
+  char *cq;
+
+  memset (&p,
+          0,
+          sizeof (p));
+  ctx->fd = syscall (__NR_io_uring_setup,
+                     RING_ENTRIES,
+                     &p);
+  if (ctx->fd < 0)
+  {
+    LOG_STRERROR (GNUNET_ERROR_TYPE_INFO,
+                  "io_uring_setup");
+    return GNUNET_SYSERR;
+  }
+  if (0 == (p.features & IORING_FEAT_EXT_ARG))
+  {
+    /* need Linux 5.11 for waiting with a timeout */
+    LOG (GNUNET_ERROR_TYPE_INFO,
+         "io_uring lacks IORING_FEAT_EXT_ARG\n");
+    GNUNET_break (0 == close (ctx->fd));
+    return GNUNET_SYSERR;
+  }
+  ctx->sq_len = p.sq_off.array + p.sq_entries * sizeof (unsigned int);
+  ctx->cq_len = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+  if (0 != (p.features & IORING_FEAT_SINGLE_MMAP))
+  {
+    ctx->sq_len = GNUNET_MAX (ctx->sq_len,
+                              ctx->cq_len);
+    ctx->cq_len = ctx->sq_len;
+  }
+  ctx->sq_ptr = mmap (NULL,
+                      ctx->sq_len,
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE,
+                      ctx->fd,
+                      IORING_OFF_SQ_RING);
+  if (MAP_FAILED == ctx->sq_ptr)
+    goto fail;
+  if (0 != (p.features & IORING_FEAT_SINGLE_MMAP))
+    ctx->cq_ptr = ctx->sq_ptr;
+  else
+    ctx->cq_ptr = mmap (NULL,
+                        ctx->cq_len,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE,
+                        ctx->fd,
+                        IORING_OFF_CQ_RING);
+  if (MAP_FAILED == ctx->cq_ptr)
+    goto fail;
+  ctx->sqes_len = p.sq_entries * sizeof (struct io_uring_sqe);
+  ctx->sqes = mmap (NULL,
+                    ctx->sqes_len,
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE,
+                    ctx->fd,
+                    IORING_OFF_SQES);
+  if (MAP_FAILED == (void *) ctx->sqes)
+    goto fail;
+  sq = ctx->sq_ptr;
+  cq = ctx->cq_ptr;
+  ctx->sq_head = (unsigned int *) (sq + p.sq_off.head);
+  ctx->sq_tail = (unsigned int *) (sq + p.sq_off.tail);
+  ctx->sq_mask = (unsigned int *) (sq + p.sq_off.ring_mask);
+  ctx->sq_entries = (unsigned int *) (sq + p.sq_off.ring_entries);
+  ctx->sq_array = (unsigned int *) (sq + p.sq_off.array);
+  ctx->cq_head = (unsigned int *) (cq + p.cq_off.head);
+  ctx->cq_tail = (unsigned int *) (cq + p.cq_off.tail);
+  ctx->cq_mask = (unsigned int *) (cq + p.cq_off.ring_mask);
+  ctx->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+  ctx->sq_tail_local = *ctx->sq_tail;
+  return GNUNET_OK;
+fail:
+  LOG_STRERROR (GNUNET_ERROR_TYPE_WARNING,
+                "mmap");
+  ring_teardown (ctx);
+  return GNUNET_SYSERR;
+}
+
+
+static int
+uring_add (void *cls,
+           struct GNUNET_SCHEDULER_Task *task,
+           struct GNUNET_SCHEDULER_FdInfo *fdi)
+{
+  struct UringContext *ctx = cls;
+  struct UringPoll *up;
+  struct io_uring_sqe *sqe;
+  uint32_t mask;
+
+  GNUNET_assert (NULL != task);
+  GNUNET_assert (NULL != fdi);
+  GNUNET_assert (0 != (GNUNET_SCHEDULER_ET_IN & fdi->et) ||
+                 0 != (GNUNET_SCHEDULER_ET_OUT & fdi->et));
+  if (! ((NULL != fdi->fd) ^ (NULL != fdi->fh)) || (fdi->sock < 0))
+  {
+    /* exactly one out of {fd, hf} must be != NULL and the OS handle must be valid */
+    return GNUNET_SYSERR;
+  }
+  up = GNUNET_new (struct UringPoll);
+  up->kind = UK_POLL;
+  up->task = task;
+  up->fdi = fdi;
+  up->et = fdi->et;
+  mask = 0;
+  if (0 != (GNUNET_SCHEDULER_ET_IN & fdi->et))
+    mask |= POLLIN;
+  if (0 != (GNUNET_SCHEDULER_ET_OUT & fdi->et))
+    mask |= POLLOUT;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  /* poll32_events is word-reversed on big endian */
+  mask = (mask << 16) | (mask >> 16);
+#endif
+  sqe = ring_get_sqe (ctx);
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fdi->sock;
+  sqe->poll32_events = mask;
+  sqe->user_data = (uint64_t) (uintptr_t) up;
+  ctx->inflight++;
+  GNUNET_CONTAINER_DLL_insert (ctx->poll_head,
+                               ctx->poll_tail,
+                               up);
+  return GNUNET_OK;
+}
+
+
+static int
+uring_del (void *cls,
+           struct GNUNET_SCHEDULER_Task *task)
+{
+  struct UringContext *ctx = cls;
+  struct UringPoll *pos;
+  int ret;
+
+  ret = GNUNET_SYSERR;
+  pos = ctx->poll_head;
+  while (NULL != pos)
+  {
+    struct UringPoll *next = pos->next;
+
+    if (pos->task == task)
+    {
+      GNUNET_CONTAINER_DLL_remove (ctx->poll_head,
+                                   ctx->poll_tail,
+                                   pos);
+      if (pos->fired)
+      {
+        GNUNET_free (pos);
+      }
+      else
+      {
+        /* freed once the kernel confirms the removal */
+        pos->cancelled = true;
+        ring_cancel (ctx,
+                     IORING_OP_POLL_REMOVE,
+                     pos);
+      }
+      ret = GNUNET_OK;
+    }
+    pos = next;
+  }
+  return ret;
+}
+
+
+static void
+uring_set_wakeup (void *cls,
+                  struct GNUNET_TIME_Absolute dt)
+{
+  struct UringContext *ctx = cls;
+
+  ctx->timeout = dt;
+}
+
+
+/**
+ * Main loop of the io_uring event loop.
+ *
+ * @param sh scheduler handle
+ * @param ctx ring to use
+ * @return #GNUNET_OK on success
+ */
+static enum GNUNET_GenericReturnValue
+uring_loop (struct GNUNET_SCHEDULER_Handle *sh,
+            struct UringContext *ctx)
+{
+  int more = GNUNET_YES;
+
+  while ((NULL != ctx->poll_head) ||
+         (! GNUNET_TIME_absolute_is_never (ctx->timeout)) ||
+         (ctx->io_active > 0))
+  {
+    struct GNUNET_TIME_Relative remaining;
+
+    remaining = GNUNET_TIME_absolute_get_remaining (ctx->timeout);
+    if (GNUNET_YES == more)
+      remaining = GNUNET_TIME_UNIT_ZERO;
+    if (GNUNET_OK !=
+        ring_enter (ctx,
+                    GNUNET_TIME_relative_is_zero (remaining)
+                    ? GNUNET_NO
+                    : GNUNET_YES,
+                    remaining))
+      return GNUNET_SYSERR;
+    ring_reap (ctx);
+    more = GNUNET_SCHEDULER_do_work (sh);
+  }
+  return GNUNET_OK;
+}
+
+
+enum GNUNET_GenericReturnValue
+GNUNET_SCHEDULER_uring_run_ (GNUNET_SCHEDULER_TaskCallback task,
+                             void *task_cls)
+{
+  struct GNUNET_SCHEDULER_Handle *sh;
+  struct GNUNET_SCHEDULER_Driver driver;
+  struct UringContext *ctx;
+  const char *want;
+
+  want = getenv ("GNUNET_SCHEDULER_DRIVER");
+  if ((NULL == want) ||
+      (0 != strcasecmp (want,
+                        "io_uring")))
+    return GNUNET_SYSERR;
+  ctx = GNUNET_new (struct UringContext);
+  if (GNUNET_OK != ring_setup (ctx))
+  {
+    LOG (GNUNET_ERROR_TYPE_WARNING,
+         "io_uring not available, falling back to select()\n");
+    GNUNET_free (ctx);
+    return GNUNET_SYSERR;
+  }
+  ctx->timeout = GNUNET_TIME_absolute_get ();
+  memset (&driver,
+          0,
+          sizeof (driver));
+  driver.cls = ctx;
+  driver.add = &uring_add;
+  driver.del = &uring_del;
+  driver.set_wakeup = &uring_set_wakeup;
+  active_ring = ctx;
+  sh = GNUNET_SCHEDULER_driver_init (&driver);
+  GNUNET_SCHEDULER_add_with_reason_and_priority (task,
+                                                 task_cls,
+                                                 GNUNET_SCHEDULER_REASON_STARTUP,
+                                                 GNUNET_SCHEDULER_PRIORITY_DEFAULT);
+  GNUNET_break (GNUNET_OK ==
+                uring_loop (sh,
+                            ctx));
+  GNUNET_SCHEDULER_driver_done (sh);
+  /* collect the completions of cancelled polls before freeing them */
+  while (ctx->inflight > 0)
+  {
+    if (GNUNET_OK !=
+        ring_enter (ctx,
+                    GNUNET_YES,
+                    GNUNET_TIME_UNIT_FOREVER_REL))
+      break;
+    ring_reap (ctx);
+  }
+  active_ring = NULL;
+  ring_teardown (ctx);
+  GNUNET_free (ctx);
+  return GNUNET_OK;
+}
+
+
+#else
+
+
+enum GNUNET_GenericReturnValue
+GNUNET_SCHEDULER_uring_run_ (GNUNET_SCHEDULER_TaskCallback task,
+                             void *task_cls)
+{
+  if (NULL != getenv ("GNUNET_SCHEDULER_DRIVER"))
+    LOG (GNUNET_ERROR_TYPE_WARNING,
+         "io_uring not supported by this build, using select()\n");
+  return GNUNET_SYSERR;
+}
+
+
+#endif
+
+
+/**
+ * Perform @a aio without io_uring.  Called once the file descriptor
+ * is ready (for network operations) or right away (for files).
+ *
+ * @param cls the `struct GNUNET_SCHEDULER_AsyncIo`
+ */
+static void
+fallback_io (void *cls)
+{
+  struct GNUNET_SCHEDULER_AsyncIo *aio = cls;
+  ssize_t ret;
+
+  aio->task = NULL;
+  switch (aio->type)
+  {
+  case AIO_FILE_READ:
+    if (-1 == aio->offset)
+      ret = GNUNET_DISK_file_read (aio->fh,
+                                   aio->buf,
+                                   aio->len);
+    else
+      ret = pread (aio->fh->fd,
+                   aio->buf,
+                   aio->len,
+                   aio->offset);
+    break;
+  case AIO_FILE_WRITE:
+    if (-1 == aio->offset)
+      ret = GNUNET_DISK_file_write (aio->fh,
+                                    aio->buf,
+                                    aio->len);
+    else
+      ret = pwrite (aio->fh->fd,
+                    aio->buf,
+                    aio->len,
+                    aio->offset);
+    break;
+  case AIO_NET_RECV:
+    ret = GNUNET_NETWORK_socket_recv (aio->sock,
+                                      aio->buf,
+                                      aio->len);
+    break;
+  case AIO_NET_SEND:
+    ret = GNUNET_NETWORK_socket_send (aio->sock,
+                                      aio->buf,
+                                      aio->len);
+    break;
+  default:
+    GNUNET_assert (0);
+  }
+  if ((ret < 0) &&
+      ((EAGAIN == errno) ||
+       (EWOULDBLOCK == errno) ||
+       (EINTR == errno)))
+  {
+    /* spurious readiness, wait again */
+    if (AIO_NET_RECV == aio->type)
+      aio->task = GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                                 aio->sock,
+                                                 &fallback_io,
+                                                 aio);
+    else if (AIO_NET_SEND == aio->type)
+      aio->task = GNUNET_SCHEDULER_add_write_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                                  aio->sock,
+                                                  &fallback_io,
+                                                  aio);
+    else if (AIO_FILE_READ == aio->type)
+      aio->task = GNUNET_SCHEDULER_add_read_file (GNUNET_TIME_UNIT_FOREVER_REL,
+                                                  aio->fh,
+                                                  &fallback_io,
+                                                  aio);
+    else
+      aio->task = GNUNET_SCHEDULER_add_write_file (GNUNET_TIME_UNIT_FOREVER_REL,
+                                                   aio->fh,
+                                                   &fallback_io,
+                                                   aio);
+    return;
+  }
+  aio->result = (ret < 0) ? -1 : ret;
+  aio->error = (ret < 0) ? errno : 0;
+  complete_io (aio);
+}
+
+
+/**
+ * Start @a aio, using the ring if the io_uring event loop runs.
+ *
+ * @param aio operation to start
+ * @return @a aio
+ */
+static struct GNUNET_SCHEDULER_AsyncIo *
+start_io (struct GNUNET_SCHEDULER_AsyncIo *aio)
+{
+  aio->kind = UK_IO;
+#if USE_IO_URING
+  if (NULL != active_ring)
+  {
+    /* placeholder so that the scheduler stays alive while the
+       kernel works on the operation */
+    aio->task = GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_UNIT_FOREVER_REL,
+                                              &complete_io,
+                                              aio);
+    ring_submit_io (active_ring,
+                    aio);
+    return aio;
+  }
+#endif
+  switch (aio->type)
+  {
+  case AIO_FILE_READ:
+  case AIO_FILE_WRITE:
+    aio->task = GNUNET_SCHEDULER_add_now (&fallback_io,
+                                          aio);
+    break;
+  case AIO_NET_RECV:
+    aio->task = GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                               aio->sock,
+                                               &fallback_io,
+                                               aio);
+    break;
+  case AIO_NET_SEND:
+    aio->task = GNUNET_SCHEDULER_add_write_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                                aio->sock,
+                                                &fallback_io,
+                                                aio);
+    break;
+  }
+  return aio;
+}
+
+
+struct GNUNET_SCHEDULER_AsyncIo *
+GNUNET_SCHEDULER_file_read_async (const struct GNUNET_DISK_FileHandle *fh,
+                                  off_t offset,
+                                  void *buf,
+                                  size_t len,
+                                  GNUNET_SCHEDULER_AsyncIoCallback cb,
+                                  void *cb_cls)
+{
+  struct GNUNET_SCHEDULER_AsyncIo *aio;
+
+  GNUNET_assert (NULL != fh);
+  aio = GNUNET_new (struct GNUNET_SCHEDULER_AsyncIo);
+  aio->type = AIO_FILE_READ;
+  aio->fh = fh;
+  aio->offset = offset;
+  aio->buf = buf;
+  aio->len = len;
+  aio->cb = cb;
+  aio->cb_cls = cb_cls;
+  return start_io (aio);
+}
+
+
+struct GNUNET_SCHEDULER_AsyncIo *
+GNUNET_SCHEDULER_file_write_async (const struct GNUNET_DISK_FileHandle *fh,
+                                   off_t offset,
+                                   const void *buf,
+                                   size_t len,
+                                   GNUNET_SCHEDULER_AsyncIoCallback cb,
+                                   void *cb_cls)
+{
+  struct GNUNET_SCHEDULER_AsyncIo *aio;
+
+  GNUNET_assert (NULL != fh);
+  aio = GNUNET_new (struct GNUNET_SCHEDULER_AsyncIo);
+  aio->type = AIO_FILE_WRITE;
+  aio->fh = fh;
+  aio->offset = offset;
+  aio->buf = (char *) buf;
+  aio->len = len;
+  aio->cb = cb;
+  aio->cb_cls = cb_cls;
+  return start_io (aio);
+}
+
+
+struct GNUNET_SCHEDULER_AsyncIo *
+GNUNET_SCHEDULER_net_recv_async (struct GNUNET_NETWORK_Handle *sock,
+                                 void *buf,
+                                 size_t len,
+                                 GNUNET_SCHEDULER_AsyncIoCallback cb,
+                                 void *cb_cls)
+{
+  struct GNUNET_SCHEDULER_AsyncIo *aio;
+
+  GNUNET_assert (NULL != sock);
+  aio = GNUNET_new (struct GNUNET_SCHEDULER_AsyncIo);
+  aio->type = AIO_NET_RECV;
+  aio->sock = sock;
+  aio->buf = buf;
+  aio->len = len;
+  aio->cb = cb;
+  aio->cb_cls = cb_cls;
+  return start_io (aio);
+}
+
+
+struct GNUNET_SCHEDULER_AsyncIo *
+GNUNET_SCHEDULER_net_send_async (struct GNUNET_NETWORK_Handle *sock,
+                                 const void *buf,
+                                 size_t len,
+                                 GNUNET_SCHEDULER_AsyncIoCallback cb,
+                                 void *cb_cls)
+{
+  struct GNUNET_SCHEDULER_AsyncIo *aio;
+
+  GNUNET_assert (NULL != sock);
+  aio = GNUNET_new (struct GNUNET_SCHEDULER_AsyncIo);
+  aio->type = AIO_NET_SEND;
+  aio->sock = sock;
+  aio->buf = (char *) buf;
+  aio->len = len;
+  aio->cb = cb;
+  aio->cb_cls = cb_cls;
+  return start_io (aio);
+}
+
+
+void
+GNUNET_SCHEDULER_async_io_cancel (struct GNUNET_SCHEDULER_AsyncIo *aio)
+{
+  if (NULL != aio->task)
+  {
+    GNUNET_SCHEDULER_cancel (aio->task);
+    aio->task = NULL;
+  }
+#if USE_IO_URING
+  if (aio->in_kernel)
+  {
+    struct UringContext *ctx = active_ring;
+
+    /* wait until the kernel is done with the buffer; the
+       completion handler frees @a aio */
+    GNUNET_assert (NULL != ctx);
+    GNUNET_assert (NULL == ctx->cancel_target);
+    GNUNET_assert (ctx->io_active > 0);
+    ctx->io_active--;
+    ctx->cancel_target = aio;
+    ring_cancel (ctx,
+                 IORING_OP_ASYNC_CANCEL,
+                 aio);
+    while (NULL != ctx->cancel_target)
+    {
+      GNUNET_assert (GNUNET_OK ==
+                     ring_enter (ctx,
+                                 GNUNET_YES,
+                                 GNUNET_TIME_UNIT_FOREVER_REL));
+      ring_reap (ctx);
+    }
+    return;
+  }
+#endif
+  GNUNET_free (aio);
+}
+
+
+/* end of scheduler_uring.c */
@@ -0,0 +1,46 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file util/scheduler_uring.h
+ * @brief Internal interface of the io_uring event loop
+ */
+#ifndef GNUNET_SCHEDULER_URING_H_
+#define GNUNET_SCHEDULER_URING_H_
+
+#include "gnunet_common.h"
+#include "gnunet_util_lib.h"
+
+/**
+ * Run the scheduler with the io_uring event loop, if it was
+ * requested and is supported.
+ *
+ * @internal
+ * @param task task to run first (and immediately)
+ * @param task_cls closure of @a task
+ * @return #GNUNET_OK if the scheduler ran and finished,
+ *         #GNUNET_SYSERR if io_uring is not to be used; in this
+ *         case nothing was done and the caller should use select()
+ */
+enum GNUNET_GenericReturnValue
+GNUNET_SCHEDULER_uring_run_ (GNUNET_SCHEDULER_TaskCallback task,
+                             void *task_cls);
+
+#endif /* GNUNET_SCHEDULER_URING_H_ */
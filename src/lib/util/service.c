@@ -44,6 +44,13 @@
 #define LOG_STRERROR_FILE(kind, syscall, filename) \
         GNUNET_log_from_strerror_file (kind, "util-service", syscall, filename)
 
+/**
+ * How many messages of a client do we process in one task at most
+ * with #GNUNET_SERVICE_OPTION_INLINE_CONTINUE before giving other
+ * tasks a chance to run?
+ */
+#define INLINE_CONTINUE_BUDGET 64
+
 
 /**
  * Information the service tracks per listen operation.
@@ -337,6 +344,17 @@ struct GNUNET_SERVICE_Client
    */
   bool needs_continue;
 
+  /**
+   * Are we in the handler for a message of this client?
+   */
+  bool in_dispatch;
+
+  /**
+   * Did the application disable the warning about missing calls to
+   * #GNUNET_SERVICE_client_continue() for the current message?
+   */
+  bool warn_disabled;
+
   /**
    * Type of last message processed (for warn_no_receive_done).
    */
@@ -677,19 +695,96 @@ service_client_mst_cb (void *cls,
        ntohs (message->size));
   GNUNET_assert (! client->needs_continue);
   client->needs_continue = true;
+  client->warn_disabled = false;
   client->warn_type = ntohs (message->type);
-  client->warn_start = GNUNET_TIME_absolute_get ();
   GNUNET_assert (NULL == client->warn_task);
-  client->warn_task = GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_UNIT_MINUTES,
-                                                    &warn_no_client_continue,
-                                                    client);
+  client->in_dispatch = true;
   GNUNET_MQ_inject_message (client->mq, message);
+  client->in_dispatch = false;
   if (NULL != client->drop_task)
     return GNUNET_SYSERR;
+  /* only start the timer if the handler did not continue right away */
+  if ( (client->needs_continue) &&
+       (! client->warn_disabled) )
+  {
+    client->warn_start = GNUNET_TIME_absolute_get ();
+    client->warn_task = GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_UNIT_MINUTES,
+                                                      &warn_no_client_continue,
+                                                      client);
+  }
   return GNUNET_OK;
 }
 
 
+/**
+ * Task run to resume receiving data from the client after
+ * the client called #GNUNET_SERVICE_client_continue().
+ *
+ * @param cls our `struct GNUNET_SERVICE_Client`
+ */
+static void
+resume_client_receive (void *cls);
+
+
+/**
+ * A client sent us data. Receive and process it.
+ *
+ * @param cls the `struct GNUNET_SERVICE_Client` that sent us data.
+ */
+static void
+service_client_recv (void *cls);
+
+
+/**
+ * The tokenizer of @a client processed a message.  Pass further
+ * messages from its buffer to the handlers if they continued inline,
+ * or wait for more data if the buffer has no complete message left.
+ *
+ * @param client the client
+ * @param ret result from the tokenizer
+ */
+static void
+process_client_buffer (struct GNUNET_SERVICE_Client *client,
+                       enum GNUNET_GenericReturnValue ret)
+{
+  unsigned int budget = INLINE_CONTINUE_BUDGET;
+
+  while (GNUNET_NO == ret)
+  {
+    /* there is another complete message in the buffer */
+    if ( (client->needs_continue) ||
+         (NULL != client->recv_task) )
+      return; /* wait for the application to be done processing */
+    if (0 == --budget)
+    {
+      /* let other tasks run before we continue */
+      client->recv_task = GNUNET_SCHEDULER_add_now (&resume_client_receive,
+                                                    client);
+      return;
+    }
+    ret = GNUNET_MST_next (client->mst,
+                           GNUNET_YES);
+  }
+  if (GNUNET_SYSERR == ret)
+  {
+    if (NULL == client->drop_task)
+      GNUNET_SERVICE_client_drop (client);
+    return;
+  }
+  GNUNET_assert (GNUNET_OK == ret);
+  if (client->needs_continue)
+    return;
+  if (NULL != client->recv_task)
+    return;
+  /* MST needs more data, re-schedule read job */
+  client->recv_task =
+    GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                   client->sock,
+                                   &service_client_recv,
+                                   client);
+}
+
+
 /**
  * A client sent us data. Receive and process it.  If we are done,
  * reschedule this task.
@@ -717,20 +812,8 @@ service_client_recv (void *cls)
     }
     return;
   }
-  if (GNUNET_NO == ret)
-    return; /* more messages in buffer, wait for application
-               to be done processing */
-  GNUNET_assert (GNUNET_OK == ret);
-  if (client->needs_continue)
-    return;
-  if (NULL != client->recv_task)
-    return;
-  /* MST needs more data, re-schedule read job */
-  client->recv_task =
-    GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
-                                   client->sock,
-                                   &service_client_recv,
-                                   client);
+  process_client_buffer (client,
+                         ret);
 }
 
 
@@ -2317,30 +2400,12 @@ static void
 resume_client_receive (void *cls)
 {
   struct GNUNET_SERVICE_Client *c = cls;
-  int ret;
 
   c->recv_task = NULL;
   /* first, check if there is still something in the buffer */
-  ret = GNUNET_MST_next (c->mst,
-                         GNUNET_YES);
-  if (GNUNET_SYSERR == ret)
-  {
-    if (NULL == c->drop_task)
-      GNUNET_SERVICE_client_drop (c);
-    return;
-  }
-  if (GNUNET_NO == ret)
-    return; /* done processing, wait for more later */
-  GNUNET_assert (GNUNET_OK == ret);
-  if (c->needs_continue)
-    return; /* #GNUNET_MST_next() did give a message to the client */
-  /* need to receive more data from the network first */
-  if (NULL != c->recv_task)
-    return;
-  c->recv_task = GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
-                                                c->sock,
-                                                &service_client_recv,
-                                                c);
+  process_client_buffer (c,
+                         GNUNET_MST_next (c->mst,
+                                          GNUNET_YES));
 }
 
 
@@ -2356,6 +2421,9 @@ GNUNET_SERVICE_client_continue (struct GNUNET_SERVICE_Client *c)
     GNUNET_SCHEDULER_cancel (c->warn_task);
     c->warn_task = NULL;
   }
+  if ( (c->in_dispatch) &&
+       (0 != (c->sh->options & GNUNET_SERVICE_OPTION_INLINE_CONTINUE)) )
+    return; /* process_client_buffer() passes on the next message */
   c->recv_task = GNUNET_SCHEDULER_add_now (&resume_client_receive,
                                            c);
 }
@@ -2364,7 +2432,8 @@ GNUNET_SERVICE_client_continue (struct GNUNET_SERVICE_Client *c)
 void
 GNUNET_SERVICE_client_disable_continue_warning (struct GNUNET_SERVICE_Client *c)
 {
-  GNUNET_break (NULL != c->warn_task);
+  GNUNET_break (c->needs_continue);
+  c->warn_disabled = true;
   if (NULL != c->warn_task)
   {
     GNUNET_SCHEDULER_cancel (c->warn_task);
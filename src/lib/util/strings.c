@@ -434,12 +434,96 @@ GNUNET_STRINGS_from_utf8 (const char *input,
 }
 
 
+/**
+ * Check if @a input is trivially in NFC: code points below U+0300
+ * neither decompose nor combine with each other, so strings made of
+ * them only (ASCII in particular) are already normalized.
+ *
+ * @param input input string
+ * @param[out] len set to the length of @a input
+ * @return true if @a input is in NFC, false if we do not know
+ */
+static bool
+utf8_is_trivially_nfc (const char *input,
+                       size_t *len)
+{
+  const unsigned char *pos = (const unsigned char *) input;
+
+  while (1)
+  {
+    if (pos[0] < 0x80)
+    {
+      if ('\0' == pos[0])
+        break;
+      pos++;
+      continue;
+    }
+    /* two-byte sequence for U+0080 to U+02FF */
+    if ((pos[0] < 0xC2) ||
+        (pos[0] > 0xCB) ||
+        (0x80 != (pos[1] & 0xC0)))
+      return false;
+    pos += 2;
+  }
+  *len = (const char *) pos - input;
+  return true;
+}
+
+
+enum GNUNET_GenericReturnValue
+GNUNET_STRINGS_utf8_normalize_buf (const char *input,
+                                   char *output,
+                                   size_t *output_len)
+{
+  uint8_t *tmp;
+  size_t len;
+
+  if (utf8_is_trivially_nfc (input,
+                             &len))
+  {
+    if (len >= *output_len)
+    {
+      *output_len = len + 1;
+      return GNUNET_NO;
+    }
+    GNUNET_memcpy (output,
+                   input,
+                   len + 1);
+    *output_len = len;
+    return GNUNET_OK;
+  }
+  len = (0 == *output_len) ? 0 : *output_len - 1;
+  tmp = u8_normalize (UNINORM_NFC,
+                      (const uint8_t *) input,
+                      strlen (input),
+                      (0 == len) ? NULL : (uint8_t *) output,
+                      &len);
+  if (NULL == tmp)
+    return GNUNET_SYSERR;
+  if ((uint8_t *) output != tmp)
+  {
+    /* did not fit, libunistring allocated the result */
+    free (tmp);
+    *output_len = len + 1;
+    return GNUNET_NO;
+  }
+  output[len] = '\0';
+  *output_len = len;
+  return GNUNET_OK;
+}
+
+
 char *
 GNUNET_STRINGS_utf8_normalize (const char *input)
 {
   uint8_t *tmp;
   size_t len;
   char *output;
+
+  if (utf8_is_trivially_nfc (input,
+                             &len))
+    return GNUNET_strndup (input,
+                           len);
   tmp = u8_normalize (UNINORM_NFC,
                       (uint8_t *) input,
                       strlen ((char*) input),
@@ -455,6 +539,39 @@ GNUNET_STRINGS_utf8_normalize (const char *input)
 }
 
 
+/**
+ * Map the ASCII string @a input to lower or upper case.
+ *
+ * @param input input string
+ * @param[out] output where to write the result, may be @a input
+ * @param upper true to map to upper case
+ * @return true on success, false if @a input is not ASCII
+ */
+static bool
+ascii_change_case (const char *input,
+                   char *output,
+                   bool upper)
+{
+  size_t len;
+
+  for (len = 0; '\0' != input[len]; len++)
+    if (0 != (input[len] & 0x80))
+      return false;
+  /* not toupper()/tolower(), they depend on the locale */
+  for (size_t i = 0; i <= len; i++)
+  {
+    char c = input[i];
+
+    if (upper && (c >= 'a') && (c <= 'z'))
+      c -= 'a' - 'A';
+    else if ((! upper) && (c >= 'A') && (c <= 'Z'))
+      c += 'a' - 'A';
+    output[i] = c;
+  }
+  return true;
+}
+
+
 enum GNUNET_GenericReturnValue
 GNUNET_STRINGS_utf8_tolower (const char *input,
                              char *output)
@@ -462,6 +579,10 @@ GNUNET_STRINGS_utf8_tolower (const char *input,
   uint8_t *tmp_in;
   size_t len;
 
+  if (ascii_change_case (input,
+                         output,
+                         false))
+    return GNUNET_OK;
   tmp_in = u8_tolower ((uint8_t *) input,
                        strlen ((char *) input),
                        NULL,
@@ -484,6 +605,10 @@ GNUNET_STRINGS_utf8_toupper (const char *input,
   uint8_t *tmp_in;
   size_t len;
 
+  if (ascii_change_case (input,
+                         output,
+                         true))
+    return GNUNET_OK;
   tmp_in = u8_toupper ((uint8_t *) input,
                        strlen ((char *) input),
                        NULL,
@@ -75,10 +75,62 @@ proc (void *cls,
 }
 
 
+/**
+ * Check that the monitor reports the loopback address before
+ * the initial #GNUNET_OS_NIC_SYNCED.
+ */
+static void
+mon_cb (void *cls,
+        enum GNUNET_OS_NetworkInterfaceChange change,
+        const char *name,
+        int isDefault,
+        const struct sockaddr *addr,
+        const struct sockaddr *broadcast_addr,
+        const struct sockaddr *netmask,
+        socklen_t addrlen)
+{
+  int *ok = cls;
+
+  switch (change)
+  {
+  case GNUNET_OS_NIC_ADDED:
+    if (2 == *ok)
+      (void) proc (&ok[1],
+                   name,
+                   isDefault,
+                   addr,
+                   broadcast_addr,
+                   netmask,
+                   addrlen);
+    break;
+  case GNUNET_OS_NIC_REMOVED:
+    break;
+  case GNUNET_OS_NIC_SYNCED:
+    if ( (2 == *ok) &&
+         (0 == ok[1]) )
+      *ok = 0;
+    break;
+  }
+}
+
+
+static void
+run_monitor (void *cls)
+{
+  struct GNUNET_OS_NetworkInterfaceMonitor *mon;
+
+  mon = GNUNET_OS_network_interfaces_monitor_start (GNUNET_TIME_UNIT_MINUTES,
+                                                    &mon_cb,
+                                                    cls);
+  GNUNET_OS_network_interfaces_monitor_stop (mon);
+}
+
+
 int
 main (int argc, char *argv[])
 {
   int ret;
+  int mret[2] = { 2, 1 };
 
   GNUNET_log_setup ("test-os-network",
                     "WARNING",
@@ -86,7 +138,11 @@ main (int argc, char *argv[])
   ret = 1;
   GNUNET_OS_network_interfaces_list (&proc,
                                      &ret);
-  return ret;
+  if (0 != ret)
+    return ret;
+  GNUNET_SCHEDULER_run (&run_monitor,
+                        mret);
+  return mret[0];
 }
 
 
@@ -123,6 +123,37 @@ main (int argc, char *argv[])
   b = GNUNET_STRINGS_utf8_normalize (r);
   GNUNET_assert (0 == strcmp ("q\u0323\u0307", b));
   GNUNET_free (b);
+  {
+    char nbuf[8];
+    size_t nlen;
+
+    nlen = sizeof (nbuf);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_STRINGS_utf8_normalize_buf (r, nbuf, &nlen));
+    GNUNET_assert (5 == nlen);
+    GNUNET_assert (0 == strcmp ("q\u0323\u0307", nbuf));
+    nlen = sizeof (nbuf);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_STRINGS_utf8_normalize_buf ("caf\u00e9", nbuf,
+                                                      &nlen));
+    GNUNET_assert (0 == strcmp ("caf\u00e9", nbuf));
+    nlen = sizeof (nbuf);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_STRINGS_utf8_normalize_buf ("cafe\u0301", nbuf,
+                                                      &nlen));
+    GNUNET_assert (0 == strcmp ("caf\u00e9", nbuf));
+    nlen = sizeof (nbuf);
+    GNUNET_assert (GNUNET_NO ==
+                   GNUNET_STRINGS_utf8_normalize_buf ("too-long", nbuf,
+                                                      &nlen));
+    GNUNET_assert (9 == nlen);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_STRINGS_utf8_tolower ("MiXeD", nbuf));
+    WANTNF ("mixed", nbuf);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_STRINGS_utf8_toupper ("MiXeD", nbuf));
+    WANTNF ("MIXED", nbuf);
+  }
   b = GNUNET_STRINGS_to_utf8 ("TEST", 4, "ASCII");
   WANT ("TEST", b);
 
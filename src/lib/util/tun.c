@@ -278,4 +278,24 @@ GNUNET_TUN_sockaddr_cmp (const struct sockaddr *sa,
 }
 
 
+uint32_t
+GNUNET_TUN_flow_hash (uint64_t key,
+                      const void *buf,
+                      size_t len)
+{
+  const uint8_t *b = buf;
+  uint64_t h = key ^ 0xcbf29ce484222325LLU;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    h ^= b[i];
+    h *= 0x100000001b3LLU;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdLLU;
+  h ^= h >> 33;
+  return (uint32_t) h;
+}
+
+
 /* end of tun.c */
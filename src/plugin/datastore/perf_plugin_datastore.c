@@ -45,6 +45,22 @@
  */
 #define PUT_10 (MAX_SIZE / 32 / 1024 / ITERATIONS)
 
+/**
+ * Number of small items we store to measure how fast expired content
+ * is deleted.  All but every fourth of them are already expired.
+ */
+#define EXPIRED_PUTS (PUT_10 * 16)
+
+/**
+ * Number of items among #EXPIRED_PUTS that are expired.
+ */
+#define EXPIRED_ITEMS (EXPIRED_PUTS - EXPIRED_PUTS / 4)
+
+/**
+ * How many items do we delete at most per batch?
+ */
+#define REMOVE_BATCH 128
+
 static char category[256];
 
 static unsigned int hits[PUT_10 / 8 + 1];
@@ -66,6 +82,10 @@ enum RunPhase
   RP_REP_GET,
   RP_ZA_GET,
   RP_EXP_GET,
+  RP_EXPIRED_PUT,
+  RP_EXPIRED_GET,
+  RP_EXPIRED_BATCH,
+  RP_LOW_PRIORITY_BATCH,
   RP_DONE
 };
 
@@ -81,6 +101,7 @@ struct CpsRunContext
   unsigned int cnt;
   unsigned int iter;
   uint64_t offset;
+  int batched;
 };
 
 
@@ -377,6 +398,199 @@ replication_get (void *cls,
 }
 
 
+static void
+report_expired (struct CpsRunContext *crc,
+                const char *op)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  crc->end = GNUNET_TIME_absolute_get ();
+  dur = GNUNET_TIME_absolute_get_difference (crc->start,
+                                             crc->end);
+  printf ("%s took %s yielding %u/%u items (%llu/s)\n",
+          op,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          crc->cnt,
+          (unsigned int) EXPIRED_ITEMS,
+          crc->cnt * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+  GAUGER (category,
+          op,
+          crc->cnt * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us),
+          "items/s");
+  if (EXPIRED_ITEMS != crc->cnt)
+  {
+    fprintf (stderr,
+             "%s deleted %u items, expected %u\n",
+             op,
+             crc->cnt,
+             (unsigned int) EXPIRED_ITEMS);
+    crc->phase = RP_ERROR;
+  }
+  crc->cnt = 0;
+}
+
+
+/**
+ * Store a small item, most of them already expired.
+ */
+static void
+do_expired_put (struct CpsRunContext *crc)
+{
+  char value[1024];
+  struct GNUNET_HashCode key;
+  struct GNUNET_TIME_Absolute expiration;
+
+  if (EXPIRED_PUTS == crc->cnt)
+  {
+    crc->cnt = 0;
+    crc->phase = crc->batched ? RP_EXPIRED_BATCH : RP_EXPIRED_GET;
+    crc->start = GNUNET_TIME_absolute_get ();
+    GNUNET_SCHEDULER_add_now (&test, crc);
+    return;
+  }
+  GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_WEAK,
+                              &key,
+                              sizeof (key));
+  memset (value, crc->cnt, sizeof (value));
+  GNUNET_memcpy (value, &crc->cnt, sizeof (crc->cnt));
+  if (0 == crc->cnt % 4)
+    expiration = GNUNET_TIME_relative_to_absolute (GNUNET_TIME_UNIT_HOURS);
+  else
+    expiration = GNUNET_TIME_absolute_subtract (
+      GNUNET_TIME_absolute_get (),
+      GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_SECONDS,
+                                     1 + crc->cnt));
+  crc->cnt++;
+  crc->api->put (crc->api->cls,
+                 &key,
+                 true /* absent */,
+                 sizeof (value),
+                 value,
+                 1 /* type */,
+                 GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, 100),
+                 0 /* anonymity */,
+                 0 /* replication */,
+                 expiration,
+                 &put_continuation,
+                 crc);
+}
+
+
+static int
+expired_get (void *cls,
+             const struct GNUNET_HashCode *key,
+             uint32_t size,
+             const void *data,
+             enum GNUNET_BLOCK_Type type,
+             uint32_t priority,
+             uint32_t anonymity,
+             uint32_t replication,
+             struct GNUNET_TIME_Absolute expiration,
+             uint64_t uid)
+{
+  struct CpsRunContext *crc = cls;
+
+  if ( (NULL == key) ||
+       (GNUNET_TIME_absolute_is_future (expiration)) )
+  {
+    report_expired (crc,
+                    "Deleting expired items one by one");
+    if (RP_ERROR != crc->phase)
+      crc->phase = RP_EXPIRED_PUT;
+    crc->batched = GNUNET_YES;
+    GNUNET_SCHEDULER_add_now (&test, crc);
+    return GNUNET_OK;
+  }
+  crc->cnt++;
+  GNUNET_SCHEDULER_add_now (&test, crc);
+  return GNUNET_NO;
+}
+
+
+static enum GNUNET_GenericReturnValue
+expired_removed (void *cls,
+                 const struct GNUNET_HashCode *key,
+                 uint32_t size,
+                 enum GNUNET_BLOCK_Type type,
+                 uint32_t priority,
+                 struct GNUNET_TIME_Absolute expiration)
+{
+  struct CpsRunContext *crc = cls;
+
+  GNUNET_assert (GNUNET_TIME_absolute_is_past (expiration));
+  crc->cnt++;
+  return GNUNET_OK;
+}
+
+
+static void
+expired_batch (struct CpsRunContext *crc)
+{
+  if (REMOVE_BATCH ==
+      crc->api->remove_batch (crc->api->cls,
+                              GNUNET_TIME_absolute_get (),
+                              false,
+                              REMOVE_BATCH,
+                              &expired_removed,
+                              crc))
+  {
+    GNUNET_SCHEDULER_add_now (&test, crc);
+    return;
+  }
+  report_expired (crc,
+                  "Deleting expired items in batches");
+  if (RP_ERROR != crc->phase)
+    crc->phase = RP_LOW_PRIORITY_BATCH;
+  crc->start = GNUNET_TIME_absolute_get ();
+  GNUNET_SCHEDULER_add_now (&test, crc);
+}
+
+
+static enum GNUNET_GenericReturnValue
+low_priority_removed (void *cls,
+                      const struct GNUNET_HashCode *key,
+                      uint32_t size,
+                      enum GNUNET_BLOCK_Type type,
+                      uint32_t priority,
+                      struct GNUNET_TIME_Absolute expiration)
+{
+  struct CpsRunContext *crc = cls;
+
+  crc->cnt++;
+  return (REMOVE_BATCH / 2 == crc->cnt) ? GNUNET_NO : GNUNET_OK;
+}
+
+
+static void
+low_priority_batch (struct CpsRunContext *crc)
+{
+  unsigned int removed;
+
+  removed = crc->api->remove_batch (crc->api->cls,
+                                    GNUNET_TIME_absolute_get (),
+                                    true,
+                                    REMOVE_BATCH,
+                                    &low_priority_removed,
+                                    crc);
+  if ( (REMOVE_BATCH / 2 != removed) ||
+       (REMOVE_BATCH / 2 != crc->cnt) )
+  {
+    fprintf (stderr,
+             "Deleting low-priority items stopped after %u/%u items\n",
+             removed,
+             crc->cnt);
+    crc->phase = RP_ERROR;
+  }
+  else
+  {
+    crc->phase = RP_DONE;
+  }
+  crc->cnt = 0;
+  GNUNET_SCHEDULER_add_now (&test, crc);
+}
+
+
 /**
  * Function called when the service shuts
  * down.  Unloads our datastore plugin.
@@ -456,6 +670,22 @@ test (void *cls)
     crc->api->get_expiration (crc->api->cls, &expiration_get, crc);
     break;
 
+  case RP_EXPIRED_PUT:
+    do_expired_put (crc);
+    break;
+
+  case RP_EXPIRED_GET:
+    crc->api->get_expiration (crc->api->cls, &expired_get, crc);
+    break;
+
+  case RP_EXPIRED_BATCH:
+    expired_batch (crc);
+    break;
+
+  case RP_LOW_PRIORITY_BATCH:
+    low_priority_batch (crc);
+    break;
+
   case RP_DONE:
     crc->api->drop (crc->api->cls);
     ok = 0;
@@ -852,6 +852,66 @@ heap_plugin_remove_key (void *cls,
         NULL);
 }
 
+/**
+ * Remove up to @a limit expired or old items.
+ *
+ * @param cls our `struct Plugin *`
+ * @param now current time
+ * @param low_priority true to remove the oldest items,
+ *        false to remove only expired items
+ * @param limit maximum number of items to remove
+ * @param proc function to call on each removed item
+ * @param proc_cls closure for @a proc
+ * @return number of items removed
+ */
+static unsigned int
+heap_plugin_remove_batch (void *cls,
+                          struct GNUNET_TIME_Absolute now,
+                          bool low_priority,
+                          unsigned int limit,
+                          PluginRemovedProcessor proc,
+                          void *proc_cls)
+{
+  struct Plugin *plugin = cls;
+  struct Value *value;
+  struct GNUNET_HashCode key;
+  uint32_t size;
+  enum GNUNET_BLOCK_Type type;
+  uint32_t priority;
+  struct GNUNET_TIME_Absolute expiration;
+  unsigned int removed;
+
+  removed = 0;
+  while (removed < limit)
+  {
+    value = GNUNET_CONTAINER_heap_peek (plugin->by_expiration);
+    if (NULL == value)
+      break;
+    if ( (! low_priority) &&
+         (GNUNET_TIME_absolute_cmp (value->expiration,
+                                    >=,
+                                    now)) )
+      break;
+    key = value->key;
+    size = value->size;
+    type = value->type;
+    priority = value->priority;
+    expiration = value->expiration;
+    delete_value (plugin,
+                  value);
+    removed++;
+    if (GNUNET_OK != proc (proc_cls,
+                           &key,
+                           size,
+                           type,
+                           priority,
+                           expiration))
+      break;
+  }
+  return removed;
+}
+
+
 void *
 libgnunet_plugin_datastore_heap_init (void *cls);
 
@@ -893,6 +953,7 @@ libgnunet_plugin_datastore_heap_init (void *cls)
   api->drop = &heap_plugin_drop;
   api->get_keys = &heap_get_keys;
   api->remove_key = &heap_plugin_remove_key;
+  api->remove_batch = &heap_plugin_remove_batch;
   GNUNET_log_from (GNUNET_ERROR_TYPE_INFO, "heap",
                    _ ("Heap database running\n"));
   return api;
@@ -105,6 +105,15 @@ init_connection (struct Plugin *plugin)
                             " FROM datastore.gn090"
                             " ORDER BY prio ASC LIMIT 1)"
                             " ORDER BY expire ASC LIMIT 1"),
+    GNUNET_PQ_make_prepare ("select_expired_batch",
+                            "SELECT hash, LENGTH(value) AS size, type, prio, expire, oid"
+                            " FROM datastore.gn090"
+                            " WHERE expire < $1"
+                            " ORDER BY expire ASC LIMIT $2"),
+    GNUNET_PQ_make_prepare ("select_low_priority_batch",
+                            "SELECT hash, LENGTH(value) AS size, type, prio, expire, oid"
+                            " FROM datastore.gn090"
+                            " ORDER BY prio ASC, expire ASC LIMIT $1"),
     GNUNET_PQ_make_prepare ("select_replication_order",
                             "SELECT " RESULT_COLUMNS
                             " FROM datastore.gn090"
@@ -700,6 +709,149 @@ postgres_plugin_get_expiration (void *cls,
 }
 
 
+/**
+ * Closure for #process_remove_batch.
+ */
+struct RemoveBatchContext
+{
+  /**
+   * The plugin handle.
+   */
+  struct Plugin *plugin;
+
+  /**
+   * Function to call on each removed item.
+   */
+  PluginRemovedProcessor proc;
+
+  /**
+   * Closure for @e proc.
+   */
+  void *proc_cls;
+
+  /**
+   * Number of items removed so far.
+   */
+  unsigned int removed;
+};
+
+
+/**
+ * Remove the items selected for a batch and call the processor of
+ * @a cls on each of them.
+ *
+ * @param cls our `struct RemoveBatchContext`
+ * @param res result from exec
+ * @param num_results number of results in @a res
+ */
+static void
+process_remove_batch (void *cls,
+                      PGresult *res,
+                      unsigned int num_results)
+{
+  struct RemoveBatchContext *rbc = cls;
+  struct Plugin *plugin = rbc->plugin;
+
+  for (unsigned int i = 0; i < num_results; i++)
+  {
+    uint64_t rowid;
+    uint32_t utype;
+    uint32_t priority;
+    uint32_t size;
+    struct GNUNET_TIME_Absolute expiration_time;
+    struct GNUNET_HashCode key;
+    struct GNUNET_PQ_ResultSpec rs[] = {
+      GNUNET_PQ_result_spec_auto_from_type ("hash", &key),
+      GNUNET_PQ_result_spec_uint32 ("size", &size),
+      GNUNET_PQ_result_spec_uint32 ("type", &utype),
+      GNUNET_PQ_result_spec_uint32 ("prio", &priority),
+      GNUNET_PQ_result_spec_absolute_time ("expire", &expiration_time),
+      GNUNET_PQ_result_spec_uint64 ("oid", &rowid),
+      GNUNET_PQ_result_spec_end
+    };
+    struct GNUNET_PQ_QueryParam param[] = {
+      GNUNET_PQ_query_param_uint64 (&rowid),
+      GNUNET_PQ_query_param_end
+    };
+
+    if (GNUNET_OK !=
+        GNUNET_PQ_extract_result (res,
+                                  rs,
+                                  i))
+    {
+      GNUNET_break (0);
+      return;
+    }
+    if (0 >=
+        GNUNET_PQ_eval_prepared_non_select (plugin->dbh,
+                                            "delrow",
+                                            param))
+      continue;
+    rbc->removed++;
+    plugin->env->duc (plugin->env->cls,
+                      -(size + GNUNET_DATASTORE_ENTRY_OVERHEAD));
+    if (GNUNET_OK !=
+        rbc->proc (rbc->proc_cls,
+                   &key,
+                   size,
+                   (enum GNUNET_BLOCK_Type) utype,
+                   priority,
+                   expiration_time))
+      return;
+  }
+}
+
+
+/**
+ * Remove up to @a limit expired or low-priority items.
+ *
+ * @param cls closure with the `struct Plugin`
+ * @param now current time
+ * @param low_priority true to remove low-priority items,
+ *        false to remove only expired items
+ * @param limit maximum number of items to remove
+ * @param proc function to call on each removed item
+ * @param proc_cls closure for @a proc
+ * @return number of items removed
+ */
+static unsigned int
+postgres_plugin_remove_batch (void *cls,
+                              struct GNUNET_TIME_Absolute now,
+                              bool low_priority,
+                              unsigned int limit,
+                              PluginRemovedProcessor proc,
+                              void *proc_cls)
+{
+  struct Plugin *plugin = cls;
+  uint64_t ulimit = limit;
+  struct GNUNET_PQ_QueryParam eparams[] = {
+    GNUNET_PQ_query_param_absolute_time (&now),
+    GNUNET_PQ_query_param_uint64 (&ulimit),
+    GNUNET_PQ_query_param_end
+  };
+  struct GNUNET_PQ_QueryParam lparams[] = {
+    GNUNET_PQ_query_param_uint64 (&ulimit),
+    GNUNET_PQ_query_param_end
+  };
+  struct RemoveBatchContext rbc;
+
+  rbc.plugin = plugin;
+  rbc.proc = proc;
+  rbc.proc_cls = proc_cls;
+  rbc.removed = 0;
+  (void) GNUNET_PQ_eval_prepared_multi_select (plugin->dbh,
+                                               low_priority
+                                               ? "select_low_priority_batch"
+                                               : "select_expired_batch",
+                                               low_priority
+                                               ? lparams
+                                               : eparams,
+                                               &process_remove_batch,
+                                               &rbc);
+  return rbc.removed;
+}
+
+
 /**
  * Closure for #process_keys.
  */
@@ -906,6 +1058,7 @@ libgnunet_plugin_datastore_postgres_init (void *cls)
   api->get_keys = &postgres_plugin_get_keys;
   api->drop = &postgres_plugin_drop;
   api->remove_key = &postgres_plugin_remove_key;
+  api->remove_batch = &postgres_plugin_remove_batch;
   return api;
 }
 
@@ -152,6 +152,16 @@ struct Plugin
    */
   sqlite3_stmt *selZeroAnon;
 
+  /**
+   * Precompiled SQL for selecting a batch of expired items.
+   */
+  sqlite3_stmt *selExpiBatch;
+
+  /**
+   * Precompiled SQL for selecting a batch of old items.
+   */
+  sqlite3_stmt *selOldBatch;
+
   /**
    * Precompiled SQL for insertion.
    */
@@ -404,6 +414,17 @@ database_setup (const struct GNUNET_CONFIGURATION_Handle *cfg,
                  "WHERE NOT EXISTS (SELECT 1 FROM gn091 WHERE expire < ?1 LIMIT 1) OR (expire < ?1) "
                  "ORDER BY expire ASC LIMIT 1",
                  &plugin->selExpi)) ||
+    (SQLITE_OK != sq_prepare (plugin->dbh,
+                              "SELECT hash, LENGTH(value), type, prio, expire, _ROWID_ "
+                              "FROM gn091 "
+                              "WHERE expire < ?1 "
+                              "ORDER BY expire ASC LIMIT ?2",
+                              &plugin->selExpiBatch)) ||
+    (SQLITE_OK != sq_prepare (plugin->dbh,
+                              "SELECT hash, LENGTH(value), type, prio, expire, _ROWID_ "
+                              "FROM gn091 "
+                              "ORDER BY expire ASC LIMIT ?2",
+                              &plugin->selOldBatch)) ||
     (SQLITE_OK != sq_prepare (plugin->dbh,
                               "SELECT " RESULT_COLUMNS " FROM gn091 "
                               "WHERE _ROWID_ >= ? AND "
@@ -516,6 +537,10 @@ database_shutdown (struct Plugin *plugin)
     sqlite3_finalize (plugin->selExpi);
   if (NULL != plugin->selZeroAnon)
     sqlite3_finalize (plugin->selZeroAnon);
+  if (NULL != plugin->selExpiBatch)
+    sqlite3_finalize (plugin->selExpiBatch);
+  if (NULL != plugin->selOldBatch)
+    sqlite3_finalize (plugin->selOldBatch);
   if (NULL != plugin->insertContent)
     sqlite3_finalize (plugin->insertContent);
   for (int i = 0; i < 8; ++i)
@@ -1231,6 +1256,155 @@ sqlite_plugin_remove_key (void *cls,
 }
 
 
+/**
+ * Item selected for removal by #sqlite_plugin_remove_batch().
+ */
+struct RemoveCandidate
+{
+  /**
+   * Key of the item.
+   */
+  struct GNUNET_HashCode key;
+
+  /**
+   * Expiration time of the item.
+   */
+  struct GNUNET_TIME_Absolute expiration;
+
+  /**
+   * Row of the item.
+   */
+  uint64_t rowid;
+
+  /**
+   * Number of bytes in the item.
+   */
+  uint32_t size;
+
+  /**
+   * Type of the item.
+   */
+  uint32_t type;
+
+  /**
+   * Priority of the item.
+   */
+  uint32_t priority;
+};
+
+
+/**
+ * Remove up to @a limit expired or old items in one transaction.
+ * We never remove rows while the selection is still running, so we
+ * first collect the candidates and then delete them one by one.
+ *
+ * @param cls our plugin context
+ * @param now current time
+ * @param low_priority true to remove the oldest items,
+ *        false to remove only expired items
+ * @param limit maximum number of items to remove
+ * @param proc function to call on each removed item
+ * @param proc_cls closure for @a proc
+ * @return number of items removed
+ */
+static unsigned int
+sqlite_plugin_remove_batch (void *cls,
+                            struct GNUNET_TIME_Absolute now,
+                            bool low_priority,
+                            unsigned int limit,
+                            PluginRemovedProcessor proc,
+                            void *proc_cls)
+{
+  struct Plugin *plugin = cls;
+  sqlite3_stmt *stmt;
+  struct GNUNET_SQ_QueryParam params[] = {
+    GNUNET_SQ_query_param_absolute_time (&now),
+    GNUNET_SQ_query_param_uint32 (&limit),
+    GNUNET_SQ_query_param_end
+  };
+  struct RemoveCandidate *rcs;
+  unsigned int n;
+  unsigned int removed;
+  int ret;
+
+  if (0 == limit)
+    return 0;
+  stmt = low_priority ? plugin->selOldBatch : plugin->selExpiBatch;
+  if (GNUNET_OK != GNUNET_SQ_bind (stmt, params))
+    return 0;
+  rcs = GNUNET_new_array (limit,
+                          struct RemoveCandidate);
+  n = 0;
+  while ( (n < limit) &&
+          (SQLITE_ROW == (ret = sqlite3_step (stmt))) )
+  {
+    struct RemoveCandidate *rc = &rcs[n];
+    struct GNUNET_SQ_ResultSpec rs[] = {
+      GNUNET_SQ_result_spec_auto_from_type (&rc->key),
+      GNUNET_SQ_result_spec_uint32 (&rc->size),
+      GNUNET_SQ_result_spec_uint32 (&rc->type),
+      GNUNET_SQ_result_spec_uint32 (&rc->priority),
+      GNUNET_SQ_result_spec_absolute_time (&rc->expiration),
+      GNUNET_SQ_result_spec_uint64 (&rc->rowid),
+      GNUNET_SQ_result_spec_end
+    };
+
+    if (GNUNET_OK != GNUNET_SQ_extract_result (stmt,
+                                               rs))
+    {
+      GNUNET_break (0);
+      continue;
+    }
+    n++;
+  }
+  if ( (n < limit) &&
+       (SQLITE_DONE != ret) )
+    LOG_SQLITE (plugin,
+                GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
+                "sqlite3_step");
+  GNUNET_SQ_reset (plugin->dbh,
+                   stmt);
+  if ( (n > 0) &&
+       (SQLITE_OK != sqlite3_exec (plugin->dbh,
+                                   "BEGIN",
+                                   NULL,
+                                   NULL,
+                                   NULL)) )
+    LOG_SQLITE (plugin,
+                GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
+                "sqlite3_exec");
+  removed = 0;
+  for (unsigned int i = 0; i < n; i++)
+  {
+    if (GNUNET_OK != delete_by_rowid (plugin,
+                                      rcs[i].rowid))
+      break;
+    removed++;
+    if (NULL != plugin->env->duc)
+      plugin->env->duc (plugin->env->cls,
+                        -(rcs[i].size + GNUNET_DATASTORE_ENTRY_OVERHEAD));
+    if (GNUNET_OK != proc (proc_cls,
+                           &rcs[i].key,
+                           rcs[i].size,
+                           (enum GNUNET_BLOCK_Type) rcs[i].type,
+                           rcs[i].priority,
+                           rcs[i].expiration))
+      break;
+  }
+  if ( (n > 0) &&
+       (SQLITE_OK != sqlite3_exec (plugin->dbh,
+                                   "COMMIT",
+                                   NULL,
+                                   NULL,
+                                   NULL)) )
+    LOG_SQLITE (plugin,
+                GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
+                "sqlite3_exec");
+  GNUNET_free (rcs);
+  return removed;
+}
+
+
 /**
  * Get an estimate of how much space the database is
  * currently using.
@@ -1344,6 +1518,7 @@ libgnunet_plugin_datastore_sqlite_init (void *cls)
   api->get_keys = &sqlite_plugin_get_keys;
   api->drop = &sqlite_plugin_drop;
   api->remove_key = &sqlite_plugin_remove_key;
+  api->remove_batch = &sqlite_plugin_remove_batch;
   GNUNET_log_from (GNUNET_ERROR_TYPE_INFO,
                    "sqlite",
                    _ ("Sqlite database running\n"));
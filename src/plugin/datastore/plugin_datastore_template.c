@@ -222,6 +222,31 @@ template_plugin_remove_key (void *cls,
 }
 
 
+/**
+ * Remove up to @a limit expired or low-priority items.
+ *
+ * @param cls our "struct Plugin*"
+ * @param now current time
+ * @param low_priority true to remove low-priority items,
+ *        false to remove only expired items
+ * @param limit maximum number of items to remove
+ * @param proc function to call on each removed item
+ * @param proc_cls closure for @a proc
+ * @return number of items removed
+ */
+static unsigned int
+template_plugin_remove_batch (void *cls,
+                              struct GNUNET_TIME_Absolute now,
+                              bool low_priority,
+                              unsigned int limit,
+                              PluginRemovedProcessor proc,
+                              void *proc_cls)
+{
+  GNUNET_break (0);
+  return 0;
+}
+
+
 /**
  * Entry point for the plugin.
  *
@@ -248,6 +273,7 @@ libgnunet_plugin_datastore_template_init (void *cls)
   api->drop = &template_plugin_drop;
   api->get_keys = &template_get_keys;
   api->remove_key = &template_plugin_remove_key;
+  api->remove_batch = &template_plugin_remove_batch;
   GNUNET_log_from (GNUNET_ERROR_TYPE_INFO, "template",
                    _ ("Template database running\n"));
   return api;
@@ -60,6 +60,12 @@ struct CadetTunnelQueueEntry;
  */
 struct CadetPeerPath;
 
+/**
+ * A sequence of peers that paths begin with, shared by all
+ * paths that begin with it.
+ */
+struct CadetPathPrefix;
+
 /**
  * Entry in a peer path.
  */
@@ -98,6 +104,22 @@ struct CadetPeerPathEntry
    * against overflows.
    */
   int score;
+
+  /**
+   * The peers on the path up to and including this one, shared
+   * with the entries of all paths that begin with the same peers.
+   */
+  struct CadetPathPrefix *prefix;
+
+  /**
+   * DLL of the entries with the same @e prefix.
+   */
+  struct CadetPeerPathEntry *next_prefix;
+
+  /**
+   * DLL of the entries with the same @e prefix.
+   */
+  struct CadetPeerPathEntry *prev_prefix;
 };
 
 /**
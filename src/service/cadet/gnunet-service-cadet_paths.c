@@ -56,6 +56,16 @@ struct CadetPeerPath
    */
   GNUNET_CONTAINER_HeapCostType desirability;
 
+  /**
+   * DLL of the paths that end with the same prefix.
+   */
+  struct CadetPeerPath *next_end;
+
+  /**
+   * DLL of the paths that end with the same prefix.
+   */
+  struct CadetPeerPath *prev_end;
+
   /**
    * Length of the @e entries array.
    */
@@ -63,6 +73,311 @@ struct CadetPeerPath
 };
 
 
+/**
+ * A sequence of peers that paths begin with.
+ */
+struct CadetPathPrefix
+{
+  /**
+   * DLL of the entries at the end of this prefix, one for each
+   * path that begins with it.
+   */
+  struct CadetPeerPathEntry *entries_head;
+
+  /**
+   * DLL of the entries at the end of this prefix, one for each
+   * path that begins with it.
+   */
+  struct CadetPeerPathEntry *entries_tail;
+
+  /**
+   * DLL of the paths that end with this prefix.
+   */
+  struct CadetPeerPath *ends_head;
+
+  /**
+   * DLL of the paths that end with this prefix.
+   */
+  struct CadetPeerPath *ends_tail;
+
+  /**
+   * This prefix without its last peer, NULL if that is the only one.
+   */
+  struct CadetPathPrefix *parent;
+
+  /**
+   * Last peer of this prefix.
+   */
+  struct CadetPeer *peer;
+
+  /**
+   * Hash of the peers of this prefix, our key in #prefixes.
+   */
+  uint32_t hash;
+};
+
+
+/**
+ * Closure for #check_prefix().
+ */
+struct FindPrefixContext
+{
+  /**
+   * Prefix the prefix we look for extends, NULL for none.
+   */
+  struct CadetPathPrefix *parent;
+
+  /**
+   * Peer the prefix we look for ends with.
+   */
+  struct CadetPeer *peer;
+
+  /**
+   * Set to the prefix we look for, if we know it.
+   */
+  struct CadetPathPrefix *result;
+};
+
+
+/**
+ * All prefixes of all paths, by their hash.
+ */
+static struct GNUNET_CONTAINER_MultiHashMap32 *prefixes;
+
+
+/**
+ * Compute the hash of a path prefix from the hash of the prefix
+ * one peer shorter and the peer that follows it.
+ *
+ * @param parent the shorter prefix, NULL for none
+ * @param cp peer that extends the prefix
+ * @return hash of the extended prefix
+ */
+static uint32_t
+hash_next_hop (const struct CadetPathPrefix *parent,
+               struct CadetPeer *cp)
+{
+  uint32_t hop;
+
+  /* peer identities are public keys, any of their bits will do */
+  GNUNET_memcpy (&hop,
+                 GCP_get_id (cp),
+                 sizeof (hop));
+  if (NULL == parent)
+    return hop;
+  return (parent->hash * 16777619) ^ hop;
+}
+
+
+/**
+ * Check if a prefix whose hash matches is the one we look for.
+ * If so, store it in `result`.
+ *
+ * @param cls the `struct FindPrefixContext`
+ * @param key the hash of the prefix
+ * @param value the `struct CadetPathPrefix` to check
+ * @return #GNUNET_YES (continue to iterate), or if found #GNUNET_NO
+ */
+static enum GNUNET_GenericReturnValue
+check_prefix (void *cls,
+              uint32_t key,
+              void *value)
+{
+  struct FindPrefixContext *fp_ctx = cls;
+  struct CadetPathPrefix *prefix = value;
+
+  if ((prefix->parent != fp_ctx->parent) ||
+      (prefix->peer != fp_ctx->peer))
+    return GNUNET_YES; /* hash collision, ignore */
+  fp_ctx->result = prefix;
+  return GNUNET_NO;
+}
+
+
+/**
+ * Find the prefix that extends @a parent by @a cp.
+ *
+ * @param parent the shorter prefix, NULL for none
+ * @param cp peer that extends the prefix
+ * @return NULL if no path begins with the extended prefix
+ */
+static struct CadetPathPrefix *
+find_prefix (struct CadetPathPrefix *parent,
+             struct CadetPeer *cp)
+{
+  struct FindPrefixContext fp_ctx = {
+    .parent = parent,
+    .peer = cp
+  };
+
+  if (NULL == prefixes)
+    return NULL;
+  GNUNET_CONTAINER_multihashmap32_get_multiple (prefixes,
+                                                hash_next_hop (parent,
+                                                               cp),
+                                                &check_prefix,
+                                                &fp_ctx);
+  return fp_ctx.result;
+}
+
+
+/**
+ * Find the prefixes of @a cpath that paths we know begin with.
+ *
+ * @param cpath array of peers
+ * @param cpath_length length of @a cpath
+ * @param[out] found set to the prefixes of the first 1, 2, ...
+ *        peers of @a cpath
+ * @return number of prefixes found
+ */
+static unsigned int
+find_prefixes (struct CadetPeer **cpath,
+               unsigned int cpath_length,
+               struct CadetPathPrefix **found)
+{
+  struct CadetPathPrefix *prefix = NULL;
+
+  for (unsigned int i = 0; i < cpath_length; i++)
+  {
+    prefix = find_prefix (prefix,
+                          cpath[i]);
+    if (NULL == prefix)
+      return i;
+    found[i] = prefix;
+  }
+  return cpath_length;
+}
+
+
+/**
+ * Add the entries of @a path from offset @a off on to their prefixes
+ * and to the lists of their peers, and let @a path end with its
+ * last prefix.
+ *
+ * @param path path with new entries
+ * @param off offset of the first new entry
+ */
+static void
+index_entries (struct CadetPeerPath *path,
+               unsigned int off)
+{
+  struct CadetPathPrefix *parent;
+
+  if (NULL == prefixes)
+    prefixes = GNUNET_CONTAINER_multihashmap32_create (256);
+  parent = (0 == off) ? NULL : path->entries[off - 1]->prefix;
+  for (unsigned int i = off; i < path->entries_length; i++)
+  {
+    struct CadetPeerPathEntry *entry = path->entries[i];
+    struct CadetPathPrefix *prefix;
+
+    prefix = find_prefix (parent,
+                          entry->peer);
+    if (NULL == prefix)
+    {
+      prefix = GNUNET_new (struct CadetPathPrefix);
+      prefix->parent = parent;
+      prefix->peer = entry->peer;
+      prefix->hash = hash_next_hop (parent,
+                                    entry->peer);
+      GNUNET_assert (GNUNET_OK ==
+                     GNUNET_CONTAINER_multihashmap32_put (
+                       prefixes,
+                       prefix->hash,
+                       prefix,
+                       GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
+    }
+    entry->prefix = prefix;
+    GNUNET_CONTAINER_MDLL_insert (prefix,
+                                  prefix->entries_head,
+                                  prefix->entries_tail,
+                                  entry);
+    parent = prefix;
+  }
+  GNUNET_CONTAINER_MDLL_insert (end,
+                                parent->ends_head,
+                                parent->ends_tail,
+                                path);
+  for (int i = path->entries_length - 1; i >= (int) off; i--)
+  {
+    struct CadetPeerPathEntry *entry = path->entries[i];
+
+    GCP_path_entry_add (entry->peer,
+                        entry,
+                        i);
+  }
+}
+
+
+/**
+ * Remove @a path from the paths that end with its last prefix.
+ *
+ * @param path path that is about to change its end
+ */
+static void
+remove_end (struct CadetPeerPath *path)
+{
+  struct CadetPathPrefix *prefix
+    = path->entries[path->entries_length - 1]->prefix;
+
+  GNUNET_CONTAINER_MDLL_remove (end,
+                                prefix->ends_head,
+                                prefix->ends_tail,
+                                path);
+}
+
+
+/**
+ * Cut off the last entry of @a path, which must not be used
+ * by a connection.
+ *
+ * @param path path to shorten
+ */
+static void
+trim_path (struct CadetPeerPath *path)
+{
+  unsigned int end = path->entries_length - 1;
+  struct CadetPeerPathEntry *entry = path->entries[end];
+  struct CadetPathPrefix *prefix = entry->prefix;
+
+  GNUNET_assert (NULL == entry->cc);
+  remove_end (path);
+  GCP_path_entry_remove (entry->peer,
+                         entry,
+                         end);
+  GNUNET_CONTAINER_MDLL_remove (prefix,
+                                prefix->entries_head,
+                                prefix->entries_tail,
+                                entry);
+  if (NULL == prefix->entries_head)
+  {
+    /* no path begins with the prefix, so no longer one exists */
+    GNUNET_assert (NULL == prefix->ends_head);
+    GNUNET_assert (GNUNET_YES ==
+                   GNUNET_CONTAINER_multihashmap32_remove (prefixes,
+                                                           prefix->hash,
+                                                           prefix));
+    GNUNET_free (prefix);
+  }
+  GNUNET_free (entry);
+  path->entries[end] = NULL;
+  path->entries_length--;
+  if (0 < path->entries_length)
+  {
+    prefix = path->entries[end - 1]->prefix;
+    GNUNET_CONTAINER_MDLL_insert (end,
+                                  prefix->ends_head,
+                                  prefix->ends_tail,
+                                  path);
+  }
+  if (0 == GNUNET_CONTAINER_multihashmap32_size (prefixes))
+  {
+    GNUNET_CONTAINER_multihashmap32_destroy (prefixes);
+    prefixes = NULL;
+  }
+}
+
+
 /**
  * Calculate the path's desirability score.
  *
@@ -216,13 +531,7 @@ attach_path (struct CadetPeerPath *path, unsigned int stop_at)
       break;
 
     /* Attach failed, trim this entry from the path. */
-    GNUNET_assert (NULL == entry->cc);
-    GCP_path_entry_remove (entry->peer,
-                           entry,
-                           end);
-    GNUNET_free (entry);
-    path->entries[end] = NULL;
-    path->entries_length--;
+    trim_path (path);
   }
 
   /* Shrink array to actual path length. */
@@ -250,14 +559,8 @@ GCPP_release (struct CadetPeerPath *path)
   path->hn = NULL;
   entry = path->entries[path->entries_length - 1];
   GNUNET_assert (path == entry->path);
-  GNUNET_assert (NULL == entry->cc);
   /* cut 'off' end of path */
-  GCP_path_entry_remove (entry->peer,
-                         entry,
-                         path->entries_length - 1);
-  GNUNET_free (entry);
-  path->entries[path->entries_length - 1] = NULL;
-  path->entries_length--;
+  trim_path (path);
   /* see if new peer at the end likes this path any better */
   attach_path (path, 0);
   if (NULL == path->hn)
@@ -307,76 +610,6 @@ GCPP_update_score (struct CadetPeerPath *path,
 }
 
 
-/**
- * Closure for #find_peer_at() and #check_match().
- */
-struct CheckMatchContext
-{
-  /**
-   * Set to a matching path, if any.
-   */
-  struct CadetPeerPath *match;
-
-  /**
-   * Array the combined paths.
-   */
-  struct CadetPeer **cpath;
-
-  /**
-   * How long is the @e cpath array?
-   */
-  unsigned int cpath_length;
-};
-
-
-/**
- * Check if the given path is identical on all of the
- * hops until @a off, and not longer than @a off.  If the
- * @a path matches, store it in `match`.
- *
- * @param cls the `struct CheckMatchContext` to check against
- * @param path the path to check
- * @param off offset to check at
- * @return #GNUNET_YES (continue to iterate), or if found #GNUNET_NO
- */
-static int
-check_match (void *cls,
-             struct CadetPeerPath *path,
-             unsigned int off)
-{
-  struct CheckMatchContext *cm_ctx = cls;
-
-  GNUNET_assert (path->entries_length > off);
-  if ((path->entries_length != off + 1) &&
-      (off + 1 != cm_ctx->cpath_length))
-  {
-    LOG (GNUNET_ERROR_TYPE_DEBUG,
-         "check_match mismatch because path %s is too long (%u vs. %u vs. %u)\n",
-         GCPP_2s (path),
-         path->entries_length,
-         off + 1,
-         cm_ctx->cpath_length);
-    return GNUNET_YES;   /* too long, goes somewhere else already, thus cannot be useful */
-  }
-  for (unsigned int i = 0; i < off; i++)
-    if (cm_ctx->cpath[i] !=
-        GCPP_get_peer_at_offset (path,
-                                 i))
-    {
-      LOG (GNUNET_ERROR_TYPE_DEBUG,
-           "check_match path %s mismatches at offset %u\n",
-           GCPP_2s (path),
-           i);
-      return GNUNET_YES;   /* mismatch, ignore */
-    }
-  LOG (GNUNET_ERROR_TYPE_DEBUG,
-       "check_match found match with path %s\n",
-       GCPP_2s (path));
-  cm_ctx->match = path;
-  return GNUNET_NO; /* match, we are done! */
-}
-
-
 /**
  * Extend path @a path by the @a num_peers from the @a peers
  * array, assuming the owners past the current owner want it.
@@ -397,6 +630,7 @@ extend_path (struct CadetPeerPath *path,
   int i;
 
   /* Expand path */
+  remove_end (path);
   GNUNET_array_grow (path->entries,
                      path->entries_length,
                      old_len + num_peers);
@@ -408,14 +642,8 @@ extend_path (struct CadetPeerPath *path,
     entry->peer = peers_ext[i];
     entry->path = path;
   }
-  for (i = num_peers - 1; i >= 0; i--)
-  {
-    struct CadetPeerPathEntry *entry = path->entries[old_len + i];
-
-    GCP_path_entry_add (entry->peer,
-                        entry,
-                        old_len + i);
-  }
+  index_entries (path,
+                 old_len);
 
   /* If we extend an existing path, detach it from the
      old owner and re-attach to the new one */
@@ -474,8 +702,9 @@ GCPP_try_path_from_dht (const struct GNUNET_DHT_PathElement *get_path,
                         unsigned int put_path_length)
 {
   struct CadetPeer *cpath[get_path_length + put_path_length];
-  struct CheckMatchContext cm_ctx;
+  struct CadetPathPrefix *found[get_path_length + put_path_length];
   struct CadetPeerPath *path;
+  unsigned int num_found;
   unsigned int skip;
   unsigned int total_len;
 
@@ -521,37 +750,31 @@ GCPP_try_path_from_dht (const struct GNUNET_DHT_PathElement *get_path,
 
   /* First figure out if this path is a subset of an existing path, an
      extension of an existing path, or a new path. */
-  cm_ctx.cpath_length = total_len;
-  cm_ctx.cpath = cpath;
-  cm_ctx.match = NULL;
-  for (int i = total_len - 1; i >= 0; i--)
+  num_found = find_prefixes (cpath,
+                             total_len,
+                             found);
+  if (num_found == total_len)
   {
-    GCP_iterate_paths_at (cpath[i],
-                          (unsigned int) i,
-                          &check_match,
-                          &cm_ctx);
-    if (NULL != cm_ctx.match)
-    {
-      if (i == total_len - 1)
-      {
-        /* Existing path includes this one, nothing to do! */
-        LOG (GNUNET_ERROR_TYPE_DEBUG,
-             "Path discovered from DHT is already known\n");
-        return;
-      }
-      if (cm_ctx.match->entries_length == i + 1)
-      {
-        /* Existing path ends in the middle of new path, extend it! */
-        LOG (GNUNET_ERROR_TYPE_DEBUG,
-             "Trying to extend existing path %s by additional links discovered from DHT\n",
-             GCPP_2s (cm_ctx.match));
-        extend_path (cm_ctx.match,
-                     &cpath[i + 1],
-                     total_len - i - 1,
-                     GNUNET_NO);
-        return;
-      }
-    }
+    /* Existing path includes this one, nothing to do! */
+    LOG (GNUNET_ERROR_TYPE_DEBUG,
+         "Path discovered from DHT is already known\n");
+    return;
+  }
+  for (int i = num_found - 1; i >= 0; i--)
+  {
+    struct CadetPeerPath *match = found[i]->ends_head;
+
+    if (NULL == match)
+      continue;
+    /* Existing path ends in the middle of new path, extend it! */
+    LOG (GNUNET_ERROR_TYPE_DEBUG,
+         "Trying to extend existing path %s by additional links discovered from DHT\n",
+         GCPP_2s (match));
+    extend_path (match,
+                 &cpath[i + 1],
+                 total_len - i - 1,
+                 GNUNET_NO);
+    return;
   }
 
   /* No match at all, create completely new path */
@@ -567,14 +790,8 @@ GCPP_try_path_from_dht (const struct GNUNET_DHT_PathElement *get_path,
     entry->peer = cpath[i];
     entry->path = path;
   }
-  for (int i = path->entries_length - 1; i >= 0; i--)
-  {
-    struct CadetPeerPathEntry *entry = path->entries[i];
-
-    GCP_path_entry_add (entry->peer,
-                        entry,
-                        i);
-  }
+  index_entries (path,
+                 0);
 
   /* Finally, try to attach it */
   attach_path (path, 0);
@@ -598,9 +815,10 @@ struct CadetPeerPath *
 GCPP_get_path_from_route (unsigned int path_length,
                           const struct GNUNET_PeerIdentity *pids)
 {
-  struct CheckMatchContext cm_ctx;
   struct CadetPeer *cpath[path_length];
+  struct CadetPathPrefix *found[path_length];
   struct CadetPeerPath *path;
+  unsigned int num_found;
 
   /* precompute inverted 'cpath' so we can avoid doing the lookups and
      have the correct order */
@@ -610,42 +828,34 @@ GCPP_get_path_from_route (unsigned int path_length,
 
   /* First figure out if this path is a subset of an existing path, an
      extension of an existing path, or a new path. */
-  cm_ctx.cpath = cpath;
-  cm_ctx.cpath_length = path_length;
-  cm_ctx.match = NULL;
-  for (int i = path_length - 1; i >= 0; i--)
+  num_found = find_prefixes (cpath,
+                             path_length,
+                             found);
+  if (num_found == path_length)
   {
-    GCP_iterate_paths_at (cpath[i],
-                          (unsigned int) i,
-                          &check_match,
-                          &cm_ctx);
-    if (NULL != cm_ctx.match)
-    {
-      if (i == path_length - 1)
-      {
-        /* Existing path includes this one, return the match! */
-        LOG (GNUNET_ERROR_TYPE_DEBUG,
-             "Returning existing path %s as inverse for incoming connection\n",
-             GCPP_2s (cm_ctx.match));
-        return cm_ctx.match;
-      }
-      if (cm_ctx.match->entries_length == i + 1)
-      {
-        /* Existing path ends in the middle of new path, extend it! */
-        LOG (GNUNET_ERROR_TYPE_DEBUG,
-             "Extending existing path %s to create inverse for incoming connection\n",
-             GCPP_2s (cm_ctx.match));
-        extend_path (cm_ctx.match,
-                     &cpath[i + 1],
-                     path_length - i - 1,
-                     GNUNET_YES);
-        /* Check that extension was successful */
-        GNUNET_assert (cm_ctx.match->entries_length == path_length);
-        return cm_ctx.match;
-      }
-      /* Eh, we found a match but couldn't use it? Something is wrong. */
-      GNUNET_break (0);
-    }
+    /* Existing path includes this one, return the match! */
+    path = found[path_length - 1]->entries_head->path;
+    LOG (GNUNET_ERROR_TYPE_DEBUG,
+         "Returning existing path %s as inverse for incoming connection\n",
+         GCPP_2s (path));
+    return path;
+  }
+  for (int i = num_found - 1; i >= 0; i--)
+  {
+    path = found[i]->ends_head;
+    if (NULL == path)
+      continue;
+    /* Existing path ends in the middle of new path, extend it! */
+    LOG (GNUNET_ERROR_TYPE_DEBUG,
+         "Extending existing path %s to create inverse for incoming connection\n",
+         GCPP_2s (path));
+    extend_path (path,
+                 &cpath[i + 1],
+                 path_length - i - 1,
+                 GNUNET_YES);
+    /* Check that extension was successful */
+    GNUNET_assert (path->entries_length == path_length);
+    return path;
   }
 
   /* No match at all, create completely new path */
@@ -661,14 +871,8 @@ GCPP_get_path_from_route (unsigned int path_length,
     entry->peer = cpath[i];
     entry->path = path;
   }
-  for (int i = path_length - 1; i >= 0; i--)
-  {
-    struct CadetPeerPathEntry *entry = path->entries[i];
-
-    GCP_path_entry_add (entry->peer,
-                        entry,
-                        i);
-  }
+  index_entries (path,
+                 0);
   recalculate_path_desirability (path);
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Created new path %s to create inverse for incoming connection\n",
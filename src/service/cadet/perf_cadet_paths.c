@@ -0,0 +1,412 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file cadet/perf_cadet_paths.c
+ * @brief measure gnunet-service-cadet_paths.c on a relay with many
+ *        paths: ingesting paths from the DHT and finding the paths
+ *        for incoming CREATE messages, compared with finding them by
+ *        scanning the paths of each peer at each offset, as we used to;
+ *        the peer subsystem is replaced by a minimal one that accepts
+ *        every path
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "gnunet-service-cadet.h"
+#include "gnunet-service-cadet_connection.h"
+#include "gnunet-service-cadet_paths.h"
+#include "gnunet-service-cadet_peer.h"
+
+/**
+ * Number of peers we know.
+ */
+#define NUM_PEERS 4096
+
+/**
+ * Number of peers we are connected to, the first hop of all paths.
+ */
+#define NUM_NEIGHBOURS 16
+
+/**
+ * Number of paths we get from the DHT.
+ */
+#define NUM_DHT_PATHS (64 * 1024)
+
+/**
+ * Number of CREATE messages for new routes.
+ */
+#define NUM_ROUTES (16 * 1024)
+
+/**
+ * Maximum length of a path.
+ */
+#define MAX_PATH_LENGTH 8
+
+
+/**
+ * Our replacement for the peer subsystem.
+ */
+struct CadetPeer
+{
+  struct GNUNET_PeerIdentity pid;
+
+  /**
+   * Paths owned by the peer.
+   */
+  struct GNUNET_CONTAINER_Heap *path_heap;
+
+  /**
+   * DLLs of the entries of the paths the peer is on, by offset.
+   */
+  struct CadetPeerPathEntry *path_heads[MAX_PATH_LENGTH];
+
+  /**
+   * DLLs of the entries of the paths the peer is on, by offset.
+   */
+  struct CadetPeerPathEntry *path_tails[MAX_PATH_LENGTH];
+};
+
+
+struct GNUNET_PeerIdentity my_full_id;
+
+static struct CadetPeer all_peers[NUM_PEERS];
+
+static struct GNUNET_CONTAINER_MultiPeerMap *peer_map;
+
+/**
+ * Number of path entries of all peers.
+ */
+static unsigned long long num_entries;
+
+
+double
+GCP_get_desirability_of_path (struct CadetPeer *cp,
+                              unsigned int off)
+{
+  return 1.0;
+}
+
+
+void
+GCP_path_entry_add (struct CadetPeer *cp,
+                    struct CadetPeerPathEntry *entry,
+                    unsigned int off)
+{
+  GNUNET_assert (off < MAX_PATH_LENGTH);
+  GNUNET_CONTAINER_DLL_insert (cp->path_heads[off],
+                               cp->path_tails[off],
+                               entry);
+  num_entries++;
+}
+
+
+void
+GCP_path_entry_remove (struct CadetPeer *cp,
+                       struct CadetPeerPathEntry *entry,
+                       unsigned int off)
+{
+  GNUNET_CONTAINER_DLL_remove (cp->path_heads[off],
+                               cp->path_tails[off],
+                               entry);
+  num_entries--;
+}
+
+
+struct GNUNET_CONTAINER_HeapNode *
+GCP_attach_path (struct CadetPeer *cp,
+                 struct CadetPeerPath *path,
+                 unsigned int off,
+                 int force)
+{
+  if (NULL == cp->path_heap)
+    return NULL;
+  return GNUNET_CONTAINER_heap_insert (cp->path_heap,
+                                       path,
+                                       GCPP_get_desirability (path));
+}
+
+
+void
+GCP_detach_path (struct CadetPeer *cp,
+                 struct CadetPeerPath *path,
+                 struct GNUNET_CONTAINER_HeapNode *hn)
+{
+  GNUNET_assert (path ==
+                 GNUNET_CONTAINER_heap_remove_node (hn));
+}
+
+
+struct CadetPeer *
+GCP_get (const struct GNUNET_PeerIdentity *peer_id,
+         int create)
+{
+  struct CadetPeer *cp;
+
+  cp = GNUNET_CONTAINER_multipeermap_get (peer_map,
+                                          peer_id);
+  GNUNET_assert (NULL != cp);
+  return cp;
+}
+
+
+const struct GNUNET_PeerIdentity *
+GCP_get_id (struct CadetPeer *cp)
+{
+  return &cp->pid;
+}
+
+
+const char *
+GCC_2s (const struct CadetConnection *cc)
+{
+  return "cc";
+}
+
+
+static void
+report (const char *mode,
+        struct GNUNET_TIME_Absolute start,
+        unsigned long long ops)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %llu paths in %s (%llu/s)\n",
+          mode,
+          ops,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          ops * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+/**
+ * Pick a random path of peers, starting at a neighbour.
+ *
+ * @param[out] cpath where to store the path
+ * @return length of the path
+ */
+static unsigned int
+random_path (struct CadetPeer **cpath)
+{
+  unsigned int len;
+
+  len = 2 + GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                      MAX_PATH_LENGTH - 1);
+  cpath[0] = &all_peers[GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                              NUM_NEIGHBOURS)];
+  for (unsigned int i = 1; i < len; i++)
+  {
+    bool dup;
+
+    do
+    {
+      cpath[i] = &all_peers[NUM_NEIGHBOURS
+                        + GNUNET_CRYPTO_random_u32 (
+                          GNUNET_CRYPTO_QUALITY_WEAK,
+                          NUM_PEERS - NUM_NEIGHBOURS)];
+      dup = false;
+      for (unsigned int j = 1; j < i; j++)
+        dup |= (cpath[j] == cpath[i]);
+    }
+    while (dup);
+  }
+  return len;
+}
+
+
+/**
+ * Find a path for @a cpath by scanning the paths of each peer at
+ * its offset, as GCPP_get_path_from_route() used to.
+ *
+ * @return the path that includes @a cpath or ends on it, NULL for none
+ */
+static struct CadetPeerPath *
+scan_route (struct CadetPeer **cpath,
+            unsigned int len)
+{
+  for (int i = len - 1; i >= 0; i--)
+  {
+    for (struct CadetPeerPathEntry *pe = cpath[i]->path_heads[i];
+         NULL != pe;
+         pe = pe->next)
+    {
+      struct CadetPeerPath *path = pe->path;
+      bool match = true;
+
+      if ((GCPP_get_length (path) != i + 1) &&
+          (i + 1 != len))
+        continue;
+      for (int j = 0; j < i; j++)
+        if (cpath[j] != GCPP_get_peer_at_offset (path,
+                                                 j))
+        {
+          match = false;
+          break;
+        }
+      if (match)
+        return path;
+    }
+  }
+  return NULL;
+}
+
+
+/**
+ * Turn @a cpath into a route as found in a CREATE message.
+ */
+static void
+to_route (struct CadetPeer **cpath,
+          unsigned int len,
+          struct GNUNET_PeerIdentity *pids)
+{
+  for (unsigned int i = 0; i < len; i++)
+    pids[len - 1 - i] = cpath[i]->pid;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  static struct CadetPeer *routes[NUM_ROUTES][MAX_PATH_LENGTH];
+  static unsigned int route_lengths[NUM_ROUTES];
+  struct CadetPeer *cpath[MAX_PATH_LENGTH];
+  struct GNUNET_DHT_PathElement get_path[MAX_PATH_LENGTH];
+  struct GNUNET_PeerIdentity pids[MAX_PATH_LENGTH];
+  struct GNUNET_TIME_Absolute start;
+  struct CadetPeerPath *path;
+  unsigned int found = 0;
+
+  GNUNET_log_setup ("perf-cadet-paths",
+                    "WARNING",
+                    NULL);
+  GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_WEAK,
+                              &my_full_id,
+                              sizeof (my_full_id));
+  peer_map = GNUNET_CONTAINER_multipeermap_create (NUM_PEERS,
+                                                   GNUNET_YES);
+  for (unsigned int i = 0; i < NUM_PEERS; i++)
+  {
+    GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_WEAK,
+                                &all_peers[i].pid,
+                                sizeof (all_peers[i].pid));
+    all_peers[i].path_heap
+      = GNUNET_CONTAINER_heap_create (GNUNET_CONTAINER_HEAP_ORDER_MIN);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multipeermap_put (
+                     peer_map,
+                     &all_peers[i].pid,
+                     &all_peers[i],
+                     GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+  }
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_DHT_PATHS; n++)
+  {
+    unsigned int len = random_path (cpath);
+
+    /* the GET path lists the peers from the far end to us */
+    for (unsigned int i = 0; i < len; i++)
+      get_path[len - 1 - i].pred = cpath[i]->pid;
+    GCPP_try_path_from_dht (get_path,
+                            len,
+                            NULL,
+                            0);
+  }
+  report ("DHT paths, index",
+          start,
+          NUM_DHT_PATHS);
+  printf ("%llu path entries\n",
+          num_entries);
+
+  /* routes of CREATE messages we do not know paths for yet */
+  for (unsigned int n = 0; n < NUM_ROUTES; n++)
+    route_lengths[n] = random_path (routes[n]);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_ROUTES; n++)
+    if (NULL != scan_route (routes[n],
+                            route_lengths[n]))
+      found++;
+  report ("new routes, scan (lookup only)",
+          start,
+          NUM_ROUTES);
+  printf ("%u of them already known\n",
+          found);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_ROUTES; n++)
+  {
+    to_route (routes[n],
+              route_lengths[n],
+              pids);
+    path = GCPP_get_path_from_route (route_lengths[n],
+                                     pids);
+    GNUNET_assert (GCPP_get_length (path) >= route_lengths[n]);
+  }
+  report ("new routes, index",
+          start,
+          NUM_ROUTES);
+
+  /* the same routes again, now all of them are known */
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_ROUTES; n++)
+    GNUNET_assert (NULL != scan_route (routes[n],
+                                       route_lengths[n]));
+  report ("known routes, scan",
+          start,
+          NUM_ROUTES);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int n = 0; n < NUM_ROUTES; n++)
+  {
+    to_route (routes[n],
+              route_lengths[n],
+              pids);
+    path = GCPP_get_path_from_route (route_lengths[n],
+                                     pids);
+    for (unsigned int i = 0; i < route_lengths[n]; i++)
+      GNUNET_assert (routes[n][i] ==
+                     GCPP_get_peer_at_offset (path,
+                                              i));
+  }
+  report ("known routes, index",
+          start,
+          NUM_ROUTES);
+
+  /* shut down like GCP_drop_owned_paths() */
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_PEERS; i++)
+  {
+    struct GNUNET_CONTAINER_Heap *heap = all_peers[i].path_heap;
+
+    all_peers[i].path_heap = NULL;
+    while (NULL != (path = GNUNET_CONTAINER_heap_remove_root (heap)))
+      GCPP_release (path);
+    GNUNET_CONTAINER_heap_destroy (heap);
+  }
+  report ("release",
+          start,
+          NUM_DHT_PATHS + NUM_ROUTES);
+  GNUNET_assert (0 == num_entries);
+  GNUNET_CONTAINER_multipeermap_destroy (peer_map);
+  return 0;
+}
+
+
+/* end of perf_cadet_paths.c */
@@ -49,11 +49,12 @@
         GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MINUTES, 15)
 
 /**
- * How fast are we allowed to query the database for deleting
- * expired content? (1 item per second).
+ * How many items do we remove from the database at most in one go
+ * when deleting expired content or making room for new content?
+ * Bigger batches are cheaper per item, but we must not keep the
+ * database (and thus clients) waiting for too long.
  */
-#define MIN_EXPIRE_DELAY \
-        GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_SECONDS, 1)
+#define REMOVE_BATCH_SIZE 128
 
 /**
  * Name under which we store current space consumption.
@@ -188,6 +189,17 @@ static unsigned long long payload;
  */
 static struct GNUNET_SCHEDULER_Task *expired_kill_task;
 
+/**
+ * Task that continues to discard content to stay below the quota.
+ */
+static struct GNUNET_SCHEDULER_Task *manage_space_task;
+
+/**
+ * How many bytes do we still have to discard to stay below the
+ * quota?
+ */
+static unsigned long long space_needed;
+
 /**
  * Minimum time that content should have to not be discarded instantly
  * (time stamp of any content that we've been discarding recently to
@@ -257,148 +269,115 @@ static struct GNUNET_STATISTICS_GetHandle *stat_get;
 static struct GNUNET_SERVICE_Handle *service;
 
 /**
- * Task that is used to remove expired entries from
- * the datastore.  This task will schedule itself
- * again automatically to always delete all expired
- * content quickly.
+ * Process an expired item that was deleted from the datastore.
  *
- * @param cls not used
- */
-static void
-delete_expired (void *cls);
-
-
-/**
- * Iterate over the expired items stored in the datastore.
- * Delete all expired items; once we have processed all
- * expired items, re-schedule the "delete_expired" task.
- *
- * @param cls not used
+ * @param cls pointer to the number of bytes deleted so far
  * @param key key for the content
  * @param size number of bytes in data
- * @param data content stored
  * @param type type of the content
  * @param priority priority of the content
- * @param anonymity anonymity-level for the content
- * @param replication replication-level for the content
  * @param expiration expiration time for the content
- * @param uid unique identifier for the datum;
- *        maybe 0 if no unique identifier is available
- *
- * @return #GNUNET_SYSERR to abort the iteration, #GNUNET_OK to continue
- *         (continue on call to "next", of course),
- *         #GNUNET_NO to delete the item and continue (if supported)
+ * @return #GNUNET_OK to continue deleting
  */
-static int
+static enum GNUNET_GenericReturnValue
 expired_processor (void *cls,
                    const struct GNUNET_HashCode *key,
                    uint32_t size,
-                   const void *data,
                    enum GNUNET_BLOCK_Type type,
                    uint32_t priority,
-                   uint32_t anonymity,
-                   uint32_t replication,
-                   struct GNUNET_TIME_Absolute expiration,
-                   uint64_t uid)
+                   struct GNUNET_TIME_Absolute expiration)
 {
-  struct GNUNET_TIME_Absolute now;
+  unsigned long long *bytes = cls;
 
-  if (NULL == key)
-  {
-    expired_kill_task =
-      GNUNET_SCHEDULER_add_delayed_with_priority (MAX_EXPIRE_DELAY,
-                                                  GNUNET_SCHEDULER_PRIORITY_IDLE,
-                                                  &delete_expired,
-                                                  NULL);
-    return GNUNET_SYSERR;
-  }
-  now = GNUNET_TIME_absolute_get ();
-  if (expiration.abs_value_us > now.abs_value_us)
-  {
-    /* finished processing */
-    expired_kill_task =
-      GNUNET_SCHEDULER_add_delayed_with_priority (MAX_EXPIRE_DELAY,
-                                                  GNUNET_SCHEDULER_PRIORITY_IDLE,
-                                                  &delete_expired,
-                                                  NULL);
-    return GNUNET_SYSERR;
-  }
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "Deleting content `%s' of type %u that expired %s ago\n",
+              "Deleted content `%s' of type %u that expired %s ago\n",
               GNUNET_h2s (key),
               type,
               GNUNET_STRINGS_relative_time_to_string (
-                GNUNET_TIME_absolute_get_difference (expiration, now),
+                GNUNET_TIME_absolute_get_duration (expiration),
                 GNUNET_YES));
-  min_expiration = now;
-  GNUNET_STATISTICS_update (stats,
-                            gettext_noop ("# bytes expired"),
-                            size,
-                            GNUNET_YES);
+  *bytes += size;
   GNUNET_CONTAINER_bloomfilter_remove (filter, key);
-  expired_kill_task =
-    GNUNET_SCHEDULER_add_delayed_with_priority (MIN_EXPIRE_DELAY,
-                                                GNUNET_SCHEDULER_PRIORITY_IDLE,
-                                                &delete_expired,
-                                                NULL);
-  return GNUNET_NO;
+  return GNUNET_OK;
 }
 
 
 /**
  * Task that is used to remove expired entries from
- * the datastore.  This task will schedule itself
- * again automatically to always delete all expired
- * content quickly.
+ * the datastore.  Removes a batch of expired entries at
+ * a time, and schedules itself again right away (at idle
+ * priority, so that we keep serving requests) until all
+ * expired content is gone.
  *
  * @param cls not used
  */
 static void
 delete_expired (void *cls)
 {
+  struct GNUNET_TIME_Absolute now;
+  unsigned long long bytes;
+  unsigned int removed;
+
   expired_kill_task = NULL;
-  plugin->api->get_expiration (plugin->api->cls, &expired_processor, NULL);
+  now = GNUNET_TIME_absolute_get ();
+  bytes = 0;
+  removed = plugin->api->remove_batch (plugin->api->cls,
+                                       now,
+                                       false,
+                                       REMOVE_BATCH_SIZE,
+                                       &expired_processor,
+                                       &bytes);
+  if (0 != removed)
+  {
+    min_expiration = now;
+    GNUNET_STATISTICS_update (stats,
+                              gettext_noop ("# bytes expired"),
+                              bytes,
+                              GNUNET_YES);
+  }
+  if (REMOVE_BATCH_SIZE == removed)
+  {
+    /* there is likely more expired content, continue soon */
+    expired_kill_task =
+      GNUNET_SCHEDULER_add_with_priority (GNUNET_SCHEDULER_PRIORITY_IDLE,
+                                          &delete_expired,
+                                          NULL);
+    return;
+  }
+  expired_kill_task =
+    GNUNET_SCHEDULER_add_delayed_with_priority (MAX_EXPIRE_DELAY,
+                                                GNUNET_SCHEDULER_PRIORITY_IDLE,
+                                                &delete_expired,
+                                                NULL);
 }
 
 
 /**
- * An iterator over a set of items stored in the datastore
- * that deletes until we're happy with respect to our quota.
+ * Process a low-priority item that was deleted from the
+ * datastore to stay below our quota.
  *
- * @param cls closure
+ * @param cls pointer to the number of bytes deleted so far
  * @param key key for the content
  * @param size number of bytes in data
- * @param data content stored
  * @param type type of the content
  * @param priority priority of the content
- * @param anonymity anonymity-level for the content
- * @param replication replication-level for the content
  * @param expiration expiration time for the content
- * @param uid unique identifier for the datum;
- *        maybe 0 if no unique identifier is available
- * @return #GNUNET_SYSERR to abort the iteration, #GNUNET_OK to continue
- *         (continue on call to "next", of course),
- *         #GNUNET_NO to delete the item and continue (if supported)
+ * @return #GNUNET_OK to continue deleting, #GNUNET_NO if we
+ *         freed enough space
  */
-static int
+static enum GNUNET_GenericReturnValue
 quota_processor (void *cls,
                  const struct GNUNET_HashCode *key,
                  uint32_t size,
-                 const void *data,
                  enum GNUNET_BLOCK_Type type,
                  uint32_t priority,
-                 uint32_t anonymity,
-                 uint32_t replication,
-                 struct GNUNET_TIME_Absolute expiration,
-                 uint64_t uid)
+                 struct GNUNET_TIME_Absolute expiration)
 {
-  unsigned long long *need = cls;
+  unsigned long long *bytes = cls;
 
-  if (NULL == key)
-    return GNUNET_SYSERR;
   GNUNET_log (
     GNUNET_ERROR_TYPE_DEBUG,
-    "Deleting %llu bytes of low-priority (%u) content `%s' of type %u at %s prior to expiration (still trying to free another %llu bytes)\n",
+    "Deleted %llu bytes of low-priority (%u) content `%s' of type %u at %s prior to expiration (still trying to free another %llu bytes)\n",
     (unsigned long long) (size + GNUNET_DATASTORE_ENTRY_OVERHEAD),
     (unsigned int) priority,
     GNUNET_h2s (key),
@@ -406,21 +385,58 @@ quota_processor (void *cls,
     GNUNET_STRINGS_relative_time_to_string (GNUNET_TIME_absolute_get_remaining (
                                               expiration),
                                             GNUNET_YES),
-    *need);
-  if (size + GNUNET_DATASTORE_ENTRY_OVERHEAD > *need)
-    *need = 0;
+    space_needed);
+  if (size + GNUNET_DATASTORE_ENTRY_OVERHEAD > space_needed)
+    space_needed = 0;
   else
-    *need -= size + GNUNET_DATASTORE_ENTRY_OVERHEAD;
+    space_needed -= size + GNUNET_DATASTORE_ENTRY_OVERHEAD;
   if (priority > 0)
     min_expiration = GNUNET_TIME_UNIT_FOREVER_ABS;
   else
     min_expiration = expiration;
-  GNUNET_STATISTICS_update (stats,
-                            gettext_noop ("# bytes purged (low-priority)"),
-                            size,
-                            GNUNET_YES);
+  *bytes += size;
   GNUNET_CONTAINER_bloomfilter_remove (filter, key);
-  return GNUNET_NO;
+  return (0 == space_needed) ? GNUNET_NO : GNUNET_OK;
+}
+
+
+/**
+ * Task that discards a batch of low-priority content to
+ * free #space_needed bytes, and schedules itself again (at
+ * idle priority) if that was not enough.
+ *
+ * @param cls not used
+ */
+static void
+discard_content (void *cls)
+{
+  unsigned long long bytes;
+  unsigned int removed;
+
+  manage_space_task = NULL;
+  bytes = 0;
+  removed = plugin->api->remove_batch (plugin->api->cls,
+                                       GNUNET_TIME_absolute_get (),
+                                       true,
+                                       REMOVE_BATCH_SIZE,
+                                       &quota_processor,
+                                       &bytes);
+  if (0 != removed)
+    GNUNET_STATISTICS_update (stats,
+                              gettext_noop ("# bytes purged (low-priority)"),
+                              bytes,
+                              GNUNET_YES);
+  if ( (0 == space_needed) ||
+       (REMOVE_BATCH_SIZE != removed) )
+  {
+    /* done, or nothing left to discard */
+    space_needed = 0;
+    return;
+  }
+  manage_space_task =
+    GNUNET_SCHEDULER_add_with_priority (GNUNET_SCHEDULER_PRIORITY_IDLE,
+                                        &discard_content,
+                                        NULL);
 }
 
 
@@ -439,17 +455,13 @@ quota_processor (void *cls,
 static void
 manage_space (unsigned long long need)
 {
-  unsigned long long last;
-
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Asked to free up %llu bytes of cache space\n",
               need);
-  last = 0;
-  while ((need > 0) && (last != need))
-  {
-    last = need;
-    plugin->api->get_expiration (plugin->api->cls, &quota_processor, &need);
-  }
+  space_needed += need;
+  if (NULL != manage_space_task)
+    return; /* already discarding content, will also free this */
+  discard_content (NULL);
 }
 
 
@@ -1333,6 +1345,11 @@ cleaning_task (void *cls)
     GNUNET_SCHEDULER_cancel (expired_kill_task);
     expired_kill_task = NULL;
   }
+  if (NULL != manage_space_task)
+  {
+    GNUNET_SCHEDULER_cancel (manage_space_task);
+    manage_space_task = NULL;
+  }
   if (GNUNET_YES == do_drop)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
@@ -25,6 +25,7 @@
  * @author Nathan Evans
  */
 #include "gnunet-service-dht_clients.h"
+#include "gnunet_block_group_lib.h"
 
 /**
  * Enable slow sanity checks to debug issues.
@@ -86,6 +87,13 @@ struct ClientQueryRecord
    */
   struct GNUNET_HashCode *seen_replies;
 
+  /**
+   * Block group with the @e seen_replies, kept across retransmissions
+   * so that only new replies need to be added.  NULL if not yet
+   * created or not supported by the block type.
+   */
+  struct GNUNET_BLOCK_Group *bg;
+
   /**
    * Pointer to this nodes heap location in the retry-heap (for fast removal)
    */
@@ -117,6 +125,16 @@ struct ClientQueryRecord
    */
   unsigned int seen_replies_count;
 
+  /**
+   * Number of entries of @e seen_replies already added to @e bg.
+   */
+  unsigned int bg_seen_count;
+
+  /**
+   * Number of replies @e bg was sized for.
+   */
+  unsigned int bg_seen_size;
+
   /**
    * Desired replication level
    */
@@ -279,6 +297,7 @@ remove_client_query_record (struct ClientQueryRecord *record)
   GNUNET_array_grow (record->seen_replies,
                      record->seen_replies_count,
                      0);
+  GNUNET_BLOCK_group_destroy (record->bg);
   GNUNET_free (record);
 }
 
@@ -364,23 +383,41 @@ client_disconnect_cb (void *cls,
 static void
 transmit_request (struct ClientQueryRecord *cqr)
 {
-  struct GNUNET_BLOCK_Group *bg;
   struct GNUNET_CONTAINER_BloomFilter *peer_bf;
 
   GNUNET_STATISTICS_update (GDS_stats,
                             "# GET requests from clients injected",
                             1,
                             GNUNET_NO);
-  bg = GNUNET_BLOCK_group_create (GDS_block_context,
-                                  cqr->type,
-                                  NULL, /* raw data */
-                                  0, /* raw data size */
-                                  "seen-set-size",
-                                  cqr->seen_replies_count,
-                                  NULL);
-  GNUNET_BLOCK_group_set_seen (bg,
-                               cqr->seen_replies,
-                               cqr->seen_replies_count);
+  if ( (NULL == cqr->bg) ||
+       (GNUNET_BLOCK_GROUP_compute_bloomfilter_size (
+          cqr->seen_replies_count,
+          GNUNET_CONSTANTS_BLOOMFILTER_K) >
+        GNUNET_BLOCK_GROUP_compute_bloomfilter_size (
+          cqr->bg_seen_size,
+          GNUNET_CONSTANTS_BLOOMFILTER_K)) )
+  {
+    /* (re)create the group, leaving room for as many replies again
+       so that we do not have to do this on every retransmission */
+    GNUNET_BLOCK_group_destroy (cqr->bg);
+    cqr->bg_seen_size = 2 * cqr->seen_replies_count;
+    cqr->bg_seen_count = 0;
+    cqr->bg = GNUNET_BLOCK_group_create (GDS_block_context,
+                                         cqr->type,
+                                         NULL, /* raw data */
+                                         0, /* raw data size */
+                                         "seen-set-size",
+                                         cqr->bg_seen_size,
+                                         NULL);
+    GNUNET_STATISTICS_update (GDS_stats,
+                              "# Block groups created for client GETs",
+                              1,
+                              GNUNET_NO);
+  }
+  GNUNET_BLOCK_group_set_seen (cqr->bg,
+                               &cqr->seen_replies[cqr->bg_seen_count],
+                               cqr->seen_replies_count - cqr->bg_seen_count);
+  cqr->bg_seen_count = cqr->seen_replies_count;
   peer_bf
     = GNUNET_CONTAINER_bloomfilter_init (NULL,
                                          DHT_BLOOM_SIZE,
@@ -397,9 +434,8 @@ transmit_request (struct ClientQueryRecord *cqr)
                              &cqr->key,
                              cqr->xquery,
                              cqr->xquery_size,
-                             bg,
+                             cqr->bg,
                              peer_bf);
-  GNUNET_BLOCK_group_destroy (bg);
   GNUNET_CONTAINER_bloomfilter_free (peer_bf);
 
   /* Exponential back-off for retries.
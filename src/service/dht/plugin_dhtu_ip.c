@@ -29,10 +29,17 @@
 #include "plugin_dhtu_ip.h"
 
 /**
- * How frequently should we re-scan our local interfaces for IPs?
+ * How frequently should we re-scan our local interfaces for IPs
+ * if we are not notified about changes?
  */
 #define SCAN_FREQ GNUNET_TIME_UNIT_MINUTES
 
+/**
+ * How long do we keep a source we are not (or no longer) finding on
+ * our interfaces after we last received traffic on it?
+ */
+#define SOURCE_TIMEOUT GNUNET_TIME_relative_multiply (SCAN_FREQ, 60)
+
 /**
  * Maximum number of concurrently active destinations to support.
  */
@@ -77,9 +84,15 @@ struct GNUNET_DHTU_Source
   socklen_t addrlen;
 
   /**
-   * Last generation this address was observed.
+   * When do we forget this source if it is not on any of our
+   * interfaces?
+   */
+  struct GNUNET_TIME_Absolute expiration;
+
+  /**
+   * Number of our interfaces currently having this address.
    */
-  unsigned int scan_generation;
+  unsigned int ifc_count;
 
 };
 
@@ -198,9 +211,14 @@ struct Plugin
   struct GNUNET_CONTAINER_MultiHashMap *dsts;
 
   /**
-   * Task that scans for IP address changes.
+   * Monitor telling us about IP address changes.
    */
-  struct GNUNET_SCHEDULER_Task *scan_task;
+  struct GNUNET_OS_NetworkInterfaceMonitor *ifc_mon;
+
+  /**
+   * Task that expires sources that are not on our interfaces.
+   */
+  struct GNUNET_SCHEDULER_Task *expire_task;
 
   /**
    * Task that reads incoming UDP packets.
@@ -222,11 +240,6 @@ struct Plugin
    */
   struct GNUNET_PeerIdentity my_id;
 
-  /**
-   * How often have we scanned for IPs?
-   */
-  unsigned int scan_generation;
-
   /**
    * Port as a 16-bit value.
    */
@@ -517,7 +530,6 @@ create_source (struct Plugin *plugin,
   memcpy (&src->addr,
           addr,
           addrlen);
-  src->scan_generation = plugin->scan_generation;
   switch (addr->sa_family)
   {
   case AF_INET:
@@ -662,29 +674,102 @@ addrcmp (const struct sockaddr *a1,
 
 
 /**
- * Callback function invoked for each interface found.
+ * Forget about a source.
+ *
+ * @param plugin our plugin
+ * @param src source to destroy
+ */
+static void
+destroy_source (struct Plugin *plugin,
+                struct GNUNET_DHTU_Source *src)
+{
+  GNUNET_CONTAINER_DLL_remove (plugin->src_head,
+                               plugin->src_tail,
+                               src);
+  plugin->env->address_del_cb (src->app_ctx);
+  GNUNET_free (src->address);
+  GNUNET_free (src);
+}
+
+
+/**
+ * Forget about sources that are not on our interfaces and on
+ * which we did not receive traffic for a while.
+ *
+ * @param cls a `struct Plugin`
+ */
+static void
+expire_sources (void *cls)
+{
+  struct Plugin *plugin = cls;
+  struct GNUNET_DHTU_Source *next;
+  bool pending = false;
+
+  plugin->expire_task = NULL;
+  for (struct GNUNET_DHTU_Source *src = plugin->src_head;
+       NULL != src;
+       src = next)
+  {
+    next = src->next;
+    if (0 < src->ifc_count)
+      continue;
+    if (GNUNET_TIME_absolute_is_past (src->expiration))
+      destroy_source (plugin,
+                      src);
+    else
+      pending = true;
+  }
+  if (pending)
+    plugin->expire_task = GNUNET_SCHEDULER_add_delayed (SCAN_FREQ,
+                                                        &expire_sources,
+                                                        plugin);
+}
+
+
+/**
+ * Make sure sources that are not on our interfaces expire.
+ *
+ * @param plugin our plugin
+ */
+static void
+schedule_expire (struct Plugin *plugin)
+{
+  if (NULL != plugin->expire_task)
+    return;
+  plugin->expire_task = GNUNET_SCHEDULER_add_delayed (SCAN_FREQ,
+                                                      &expire_sources,
+                                                      plugin);
+}
+
+
+/**
+ * Callback function invoked whenever the addresses of our interfaces
+ * change.
  *
  * @param cls closure
+ * @param change what happened
  * @param name name of the interface (can be NULL for unknown)
  * @param isDefault is this presumably the default interface
- * @param addr address of this interface (can be NULL for unknown or unassigned)
+ * @param addr address of this interface
  * @param broadcast_addr the broadcast address (can be NULL for unknown or unassigned)
  * @param netmask the network mask (can be NULL for unknown or unassigned)
  * @param addrlen length of the address
- * @return #GNUNET_OK to continue iteration, #GNUNET_SYSERR to abort
  */
-static enum GNUNET_GenericReturnValue
-process_ifcs (void *cls,
-              const char *name,
-              int isDefault,
-              const struct sockaddr *addr,
-              const struct sockaddr *broadcast_addr,
-              const struct sockaddr *netmask,
-              socklen_t addrlen)
+static void
+ifc_change_cb (void *cls,
+               enum GNUNET_OS_NetworkInterfaceChange change,
+               const char *name,
+               int isDefault,
+               const struct sockaddr *addr,
+               const struct sockaddr *broadcast_addr,
+               const struct sockaddr *netmask,
+               socklen_t addrlen)
 {
   struct Plugin *plugin = cls;
   struct GNUNET_DHTU_Source *src;
 
+  if (GNUNET_OS_NIC_SYNCED == change)
+    return;
   for (src = plugin->src_head;
        NULL != src;
        src = src->next)
@@ -693,10 +778,26 @@ process_ifcs (void *cls,
          (0 == addrcmp_np (addr,
                            (const struct sockaddr *) &src->addr,
                            addrlen)) )
-    {
-      src->scan_generation = plugin->scan_generation;
-      return GNUNET_OK;
-    }
+      break;
+  }
+  if (GNUNET_OS_NIC_REMOVED == change)
+  {
+    if ( (NULL == src) ||
+         (0 == src->ifc_count) )
+      return;
+    if (0 < --src->ifc_count)
+      return; /* still on another interface */
+    if (GNUNET_TIME_absolute_is_past (src->expiration))
+      destroy_source (plugin,
+                      src);
+    else
+      schedule_expire (plugin);
+    return;
+  }
+  if (NULL != src)
+  {
+    src->ifc_count++;
+    return;
   }
   switch (addr->sa_family)
   {
@@ -709,9 +810,9 @@ process_ifcs (void *cls,
               addr,
               addrlen);
       v4.sin_port = htons (plugin->port16);
-      (void) create_source (plugin,
-                            (const struct sockaddr *) &v4,
-                            sizeof (v4));
+      src = create_source (plugin,
+                           (const struct sockaddr *) &v4,
+                           sizeof (v4));
       break;
     }
   case AF_INET6:
@@ -723,47 +824,14 @@ process_ifcs (void *cls,
               addr,
               addrlen);
       v6.sin6_port = htons (plugin->port16);
-      (void) create_source (plugin,
-                            (const struct sockaddr *) &v6,
-                            sizeof (v6));
+      src = create_source (plugin,
+                           (const struct sockaddr *) &v6,
+                           sizeof (v6));
       break;
     }
   }
-  return GNUNET_OK;
-}
-
-
-/**
- * Scan network interfaces for IP address changes.
- *
- * @param cls a `struct Plugin`
- */
-static void
-scan (void *cls)
-{
-  struct Plugin *plugin = cls;
-  struct GNUNET_DHTU_Source *next;
-
-  plugin->scan_generation++;
-  GNUNET_OS_network_interfaces_list (&process_ifcs,
-                                     plugin);
-  for (struct GNUNET_DHTU_Source *src = plugin->src_head;
-       NULL != src;
-       src = next)
-  {
-    next = src->next;
-    if (src->scan_generation >= plugin->scan_generation)
-      continue;
-    GNUNET_CONTAINER_DLL_remove (plugin->src_head,
-                                 plugin->src_tail,
-                                 src);
-    plugin->env->address_del_cb (src->app_ctx);
-    GNUNET_free (src->address);
-    GNUNET_free (src);
-  }
-  plugin->scan_task = GNUNET_SCHEDULER_add_delayed (SCAN_FREQ,
-                                                    &scan,
-                                                    plugin);
+  if (NULL != src)
+    src->ifc_count++;
 }
 
 
@@ -878,8 +946,11 @@ read_cb (void *cls)
                              &sa_tmp,
                              sizeof (sa_tmp));
           /* For sources we discovered by reading,
-             force the generation far into the future */
-          src->scan_generation = plugin->scan_generation + 60;
+             keep them for a while even if they are not
+             on our interfaces */
+          src->expiration = GNUNET_TIME_relative_to_absolute (SOURCE_TIMEOUT);
+          if (0 == src->ifc_count)
+            schedule_expire (plugin);
         }
         break;
       }
@@ -909,8 +980,11 @@ read_cb (void *cls)
                              &sa_tmp,
                              sizeof (sa_tmp));
           /* For sources we discovered by reading,
-             force the generation far into the future */
-          src->scan_generation = plugin->scan_generation + 60;
+             keep them for a while even if they are not
+             on our interfaces */
+          src->expiration = GNUNET_TIME_relative_to_absolute (SOURCE_TIMEOUT);
+          if (0 == src->ifc_count)
+            schedule_expire (plugin);
           break;
         }
       }
@@ -1110,8 +1184,9 @@ DHTU_ip_init (struct GNUNET_DHTU_PluginEnvironment *env)
                         GNUNET_TIME_UNIT_ZERO_ABS,
                         log (nse) / log (2),
                         -1.0 /* stddev */);
-  plugin->scan_task = GNUNET_SCHEDULER_add_now (&scan,
-                                                plugin);
+  plugin->ifc_mon = GNUNET_OS_network_interfaces_monitor_start (SCAN_FREQ,
+                                                                &ifc_change_cb,
+                                                                plugin);
   api = GNUNET_new (struct GNUNET_DHTU_PluginFunctions);
   api->cls = plugin;
   api->try_connect = &ip_try_connect;
@@ -1144,15 +1219,15 @@ DHTU_ip_done (struct GNUNET_DHTU_PluginFunctions *api)
                                  dst);
     GNUNET_free (dst);
   }
-  while (NULL != (src = plugin->src_head))
+  GNUNET_OS_network_interfaces_monitor_stop (plugin->ifc_mon);
+  if (NULL != plugin->expire_task)
   {
-    plugin->env->address_del_cb (src->app_ctx);
-    GNUNET_CONTAINER_DLL_remove (plugin->src_head,
-                                 plugin->src_tail,
-                                 src);
-    GNUNET_free (src->address);
-    GNUNET_free (src);
+    GNUNET_SCHEDULER_cancel (plugin->expire_task);
+    plugin->expire_task = NULL;
   }
+  while (NULL != (src = plugin->src_head))
+    destroy_source (plugin,
+                    src);
   plugin->env->network_size_cb (plugin->env->cls,
                                 GNUNET_TIME_UNIT_FOREVER_ABS,
                                 0.0,
@@ -1163,7 +1238,6 @@ DHTU_ip_done (struct GNUNET_DHTU_PluginFunctions *api)
     GNUNET_SCHEDULER_cancel (plugin->read_task);
     plugin->read_task = NULL;
   }
-  GNUNET_SCHEDULER_cancel (plugin->scan_task);
   GNUNET_break (GNUNET_OK ==
                 GNUNET_NETWORK_socket_close (plugin->sock));
   GNUNET_free (plugin->port);
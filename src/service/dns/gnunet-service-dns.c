@@ -48,6 +48,25 @@
  */
 #define DNS_PORT 53
 
+/**
+ * Bit we set in the request ID when we show a request to a monitor.
+ * Monitors cannot change requests, so we do not wait for their
+ * responses; the bit tells us to ignore them.
+ */
+#define MONITOR_TAG ((uint64_t) 1 << 31)
+
+/**
+ * How many messages may be queued for a monitor before we stop
+ * showing it requests (until it catches up).
+ */
+#define MAX_MONITOR_QUEUE 256
+
+/**
+ * How many replies may be queued for the hijacker before we drop
+ * further replies (as the TUN interface would).
+ */
+#define MAX_HELPER_QUEUE 256
+
 
 /**
  * Generic logging shorthand
@@ -66,12 +85,6 @@ enum RequestPhase
    */
   RP_INIT,
 
-  /**
-   * Showing the request to all monitor clients.  If
-   * client list is empty, will enter QUERY phase.
-   */
-  RP_REQUEST_MONITOR,
-
   /**
    * Showing the request to PRE-RESOLUTION clients to find an answer.
    * If client list is empty, will trigger global DNS request.
@@ -91,8 +104,8 @@ enum RequestPhase
   RP_MODIFY,
 
   /**
-   * Showing the request to all monitor clients.  If
-   * client list is empty, give the result to the hijacker (and be done).
+   * Response is final and has been shown to all monitor clients;
+   * give the result to the hijacker (and be done).
    */
   RP_RESPONSE_MONITOR,
 
@@ -169,9 +182,8 @@ struct RequestRecord
   struct sockaddr_storage dst_addr;
 
   /**
-   * ID of this request, also basis for hashing.  Lowest 16 bit will
-   * be our message ID when doing a global DNS request and our index
-   * into the 'requests' array.
+   * ID of this request.  The upper 32 bits are the key of the request
+   * in the #requests map, see #get_request_key().
    */
   uint64_t request_id;
 
@@ -189,6 +201,38 @@ struct RequestRecord
    * In which phase this this request?
    */
   enum RequestPhase phase;
+
+  /**
+   * DNS ID the request had when we received it from the hijacker.
+   */
+  uint16_t dns_id;
+};
+
+
+/**
+ * Closure for #find_by_source() and #find_by_id().
+ */
+struct FindRequestContext
+{
+  /**
+   * Source address of the request we are looking for.
+   */
+  const struct sockaddr_storage *src_addr;
+
+  /**
+   * ID of the request we are looking for.
+   */
+  uint64_t request_id;
+
+  /**
+   * DNS ID of the request we are looking for.
+   */
+  uint16_t dns_id;
+
+  /**
+   * Set to the request we found.
+   */
+  struct RequestRecord *rr;
 };
 
 
@@ -212,6 +256,11 @@ static struct GNUNET_STATISTICS_Handle *stats;
  */
 static struct GNUNET_HELPER_Handle *hijacker;
 
+/**
+ * Number of replies queued for the #hijacker.
+ */
+static unsigned int helper_queue;
+
 /**
  * Command-line arguments we are giving to the hijacker process.
  */
@@ -228,14 +277,35 @@ static struct ClientRecord *clients_head;
 static struct ClientRecord *clients_tail;
 
 /**
- * Array of all open requests.
+ * Map of all open requests, by the key #get_request_key() computes
+ * from their source address, source port and DNS ID.
  */
-static struct RequestRecord requests[UINT16_MAX + 1];
+static struct GNUNET_CONTAINER_MultiHashMap32 *requests;
 
 /**
  * Generator for unique request IDs.
  */
-static uint64_t request_id_gen;
+static uint32_t request_id_gen;
+
+/**
+ * Number of clients with #GNUNET_DNS_FLAG_REQUEST_MONITOR.
+ */
+static unsigned int request_monitors;
+
+/**
+ * Number of clients with #GNUNET_DNS_FLAG_PRE_RESOLUTION.
+ */
+static unsigned int pre_resolution_clients;
+
+/**
+ * Number of clients with #GNUNET_DNS_FLAG_POST_RESOLUTION.
+ */
+static unsigned int post_resolution_clients;
+
+/**
+ * Number of clients with #GNUNET_DNS_FLAG_RESPONSE_MONITOR.
+ */
+static unsigned int response_monitors;
 
 /**
  * Handle to the DNS Stub resolver.
@@ -243,6 +313,183 @@ static uint64_t request_id_gen;
 static struct GNUNET_DNSSTUB_Context *dnsstub;
 
 
+/**
+ * Compute the key of a request in the #requests map.  Requests are
+ * identified by their source address, source port and DNS ID, so
+ * that clients using the same DNS ID do not collide.
+ *
+ * @param src_addr source address (and port) of the request
+ * @param dns_id DNS ID of the request
+ * @return key for the #requests map
+ */
+static uint32_t
+get_request_key (const struct sockaddr_storage *src_addr,
+                 uint16_t dns_id)
+{
+  const unsigned char *addr;
+  size_t addr_len;
+  uint16_t port;
+  uint32_t key;
+
+  switch (src_addr->ss_family)
+  {
+  case AF_INET:
+    {
+      const struct sockaddr_in *sa4 = (const struct sockaddr_in *) src_addr;
+
+      addr = (const unsigned char *) &sa4->sin_addr;
+      addr_len = sizeof(sa4->sin_addr);
+      port = sa4->sin_port;
+    }
+    break;
+
+  case AF_INET6:
+    {
+      const struct sockaddr_in6 *sa6 = (const struct sockaddr_in6 *) src_addr;
+
+      addr = (const unsigned char *) &sa6->sin6_addr;
+      addr_len = sizeof(sa6->sin6_addr);
+      port = sa6->sin6_port;
+    }
+    break;
+
+  default:
+    GNUNET_assert (0);
+  }
+  /* FNV-1a */
+  key = 2166136261u;
+  key = (key ^ dns_id) * 16777619u;
+  key = (key ^ port) * 16777619u;
+  for (size_t i = 0; i < addr_len; i++)
+    key = (key ^ addr[i]) * 16777619u;
+  return key;
+}
+
+
+/**
+ * Check if a request came from the source address, port and DNS ID
+ * we are looking for.
+ *
+ * @param cls our `struct FindRequestContext`
+ * @param key unused
+ * @param value a `struct RequestRecord` with matching key
+ * @return #GNUNET_NO if we found the request
+ */
+static enum GNUNET_GenericReturnValue
+find_by_source (void *cls,
+                uint32_t key,
+                void *value)
+{
+  struct FindRequestContext *frc = cls;
+  struct RequestRecord *rr = value;
+
+  (void) key;
+  if ( (rr->dns_id != frc->dns_id) ||
+       (rr->src_addr.ss_family != frc->src_addr->ss_family) )
+    return GNUNET_YES;
+  switch (rr->src_addr.ss_family)
+  {
+  case AF_INET:
+    {
+      const struct sockaddr_in *a = (const struct sockaddr_in *) &rr->src_addr;
+      const struct sockaddr_in *b
+        = (const struct sockaddr_in *) frc->src_addr;
+
+      if ( (a->sin_port != b->sin_port) ||
+           (0 != GNUNET_memcmp (&a->sin_addr,
+                                &b->sin_addr)) )
+        return GNUNET_YES;
+    }
+    break;
+
+  case AF_INET6:
+    {
+      const struct sockaddr_in6 *a
+        = (const struct sockaddr_in6 *) &rr->src_addr;
+      const struct sockaddr_in6 *b
+        = (const struct sockaddr_in6 *) frc->src_addr;
+
+      if ( (a->sin6_port != b->sin6_port) ||
+           (0 != GNUNET_memcmp (&a->sin6_addr,
+                                &b->sin6_addr)) )
+        return GNUNET_YES;
+    }
+    break;
+
+  default:
+    return GNUNET_YES;
+  }
+  frc->rr = rr;
+  return GNUNET_NO;
+}
+
+
+/**
+ * Check if a request has the request ID we are looking for.
+ *
+ * @param cls our `struct FindRequestContext`
+ * @param key unused
+ * @param value a `struct RequestRecord` with matching key
+ * @return #GNUNET_NO if we found the request
+ */
+static enum GNUNET_GenericReturnValue
+find_by_id (void *cls,
+            uint32_t key,
+            void *value)
+{
+  struct FindRequestContext *frc = cls;
+  struct RequestRecord *rr = value;
+
+  (void) key;
+  if (rr->request_id != frc->request_id)
+    return GNUNET_YES;
+  frc->rr = rr;
+  return GNUNET_NO;
+}
+
+
+/**
+ * Find an open request by its request ID.
+ *
+ * @param request_id ID of the request
+ * @return NULL if no such request is open
+ */
+static struct RequestRecord *
+get_request_by_id (uint64_t request_id)
+{
+  struct FindRequestContext frc = {
+    .request_id = request_id
+  };
+
+  GNUNET_CONTAINER_multihashmap32_get_multiple (requests,
+                                                (uint32_t) (request_id >> 32),
+                                                &find_by_id,
+                                                &frc);
+  return frc.rr;
+}
+
+
+/**
+ * Update the number of clients with each flag.
+ *
+ * @param flags flags of a client
+ * @param delta 1 if the client now has @a flags, -1 if it no longer has
+ */
+static void
+count_client_flags (enum GNUNET_DNS_Flags flags,
+                    int delta)
+{
+  if (0 != (flags & GNUNET_DNS_FLAG_REQUEST_MONITOR))
+    request_monitors += delta;
+  if (0 != (flags & GNUNET_DNS_FLAG_PRE_RESOLUTION))
+    pre_resolution_clients += delta;
+  if (0 != (flags & GNUNET_DNS_FLAG_POST_RESOLUTION))
+    post_resolution_clients += delta;
+  if (0 != (flags & GNUNET_DNS_FLAG_RESPONSE_MONITOR))
+    response_monitors += delta;
+}
+
+
 /**
  * We're done processing a DNS request, free associated memory.
  *
@@ -251,12 +498,44 @@ static struct GNUNET_DNSSTUB_Context *dnsstub;
 static void
 cleanup_rr (struct RequestRecord *rr)
 {
+  if (NULL != rr->rs)
+  {
+    GNUNET_DNSSTUB_resolve_cancel (rr->rs);
+    rr->rs = NULL;
+  }
+  GNUNET_assert (GNUNET_YES ==
+                 GNUNET_CONTAINER_multihashmap32_remove (requests,
+                                                         (uint32_t) (rr->
+                                                                     request_id
+                                                                     >> 32),
+                                                         rr));
   GNUNET_free (rr->payload);
-  rr->payload = NULL;
-  rr->payload_length = 0;
   GNUNET_array_grow (rr->client_wait_list,
                      rr->client_wait_list_length,
                      0);
+  GNUNET_free (rr);
+}
+
+
+/**
+ * Clean up an open request during shutdown.
+ *
+ * @param cls NULL
+ * @param key unused
+ * @param value the `struct RequestRecord` to clean up
+ * @return #GNUNET_OK (continue to iterate)
+ */
+static enum GNUNET_GenericReturnValue
+cleanup_request (void *cls,
+                 uint32_t key,
+                 void *value)
+{
+  struct RequestRecord *rr = value;
+
+  (void) cls;
+  (void) key;
+  cleanup_rr (rr);
+  return GNUNET_OK;
 }
 
 
@@ -275,8 +554,14 @@ cleanup_task (void *cls GNUNET_UNUSED)
   }
   for (unsigned int i = 0; i < 8; i++)
     GNUNET_free (helper_argv[i]);
-  for (unsigned int i = 0; i <= UINT16_MAX; i++)
-    cleanup_rr (&requests[i]);
+  if (NULL != requests)
+  {
+    GNUNET_CONTAINER_multihashmap32_iterate (requests,
+                                             &cleanup_request,
+                                             NULL);
+    GNUNET_CONTAINER_multihashmap32_destroy (requests);
+    requests = NULL;
+  }
   if (NULL != stats)
   {
     GNUNET_STATISTICS_destroy (stats,
@@ -291,6 +576,22 @@ cleanup_task (void *cls GNUNET_UNUSED)
 }
 
 
+/**
+ * The hijacker took a reply (or is gone).
+ *
+ * @param cls NULL
+ * @param result #GNUNET_OK on success
+ */
+static void
+reply_sent (void *cls,
+            enum GNUNET_GenericReturnValue result)
+{
+  (void) cls;
+  (void) result;
+  helper_queue--;
+}
+
+
 /**
  * We're done with some request, finish processing.
  *
@@ -451,14 +752,28 @@ request_done (struct RequestRecord *rr)
     }
     /* final checks & sending */
     GNUNET_assert (off == reply_len);
-    (void) GNUNET_HELPER_send (hijacker,
-                               hdr,
-                               GNUNET_YES,
-                               NULL, NULL);
-    GNUNET_STATISTICS_update (stats,
-                              gettext_noop (
-                                "# DNS requests answered via TUN interface"),
-                              1, GNUNET_NO);
+    /* many requests may complete at once, so queue the replies
+       instead of keeping only one */
+    if ( (helper_queue < MAX_HELPER_QUEUE) &&
+         (NULL != GNUNET_HELPER_send (hijacker,
+                                      hdr,
+                                      GNUNET_NO,
+                                      &reply_sent,
+                                      NULL)) )
+    {
+      helper_queue++;
+      GNUNET_STATISTICS_update (stats,
+                                gettext_noop (
+                                  "# DNS requests answered via TUN interface"),
+                                1, GNUNET_NO);
+    }
+    else
+    {
+      GNUNET_STATISTICS_update (stats,
+                                gettext_noop (
+                                  "# DNS replies dropped (TUN interface busy)"),
+                                1, GNUNET_NO);
+    }
   }
   /* clean up, we're done */
   cleanup_rr (rr);
@@ -466,15 +781,17 @@ request_done (struct RequestRecord *rr)
 
 
 /**
- * Show the payload of the given request record to the client
- * (and wait for a response).
+ * Show the payload of the given request record to the client.
  *
  * @param rr request to send to client
  * @param cr client to send the response to
+ * @param request_id request ID to give to the client
+ * @return #GNUNET_SYSERR if the request is too big to send
  */
-static void
+static enum GNUNET_GenericReturnValue
 send_request_to_client (struct RequestRecord *rr,
-                        struct ClientRecord *cr)
+                        struct ClientRecord *cr,
+                        uint64_t request_id)
 {
   struct GNUNET_MQ_Envelope *env;
   struct GNUNET_DNS_Request *req;
@@ -483,8 +800,7 @@ send_request_to_client (struct RequestRecord *rr,
       GNUNET_MAX_MESSAGE_SIZE)
   {
     GNUNET_break (0);
-    cleanup_rr (rr);
-    return;
+    return GNUNET_SYSERR;
   }
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Sending information about request %llu to local client\n",
@@ -493,12 +809,72 @@ send_request_to_client (struct RequestRecord *rr,
                              rr->payload_length,
                              GNUNET_MESSAGE_TYPE_DNS_CLIENT_REQUEST);
   req->reserved = htonl (0);
-  req->request_id = rr->request_id;
+  req->request_id = request_id;
   GNUNET_memcpy (&req[1],
                  rr->payload,
                  rr->payload_length);
   GNUNET_MQ_send (cr->mq,
                   env);
+  return GNUNET_OK;
+}
+
+
+/**
+ * Show the request to all monitor clients with the given @a flag.
+ * Monitors cannot change the request, so we do not wait for them.
+ * Monitors that do not keep up miss requests instead of holding
+ * them up.
+ *
+ * @param rr request to show
+ * @param flag #GNUNET_DNS_FLAG_REQUEST_MONITOR or
+ *        #GNUNET_DNS_FLAG_RESPONSE_MONITOR
+ */
+static void
+notify_monitors (struct RequestRecord *rr,
+                 enum GNUNET_DNS_Flags flag)
+{
+  for (struct ClientRecord *cr = clients_head; NULL != cr; cr = cr->next)
+  {
+    if (0 == (cr->flags & flag))
+      continue;
+    if (GNUNET_MQ_get_length (cr->mq) >= MAX_MONITOR_QUEUE)
+    {
+      GNUNET_STATISTICS_update (stats,
+                                gettext_noop (
+                                  "# Requests not shown to slow monitor"),
+                                1,
+                                GNUNET_NO);
+      continue;
+    }
+    if (GNUNET_OK !=
+        send_request_to_client (rr,
+                                cr,
+                                rr->request_id | MONITOR_TAG))
+      return;
+  }
+}
+
+
+/**
+ * Add all clients with the given @a flag to the list of clients
+ * that must see the request (one after the other) before it can
+ * move on.
+ *
+ * @param rr request to process
+ * @param flag #GNUNET_DNS_FLAG_PRE_RESOLUTION or
+ *        #GNUNET_DNS_FLAG_POST_RESOLUTION
+ */
+static void
+wait_for_clients (struct RequestRecord *rr,
+                  enum GNUNET_DNS_Flags flag)
+{
+  for (struct ClientRecord *cr = clients_head; NULL != cr; cr = cr->next)
+  {
+    if (0 != (cr->flags & flag))
+      GNUNET_array_append (rr->client_wait_list,
+                           rr->client_wait_list_length,
+                           cr);
+  }
 }
 
 
@@ -506,8 +882,9 @@ send_request_to_client (struct RequestRecord *rr,
  * Callback called from DNSSTUB resolver when a resolution
  * succeeded.
  *
- * @param cls NULL
- * @param dns the response itself
+ * @param cls the `struct RequestRecord`
+ * @param dns the response itself, NULL if the stub gave up
+ *        on the request
  * @param r number of bytes in dns
  */
 static void
@@ -526,26 +903,21 @@ static void
 next_phase (struct RequestRecord *rr)
 {
   struct ClientRecord *cr;
-  int nz;
 
   if (rr->phase == RP_DROP)
   {
     cleanup_rr (rr);
     return;
   }
-  nz = -1;
   for (unsigned int j = 0; j < rr->client_wait_list_length; j++)
   {
-    if (NULL != rr->client_wait_list[j])
-    {
-      nz = (int) j;
-      break;
-    }
-  }
-  if (-1 != nz)
-  {
-    send_request_to_client (rr,
-                            rr->client_wait_list[nz]);
+    if (NULL == (cr = rr->client_wait_list[j]))
+      continue;
+    if (GNUNET_OK !=
+        send_request_to_client (rr,
+                                cr,
+                                rr->request_id))
+      cleanup_rr (rr);
     return;
   }
   /* done with current phase, advance! */
@@ -556,26 +928,14 @@ next_phase (struct RequestRecord *rr)
   switch (rr->phase)
   {
   case RP_INIT:
-    rr->phase = RP_REQUEST_MONITOR;
-    for (cr = clients_head; NULL != cr; cr = cr->next)
-    {
-      if (0 != (cr->flags & GNUNET_DNS_FLAG_REQUEST_MONITOR))
-        GNUNET_array_append (rr->client_wait_list,
-                             rr->client_wait_list_length,
-                             cr);
-    }
-    next_phase (rr);
-    return;
-
-  case RP_REQUEST_MONITOR:
+    if (0 != request_monitors)
+      notify_monitors (rr,
+                       GNUNET_DNS_FLAG_REQUEST_MONITOR);
     rr->phase = RP_QUERY;
-    for (cr = clients_head; NULL != cr; cr = cr->next)
-    {
-      if (0 != (cr->flags & GNUNET_DNS_FLAG_PRE_RESOLUTION))
-        GNUNET_array_append (rr->client_wait_list,
-                             rr->client_wait_list_length,
-                             cr);
-    }
+    /* without PRE-RESOLUTION clients, this goes straight to the Internet */
+    if (0 != pre_resolution_clients)
+      wait_for_clients (rr,
+                        GNUNET_DNS_FLAG_PRE_RESOLUTION);
     next_phase (rr);
     return;
 
@@ -606,7 +966,7 @@ next_phase (struct RequestRecord *rr)
                                      rr->payload,
                                      rr->payload_length,
                                      &process_dns_result,
-                                     NULL);
+                                     rr);
     if (NULL == rr->rs)
     {
       GNUNET_STATISTICS_update (stats,
@@ -621,31 +981,19 @@ next_phase (struct RequestRecord *rr)
 
   case RP_INTERNET_DNS:
     rr->phase = RP_MODIFY;
-    for (cr = clients_head; NULL != cr; cr = cr->next)
-    {
-      if (0 != (cr->flags & GNUNET_DNS_FLAG_POST_RESOLUTION))
-        GNUNET_array_append (rr->client_wait_list,
-                             rr->client_wait_list_length,
-                             cr);
-    }
+    if (0 != post_resolution_clients)
+      wait_for_clients (rr,
+                        GNUNET_DNS_FLAG_POST_RESOLUTION);
     next_phase (rr);
     return;
 
   case RP_MODIFY:
     rr->phase = RP_RESPONSE_MONITOR;
-    for (cr = clients_head; NULL != cr; cr = cr->next)
-    {
-      if (0 != (cr->flags & GNUNET_DNS_FLAG_RESPONSE_MONITOR))
-        GNUNET_array_append (rr->client_wait_list,
-                             rr->client_wait_list_length,
-                             cr);
-    }
-    next_phase (rr);
-    return;
-
-  case RP_RESPONSE_MONITOR:
+    if (0 != response_monitors)
+      notify_monitors (rr,
+                       GNUNET_DNS_FLAG_RESPONSE_MONITOR);
     request_done (rr);
-    break;
+    return;
 
   case RP_DROP:
     cleanup_rr (rr);
@@ -684,6 +1032,42 @@ client_connect_cb (void *cls,
 }
 
 
+/**
+ * A client disconnected, make sure a request no longer waits for it.
+ *
+ * @param cls the `struct ClientRecord` that disconnected
+ * @param key unused
+ * @param value a `struct RequestRecord`
+ * @return #GNUNET_OK (continue to iterate)
+ */
+static enum GNUNET_GenericReturnValue
+forget_client (void *cls,
+               uint32_t key,
+               void *value)
+{
+  struct ClientRecord *cr = cls;
+  struct RequestRecord *rr = value;
+  bool waiting = true;
+
+  (void) key;
+  for (unsigned int j = 0; j < rr->client_wait_list_length; j++)
+  {
+    if (rr->client_wait_list[j] != cr)
+    {
+      /* we only wait for the first client still on the list */
+      if (NULL != rr->client_wait_list[j])
+        waiting = false;
+      continue;
+    }
+    rr->client_wait_list[j] = NULL;
+    if (waiting)
+      next_phase (rr);
+    break;
+  }
+  return GNUNET_OK;
+}
+
+
 /**
  * A client disconnected, clean up after it.
  *
@@ -697,25 +1081,18 @@ client_disconnect_cb (void *cls,
                       void *app_ctx)
 {
   struct ClientRecord *cr = app_ctx;
-  struct RequestRecord *rr;
 
   GNUNET_CONTAINER_DLL_remove (clients_head,
                                clients_tail,
                                cr);
-  for (unsigned int i = 0; i < UINT16_MAX; i++)
-  {
-    rr = &requests[i];
-    if (0 == rr->client_wait_list_length)
-      continue;   /* not in use */
-    for (unsigned int j = 0; j < rr->client_wait_list_length; j++)
-    {
-      if (rr->client_wait_list[j] == cr)
-      {
-        rr->client_wait_list[j] = NULL;
-        next_phase (rr);
-      }
-    }
-  }
+  count_client_flags (cr->flags,
+                      -1);
+  if ( (0 != (cr->flags & (GNUNET_DNS_FLAG_PRE_RESOLUTION
+                           | GNUNET_DNS_FLAG_POST_RESOLUTION))) &&
+       (NULL != requests) )
+    GNUNET_CONTAINER_multihashmap32_iterate (requests,
+                                             &forget_client,
+                                             cr);
   GNUNET_free (cr);
 }
 
@@ -724,8 +1101,9 @@ client_disconnect_cb (void *cls,
  * Callback called from DNSSTUB resolver when a resolution
  * succeeded.
  *
- * @param cls NULL
- * @param dns the response itself
+ * @param cls the `struct RequestRecord`
+ * @param dns the response itself, NULL if the stub gave up
+ *        on the request
  * @param r number of bytes in dns
  */
 static void
@@ -733,16 +1111,22 @@ process_dns_result (void *cls,
                     const struct GNUNET_TUN_DnsHeader *dns,
                     size_t r)
 {
-  struct RequestRecord *rr;
+  struct RequestRecord *rr = cls;
 
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Processing DNS result from stub resolver\n");
-  GNUNET_assert (NULL == cls);
   if (NULL == dns)
-    return; /* ignore */
-
-  rr = &requests[dns->id];
-  if (rr->phase != RP_INTERNET_DNS)
+  {
+    /* the stub needed the socket for another request */
+    GNUNET_STATISTICS_update (stats,
+                              gettext_noop (
+                                "# External DNS request timed out"),
+                              1, GNUNET_NO);
+    rr->rs = NULL;
+    cleanup_rr (rr);
+    return;
+  }
+  if (dns->id != ((const struct GNUNET_TUN_DnsHeader *) rr->payload)->id)
   {
     /* unexpected / bogus reply */
     GNUNET_STATISTICS_update (stats,
@@ -756,6 +1140,8 @@ process_dns_result (void *cls,
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Got a response from the stub resolver for DNS request %llu intercepted locally!\n",
        (unsigned long long) rr->request_id);
+  GNUNET_DNSSTUB_resolve_cancel (rr->rs);
+  rr->rs = NULL;
   GNUNET_free (rr->payload);
   rr->payload = GNUNET_malloc (r);
   GNUNET_memcpy (rr->payload,
@@ -778,7 +1164,11 @@ handle_client_init (void *cls,
 {
   struct ClientRecord *cr = cls;
 
+  count_client_flags (cr->flags,
+                      -1);
   cr->flags =  ntohl (reg->flags);
+  count_client_flags (cr->flags,
+                      1);
   GNUNET_SERVICE_client_continue (cr->client);
 }
 
@@ -811,15 +1201,25 @@ handle_client_response (void *cls,
   struct ClientRecord *cr = cls;
   struct RequestRecord *rr;
   uint16_t msize;
-  uint16_t off;
 
   msize = ntohs (resp->header.size);
-  off = (uint16_t) resp->request_id;
-  rr = &requests[off];
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Received DNS response with ID %llu from local client!\n",
        (unsigned long long) resp->request_id);
-  if (rr->request_id != resp->request_id)
+  if (0 != (resp->request_id & MONITOR_TAG))
+  {
+    /* monitor is done with the request; we did not wait for it */
+    if (2 == ntohl (resp->drop_flag))
+    {
+      GNUNET_break (0);
+      GNUNET_SERVICE_client_drop (cr->client);
+      return;
+    }
+    GNUNET_SERVICE_client_continue (cr->client);
+    return;
+  }
+  rr = get_request_by_id (resp->request_id);
+  if (NULL == rr)
   {
     GNUNET_STATISTICS_update (stats,
                               gettext_noop (
@@ -847,9 +1247,7 @@ handle_client_response (void *cls,
 
     case 2:     /* update */
       msize -= sizeof(struct GNUNET_DNS_Response);
-      if ((sizeof(struct GNUNET_TUN_DnsHeader) > msize) ||
-          (RP_REQUEST_MONITOR == rr->phase) ||
-          (RP_RESPONSE_MONITOR == rr->phase))
+      if (sizeof(struct GNUNET_TUN_DnsHeader) > msize)
       {
         GNUNET_break (0);
         GNUNET_SERVICE_client_drop (cr->client);
@@ -913,6 +1311,8 @@ process_helper_messages (void *cls,
   const struct GNUNET_TUN_UdpHeader *udp;
   const struct GNUNET_TUN_DnsHeader *dns;
   struct RequestRecord *rr;
+  struct FindRequestContext frc;
+  uint32_t key;
   struct sockaddr_in *srca4;
   struct sockaddr_in6 *srca6;
   struct sockaddr_in *dsta4;
@@ -996,17 +1396,11 @@ process_helper_messages (void *cls,
   }
   msize -= sizeof(struct GNUNET_TUN_UdpHeader);
   dns = (const struct GNUNET_TUN_DnsHeader*) &udp[1];
-  rr = &requests[dns->id];
-
-  /* clean up from previous request */
-  GNUNET_free (rr->payload);
-  rr->payload = NULL;
-  GNUNET_array_grow (rr->client_wait_list,
-                     rr->client_wait_list_length,
-                     0);
 
   /* setup new request */
+  rr = GNUNET_new (struct RequestRecord);
   rr->phase = RP_INIT;
+  rr->dns_id = dns->id;
   switch (ntohs (tun->proto))
   {
   case ETH_P_IPV4:
@@ -1050,11 +1444,28 @@ process_helper_messages (void *cls,
   default:
     GNUNET_assert (0);
   }
+  /* a retransmission replaces the previous request */
+  key = get_request_key (&rr->src_addr,
+                         rr->dns_id);
+  frc.src_addr = &rr->src_addr;
+  frc.dns_id = rr->dns_id;
+  frc.rr = NULL;
+  GNUNET_CONTAINER_multihashmap32_get_multiple (requests,
+                                                key,
+                                                &find_by_source,
+                                                &frc);
+  if (NULL != frc.rr)
+    cleanup_rr (frc.rr);
   rr->payload = GNUNET_malloc (msize);
   rr->payload_length = msize;
   GNUNET_memcpy (rr->payload, dns, msize);
-  rr->request_id = dns->id | (request_id_gen << 16);
-  request_id_gen++;
+  rr->request_id = ((uint64_t) key << 32)
+                   | (request_id_gen++ & (MONITOR_TAG - 1));
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONTAINER_multihashmap32_put (requests,
+                                                      key,
+                                                      rr,
+                                                      GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Creating new DNS request %llu\n",
        (unsigned long long) rr->request_id);
@@ -1089,6 +1500,7 @@ run (void *cls,
 
   cfg = cfg_;
   stats = GNUNET_STATISTICS_create ("dns", cfg);
+  requests = GNUNET_CONTAINER_multihashmap32_create (256);
   GNUNET_SCHEDULER_add_shutdown (&cleanup_task,
                                  cls);
   dnsstub = GNUNET_DNSSTUB_start (128);
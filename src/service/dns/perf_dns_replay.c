@@ -0,0 +1,695 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file dns/perf_dns_replay.c
+ * @brief measure how fast the DNS service answers a stream of queries
+ *        it intercepts, with no clients, with monitors and with
+ *        resolution clients.  We run the service in this process with
+ *        a local DNS server and, instead of gnunet-helper-dns, start
+ *        this program again as the helper to replay the queries over
+ *        the helper interface.  Many senders use the same DNS IDs at
+ *        the same time, and each must get its own answer.
+ */
+
+/* we drive the service from here, so we need our own main() */
+#define main gnunet_service_dns_main
+#include "gnunet-service-dns.c"
+#undef main
+
+#include <pthread.h>
+
+/**
+ * Number of queries we replay.
+ */
+#define NUM_QUERIES 20000
+
+/**
+ * Maximum number of queries waiting for an answer.
+ */
+#define WINDOW 64
+
+/**
+ * Number of source ports the queries come from.
+ */
+#define NUM_PORTS 16
+
+/**
+ * Number of DNS IDs each source port uses.
+ */
+#define NUM_IDS 16
+
+/**
+ * First source port of the queries.
+ */
+#define PORT_BASE 40000
+
+/**
+ * Message type the replay helper uses to report its result.
+ */
+#define MY_TYPE_RESULT 256
+
+/**
+ * Maximum number of DNS clients in a mode.
+ */
+#define MAX_CLIENTS 8
+
+
+GNUNET_NETWORK_STRUCT_BEGIN
+
+/**
+ * Result of a replay, sent by the helper when it is done.
+ */
+struct ReplayResult
+{
+  /**
+   * Type is #MY_TYPE_RESULT.
+   */
+  struct GNUNET_MessageHeader header;
+
+  /**
+   * Number of queries that got the right answer.
+   */
+  uint32_t answered GNUNET_PACKED;
+
+  /**
+   * Number of answers that did not match a query.
+   */
+  uint32_t wrong GNUNET_PACKED;
+
+  /**
+   * Time from the first query to the last answer.
+   */
+  struct GNUNET_TIME_RelativeNBO duration;
+};
+
+GNUNET_NETWORK_STRUCT_END
+
+
+/**
+ * DNS clients we connect during a replay.
+ */
+struct Mode
+{
+  /**
+   * Name to report.
+   */
+  const char *name;
+
+  /**
+   * Number of request and response monitors.
+   */
+  unsigned int monitors;
+
+  /**
+   * Number of pre- and post-resolution clients.
+   */
+  unsigned int resolvers;
+};
+
+
+static const struct Mode modes[] = {
+  { "no clients", 0, 0 },
+  { "4 monitors", 4, 0 },
+  { "4 monitors, 1 resolution client", 4, 1 },
+};
+
+static unsigned int mode;
+
+static struct GNUNET_DNS_Handle *dns_clients[MAX_CLIENTS];
+
+static struct GNUNET_SCHEDULER_Task *ready_task;
+
+static struct GNUNET_SCHEDULER_Task *timeout_task;
+
+static struct ReplayResult result;
+
+/**
+ * Socket of our local DNS server.
+ */
+static int dns_server;
+
+static pthread_t dns_server_thread;
+
+static struct sockaddr_in dns_server_addr;
+
+
+/* ******************** the replay helper ******************** */
+
+static void
+write_all (const void *buf,
+           size_t len)
+{
+  const char *pos = buf;
+
+  while (len > 0)
+  {
+    ssize_t ret = write (STDOUT_FILENO,
+                         pos,
+                         len);
+
+    GNUNET_assert (ret > 0);
+    pos += ret;
+    len -= ret;
+  }
+}
+
+
+static bool
+read_all (void *buf,
+          size_t len)
+{
+  char *pos = buf;
+
+  while (len > 0)
+  {
+    ssize_t ret = read (STDIN_FILENO,
+                        pos,
+                        len);
+
+    if (ret <= 0)
+      return false;
+    pos += ret;
+    len -= ret;
+  }
+  return true;
+}
+
+
+/**
+ * Write query @a n of the stream, as the TUN interface would give
+ * it to the service.
+ */
+static void
+write_query (unsigned int n)
+{
+  char name[32];
+  char buf[512] GNUNET_ALIGN;
+  struct GNUNET_MessageHeader *hdr = (struct GNUNET_MessageHeader *) buf;
+  struct GNUNET_TUN_Layer2PacketHeader *tun
+    = (struct GNUNET_TUN_Layer2PacketHeader *) &hdr[1];
+  struct GNUNET_TUN_IPv4Header *ip4
+    = (struct GNUNET_TUN_IPv4Header *) &tun[1];
+  struct GNUNET_TUN_UdpHeader *udp = (struct GNUNET_TUN_UdpHeader *) &ip4[1];
+  struct GNUNET_TUN_DnsHeader *dns = (struct GNUNET_TUN_DnsHeader *) &udp[1];
+  char *q = (char *) &dns[1];
+  struct in_addr src;
+  struct in_addr dst;
+  size_t dns_len;
+  uint16_t v;
+
+  memset (buf,
+          0,
+          sizeof (buf));
+  dns->id = htons ((n / NUM_PORTS) % NUM_IDS);
+  dns->flags.recursion_desired = 1;
+  dns->query_count = htons (1);
+  /* QNAME */
+  GNUNET_snprintf (name,
+                   sizeof (name),
+                   "www%u",
+                   n % 1000);
+  *q = strlen (name);
+  memcpy (&q[1], name, strlen (name));
+  q += 1 + strlen (name);
+  *q = strlen ("example");
+  memcpy (&q[1], "example", strlen ("example"));
+  q += 1 + strlen ("example");
+  *q = strlen ("com");
+  memcpy (&q[1], "com", strlen ("com"));
+  q += 1 + strlen ("com") + 1;
+  v = htons (GNUNET_DNSPARSER_TYPE_A);
+  memcpy (q, &v, sizeof (v));
+  q += sizeof (v);
+  v = htons (GNUNET_TUN_DNS_CLASS_INTERNET);
+  memcpy (q, &v, sizeof (v));
+  q += sizeof (v);
+  dns_len = q - (char *) dns;
+
+  GNUNET_assert (1 == inet_pton (AF_INET, "169.254.1.2", &src));
+  GNUNET_assert (1 == inet_pton (AF_INET, "169.254.1.1", &dst));
+  udp->source_port = htons (PORT_BASE + n % NUM_PORTS);
+  udp->destination_port = htons (DNS_PORT);
+  udp->len = htons (sizeof (*udp) + dns_len);
+  GNUNET_TUN_initialize_ipv4_header (ip4,
+                                     IPPROTO_UDP,
+                                     sizeof (*udp) + dns_len,
+                                     &src,
+                                     &dst);
+  GNUNET_TUN_calculate_udp4_checksum (ip4,
+                                      udp,
+                                      dns,
+                                      dns_len);
+  tun->flags = htons (0);
+  tun->proto = htons (ETH_P_IPV4);
+  hdr->type = htons (GNUNET_MESSAGE_TYPE_DNS_HELPER);
+  hdr->size = htons (q - buf);
+  write_all (buf,
+             q - buf);
+}
+
+
+/**
+ * Replay the query stream over stdout and check the answers we get
+ * on stdin, then report the result.
+ *
+ * @return 0 on success
+ */
+static int
+replay (void)
+{
+  static bool pending[NUM_PORTS][NUM_IDS];
+  struct GNUNET_TIME_Absolute start;
+  unsigned int sent = 0;
+  unsigned int done = 0;
+  char buf[GNUNET_MAX_MESSAGE_SIZE] GNUNET_ALIGN;
+  const struct GNUNET_MessageHeader *hdr
+    = (const struct GNUNET_MessageHeader *) buf;
+  const struct GNUNET_TUN_Layer2PacketHeader *tun
+    = (const struct GNUNET_TUN_Layer2PacketHeader *) &hdr[1];
+  const struct GNUNET_TUN_IPv4Header *ip4
+    = (const struct GNUNET_TUN_IPv4Header *) &tun[1];
+  const struct GNUNET_TUN_UdpHeader *udp
+    = (const struct GNUNET_TUN_UdpHeader *) &ip4[1];
+  const struct GNUNET_TUN_DnsHeader *dns
+    = (const struct GNUNET_TUN_DnsHeader *) &udp[1];
+
+  start = GNUNET_TIME_absolute_get ();
+  while (done < NUM_QUERIES)
+  {
+    unsigned int port;
+    unsigned int id;
+    uint16_t size;
+
+    while ( (sent < NUM_QUERIES) &&
+            (sent - done < WINDOW) &&
+            (! pending[sent % NUM_PORTS][(sent / NUM_PORTS) % NUM_IDS]) )
+    {
+      pending[sent % NUM_PORTS][(sent / NUM_PORTS) % NUM_IDS] = true;
+      write_query (sent++);
+    }
+    if (! read_all (buf,
+                    sizeof (*hdr)))
+      return 1;
+    size = ntohs (hdr->size);
+    GNUNET_assert (size >= sizeof (*hdr));
+    if (! read_all (&buf[sizeof (*hdr)],
+                    size - sizeof (*hdr)))
+      return 1;
+    done++;
+    port = ntohs (udp->destination_port) - PORT_BASE;
+    id = ntohs (dns->id);
+    if ( (size < sizeof (*hdr) + sizeof (*tun) + sizeof (*ip4)
+          + sizeof (*udp) + sizeof (*dns)) ||
+         (ETH_P_IPV4 != ntohs (tun->proto)) ||
+         (port >= NUM_PORTS) ||
+         (id >= NUM_IDS) ||
+         (! pending[port][id]) ||
+         (1 != dns->flags.query_or_response) )
+    {
+      result.wrong++;
+      continue;
+    }
+    pending[port][id] = false;
+    result.answered++;
+  }
+  result.header.type = htons (MY_TYPE_RESULT);
+  result.header.size = htons (sizeof (result));
+  result.answered = htonl (result.answered);
+  result.wrong = htonl (result.wrong);
+  result.duration = GNUNET_TIME_relative_hton (
+    GNUNET_TIME_absolute_get_duration (start));
+  write_all (&result,
+             sizeof (result));
+  return 0;
+}
+
+
+/* ******************** the DNS server ******************** */
+
+/**
+ * Answer every query with an empty response.
+ */
+static void *
+serve_dns (void *cls)
+{
+  char buf[65536] GNUNET_ALIGN;
+  struct GNUNET_TUN_DnsHeader *dns = (struct GNUNET_TUN_DnsHeader *) buf;
+
+  (void) cls;
+  while (1)
+  {
+    struct sockaddr_storage sa;
+    socklen_t sa_len = sizeof (sa);
+    ssize_t len;
+
+    len = recvfrom (dns_server,
+                    buf,
+                    sizeof (buf),
+                    0,
+                    (struct sockaddr *) &sa,
+                    &sa_len);
+    if (0 == len)
+      break; /* told to stop */
+    if (len < (ssize_t) sizeof (*dns))
+      continue;
+    dns->flags.query_or_response = 1;
+    dns->flags.recursion_available = 1;
+    (void) sendto (dns_server,
+                   buf,
+                   len,
+                   0,
+                   (const struct sockaddr *) &sa,
+                   sa_len);
+  }
+  return NULL;
+}
+
+
+static void
+start_dns_server (void)
+{
+  socklen_t sa_len = sizeof (dns_server_addr);
+
+  dns_server = socket (AF_INET,
+                       SOCK_DGRAM,
+                       0);
+  GNUNET_assert (-1 != dns_server);
+  dns_server_addr.sin_family = AF_INET;
+  dns_server_addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  GNUNET_assert (0 == bind (dns_server,
+                            (const struct sockaddr *) &dns_server_addr,
+                            sizeof (dns_server_addr)));
+  GNUNET_assert (0 == getsockname (dns_server,
+                                   (struct sockaddr *) &dns_server_addr,
+                                   &sa_len));
+  GNUNET_assert (0 == pthread_create (&dns_server_thread,
+                                      NULL,
+                                      &serve_dns,
+                                      NULL));
+}
+
+
+static void
+stop_dns_server (void)
+{
+  int fd;
+
+  fd = socket (AF_INET,
+               SOCK_DGRAM,
+               0);
+  GNUNET_assert (-1 != fd);
+  GNUNET_assert (0 == sendto (fd,
+                              NULL,
+                              0,
+                              0,
+                              (const struct sockaddr *) &dns_server_addr,
+                              sizeof (dns_server_addr)));
+  GNUNET_break (0 == close (fd));
+  GNUNET_assert (0 == pthread_join (dns_server_thread,
+                                    NULL));
+  GNUNET_break (0 == close (dns_server));
+}
+
+
+/* ******************** the service ******************** */
+
+static void
+forward_request (void *cls,
+                 struct GNUNET_DNS_RequestHandle *rh,
+                 size_t request_length,
+                 const char *request)
+{
+  GNUNET_DNS_request_forward (rh);
+}
+
+
+static void
+disconnect_clients (void)
+{
+  for (unsigned int i = 0; i < MAX_CLIENTS; i++)
+  {
+    if (NULL == dns_clients[i])
+      continue;
+    GNUNET_DNS_disconnect (dns_clients[i]);
+    dns_clients[i] = NULL;
+  }
+}
+
+
+static void
+start_mode (void);
+
+
+/**
+ * The helper is done, report and go on with the next mode.
+ *
+ * @param cls NULL
+ */
+static void
+replay_done (void *cls)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  (void) cls;
+  hijacker = NULL; /* the helper library stops it */
+  if (NULL != timeout_task)
+  {
+    GNUNET_SCHEDULER_cancel (timeout_task);
+    timeout_task = NULL;
+  }
+  dur = GNUNET_TIME_relative_ntoh (result.duration);
+  printf ("%s: %u queries answered in %s (%llu/s)\n",
+          modes[mode].name,
+          (unsigned int) ntohl (result.answered),
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          ntohl (result.answered) * 1000000LLU
+          / GNUNET_MAX (1, dur.rel_value_us));
+  if ( (NUM_QUERIES != ntohl (result.answered)) ||
+       (0 != ntohl (result.wrong)) )
+  {
+    fprintf (stderr,
+             "%u queries answered, %u wrong answers\n",
+             (unsigned int) ntohl (result.answered),
+             (unsigned int) ntohl (result.wrong));
+    global_ret = 1;
+  }
+  if (0 != GNUNET_CONTAINER_multihashmap32_size (requests))
+  {
+    fprintf (stderr,
+             "%u requests left over\n",
+             GNUNET_CONTAINER_multihashmap32_size (requests));
+    global_ret = 1;
+  }
+  disconnect_clients ();
+  memset (&result,
+          0,
+          sizeof (result));
+  mode++;
+  if ( (0 != global_ret) ||
+       (mode >= sizeof (modes) / sizeof (modes[0])) )
+  {
+    GNUNET_SCHEDULER_shutdown ();
+    return;
+  }
+  start_mode ();
+}
+
+
+/**
+ * Handle a message from the helper.
+ *
+ * @param cls NULL
+ * @param message a query or the result of the replay
+ * @return #GNUNET_OK
+ */
+static int
+replay_message (void *cls,
+                const struct GNUNET_MessageHeader *message)
+{
+  if (MY_TYPE_RESULT != ntohs (message->type))
+    return process_helper_messages (cls,
+                                    message);
+  GNUNET_assert (sizeof (result) == ntohs (message->size));
+  memcpy (&result,
+          message,
+          sizeof (result));
+  return GNUNET_OK;
+}
+
+
+static void
+do_timeout (void *cls)
+{
+  (void) cls;
+  timeout_task = NULL;
+  fprintf (stderr,
+           "%s: timeout\n",
+           modes[mode].name);
+  global_ret = 1;
+  GNUNET_SCHEDULER_shutdown ();
+}
+
+
+/**
+ * Once the service knows all our clients, start the helper.
+ *
+ * @param cls NULL
+ */
+static void
+check_ready (void *cls)
+{
+  const struct Mode *m = &modes[mode];
+  char *const argv[] = {
+    (char *) "perf_dns_replay",
+    (char *) "replay",
+    NULL
+  };
+
+  (void) cls;
+  ready_task = NULL;
+  if ( (request_monitors != m->monitors) ||
+       (response_monitors != m->monitors) ||
+       (pre_resolution_clients != m->resolvers) ||
+       (post_resolution_clients != m->resolvers) )
+  {
+    ready_task = GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_UNIT_MILLISECONDS,
+                                               &check_ready,
+                                               NULL);
+    return;
+  }
+  timeout_task = GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_UNIT_MINUTES,
+                                               &do_timeout,
+                                               NULL);
+  hijacker = GNUNET_HELPER_start (GNUNET_NO,
+                                  "/proc/self/exe",
+                                  argv,
+                                  &replay_message,
+                                  &replay_done,
+                                  NULL);
+}
+
+
+static void
+start_mode (void)
+{
+  const struct Mode *m = &modes[mode];
+  unsigned int n = 0;
+
+  for (unsigned int i = 0; i < m->monitors; i++)
+    dns_clients[n++] = GNUNET_DNS_connect (cfg,
+                                           GNUNET_DNS_FLAG_REQUEST_MONITOR
+                                           | GNUNET_DNS_FLAG_RESPONSE_MONITOR,
+                                           &forward_request,
+                                           NULL);
+  for (unsigned int i = 0; i < m->resolvers; i++)
+    dns_clients[n++] = GNUNET_DNS_connect (cfg,
+                                           GNUNET_DNS_FLAG_PRE_RESOLUTION
+                                           | GNUNET_DNS_FLAG_POST_RESOLUTION,
+                                           &forward_request,
+                                           NULL);
+  GNUNET_assert (n <= MAX_CLIENTS);
+  ready_task = GNUNET_SCHEDULER_add_now (&check_ready,
+                                         NULL);
+}
+
+
+static void
+do_shutdown (void *cls)
+{
+  if (NULL != ready_task)
+  {
+    GNUNET_SCHEDULER_cancel (ready_task);
+    ready_task = NULL;
+  }
+  if (NULL != timeout_task)
+  {
+    GNUNET_SCHEDULER_cancel (timeout_task);
+    timeout_task = NULL;
+  }
+  disconnect_clients ();
+  cleanup_task (cls);
+}
+
+
+static void
+perf_init (void *cls,
+           const struct GNUNET_CONFIGURATION_Handle *cfg_,
+           struct GNUNET_SERVICE_Handle *service)
+{
+  cfg = cfg_;
+  GNUNET_SCHEDULER_add_shutdown (&do_shutdown,
+                                 NULL);
+  requests = GNUNET_CONTAINER_multihashmap32_create (256);
+  dnsstub = GNUNET_DNSSTUB_start (128);
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_DNSSTUB_add_dns_sa (dnsstub,
+                                            (const struct sockaddr *) &
+                                            dns_server_addr));
+  start_mode ();
+}
+
+
+int
+main (int argc,
+      char *argv[])
+{
+  struct GNUNET_MQ_MessageHandler handlers[] = {
+    GNUNET_MQ_hd_fixed_size (client_init,
+                             GNUNET_MESSAGE_TYPE_DNS_CLIENT_INIT,
+                             struct GNUNET_DNS_Register,
+                             NULL),
+    GNUNET_MQ_hd_var_size (client_response,
+                           GNUNET_MESSAGE_TYPE_DNS_CLIENT_RESPONSE,
+                           struct GNUNET_DNS_Response,
+                           NULL),
+    GNUNET_MQ_handler_end ()
+  };
+  char *const service_argv[] = {
+    (char *) "perf_dns_replay",
+    (char *) "-c", (char *) "perf_dns_replay.conf",
+    NULL
+  };
+
+  if ( (2 == argc) &&
+       (0 == strcmp (argv[1],
+                     "replay")) )
+    return replay ();
+  GNUNET_log_setup ("perf-dns-replay",
+                    "WARNING",
+                    NULL);
+  start_dns_server ();
+  if (0 != GNUNET_SERVICE_run_ (3,
+                                service_argv,
+                                "dns",
+                                GNUNET_SERVICE_OPTION_NONE,
+                                &perf_init,
+                                &client_connect_cb,
+                                &client_disconnect_cb,
+                                NULL,
+                                handlers))
+    global_ret = 1;
+  stop_dns_server ();
+  return global_ret;
+}
+
+
+/* end of perf_dns_replay.c */
@@ -208,6 +208,16 @@ struct ChannelState
    */
   struct GNUNET_PeerIdentity peer;
 
+  /**
+   * Next entry in the #connections_lru_head clock list (TCP/UDP only).
+   */
+  struct ChannelState *next_lru;
+
+  /**
+   * Previous entry in the #connections_lru_head clock list (TCP/UDP only).
+   */
+  struct ChannelState *prev_lru;
+
   /**
    * #GNUNET_NO if this is a channel for TCP/UDP,
    * #GNUNET_YES if this is a channel for DNS,
@@ -220,9 +230,16 @@ struct ChannelState
     struct
     {
       /**
-       * Heap node for this state in the connections_heap.
+       * #GNUNET_YES if this state is in the #connections_map and
+       * the clock list, that is, it has been fully set up.
        */
-      struct GNUNET_CONTAINER_HeapNode *heap_node;
+      int is_bound;
+
+      /**
+       * #GNUNET_YES if this state saw traffic since the clock hand
+       * last passed over it (second-chance bit).
+       */
+      int lru_referenced;
 
       /**
        * Key this state has in the #connections_map.
@@ -329,9 +346,27 @@ static struct GNUNET_CADET_Handle *cadet_handle;
 static struct GNUNET_CONTAINER_MultiHashMap *connections_map;
 
 /**
- * Heap so we can quickly find "old" connections.
+ * Head of the clock list so we can quickly find "old" connections.
+ * New connections are appended at the tail; the clock hand starts at
+ * the head and gives recently used connections a second chance.
+ */
+static struct ChannelState *connections_lru_head;
+
+/**
+ * Tail of the clock list of connections.
  */
-static struct GNUNET_CONTAINER_Heap *connections_heap;
+static struct ChannelState *connections_lru_tail;
+
+/**
+ * Number of entries in the #connections_lru_head list.
+ */
+static unsigned long long connections_lru_size;
+
+/**
+ * Random key for #GNUNET_TUN_flow_hash(), so that remote parties cannot
+ * predict which flows end up in the same #connections_map bucket.
+ */
+static uint64_t flow_hash_key;
 
 /**
  * If there are at least this many connections, old ones will be removed
@@ -571,14 +606,18 @@ static void
 hash_redirect_info (struct GNUNET_HashCode *hash,
                     const struct RedirectInformation *ri)
 {
+  char *start;
   char *off;
+  uint32_t bucket;
 
   memset (hash,
           0,
           sizeof(struct GNUNET_HashCode));
-  /* the GNUnet hashmap only uses the first sizeof(unsigned int) of the hash,
-     so we put the IP address in there (and hope for few collisions) */
-  off = (char *) hash;
+  /* the GNUnet hashmap only uses the first sizeof(unsigned int) of the hash
+     to pick a bucket, so we put a keyed hash of the tuple there; the rest
+     of the key is the tuple itself, so distinct flows never compare equal */
+  start = ((char *) hash) + sizeof(uint32_t);
+  off = start;
   switch (ri->remote_address.af)
   {
   case AF_INET:
@@ -592,7 +631,7 @@ hash_redirect_info (struct GNUNET_HashCode *hash,
     GNUNET_memcpy (off,
                    &ri->remote_address.address.ipv6,
                    sizeof(struct in6_addr));
-    off += sizeof(struct in_addr);
+    off += sizeof(struct in6_addr);
     break;
 
   default:
@@ -615,7 +654,7 @@ hash_redirect_info (struct GNUNET_HashCode *hash,
     GNUNET_memcpy (off,
                    &ri->local_address.address.ipv6,
                    sizeof(struct in6_addr));
-    off += sizeof(struct in_addr);
+    off += sizeof(struct in6_addr);
     break;
 
   default:
@@ -628,7 +667,13 @@ hash_redirect_info (struct GNUNET_HashCode *hash,
   GNUNET_memcpy (off,
                  &ri->remote_address.proto,
                  sizeof(uint8_t));
-  /* off += sizeof (uint8_t); */
+  off += sizeof(uint8_t);
+  bucket = GNUNET_TUN_flow_hash (flow_hash_key,
+                                 start,
+                                 off - start);
+  GNUNET_memcpy (hash,
+                 &bucket,
+                 sizeof(uint32_t));
 }
 
 
@@ -689,9 +734,7 @@ get_redirect_state (int af,
     return NULL;
   /* Mark this connection as freshly used */
   if (NULL == state_key)
-    GNUNET_CONTAINER_heap_update_cost (state->specifics.tcp_udp.heap_node,
-                                       GNUNET_TIME_absolute_get ().abs_value_us)
-    ;
+    state->specifics.tcp_udp.lru_referenced = GNUNET_YES;
   return state;
 }
 
@@ -726,7 +769,7 @@ check_tcp_service (void *cls,
     GNUNET_break_op (0);
     return GNUNET_SYSERR;
   }
-  if (NULL != state->specifics.tcp_udp.heap_node)
+  if (GNUNET_YES == state->specifics.tcp_udp.is_bound)
   {
     GNUNET_break_op (0);
     return GNUNET_SYSERR;
@@ -1274,7 +1317,7 @@ setup_fresh_address (int af,
  * connection / correct cadet channel.  This function generates
  * a "fresh" source IP and source port number for a connection
  * After picking a good source address, this function sets up
- * the state in the 'connections_map' and 'connections_heap'
+ * the state in the 'connections_map' and the clock list
  * to allow finding the state when needed later.  The function
  * also makes sure that we remain within memory limits by
  * cleaning up 'old' states.
@@ -1284,8 +1327,8 @@ setup_fresh_address (int af,
  *              this code can determine which AF/protocol is
  *              going to be used (the 'channel' should also
  *              already be set); after calling this function,
- *              heap_node and the local_address will be
- *              also initialized (heap_node != NULL can be
+ *              is_bound and the local_address will be
+ *              also initialized (is_bound can be
  *              used to test if a state has been fully setup).
  */
 static void
@@ -1330,15 +1373,34 @@ setup_state_record (struct ChannelState *state)
                  GNUNET_CONTAINER_multihashmap_put (connections_map,
                                                     &key, state,
                                                     GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
-  state->specifics.tcp_udp.heap_node
-    = GNUNET_CONTAINER_heap_insert (connections_heap,
-                                    state,
-                                    GNUNET_TIME_absolute_get ().abs_value_us);
-  while (GNUNET_CONTAINER_heap_get_size (connections_heap) > max_connections)
+  state->specifics.tcp_udp.is_bound = GNUNET_YES;
+  GNUNET_CONTAINER_MDLL_insert_tail (lru,
+                                     connections_lru_head,
+                                     connections_lru_tail,
+                                     state);
+  connections_lru_size++;
+  while ((connections_lru_size > max_connections) &&
+         (connections_lru_head != connections_lru_tail))
   {
-    s = GNUNET_CONTAINER_heap_remove_root (connections_heap);
-    GNUNET_assert (state != s);
-    s->specifics.tcp_udp.heap_node = NULL;
+    s = connections_lru_head;
+    GNUNET_CONTAINER_MDLL_remove (lru,
+                                  connections_lru_head,
+                                  connections_lru_tail,
+                                  s);
+    if ((state == s) ||
+        (GNUNET_YES == s->specifics.tcp_udp.lru_referenced))
+    {
+      /* give it a second chance; never evict the state we are
+         setting up */
+      s->specifics.tcp_udp.lru_referenced = GNUNET_NO;
+      GNUNET_CONTAINER_MDLL_insert_tail (lru,
+                                         connections_lru_head,
+                                         connections_lru_tail,
+                                         s);
+      continue;
+    }
+    connections_lru_size--;
+    s->specifics.tcp_udp.is_bound = GNUNET_NO;
     GNUNET_CADET_channel_destroy (s->channel);
     GNUNET_assert (GNUNET_OK ==
                    GNUNET_CONTAINER_multihashmap_remove (connections_map,
@@ -1558,7 +1620,7 @@ handle_udp_remote (void *cls,
   }
   state->specifics.tcp_udp.ri.remote_address.proto = IPPROTO_UDP;
   state->specifics.tcp_udp.ri.remote_address.port = msg->destination_port;
-  if (NULL == state->specifics.tcp_udp.heap_node)
+  if (GNUNET_YES != state->specifics.tcp_udp.is_bound)
     setup_state_record (state);
   if (0 != ntohs (msg->source_port))
     state->specifics.tcp_udp.ri.local_address.port = msg->source_port;
@@ -1705,7 +1767,7 @@ check_tcp_remote (void *cls,
     return GNUNET_SYSERR;
   }
   if ((NULL != state->specifics.tcp_udp.serv) ||
-      (NULL != state->specifics.tcp_udp.heap_node))
+      (GNUNET_YES == state->specifics.tcp_udp.is_bound))
   {
     GNUNET_break_op (0);
     return GNUNET_SYSERR;
@@ -1830,7 +1892,7 @@ check_tcp_data (void *cls,
   struct ChannelState *state = cls;
 
   if ((NULL == state) ||
-      (NULL == state->specifics.tcp_udp.heap_node))
+      (GNUNET_YES != state->specifics.tcp_udp.is_bound))
   {
     /* connection should have been up! */
     GNUNET_STATISTICS_update (stats,
@@ -2019,7 +2081,7 @@ handle_icmp_remote (void *cls,
                             1, GNUNET_NO);
 
   af = (int) ntohl (msg->af);
-  if ((NULL != state->specifics.tcp_udp.heap_node) &&
+  if ((GNUNET_YES == state->specifics.tcp_udp.is_bound) &&
       (af != state->specifics.tcp_udp.ri.remote_address.af))
   {
     /* other peer switched AF on this channel; not allowed */
@@ -2044,7 +2106,7 @@ handle_icmp_remote (void *cls,
     payload = &v4[1];
     pkt_len -= sizeof(struct in_addr);
     state->specifics.tcp_udp.ri.remote_address.address.ipv4 = *v4;
-    if (NULL == state->specifics.tcp_udp.heap_node)
+    if (GNUNET_YES != state->specifics.tcp_udp.is_bound)
     {
       state->specifics.tcp_udp.ri.remote_address.af = af;
       state->specifics.tcp_udp.ri.remote_address.proto = IPPROTO_ICMP;
@@ -2109,7 +2171,7 @@ handle_icmp_remote (void *cls,
     payload = &v6[1];
     pkt_len -= sizeof(struct in6_addr);
     state->specifics.tcp_udp.ri.remote_address.address.ipv6 = *v6;
-    if (NULL == state->specifics.tcp_udp.heap_node)
+    if (GNUNET_YES != state->specifics.tcp_udp.is_bound)
     {
       state->specifics.tcp_udp.ri.remote_address.af = af;
       state->specifics.tcp_udp.ri.remote_address.proto = IPPROTO_ICMPV6;
@@ -2537,15 +2599,19 @@ clean_channel (void *cls,
   }
   else
   {
-    if (NULL != s->specifics.tcp_udp.heap_node)
+    if (GNUNET_YES == s->specifics.tcp_udp.is_bound)
     {
       GNUNET_assert (GNUNET_YES ==
                      GNUNET_CONTAINER_multihashmap_remove (connections_map,
                                                            &s->specifics.tcp_udp
                                                            .state_key,
                                                            s));
-      GNUNET_CONTAINER_heap_remove_node (s->specifics.tcp_udp.heap_node);
-      s->specifics.tcp_udp.heap_node = NULL;
+      GNUNET_CONTAINER_MDLL_remove (lru,
+                                    connections_lru_head,
+                                    connections_lru_tail,
+                                    s);
+      connections_lru_size--;
+      s->specifics.tcp_udp.is_bound = GNUNET_NO;
     }
   }
   GNUNET_free (s);
@@ -3306,11 +3372,9 @@ cleanup (void *cls)
     GNUNET_CONTAINER_multihashmap_destroy (connections_map);
     connections_map = NULL;
   }
-  if (NULL != connections_heap)
-  {
-    GNUNET_CONTAINER_heap_destroy (connections_heap);
-    connections_heap = NULL;
-  }
+  connections_lru_head = NULL;
+  connections_lru_tail = NULL;
+  connections_lru_size = 0;
   if (NULL != dnsstub)
   {
     GNUNET_DNSSTUB_stop (dnsstub);
@@ -4000,8 +4064,8 @@ run (void *cls,
                                                    GNUNET_NO);
   connections_map = GNUNET_CONTAINER_multihashmap_create (65536,
                                                           GNUNET_NO);
-  connections_heap = GNUNET_CONTAINER_heap_create (
-    GNUNET_CONTAINER_HEAP_ORDER_MIN);
+  flow_hash_key = GNUNET_CRYPTO_random_u64 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                            UINT64_MAX);
   GNUNET_CONFIGURATION_iterate_sections (cfg,
                                          &read_service_conf,
                                          NULL);
@@ -0,0 +1,211 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file exit/perf_exit_flows.c
+ * @brief measure the connection table of the exit daemon: set up
+ *        #NUM_FLOWS TCP flows to a handful of popular remote hosts,
+ *        look up the flows of millions of synthetic packets for half
+ *        of them, and open new flows beyond the table limit so that
+ *        idle ones get evicted; the exit needs its TUN helper, so we
+ *        run the daemon's table code in this process without channels
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "gnunet_cadet_service.h"
+
+/* our flows have no channels */
+#define GNUNET_CADET_channel_destroy perf_cadet_channel_destroy
+
+static void
+perf_cadet_channel_destroy (struct GNUNET_CADET_Channel *channel);
+
+/* we drive the daemon from here, so we need our own main() */
+#define main gnunet_daemon_exit_main
+#include "gnunet-daemon-exit.c"
+#undef main
+
+/**
+ * Number of flows in the table.
+ */
+#define NUM_FLOWS 100000
+
+/**
+ * Number of packets we look up.
+ */
+#define NUM_PACKETS (4 * 1000 * 1000)
+
+/**
+ * Number of flows we open beyond #NUM_FLOWS.
+ */
+#define NUM_CHURN (NUM_FLOWS / 4)
+
+/**
+ * Number of remote hosts all flows go to.
+ */
+#define NUM_REMOTES 8
+
+
+static struct ChannelState *flows[NUM_FLOWS + NUM_CHURN];
+
+static unsigned int evicted;
+
+
+static void
+perf_cadet_channel_destroy (struct GNUNET_CADET_Channel *channel)
+{
+  GNUNET_assert (NULL == channel);
+  evicted++;
+}
+
+
+static void
+report (const char *what,
+        unsigned int count,
+        struct GNUNET_TIME_Absolute start)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %u in %s (%llu/s)\n",
+          what,
+          count,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          count * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+/**
+ * Open a new TCP flow to one of the popular remote hosts, as
+ * handle_tcp_remote() does.
+ */
+static struct ChannelState *
+open_flow (void)
+{
+  struct ChannelState *state;
+  struct SocketAddress *remote;
+
+  state = GNUNET_new (struct ChannelState);
+  state->is_dns = GNUNET_NO;
+  remote = &state->specifics.tcp_udp.ri.remote_address;
+  remote->af = AF_INET;
+  remote->proto = IPPROTO_TCP;
+  remote->port = htons (443);
+  remote->address.ipv4.s_addr
+    = htonl (0xC6336400 /* 198.51.100.0 */
+             + GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                         NUM_REMOTES));
+  setup_state_record (state);
+  return state;
+}
+
+
+static struct ChannelState *
+lookup_flow (const struct ChannelState *state)
+{
+  const struct RedirectInformation *ri = &state->specifics.tcp_udp.ri;
+
+  return get_redirect_state (AF_INET,
+                             IPPROTO_TCP,
+                             &ri->remote_address.address.ipv4,
+                             ri->remote_address.port,
+                             &ri->local_address.address.ipv4,
+                             ri->local_address.port,
+                             NULL);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  struct GNUNET_TIME_Absolute start;
+  unsigned int found;
+  int ret;
+
+  GNUNET_log_setup ("perf-exit-flows",
+                    "WARNING",
+                    NULL);
+  ret = 0;
+  GNUNET_assert (1 == inet_pton (AF_INET,
+                                 "10.0.0.1",
+                                 &exit_ipv4addr));
+  GNUNET_assert (1 == inet_pton (AF_INET,
+                                 "255.0.0.0",
+                                 &exit_ipv4mask));
+  max_connections = NUM_FLOWS;
+  connections_map = GNUNET_CONTAINER_multihashmap_create (65536,
+                                                          GNUNET_NO);
+  flow_hash_key = GNUNET_CRYPTO_random_u64 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                            UINT64_MAX);
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_FLOWS; i++)
+    flows[i] = open_flow ();
+  report ("flows opened",
+          NUM_FLOWS,
+          start);
+
+  /* packets of random flows of the busy first half, as they arrive
+     from the TUN interface */
+  found = 0;
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_PACKETS; i++)
+  {
+    const struct ChannelState *state
+      = flows[GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                        NUM_FLOWS / 2)];
+
+    if (state == lookup_flow (state))
+      found++;
+  }
+  report ("packets matched to their flow",
+          NUM_PACKETS,
+          start);
+  if (NUM_PACKETS != found)
+    ret = 1;
+
+  /* the table is full, so new flows push out idle ones */
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_CHURN; i++)
+    flows[NUM_FLOWS + i] = open_flow ();
+  report ("flows opened in a full table",
+          NUM_CHURN,
+          start);
+  if ((NUM_CHURN != evicted) ||
+      (NUM_FLOWS != GNUNET_CONTAINER_multihashmap_size (connections_map)))
+    ret = 1;
+  for (unsigned int i = 0; i < NUM_FLOWS / 2; i++)
+    if (flows[i] != lookup_flow (flows[i]))
+      ret = 1;  /* evicted a busy flow */
+  for (unsigned int i = NUM_FLOWS; i < NUM_FLOWS + NUM_CHURN; i++)
+    if (flows[i] != lookup_flow (flows[i]))
+      ret = 1;  /* evicted a new flow */
+
+  GNUNET_CONTAINER_multihashmap_iterate (connections_map,
+                                         &free_iterate,
+                                         NULL);
+  GNUNET_CONTAINER_multihashmap_destroy (connections_map);
+  return ret;
+}
+
+
+/* end of perf_exit_flows.c */
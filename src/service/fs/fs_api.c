@@ -690,33 +690,6 @@ get_write_handle (struct GNUNET_FS_Handle *h, const char *ext, const char *ent)
 }
 
 
-/**
- * Return a write handle for serialization.
- *
- * @param h master context
- * @param ext component of the path
- * @param uni name of parent
- * @param ent entity identifier (or empty string for the directory)
- * @return NULL on error
- */
-static struct GNUNET_BIO_WriteHandle *
-get_write_handle_in_dir (struct GNUNET_FS_Handle *h,
-                         const char *ext,
-                         const char *uni,
-                         const char *ent)
-{
-  char *fn;
-  struct GNUNET_BIO_WriteHandle *ret;
-
-  fn = get_serialization_file_name_in_dir (h, ext, uni, ent);
-  if (NULL == fn)
-    return NULL;
-  ret = GNUNET_BIO_write_open_file (fn);
-  GNUNET_free (fn);
-  return ret;
-}
-
-
 /**
  * Remove serialization/deserialization file from disk.
  *
@@ -1243,44 +1216,6 @@ make_serialization_file_name (struct GNUNET_FS_Handle *h, const char *ext)
 }
 
 
-/**
- * Create a new random name for serialization.  Also checks if persistence
- * is enabled and returns NULL if not.
- *
- * @param h master context
- * @param ext component of the path
- * @param uni name of parent
- * @return NULL on error
- */
-static char *
-make_serialization_file_name_in_dir (struct GNUNET_FS_Handle *h,
-                                     const char *ext,
-                                     const char *uni)
-{
-  char *fn;
-  char *dn;
-  char *ret;
-
-  if (0 == (h->flags & GNUNET_FS_FLAGS_PERSISTENCE))
-    return NULL; /* persistence not requested */
-  dn = get_serialization_file_name_in_dir (h, ext, uni, "");
-  if (NULL == dn)
-    return NULL;
-  if (GNUNET_OK != GNUNET_DISK_directory_create_for_file (dn))
-  {
-    GNUNET_free (dn);
-    return NULL;
-  }
-  fn = GNUNET_DISK_mktemp (dn);
-  GNUNET_free (dn);
-  if (NULL == fn)
-    return NULL; /* epic fail */
-  ret = get_serialization_short_name (fn);
-  GNUNET_free (fn);
-  return ret;
-}
-
-
 /**
  * Copy all of the data from the reader to the write handle.
  *
@@ -1897,6 +1832,118 @@ cleanup:
 }
 
 
+/**
+ * Tags of the records in the journals that we append to the
+ * serialization files of downloads and to the results files of
+ * searches.
+ */
+enum JournalTag
+{
+  /**
+   * End of the journal, overwritten by the next append.
+   */
+  JOURNAL_END = 0,
+
+  /**
+   * New state (and CHK) of a request of a download.
+   */
+  JOURNAL_DOWNLOAD_REQUEST = 1,
+
+  /**
+   * Progress of a download.
+   */
+  JOURNAL_DOWNLOAD_PROGRESS = 2,
+
+  /**
+   * A search result, in full.
+   */
+  JOURNAL_SEARCH_RESULT = 3,
+
+  /**
+   * New availability counters of a search result.
+   */
+  JOURNAL_SEARCH_AVAILABILITY = 4
+};
+
+
+/**
+ * Append the records in @a records and a #JOURNAL_END tag to the
+ * journal in @a fn, replacing the #JOURNAL_END tag that ends it.
+ * The file is created if it does not exist.  Closes @a records.
+ *
+ * @param fn file with the journal
+ * @param records buffer with the records to append
+ * @param[out] appended set to the number of bytes appended
+ * @return #GNUNET_OK on success, #GNUNET_SYSERR on error
+ *         (including if @a fn does not end with a #JOURNAL_END tag)
+ */
+static enum GNUNET_GenericReturnValue
+append_journal (const char *fn,
+                struct GNUNET_BIO_WriteHandle *records,
+                uint64_t *appended)
+{
+  struct GNUNET_DISK_FileHandle *fh;
+  void *buf;
+  size_t size;
+  off_t end;
+  int32_t tag;
+  enum GNUNET_GenericReturnValue ret;
+
+  buf = NULL;
+  if ((GNUNET_OK !=
+       GNUNET_BIO_write_int32 (records, "journal end", JOURNAL_END)) ||
+      (GNUNET_OK !=
+       GNUNET_BIO_get_buffer_contents (records, NULL, &buf, &size)))
+  {
+    GNUNET_break (0);
+    (void) GNUNET_BIO_write_close (records, NULL);
+    GNUNET_free (buf);
+    return GNUNET_SYSERR;
+  }
+  (void) GNUNET_BIO_write_close (records, NULL);
+  fh = GNUNET_DISK_file_open (fn,
+                              GNUNET_DISK_OPEN_READWRITE
+                              | GNUNET_DISK_OPEN_CREATE,
+                              GNUNET_DISK_PERM_USER_READ
+                              | GNUNET_DISK_PERM_USER_WRITE);
+  if (NULL == fh)
+  {
+    GNUNET_free (buf);
+    return GNUNET_SYSERR;
+  }
+  ret = GNUNET_SYSERR;
+  end = GNUNET_DISK_file_seek (fh, 0, GNUNET_DISK_SEEK_END);
+  if (end >= (off_t) sizeof(tag))
+  {
+    /* check that we are about to replace the end of a journal */
+    if ((end - (off_t) sizeof(tag) !=
+         GNUNET_DISK_file_seek (fh, end - sizeof(tag), GNUNET_DISK_SEEK_SET))
+        ||
+        (sizeof(tag) != GNUNET_DISK_file_read (fh, &tag, sizeof(tag))) ||
+        (JOURNAL_END != ntohl (tag)) ||
+        (end - (off_t) sizeof(tag) !=
+         GNUNET_DISK_file_seek (fh, end - sizeof(tag), GNUNET_DISK_SEEK_SET)))
+      goto cleanup;
+    end -= sizeof(tag);
+  }
+  else if (0 != end)
+  {
+    goto cleanup;
+  }
+  if (size != GNUNET_DISK_file_write (fh, buf, size))
+  {
+    GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_WARNING, "write", fn);
+    goto cleanup;
+  }
+  *appended = size;
+  ret = GNUNET_OK;
+cleanup:
+  GNUNET_break (GNUNET_OK == GNUNET_DISK_file_close (fh));
+  GNUNET_free (buf);
+  return ret;
+}
+
+
 /**
  * Serialize a download request.
  *
@@ -2003,6 +2050,152 @@ cleanup:
 }
 
 
+/**
+ * Find the request of a download for the block at the given depth
+ * and offset.
+ *
+ * @param dr top-level request of the download
+ * @param depth depth of the block
+ * @param offset offset of the block
+ * @return NULL if there is no such block
+ */
+static struct DownloadRequest *
+find_download_request (struct DownloadRequest *dr,
+                       unsigned int depth,
+                       uint64_t offset)
+{
+  unsigned int i;
+
+  while (dr->depth > depth)
+  {
+    /* children are ordered by offset */
+    for (i = dr->num_children; i > 0; i--)
+      if (dr->children[i - 1]->offset <= offset)
+        break;
+    if (0 == i)
+      return NULL;
+    dr = dr->children[i - 1];
+  }
+  if ((dr->depth != depth) || (dr->offset != offset))
+    return NULL;
+  return dr;
+}
+
+
+/**
+ * Apply the journal that follows the state of a download in its
+ * serialization file.
+ *
+ * @param rh handle to read the journal from
+ * @param dc download to apply the journal to
+ * @return #GNUNET_OK on success, #GNUNET_SYSERR if the journal is
+ *         truncated or malformed (the records up to the problem
+ *         are applied)
+ */
+static enum GNUNET_GenericReturnValue
+read_download_journal (struct GNUNET_BIO_ReadHandle *rh,
+                       struct GNUNET_FS_DownloadContext *dc)
+{
+  struct DownloadRequest *dr;
+  int32_t tag;
+  uint32_t depth;
+  uint64_t offset;
+  uint32_t state;
+
+  while (1)
+  {
+    if (GNUNET_OK != GNUNET_BIO_read_int32 (rh, "journal tag", &tag))
+      return GNUNET_SYSERR;
+    switch (tag)
+    {
+    case JOURNAL_END:
+      return GNUNET_OK;
+
+    case JOURNAL_DOWNLOAD_REQUEST:
+      {
+        struct GNUNET_BIO_ReadSpec rs[] = {
+          GNUNET_BIO_read_spec_int32 ("depth", (int32_t *) &depth),
+          GNUNET_BIO_read_spec_int64 ("offset", (int64_t *) &offset),
+          GNUNET_BIO_read_spec_int32 ("state", (int32_t *) &state),
+          GNUNET_BIO_read_spec_end (),
+        };
+
+        if ((GNUNET_OK != GNUNET_BIO_read_spec_commit (rh, rs)) ||
+            (NULL == dc->top_request) ||
+            (state > BRS_ERROR) ||
+            (NULL == (dr = find_download_request (dc->top_request,
+                                                  depth,
+                                                  offset))))
+        {
+          GNUNET_break (0);
+          return GNUNET_SYSERR;
+        }
+        if ((BRS_CHK_SET == state) &&
+            (GNUNET_OK !=
+             GNUNET_BIO_read (rh, "chk", &dr->chk, sizeof(struct
+                                                           ContentHashKey))))
+          return GNUNET_SYSERR;
+        dr->state = (enum BlockRequestState) state;
+        break;
+      }
+
+    case JOURNAL_DOWNLOAD_PROGRESS:
+      {
+        struct GNUNET_BIO_ReadSpec rs[] = {
+          GNUNET_BIO_read_spec_int64 ("completed", (int64_t *) &dc->completed),
+          GNUNET_BIO_read_spec_int32 ("has finished",
+                                      (int32_t *) &dc->has_finished),
+          GNUNET_BIO_read_spec_end (),
+        };
+
+        if (GNUNET_OK != GNUNET_BIO_read_spec_commit (rh, rs))
+          return GNUNET_SYSERR;
+        break;
+      }
+
+    default:
+      GNUNET_break (0);
+      return GNUNET_SYSERR;
+    }
+  }
+}
+
+
+void
+GNUNET_FS_download_journal_request_ (struct GNUNET_FS_DownloadContext *dc,
+                                     const struct DownloadRequest *dr)
+{
+  int32_t tag = JOURNAL_DOWNLOAD_REQUEST;
+  int32_t depth = dr->depth;
+  int64_t offset = dr->offset;
+  int32_t state = dr->state;
+  struct GNUNET_BIO_WriteSpec ws[] = {
+    GNUNET_BIO_write_spec_int32 ("tag", &tag),
+    GNUNET_BIO_write_spec_int32 ("depth", &depth),
+    GNUNET_BIO_write_spec_int64 ("offset", &offset),
+    GNUNET_BIO_write_spec_int32 ("state", &state),
+    GNUNET_BIO_write_spec_end (),
+  };
+
+  if ((NULL == dc->serialization) ||
+      (dc->journal_stale) ||
+      (0 != (dc->options & GNUNET_FS_DOWNLOAD_IS_PROBE)))
+    return; /* the next sync writes everything anyway */
+  if (NULL == dc->journal)
+    dc->journal = GNUNET_BIO_write_open_buffer ();
+  if ((GNUNET_OK != GNUNET_BIO_write_spec_commit (dc->journal, ws)) ||
+      ((BRS_CHK_SET == dr->state) &&
+       (GNUNET_OK != GNUNET_BIO_write (dc->journal,
+                                       "chk",
+                                       &dr->chk,
+                                       sizeof(struct ContentHashKey)))))
+  {
+    GNUNET_break (0);
+    dc->journal_stale = true;
+  }
+}
+
+
 /**
  * Compute the name of the sync file (or directory) for the given download
  * context.
@@ -2037,12 +2230,73 @@ get_download_sync_filename (struct GNUNET_FS_DownloadContext *dc,
 }
 
 
+/**
+ * Append the changes to the request tree of a download and its
+ * progress to its serialization file, unless the journal in the
+ * file should be compacted or cannot express what changed.
+ *
+ * @param dc the download to sync
+ * @return #GNUNET_OK on success, #GNUNET_NO if the file must be
+ *         written in full instead, #GNUNET_SYSERR on error
+ */
+static enum GNUNET_GenericReturnValue
+append_download_journal (struct GNUNET_FS_DownloadContext *dc)
+{
+  struct GNUNET_BIO_WriteHandle *journal = dc->journal;
+  enum GNUNET_GenericReturnValue ret;
+  uint64_t appended;
+  char *fn;
+  int32_t tag = JOURNAL_DOWNLOAD_PROGRESS;
+  struct GNUNET_BIO_WriteSpec ws[] = {
+    GNUNET_BIO_write_spec_int32 ("tag", &tag),
+    GNUNET_BIO_write_spec_int64 ("completed", (int64_t *) &dc->completed),
+    GNUNET_BIO_write_spec_int32 ("has finished",
+                                 (int32_t *) &dc->has_finished),
+    GNUNET_BIO_write_spec_end (),
+  };
+
+  dc->journal = NULL;
+  /* once the journal is larger than the rest of the file, rewriting
+     the file costs less than what we appended since it was written */
+  if ((NULL == dc->serialization) ||
+      (dc->journal_stale) ||
+      (NULL != dc->emsg) ||
+      (NULL == dc->top_request) ||
+      (dc->journal_size > dc->snapshot_size))
+  {
+    if (NULL != journal)
+      (void) GNUNET_BIO_write_close (journal, NULL);
+    return GNUNET_NO;
+  }
+  if (NULL == journal)
+    journal = GNUNET_BIO_write_open_buffer ();
+  fn = get_download_sync_filename (dc, dc->serialization, "");
+  if ((NULL == fn) ||
+      (GNUNET_OK != GNUNET_BIO_write_spec_commit (journal, ws)))
+  {
+    (void) GNUNET_BIO_write_close (journal, NULL);
+    GNUNET_free (fn);
+    return GNUNET_NO;
+  }
+  ret = append_journal (fn, journal, &appended);
+  GNUNET_free (fn);
+  if (GNUNET_OK != ret)
+    return GNUNET_NO;
+  dc->journal_size += appended;
+  return GNUNET_OK;
+}
+
+
 /**
  * Synchronize this download struct with its mirror
  * on disk.  Note that all internal FS-operations that change
  * publishing structs should already call "sync" internally,
  * so this function is likely not useful for clients.
  *
+ * Usually, only what changed since the last sync is appended
+ * to the journal at the end of the file; the file is written in
+ * full when the journal has grown too large.
+ *
  * @param dc the struct to sync
  */
 void
@@ -2055,6 +2309,8 @@ GNUNET_FS_download_sync_ (struct GNUNET_FS_DownloadContext *dc)
 
   if (0 != (dc->options & GNUNET_FS_DOWNLOAD_IS_PROBE))
     return; /* we don't sync probes */
+  if (GNUNET_OK == append_download_journal (dc))
+    return;
   if (NULL == dc->serialization)
   {
     dir = get_download_sync_filename (dc, "", "");
@@ -2131,6 +2387,11 @@ GNUNET_FS_download_sync_ (struct GNUNET_FS_DownloadContext *dc)
       goto cleanup;
     }
   }
+  if (GNUNET_OK != GNUNET_BIO_write_int32 (wh, "journal end", JOURNAL_END))
+  {
+    GNUNET_break (0);
+    goto cleanup;
+  }
   GNUNET_free (uris);
   uris = NULL;
   if (GNUNET_OK != GNUNET_BIO_write_close (wh, NULL))
@@ -2139,6 +2400,11 @@ GNUNET_FS_download_sync_ (struct GNUNET_FS_DownloadContext *dc)
     GNUNET_break (0);
     goto cleanup;
   }
+  if (GNUNET_OK !=
+      GNUNET_DISK_file_size (fn, &dc->snapshot_size, GNUNET_YES, GNUNET_YES))
+    dc->snapshot_size = 0;
+  dc->journal_size = 0;
+  dc->journal_stale = false;
   GNUNET_free (fn);
   return;
 cleanup:
@@ -2154,45 +2420,52 @@ cleanup:
 
 
 /**
- * Synchronize this search result with its mirror
- * on disk.  Note that all internal FS-operations that change
- * publishing structs should already call "sync" internally,
- * so this function is likely not useful for clients.
+ * Name of the file with the journal of the results of a search, in
+ * the directory of the search.  Cannot clash with the names that
+ * GNUNET_DISK_mktemp() picked for the one file per result that we
+ * used to write.
+ */
+#define SEARCH_RESULTS_JOURNAL "results"
+
+
+/**
+ * Return the name of the file with the results of a search.
  *
- * @param sr the struct to sync
+ * @param sc the search
+ * @return NULL on error
  */
-void
-GNUNET_FS_search_result_sync_ (struct GNUNET_FS_SearchResult *sr)
+static char *
+get_search_results_filename (struct GNUNET_FS_SearchContext *sc)
+{
+  return get_serialization_file_name_in_dir (sc->h,
+                                             (NULL == sc->psearch_result)
+                                             ? GNUNET_FS_SYNC_PATH_MASTER_SEARCH
+                                             : GNUNET_FS_SYNC_PATH_CHILD_SEARCH,
+                                             sc->serialization,
+                                             SEARCH_RESULTS_JOURNAL);
+}
+
+
+/**
+ * Write a #JOURNAL_SEARCH_RESULT record with all of a search result.
+ *
+ * @param wh where to write the record
+ * @param sr the search result
+ * @return #GNUNET_OK on success
+ */
+static enum GNUNET_GenericReturnValue
+write_search_result (struct GNUNET_BIO_WriteHandle *wh,
+                     struct GNUNET_FS_SearchResult *sr)
 {
-  struct GNUNET_BIO_WriteHandle *wh;
   char *uris;
+  enum GNUNET_GenericReturnValue ret;
 
-  if (NULL == sr->sc)
-    return;
-  uris = NULL;
-  if (NULL == sr->serialization)
-    sr->serialization =
-      make_serialization_file_name_in_dir (sr->h,
-                                           (sr->sc->psearch_result == NULL)
-                                           ? GNUNET_FS_SYNC_PATH_MASTER_SEARCH
-                                           : GNUNET_FS_SYNC_PATH_CHILD_SEARCH,
-                                           sr->sc->serialization);
-  if (NULL == sr->serialization)
-    return;
-  wh = get_write_handle_in_dir (sr->h,
-                                (sr->sc->psearch_result == NULL)
-                                ? GNUNET_FS_SYNC_PATH_MASTER_SEARCH
-                                : GNUNET_FS_SYNC_PATH_CHILD_SEARCH,
-                                sr->sc->serialization,
-                                sr->serialization);
-  if (NULL == wh)
-  {
-    GNUNET_break (0);
-    goto cleanup;
-  }
   uris = GNUNET_FS_uri_to_string (sr->uri);
   {
+    int32_t tag = JOURNAL_SEARCH_RESULT;
     struct GNUNET_BIO_WriteSpec ws[] = {
+      GNUNET_BIO_write_spec_int32 ("tag", &tag),
+      GNUNET_BIO_write_spec_string ("serialization", sr->serialization),
       GNUNET_BIO_write_spec_string ("uris", uris),
       GNUNET_BIO_write_spec_string ("download serialization",
                                     (sr->download != NULL)
@@ -2215,52 +2488,220 @@ GNUNET_FS_search_result_sync_ (struct GNUNET_FS_SearchResult *sr)
                                    (int32_t *) &sr->availability_trials),
       GNUNET_BIO_write_spec_end (),
     };
-    if ((GNUNET_OK != GNUNET_BIO_write_spec_commit (wh, ws)))
-    {
-      GNUNET_break (0);
-      goto cleanup;
-    }
+
+    ret = GNUNET_BIO_write_spec_commit (wh, ws);
   }
+  GNUNET_free (uris);
+  if (GNUNET_OK != ret)
+    return ret;
   if ((NULL != sr->uri) && (GNUNET_FS_URI_KSK == sr->sc->uri->type) &&
       (GNUNET_OK !=
        GNUNET_BIO_write (wh,
                          "keyword bitmap",
                          sr->keyword_bitmap,
                          (sr->sc->uri->data.ksk.keywordCount + 7) / 8)))
-  {
-    GNUNET_break (0);
-    goto cleanup;
-  }
-  if (GNUNET_OK != GNUNET_BIO_write_close (wh, NULL))
-  {
-    wh = NULL;
-    GNUNET_break (0);
-    goto cleanup;
-  }
-  GNUNET_free (uris);
-  return;
-cleanup:
-  GNUNET_free (uris);
-  if (NULL != wh)
-    (void) GNUNET_BIO_write_close (wh, NULL);
-  remove_sync_file_in_dir (sr->h,
-                           (NULL == sr->sc->psearch_result)
-                           ? GNUNET_FS_SYNC_PATH_MASTER_SEARCH
-                           : GNUNET_FS_SYNC_PATH_CHILD_SEARCH,
-                           sr->sc->serialization,
-                           sr->serialization);
-  GNUNET_free (sr->serialization);
-  sr->serialization = NULL;
+    return GNUNET_SYSERR;
+  return GNUNET_OK;
 }
 
 
 /**
- * Synchronize this search struct with its mirror
- * on disk.  Note that all internal FS-operations that change
- * publishing structs should already call "sync" internally,
- * so this function is likely not useful for clients.
+ * Write a search result to the results file of its search
+ * (if it was synced before).
  *
- * @param sc the struct to sync
+ * @param cls the `struct GNUNET_BIO_WriteHandle *` to write to
+ * @param key the key of the search result (unused)
+ * @param value the `struct GNUNET_FS_SearchResult`
+ * @return #GNUNET_OK to continue, #GNUNET_SYSERR on error
+ */
+static int
+write_search_result_it (void *cls,
+                        const struct GNUNET_HashCode *key,
+                        void *value)
+{
+  struct GNUNET_BIO_WriteHandle *wh = cls;
+  struct GNUNET_FS_SearchResult *sr = value;
+
+  (void) key;
+  if (NULL == sr->serialization)
+    return GNUNET_OK; /* never synced */
+  return write_search_result (wh, sr);
+}
+
+
+/**
+ * Write the results file of a search in full, compacting its
+ * journal.
+ *
+ * @param sc the search
+ * @return #GNUNET_OK on success
+ */
+static enum GNUNET_GenericReturnValue
+write_search_results (struct GNUNET_FS_SearchContext *sc)
+{
+  struct GNUNET_BIO_WriteHandle *wh;
+  char *fn;
+
+  fn = get_search_results_filename (sc);
+  if (NULL == fn)
+    return GNUNET_SYSERR;
+  if (GNUNET_OK != GNUNET_DISK_directory_create_for_file (fn))
+  {
+    GNUNET_free (fn);
+    return GNUNET_SYSERR;
+  }
+  wh = GNUNET_BIO_write_open_file (fn);
+  if (NULL == wh)
+  {
+    GNUNET_break (0);
+    GNUNET_free (fn);
+    return GNUNET_SYSERR;
+  }
+  if ((GNUNET_SYSERR ==
+       GNUNET_CONTAINER_multihashmap_iterate (sc->master_result_map,
+                                              &write_search_result_it,
+                                              wh)) ||
+      (GNUNET_OK != GNUNET_BIO_write_int32 (wh, "journal end", JOURNAL_END)))
+  {
+    GNUNET_break (0);
+    (void) GNUNET_BIO_write_close (wh, NULL);
+    goto cleanup;
+  }
+  if (GNUNET_OK != GNUNET_BIO_write_close (wh, NULL))
+  {
+    GNUNET_break (0);
+    goto cleanup;
+  }
+  if (GNUNET_OK !=
+      GNUNET_DISK_file_size (fn,
+                             &sc->results_snapshot_size,
+                             GNUNET_YES,
+                             GNUNET_YES))
+    sc->results_snapshot_size = 0;
+  sc->results_journal_size = 0;
+  GNUNET_free (fn);
+  return GNUNET_OK;
+cleanup:
+  if (0 != unlink (fn))
+    GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_WARNING, "unlink", fn);
+  GNUNET_free (fn);
+  return GNUNET_SYSERR;
+}
+
+
+/**
+ * Append records about the results of a search to its results file,
+ * or write the file in full if its journal has grown too large.
+ *
+ * @param sc the search
+ * @param records buffer with the records, will be closed
+ */
+static void
+append_search_results (struct GNUNET_FS_SearchContext *sc,
+                       struct GNUNET_BIO_WriteHandle *records)
+{
+  uint64_t appended;
+  char *fn;
+
+  /* once the journal is larger than the results, rewriting the
+     file costs less than what we appended since it was written */
+  if (sc->results_journal_size > sc->results_snapshot_size)
+  {
+    (void) GNUNET_BIO_write_close (records, NULL);
+    (void) write_search_results (sc);
+    return;
+  }
+  fn = get_search_results_filename (sc);
+  if (NULL == fn)
+  {
+    (void) GNUNET_BIO_write_close (records, NULL);
+    return;
+  }
+  if (GNUNET_OK == append_journal (fn, records, &appended))
+    sc->results_journal_size += appended;
+  else
+    (void) write_search_results (sc); /* file was damaged */
+  GNUNET_free (fn);
+}
+
+
+/**
+ * Synchronize this search result with its mirror
+ * on disk.  Note that all internal FS-operations that change
+ * publishing structs should already call "sync" internally,
+ * so this function is likely not useful for clients.
+ *
+ * The results of a search are kept in one file, to which we
+ * append the result whenever it changes.
+ *
+ * @param sr the struct to sync
+ */
+void
+GNUNET_FS_search_result_sync_ (struct GNUNET_FS_SearchResult *sr)
+{
+  struct GNUNET_BIO_WriteHandle *wh;
+
+  if ((NULL == sr->sc) ||
+      (NULL == sr->sc->serialization))
+    return;
+  if (NULL == sr->serialization)
+    GNUNET_asprintf (&sr->serialization,
+                     "%016llx",
+                     (unsigned long long) GNUNET_CRYPTO_random_u64 (
+                       GNUNET_CRYPTO_QUALITY_NONCE,
+                       UINT64_MAX));
+  wh = GNUNET_BIO_write_open_buffer ();
+  if (GNUNET_OK != write_search_result (wh, sr))
+  {
+    GNUNET_break (0);
+    (void) GNUNET_BIO_write_close (wh, NULL);
+    return;
+  }
+  append_search_results (sr->sc, wh);
+}
+
+
+void
+GNUNET_FS_search_result_sync_availability_ (struct GNUNET_FS_SearchResult *sr)
+{
+  struct GNUNET_BIO_WriteHandle *wh;
+  int32_t tag = JOURNAL_SEARCH_AVAILABILITY;
+  struct GNUNET_BIO_WriteSpec ws[] = {
+    GNUNET_BIO_write_spec_int32 ("tag", &tag),
+    GNUNET_BIO_write_spec_string ("serialization", sr->serialization),
+    GNUNET_BIO_write_spec_int32 ("availability success",
+                                 (int32_t *) &sr->availability_success),
+    GNUNET_BIO_write_spec_int32 ("availability trials",
+                                 (int32_t *) &sr->availability_trials),
+    GNUNET_BIO_write_spec_end (),
+  };
+
+  if ((NULL == sr->sc) ||
+      (NULL == sr->sc->serialization))
+    return;
+  if (NULL == sr->serialization)
+  {
+    GNUNET_FS_search_result_sync_ (sr);
+    return;
+  }
+  wh = GNUNET_BIO_write_open_buffer ();
+  if (GNUNET_OK != GNUNET_BIO_write_spec_commit (wh, ws))
+  {
+    GNUNET_break (0);
+    (void) GNUNET_BIO_write_close (wh, NULL);
+    return;
+  }
+  append_search_results (sr->sc, wh);
+}
+
+
+/**
+ * Synchronize this search struct with its mirror
+ * on disk.  Note that all internal FS-operations that change
+ * publishing structs should already call "sync" internally,
+ * so this function is likely not useful for clients.
+ *
+ * @param sc the struct to sync
  */
 void
 GNUNET_FS_search_sync_ (struct GNUNET_FS_SearchContext *sc)
@@ -2526,57 +2967,44 @@ deserialize_search (struct GNUNET_FS_Handle *h,
 
 
 /**
- * Function called with a filename of serialized search result
- * to deserialize.
+ * Read the fields of a search result (following its serialization
+ * name) as written by write_search_result().
  *
- * @param cls the `struct GNUNET_FS_SearchContext *`
- * @param filename complete filename (absolute path)
- * @return #GNUNET_OK (continue to iterate)
+ * @param sc the search the result belongs to
+ * @param rh where to read from
+ * @param serialization name of the result, will be owned by the result
+ * @param[out] download set to the serialization name of the download
+ *             of the result, NULL for none
+ * @param[out] update_srch set to the serialization name of the update
+ *             search of the result, NULL for none
+ * @return the search result, NULL on error
  */
-static int
-deserialize_search_result (void *cls, const char *filename)
+static struct GNUNET_FS_SearchResult *
+read_search_result (struct GNUNET_FS_SearchContext *sc,
+                    struct GNUNET_BIO_ReadHandle *rh,
+                    char *serialization,
+                    char **download,
+                    char **update_srch)
 {
-  struct GNUNET_FS_SearchContext *sc = cls;
-  char *serialized;
+  struct GNUNET_FS_SearchResult *sr;
   char *uris;
   char *emsg;
-  char *download;
-  char *update_srch;
-  struct GNUNET_BIO_ReadHandle *rh;
-  struct GNUNET_BIO_ReadHandle *drh;
-  struct GNUNET_FS_SearchResult *sr;
 
-  serialized = get_serialization_short_name (filename);
-  rh = GNUNET_BIO_read_open_file (filename);
-  if (NULL == rh)
-  {
-    if (NULL != serialized)
-    {
-      remove_sync_file_in_dir (sc->h,
-                               (NULL == sc->psearch_result)
-                               ? GNUNET_FS_SYNC_PATH_MASTER_SEARCH
-                               : GNUNET_FS_SYNC_PATH_CHILD_SEARCH,
-                               sc->serialization,
-                               serialized);
-      GNUNET_free (serialized);
-    }
-    return GNUNET_OK;
-  }
   emsg = NULL;
   uris = NULL;
-  download = NULL;
-  update_srch = NULL;
+  *download = NULL;
+  *update_srch = NULL;
   sr = GNUNET_new (struct GNUNET_FS_SearchResult);
   sr->h = sc->h;
   sr->sc = sc;
-  sr->serialization = serialized;
+  sr->serialization = serialization;
   if ((GNUNET_OK !=
        GNUNET_BIO_read_string (rh, "result-uri", &uris, 10 * 1024)) ||
       (NULL == (sr->uri = GNUNET_FS_uri_parse (uris, &emsg))) ||
       (GNUNET_OK !=
-       GNUNET_BIO_read_string (rh, "download-lnk", &download, 16)) ||
+       GNUNET_BIO_read_string (rh, "download-lnk", download, 16)) ||
       (GNUNET_OK !=
-       GNUNET_BIO_read_string (rh, "search-lnk", &update_srch, 16)) ||
+       GNUNET_BIO_read_string (rh, "search-lnk", update_srch, 16)) ||
       (GNUNET_OK != GNUNET_FS_read_meta_data (rh, "result-meta", &sr->meta)) ||
       (GNUNET_OK != GNUNET_BIO_read (rh,
                                      "result-key",
@@ -2617,6 +3045,43 @@ deserialize_search_result (void *cls, const char *filename)
     }
   }
   GNUNET_free (uris);
+  return sr;
+cleanup:
+  GNUNET_free (*download);
+  GNUNET_free (*update_srch);
+  GNUNET_free (emsg);
+  GNUNET_free (uris);
+  if (NULL != sr->uri)
+    GNUNET_FS_uri_destroy (sr->uri);
+  if (NULL != sr->meta)
+    GNUNET_FS_meta_data_destroy (sr->meta);
+  GNUNET_free (sr->keyword_bitmap);
+  GNUNET_free (sr->serialization);
+  GNUNET_free (sr);
+  return NULL;
+}
+
+
+/**
+ * Resume the download and the update search of a search result
+ * we read from disk, and add the result to its search.
+ *
+ * @param sc the search the result belongs to
+ * @param sr the search result
+ * @param download serialization name of the download of the result,
+ *        NULL for none; will be freed
+ * @param update_srch serialization name of the update search of the
+ *        result, NULL for none; will be freed
+ */
+static void
+resume_search_result (struct GNUNET_FS_SearchContext *sc,
+                      struct GNUNET_FS_SearchResult *sr,
+                      char *download,
+                      char *update_srch)
+{
+  struct GNUNET_BIO_ReadHandle *drh;
+  char *emsg;
+
   if (NULL != download)
   {
     drh = get_read_handle (sc->h, GNUNET_FS_SYNC_PATH_CHILD_DOWNLOAD, download);
@@ -2657,6 +3122,54 @@ deserialize_search_result (void *cls, const char *filename)
                   &sr->key,
                   sr,
                   GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
+}
+
+
+/**
+ * Function called with a filename of serialized search result
+ * to deserialize, for results written by older versions (one
+ * file per result).
+ *
+ * @param cls the `struct GNUNET_FS_SearchContext *`
+ * @param filename complete filename (absolute path)
+ * @return #GNUNET_OK (continue to iterate)
+ */
+static int
+deserialize_search_result (void *cls, const char *filename)
+{
+  struct GNUNET_FS_SearchContext *sc = cls;
+  char *serialized;
+  char *emsg;
+  char *download;
+  char *update_srch;
+  struct GNUNET_BIO_ReadHandle *rh;
+  struct GNUNET_FS_SearchResult *sr;
+
+  serialized = get_serialization_short_name (filename);
+  if ((NULL != serialized) &&
+      (0 == strcmp (serialized, SEARCH_RESULTS_JOURNAL)))
+  {
+    GNUNET_free (serialized);
+    return GNUNET_OK;
+  }
+  rh = GNUNET_BIO_read_open_file (filename);
+  if (NULL == rh)
+  {
+    if (NULL != serialized)
+    {
+      remove_sync_file_in_dir (sc->h,
+                               (NULL == sc->psearch_result)
+                               ? GNUNET_FS_SYNC_PATH_MASTER_SEARCH
+                               : GNUNET_FS_SYNC_PATH_CHILD_SEARCH,
+                               sc->serialization,
+                               serialized);
+      GNUNET_free (serialized);
+    }
+    return GNUNET_OK;
+  }
+  sr = read_search_result (sc, rh, serialized, &download, &update_srch);
+  if (NULL != sr)
+    resume_search_result (sc, sr, download, update_srch);
   if (GNUNET_OK != GNUNET_BIO_read_close (rh, &emsg))
   {
     GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
@@ -2666,26 +3179,234 @@ deserialize_search_result (void *cls, const char *filename)
     GNUNET_free (emsg);
   }
   return GNUNET_OK;
-cleanup:
-  GNUNET_free (download);
-  GNUNET_free (emsg);
-  GNUNET_free (uris);
-  GNUNET_free (update_srch);
-  if (NULL != sr->uri)
-    GNUNET_FS_uri_destroy (sr->uri);
-  if (NULL != sr->meta)
-    GNUNET_FS_meta_data_destroy (sr->meta);
+}
+
+
+/**
+ * Remove a file with a search result written by an older version,
+ * after its result was moved to the results file of the search.
+ *
+ * @param cls the `struct GNUNET_FS_SearchContext *`
+ * @param filename complete filename (absolute path)
+ * @return #GNUNET_OK (continue to iterate)
+ */
+static int
+remove_search_result_file (void *cls, const char *filename)
+{
+  char *serialized;
+
+  (void) cls;
+  serialized = get_serialization_short_name (filename);
+  if ((NULL != serialized) &&
+      (0 != strcmp (serialized, SEARCH_RESULTS_JOURNAL)) &&
+      (0 != unlink (filename)))
+    GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_WARNING, "unlink", filename);
+  GNUNET_free (serialized);
+  return GNUNET_OK;
+}
+
+
+/**
+ * A search result read from the results file of a search, kept
+ * until we know whether a later record replaces it.
+ */
+struct JournaledResult
+{
+  /**
+   * The search result.
+   */
+  struct GNUNET_FS_SearchResult *sr;
+
+  /**
+   * Serialization name of the download of the result, or NULL.
+   */
+  char *download;
+
+  /**
+   * Serialization name of the update search of the result, or NULL.
+   */
+  char *update_srch;
+};
+
+
+/**
+ * Free a search result read from the results file that a later
+ * record replaced (or that we failed to resume).
+ *
+ * @param jr the result to free
+ */
+static void
+free_journaled_result (struct JournaledResult *jr)
+{
+  struct GNUNET_FS_SearchResult *sr = jr->sr;
+
+  GNUNET_FS_uri_destroy (sr->uri);
+  GNUNET_FS_meta_data_destroy (sr->meta);
+  GNUNET_free (sr->keyword_bitmap);
   GNUNET_free (sr->serialization);
   GNUNET_free (sr);
+  GNUNET_free (jr->download);
+  GNUNET_free (jr->update_srch);
+  GNUNET_free (jr);
+}
+
+
+/**
+ * Resume a search result once its last record was read.
+ *
+ * @param cls the `struct GNUNET_FS_SearchContext *`
+ * @param key hash of the serialization name of the result (unused)
+ * @param value the `struct JournaledResult`
+ * @return #GNUNET_OK (continue to iterate)
+ */
+static int
+resume_journaled_result (void *cls,
+                         const struct GNUNET_HashCode *key,
+                         void *value)
+{
+  struct GNUNET_FS_SearchContext *sc = cls;
+  struct JournaledResult *jr = value;
+
+  (void) key;
+  resume_search_result (sc, jr->sr, jr->download, jr->update_srch);
+  GNUNET_free (jr);
+  return GNUNET_OK;
+}
+
+
+/**
+ * Read the results file of a search, replaying its journal, and
+ * resume the results.
+ *
+ * @param sc the search
+ * @return #GNUNET_OK on success (or if there is no such file),
+ *         #GNUNET_SYSERR if the file is damaged (the results we
+ *         could read are resumed)
+ */
+static enum GNUNET_GenericReturnValue
+read_search_results (struct GNUNET_FS_SearchContext *sc)
+{
+  struct GNUNET_CONTAINER_MultiHashMap *results;
+  struct GNUNET_BIO_ReadHandle *rh;
+  struct JournaledResult *jr;
+  struct GNUNET_HashCode hc;
+  enum GNUNET_GenericReturnValue ret;
+  char *fn;
+  char *serialized;
+  char *emsg;
+  int32_t tag;
+  int32_t success;
+  int32_t trials;
+
+  fn = get_search_results_filename (sc);
+  if (NULL == fn)
+    return GNUNET_OK;
+  if (GNUNET_YES != GNUNET_DISK_file_test (fn))
+  {
+    GNUNET_free (fn);
+    return GNUNET_OK;
+  }
+  rh = GNUNET_BIO_read_open_file (fn);
+  if (NULL == rh)
+  {
+    GNUNET_free (fn);
+    return GNUNET_SYSERR;
+  }
+  results = GNUNET_CONTAINER_multihashmap_create (16, GNUNET_NO);
+  ret = GNUNET_SYSERR;
+  while (GNUNET_OK == GNUNET_BIO_read_int32 (rh, "journal tag", &tag))
+  {
+    if (JOURNAL_END == tag)
+    {
+      ret = GNUNET_OK;
+      break;
+    }
+    serialized = NULL;
+    if (GNUNET_OK !=
+        GNUNET_BIO_read_string (rh, "serialization", &serialized, 64))
+      break;
+    if (NULL == serialized)
+    {
+      GNUNET_break (0);
+      break;
+    }
+    GNUNET_CRYPTO_hash (serialized, strlen (serialized), &hc);
+    if (JOURNAL_SEARCH_RESULT == tag)
+    {
+      jr = GNUNET_new (struct JournaledResult);
+      jr->sr = read_search_result (sc,
+                                   rh,
+                                   serialized,
+                                   &jr->download,
+                                   &jr->update_srch);
+      if (NULL == jr->sr)
+      {
+        GNUNET_free (jr);
+        break;
+      }
+      {
+        struct JournaledResult *old;
+
+        old = GNUNET_CONTAINER_multihashmap_get (results, &hc);
+        if (NULL != old)
+        {
+          GNUNET_assert (GNUNET_YES ==
+                         GNUNET_CONTAINER_multihashmap_remove (results,
+                                                               &hc,
+                                                               old));
+          free_journaled_result (old);
+        }
+      }
+      GNUNET_assert (GNUNET_OK ==
+                     GNUNET_CONTAINER_multihashmap_put (
+                       results,
+                       &hc,
+                       jr,
+                       GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+      continue;
+    }
+    GNUNET_free (serialized);
+    if (JOURNAL_SEARCH_AVAILABILITY != tag)
+    {
+      GNUNET_break (0);
+      break;
+    }
+    if ((GNUNET_OK !=
+         GNUNET_BIO_read_int32 (rh, "availability success", &success)) ||
+        (GNUNET_OK !=
+         GNUNET_BIO_read_int32 (rh, "availability trials", &trials)))
+      break;
+    jr = GNUNET_CONTAINER_multihashmap_get (results, &hc);
+    if (NULL == jr)
+    {
+      GNUNET_break (0);
+      break;
+    }
+    jr->sr->availability_success = success;
+    jr->sr->availability_trials = trials;
+  }
   if (GNUNET_OK != GNUNET_BIO_read_close (rh, &emsg))
   {
     GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
                 _ ("Failure while resuming search operation `%s': %s\n"),
-                filename,
+                fn,
                 emsg);
     GNUNET_free (emsg);
   }
-  return GNUNET_OK;
+  /* continue appending to the file as we found it */
+  if ((GNUNET_OK == ret) &&
+      (GNUNET_OK !=
+       GNUNET_DISK_file_size (fn,
+                              &sc->results_snapshot_size,
+                              GNUNET_YES,
+                              GNUNET_YES)))
+    sc->results_snapshot_size = 0;
+  GNUNET_free (fn);
+  GNUNET_CONTAINER_multihashmap_iterate (results,
+                                         &resume_journaled_result,
+                                         sc);
+  GNUNET_CONTAINER_multihashmap_destroy (results);
+  return ret;
 }
 
 
@@ -2997,6 +3718,11 @@ deserialize_download (struct GNUNET_FS_Handle *h,
       goto cleanup;
     }
   }
+  /* a truncated journal (or none, from older versions) still leaves
+     us with a consistent, if older, state; either way, we write the
+     file in full on the next sync */
+  (void) read_download_journal (rh, dc);
+  dc->journal_stale = true;
   dn = get_download_sync_filename (dc, dc->serialization, ".dir");
   if (NULL != dn)
   {
@@ -3072,6 +3798,8 @@ deserialize_search (struct GNUNET_FS_Handle *h,
   char *dn;
   uint32_t options;
   char in_pause;
+  enum GNUNET_GenericReturnValue journal_ok;
+  unsigned int num_results;
 
   if ((NULL != psearch_result) && (NULL != psearch_result->update_search))
   {
@@ -3108,6 +3836,8 @@ deserialize_search (struct GNUNET_FS_Handle *h,
   }
   sc->options = (enum GNUNET_FS_SearchOptions) options;
   sc->master_result_map = GNUNET_CONTAINER_multihashmap_create (16, GNUNET_NO);
+  journal_ok = read_search_results (sc);
+  num_results = GNUNET_CONTAINER_multihashmap_size (sc->master_result_map);
   dn = get_serialization_file_name_in_dir (h,
                                            (NULL == sc->psearch_result)
                                            ? GNUNET_FS_SYNC_PATH_MASTER_SEARCH
@@ -3118,6 +3848,15 @@ deserialize_search (struct GNUNET_FS_Handle *h,
   {
     if (GNUNET_YES == GNUNET_DISK_directory_test (dn, GNUNET_YES))
       GNUNET_DISK_directory_scan (dn, &deserialize_search_result, sc);
+    if ((GNUNET_OK != journal_ok) ||
+        (num_results !=
+         GNUNET_CONTAINER_multihashmap_size (sc->master_result_map)))
+    {
+      /* the results file was damaged, or we found results in the
+         layout of older versions; write them all to a new file */
+      if (GNUNET_OK == write_search_results (sc))
+        GNUNET_DISK_directory_scan (dn, &remove_search_result_file, sc);
+    }
     GNUNET_free (dn);
   }
   if (('\0' == in_pause) &&
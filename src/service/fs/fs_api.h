@@ -552,7 +552,8 @@ struct GNUNET_FS_SearchResult
   struct GNUNET_FS_SearchContext *update_search;
 
   /**
-   * Name under which this search result is stored on disk.
+   * Name under which this search result is recorded in the
+   * results journal of its search.
    */
   char *serialization;
 
@@ -949,6 +950,17 @@ void
 GNUNET_FS_search_result_sync_ (struct GNUNET_FS_SearchResult *sr);
 
 
+/**
+ * Synchronize the availability counters of this search result with
+ * its mirror on disk.  Cheaper than #GNUNET_FS_search_result_sync_()
+ * if nothing else about the result changed.
+ *
+ * @param sr the struct to sync
+ */
+void
+GNUNET_FS_search_result_sync_availability_ (struct GNUNET_FS_SearchResult *sr);
+
+
 /**
  * Synchronize this download struct with its mirror
  * on disk.  Note that all internal FS-operations that change
@@ -1582,6 +1594,18 @@ struct GNUNET_FS_SearchContext
    */
   struct GNUNET_SCHEDULER_Task *task;
 
+  /**
+   * Size of the journal with our results when it was last
+   * written in full.
+   */
+  uint64_t results_snapshot_size;
+
+  /**
+   * Number of bytes appended to the journal with our results
+   * since it was last written in full.
+   */
+  uint64_t results_journal_size;
+
   /**
    * Anonymity level for the search.
    */
@@ -1728,6 +1752,20 @@ void
 GNUNET_FS_free_download_request_ (struct DownloadRequest *dr);
 
 
+/**
+ * Remember that the state (and possibly the CHK) of a request of
+ * this download changed, so that the next #GNUNET_FS_download_sync_()
+ * can append the change to the serialization file instead of
+ * writing the whole request tree again.
+ *
+ * @param dc the download @a dr belongs to
+ * @param dr the request that changed
+ */
+void
+GNUNET_FS_download_journal_request_ (struct GNUNET_FS_DownloadContext *dc,
+                                     const struct DownloadRequest *dr);
+
+
 /**
  * Stop the ping task for this search result.
  *
@@ -1855,6 +1893,12 @@ struct GNUNET_FS_DownloadContext
    */
   struct DownloadRequest *top_request;
 
+  /**
+   * Changes to the states of the requests in @e top_request that were
+   * not yet appended to our serialization file, NULL for none.
+   */
+  struct GNUNET_BIO_WriteHandle *journal;
+
   /**
    * Identity of the peer having the content, or all-zeros
    * if we don't know of such a peer.
@@ -1889,6 +1933,17 @@ struct GNUNET_FS_DownloadContext
    */
   uint64_t completed;
 
+  /**
+   * Size of our serialization file when it was last written in full.
+   */
+  uint64_t snapshot_size;
+
+  /**
+   * Number of bytes appended to our serialization file since it
+   * was last written in full.
+   */
+  uint64_t journal_size;
+
   /**
    * What was the size of the file on disk that we're downloading
    * before we started?  Used to detect if there is a point in
@@ -1933,6 +1988,13 @@ struct GNUNET_FS_DownloadContext
    * Are we ready to issue requests (reconstructions are finished)?
    */
   int issue_requests;
+
+  /**
+   * Set if our state changed in a way that the journal cannot
+   * express, so that the next sync must write the serialization
+   * file in full.
+   */
+  bool journal_stale;
 };
 
 
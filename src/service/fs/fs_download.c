@@ -93,6 +93,24 @@ compute_disk_offset (uint64_t fsize, uint64_t off, unsigned int depth)
 }
 
 
+/**
+ * Change the state of a request and remember the change for the
+ * next sync.
+ *
+ * @param dc overall download @a dr belongs to
+ * @param dr request to change
+ * @param state new state of @a dr
+ */
+static void
+set_request_state (struct GNUNET_FS_DownloadContext *dc,
+                   struct DownloadRequest *dr,
+                   enum BlockRequestState state)
+{
+  dr->state = state;
+  GNUNET_FS_download_journal_request_ (dc, dr);
+}
+
+
 /**
  * Fill in all of the generic fields for a download event and call the
  * callback.
@@ -358,6 +376,7 @@ full_recursive_download (struct GNUNET_FS_DownloadContext *dc)
                                 dc->temp_filename);
     GNUNET_free (dc->temp_filename);
     dc->temp_filename = NULL;
+    dc->journal_stale = true;
   }
 }
 
@@ -500,7 +519,7 @@ try_match_block (struct GNUNET_FS_DownloadContext *dc,
   {
   case BRS_INIT:
     dr->chk = in_chk;
-    dr->state = BRS_RECONSTRUCT_META_UP;
+    set_request_state (dc, dr, BRS_RECONSTRUCT_META_UP);
     break;
 
   case BRS_CHK_SET:
@@ -529,7 +548,7 @@ try_match_block (struct GNUNET_FS_DownloadContext *dc,
                          _ ("Failed to open file `%s' for writing"),
                          fn);
         GNUNET_DISK_file_close (fh);
-        dr->state = BRS_ERROR;
+        set_request_state (dc, dr, BRS_ERROR);
         pi.status = GNUNET_FS_STATUS_DOWNLOAD_ERROR;
         pi.value.download.specifics.error.message = dc->emsg;
         GNUNET_FS_download_make_status_ (&pi, dc);
@@ -542,7 +561,7 @@ try_match_block (struct GNUNET_FS_DownloadContext *dc,
                          _ ("Failed to open file `%s' for writing"),
                          fn);
         GNUNET_DISK_file_close (fh);
-        dr->state = BRS_ERROR;
+        set_request_state (dc, dr, BRS_ERROR);
         pi.status = GNUNET_FS_STATUS_DOWNLOAD_ERROR;
         pi.value.download.specifics.error.message = dc->emsg;
         GNUNET_FS_download_make_status_ (&pi, dc);
@@ -551,7 +570,7 @@ try_match_block (struct GNUNET_FS_DownloadContext *dc,
       GNUNET_DISK_file_close (fh);
     }
     /* signal success */
-    dr->state = BRS_DOWNLOAD_UP;
+    set_request_state (dc, dr, BRS_DOWNLOAD_UP);
     dc->completed = dc->length;
     GNUNET_FS_download_sync_ (dc);
     pi.status = GNUNET_FS_STATUS_DOWNLOAD_PROGRESS;
@@ -628,16 +647,18 @@ match_full_data (void *cls,
  * Set the state of the given download request to
  * BRS_DOWNLOAD_UP and propagate it up the tree.
  *
+ * @param dc overall download @a dr belongs to
  * @param dr download request that is done
  */
 static void
-propagate_up (struct DownloadRequest *dr)
+propagate_up (struct GNUNET_FS_DownloadContext *dc,
+              struct DownloadRequest *dr)
 {
   unsigned int i;
 
   do
   {
-    dr->state = BRS_DOWNLOAD_UP;
+    set_request_state (dc, dr, BRS_DOWNLOAD_UP);
     dr = dr->parent;
     if (NULL == dr)
       break;
@@ -700,17 +721,17 @@ try_top_down_reconstruction (struct GNUNET_FS_DownloadContext *dc,
       encrypt_existing_match (dc, &dr->chk, dr, block, len, GNUNET_NO))
   {
     /* hash matches but encrypted block does not, really bad */
-    dr->state = BRS_ERROR;
+    set_request_state (dc, dr, BRS_ERROR);
     /* propagate up */
     while (NULL != dr->parent)
     {
       dr = dr->parent;
-      dr->state = BRS_ERROR;
+      set_request_state (dc, dr, BRS_ERROR);
     }
     return;
   }
   /* block matches */
-  dr->state = BRS_DOWNLOAD_DOWN;
+  set_request_state (dc, dr, BRS_DOWNLOAD_DOWN);
 
   /* set CHKs for children */
   up_done = GNUNET_YES;
@@ -723,15 +744,15 @@ try_top_down_reconstruction (struct GNUNET_FS_DownloadContext *dc,
     GNUNET_assert (0 == (drc->offset - dr->offset) % child_block_size);
     if (BRS_INIT == drc->state)
     {
-      drc->state = BRS_CHK_SET;
       drc->chk = chks[drc->chk_idx];
+      set_request_state (dc, drc, BRS_CHK_SET);
       try_top_down_reconstruction (dc, drc);
     }
     if (BRS_DOWNLOAD_UP != drc->state)
       up_done = GNUNET_NO;   /* children not all done */
   }
   if (GNUNET_YES == up_done)
-    propagate_up (dr); /* children all done (or no children...) */
+    propagate_up (dc, dr); /* children all done (or no children...) */
 }
 
 
@@ -1050,10 +1071,10 @@ process_result_with_request (void *cls,
     GNUNET_log (GNUNET_ERROR_TYPE_WARNING, "%s\n", dc->emsg);
     while (NULL != dr->parent)
     {
-      dr->state = BRS_ERROR;
+      set_request_state (dc, dr, BRS_ERROR);
       dr = dr->parent;
     }
-    dr->state = BRS_ERROR;
+    set_request_state (dc, dr, BRS_ERROR);
     goto signal_error;
   }
 
@@ -1150,7 +1171,7 @@ process_result_with_request (void *cls,
                                          dc);
   }
   GNUNET_assert (dc->completed <= dc->length);
-  dr->state = BRS_DOWNLOAD_DOWN;
+  set_request_state (dc, dr, BRS_DOWNLOAD_DOWN);
   pi.status = GNUNET_FS_STATUS_DOWNLOAD_PROGRESS;
   pi.value.download.specifics.progress.data = pt;
   pi.value.download.specifics.progress.offset = dr->offset;
@@ -1168,7 +1189,7 @@ process_result_with_request (void *cls,
       GNUNET_TIME_UNIT_ZERO; /* found locally */
   GNUNET_FS_download_make_status_ (&pi, dc);
   if (0 == dr->depth)
-    propagate_up (dr);
+    propagate_up (dc, dr);
 
   if (dc->completed == dc->length)
   {
@@ -1219,7 +1240,7 @@ process_result_with_request (void *cls,
         goto signal_error;
       }
       drc->chk = chkarr[drc->chk_idx];
-      drc->state = BRS_CHK_SET;
+      set_request_state (dc, drc, BRS_CHK_SET);
       if (GNUNET_YES == dc->issue_requests)
         schedule_block_download (dc, drc);
       break;
@@ -1685,7 +1706,7 @@ reconstruct_cb (void *cls,
         depth);
       /* block matches, hence tree below matches;
        * this request is done! */
-      dr->state = BRS_DOWNLOAD_UP;
+      set_request_state (dc, dr, BRS_DOWNLOAD_UP);
       (void) GNUNET_CONTAINER_multihashmap_remove (dc->active,
                                                    &dr->chk.query,
                                                    dr);
@@ -1843,6 +1864,7 @@ GNUNET_FS_download_start_task_ (void *cls)
     dc->top_request->chk = (dc->uri->type == GNUNET_FS_URI_CHK)
                            ? dc->uri->data.chk.chk
                            : dc->uri->data.loc.fi.chk;
+    dc->journal_stale = true;
     /* signal start */
     GNUNET_FS_download_sync_ (dc);
     if (NULL != dc->search)
@@ -1989,6 +2011,8 @@ GNUNET_FS_download_signal_suspend_ (void *cls)
     GNUNET_DISK_file_close (dc->rfh);
     dc->rfh = NULL;
   }
+  if (NULL != dc->journal)
+    GNUNET_FS_download_sync_ (dc); /* write what changed since the last sync */
   GNUNET_FS_free_download_request_ (dc->top_request);
   if (NULL != dc->active)
   {
@@ -2303,6 +2327,11 @@ GNUNET_FS_download_stop (struct GNUNET_FS_DownloadContext *dc, int do_delete)
   GNUNET_FS_download_make_status_ (&pi, dc);
   GNUNET_FS_free_download_request_ (dc->top_request);
   dc->top_request = NULL;
+  if (NULL != dc->journal)
+  {
+    (void) GNUNET_BIO_write_close (dc->journal, NULL);
+    dc->journal = NULL;
+  }
   if (NULL != dc->active)
   {
     GNUNET_CONTAINER_multihashmap_destroy (dc->active);
@@ -228,7 +228,7 @@ probe_failure_handler (void *cls)
   GNUNET_FS_download_stop (sr->probe_ctx, GNUNET_YES);
   sr->probe_ctx = NULL;
   GNUNET_FS_stop_probe_ping_task_ (sr);
-  GNUNET_FS_search_result_sync_ (sr);
+  GNUNET_FS_search_result_sync_availability_ (sr);
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Probe #%u for search result %p failed\n",
               sr->availability_trials,
@@ -253,7 +253,7 @@ probe_success_handler (void *cls)
   GNUNET_FS_download_stop (sr->probe_ctx, GNUNET_YES);
   sr->probe_ctx = NULL;
   GNUNET_FS_stop_probe_ping_task_ (sr);
-  GNUNET_FS_search_result_sync_ (sr);
+  GNUNET_FS_search_result_sync_availability_ (sr);
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Probe #%u for search result %p succeeded\n",
               sr->availability_trials,
@@ -348,7 +348,7 @@ GNUNET_FS_search_probe_progress_ (void *cls,
     if (0 == sr->remaining_probe_time.rel_value_us)
       sr->probe_cancel_task =
         GNUNET_SCHEDULER_add_now (&probe_failure_handler, sr);
-    GNUNET_FS_search_result_sync_ (sr);
+    GNUNET_FS_search_result_sync_availability_ (sr);
     break;
 
   default:
@@ -736,6 +736,27 @@ process_sks_result (struct GNUNET_FS_SearchContext *sc,
 }
 
 
+/**
+ * Obtain the public key of the 'anonymous' pseudonym.  Deriving it
+ * takes a scalar multiplication, so we only do that once.
+ *
+ * @return the public key of the anonymous pseudonym
+ */
+static const struct GNUNET_CRYPTO_EcdsaPublicKey *
+get_anonymous_public_key (void)
+{
+  static struct GNUNET_CRYPTO_EcdsaPublicKey anon_pub;
+  static int once;
+
+  if (once)
+    return &anon_pub;
+  GNUNET_CRYPTO_ecdsa_key_get_public (GNUNET_CRYPTO_ecdsa_key_get_anonymous (),
+                                      &anon_pub);
+  once = 1;
+  return &anon_pub;
+}
+
+
 /**
  * Decrypt a ublock using a 'keyword' as the passphrase.  Given the
  * KSK public key derived from the keyword, this function looks up
@@ -757,8 +778,6 @@ decrypt_block_with_keyword (const struct GNUNET_FS_SearchContext *sc,
                             size_t edata_size,
                             char *data)
 {
-  const struct GNUNET_CRYPTO_EcdsaPrivateKey *anon;
-  struct GNUNET_CRYPTO_EcdsaPublicKey anon_pub;
   unsigned int i;
 
   /* find key */
@@ -774,10 +793,8 @@ decrypt_block_with_keyword (const struct GNUNET_FS_SearchContext *sc,
     return GNUNET_SYSERR;
   }
   /* decrypt */
-  anon = GNUNET_CRYPTO_ecdsa_key_get_anonymous ();
-  GNUNET_CRYPTO_ecdsa_key_get_public (anon, &anon_pub);
   GNUNET_FS_ublock_decrypt_ (edata, edata_size,
-                             &anon_pub,
+                             get_anonymous_public_key (),
                              sc->requests[i].keyword,
                              data);
   return i;
@@ -1014,24 +1031,19 @@ schedule_transmit_search_request (struct GNUNET_FS_SearchContext *sc);
 struct MessageBuilderContext
 {
   /**
-   * How many entries can we store to xoff.
-   */
-  unsigned int put_cnt;
-
-  /**
-   * How many entries should we skip.
+   * Where to store the keys.
    */
-  unsigned int skip_cnt;
+  struct GNUNET_HashCode *keys;
 
   /**
-   * Where to store the keys.
+   * How many keys did we store in @e keys.
    */
-  struct GNUNET_HashCode *xoff;
+  unsigned int keys_cnt;
 
   /**
-   * Search context we are iterating for.
+   * How many keys fit into @e keys.
    */
-  struct GNUNET_FS_SearchContext *sc;
+  unsigned int keys_size;
 
   /**
    * Keyword offset the search result must match (0 for SKS)
@@ -1042,7 +1054,7 @@ struct MessageBuilderContext
 
 /**
  * Iterating over the known results, pick those matching the given
- * result range and store their keys at 'xoff'.
+ * keyword and store their keys in the builder context.
  *
  * @param cls the `struct MessageBuilderContext`
  * @param key key for a result
@@ -1063,179 +1075,128 @@ build_result_set (void *cls,
                                                                 keyword_offset
                                                                 % 8)))))
     return GNUNET_OK; /* have no match for this keyword yet */
-  if (mbc->skip_cnt > 0)
-  {
-    mbc->skip_cnt--;
-    return GNUNET_OK;
-  }
-  if (0 == mbc->put_cnt)
-    return GNUNET_SYSERR;
-  mbc->xoff[--mbc->put_cnt] = *key;
-
-  return GNUNET_OK;
-}
-
-
-/**
- * Iterating over the known results, count those matching the given
- * result range and increment put count for each.
- *
- * @param cls the `struct MessageBuilderContext`
- * @param key key for a result
- * @param value the search result
- * @return #GNUNET_OK to continue iterating
- */
-static int
-find_result_set (void *cls,
-                 const struct GNUNET_HashCode *key,
-                 void *value)
-{
-  struct MessageBuilderContext *mbc = cls;
-  struct GNUNET_FS_SearchResult *sr = value;
-
-  if ((NULL != sr->keyword_bitmap) &&
-      (0 == (sr->keyword_bitmap[mbc->keyword_offset / 8] & (1
-                                                            << (mbc->
-                                                                keyword_offset
-                                                                % 8)))))
-    return GNUNET_OK; /* have no match for this keyword yet */
-  mbc->put_cnt++;
+  GNUNET_assert (mbc->keys_cnt < mbc->keys_size);
+  mbc->keys[mbc->keys_cnt++] = *key;
   return GNUNET_OK;
 }
 
 
 /**
- * Schedule the transmission of the (next) search request
- * to the service.
+ * Transmit the search request for @a query to the service, split
+ * over as many messages as needed to carry all known results.
  *
  * @param sc context for the search
+ * @param query the query to search for
+ * @param keys keys of the results we already know
+ * @param keys_cnt number of entries in @a keys
  */
 static void
-schedule_transmit_search_request (struct GNUNET_FS_SearchContext *sc)
+transmit_search_request (struct GNUNET_FS_SearchContext *sc,
+                         const struct GNUNET_HashCode *query,
+                         const struct GNUNET_HashCode *keys,
+                         unsigned int keys_cnt)
 {
-  struct MessageBuilderContext mbc;
   struct GNUNET_MQ_Envelope *env;
   struct SearchMessage *sm;
-  struct GNUNET_CRYPTO_EcdsaPublicKey dpub;
-  unsigned int total_seen_results; /* total number of result hashes to send */
   uint32_t options;
-  unsigned int left;
+  unsigned int off;
   unsigned int todo;
   unsigned int fit;
-  unsigned int search_request_map_offset;
-  unsigned int keyword_offset;
-  int first_call;
 
-  memset (&mbc, 0, sizeof(mbc));
-  mbc.sc = sc;
-  if (GNUNET_FS_uri_test_ksk (sc->uri))
-  {
-    /* This will calculate the result set size ONLY for
-       "keyword_offset == 0", so we will have to recalculate
-       it for the other keywords later! */
-    GNUNET_CONTAINER_multihashmap_iterate (sc->master_result_map,
-                                           &find_result_set,
-                                           &mbc);
-    total_seen_results = mbc.put_cnt;
-  }
-  else
+  options = SEARCH_MESSAGE_OPTION_NONE;
+  if (0 != (sc->options & GNUNET_FS_SEARCH_OPTION_LOOPBACK_ONLY))
+    options |= SEARCH_MESSAGE_OPTION_LOOPBACK_ONLY;
+  fit = (GNUNET_MAX_MESSAGE_SIZE - 1 - sizeof(*sm)) / sizeof(struct
+                                                             GNUNET_HashCode);
+  off = 0;
+  do
   {
-    total_seen_results
-      = GNUNET_CONTAINER_multihashmap_size (sc->master_result_map);
-  }
-  search_request_map_offset = 0;
-  keyword_offset = 0;
-  first_call = GNUNET_YES;
-  while ((0 != (left =
-                  (total_seen_results - search_request_map_offset))) ||
-         (GNUNET_YES == first_call))
-  {
-    first_call = GNUNET_NO;
-    options = SEARCH_MESSAGE_OPTION_NONE;
-    if (0 != (sc->options & GNUNET_FS_SEARCH_OPTION_LOOPBACK_ONLY))
-      options |= SEARCH_MESSAGE_OPTION_LOOPBACK_ONLY;
-
-    fit = (GNUNET_MAX_MESSAGE_SIZE - 1 - sizeof(*sm)) / sizeof(struct
-                                                               GNUNET_HashCode);
     todo = GNUNET_MIN (fit,
-                       left);
+                       keys_cnt - off);
     env = GNUNET_MQ_msg_extra (sm,
                                sizeof(struct GNUNET_HashCode) * todo,
                                GNUNET_MESSAGE_TYPE_FS_START_SEARCH);
-    mbc.skip_cnt = search_request_map_offset;
-    mbc.xoff = (struct GNUNET_HashCode *) &sm[1];
     sm->type = htonl (GNUNET_BLOCK_TYPE_FS_UBLOCK);
     sm->anonymity_level = htonl (sc->anonymity);
     memset (&sm->target,
             0,
             sizeof(struct GNUNET_PeerIdentity));
-
-    if (GNUNET_FS_uri_test_ksk (sc->uri))
+    sm->query = *query;
+    GNUNET_memcpy (&sm[1],
+                   &keys[off],
+                   sizeof(struct GNUNET_HashCode) * todo);
+    off += todo;
+    if (keys_cnt != off)
     {
-      mbc.keyword_offset = keyword_offset;
-      /* calculate how many results we can send in this message */
-      mbc.put_cnt = todo;
-      /* now build message */
-      sm->query = sc->requests[keyword_offset].uquery;
-      GNUNET_CONTAINER_multihashmap_iterate (sc->master_result_map,
-                                             &build_result_set,
-                                             &mbc);
-      search_request_map_offset += todo;
-      GNUNET_assert (0 == mbc.put_cnt);
-      GNUNET_assert (total_seen_results >= search_request_map_offset);
-      if (total_seen_results != search_request_map_offset)
-      {
-        /* more requesting to be done... */
-        sm->options = htonl (options | SEARCH_MESSAGE_OPTION_CONTINUED);
-      }
-      else
-      {
-        sm->options = htonl (options);
-        keyword_offset++;
-        if (sc->uri->data.ksk.keywordCount != keyword_offset)
-        {
-          /* more keywords => more requesting to be done... */
-          first_call = GNUNET_YES;
-          search_request_map_offset = 0;
-          mbc.put_cnt = 0;
-          mbc.keyword_offset = keyword_offset;
-          GNUNET_CONTAINER_multihashmap_iterate (sc->master_result_map,
-                                                 &find_result_set,
-                                                 &mbc);
-          total_seen_results = mbc.put_cnt;
-        }
-      }
+      /* more requesting to be done... */
+      sm->options = htonl (options | SEARCH_MESSAGE_OPTION_CONTINUED);
     }
     else
     {
-      GNUNET_assert (GNUNET_FS_uri_test_sks (sc->uri));
+      sm->options = htonl (options);
+    }
+    GNUNET_MQ_send (sc->mq,
+                    env);
+  }
+  while (keys_cnt != off);
+}
 
-      GNUNET_CRYPTO_ecdsa_public_key_derive (&sc->uri->data.sks.ns,
-                                             sc->uri->data.sks.identifier,
-                                             "fs-ublock",
-                                             &dpub);
-      GNUNET_CRYPTO_hash (&dpub,
-                          sizeof(dpub),
-                          &sm->query);
-      mbc.put_cnt = todo;
-      mbc.keyword_offset = 0;
+
+/**
+ * Schedule the transmission of the (next) search request
+ * to the service.  We only do this when we (re)connect, and the
+ * service forgets the requests of a client when it disconnects, so
+ * we must always send all results we know; while we stay connected,
+ * the service itself keeps track of the results it passes to us.
+ *
+ * @param sc context for the search
+ */
+static void
+schedule_transmit_search_request (struct GNUNET_FS_SearchContext *sc)
+{
+  struct MessageBuilderContext mbc;
+  struct GNUNET_CRYPTO_EcdsaPublicKey dpub;
+  struct GNUNET_HashCode query;
+
+  memset (&mbc, 0, sizeof(mbc));
+  mbc.keys_size = GNUNET_CONTAINER_multihashmap_size (sc->master_result_map);
+  if (0 != mbc.keys_size)
+    mbc.keys = GNUNET_new_array (mbc.keys_size,
+                                 struct GNUNET_HashCode);
+  if (GNUNET_FS_uri_test_ksk (sc->uri))
+  {
+    for (unsigned int i = 0; i < sc->uri->data.ksk.keywordCount; i++)
+    {
+      mbc.keys_cnt = 0;
+      mbc.keyword_offset = i;
       GNUNET_CONTAINER_multihashmap_iterate (sc->master_result_map,
                                              &build_result_set,
                                              &mbc);
-      GNUNET_assert (total_seen_results >= search_request_map_offset);
-      if (total_seen_results != search_request_map_offset)
-      {
-        /* more requesting to be done... */
-        sm->options = htonl (options | SEARCH_MESSAGE_OPTION_CONTINUED);
-      }
-      else
-      {
-        sm->options = htonl (options);
-      }
+      transmit_search_request (sc,
+                               &sc->requests[i].uquery,
+                               mbc.keys,
+                               mbc.keys_cnt);
     }
-    GNUNET_MQ_send (sc->mq,
-                    env);
   }
+  else
+  {
+    GNUNET_assert (GNUNET_FS_uri_test_sks (sc->uri));
+    GNUNET_CRYPTO_ecdsa_public_key_derive (&sc->uri->data.sks.ns,
+                                           sc->uri->data.sks.identifier,
+                                           "fs-ublock",
+                                           &dpub);
+    GNUNET_CRYPTO_hash (&dpub,
+                        sizeof(dpub),
+                        &query);
+    GNUNET_CONTAINER_multihashmap_iterate (sc->master_result_map,
+                                           &build_result_set,
+                                           &mbc);
+    transmit_search_request (sc,
+                             &query,
+                             mbc.keys,
+                             mbc.keys_cnt);
+  }
+  GNUNET_free (mbc.keys);
 }
 
 
@@ -1403,16 +1364,12 @@ GNUNET_FS_search_start_searching_ (struct GNUNET_FS_SearchContext *sc)
 {
   unsigned int i;
   const char *keyword;
-  const struct GNUNET_CRYPTO_EcdsaPrivateKey *anon;
-  struct GNUNET_CRYPTO_EcdsaPublicKey anon_pub;
   struct SearchRequestEntry *sre;
 
   GNUNET_assert (NULL == sc->mq);
   if (GNUNET_FS_uri_test_ksk (sc->uri))
   {
     GNUNET_assert (0 != sc->uri->data.ksk.keywordCount);
-    anon = GNUNET_CRYPTO_ecdsa_key_get_anonymous ();
-    GNUNET_CRYPTO_ecdsa_key_get_public (anon, &anon_pub);
     sc->requests
       = GNUNET_new_array (sc->uri->data.ksk.keywordCount,
                           struct SearchRequestEntry);
@@ -1422,7 +1379,7 @@ GNUNET_FS_search_start_searching_ (struct GNUNET_FS_SearchContext *sc)
       keyword = &sc->uri->data.ksk.keywords[i][1];
       sre = &sc->requests[i];
       sre->keyword = GNUNET_strdup (keyword);
-      GNUNET_CRYPTO_ecdsa_public_key_derive (&anon_pub,
+      GNUNET_CRYPTO_ecdsa_public_key_derive (get_anonymous_public_key (),
                                              keyword,
                                              "fs-ublock",
                                              &sre->dpub);
@@ -96,6 +96,12 @@ struct GSF_PendingRequest
    */
   struct GNUNET_HashCode *replies_seen;
 
+  /**
+   * Set of the hash codes in @e replies_seen, to skip duplicates
+   * when the client re-transmits its known results.
+   */
+  struct GNUNET_CONTAINER_MultiHashMap *replies_seen_map;
+
   /**
    * Block group for filtering replies we've already seen.
    */
@@ -195,6 +201,11 @@ struct GSF_PendingRequest
    * Length of the 'replies_seen' array.
    */
   unsigned int replies_seen_size;
+
+  /**
+   * Number of replies the block group @e bg was sized for.
+   */
+  unsigned int bg_seen_size;
 };
 
 
@@ -257,13 +268,16 @@ refresh_bloomfilter (enum GNUNET_BLOCK_Type type,
   }
   if (GNUNET_BLOCK_TYPE_FS_UBLOCK != type)
     return; /* no need */
+  /* leave room for more replies, so that we do not have to
+     rebuild the filter whenever the client adds some */
+  pr->bg_seen_size = 2 * pr->replies_seen_count;
   pr->bg =
     GNUNET_BLOCK_group_create (GSF_block_ctx,
                                type,
                                NULL,
                                0,
                                "seen-set-size",
-                               pr->replies_seen_count,
+                               pr->bg_seen_size,
                                NULL);
   if (NULL == pr->bg)
     return;
@@ -274,6 +288,51 @@ refresh_bloomfilter (enum GNUNET_BLOCK_Type type,
 }
 
 
+/**
+ * Add the given replies to the set of replies seen by @a pr,
+ * skipping those we already know.  The new replies are appended
+ * to @e replies_seen.
+ *
+ * @param pr request to update
+ * @param replies_seen hash codes of replies seen
+ * @param replies_seen_count size of the @a replies_seen array
+ * @return number of replies that were new
+ */
+static unsigned int
+add_replies_seen (struct GSF_PendingRequest *pr,
+                  const struct GNUNET_HashCode *replies_seen,
+                  unsigned int replies_seen_count)
+{
+  unsigned int added;
+
+  if (0 == replies_seen_count)
+    return 0;
+  if (NULL == pr->replies_seen_map)
+    pr->replies_seen_map
+      = GNUNET_CONTAINER_multihashmap_create (replies_seen_count,
+                                              GNUNET_NO);
+  if (replies_seen_count + pr->replies_seen_count > pr->replies_seen_size)
+    GNUNET_array_grow (pr->replies_seen,
+                       pr->replies_seen_size,
+                       GNUNET_MAX (replies_seen_count + pr->replies_seen_count,
+                                   2 * pr->replies_seen_size));
+  added = 0;
+  for (unsigned int i = 0; i < replies_seen_count; i++)
+  {
+    if (GNUNET_OK !=
+        GNUNET_CONTAINER_multihashmap_put (
+          pr->replies_seen_map,
+          &replies_seen[i],
+          pr,
+          GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY))
+      continue; /* duplicate */
+    pr->replies_seen[pr->replies_seen_count++] = replies_seen[i];
+    added++;
+  }
+  return added;
+}
+
+
 struct GSF_PendingRequest *
 GSF_pending_request_create_ (enum GSF_PendingRequestOptions options,
                              enum GNUNET_BLOCK_Type type,
@@ -337,15 +396,9 @@ GSF_pending_request_create_ (enum GSF_PendingRequestOptions options,
       GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_SECONDS,
                                      (uint32_t) (-ttl)));
   if (replies_seen_count > 0)
-  {
-    pr->replies_seen_size = replies_seen_count;
-    pr->replies_seen =
-      GNUNET_new_array (pr->replies_seen_size, struct GNUNET_HashCode);
-    GNUNET_memcpy (pr->replies_seen,
-                   replies_seen,
-                   replies_seen_count * sizeof(struct GNUNET_HashCode));
-    pr->replies_seen_count = replies_seen_count;
-  }
+    add_replies_seen (pr,
+                      replies_seen,
+                      replies_seen_count);
   if ((NULL != bf_data) &&
       (GNUNET_BLOCK_TYPE_FS_UBLOCK == pr->public_data.type))
   {
@@ -440,41 +493,38 @@ GSF_pending_request_update_ (struct GSF_PendingRequest *pr,
                              const struct GNUNET_HashCode *replies_seen,
                              unsigned int replies_seen_count)
 {
+  const struct GNUNET_HashCode *added;
+  unsigned int added_count;
+
   if (replies_seen_count + pr->replies_seen_count < pr->replies_seen_count)
     return; /* integer overflow */
-  if (0 != (pr->public_data.options & GSF_PRO_BLOOMFILTER_FULL_REFRESH))
+  added_count = add_replies_seen (pr,
+                                  replies_seen,
+                                  replies_seen_count);
+  if (0 == added_count)
+    return;
+  added = &pr->replies_seen[pr->replies_seen_count - added_count];
+  if ( (NULL == pr->bg) ||
+       ( (0 != (pr->public_data.options & GSF_PRO_BLOOMFILTER_FULL_REFRESH))
+         &&
+         (pr->replies_seen_count > pr->bg_seen_size) ) )
   {
-    /* we're responsible for the BF, full refresh */
-    if (replies_seen_count + pr->replies_seen_count > pr->replies_seen_size)
-      GNUNET_array_grow (pr->replies_seen,
-                         pr->replies_seen_size,
-                         replies_seen_count + pr->replies_seen_count);
-    GNUNET_memcpy (&pr->replies_seen[pr->replies_seen_count],
-                   replies_seen,
-                   sizeof(struct GNUNET_HashCode) * replies_seen_count);
-    pr->replies_seen_count += replies_seen_count;
+    /* either we're responsible for the BF and it became too small,
+     * or we're not the initiator, but the initiator did not give us
+     * any bloom-filter, so we need to create one on-the-fly */
     refresh_bloomfilter (pr->public_data.type, pr);
   }
   else
   {
-    if (NULL == pr->bg)
-    {
-      /* we're not the initiator, but the initiator did not give us
-       * any bloom-filter, so we need to create one on-the-fly */
-      refresh_bloomfilter (pr->public_data.type, pr);
-    }
-    else
-    {
-      GNUNET_break (GNUNET_OK ==
-                    GNUNET_BLOCK_group_set_seen (pr->bg,
-                                                 replies_seen,
-                                                 pr->replies_seen_count));
-    }
+    GNUNET_break (GNUNET_OK ==
+                  GNUNET_BLOCK_group_set_seen (pr->bg,
+                                               added,
+                                               added_count));
   }
   if (NULL != pr->gh)
     GNUNET_DHT_get_filter_known_results (pr->gh,
-                                         replies_seen_count,
-                                         replies_seen);
+                                         added_count,
+                                         added);
 }
 
 
@@ -593,6 +643,8 @@ clean_request (void *cls, const struct GNUNET_HashCode *key, void *value)
   }
   GSF_plan_notify_request_done_ (pr);
   GNUNET_free (pr->replies_seen);
+  if (NULL != pr->replies_seen_map)
+    GNUNET_CONTAINER_multihashmap_destroy (pr->replies_seen_map);
   GNUNET_BLOCK_group_destroy (pr->bg);
   pr->bg = NULL;
   GNUNET_PEER_change_rc (pr->sender_pid, -1);
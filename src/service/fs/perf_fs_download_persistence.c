@@ -0,0 +1,375 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file fs/perf_fs_download_persistence.c
+ * @brief measure the cost of keeping a large persistent download in
+ *        sync with its file, as blocks arrive and the download syncs
+ *        after each of them; compares appending to the journal with
+ *        writing the file in full every time, as we used to, and checks
+ *        that the download resumes with the journaled state
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "gnunet_fs_service.h"
+#include "fs_api.h"
+#include "fs_tree.h"
+
+/**
+ * Size of the file we download.
+ */
+#define FILE_SIZE (128 * 1024 * 1024)
+
+/**
+ * Number of DBLOCKs we receive before we stop the download.
+ */
+#define NUM_BLOCKS (FILE_SIZE / DBLOCK_SIZE * 3 / 4)
+
+
+static const struct GNUNET_CONFIGURATION_Handle *cfg;
+
+static struct GNUNET_FS_Handle *fs;
+
+static struct GNUNET_FS_DownloadContext *dc;
+
+/**
+ * Number of DBLOCKs still to be received.
+ */
+static unsigned int blocks_left;
+
+/**
+ * Number of syncs done.
+ */
+static unsigned long long syncs;
+
+/**
+ * Number of bytes written by the syncs.
+ */
+static unsigned long long written;
+
+/**
+ * Do we force every sync to write the file in full?
+ */
+static bool full;
+
+/**
+ * Number of blocks in each state after the journaled download.
+ */
+static unsigned int states[BRS_ERROR + 1];
+
+/**
+ * Did the download resume as we left it?
+ */
+static bool resumed;
+
+static int global_ret;
+
+
+static void
+report (const char *mode,
+        struct GNUNET_TIME_Absolute start)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %llu syncs writing %llu KiB in %s (%llu/s)\n",
+          mode,
+          syncs,
+          written / 1024,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          syncs * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+/**
+ * Create the request tree for the whole file, as
+ * create_download_request() does.
+ */
+static struct DownloadRequest *
+build_request (struct DownloadRequest *parent,
+               unsigned int chk_idx,
+               unsigned int depth,
+               uint64_t offset)
+{
+  struct DownloadRequest *dr;
+  uint64_t child_block_size;
+
+  dr = GNUNET_new (struct DownloadRequest);
+  dr->parent = parent;
+  dr->depth = depth;
+  dr->offset = offset;
+  dr->chk_idx = chk_idx;
+  if (0 == depth)
+    return dr;
+  child_block_size = GNUNET_FS_tree_compute_tree_size (depth - 1);
+  dr->num_children = (FILE_SIZE - offset + child_block_size - 1)
+                     / child_block_size;
+  if (dr->num_children > CHK_PER_INODE)
+    dr->num_children = CHK_PER_INODE;
+  dr->children = GNUNET_new_array (dr->num_children,
+                                   struct DownloadRequest *);
+  for (unsigned int i = 0; i < dr->num_children; i++)
+    dr->children[i] = build_request (dr,
+                                     i,
+                                     depth - 1,
+                                     offset + i * child_block_size);
+  return dr;
+}
+
+
+static void
+set_state (struct DownloadRequest *dr,
+           enum BlockRequestState state)
+{
+  dr->state = state;
+  GNUNET_FS_download_journal_request_ (dc,
+                                       dr);
+}
+
+
+static void
+sync_download (void)
+{
+  uint64_t journal_size = dc->journal_size;
+
+  if (full)
+    dc->journal_stale = true;
+  GNUNET_FS_download_sync_ (dc);
+  GNUNET_assert (NULL != dc->serialization);
+  if (dc->journal_size > journal_size)
+    written += dc->journal_size - journal_size;
+  else
+    written += dc->snapshot_size;
+  syncs++;
+}
+
+
+/**
+ * Receive the block of @a dr and everything below it, syncing
+ * after each block, until we have received #NUM_BLOCKS DBLOCKs.
+ */
+static void
+receive (struct DownloadRequest *dr)
+{
+  if (0 == blocks_left)
+    return;
+  if (0 == dr->depth)
+  {
+    set_state (dr,
+               BRS_DOWNLOAD_UP);
+    dc->completed += DBLOCK_SIZE;
+    blocks_left--;
+    for (struct DownloadRequest *pos = dr->parent;
+         NULL != pos;
+         pos = pos->parent)
+    {
+      for (unsigned int i = 0; i < pos->num_children; i++)
+        if (BRS_DOWNLOAD_UP != pos->children[i]->state)
+          goto done;
+      set_state (pos,
+                 BRS_DOWNLOAD_UP);
+    }
+done:
+    sync_download ();
+    return;
+  }
+  set_state (dr,
+             BRS_DOWNLOAD_DOWN);
+  for (unsigned int i = 0; i < dr->num_children; i++)
+  {
+    GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_WEAK,
+                                &dr->children[i]->chk,
+                                sizeof (struct ContentHashKey));
+    set_state (dr->children[i],
+               BRS_CHK_SET);
+  }
+  sync_download ();
+  for (unsigned int i = 0; i < dr->num_children; i++)
+    receive (dr->children[i]);
+}
+
+
+static void
+count_states (const struct DownloadRequest *dr,
+              unsigned int *counts)
+{
+  counts[dr->state]++;
+  for (unsigned int i = 0; i < dr->num_children; i++)
+    count_states (dr->children[i],
+                  counts);
+}
+
+
+static void
+perf_download (const char *mode)
+{
+  struct GNUNET_TIME_Absolute start;
+  struct GNUNET_FS_Uri *uri;
+
+  uri = GNUNET_new (struct GNUNET_FS_Uri);
+  uri->type = GNUNET_FS_URI_CHK;
+  uri->data.chk.file_length = GNUNET_htonll (FILE_SIZE);
+  GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_WEAK,
+                              &uri->data.chk.chk,
+                              sizeof (struct ContentHashKey));
+  dc = GNUNET_new (struct GNUNET_FS_DownloadContext);
+  dc->h = fs;
+  dc->uri = uri;
+  dc->meta = GNUNET_FS_meta_data_create ();
+  dc->filename = GNUNET_strdup ("perf_fs_download_persistence.out");
+  dc->length = FILE_SIZE;
+  dc->anonymity = 1;
+  dc->start_time = GNUNET_TIME_absolute_get ();
+  dc->treedepth = GNUNET_FS_compute_depth (FILE_SIZE);
+  dc->top_request = build_request (NULL,
+                                   0,
+                                   dc->treedepth - 1,
+                                   0);
+  dc->top_request->chk = uri->data.chk.chk;
+  dc->top_request->state = BRS_CHK_SET;
+  blocks_left = NUM_BLOCKS;
+  syncs = 0;
+  written = 0;
+  start = GNUNET_TIME_absolute_get ();
+  receive (dc->top_request);
+  report (mode,
+          start);
+  GNUNET_assert (NULL == dc->journal);
+  if (full)
+  {
+    GNUNET_FS_remove_sync_file_ (fs,
+                                 GNUNET_FS_SYNC_PATH_MASTER_DOWNLOAD,
+                                 dc->serialization);
+  }
+  else
+  {
+    memset (states,
+            0,
+            sizeof (states));
+    count_states (dc->top_request,
+                  states);
+  }
+  GNUNET_FS_free_download_request_ (dc->top_request);
+  GNUNET_FS_meta_data_destroy (dc->meta);
+  GNUNET_FS_uri_destroy (dc->uri);
+  GNUNET_free (dc->filename);
+  GNUNET_free (dc->serialization);
+  GNUNET_free (dc);
+  dc = NULL;
+}
+
+
+static void *
+progress_cb (void *cls,
+             const struct GNUNET_FS_ProgressInfo *info)
+{
+  unsigned int counts[BRS_ERROR + 1];
+
+  switch (info->status)
+  {
+  case GNUNET_FS_STATUS_DOWNLOAD_RESUME:
+    memset (counts,
+            0,
+            sizeof (counts));
+    count_states (info->value.download.dc->top_request,
+                  counts);
+    if ( (info->value.download.completed ==
+          (uint64_t) NUM_BLOCKS * DBLOCK_SIZE) &&
+         (0 == memcmp (counts,
+                       states,
+                       sizeof (counts))) )
+      resumed = true;
+    break;
+
+  case GNUNET_FS_STATUS_DOWNLOAD_SUSPEND:
+    break;
+
+  default:
+    GNUNET_break (0);
+    break;
+  }
+  return NULL;
+}
+
+
+static void
+run (void *cls)
+{
+  (void) cls;
+  fs = GNUNET_FS_start (cfg,
+                        "perf-fs-download-persistence",
+                        &progress_cb,
+                        NULL,
+                        GNUNET_FS_FLAGS_PERSISTENCE,
+                        GNUNET_FS_OPTIONS_END);
+  GNUNET_assert (NULL != fs);
+  full = true;
+  perf_download ("full rewrite");
+  full = false;
+  perf_download ("journal");
+  GNUNET_FS_stop (fs);
+
+  /* the download must resume with what we journaled */
+  fs = GNUNET_FS_start (cfg,
+                        "perf-fs-download-persistence",
+                        &progress_cb,
+                        NULL,
+                        GNUNET_FS_FLAGS_PERSISTENCE,
+                        GNUNET_FS_OPTIONS_END);
+  GNUNET_assert (NULL != fs);
+  GNUNET_FS_stop (fs);
+  if (! resumed)
+  {
+    fprintf (stderr,
+             "Download did not resume with the journaled state\n");
+    global_ret = 1;
+  }
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  struct GNUNET_CONFIGURATION_Handle *c;
+  char *state_dir;
+
+  GNUNET_log_setup ("perf-fs-download-persistence",
+                    "WARNING",
+                    NULL);
+  state_dir = GNUNET_DISK_mkdtemp ("perf-fs-download-persistence");
+  GNUNET_assert (NULL != state_dir);
+  c = GNUNET_CONFIGURATION_create ();
+  GNUNET_CONFIGURATION_set_value_string (c,
+                                         "fs",
+                                         "STATE_DIR",
+                                         state_dir);
+  cfg = c;
+  GNUNET_SCHEDULER_run (&run,
+                        NULL);
+  GNUNET_CONFIGURATION_destroy (c);
+  GNUNET_DISK_directory_remove (state_dir);
+  GNUNET_free (state_dir);
+  return global_ret;
+}
+
+
+/* end of perf_fs_download_persistence.c */
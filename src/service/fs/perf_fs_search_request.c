@@ -0,0 +1,242 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file fs/perf_fs_search_request.c
+ * @brief measure how long a search with #NUM_RESULTS known results
+ *        takes to (re)transmit its requests to the FS service, for a
+ *        keyword search and a namespace search; we run the search
+ *        code in this process and count the messages it would send
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+
+/* we only count what would go to the service */
+#define GNUNET_MQ_send perf_mq_send
+
+static void
+perf_mq_send (struct GNUNET_MQ_Handle *mq,
+              struct GNUNET_MQ_Envelope *env);
+
+#include "fs_search.c"
+
+/**
+ * Number of results the search already knows.
+ */
+#define NUM_RESULTS (100 * 1000)
+
+/**
+ * Number of keywords of the keyword search.
+ */
+#define NUM_KEYWORDS 3
+
+/**
+ * How many times do we transmit the requests, as on reconnects?
+ */
+#define ROUNDS 10
+
+
+static unsigned long long sent_messages;
+
+static unsigned long long sent_keys;
+
+
+static void
+perf_mq_send (struct GNUNET_MQ_Handle *mq,
+              struct GNUNET_MQ_Envelope *env)
+{
+  const struct SearchMessage *sm
+    = (const struct SearchMessage *) GNUNET_MQ_env_get_msg (env);
+
+  GNUNET_assert (GNUNET_MESSAGE_TYPE_FS_START_SEARCH ==
+                 ntohs (sm->header.type));
+  sent_messages++;
+  sent_keys += (ntohs (sm->header.size) - sizeof (*sm))
+               / sizeof (struct GNUNET_HashCode);
+  GNUNET_MQ_discard (env);
+}
+
+
+/**
+ * Create a search for @a uri that knows #NUM_RESULTS results.
+ * Result i matches keyword k if bit k of i is set or k is 0.
+ *
+ * @param uri what we search for, takes ownership
+ * @return the search
+ */
+static struct GNUNET_FS_SearchContext *
+make_search (struct GNUNET_FS_Uri *uri)
+{
+  struct GNUNET_FS_SearchContext *sc;
+  bool ksk = GNUNET_FS_uri_test_ksk (uri);
+
+  sc = GNUNET_new (struct GNUNET_FS_SearchContext);
+  sc->uri = uri;
+  sc->anonymity = 1;
+  sc->master_result_map
+    = GNUNET_CONTAINER_multihashmap_create (NUM_RESULTS,
+                                            GNUNET_NO);
+  if (ksk)
+  {
+    sc->requests = GNUNET_new_array (uri->data.ksk.keywordCount,
+                                     struct SearchRequestEntry);
+    for (unsigned int k = 0; k < uri->data.ksk.keywordCount; k++)
+      GNUNET_CRYPTO_hash_create_random (GNUNET_CRYPTO_QUALITY_WEAK,
+                                        &sc->requests[k].uquery);
+  }
+  for (unsigned int i = 0; i < NUM_RESULTS; i++)
+  {
+    struct GNUNET_FS_SearchResult *sr;
+
+    sr = GNUNET_new (struct GNUNET_FS_SearchResult);
+    sr->sc = sc;
+    GNUNET_CRYPTO_hash_create_random (GNUNET_CRYPTO_QUALITY_WEAK,
+                                      &sr->key);
+    if (ksk)
+    {
+      sr->keyword_bitmap
+        = GNUNET_malloc ((uri->data.ksk.keywordCount + 7) / 8);
+      for (unsigned int k = 0; k < uri->data.ksk.keywordCount; k++)
+        if ( (0 == k) ||
+             (0 != (i & (1U << k))) )
+          sr->keyword_bitmap[k / 8] |= (1 << (k % 8));
+    }
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multihashmap_put (
+                     sc->master_result_map,
+                     &sr->key,
+                     sr,
+                     GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST));
+  }
+  return sc;
+}
+
+
+static int
+free_result (void *cls,
+             const struct GNUNET_HashCode *key,
+             void *value)
+{
+  struct GNUNET_FS_SearchResult *sr = value;
+
+  GNUNET_free (sr->keyword_bitmap);
+  GNUNET_free (sr);
+  return GNUNET_OK;
+}
+
+
+static void
+free_search (struct GNUNET_FS_SearchContext *sc)
+{
+  GNUNET_CONTAINER_multihashmap_iterate (sc->master_result_map,
+                                         &free_result,
+                                         NULL);
+  GNUNET_CONTAINER_multihashmap_destroy (sc->master_result_map);
+  GNUNET_free (sc->requests);
+  GNUNET_FS_uri_destroy (sc->uri);
+  GNUNET_free (sc);
+}
+
+
+/**
+ * Transmit the requests of @a sc #ROUNDS times.
+ *
+ * @param mode what we measure
+ * @param sc the search
+ * @param keys number of known results each round must carry
+ * @return 0 if every round carried @a keys results
+ */
+static int
+perf_transmit (const char *mode,
+               struct GNUNET_FS_SearchContext *sc,
+               unsigned long long keys)
+{
+  struct GNUNET_TIME_Absolute start;
+  struct GNUNET_TIME_Relative dur;
+
+  sent_messages = 0;
+  sent_keys = 0;
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < ROUNDS; i++)
+    schedule_transmit_search_request (sc);
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %u results, %llu messages per transmission, %s each\n",
+          mode,
+          NUM_RESULTS,
+          sent_messages / ROUNDS,
+          GNUNET_STRINGS_relative_time_to_string (
+            GNUNET_TIME_relative_divide (dur,
+                                         ROUNDS),
+            GNUNET_YES));
+  if (ROUNDS * keys != sent_keys)
+  {
+    fprintf (stderr,
+             "sent %llu known results, wanted %llu\n",
+             sent_keys / ROUNDS,
+             keys);
+    return 1;
+  }
+  return 0;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  struct GNUNET_FS_SearchContext *sc;
+  struct GNUNET_CRYPTO_EcdsaPrivateKey ns_priv;
+  struct GNUNET_CRYPTO_EcdsaPublicKey ns;
+  unsigned long long keys;
+  char *emsg = NULL;
+  int ret = 0;
+
+  GNUNET_log_setup ("perf-fs-search-request",
+                    "WARNING",
+                    NULL);
+  sc = make_search (GNUNET_FS_uri_ksk_create ("alpha beta gamma",
+                                              &emsg));
+  GNUNET_assert (NULL == emsg);
+  GNUNET_assert (NUM_KEYWORDS == sc->uri->data.ksk.keywordCount);
+  /* keyword 0 matches all results, every other keyword half of them */
+  keys = NUM_RESULTS;
+  for (unsigned int k = 1; k < NUM_KEYWORDS; k++)
+    for (unsigned int i = 0; i < NUM_RESULTS; i++)
+      if (0 != (i & (1U << k)))
+        keys++;
+  ret |= perf_transmit ("keyword search",
+                        sc,
+                        keys);
+  free_search (sc);
+
+  GNUNET_CRYPTO_ecdsa_key_create (&ns_priv);
+  GNUNET_CRYPTO_ecdsa_key_get_public (&ns_priv,
+                                      &ns);
+  sc = make_search (GNUNET_FS_uri_sks_create (&ns,
+                                              "root"));
+  ret |= perf_transmit ("namespace search",
+                        sc,
+                        NUM_RESULTS);
+  free_search (sc);
+  return ret;
+}
+
+
+/* end of perf_fs_search_request.c */
@@ -39,6 +39,13 @@
 #include "identity.h"
 
 
+/**
+ * How long do we wait before writing changes to the subsystem
+ * configuration to disk, so that many of them are written at once?
+ */
+#define SUBSYSTEM_CFG_WRITE_DELAY GNUNET_TIME_UNIT_SECONDS
+
+
 /**
  * Information we keep about each ego.
  */
@@ -107,6 +114,200 @@ static struct Ego *ego_head;
  */
 static struct Ego *ego_tail;
 
+/**
+ * Map from the hash of the identifier of an ego to the `struct Ego`.
+ * Identifiers are hashed with ASCII letters in lower case, so that
+ * lookups can ignore the case as they always did; egos created before
+ * identifiers were lower-cased may share a key.
+ */
+static struct GNUNET_CONTAINER_MultiHashMap *ego_map;
+
+/**
+ * Task writing #subsystem_cfg to #subsystem_cfg_file, NULL if
+ * there are no unsaved changes.
+ */
+static struct GNUNET_SCHEDULER_Task *subsystem_cfg_write_task;
+
+
+/**
+ * Compute the key of the identifier @a name in #ego_map.
+ *
+ * @param name identifier of an ego
+ * @param[out] key set to the key
+ */
+static void
+get_ego_key (const char *name,
+             struct GNUNET_HashCode *key)
+{
+  char *lname;
+  size_t len;
+
+  len = strlen (name);
+  lname = GNUNET_malloc (len + 1);
+  for (size_t i = 0; i < len; i++)
+    lname[i] = tolower ((unsigned char) name[i]);
+  GNUNET_CRYPTO_hash (lname,
+                      len,
+                      key);
+  GNUNET_free (lname);
+}
+
+
+/**
+ * Add @a ego to #ego_map under its current identifier.
+ *
+ * @param ego ego to index
+ */
+static void
+index_ego (struct Ego *ego)
+{
+  struct GNUNET_HashCode key;
+
+  get_ego_key (ego->identifier,
+               &key);
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONTAINER_multihashmap_put (
+                   ego_map,
+                   &key,
+                   ego,
+                   GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
+}
+
+
+/**
+ * Remove @a ego from #ego_map.
+ *
+ * @param ego ego to remove
+ */
+static void
+unindex_ego (struct Ego *ego)
+{
+  struct GNUNET_HashCode key;
+
+  get_ego_key (ego->identifier,
+               &key);
+  GNUNET_assert (GNUNET_YES ==
+                 GNUNET_CONTAINER_multihashmap_remove (ego_map,
+                                                       &key,
+                                                       ego));
+}
+
+
+/**
+ * Closure for #check_ego_name().
+ */
+struct FindEgoContext
+{
+  /**
+   * Identifier to look for.
+   */
+  const char *name;
+
+  /**
+   * Set to the ego we found, NULL for none.
+   */
+  struct Ego *ego;
+
+  /**
+   * Do we accept an identifier that differs in case?
+   */
+  bool ignore_case;
+};
+
+
+/**
+ * Check if @a value is the ego we are looking for.
+ *
+ * @param cls a `struct FindEgoContext`
+ * @param key key of the ego in #ego_map
+ * @param value a `struct Ego`
+ * @return #GNUNET_NO once we found the exact identifier
+ */
+static enum GNUNET_GenericReturnValue
+check_ego_name (void *cls,
+                const struct GNUNET_HashCode *key,
+                void *value)
+{
+  struct FindEgoContext *fc = cls;
+  struct Ego *ego = value;
+
+  (void) key;
+  if (0 == strcmp (ego->identifier,
+                   fc->name))
+  {
+    fc->ego = ego;
+    return GNUNET_NO;
+  }
+  if ( (fc->ignore_case) &&
+       (NULL == fc->ego) &&
+       (0 == strcasecmp (ego->identifier,
+                         fc->name)) )
+    fc->ego = ego;
+  return GNUNET_YES;
+}
+
+
+/**
+ * Find the ego with the given identifier.
+ *
+ * @param name identifier to look for
+ * @param ignore_case true to accept an identifier that differs in
+ *        the case of ASCII letters, if there is no exact match
+ * @return NULL if there is no such ego
+ */
+static struct Ego *
+find_ego (const char *name,
+          bool ignore_case)
+{
+  struct FindEgoContext fc = {
+    .name = name,
+    .ignore_case = ignore_case
+  };
+  struct GNUNET_HashCode key;
+
+  get_ego_key (name,
+               &key);
+  GNUNET_CONTAINER_multihashmap_get_multiple (ego_map,
+                                              &key,
+                                              &check_ego_name,
+                                              &fc);
+  return fc.ego;
+}
+
+
+/**
+ * Write #subsystem_cfg to disk.
+ *
+ * @param cls NULL
+ */
+static void
+write_subsystem_cfg (void *cls)
+{
+  (void) cls;
+  subsystem_cfg_write_task = NULL;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_write (subsystem_cfg, subsystem_cfg_file))
+    GNUNET_log (
+      GNUNET_ERROR_TYPE_ERROR,
+      _ ("Failed to write subsystem default identifier map to `%s'.\n"),
+      subsystem_cfg_file);
+}
+
+
+/**
+ * #subsystem_cfg changed, write it to disk soon.
+ */
+static void
+schedule_subsystem_cfg_write (void)
+{
+  if (NULL != subsystem_cfg_write_task)
+    return;
+  subsystem_cfg_write_task
+    = GNUNET_SCHEDULER_add_delayed (SUBSYSTEM_CFG_WRITE_DELAY,
+                                    &write_subsystem_cfg,
+                                    NULL);
+}
+
 
 /**
  * Get the name of the file we use to store a given ego.
@@ -173,6 +374,11 @@ shutdown_task (void *cls)
 {
   struct Ego *e;
 
+  if (NULL != subsystem_cfg_write_task)
+  {
+    GNUNET_SCHEDULER_cancel (subsystem_cfg_write_task);
+    write_subsystem_cfg (NULL);
+  }
   if (NULL != nc)
   {
     GNUNET_notification_context_destroy (nc);
@@ -197,6 +403,11 @@ shutdown_task (void *cls)
     GNUNET_free (e->identifier);
     GNUNET_free (e);
   }
+  if (NULL != ego_map)
+  {
+    GNUNET_CONTAINER_multihashmap_destroy (ego_map);
+    ego_map = NULL;
+  }
 }
 
 
@@ -332,10 +543,10 @@ handle_lookup_message (void *cls,
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Received LOOKUP message from client\n");
   name = (const char *) &message[1];
-  for (ego = ego_head; NULL != ego; ego = ego->next)
+  ego = find_ego (name,
+                  true);
+  if (NULL != ego)
   {
-    if (0 != strcasecmp (name, ego->identifier))
-      continue;
     env = create_update_message (ego);
     GNUNET_MQ_send (GNUNET_SERVICE_client_get_mq (client), env);
     GNUNET_SERVICE_client_continue (client);
@@ -376,26 +587,22 @@ handle_lookup_by_suffix_message (void *cls,
 {
   struct GNUNET_SERVICE_Client *client = cls;
   const char *name;
+  const char *suffix;
   struct GNUNET_MQ_Envelope *env;
   struct Ego *lprefix;
 
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Received LOOKUP_BY_SUFFIX message from client\n");
   name = (const char *) &message[1];
-  lprefix = NULL;
-  for (struct Ego *ego = ego_head; NULL != ego; ego = ego->next)
+  /* try the suffixes starting at label boundaries, longest first */
+  suffix = name;
+  while (NULL == (lprefix = find_ego (suffix,
+                                      false)))
   {
-    if ((strlen (ego->identifier) <= strlen (name)) &&
-        (0 == strcmp (ego->identifier,
-                      &name[strlen (name) - strlen (ego->identifier)])) &&
-        ((strlen (name) == strlen (ego->identifier)) ||
-         ('.' == name[strlen (name) - strlen (ego->identifier) - 1])) &&
-        ((NULL == lprefix) ||
-         (strlen (ego->identifier) > strlen (lprefix->identifier))))
-    {
-      /* found better match, update! */
-      lprefix = ego;
-    }
+    suffix = strchr (suffix, '.');
+    if (NULL == suffix)
+      break;
+    suffix++;
   }
   if (NULL != lprefix)
   {
@@ -509,16 +716,14 @@ handle_create_message (void *cls,
   }
   str = GNUNET_strdup ((const char *) &crm[1] + key_len);
   GNUNET_STRINGS_utf8_tolower ((const char *) &crm[1] + key_len, str);
-  for (ego = ego_head; NULL != ego; ego = ego->next)
+  if (NULL != find_ego (str,
+                       false))
   {
-    if (0 == strcmp (ego->identifier, str))
-    {
-      send_result_code (client,
-                        GNUNET_EC_IDENTITY_NAME_CONFLICT);
-      GNUNET_SERVICE_client_continue (client);
-      GNUNET_free (str);
-      return;
-    }
+    send_result_code (client,
+                      GNUNET_EC_IDENTITY_NAME_CONFLICT);
+    GNUNET_SERVICE_client_continue (client);
+    GNUNET_free (str);
+    return;
   }
   ego = GNUNET_new (struct Ego);
   ego->pk = private_key;
@@ -526,6 +731,7 @@ handle_create_message (void *cls,
   GNUNET_CONTAINER_DLL_insert (ego_head,
                                ego_tail,
                                ego);
+  index_ego (ego);
   send_result_code (client, GNUNET_EC_NONE);
   fn = get_ego_filename (ego);
   if (GNUNET_OK !=
@@ -553,14 +759,19 @@ struct RenameContext
   const char *old_name;
 
   /**
-   * New name.
+   * New name, NULL if the ego was deleted.
    */
   const char *new_name;
+
+  /**
+   * Set to true if the ego was the default of a subsystem.
+   */
+  bool changed;
 };
 
 /**
- * An ego was renamed; rename it in all subsystems where it is
- * currently set as the default.
+ * An ego was renamed or deleted; rename it in (or remove it from)
+ * all subsystems where it is currently set as the default.
  *
  * @param cls the 'struct RenameContext'
  * @param section a section in the configuration to process
@@ -585,6 +796,7 @@ handle_ego_rename (void *cls, const char *section)
                                          section,
                                          "DEFAULT_IDENTIFIER",
                                          rc->new_name);
+  rc->changed = true;
   GNUNET_free (id);
 }
 
@@ -656,49 +868,45 @@ handle_rename_message (void *cls, const struct RenameMessage *rm)
   GNUNET_STRINGS_utf8_tolower (&old_name_tmp[old_name_len], new_name);
 
   /* check if new name is already in use */
-  for (ego = ego_head; NULL != ego; ego = ego->next)
+  if (NULL != find_ego (new_name,
+                       false))
   {
-    if (0 == strcmp (ego->identifier, new_name))
-    {
-      send_result_code (client, GNUNET_EC_IDENTITY_NAME_CONFLICT);
-      GNUNET_SERVICE_client_continue (client);
-      GNUNET_free (old_name);
-      GNUNET_free (new_name);
-      return;
-    }
+    send_result_code (client, GNUNET_EC_IDENTITY_NAME_CONFLICT);
+    GNUNET_SERVICE_client_continue (client);
+    GNUNET_free (old_name);
+    GNUNET_free (new_name);
+    return;
   }
 
   /* locate old name and, if found, perform rename */
-  for (ego = ego_head; NULL != ego; ego = ego->next)
+  ego = find_ego (old_name,
+                  false);
+  if (NULL != ego)
   {
-    if (0 == strcmp (ego->identifier, old_name))
-    {
-      fn_old = get_ego_filename (ego);
-      GNUNET_free (ego->identifier);
-      rename_ctx.old_name = old_name;
-      rename_ctx.new_name = new_name;
-      GNUNET_CONFIGURATION_iterate_sections (subsystem_cfg,
-                                             &handle_ego_rename,
-                                             &rename_ctx);
-      if (GNUNET_OK !=
-          GNUNET_CONFIGURATION_write (subsystem_cfg, subsystem_cfg_file))
-        GNUNET_log (
-          GNUNET_ERROR_TYPE_ERROR,
-          _ ("Failed to write subsystem default identifier map to `%s'.\n"),
-          subsystem_cfg_file);
-      ego->identifier = GNUNET_strdup (new_name);
-      fn_new = get_ego_filename (ego);
-      if (0 != rename (fn_old, fn_new))
-        GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_WARNING, "rename", fn_old);
-      GNUNET_free (fn_old);
-      GNUNET_free (fn_new);
-      GNUNET_free (old_name);
-      GNUNET_free (new_name);
-      notify_listeners (ego);
-      send_result_code (client, GNUNET_EC_NONE);
-      GNUNET_SERVICE_client_continue (client);
-      return;
-    }
+    fn_old = get_ego_filename (ego);
+    unindex_ego (ego);
+    GNUNET_free (ego->identifier);
+    rename_ctx.old_name = old_name;
+    rename_ctx.new_name = new_name;
+    rename_ctx.changed = false;
+    GNUNET_CONFIGURATION_iterate_sections (subsystem_cfg,
+                                           &handle_ego_rename,
+                                           &rename_ctx);
+    if (rename_ctx.changed)
+      schedule_subsystem_cfg_write ();
+    ego->identifier = GNUNET_strdup (new_name);
+    index_ego (ego);
+    fn_new = get_ego_filename (ego);
+    if (0 != rename (fn_old, fn_new))
+      GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_WARNING, "rename", fn_old);
+    GNUNET_free (fn_old);
+    GNUNET_free (fn_new);
+    GNUNET_free (old_name);
+    GNUNET_free (new_name);
+    notify_listeners (ego);
+    send_result_code (client, GNUNET_EC_NONE);
+    GNUNET_SERVICE_client_continue (client);
+    return;
   }
 
   /* failed to locate old name */
@@ -709,37 +917,6 @@ handle_rename_message (void *cls, const struct RenameMessage *rm)
 }
 
 
-/**
- * An ego was removed, remove it from all subsystems where it is
- * currently set as the default.
- *
- * @param cls name of the removed ego (const char *)
- * @param section a section in the configuration to process
- */
-static void
-handle_ego_delete (void *cls, const char *section)
-{
-  const char *identifier = cls;
-  char *id;
-
-  if (GNUNET_OK != GNUNET_CONFIGURATION_get_value_string (subsystem_cfg,
-                                                          section,
-                                                          "DEFAULT_IDENTIFIER",
-                                                          &id))
-    return;
-  if (0 != strcmp (id, identifier))
-  {
-    GNUNET_free (id);
-    return;
-  }
-  GNUNET_CONFIGURATION_set_value_string (subsystem_cfg,
-                                         section,
-                                         "DEFAULT_IDENTIFIER",
-                                         NULL);
-  GNUNET_free (id);
-}
-
-
 /**
  * Checks a #GNUNET_MESSAGE_TYPE_IDENTITY_DELETE message
  *
@@ -785,39 +962,39 @@ handle_delete_message (void *cls, const struct DeleteMessage *dm)
   struct Ego *ego;
   char *name;
   char *fn;
+  struct RenameContext delete_ctx;
   struct GNUNET_SERVICE_Client *client = cls;
 
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Received DELETE message from client\n");
   name = GNUNET_strdup ((const char *) &dm[1]);
   GNUNET_STRINGS_utf8_tolower ((const char *) &dm[1], name);
 
-  for (ego = ego_head; NULL != ego; ego = ego->next)
+  ego = find_ego (name,
+                  false);
+  if (NULL != ego)
   {
-    if (0 == strcmp (ego->identifier, name))
-    {
-      GNUNET_CONTAINER_DLL_remove (ego_head, ego_tail, ego);
-      GNUNET_CONFIGURATION_iterate_sections (subsystem_cfg,
-                                             &handle_ego_delete,
-                                             ego->identifier);
-      if (GNUNET_OK !=
-          GNUNET_CONFIGURATION_write (subsystem_cfg, subsystem_cfg_file))
-        GNUNET_log (
-          GNUNET_ERROR_TYPE_ERROR,
-          _ ("Failed to write subsystem default identifier map to `%s'.\n"),
-          subsystem_cfg_file);
-      fn = get_ego_filename (ego);
-      if (0 != unlink (fn))
-        GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_WARNING, "unlink", fn);
-      GNUNET_free (fn);
-      GNUNET_free (ego->identifier);
-      ego->identifier = NULL;
-      notify_listeners (ego);
-      GNUNET_free (ego);
-      GNUNET_free (name);
-      send_result_code (client, GNUNET_EC_NONE);
-      GNUNET_SERVICE_client_continue (client);
-      return;
-    }
+    GNUNET_CONTAINER_DLL_remove (ego_head, ego_tail, ego);
+    unindex_ego (ego);
+    delete_ctx.old_name = ego->identifier;
+    delete_ctx.new_name = NULL;
+    delete_ctx.changed = false;
+    GNUNET_CONFIGURATION_iterate_sections (subsystem_cfg,
+                                           &handle_ego_rename,
+                                           &delete_ctx);
+    if (delete_ctx.changed)
+      schedule_subsystem_cfg_write ();
+    fn = get_ego_filename (ego);
+    if (0 != unlink (fn))
+      GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_WARNING, "unlink", fn);
+    GNUNET_free (fn);
+    GNUNET_free (ego->identifier);
+    ego->identifier = NULL;
+    notify_listeners (ego);
+    GNUNET_free (ego);
+    GNUNET_free (name);
+    send_result_code (client, GNUNET_EC_NONE);
+    GNUNET_SERVICE_client_continue (client);
+    return;
   }
 
   send_result_code (client, GNUNET_EC_IDENTITY_NOT_FOUND);
@@ -927,6 +1104,7 @@ process_ego_file (void *cls,
               fn + 1);
   ego->identifier = GNUNET_strdup (fn + 1);
   GNUNET_CONTAINER_DLL_insert (ego_head, ego_tail, ego);
+  index_ego (ego);
   return GNUNET_OK;
 }
 
@@ -945,6 +1123,8 @@ run (void *cls,
 {
   cfg = c;
   nc = GNUNET_notification_context_create (1);
+  ego_map = GNUNET_CONTAINER_multihashmap_create (16,
+                                                  GNUNET_NO);
   if (GNUNET_OK != GNUNET_CONFIGURATION_get_value_filename (cfg,
                                                             "identity",
                                                             "EGODIR",
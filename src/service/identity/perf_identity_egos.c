@@ -0,0 +1,461 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file identity/perf_identity_egos.c
+ * @brief measure creating, renaming, looking up and deleting many egos
+ *        with the message handlers of the identity service; the
+ *        handlers run in this process and we take their replies
+ *        directly from the envelopes they send to the client
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+
+/* we are the only client, and we read the replies from here */
+#define GNUNET_SERVICE_client_get_mq perf_client_get_mq
+#define GNUNET_SERVICE_client_continue perf_client_continue
+#define GNUNET_SERVICE_client_drop perf_client_drop
+#define GNUNET_MQ_send perf_mq_send
+
+static struct GNUNET_MQ_Handle *
+perf_client_get_mq (struct GNUNET_SERVICE_Client *client);
+
+static void
+perf_client_continue (struct GNUNET_SERVICE_Client *client);
+
+static void
+perf_client_drop (struct GNUNET_SERVICE_Client *client);
+
+static void
+perf_mq_send (struct GNUNET_MQ_Handle *mq,
+              struct GNUNET_MQ_Envelope *env);
+
+/* we drive the service from here, so we need our own main() */
+#define main gnunet_service_identity_main
+#include "gnunet-service-identity.c"
+#undef main
+
+/**
+ * Number of egos to create.
+ */
+#define NUM_EGOS 10000
+
+/**
+ * Number of lookups by name and by suffix.
+ */
+#define NUM_LOOKUPS 10000
+
+
+/**
+ * Result code of the last #GNUNET_MESSAGE_TYPE_IDENTITY_RESULT_CODE
+ * reply, UINT32_MAX after an update.
+ */
+static uint32_t last_result;
+
+/**
+ * Name in the last #GNUNET_MESSAGE_TYPE_IDENTITY_UPDATE reply.
+ */
+static char last_name[64];
+
+/**
+ * Private key of all our egos.
+ */
+static struct GNUNET_CRYPTO_PrivateKey ego_key;
+
+static int global_ret;
+
+
+static struct GNUNET_MQ_Handle *
+perf_client_get_mq (struct GNUNET_SERVICE_Client *client)
+{
+  return NULL;
+}
+
+
+static void
+perf_client_continue (struct GNUNET_SERVICE_Client *client)
+{
+}
+
+
+static void
+perf_client_drop (struct GNUNET_SERVICE_Client *client)
+{
+  GNUNET_assert (0);
+}
+
+
+static void
+perf_mq_send (struct GNUNET_MQ_Handle *mq,
+              struct GNUNET_MQ_Envelope *env)
+{
+  const struct GNUNET_MessageHeader *msg = GNUNET_MQ_env_get_msg (env);
+
+  switch (ntohs (msg->type))
+  {
+  case GNUNET_MESSAGE_TYPE_IDENTITY_RESULT_CODE:
+    last_result
+      = ntohl (((const struct ResultCodeMessage *) msg)->result_code);
+    break;
+  case GNUNET_MESSAGE_TYPE_IDENTITY_UPDATE:
+    {
+      const struct UpdateMessage *um = (const struct UpdateMessage *) msg;
+
+      last_result = UINT32_MAX;
+      GNUNET_assert (ntohs (um->name_len) <= sizeof (last_name));
+      GNUNET_memcpy (last_name,
+                     &um[1],
+                     ntohs (um->name_len));
+      break;
+    }
+  default:
+    GNUNET_assert (0);
+  }
+  GNUNET_MQ_discard (env);
+}
+
+
+static void
+report (const char *mode,
+        struct GNUNET_TIME_Absolute start,
+        unsigned long long ops)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %llu operations in %s (%llu/s)\n",
+          mode,
+          ops,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          ops * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+static void
+expect (uint32_t result)
+{
+  if (result != last_result)
+  {
+    fprintf (stderr,
+             "got result %u, wanted %u\n",
+             (unsigned int) last_result,
+             (unsigned int) result);
+    global_ret = 1;
+  }
+}
+
+
+static void
+expect_ego (const char *name)
+{
+  expect (UINT32_MAX);
+  if ( (UINT32_MAX == last_result) &&
+       (0 != strcmp (name,
+                     last_name)) )
+  {
+    fprintf (stderr,
+             "got ego `%s', wanted `%s'\n",
+             last_name,
+             name);
+    global_ret = 1;
+  }
+}
+
+
+static void
+create_ego (const char *name)
+{
+  struct CreateRequestMessage *crm;
+  size_t key_len = GNUNET_CRYPTO_private_key_get_length (&ego_key);
+  size_t name_len = strlen (name) + 1;
+  size_t size = sizeof (*crm) + key_len + name_len;
+
+  crm = GNUNET_malloc (size);
+  crm->header.type = htons (GNUNET_MESSAGE_TYPE_IDENTITY_CREATE);
+  crm->header.size = htons (size);
+  crm->name_len = htons (name_len);
+  crm->key_len = htons (key_len);
+  GNUNET_CRYPTO_write_private_key_to_buffer (&ego_key,
+                                             &crm[1],
+                                             key_len);
+  GNUNET_memcpy ((char *) &crm[1] + key_len,
+                 name,
+                 name_len);
+  GNUNET_assert (GNUNET_OK ==
+                 check_create_message (NULL,
+                                       crm));
+  handle_create_message (NULL,
+                         crm);
+  GNUNET_free (crm);
+}
+
+
+static void
+rename_ego (const char *old_name,
+            const char *new_name)
+{
+  struct RenameMessage *rm;
+  size_t old_len = strlen (old_name) + 1;
+  size_t new_len = strlen (new_name) + 1;
+  size_t size = sizeof (*rm) + old_len + new_len;
+
+  rm = GNUNET_malloc (size);
+  rm->header.type = htons (GNUNET_MESSAGE_TYPE_IDENTITY_RENAME);
+  rm->header.size = htons (size);
+  rm->old_name_len = htons (old_len);
+  rm->new_name_len = htons (new_len);
+  GNUNET_memcpy (&rm[1],
+                 old_name,
+                 old_len);
+  GNUNET_memcpy ((char *) &rm[1] + old_len,
+                 new_name,
+                 new_len);
+  GNUNET_assert (GNUNET_OK ==
+                 check_rename_message (NULL,
+                                       rm));
+  handle_rename_message (NULL,
+                         rm);
+  GNUNET_free (rm);
+}
+
+
+static void
+lookup_ego (const char *name,
+            bool by_suffix)
+{
+  struct LookupMessage *lm;
+  size_t name_len = strlen (name) + 1;
+  size_t size = sizeof (*lm) + name_len;
+
+  lm = GNUNET_malloc (size);
+  lm->header.type = htons (by_suffix
+                           ? GNUNET_MESSAGE_TYPE_IDENTITY_LOOKUP_BY_SUFFIX
+                           : GNUNET_MESSAGE_TYPE_IDENTITY_LOOKUP);
+  lm->header.size = htons (size);
+  GNUNET_memcpy (&lm[1],
+                 name,
+                 name_len);
+  if (by_suffix)
+  {
+    GNUNET_assert (GNUNET_OK ==
+                   check_lookup_by_suffix_message (NULL,
+                                                   lm));
+    handle_lookup_by_suffix_message (NULL,
+                                     lm);
+  }
+  else
+  {
+    GNUNET_assert (GNUNET_OK ==
+                   check_lookup_message (NULL,
+                                         lm));
+    handle_lookup_message (NULL,
+                           lm);
+  }
+  GNUNET_free (lm);
+}
+
+
+static void
+delete_ego (const char *name)
+{
+  struct DeleteMessage *dm;
+  size_t name_len = strlen (name) + 1;
+  size_t size = sizeof (*dm) + name_len;
+
+  dm = GNUNET_malloc (size);
+  dm->header.type = htons (GNUNET_MESSAGE_TYPE_IDENTITY_DELETE);
+  dm->header.size = htons (size);
+  dm->name_len = htons (name_len);
+  GNUNET_memcpy (&dm[1],
+                 name,
+                 name_len);
+  GNUNET_assert (GNUNET_OK ==
+                 check_delete_message (NULL,
+                                       dm));
+  handle_delete_message (NULL,
+                         dm);
+  GNUNET_free (dm);
+}
+
+
+/**
+ * Create, rename, look up and delete #NUM_EGOS egos.
+ */
+static void
+perf_egos (void *cls)
+{
+  const char *dir = cls;
+  struct GNUNET_TIME_Absolute start;
+  char name[64];
+  char *fn;
+
+  nc = GNUNET_notification_context_create (1);
+  ego_map = GNUNET_CONTAINER_multihashmap_create (16,
+                                                  GNUNET_NO);
+  ego_directory = GNUNET_strdup (dir);
+  GNUNET_asprintf (&subsystem_cfg_file,
+                   "%s%s%s",
+                   dir,
+                   DIR_SEPARATOR_STR,
+                   "subsystem_defaults.conf");
+  subsystem_cfg = GNUNET_CONFIGURATION_create ();
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_EGOS; i++)
+  {
+    GNUNET_snprintf (name,
+                     sizeof (name),
+                     "ego%u",
+                     i);
+    create_ego (name);
+    expect (GNUNET_EC_NONE);
+  }
+  report ("create",
+          start,
+          NUM_EGOS);
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_EGOS; i++)
+  {
+    char new_name[64];
+
+    GNUNET_snprintf (name,
+                     sizeof (name),
+                     "ego%u",
+                     i);
+    GNUNET_snprintf (new_name,
+                     sizeof (new_name),
+                     "renamed%u",
+                     i);
+    rename_ego (name,
+                new_name);
+    expect (GNUNET_EC_NONE);
+  }
+  report ("rename",
+          start,
+          NUM_EGOS);
+
+  /* lookups ignore the case of the name */
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_LOOKUPS; i++)
+  {
+    unsigned int n = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                               NUM_EGOS);
+
+    GNUNET_snprintf (name,
+                     sizeof (name),
+                     (0 == i % 2) ? "renamed%u" : "Renamed%u",
+                     n);
+    lookup_ego (name,
+                false);
+    name[0] = 'r';
+    expect_ego (name);
+  }
+  report ("lookup",
+          start,
+          NUM_LOOKUPS);
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_LOOKUPS; i++)
+  {
+    unsigned int n = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                               NUM_EGOS);
+
+    GNUNET_snprintf (name,
+                     sizeof (name),
+                     "www.sub.renamed%u",
+                     n);
+    lookup_ego (name,
+                true);
+    expect_ego (&name[strlen ("www.sub.")]);
+  }
+  report ("lookup by suffix",
+          start,
+          NUM_LOOKUPS);
+  lookup_ego ("www.xrenamed1",
+              true);
+  expect (GNUNET_EC_IDENTITY_NOT_FOUND);
+
+  /* egos stored before identifiers were lower-cased are found too */
+  GNUNET_asprintf (&fn,
+                   "%s%s%s",
+                   dir,
+                   DIR_SEPARATOR_STR,
+                   "Legacy-Ego");
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_DISK_fn_write (fn,
+                                       &ego_key,
+                                       sizeof (ego_key),
+                                       GNUNET_DISK_PERM_USER_READ
+                                       | GNUNET_DISK_PERM_USER_WRITE));
+  process_ego_file (NULL,
+                    fn);
+  GNUNET_free (fn);
+  lookup_ego ("legacy-ego",
+              false);
+  expect_ego ("Legacy-Ego");
+  lookup_ego ("Legacy-Ego",
+              false);
+  expect_ego ("Legacy-Ego");
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_EGOS; i++)
+  {
+    GNUNET_snprintf (name,
+                     sizeof (name),
+                     "renamed%u",
+                     i);
+    delete_ego (name);
+    expect (GNUNET_EC_NONE);
+  }
+  report ("delete",
+          start,
+          NUM_EGOS);
+  if (1 != GNUNET_CONTAINER_multihashmap_size (ego_map))
+    global_ret = 1;
+  shutdown_task (NULL);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  char *dir;
+
+  GNUNET_log_setup ("perf-identity-egos",
+                    "WARNING",
+                    NULL);
+  dir = GNUNET_DISK_mkdtemp ("perf-identity-egos");
+  GNUNET_assert (NULL != dir);
+  ego_key.type = htonl (GNUNET_PUBLIC_KEY_TYPE_EDDSA);
+  GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_WEAK,
+                              &ego_key.eddsa_key,
+                              sizeof (ego_key.eddsa_key));
+  GNUNET_SCHEDULER_run (&perf_egos,
+                        dir);
+  GNUNET_DISK_directory_remove (dir);
+  GNUNET_free (dir);
+  return global_ret;
+}
+
+
+/* end of perf_identity_egos.c */
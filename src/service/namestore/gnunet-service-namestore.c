@@ -1292,6 +1292,7 @@ handle_edit_record_set (void *cls, const struct EditRecordSetMessage *er_msg)
   struct RecordLookupContext rlc;
   const char *name_tmp;
   const char *editor_hint;
+  char conv_buf[GNUNET_GNSRECORD_LABEL_BUFFER_SIZE];
   char *conv_name;
   uint16_t name_len;
   uint16_t old_editor_hint_len;
@@ -1320,7 +1321,9 @@ handle_edit_record_set (void *cls, const struct EditRecordSetMessage *er_msg)
               "Received NAMESTORE_RECORD_SET_EDIT message for name `%s'\n",
               name_tmp);
 
-  conv_name = GNUNET_GNSRECORD_string_normalize (name_tmp);
+  conv_name = GNUNET_GNSRECORD_string_normalize_buf (name_tmp,
+                                                     conv_buf,
+                                                     sizeof (conv_buf));
   if (NULL == conv_name)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
@@ -1371,7 +1374,8 @@ handle_edit_record_set (void *cls, const struct EditRecordSetMessage *er_msg)
   GNUNET_MQ_send (nc->mq, env);
   GNUNET_free (rlc.editor_hint);
   GNUNET_free (rlc.res_rd);
-  GNUNET_free (conv_name);
+  if (conv_buf != conv_name)
+    GNUNET_free (conv_name);
 }
 
 
@@ -1426,6 +1430,7 @@ handle_edit_record_set_cancel (void *cls, const struct
   const char *name_tmp;
   const char *editor_hint;
   const char *editor_hint_repl;
+  char conv_buf[GNUNET_GNSRECORD_LABEL_BUFFER_SIZE];
   char *conv_name;
   uint16_t name_len;
   uint16_t editor_hint_len;
@@ -1456,7 +1461,9 @@ handle_edit_record_set_cancel (void *cls, const struct
               "Received NAMESTORE_RECORD_SET_EDIT message for name `%s'\n",
               name_tmp);
 
-  conv_name = GNUNET_GNSRECORD_string_normalize (name_tmp);
+  conv_name = GNUNET_GNSRECORD_string_normalize_buf (name_tmp,
+                                                     conv_buf,
+                                                     sizeof (conv_buf));
   if (NULL == conv_name)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
@@ -1484,7 +1491,8 @@ handle_edit_record_set_cancel (void *cls, const struct
   rer_msg->ec = htons ((GNUNET_OK == res) ? GNUNET_EC_NONE :
                        GNUNET_EC_NAMESTORE_BACKEND_FAILED);
   GNUNET_MQ_send (nc->mq, env);
-  GNUNET_free (conv_name);
+  if (conv_buf != conv_name)
+    GNUNET_free (conv_name);
 }
 
 
@@ -1531,6 +1539,7 @@ handle_record_lookup (void *cls, const struct LabelLookupMessage *ll_msg)
   struct RecordLookupContext rlc;
   const char *name_tmp;
   char *res_name;
+  char conv_buf[GNUNET_GNSRECORD_LABEL_BUFFER_SIZE];
   char *conv_name;
   uint32_t name_len;
   int res;
@@ -1556,7 +1565,9 @@ handle_record_lookup (void *cls, const struct LabelLookupMessage *ll_msg)
               "Received NAMESTORE_RECORD_LOOKUP message for name `%s'\n",
               name_tmp);
 
-  conv_name = GNUNET_GNSRECORD_string_normalize (name_tmp);
+  conv_name = GNUNET_GNSRECORD_string_normalize_buf (name_tmp,
+                                                     conv_buf,
+                                                     sizeof (conv_buf));
   if (NULL == conv_name)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
@@ -1604,7 +1615,8 @@ handle_record_lookup (void *cls, const struct LabelLookupMessage *ll_msg)
   GNUNET_MQ_send (nc->mq, env);
   GNUNET_free (rlc.editor_hint);
   GNUNET_free (rlc.res_rd);
-  GNUNET_free (conv_name);
+  if (conv_buf != conv_name)
+    GNUNET_free (conv_name);
 }
 
 
@@ -1715,6 +1727,7 @@ store_record_set (struct NamestoreClient *nc,
   const char *name_tmp;
   const char *rd_ser;
   char *emsg;
+  char conv_buf[GNUNET_GNSRECORD_LABEL_BUFFER_SIZE];
   char *conv_name;
   unsigned int rd_count;
   int res;
@@ -1738,7 +1751,9 @@ store_record_set (struct NamestoreClient *nc,
     struct GNUNET_GNSRECORD_Data rd[GNUNET_NZL (rd_count)];
 
     /* Extracting and converting private key */
-    conv_name = GNUNET_GNSRECORD_string_normalize (name_tmp);
+    conv_name = GNUNET_GNSRECORD_string_normalize_buf (name_tmp,
+                                                       conv_buf,
+                                                       sizeof (conv_buf));
     if (NULL == conv_name)
     {
       GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
@@ -1754,7 +1769,8 @@ store_record_set (struct NamestoreClient *nc,
                   "Label invalid: `%s'\n",
                   emsg);
       GNUNET_free (emsg);
-      GNUNET_free (conv_name);
+      if (conv_buf != conv_name)
+        GNUNET_free (conv_name);
       return GNUNET_EC_NAMESTORE_LABEL_INVALID;
     }
 
@@ -1762,7 +1778,8 @@ store_record_set (struct NamestoreClient *nc,
         GNUNET_GNSRECORD_records_deserialize (rd_ser_len, rd_ser, rd_count,
                                               rd))
     {
-      GNUNET_free (conv_name);
+      if (conv_buf != conv_name)
+        GNUNET_free (conv_name);
       return GNUNET_EC_NAMESTORE_RECORD_DATA_INVALID;
     }
 
@@ -1831,7 +1848,8 @@ store_record_set (struct NamestoreClient *nc,
                                                  GNUNET_GNSRECORD_FILTER_INCLUDE_MAINTENANCE,
                                                  &emsg))
       {
-        GNUNET_free (conv_name);
+        if (conv_buf != conv_name)
+          GNUNET_free (conv_name);
         GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                     "Error normalizing record set: `%s'\n",
                     emsg);
@@ -1888,9 +1906,12 @@ store_record_set (struct NamestoreClient *nc,
     if (GNUNET_SYSERR == res)
     {
       /* store not successful, no need to tell monitors */
-      GNUNET_free (conv_name);
+      if (conv_buf != conv_name)
+        GNUNET_free (conv_name);
       return GNUNET_EC_NAMESTORE_STORE_FAILED;
     }
+    if (conv_buf != conv_name)
+      GNUNET_free (conv_name);
   }
   return ec;
 }
@@ -53,7 +53,7 @@
 
 /**
  * How often should we ask the OS about a list of active
- * network interfaces?
+ * network interfaces if we are not notified about changes?
  */
 #define SCAN_FREQ GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_SECONDS, 15)
 
@@ -128,6 +128,11 @@ struct LocalAddressList
    */
   int old;
 
+  /**
+   * Number of our interfaces having this address.
+   */
+  unsigned int ifc_count;
+
   /**
    * What type of address is this?
    */
@@ -295,9 +300,9 @@ static const struct GNUNET_CONFIGURATION_Handle *cfg;
 static struct GNUNET_STATISTICS_Handle *stats;
 
 /**
- * Task scheduled to periodically scan our network interfaces.
+ * Monitor of our network interfaces.
  */
-static struct GNUNET_SCHEDULER_Task *scan_task;
+static struct GNUNET_OS_NetworkInterfaceMonitor *ifc_mon;
 
 /**
  * Head of client DLL.
@@ -549,45 +554,15 @@ is_nat_v6 (const struct in6_addr *ip)
 
 
 /**
- * Closure for #ifc_proc.
- */
-struct IfcProcContext
-{
-  /**
-   * Head of DLL of local addresses.
-   */
-  struct LocalAddressList *lal_head;
-
-  /**
-   * Tail of DLL of local addresses.
-   */
-  struct LocalAddressList *lal_tail;
-};
-
-
-/**
- * Callback function invoked for each interface found.  Adds them
- * to our new address list.
+ * Create a new entry for our address list for an address of
+ * one of our interfaces.
  *
- * @param cls a `struct IfcProcContext *`
- * @param name name of the interface (can be NULL for unknown)
- * @param isDefault is this presumably the default interface
- * @param addr address of this interface (can be NULL for unknown or unassigned)
- * @param broadcast_addr the broadcast address (can be NULL for unknown or unassigned)
- * @param netmask the network mask (can be NULL for unknown or unassigned)
- * @param addrlen length of the address
- * @return #GNUNET_OK to continue iteration, #GNUNET_SYSERR to abort
+ * @param addr address of the interface
+ * @return the new entry, NULL if the address is to be ignored
  */
-static int
-ifc_proc (void *cls,
-          const char *name,
-          int isDefault,
-          const struct sockaddr *addr,
-          const struct sockaddr *broadcast_addr,
-          const struct sockaddr *netmask,
-          socklen_t addrlen)
+static struct LocalAddressList *
+make_lal (const struct sockaddr *addr)
 {
-  struct IfcProcContext *ifc_ctx = cls;
   struct LocalAddressList *lal;
   size_t alen;
   const struct in_addr *ip4;
@@ -627,11 +602,11 @@ ifc_proc (void *cls,
 #if AF_UNIX
   case AF_UNIX:
     GNUNET_break (0);
-    return GNUNET_OK;
+    return NULL;
 #endif
   default:
     GNUNET_break (0);
-    return GNUNET_OK;
+    return NULL;
   }
   lal = GNUNET_malloc (sizeof(*lal));
   lal->af = addr->sa_family;
@@ -639,10 +614,7 @@ ifc_proc (void *cls,
   GNUNET_memcpy (&lal->addr,
                  addr,
                  alen);
-  GNUNET_CONTAINER_DLL_insert (ifc_ctx->lal_head,
-                               ifc_ctx->lal_tail,
-                               lal);
-  return GNUNET_OK;
+  return lal;
 }
 
 
@@ -973,109 +945,120 @@ reversal_callback (void *cls,
 
 
 /**
- * Task we run periodically to scan for network interfaces.
+ * Find the entry for @a addr in our address list.
  *
- * @param cls NULL
+ * @param addr address to look for
+ * @return the entry, NULL if we do not have it
  */
-static void
-run_scan (void *cls)
+static struct LocalAddressList *
+find_lal (const struct sockaddr *addr)
 {
-  struct IfcProcContext ifc_ctx;
-  int found;
-  int have_nat;
-  struct LocalAddressList *lnext;
-
-  scan_task = GNUNET_SCHEDULER_add_delayed (SCAN_FREQ,
-                                            &run_scan,
-                                            NULL);
-  memset (&ifc_ctx,
-          0,
-          sizeof(ifc_ctx));
-  GNUNET_OS_network_interfaces_list (&ifc_proc,
-                                     &ifc_ctx);
-  /* remove addresses that disappeared */
   for (struct LocalAddressList *lal = lal_head;
        NULL != lal;
-       lal = lnext)
+       lal = lal->next)
   {
-    lnext = lal->next;
-    found = GNUNET_NO;
-    for (struct LocalAddressList *pos = ifc_ctx.lal_head;
-         NULL != pos;
-         pos = pos->next)
-    {
-      if ((pos->af == lal->af) &&
-          (0 == memcmp (&lal->addr,
-                        &pos->addr,
-                        (AF_INET == lal->af)
-                        ? sizeof(struct sockaddr_in)
-                        : sizeof(struct sockaddr_in6))))
-      {
-        found = GNUNET_YES;
-      }
-    }
-    if (GNUNET_NO == found)
-    {
-      notify_clients (lal,
-                      GNUNET_NO);
-      free_lal (lal);
-    }
+    if ((addr->sa_family == lal->af) &&
+        (0 == memcmp (&lal->addr,
+                      addr,
+                      (AF_INET == lal->af)
+                      ? sizeof(struct sockaddr_in)
+                      : sizeof(struct sockaddr_in6))))
+      return lal;
   }
+  return NULL;
+}
+
+
+/**
+ * Callback function invoked whenever the addresses of our network
+ * interfaces change.  Updates our address list and tells our clients.
+ *
+ * @param cls NULL
+ * @param change what happened
+ * @param name name of the interface (can be NULL for unknown)
+ * @param isDefault is this presumably the default interface
+ * @param addr address of this interface
+ * @param broadcast_addr the broadcast address (can be NULL for unknown or unassigned)
+ * @param netmask the network mask (can be NULL for unknown or unassigned)
+ * @param addrlen length of the address
+ */
+static void
+ifc_change_cb (void *cls,
+               enum GNUNET_OS_NetworkInterfaceChange change,
+               const char *name,
+               int isDefault,
+               const struct sockaddr *addr,
+               const struct sockaddr *broadcast_addr,
+               const struct sockaddr *netmask,
+               socklen_t addrlen)
+{
+  struct LocalAddressList *lal;
 
-  /* add addresses that appeared */
-  have_nat = GNUNET_NO;
-  for (struct LocalAddressList *pos = ifc_ctx.lal_head;
-       NULL != pos;
-       pos = ifc_ctx.lal_head)
+  (void) cls;
+  (void) name;
+  (void) isDefault;
+  (void) broadcast_addr;
+  (void) netmask;
+  (void) addrlen;
+  switch (change)
   {
-    found = GNUNET_NO;
-    if (GNUNET_NAT_AC_LAN == (GNUNET_NAT_AC_LAN & pos->ac))
-      have_nat = GNUNET_YES;
-    for (struct LocalAddressList *lal = lal_head;
-         NULL != lal;
-         lal = lal->next)
+  case GNUNET_OS_NIC_SYNCED:
     {
-      if ((pos->af == lal->af) &&
-          (0 == memcmp (&lal->addr,
-                        &pos->addr,
-                        (AF_INET == lal->af)
-                        ? sizeof(struct sockaddr_in)
-                        : sizeof(struct sockaddr_in6))))
-        found = GNUNET_YES;
+      int have_nat = GNUNET_NO;
+
+      for (lal = lal_head; NULL != lal; lal = lal->next)
+        if (GNUNET_NAT_AC_LAN == (GNUNET_NAT_AC_LAN & lal->ac))
+          have_nat = GNUNET_YES;
+      GN_nat_status_changed (have_nat);
+      return;
     }
-    GNUNET_CONTAINER_DLL_remove (ifc_ctx.lal_head,
-                                 ifc_ctx.lal_tail,
-                                 pos);
-    if (GNUNET_YES == found)
+
+  case GNUNET_OS_NIC_REMOVED:
+    lal = find_lal (addr);
+    if (NULL == lal)
+      return;
+    if (0 < --lal->ifc_count)
+      return; /* still on another interface */
+    notify_clients (lal,
+                    GNUNET_NO);
+    free_lal (lal);
+    return;
+
+  case GNUNET_OS_NIC_ADDED:
+    lal = find_lal (addr);
+    if (NULL != lal)
     {
-      GNUNET_free (pos);
+      /* same address on another interface */
+      lal->ifc_count++;
+      return;
     }
-    else
+    lal = make_lal (addr);
+    if (NULL == lal)
+      return;
+    lal->ifc_count = 1;
+    notify_clients (lal,
+                    GNUNET_YES);
+    GNUNET_CONTAINER_DLL_insert (lal_head,
+                                 lal_tail,
+                                 lal);
+    if ((AF_INET == lal->af) &&
+        (NULL == lal->hc) &&
+        (0 != (GNUNET_NAT_AC_LAN & lal->ac)))
     {
-      notify_clients (pos,
-                      GNUNET_YES);
-      GNUNET_CONTAINER_DLL_insert (lal_head,
-                                   lal_tail,
-                                   pos);
-      if ((AF_INET == pos->af) &&
-          (NULL == pos->hc) &&
-          (0 != (GNUNET_NAT_AC_LAN & pos->ac)))
-      {
-        const struct sockaddr_in *s4
-          = (const struct sockaddr_in *) &pos->addr;
-
-        GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                    "Found NATed local address %s, starting NAT server\n",
-                    GNUNET_a2s ((const struct sockaddr *) &pos->addr,
-                                sizeof(*s4)));
-        pos->hc = GN_start_gnunet_nat_server_ (&s4->sin_addr,
-                                               &reversal_callback,
-                                               pos,
-                                               cfg);
-      }
+      const struct sockaddr_in *s4
+        = (const struct sockaddr_in *) &lal->addr;
+
+      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                  "Found NATed local address %s, starting NAT server\n",
+                  GNUNET_a2s ((const struct sockaddr *) &lal->addr,
+                              sizeof(*s4)));
+      lal->hc = GN_start_gnunet_nat_server_ (&s4->sin_addr,
+                                             &reversal_callback,
+                                             lal,
+                                             cfg);
     }
+    return;
   }
-  GN_nat_status_changed (have_nat);
 }
 
 
@@ -1950,10 +1933,10 @@ shutdown_task (void *cls)
     GNUNET_free (se);
   }
   GN_nat_status_changed (GNUNET_NO);
-  if (NULL != scan_task)
+  if (NULL != ifc_mon)
   {
-    GNUNET_SCHEDULER_cancel (scan_task);
-    scan_task = NULL;
+    GNUNET_OS_network_interfaces_monitor_stop (ifc_mon);
+    ifc_mon = NULL;
   }
   if (NULL != stats)
   {
@@ -2021,8 +2004,9 @@ run (void *cls,
   stats = GNUNET_STATISTICS_create ("nat",
                                     cfg);
   if (GNUNET_YES == enable_ipscan)
-    scan_task = GNUNET_SCHEDULER_add_now (&run_scan,
-                                          NULL);
+    ifc_mon = GNUNET_OS_network_interfaces_monitor_start (SCAN_FREQ,
+                                                          &ifc_change_cb,
+                                                          NULL);
 }
 
 
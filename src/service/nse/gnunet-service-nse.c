@@ -48,6 +48,7 @@
 #include "gnunet_testbed_logger_service.h"
 #endif
 #include "nse.h"
+#include "gnunet-service-nse_pow.h"
 #include <gcrypt.h>
 
 
@@ -67,6 +68,11 @@
  */
 #define HISTORY_SIZE 64
 
+/**
+ * How many verified proofs of work of other peers do we remember?
+ */
+#define POW_CACHE_SIZE 1024
+
 /**
  * Message priority to use.  No real rush, reliability not
  * required. Corking OK.
@@ -113,11 +119,6 @@ static struct GNUNET_BIO_WriteHandle *histogram;
 
 #endif
 
-/**
- * Salt for PoW calculations.
- */
-static struct GNUNET_CRYPTO_PowSalt salt = { "gnunet-nse-proof" };
-
 
 /**
  * Per-peer information.
@@ -779,37 +780,6 @@ update_flood_message (void *cls)
 }
 
 
-/**
- * Check whether the given public key and integer are a valid proof of
- * work.
- *
- * @param pkey the public key
- * @param val the integer
- * @return #GNUNET_YES if valid, #GNUNET_NO if not
- */
-static enum GNUNET_GenericReturnValue
-check_proof_of_work (const struct GNUNET_CRYPTO_EddsaPublicKey *pkey,
-                     uint64_t val)
-{
-  char buf[sizeof(struct GNUNET_CRYPTO_EddsaPublicKey)
-           + sizeof(val)] GNUNET_ALIGN;
-  struct GNUNET_HashCode result;
-
-  GNUNET_memcpy (buf, &val, sizeof(val));
-  GNUNET_memcpy (&buf[sizeof(val)],
-                 pkey,
-                 sizeof(struct GNUNET_CRYPTO_EddsaPublicKey));
-  GNUNET_CRYPTO_pow_hash (&salt,
-                          buf,
-                          sizeof(buf),
-                          &result);
-  return (GNUNET_CRYPTO_hash_count_leading_zeros (&result) >=
-          nse_work_required)
-    ? GNUNET_YES
-    : GNUNET_NO;
-}
-
-
 /**
  * Write our current proof to disk.
  */
@@ -848,25 +818,18 @@ find_proof (void *cls)
 {
 #define ROUND_SIZE 10
   uint64_t counter;
-  char buf[sizeof(struct GNUNET_CRYPTO_EddsaPublicKey)
-           + sizeof(uint64_t)] GNUNET_ALIGN;
   struct GNUNET_HashCode result;
   unsigned int i;
 
   (void) cls;
   proof_task = NULL;
-  GNUNET_memcpy (&buf[sizeof(uint64_t)],
-                 &my_identity,
-                 sizeof(struct GNUNET_PeerIdentity));
   i = 0;
   counter = my_proof;
   while ((counter != UINT64_MAX) && (i < ROUND_SIZE))
   {
-    GNUNET_memcpy (buf, &counter, sizeof(uint64_t));
-    GNUNET_CRYPTO_pow_hash (&salt,
-                            buf,
-                            sizeof(buf),
-                            &result);
+    GSN_POW_hash (&my_identity.public_key,
+                  counter,
+                  &result);
     if (nse_work_required <=
         GNUNET_CRYPTO_hash_count_leading_zeros (&result))
     {
@@ -914,8 +877,9 @@ find_proof (void *cls)
 static int
 verify_message_crypto (const struct GNUNET_NSE_FloodMessage *incoming_flood)
 {
-  if (GNUNET_YES != check_proof_of_work (&incoming_flood->origin.public_key,
-                                         incoming_flood->proof_of_work))
+  if (GNUNET_YES !=
+      GSN_POW_check_cached (&incoming_flood->origin.public_key,
+                            incoming_flood->proof_of_work))
   {
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                 "Proof of work invalid: %llu!\n",
@@ -1275,6 +1239,7 @@ shutdown_task (void *cls)
     GNUNET_CORE_disconnect (core_api);
     core_api = NULL;
   }
+  GSN_POW_done ();
   if (NULL != stats)
   {
     GNUNET_STATISTICS_destroy (stats, GNUNET_NO);
@@ -1337,7 +1302,7 @@ core_init (void *cls, const struct GNUNET_PeerIdentity *identity)
     GNUNET_TIME_absolute_add (current_timestamp, gnunet_nse_interval);
   estimate_index = HISTORY_SIZE - 1;
   estimate_count = 0;
-  if (GNUNET_YES == check_proof_of_work (&my_identity.public_key, my_proof))
+  if (GNUNET_YES == GSN_POW_check (&my_identity.public_key, my_proof))
   {
     int idx = (estimate_index + HISTORY_SIZE - 1) % HISTORY_SIZE;
     prev_time.abs_value_us =
@@ -1511,6 +1476,9 @@ run (void *cls,
     return;
   }
   stats = GNUNET_STATISTICS_create ("nse", cfg);
+  GSN_POW_init (nse_work_required,
+                POW_CACHE_SIZE,
+                stats);
 }
 
 
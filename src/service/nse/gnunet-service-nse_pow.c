@@ -0,0 +1,245 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file nse/gnunet-service-nse_pow.c
+ * @brief proofs of work of the NSE service
+ *
+ * An origin keeps its proof of work from round to round, only the
+ * signature of its flood message changes.  As checking a proof costs
+ * an Argon2id hash, we remember the proofs that passed, per origin,
+ * and evict the least recently used ones.
+ */
+#include "platform.h"
+#include "gnunet-service-nse_pow.h"
+
+
+/**
+ * A proof of work that passed the check.
+ */
+struct ProofEntry
+{
+  /**
+   * Kept in a DLL, most recently used first.
+   */
+  struct ProofEntry *next;
+
+  /**
+   * Kept in a DLL, most recently used first.
+   */
+  struct ProofEntry *prev;
+
+  /**
+   * The origin, key in #proofs.
+   */
+  struct GNUNET_PeerIdentity origin;
+
+  /**
+   * The proof of the origin.
+   */
+  uint64_t val;
+};
+
+
+/**
+ * Salt for PoW calculations.
+ */
+static struct GNUNET_CRYPTO_PowSalt salt = { "gnunet-nse-proof" };
+
+/**
+ * Amount of work required (W-bit collisions) for NSE proofs, in
+ * collision-bits.
+ */
+static unsigned long long nse_work_required;
+
+/**
+ * Maps origins to their `struct ProofEntry`.
+ */
+static struct GNUNET_CONTAINER_MultiPeerMap *proofs;
+
+/**
+ * Most recently used proof.
+ */
+static struct ProofEntry *proof_head;
+
+/**
+ * Least recently used proof.
+ */
+static struct ProofEntry *proof_tail;
+
+/**
+ * Maximum number of entries in #proofs.
+ */
+static unsigned int proofs_max;
+
+/**
+ * Handle for reporting statistics, can be NULL.
+ */
+static struct GNUNET_STATISTICS_Handle *pow_stats;
+
+
+void
+GSN_POW_init (unsigned long long work_required,
+              unsigned int cache_size,
+              struct GNUNET_STATISTICS_Handle *stats)
+{
+  nse_work_required = work_required;
+  proofs_max = cache_size;
+  pow_stats = stats;
+  if (0 != cache_size)
+    proofs = GNUNET_CONTAINER_multipeermap_create (cache_size,
+                                                   GNUNET_YES);
+}
+
+
+void
+GSN_POW_done ()
+{
+  struct ProofEntry *pe;
+
+  while (NULL != (pe = proof_head))
+  {
+    GNUNET_CONTAINER_DLL_remove (proof_head,
+                                 proof_tail,
+                                 pe);
+    GNUNET_free (pe);
+  }
+  if (NULL != proofs)
+  {
+    GNUNET_CONTAINER_multipeermap_destroy (proofs);
+    proofs = NULL;
+  }
+  pow_stats = NULL;
+}
+
+
+void
+GSN_POW_hash (const struct GNUNET_CRYPTO_EddsaPublicKey *pkey,
+              uint64_t val,
+              struct GNUNET_HashCode *result)
+{
+  char buf[sizeof(struct GNUNET_CRYPTO_EddsaPublicKey)
+           + sizeof(val)] GNUNET_ALIGN;
+
+  GNUNET_memcpy (buf, &val, sizeof(val));
+  GNUNET_memcpy (&buf[sizeof(val)],
+                 pkey,
+                 sizeof(struct GNUNET_CRYPTO_EddsaPublicKey));
+  GNUNET_CRYPTO_pow_hash (&salt,
+                          buf,
+                          sizeof(buf),
+                          result);
+}
+
+
+enum GNUNET_GenericReturnValue
+GSN_POW_check (const struct GNUNET_CRYPTO_EddsaPublicKey *pkey,
+               uint64_t val)
+{
+  struct GNUNET_HashCode result;
+
+  if (0 == nse_work_required)
+    return GNUNET_YES;
+  GSN_POW_hash (pkey,
+                val,
+                &result);
+  return (GNUNET_CRYPTO_hash_count_leading_zeros (&result) >=
+          nse_work_required)
+    ? GNUNET_YES
+    : GNUNET_NO;
+}
+
+
+enum GNUNET_GenericReturnValue
+GSN_POW_check_cached (const struct GNUNET_CRYPTO_EddsaPublicKey *pkey,
+                      uint64_t val)
+{
+  const struct GNUNET_PeerIdentity *origin
+    = (const struct GNUNET_PeerIdentity *) pkey;
+  struct ProofEntry *pe;
+
+  if (NULL == proofs)
+    return GSN_POW_check (pkey,
+                          val);
+  pe = GNUNET_CONTAINER_multipeermap_get (proofs,
+                                          origin);
+  if ( (NULL != pe) &&
+       (pe->val == val) )
+  {
+    GNUNET_STATISTICS_update (pow_stats,
+                              gettext_noop ("# proof-of-work cache hits"),
+                              1,
+                              GNUNET_NO);
+    GNUNET_CONTAINER_DLL_remove (proof_head,
+                                 proof_tail,
+                                 pe);
+    GNUNET_CONTAINER_DLL_insert (proof_head,
+                                 proof_tail,
+                                 pe);
+    return GNUNET_YES;
+  }
+  GNUNET_STATISTICS_update (pow_stats,
+                            gettext_noop ("# proof-of-work cache misses"),
+                            1,
+                            GNUNET_NO);
+  if (GNUNET_YES != GSN_POW_check (pkey,
+                                   val))
+    return GNUNET_NO;
+  if (NULL != pe)
+  {
+    /* origin found a new proof */
+    GNUNET_CONTAINER_DLL_remove (proof_head,
+                                 proof_tail,
+                                 pe);
+  }
+  else
+  {
+    if (GNUNET_CONTAINER_multipeermap_size (proofs) >= proofs_max)
+    {
+      pe = proof_tail;
+      GNUNET_CONTAINER_DLL_remove (proof_head,
+                                   proof_tail,
+                                   pe);
+      GNUNET_assert (GNUNET_YES ==
+                     GNUNET_CONTAINER_multipeermap_remove (proofs,
+                                                           &pe->origin,
+                                                           pe));
+    }
+    else
+    {
+      pe = GNUNET_new (struct ProofEntry);
+    }
+    pe->origin = *origin;
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multipeermap_put (
+                     proofs,
+                     &pe->origin,
+                     pe,
+                     GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST));
+  }
+  pe->val = val;
+  GNUNET_CONTAINER_DLL_insert (proof_head,
+                               proof_tail,
+                               pe);
+  return GNUNET_YES;
+}
+
+
+/* end of gnunet-service-nse_pow.c */
@@ -0,0 +1,91 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file nse/gnunet-service-nse_pow.h
+ * @brief proofs of work of the NSE service
+ */
+#ifndef GNUNET_SERVICE_NSE_POW_H
+#define GNUNET_SERVICE_NSE_POW_H
+
+#include "gnunet_util_lib.h"
+#include "gnunet_statistics_service.h"
+
+
+/**
+ * Initialize the proof of work checks.
+ *
+ * @param work_required number of leading zero bits a proof needs
+ * @param cache_size how many verified proofs to remember
+ * @param stats where to report cache hits and misses, can be NULL
+ */
+void
+GSN_POW_init (unsigned long long work_required,
+              unsigned int cache_size,
+              struct GNUNET_STATISTICS_Handle *stats);
+
+
+/**
+ * Forget all verified proofs.
+ */
+void
+GSN_POW_done (void);
+
+
+/**
+ * Compute the proof of work hash of a public key and integer.
+ *
+ * @param pkey the public key
+ * @param val the integer
+ * @param[out] result the hash
+ */
+void
+GSN_POW_hash (const struct GNUNET_CRYPTO_EddsaPublicKey *pkey,
+              uint64_t val,
+              struct GNUNET_HashCode *result);
+
+
+/**
+ * Check whether the given public key and integer are a valid proof of
+ * work.
+ *
+ * @param pkey the public key
+ * @param val the integer
+ * @return #GNUNET_YES if valid, #GNUNET_NO if not
+ */
+enum GNUNET_GenericReturnValue
+GSN_POW_check (const struct GNUNET_CRYPTO_EddsaPublicKey *pkey,
+               uint64_t val);
+
+
+/**
+ * Check whether the given public key and integer are a valid proof of
+ * work, remembering the proofs that recently passed.
+ *
+ * @param pkey the public key
+ * @param val the integer
+ * @return #GNUNET_YES if valid, #GNUNET_NO if not
+ */
+enum GNUNET_GenericReturnValue
+GSN_POW_check_cached (const struct GNUNET_CRYPTO_EddsaPublicKey *pkey,
+                      uint64_t val);
+
+
+#endif
@@ -0,0 +1,177 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file nse/perf_nse_pow_cache.c
+ * @brief measure checking the proofs of work of the flood messages a
+ *        peer receives over several rounds, with and without
+ *        remembering the proofs that passed
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "gnunet-service-nse_pow.h"
+
+/**
+ * Number of peers whose flood messages we receive.
+ */
+#define NUM_ORIGINS 128
+
+/**
+ * Number of rounds to replay.
+ */
+#define ROUNDS 8
+
+/**
+ * Number of neighbours forwarding the flood message of each origin
+ * to us in every round.
+ */
+#define DUPLICATES 2
+
+/**
+ * Leading zero bits a proof needs; low, so we find the proofs quickly.
+ */
+#define WORK_REQUIRED 2
+
+
+static struct GNUNET_CRYPTO_EddsaPublicKey origins[NUM_ORIGINS];
+
+static uint64_t proofs[NUM_ORIGINS];
+
+
+static void
+report (const char *mode,
+        struct GNUNET_TIME_Absolute start,
+        unsigned long long ops)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %llu proofs checked in %s (%llu/s)\n",
+          mode,
+          ops,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          ops * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+/**
+ * Replay the rounds, checking every proof with @a check.
+ */
+static void
+replay (const char *mode,
+        enum GNUNET_GenericReturnValue
+        (*check)(const struct GNUNET_CRYPTO_EddsaPublicKey *pkey,
+                 uint64_t val))
+{
+  struct GNUNET_TIME_Absolute start;
+  unsigned long long ops = 0;
+
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int round = 0; round < ROUNDS; round++)
+    for (unsigned int d = 0; d < DUPLICATES; d++)
+      for (unsigned int i = 0; i < NUM_ORIGINS; i++)
+      {
+        GNUNET_assert (GNUNET_YES ==
+                       check (&origins[i],
+                              proofs[i]));
+        ops++;
+      }
+  report (mode,
+          start,
+          ops);
+}
+
+
+/**
+ * Find a proof for @a pkey, and a value that is not one.
+ */
+static void
+find_proof (const struct GNUNET_CRYPTO_EddsaPublicKey *pkey,
+            uint64_t *proof,
+            uint64_t *bad)
+{
+  struct GNUNET_HashCode result;
+
+  *bad = UINT64_MAX;
+  for (*proof = 0; ; (*proof)++)
+  {
+    GSN_POW_hash (pkey,
+                  *proof,
+                  &result);
+    if (GNUNET_CRYPTO_hash_count_leading_zeros (&result) >= WORK_REQUIRED)
+      return;
+    *bad = *proof;
+  }
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  uint64_t bad;
+
+  GNUNET_log_setup ("perf-nse-pow-cache",
+                    "WARNING",
+                    NULL);
+  for (unsigned int i = 0; i < NUM_ORIGINS; i++)
+  {
+    /* we want a value that is not a proof before the proof */
+    do
+    {
+      GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_WEAK,
+                                  &origins[i],
+                                  sizeof (origins[i]));
+      find_proof (&origins[i],
+                  &proofs[i],
+                  &bad);
+    }
+    while (UINT64_MAX == bad);
+  }
+
+  GSN_POW_init (WORK_REQUIRED,
+                NUM_ORIGINS,
+                NULL);
+  replay ("uncached",
+          &GSN_POW_check);
+  replay ("cached",
+          &GSN_POW_check_cached);
+  /* a wrong proof of a known origin must not pass */
+  GNUNET_assert (GNUNET_NO ==
+                 GSN_POW_check_cached (&origins[NUM_ORIGINS - 1],
+                                       bad));
+  GNUNET_assert (GNUNET_YES ==
+                 GSN_POW_check_cached (&origins[NUM_ORIGINS - 1],
+                                       proofs[NUM_ORIGINS - 1]));
+  GSN_POW_done ();
+
+  /* a cache too small for all origins must still be correct */
+  GSN_POW_init (WORK_REQUIRED,
+                NUM_ORIGINS / 2,
+                NULL);
+  replay ("cached, half the origins",
+          &GSN_POW_check_cached);
+  GSN_POW_done ();
+  return 0;
+}
+
+
+/* end of perf_nse_pow_cache.c */
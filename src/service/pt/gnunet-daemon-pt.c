@@ -47,73 +47,82 @@
  */
 #define MAX_DNS_SIZE (8 * 1024)
 
+/**
+ * How many channels do we keep open at least (if we know of enough
+ * DNS exits)?
+ */
+#define MIN_OPEN_TUNNELS 4
+
 /**
  * How many channels do we open at most at the same time?
  */
-#define MAX_OPEN_TUNNELS 4
+#define MAX_OPEN_TUNNELS 16
+
+/**
+ * How many DNS requests waiting for an answer do we allow per open
+ * channel before we open another one?
+ */
+#define REQUESTS_PER_TUNNEL 64
 
 
 /**
- * Which group of DNS records are we currently processing?
+ * Information tracked per DNS reply that we are processing.
  */
-enum RequestGroup
+struct ReplyContext
 {
   /**
-   * DNS answers
+   * Handle to submit the final result.
    */
-  ANSWERS = 0,
+  struct GNUNET_DNS_RequestHandle *rh;
 
   /**
-   * DNS authority records
+   * DNS packet that is being modified.
    */
-  AUTHORITY_RECORDS = 1,
+  struct GNUNET_DNSPARSER_Packet *dns;
 
   /**
-   * DNS additional records
+   * Head of DLL of records we are waiting on the VPN for.
    */
-  ADDITIONAL_RECORDS = 2,
+  struct RecordRedirection *redirect_head;
 
   /**
-   * We're done processing.
+   * Tail of DLL of records we are waiting on the VPN for.
    */
-  END = 3
+  struct RecordRedirection *redirect_tail;
 };
 
 
 /**
- * Information tracked per DNS reply that we are processing.
+ * Redirection we requested from the VPN for one of the records
+ * of a DNS reply.  We request the redirections for all records
+ * of a reply at the same time.
  */
-struct ReplyContext
+struct RecordRedirection
 {
   /**
-   * Handle to submit the final result.
+   * Kept in a DLL.
    */
-  struct GNUNET_DNS_RequestHandle *rh;
+  struct RecordRedirection *next;
 
   /**
-   * DNS packet that is being modified.
+   * Kept in a DLL.
    */
-  struct GNUNET_DNSPARSER_Packet *dns;
+  struct RecordRedirection *prev;
 
   /**
-   * Active redirection request with the VPN.
+   * Reply the record belongs to.
    */
-  struct GNUNET_VPN_RedirectionRequest *rr;
+  struct ReplyContext *rc;
 
   /**
-   * Record for which we have an active redirection request.
+   * Record to modify once the redirection is available.
    */
   struct GNUNET_DNSPARSER_Record *rec;
 
   /**
-   * Offset in the current record group that is being modified.
-   */
-  unsigned int offset;
-
-  /**
-   * Group that is being modified
+   * Active redirection request with the VPN.
    */
-  enum RequestGroup group;
+  struct GNUNET_VPN_RedirectionRequest *rr;
 };
 
 
@@ -146,14 +155,9 @@ struct CadetExit
   struct GNUNET_TIME_Absolute expiration;
 
   /**
-   * Head of DLL of requests waiting for a response.
+   * Requests waiting for a response, by DNS ID.
    */
-  struct RequestContext *receive_queue_head;
-
-  /**
-   * Tail of DLL of requests waiting for a response.
-   */
-  struct RequestContext *receive_queue_tail;
+  struct GNUNET_CONTAINER_MultiHashMap32 *receive_queue;
 
   /**
    * Identity of the peer that is providing the exit for us.
@@ -182,16 +186,6 @@ struct CadetExit
  */
 struct RequestContext
 {
-  /**
-   * We keep these in a DLL.
-   */
-  struct RequestContext *next;
-
-  /**
-   * We keep these in a DLL.
-   */
-  struct RequestContext *prev;
-
   /**
    * Exit that was chosen for this request.
    */
@@ -298,6 +292,21 @@ static int dns_channel;
  */
 static unsigned int dns_exit_available;
 
+/**
+ * Number of DNS exit peers we know about, with or without a channel.
+ */
+static unsigned int dns_exit_known;
+
+/**
+ * Number of DNS requests waiting for an answer from a DNS exit.
+ */
+static unsigned int dns_requests_pending;
+
+/**
+ * Task that closes channels we no longer need.
+ */
+static struct GNUNET_SCHEDULER_Task *shrink_task;
+
 
 /**
  * We are short on cadet exits, try to open another one.
@@ -306,6 +315,26 @@ static void
 try_open_exit (void);
 
 
+/**
+ * How many channels to DNS exits do we want to have open, given
+ * the number of DNS requests waiting for an answer?
+ *
+ * @return number of channels to keep open
+ */
+static unsigned int
+get_exit_target (void)
+{
+  unsigned int target;
+
+  target = 1 + dns_requests_pending / REQUESTS_PER_TUNNEL;
+  if (target < MIN_OPEN_TUNNELS)
+    return MIN_OPEN_TUNNELS;
+  if (target > MAX_OPEN_TUNNELS)
+    return MAX_OPEN_TUNNELS;
+  return target;
+}
+
+
 /**
  * Compute the weight of the given exit.  The higher the weight,
  * the more likely it will be that the channel will be chosen.
@@ -318,12 +347,15 @@ try_open_exit (void);
 static uint32_t
 get_channel_weight (struct CadetExit *exit)
 {
+  uint32_t pending;
   uint32_t dropped;
   uint32_t drop_percent;
   uint32_t good_percent;
 
-  GNUNET_assert (exit->num_transmitted >= exit->num_answered);
-  dropped = exit->num_transmitted - exit->num_answered;
+  pending = GNUNET_CONTAINER_multihashmap32_size (exit->receive_queue);
+  GNUNET_assert (exit->num_transmitted >= exit->num_answered + pending);
+  /* requests still waiting for their answer were not dropped (yet) */
+  dropped = exit->num_transmitted - exit->num_answered - pending;
   if (exit->num_transmitted > 0)
     drop_percent = (uint32_t) ((100LL * dropped) / exit->num_transmitted);
   else
@@ -332,7 +364,8 @@ get_channel_weight (struct CadetExit *exit)
       (drop_percent > 25))
     return 0; /* statistically significant, and > 25% loss, die */
   good_percent = 100 - drop_percent;
-  GNUNET_assert (0 != good_percent);
+  if (0 == good_percent)
+    good_percent = 1; /* too few transmissions to give up on it */
   if (UINT32_MAX / good_percent / good_percent < exit->num_transmitted)
     return UINT32_MAX; /* formula below would overflow */
   return 1 + good_percent * good_percent * exit->num_transmitted;
@@ -353,42 +386,40 @@ get_channel_weight (struct CadetExit *exit)
 static struct CadetExit *
 choose_exit ()
 {
-  struct CadetExit *pos;
-  uint64_t total_transmitted;
+  struct CadetExit *candidates[MAX_OPEN_TUNNELS];
+  uint64_t offsets[MAX_OPEN_TUNNELS];
+  unsigned int num_candidates;
+  uint64_t total_weight;
   uint64_t selected_offset;
-  uint32_t channel_weight;
-
-  total_transmitted = 0;
-  for (pos = exit_head; NULL != pos; pos = pos->next)
+  uint64_t channel_weight;
+
+  num_candidates = 0;
+  total_weight = 0;
+  for (struct CadetExit *pos = exit_head;
+       (NULL != pos) &&
+       (NULL != pos->cadet_channel) &&
+       (num_candidates < MAX_OPEN_TUNNELS);
+       pos = pos->next)
   {
-    if (NULL == pos->cadet_channel)
-      break;
     channel_weight = get_channel_weight (pos);
-    total_transmitted += channel_weight;
     /* double weight for idle channels */
     if (0 != pos->idle)
-      total_transmitted += channel_weight;
+      channel_weight *= 2;
+    total_weight += channel_weight;
+    candidates[num_candidates] = pos;
+    offsets[num_candidates] = total_weight;
+    num_candidates++;
   }
-  if (0 == total_transmitted)
+  if (0 == total_weight)
   {
     /* no channels available, or only a very bad one... */
     return exit_head;
   }
   selected_offset = GNUNET_CRYPTO_random_u64 (GNUNET_CRYPTO_QUALITY_WEAK,
-                                              total_transmitted);
-  total_transmitted = 0;
-  for (pos = exit_head; NULL != pos; pos = pos->next)
-  {
-    if (NULL == pos->cadet_channel)
-      break;
-    channel_weight = get_channel_weight (pos);
-    total_transmitted += channel_weight;
-    /* double weight for idle channels */
-    if (0 != pos->idle)
-      total_transmitted += channel_weight;
-    if (total_transmitted > selected_offset)
-      return pos;
-  }
+                                              total_weight);
+  for (unsigned int i = 0; i < num_candidates; i++)
+    if (offsets[i] > selected_offset)
+      return candidates[i];
   GNUNET_break (0);
   return NULL;
 }
@@ -432,24 +463,38 @@ finish_request (struct ReplyContext *rc)
 
 
 /**
- * Process the next record of the given request context.
- * When done, submit the reply and free the resources of
- * the rc.
+ * We failed to modify a record in the response.  Drop the reply,
+ * cancel the other redirections and free the resources of the rc.
  *
- * @param rc context to process
+ * @param rc context to abort
  */
 static void
-submit_request (struct ReplyContext *rc);
+abort_reply (struct ReplyContext *rc)
+{
+  struct RecordRedirection *rd;
+
+  while (NULL != (rd = rc->redirect_head))
+  {
+    GNUNET_CONTAINER_DLL_remove (rc->redirect_head,
+                                 rc->redirect_tail,
+                                 rd);
+    if (NULL != rd->rr)
+      GNUNET_VPN_cancel_request (rd->rr);
+    GNUNET_free (rd);
+  }
+  GNUNET_DNS_request_drop (rc->rh);
+  GNUNET_DNSPARSER_free_packet (rc->dns);
+  GNUNET_free (rc);
+}
 
 
 /**
  * Callback invoked from the VPN service once a redirection is
  * available.  Provides the IP address that can now be used to
- * reach the requested destination.  We substitute the active
- * record and then continue with 'submit_request' to look at
- * the other records.
+ * reach the requested destination.  We substitute the record
+ * and, once the last record is done, submit the reply.
  *
- * @param cls our `struct ReplyContext`
+ * @param cls our `struct RecordRedirection`
  * @param af address family, AF_INET or AF_INET6; AF_UNSPEC on error;
  *                will match 'result_af' from the request
  * @param address IP address (struct in_addr or struct in_addr6, depending on 'af')
@@ -462,32 +507,31 @@ vpn_allocation_callback (void *cls,
                          int af,
                          const void *address)
 {
-  struct ReplyContext *rc = cls;
+  struct RecordRedirection *rd = cls;
+  struct ReplyContext *rc = rd->rc;
 
-  rc->rr = NULL;
+  rd->rr = NULL;
   if (af == AF_UNSPEC)
   {
-    GNUNET_DNS_request_drop (rc->rh);
-    GNUNET_DNSPARSER_free_packet (rc->dns);
-    GNUNET_free (rc);
+    abort_reply (rc);
     return;
   }
   GNUNET_STATISTICS_update (stats,
                             gettext_noop ("# DNS records modified"),
                             1,
                             GNUNET_NO);
-  switch (rc->rec->type)
+  switch (rd->rec->type)
   {
   case GNUNET_DNSPARSER_TYPE_A:
     GNUNET_assert (AF_INET == af);
-    GNUNET_memcpy (rc->rec->data.raw.data,
+    GNUNET_memcpy (rd->rec->data.raw.data,
                    address,
                    sizeof(struct in_addr));
     break;
 
   case GNUNET_DNSPARSER_TYPE_AAAA:
     GNUNET_assert (AF_INET6 == af);
-    GNUNET_memcpy (rc->rec->data.raw.data,
+    GNUNET_memcpy (rd->rec->data.raw.data,
                    address,
                    sizeof(struct in6_addr));
     break;
@@ -496,16 +540,19 @@ vpn_allocation_callback (void *cls,
     GNUNET_assert (0);
     return;
   }
-  rc->rec = NULL;
-  submit_request (rc);
+  GNUNET_CONTAINER_DLL_remove (rc->redirect_head,
+                               rc->redirect_tail,
+                               rd);
+  GNUNET_free (rd);
+  if (NULL == rc->redirect_head)
+    finish_request (rc);
 }
 
 
 /**
  * Modify the given DNS record by asking VPN to create a channel
- * to the given address.  When done, continue with submitting
- * other records from the request context ('submit_request' is
- * our continuation).
+ * to the given address.  Once all records of the request context
+ * are done, #vpn_allocation_callback() submits the reply.
  *
  * @param rc context to process
  * @param rec record to modify
@@ -514,6 +561,7 @@ static void
 modify_address (struct ReplyContext *rc,
                 struct GNUNET_DNSPARSER_Record *rec)
 {
+  struct RecordRedirection *rd;
   int af;
 
   switch (rec->type)
@@ -532,88 +580,80 @@ modify_address (struct ReplyContext *rc,
     GNUNET_assert (0);
     return;
   }
-  rc->rec = rec;
-  rc->rr = GNUNET_VPN_redirect_to_ip (vpn_handle,
+  rd = GNUNET_new (struct RecordRedirection);
+  rd->rc = rc;
+  rd->rec = rec;
+  GNUNET_CONTAINER_DLL_insert_tail (rc->redirect_head,
+                                    rc->redirect_tail,
+                                    rd);
+  rd->rr = GNUNET_VPN_redirect_to_ip (vpn_handle,
                                       af,
                                       af,
                                       rec->data.raw.data,
                                       GNUNET_TIME_relative_to_absolute (
                                         TIMEOUT),
                                       &vpn_allocation_callback,
-                                      rc);
+                                      rd);
 }
 
 
 /**
- * Process the next record of the given request context.
- * When done, submit the reply and free the resources of
- * the rc.
+ * Ask the VPN for redirections for all of the given records
+ * that need protocol-translation work.
  *
  * @param rc context to process
+ * @param ra array of records
+ * @param ra_len number of entries in @a ra
  */
 static void
-submit_request (struct ReplyContext *rc)
+modify_records (struct ReplyContext *rc,
+                struct GNUNET_DNSPARSER_Record *ra,
+                unsigned int ra_len)
 {
-  struct GNUNET_DNSPARSER_Record *ra;
-  unsigned int ra_len;
-  unsigned int i;
-
-  while (1)
+  for (unsigned int i = 0; i < ra_len; i++)
   {
-    switch (rc->group)
+    switch (ra[i].type)
     {
-    case ANSWERS:
-      ra = rc->dns->answers;
-      ra_len = rc->dns->num_answers;
-      break;
-
-    case AUTHORITY_RECORDS:
-      ra = rc->dns->authority_records;
-      ra_len = rc->dns->num_authority_records;
+    case GNUNET_DNSPARSER_TYPE_A:
+      if (ipv4_pt)
+        modify_address (rc,
+                        &ra[i]);
       break;
 
-    case ADDITIONAL_RECORDS:
-      ra = rc->dns->additional_records;
-      ra_len = rc->dns->num_additional_records;
+    case GNUNET_DNSPARSER_TYPE_AAAA:
+      if (ipv6_pt)
+        modify_address (rc,
+                        &ra[i]);
       break;
-
-    case END:
-      finish_request (rc);
-      return;
-
-    default:
-      GNUNET_assert (0);
     }
-    for (i = rc->offset; i < ra_len; i++)
-    {
-      switch (ra[i].type)
-      {
-      case GNUNET_DNSPARSER_TYPE_A:
-        if (ipv4_pt)
-        {
-          rc->offset = i + 1;
-          modify_address (rc,
-                          &ra[i]);
-          return;
-        }
-        break;
-
-      case GNUNET_DNSPARSER_TYPE_AAAA:
-        if (ipv6_pt)
-        {
-          rc->offset = i + 1;
-          modify_address (rc,
-                          &ra[i]);
-          return;
-        }
-        break;
-      }
-    }
-    rc->group++;
   }
 }
 
 
+/**
+ * Request the redirections for all records of the given request
+ * context at once.  Once they are all done, the reply is submitted
+ * and the resources of the rc are freed.
+ *
+ * @param rc context to process
+ */
+static void
+submit_request (struct ReplyContext *rc)
+{
+  modify_records (rc,
+                  rc->dns->answers,
+                  rc->dns->num_answers);
+  modify_records (rc,
+                  rc->dns->authority_records,
+                  rc->dns->num_authority_records);
+  modify_records (rc,
+                  rc->dns->additional_records,
+                  rc->dns->num_additional_records);
+  if (NULL == rc->redirect_head)
+    finish_request (rc);
+}
+
+
 /**
  * Test if any of the given records need protocol-translation work.
  *
@@ -695,12 +735,82 @@ dns_post_request_handler (void *cls,
   rc = GNUNET_new (struct ReplyContext);
   rc->rh = rh;
   rc->dns = dns;
-  rc->offset = 0;
-  rc->group = ANSWERS;
   submit_request (rc);
 }
 
 
+/**
+ * Forget about a DNS request that is done.
+ *
+ * @param rc the request to free
+ */
+static void
+free_request (struct RequestContext *rc)
+{
+  GNUNET_assert (GNUNET_YES ==
+                 GNUNET_CONTAINER_multihashmap32_remove (rc->exit->receive_queue,
+                                                         rc->dns_id,
+                                                         rc));
+  dns_requests_pending--;
+  if (NULL != rc->timeout_task)
+    GNUNET_SCHEDULER_cancel (rc->timeout_task);
+  GNUNET_MQ_discard (rc->env);
+  GNUNET_free (rc);
+}
+
+
+/**
+ * Close the channel to the given exit and move it to the end of the
+ * list of exits, where those without a channel live.
+ *
+ * @param exit exit to close the channel for
+ */
+static void
+close_exit (struct CadetExit *exit)
+{
+  GNUNET_CADET_channel_destroy (exit->cadet_channel);
+  exit->cadet_channel = NULL;
+  GNUNET_CONTAINER_DLL_remove (exit_head,
+                               exit_tail,
+                               exit);
+  GNUNET_CONTAINER_DLL_insert_tail (exit_head,
+                                    exit_tail,
+                                    exit);
+  dns_exit_available--;
+}
+
+
+/**
+ * Task run once the load went down to close channels to exits
+ * that we no longer need and that have no requests waiting.
+ *
+ * @param cls NULL
+ */
+static void
+shrink_exits (void *cls)
+{
+  struct CadetExit *pos;
+  struct CadetExit *next;
+
+  shrink_task = NULL;
+  for (pos = exit_head; NULL != pos; pos = next)
+  {
+    next = pos->next;
+    if (dns_exit_available <= get_exit_target ())
+      break;
+    if (NULL == pos->cadet_channel)
+      break;
+    if (0 != GNUNET_CONTAINER_multihashmap32_size (pos->receive_queue))
+      continue;
+    GNUNET_STATISTICS_update (stats,
+                              gettext_noop ("# DNS exit channels closed (idle)"),
+                              1,
+                              GNUNET_NO);
+    close_exit (pos);
+  }
+}
+
+
 /**
  * Task run if the time to answer a DNS request via CADET is over.
  *
@@ -712,32 +822,25 @@ timeout_request (void *cls)
   struct RequestContext *rc = cls;
   struct CadetExit *exit = rc->exit;
 
+  rc->timeout_task = NULL;
   GNUNET_STATISTICS_update (stats,
                             gettext_noop ("# DNS requests dropped (timeout)"),
                             1,
                             GNUNET_NO);
   GNUNET_DNS_request_drop (rc->rh);
-  GNUNET_free (rc);
+  free_request (rc);
   if ((0 == get_channel_weight (exit)) &&
-      (NULL == exit->receive_queue_head))
+      (0 == GNUNET_CONTAINER_multihashmap32_size (exit->receive_queue)))
   {
     /* this straw broke the camel's back: this channel now has
        such a low score that it will not be used; close it! */
-    GNUNET_CADET_channel_destroy (exit->cadet_channel);
-    exit->cadet_channel = NULL;
-    GNUNET_CONTAINER_DLL_remove (exit_head,
-                                 exit_tail,
-                                 exit);
-    GNUNET_CONTAINER_DLL_insert_tail (exit_head,
-                                      exit_tail,
-                                      exit);
+    close_exit (exit);
     /* go back to semi-innocent: mark as not great, but
        avoid a prohibitively negative score (see
      #get_channel_weight(), which checks for a certain
        minimum number of transmissions before making
        up an opinion) */exit->num_transmitted = 5;
     exit->num_answered = 0;
-    dns_exit_available--;
     /* now try to open an alternative exit */
     try_open_exit ();
   }
@@ -809,14 +912,21 @@ dns_pre_request_handler (void *cls,
                  sizeof(dns));
   rc->dns_id = dns.id;
   rc->env = env;
-  GNUNET_CONTAINER_DLL_remove (exit->receive_queue_head,
-                               exit->receive_queue_tail,
-                               rc);
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONTAINER_multihashmap32_put (
+                   exit->receive_queue,
+                   rc->dns_id,
+                   rc,
+                   GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
+  dns_requests_pending++;
   if (0 < exit->idle)
     exit->idle--;
   exit->num_transmitted++;
   GNUNET_MQ_send (GNUNET_CADET_get_mq (exit->cadet_channel),
                   GNUNET_MQ_env_copy (env));
+  if ((dns_exit_available < get_exit_target ()) &&
+      (dns_exit_available < dns_exit_known))
+    try_open_exit ();
 }
 
 
@@ -873,30 +983,51 @@ handle_dns_response (void *cls,
   struct RequestContext *rc;
 
   mlen = ntohs (msg->header.size) - sizeof(*msg);
-  for (rc = exit->receive_queue_head; NULL != rc; rc = rc->next)
+  rc = GNUNET_CONTAINER_multihashmap32_get (exit->receive_queue,
+                                            msg->dns.id);
+  if (NULL == rc)
   {
-    if (msg->dns.id == rc->dns_id)
-    {
-      GNUNET_STATISTICS_update (stats,
-                                gettext_noop ("# DNS replies received"),
-                                1,
-                                GNUNET_NO);
-      GNUNET_DNS_request_answer (rc->rh,
-                                 mlen + sizeof(struct GNUNET_TUN_DnsHeader),
-                                 (const void *) &msg->dns);
-      GNUNET_CONTAINER_DLL_remove (exit->receive_queue_head,
-                                   exit->receive_queue_tail,
-                                   rc);
-      GNUNET_SCHEDULER_cancel (rc->timeout_task);
-      GNUNET_MQ_discard (rc->env);
-      GNUNET_free (rc);
-      exit->num_answered++;
-      return;
-    }
+    GNUNET_STATISTICS_update (stats,
+                              gettext_noop (
+                                "# DNS replies dropped (too late?)"),
+                              1, GNUNET_NO);
+    return;
   }
   GNUNET_STATISTICS_update (stats,
-                            gettext_noop ("# DNS replies dropped (too late?)"),
-                            1, GNUNET_NO);
+                            gettext_noop ("# DNS replies received"),
+                            1,
+                            GNUNET_NO);
+  GNUNET_DNS_request_answer (rc->rh,
+                             mlen + sizeof(struct GNUNET_TUN_DnsHeader),
+                             (const void *) &msg->dns);
+  free_request (rc);
+  exit->num_answered++;
+  if ((dns_exit_available > get_exit_target ()) &&
+      (0 == GNUNET_CONTAINER_multihashmap32_size (exit->receive_queue)) &&
+      (NULL == shrink_task))
+    shrink_task = GNUNET_SCHEDULER_add_now (&shrink_exits,
+                                            NULL);
+}
+
+
+/**
+ * Drop a pending DNS request.
+ *
+ * @param cls NULL
+ * @param key DNS ID of the request
+ * @param value the `struct RequestContext` to drop
+ * @return #GNUNET_OK (continue to iterate)
+ */
+static enum GNUNET_GenericReturnValue
+drop_request (void *cls,
+              uint32_t key,
+              void *value)
+{
+  struct RequestContext *rc = value;
+
+  GNUNET_DNS_request_drop (rc->rh);
+  free_request (rc);
+  return GNUNET_OK;
 }
 
 
@@ -908,18 +1039,9 @@ handle_dns_response (void *cls,
 static void
 abort_all_requests (struct CadetExit *exit)
 {
-  struct RequestContext *rc;
-
-  while (NULL != (rc = exit->receive_queue_head))
-  {
-    GNUNET_CONTAINER_DLL_remove (exit->receive_queue_head,
-                                 exit->receive_queue_tail,
-                                 rc);
-    GNUNET_DNS_request_drop (rc->rh);
-    GNUNET_SCHEDULER_cancel (rc->timeout_task);
-    GNUNET_MQ_discard (rc->env);
-    GNUNET_free (rc);
-  }
+  GNUNET_CONTAINER_multihashmap32_iterate (exit->receive_queue,
+                                           &drop_request,
+                                           NULL);
 }
 
 
@@ -951,8 +1073,14 @@ cleanup (void *cls)
       exit->cadet_channel = NULL;
     }
     abort_all_requests (exit);
+    GNUNET_CONTAINER_multihashmap32_destroy (exit->receive_queue);
     GNUNET_free (exit);
   }
+  if (NULL != shrink_task)
+  {
+    GNUNET_SCHEDULER_cancel (shrink_task);
+    shrink_task = NULL;
+  }
   if (NULL != cadet_handle)
   {
     GNUNET_CADET_disconnect (cadet_handle);
@@ -986,6 +1114,40 @@ cleanup (void *cls)
 }
 
 
+/**
+ * Move a pending DNS request to another exit and transmit it again.
+ *
+ * @param cls the `struct CadetExit` to move the request to
+ * @param key DNS ID of the request
+ * @param value the `struct RequestContext` to move
+ * @return #GNUNET_OK (continue to iterate)
+ */
+static enum GNUNET_GenericReturnValue
+move_request (void *cls,
+              uint32_t key,
+              void *value)
+{
+  struct CadetExit *alt = cls;
+  struct RequestContext *rc = value;
+
+  GNUNET_assert (GNUNET_YES ==
+                 GNUNET_CONTAINER_multihashmap32_remove (rc->exit->receive_queue,
+                                                         key,
+                                                         rc));
+  rc->exit = alt;
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONTAINER_multihashmap32_put (
+                   alt->receive_queue,
+                   key,
+                   rc,
+                   GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
+  alt->num_transmitted++;
+  GNUNET_MQ_send (GNUNET_CADET_get_mq (alt->cadet_channel),
+                  GNUNET_MQ_env_copy (rc->env));
+  return GNUNET_OK;
+}
+
+
 /**
  * Function called whenever a channel is destroyed.  Should clean up
  * the associated state and attempt to build a new one.
@@ -1003,26 +1165,26 @@ cadet_channel_end_cb (void *cls,
 {
   struct CadetExit *exit = cls;
   struct CadetExit *alt;
-  struct RequestContext *rc;
 
   exit->cadet_channel = NULL;
+  GNUNET_CONTAINER_DLL_remove (exit_head,
+                               exit_tail,
+                               exit);
+  GNUNET_CONTAINER_DLL_insert_tail (exit_head,
+                                    exit_tail,
+                                    exit);
   dns_exit_available--;
-  /* open alternative channels */
   /* our channel is now closed, move our requests to an alternative
      channel */
   alt = choose_exit ();
-  while (NULL != (rc = exit->receive_queue_head))
-  {
-    GNUNET_CONTAINER_DLL_remove (exit->receive_queue_head,
-                                 exit->receive_queue_tail,
-                                 rc);
-    rc->exit = alt;
-    GNUNET_CONTAINER_DLL_insert (alt->receive_queue_head,
-                                 alt->receive_queue_tail,
-                                 rc);
-    GNUNET_MQ_send (GNUNET_CADET_get_mq (alt->cadet_channel),
-                    GNUNET_MQ_env_copy (rc->env));
-  }
+  if ((NULL == alt) ||
+      (NULL == alt->cadet_channel))
+    abort_all_requests (exit);
+  else
+    GNUNET_CONTAINER_multihashmap32_iterate (exit->receive_queue,
+                                             &move_request,
+                                             alt);
+  /* open alternative channels */
   try_open_exit ();
 }
 
@@ -1164,6 +1326,8 @@ handle_dht_result (void *cls,
   {
     exit = GNUNET_new (struct CadetExit);
     exit->peer = ad->peer;
+    exit->receive_queue = GNUNET_CONTAINER_multihashmap32_create (32);
+    dns_exit_known++;
     /* channel is closed, so insert at the end */
     GNUNET_CONTAINER_DLL_insert_tail (exit_head,
                                       exit_tail,
@@ -1172,7 +1336,7 @@ handle_dht_result (void *cls,
   exit->expiration = GNUNET_TIME_absolute_max (exit->expiration,
                                                GNUNET_TIME_absolute_ntoh (
                                                  ad->expiration_time));
-  if (dns_exit_available < MAX_OPEN_TUNNELS)
+  if (dns_exit_available < get_exit_target ())
     try_open_exit ();
 }
 
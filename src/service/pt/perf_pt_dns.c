@@ -0,0 +1,586 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file pt/perf_pt_dns.c
+ * @brief measure the protocol translation daemon: how long DNS replies
+ *        with many addresses wait for their VPN redirections, and how
+ *        fast replies from DNS exits are matched to a large number of
+ *        pending requests.  A real setup (see test_gns_vpn) needs the
+ *        VPN and exit helpers, so we run the daemon in this process and
+ *        stand in for the VPN service (answering every redirection
+ *        after #VPN_DELAY) and for the channels to the local exits
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "gnunet_dns_service.h"
+#include "gnunet_cadet_service.h"
+#include "gnunet_vpn_service.h"
+
+/* we stand in for the VPN service, for the DNS service and for the
+   channels to the exits */
+#define GNUNET_VPN_redirect_to_ip perf_vpn_redirect_to_ip
+#define GNUNET_VPN_cancel_request perf_vpn_cancel_request
+#define GNUNET_DNS_request_answer perf_dns_request_answer
+#define GNUNET_DNS_request_drop perf_dns_request_drop
+#define GNUNET_CADET_channel_create perf_cadet_channel_create
+#define GNUNET_CADET_channel_destroy perf_cadet_channel_destroy
+#define GNUNET_CADET_get_mq perf_cadet_get_mq
+
+static struct GNUNET_VPN_RedirectionRequest *
+perf_vpn_redirect_to_ip (struct GNUNET_VPN_Handle *vh,
+                         int client_af,
+                         int result_af,
+                         const void *addr,
+                         struct GNUNET_TIME_Absolute expiration_time,
+                         GNUNET_VPN_AllocationCallback cb,
+                         void *cb_cls);
+
+static void
+perf_vpn_cancel_request (struct GNUNET_VPN_RedirectionRequest *rr);
+
+static void
+perf_dns_request_answer (struct GNUNET_DNS_RequestHandle *rh,
+                         uint16_t reply_length,
+                         const char *reply);
+
+static void
+perf_dns_request_drop (struct GNUNET_DNS_RequestHandle *rh);
+
+static struct GNUNET_CADET_Channel *
+perf_cadet_channel_create (struct GNUNET_CADET_Handle *h,
+                           void *channel_cls,
+                           const struct GNUNET_PeerIdentity *destination,
+                           const struct GNUNET_HashCode *port,
+                           GNUNET_CADET_WindowSizeEventHandler window_changes,
+                           GNUNET_CADET_DisconnectEventHandler disconnects,
+                           const struct GNUNET_MQ_MessageHandler *handlers);
+
+static void
+perf_cadet_channel_destroy (struct GNUNET_CADET_Channel *channel);
+
+static struct GNUNET_MQ_Handle *
+perf_cadet_get_mq (const struct GNUNET_CADET_Channel *channel);
+
+/* we drive the daemon from here, so we need our own main() */
+#define main gnunet_daemon_pt_main
+#include "gnunet-daemon-pt.c"
+#undef main
+
+/**
+ * How long does the VPN take to answer a redirection request?
+ */
+#define VPN_DELAY GNUNET_TIME_relative_multiply ( \
+    GNUNET_TIME_UNIT_MILLISECONDS, 10)
+
+/**
+ * Number of DNS replies we translate.
+ */
+#define NUM_REPLIES 64
+
+/**
+ * Number of A records per DNS reply.
+ */
+#define NUM_RECORDS 16
+
+/**
+ * Number of DNS requests we send to the exits.
+ */
+#define NUM_QUERIES 50000
+
+/**
+ * Number of DNS exits we know about.
+ */
+#define NUM_EXITS MAX_OPEN_TUNNELS
+
+
+/**
+ * A redirection request to our VPN stand-in.
+ */
+struct GNUNET_VPN_RedirectionRequest
+{
+  /**
+   * Function to call with the result.
+   */
+  GNUNET_VPN_AllocationCallback cb;
+
+  /**
+   * Closure for @e cb.
+   */
+  void *cb_cls;
+
+  /**
+   * Task answering the request.
+   */
+  struct GNUNET_SCHEDULER_Task *task;
+};
+
+
+/**
+ * A DNS request the daemon is processing.
+ */
+struct GNUNET_DNS_RequestHandle
+{
+  /**
+   * When did the daemon get the request?
+   */
+  struct GNUNET_TIME_Absolute start;
+};
+
+
+/**
+ * A channel to one of our local exits.
+ */
+struct GNUNET_CADET_Channel
+{
+  /**
+   * Queue the daemon sends its requests with.
+   */
+  struct GNUNET_MQ_Handle *mq;
+
+  /**
+   * The exit, as the daemon sees it.
+   */
+  struct CadetExit *exit;
+};
+
+
+/**
+ * A request an exit received and is going to answer.
+ */
+struct ExitRequest
+{
+  /**
+   * Exit that received the request.
+   */
+  struct CadetExit *exit;
+
+  /**
+   * DNS ID of the request.
+   */
+  uint16_t dns_id;
+};
+
+
+/**
+ * The address the VPN hands out for every redirection.
+ */
+static struct in_addr vpn_address;
+
+static struct GNUNET_DNS_RequestHandle handles[NUM_QUERIES];
+
+static unsigned int answered;
+
+static unsigned int dropped;
+
+static struct GNUNET_TIME_Relative total_latency;
+
+static struct ExitRequest *exit_requests;
+
+static unsigned int num_exit_requests;
+
+static unsigned int max_exits_open;
+
+static struct GNUNET_TIME_Absolute start;
+
+static int global_ret;
+
+
+static void
+vpn_answer (void *cls)
+{
+  struct GNUNET_VPN_RedirectionRequest *rr = cls;
+
+  rr->task = NULL;
+  rr->cb (rr->cb_cls,
+          AF_INET,
+          &vpn_address);
+  GNUNET_free (rr);
+}
+
+
+static struct GNUNET_VPN_RedirectionRequest *
+perf_vpn_redirect_to_ip (struct GNUNET_VPN_Handle *vh,
+                         int client_af,
+                         int result_af,
+                         const void *addr,
+                         struct GNUNET_TIME_Absolute expiration_time,
+                         GNUNET_VPN_AllocationCallback cb,
+                         void *cb_cls)
+{
+  struct GNUNET_VPN_RedirectionRequest *rr;
+
+  GNUNET_assert (AF_INET == result_af);
+  rr = GNUNET_new (struct GNUNET_VPN_RedirectionRequest);
+  rr->cb = cb;
+  rr->cb_cls = cb_cls;
+  rr->task = GNUNET_SCHEDULER_add_delayed (VPN_DELAY,
+                                           &vpn_answer,
+                                           rr);
+  return rr;
+}
+
+
+static void
+perf_vpn_cancel_request (struct GNUNET_VPN_RedirectionRequest *rr)
+{
+  GNUNET_SCHEDULER_cancel (rr->task);
+  GNUNET_free (rr);
+}
+
+
+static void
+perf_dns_request_drop (struct GNUNET_DNS_RequestHandle *rh)
+{
+  dropped++;
+}
+
+
+static void
+perf_cadet_channel_destroy (struct GNUNET_CADET_Channel *channel)
+{
+  GNUNET_MQ_destroy (channel->mq);
+  GNUNET_free (channel);
+}
+
+
+static struct GNUNET_MQ_Handle *
+perf_cadet_get_mq (const struct GNUNET_CADET_Channel *channel)
+{
+  return channel->mq;
+}
+
+
+static void
+finish (void *cls)
+{
+  printf ("up to %u of %u exits open, %u open when done\n",
+          max_exits_open,
+          (unsigned int) NUM_EXITS,
+          dns_exit_available);
+  if ((max_exits_open <= MIN_OPEN_TUNNELS) ||
+      (MIN_OPEN_TUNNELS != dns_exit_available))
+    global_ret = 1;
+  GNUNET_SCHEDULER_shutdown ();
+}
+
+
+/**
+ * The exits got all our requests, let them answer.
+ */
+static void
+answer_exit_requests (void *cls)
+{
+  struct GNUNET_TIME_Relative dur;
+  struct DnsResponseMessage msg;
+
+  /* the exits answer in random order */
+  for (unsigned int i = num_exit_requests - 1; i > 0; i--)
+  {
+    unsigned int j = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                               i + 1);
+    struct ExitRequest tmp = exit_requests[i];
+
+    exit_requests[i] = exit_requests[j];
+    exit_requests[j] = tmp;
+  }
+  memset (&msg,
+          0,
+          sizeof (msg));
+  msg.header.size = htons (sizeof (msg));
+  msg.header.type = htons (GNUNET_MESSAGE_TYPE_VPN_DNS_FROM_INTERNET);
+  answered = 0;
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < num_exit_requests; i++)
+  {
+    msg.dns.id = exit_requests[i].dns_id;
+    handle_dns_response (exit_requests[i].exit,
+                         &msg);
+  }
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("matched %u DNS replies from exits to pending requests in %s"
+          " (%llu/s)\n",
+          answered,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          answered * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+  if ((NUM_QUERIES != answered) ||
+      (0 != dropped) ||
+      (0 != dns_requests_pending))
+    global_ret = 1;
+  GNUNET_free (exit_requests);
+  num_exit_requests = 0;
+  /* give the daemon a chance to close the exits it no longer needs */
+  GNUNET_SCHEDULER_add_now (&finish,
+                            NULL);
+}
+
+
+/**
+ * The daemon sends a DNS request to one of our exits, which
+ * remembers it to answer it later.
+ */
+static void
+exit_send (struct GNUNET_MQ_Handle *mq,
+           const struct GNUNET_MessageHeader *msg,
+           void *impl_state)
+{
+  struct GNUNET_CADET_Channel *channel = impl_state;
+  struct GNUNET_TUN_DnsHeader dns;
+  struct ExitRequest er;
+
+  GNUNET_memcpy (&dns,
+                 &msg[1],
+                 sizeof (dns));
+  er.exit = channel->exit;
+  er.dns_id = dns.id;
+  GNUNET_array_append (exit_requests,
+                       num_exit_requests,
+                       er);
+  GNUNET_MQ_impl_send_continue (mq);
+  if (NUM_QUERIES == num_exit_requests)
+    GNUNET_SCHEDULER_add_now (&answer_exit_requests,
+                              NULL);
+}
+
+
+static void
+exit_destroy (struct GNUNET_MQ_Handle *mq,
+              void *impl_state)
+{
+}
+
+
+static void
+exit_cancel (struct GNUNET_MQ_Handle *mq,
+             void *impl_state)
+{
+  GNUNET_assert (0);
+}
+
+
+static struct GNUNET_CADET_Channel *
+perf_cadet_channel_create (struct GNUNET_CADET_Handle *h,
+                           void *channel_cls,
+                           const struct GNUNET_PeerIdentity *destination,
+                           const struct GNUNET_HashCode *port,
+                           GNUNET_CADET_WindowSizeEventHandler window_changes,
+                           GNUNET_CADET_DisconnectEventHandler disconnects,
+                           const struct GNUNET_MQ_MessageHandler *handlers)
+{
+  struct GNUNET_CADET_Channel *channel;
+
+  channel = GNUNET_new (struct GNUNET_CADET_Channel);
+  channel->exit = channel_cls;
+  channel->mq = GNUNET_MQ_queue_for_callbacks (&exit_send,
+                                               &exit_destroy,
+                                               &exit_cancel,
+                                               channel,
+                                               NULL,
+                                               NULL,
+                                               NULL);
+  return channel;
+}
+
+
+/**
+ * Send #NUM_QUERIES DNS requests through the exits, then let the
+ * exits answer all of them.
+ */
+static void
+perf_exits (void)
+{
+  struct GNUNET_TIME_Relative dur;
+  struct GNUNET_TUN_DnsHeader dns;
+
+  dns_channel = GNUNET_YES;
+  for (unsigned int i = 0; i < NUM_EXITS; i++)
+  {
+    struct CadetExit *exit;
+
+    exit = GNUNET_new (struct CadetExit);
+    GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_WEAK,
+                                &exit->peer,
+                                sizeof (exit->peer));
+    exit->receive_queue = GNUNET_CONTAINER_multihashmap32_create (32);
+    exit->expiration = GNUNET_TIME_UNIT_FOREVER_ABS;
+    GNUNET_CONTAINER_DLL_insert_tail (exit_head,
+                                      exit_tail,
+                                      exit);
+    dns_exit_known++;
+    if (dns_exit_available < get_exit_target ())
+      try_open_exit ();
+  }
+  max_exits_open = dns_exit_available;
+  memset (&dns,
+          0,
+          sizeof (dns));
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_QUERIES; i++)
+  {
+    /* many requests share a DNS ID */
+    dns.id = htons ((uint16_t) GNUNET_CRYPTO_random_u32 (
+                      GNUNET_CRYPTO_QUALITY_WEAK,
+                      UINT16_MAX + 1));
+    dns_pre_request_handler (NULL,
+                             &handles[i],
+                             sizeof (dns),
+                             (const char *) &dns);
+    max_exits_open = GNUNET_MAX (max_exits_open,
+                                 dns_exit_available);
+  }
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("queued %u DNS requests for exits in %s (%llu/s)\n",
+          (unsigned int) NUM_QUERIES,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          NUM_QUERIES * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+static void
+perf_dns_request_answer (struct GNUNET_DNS_RequestHandle *rh,
+                         uint16_t reply_length,
+                         const char *reply)
+{
+  struct GNUNET_DNSPARSER_Packet *p;
+  struct GNUNET_TIME_Relative dur;
+
+  answered++;
+  if (dns_channel)
+    return; /* replies from exits are passed on as they are */
+  total_latency = GNUNET_TIME_relative_add (
+    total_latency,
+    GNUNET_TIME_absolute_get_duration (rh->start));
+  p = GNUNET_DNSPARSER_parse (reply,
+                              reply_length);
+  if ((NULL == p) ||
+      (NUM_RECORDS != p->num_answers))
+  {
+    global_ret = 1;
+  }
+  else
+  {
+    for (unsigned int i = 0; i < p->num_answers; i++)
+      if (0 != memcmp (p->answers[i].data.raw.data,
+                       &vpn_address,
+                       sizeof (vpn_address)))
+        global_ret = 1;
+  }
+  if (NULL != p)
+    GNUNET_DNSPARSER_free_packet (p);
+  if (NUM_REPLIES != answered)
+    return;
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("translated %u DNS replies with %u addresses each in %s"
+          " (%llu/s), average latency %s\n",
+          answered,
+          (unsigned int) NUM_RECORDS,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          answered * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us),
+          GNUNET_STRINGS_relative_time_to_string (
+            GNUNET_TIME_relative_divide (total_latency,
+                                         answered),
+            GNUNET_YES));
+  perf_exits ();
+}
+
+
+/**
+ * Have the daemon translate #NUM_REPLIES DNS replies with
+ * #NUM_RECORDS addresses each.
+ */
+static void
+perf_translate (void *cls)
+{
+  struct GNUNET_DNSPARSER_Packet p;
+  struct GNUNET_DNSPARSER_Query q;
+  struct GNUNET_DNSPARSER_Record records[NUM_RECORDS];
+  uint32_t addresses[NUM_RECORDS];
+  char *buf;
+  size_t buf_len;
+
+  ipv4_pt = GNUNET_YES;
+  GNUNET_assert (1 == inet_pton (AF_INET,
+                                 "169.254.86.1",
+                                 &vpn_address));
+  memset (&p,
+          0,
+          sizeof (p));
+  memset (&q,
+          0,
+          sizeof (q));
+  memset (records,
+          0,
+          sizeof (records));
+  q.name = "perf.gnunet.org";
+  q.type = GNUNET_DNSPARSER_TYPE_A;
+  q.dns_traffic_class = GNUNET_TUN_DNS_CLASS_INTERNET;
+  for (unsigned int i = 0; i < NUM_RECORDS; i++)
+  {
+    addresses[i] = htonl (0xc0000200 + i); /* 192.0.2.0/24 */
+    records[i].name = q.name;
+    records[i].type = GNUNET_DNSPARSER_TYPE_A;
+    records[i].dns_traffic_class = GNUNET_TUN_DNS_CLASS_INTERNET;
+    records[i].expiration_time =
+      GNUNET_TIME_relative_to_absolute (GNUNET_TIME_UNIT_HOURS);
+    records[i].data.raw.data = &addresses[i];
+    records[i].data.raw.data_len = sizeof (addresses[i]);
+  }
+  p.queries = &q;
+  p.num_queries = 1;
+  p.answers = records;
+  p.num_answers = NUM_RECORDS;
+  p.flags.query_or_response = 1;
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_DNSPARSER_pack (&p,
+                                        MAX_DNS_SIZE,
+                                        &buf,
+                                        &buf_len));
+  GNUNET_SCHEDULER_add_shutdown (&cleanup,
+                                 NULL);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int i = 0; i < NUM_REPLIES; i++)
+  {
+    handles[i].start = GNUNET_TIME_absolute_get ();
+    dns_post_request_handler (NULL,
+                              &handles[i],
+                              buf_len,
+                              buf);
+  }
+  GNUNET_free (buf);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  GNUNET_log_setup ("perf-pt-dns",
+                    "WARNING",
+                    NULL);
+  GNUNET_SCHEDULER_run (&perf_translate,
+                        NULL);
+  return global_ret;
+}
+
+
+/* end of perf_pt_dns.c */
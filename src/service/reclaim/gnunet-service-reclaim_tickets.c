@@ -265,6 +265,32 @@ struct RevokedAttributeEntry
    * New ID of the attribute
    */
   struct GNUNET_RECLAIM_Identifier new_id;
+
+  /**
+   * Label of the attribute record set under the old ID
+   */
+  char *old_label;
+
+  /**
+   * Label of the attribute record set under the new ID,
+   * NULL if the attribute was not found in the zone
+   */
+  char *new_label;
+
+  /**
+   * Serialized, re-keyed attribute record set
+   */
+  char *data;
+
+  /**
+   * Size of @e data
+   */
+  size_t data_size;
+
+  /**
+   * Number of records in @e data
+   */
+  unsigned int rd_count;
 };
 
 
@@ -314,9 +340,9 @@ struct RECLAIM_TICKETS_RevokeHandle
   struct RevokedAttributeEntry *attrs_tail;
 
   /**
-   * Current attribute to move
+   * Revoked attributes by hash of their old ID
    */
-  struct RevokedAttributeEntry *move_attr;
+  struct GNUNET_CONTAINER_MultiHashMap *attrs_map;
 
   /**
    * Number of attributes in ticket
@@ -332,6 +358,26 @@ struct RECLAIM_TICKETS_RevokeHandle
    * Tickets to update
    */
   struct TicketRecordsEntry *tickets_to_update_tail;
+
+  /**
+   * Record sets to store in bulk once the zone was scanned
+   */
+  struct GNUNET_NAMESTORE_RecordInfo *ri;
+
+  /**
+   * Number of entries in @e ri
+   */
+  unsigned int ri_count;
+
+  /**
+   * Number of entries in @e ri already sent to the namestore
+   */
+  unsigned int ri_pos;
+
+  /**
+   * When did we start the revocation
+   */
+  struct GNUNET_TIME_Absolute revocation_start_time;
 };
 
 
@@ -368,15 +414,23 @@ cleanup_rvk (struct RECLAIM_TICKETS_RevokeHandle *rh)
     GNUNET_NAMESTORE_cancel (rh->ns_qe);
   if (NULL != rh->ns_it)
     GNUNET_NAMESTORE_zone_iteration_stop (rh->ns_it);
+  for (unsigned int i = 0; i < rh->ri_count; i++)
+    GNUNET_free (rh->ri[i].a_rd);
+  GNUNET_free (rh->ri);
+  if (NULL != rh->attrs_map)
+    GNUNET_CONTAINER_multihashmap_destroy (rh->attrs_map);
   while (NULL != (ae = rh->attrs_head))
   {
     GNUNET_CONTAINER_DLL_remove (rh->attrs_head, rh->attrs_tail, ae);
+    GNUNET_free (ae->old_label);
+    GNUNET_free (ae->new_label);
+    GNUNET_free (ae->data);
     GNUNET_free (ae);
   }
   while (NULL != (le = rh->tickets_to_update_head))
   {
     GNUNET_CONTAINER_DLL_remove (rh->tickets_to_update_head,
-                                 rh->tickets_to_update_head,
+                                 rh->tickets_to_update_tail,
                                  le);
     if (NULL != le->data)
       GNUNET_free (le->data);
@@ -389,165 +443,25 @@ cleanup_rvk (struct RECLAIM_TICKETS_RevokeHandle *rh)
 
 
 /**
- * For each ticket, store new, updated attribute references
- * (Implementation further below)
- *
- * @param cls handle to the operation
- */
-static void
-process_tickets (void *cls);
-
-
-/**
- * Finished storing updated attribute references.
- * Abort on error, else continue processing tickets
- *
- * @param cls handle to the operation
- * @param success result of namestore operation
- * @param emsg (NULL on success)
- */
-static void
-ticket_processed (void *cls, enum GNUNET_ErrorCode ec)
-{
-  struct RECLAIM_TICKETS_RevokeHandle *rvk = cls;
-
-  rvk->ns_qe = NULL;
-  GNUNET_SCHEDULER_add_now (&process_tickets, rvk);
-}
-
-
-/**
- * For each ticket, store new, updated attribute references
- *
- * @param cls handle to the operation
- */
-static void
-process_tickets (void *cls)
-{
-  struct RECLAIM_TICKETS_RevokeHandle *rvk = cls;
-  struct TicketRecordsEntry *le;
-  struct RevokedAttributeEntry *ae;
-
-  if (NULL == rvk->tickets_to_update_head)
-  {
-    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                "Finished updatding tickets, success\n");
-    rvk->cb (rvk->cb_cls, GNUNET_OK);
-    cleanup_rvk (rvk);
-    return;
-  }
-  le = rvk->tickets_to_update_head;
-  GNUNET_CONTAINER_DLL_remove (rvk->tickets_to_update_head,
-                               rvk->tickets_to_update_tail,
-                               le);
-  {
-    struct GNUNET_GNSRECORD_Data rd[le->rd_count];
-    if (GNUNET_OK != GNUNET_GNSRECORD_records_deserialize (le->data_size,
-                                                           le->data,
-                                                           le->rd_count,
-                                                           rd))
-    {
-      GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
-                  "Unable to deserialize ticket record(s)\n");
-      rvk->cb (rvk->cb_cls, GNUNET_SYSERR);
-      cleanup_rvk (rvk);
-      return;
-    }
-    for (int i = 0; i < le->rd_count; i++)
-    {
-      if (GNUNET_GNSRECORD_TYPE_RECLAIM_ATTRIBUTE_REF != rd[i].record_type)
-        continue;
-      for (ae = rvk->attrs_head; NULL != ae; ae = ae->next)
-      {
-        if (0 != memcmp (rd[i].data, &ae->old_id, sizeof(ae->old_id)))
-          continue;
-        rd[i].data = &ae->new_id;
-      }
-    }
-    rvk->ns_qe = GNUNET_NAMESTORE_record_set_store (nsh,
-                                                    &rvk->identity,
-                                                    le->label,
-                                                    le->rd_count,
-                                                    rd,
-                                                    &ticket_processed,
-                                                    rvk);
-  }
-  GNUNET_free (le->label);
-  GNUNET_free (le->data);
-  GNUNET_free (le);
-}
-
-
-/**
- * Done collecting tickets. Start processing.
- *
- * @param cls handle to the operation
- */
-static void
-rvk_ticket_update_finished (void *cls)
-{
-  struct RECLAIM_TICKETS_RevokeHandle *rvk = cls;
-
-  rvk->ns_it = NULL;
-  GNUNET_SCHEDULER_add_now (&process_tickets, rvk);
-}
-
-
-/**
- * We need to update all other tickets with the new attribute IDs.
- * We first collect them all. Processing after.
+ * Find the revoked attribute entry for an attribute ID.
  *
- * @param cls handle to the operation
- * @param zone ticket issuer private key
- * @param label ticket rnd
- * @param rd_count size of record set
- * @param rd record set
+ * @param rvk handle to the operation
+ * @param id the (old) attribute ID
+ * @return NULL if the attribute is not revoked by @a rvk
  */
-static void
-rvk_ticket_update (void *cls,
-                   const struct GNUNET_CRYPTO_PrivateKey *zone,
-                   const char *label,
-                   unsigned int rd_count,
-                   const struct GNUNET_GNSRECORD_Data *rd)
+static struct RevokedAttributeEntry *
+lookup_revoked_attr (struct RECLAIM_TICKETS_RevokeHandle *rvk,
+                     const struct GNUNET_RECLAIM_Identifier *id)
 {
-  struct RECLAIM_TICKETS_RevokeHandle *rvk = cls;
-  struct TicketRecordsEntry *le;
-  struct RevokedAttributeEntry *ae;
-  int has_changed = GNUNET_NO;
+  struct GNUNET_HashCode key;
 
-  /** Let everything point to the old record **/
-  for (int i = 0; i < rd_count; i++)
-  {
-    if (GNUNET_GNSRECORD_TYPE_RECLAIM_ATTRIBUTE_REF != rd[i].record_type)
-      continue;
-    for (ae = rvk->attrs_head; NULL != ae; ae = ae->next)
-    {
-      if (0 != memcmp (rd[i].data, &ae->old_id, sizeof(ae->old_id)))
-        continue;
-      has_changed = GNUNET_YES;
-      break;
-    }
-    if (GNUNET_YES == has_changed)
-      break;
-  }
-  if (GNUNET_YES == has_changed)
-  {
-    le = GNUNET_new (struct TicketRecordsEntry);
-    le->data_size = GNUNET_GNSRECORD_records_get_size (rd_count, rd);
-    le->data = GNUNET_malloc (le->data_size);
-    le->rd_count = rd_count;
-    le->label = GNUNET_strdup (label);
-    GNUNET_GNSRECORD_records_serialize (rd_count, rd, le->data_size, le->data);
-    GNUNET_CONTAINER_DLL_insert (rvk->tickets_to_update_head,
-                                 rvk->tickets_to_update_tail,
-                                 le);
-  }
-  GNUNET_NAMESTORE_zone_iterator_next (rvk->ns_it, 1);
+  GNUNET_CRYPTO_hash (id, sizeof(*id), &key);
+  return GNUNET_CONTAINER_multihashmap_get (rvk->attrs_map, &key);
 }
 
 
 /**
- * Error iterating namestore. Abort.
+ * Error iterating or storing in namestore. Abort.
  *
  * @param cls handle to the operation
  */
@@ -563,55 +477,24 @@ rvk_ns_iter_err (void *cls)
 
 
 /**
- * Error storing new attribute in namestore. Abort
- *
- * @param cls handle to the operation
- */
-static void
-rvk_ns_err (void *cls)
-{
-  struct RECLAIM_TICKETS_RevokeHandle *rvk = cls;
-
-  rvk->ns_qe = NULL;
-  rvk->cb (rvk->cb_cls, GNUNET_SYSERR);
-  cleanup_rvk (rvk);
-}
-
-
-/**
- * We change every attribute ID of the ticket attributes we
- * want to revoke.
- * When we are done, we need to update any other ticket which
- * included references to any of the changed attributes.
- *
- * @param rh handle to the operation
- */
-static void
-move_attrs (struct RECLAIM_TICKETS_RevokeHandle *rh);
-
-
-/**
- * Delayed continuation for move_attrs
+ * Send the next batch of record sets to the namestore.
+ * When all record sets are stored, the revocation is complete.
  *
- * @param cls handle to the operation.
+ * @param rvk handle to the operation
  */
 static void
-move_attrs_cont (void *cls)
-{
-  move_attrs ((struct RECLAIM_TICKETS_RevokeHandle *) cls);
-}
+store_next_batch (struct RECLAIM_TICKETS_RevokeHandle *rvk);
 
 
 /**
- * Done deleting the old record. Abort on error.
- * Else, continue updating attribute IDs.
+ * Finished storing a batch of record sets.
+ * Abort on error, else continue with the next batch.
  *
  * @param cls handle to the operation
- * @param success result of the namestore operation
- * @param emsg error message (NULL on success)
+ * @param ec result of namestore operation
  */
 static void
-del_attr_finished (void *cls, enum GNUNET_ErrorCode ec)
+batch_stored_cb (void *cls, enum GNUNET_ErrorCode ec)
 {
   struct RECLAIM_TICKETS_RevokeHandle *rvk = cls;
 
@@ -619,193 +502,350 @@ del_attr_finished (void *cls, enum GNUNET_ErrorCode ec)
   if (GNUNET_EC_NONE != ec)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
-                "Error removing attribute: %s\n",
+                "Error storing revoked attributes and tickets: %s\n",
                 GNUNET_ErrorCode_get_hint (ec));
     rvk->cb (rvk->cb_cls, GNUNET_SYSERR);
     cleanup_rvk (rvk);
     return;
   }
-  rvk->move_attr = rvk->move_attr->next;
-  GNUNET_SCHEDULER_add_now (&move_attrs_cont, rvk);
+  store_next_batch (rvk);
 }
 
 
-/**
- * Updated an attribute ID.
- * Abort on error if namestore operation failed.
- * Else, we have to delete the old record.
- *
- * @param cls handle to the operation
- * @param success result of the store operation
- * @param emsg error message (NULL on success)
- */
 static void
-move_attr_finished (void *cls, enum GNUNET_ErrorCode ec)
+store_next_batch (struct RECLAIM_TICKETS_RevokeHandle *rvk)
 {
-  struct RECLAIM_TICKETS_RevokeHandle *rvk = cls;
-  char *label;
+  unsigned int sent;
 
-  rvk->ns_qe = NULL;
-  if (GNUNET_EC_NONE != ec)
+  if (rvk->ri_pos == rvk->ri_count)
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "Finished updating attributes and tickets, success\n");
+    GNUNET_STATISTICS_update (stats,
+                              "reclaim_revocation_time_total",
+                              GNUNET_TIME_absolute_get_duration (
+                                rvk->revocation_start_time)
+                              .rel_value_us,
+                              GNUNET_YES);
+    GNUNET_STATISTICS_update (stats,
+                              "reclaim_revocations_count",
+                              1,
+                              GNUNET_YES);
+    GNUNET_STATISTICS_update (stats,
+                              "reclaim_revocation_record_sets_stored",
+                              rvk->ri_count,
+                              GNUNET_YES);
+    rvk->cb (rvk->cb_cls, GNUNET_OK);
+    cleanup_rvk (rvk);
+    return;
+  }
+  sent = 0;
+  rvk->ns_qe = GNUNET_NAMESTORE_records_store (nsh,
+                                               &rvk->identity,
+                                               rvk->ri_count - rvk->ri_pos,
+                                               &rvk->ri[rvk->ri_pos],
+                                               &sent,
+                                               &batch_stored_cb,
+                                               rvk);
+  if ((NULL == rvk->ns_qe) || (0 == sent))
   {
     GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
-                "Error moving attribute: %s\n",
-                GNUNET_ErrorCode_get_hint (ec));
+                "Unable to store record set `%s'\n",
+                rvk->ri[rvk->ri_pos].a_label);
     rvk->cb (rvk->cb_cls, GNUNET_SYSERR);
     cleanup_rvk (rvk);
     return;
   }
-  label = GNUNET_STRINGS_data_to_string_alloc (&rvk->move_attr->old_id,
-                                               sizeof(rvk->move_attr->old_id));
-  GNUNET_assert (NULL != label);
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Removing attribute %s\n", label);
-  rvk->ns_qe = GNUNET_NAMESTORE_record_set_store (nsh,
-                                                  &rvk->identity,
-                                                  label,
-                                                  0,
-                                                  NULL,
-                                                  &del_attr_finished,
-                                                  rvk);
-  GNUNET_free (label);
+  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+              "Storing %u of %u remaining record sets\n",
+              sent,
+              rvk->ri_count - rvk->ri_pos);
+  rvk->ri_pos += sent;
+}
+
+
+/**
+ * Deserialize a record set into a freshly allocated record array
+ * for a bulk store.
+ *
+ * @param data serialized record set
+ * @param data_size size of @a data
+ * @param rd_count number of records in @a data
+ * @param[out] ri record info to initialize
+ * @return #GNUNET_OK on success
+ */
+static enum GNUNET_GenericReturnValue
+deserialize_record_info (const char *data,
+                         size_t data_size,
+                         unsigned int rd_count,
+                         struct GNUNET_NAMESTORE_RecordInfo *ri)
+{
+  ri->a_rd_count = rd_count;
+  ri->a_rd = NULL;
+  if (0 == rd_count)
+    return GNUNET_OK;
+  ri->a_rd = GNUNET_new_array (rd_count,
+                               struct GNUNET_GNSRECORD_Data);
+  return GNUNET_GNSRECORD_records_deserialize (data_size,
+                                               data,
+                                               rd_count,
+                                               ri->a_rd);
 }
 
 
 /**
- * Got the referenced attribute. Updating the ID
+ * Done scanning the zone. Build all new attribute record sets,
+ * the updated ticket record sets and the deletions of the old
+ * attributes, in this order, and store them in bulk.
  *
  * @param cls handle to the operation
- * @param zone issuer identity
- * @param label attribute ID
- * @param rd_count size of record set (should be 1)
- * @param rd record set (the attribute)
  */
 static void
-rvk_move_attr_cb (void *cls,
-                  const struct GNUNET_CRYPTO_PrivateKey *zone,
-                  const char *label,
-                  unsigned int rd_count,
-                  const struct GNUNET_GNSRECORD_Data *rd)
+rvk_collect_finished (void *cls)
 {
   struct RECLAIM_TICKETS_RevokeHandle *rvk = cls;
-  struct GNUNET_GNSRECORD_Data new_rd[rd_count];
-  struct RevokedAttributeEntry *le;
-  char *new_label;
-  char *attr_data;
+  struct RevokedAttributeEntry *ae;
+  struct TicketRecordsEntry *le;
+  struct GNUNET_NAMESTORE_RecordInfo *ri;
+  unsigned int cnt;
 
-  rvk->ns_qe = NULL;
-  if (0 == rd_count)
+  rvk->ns_it = NULL;
+  cnt = 0;
+  for (ae = rvk->attrs_head; NULL != ae; ae = ae->next)
+    if (NULL != ae->new_label)
+      cnt += 2;
+  for (le = rvk->tickets_to_update_head; NULL != le; le = le->next)
+    cnt++;
+  rvk->ri = GNUNET_new_array (cnt,
+                              struct GNUNET_NAMESTORE_RecordInfo);
+  rvk->ri_count = 0;
+  /**
+   * The record sets may not fit into a single namestore message
+   * and each message is a transaction of its own.  We thus store
+   * the attributes under their new IDs first, then let the tickets
+   * point to them and only remove the old attributes last: if a
+   * batch fails, every ticket still references an existing
+   * attribute.
+   */
+  /** Store attributes under new IDs **/
+  for (ae = rvk->attrs_head; NULL != ae; ae = ae->next)
   {
-    GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
-                "The claim %s no longer exists!\n",
-                label);
-    le = rvk->move_attr;
-    rvk->move_attr = le->next;
-    GNUNET_CONTAINER_DLL_remove (rvk->attrs_head, rvk->attrs_tail, le);
-    GNUNET_free (le);
-    GNUNET_SCHEDULER_add_now (&move_attrs_cont, rvk);
-    return;
+    if (NULL == ae->new_label)
+    {
+      GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
+                  "The claim %s no longer exists!\n",
+                  ae->old_label);
+      continue;
+    }
+    ri = &rvk->ri[rvk->ri_count++];
+    ri->a_label = ae->new_label;
+    if (GNUNET_OK != deserialize_record_info (ae->data,
+                                              ae->data_size,
+                                              ae->rd_count,
+                                              ri))
+      goto deserialize_error;
+  }
+  /** Let every other ticket point to the new IDs **/
+  for (le = rvk->tickets_to_update_head; NULL != le; le = le->next)
+  {
+    ri = &rvk->ri[rvk->ri_count++];
+    ri->a_label = le->label;
+    if (GNUNET_OK != deserialize_record_info (le->data,
+                                              le->data_size,
+                                              le->rd_count,
+                                              ri))
+      goto deserialize_error;
+    for (unsigned int i = 0; i < ri->a_rd_count; i++)
+    {
+      if (GNUNET_GNSRECORD_TYPE_RECLAIM_ATTRIBUTE_REF !=
+          ri->a_rd[i].record_type)
+        continue;
+      if (sizeof (struct GNUNET_RECLAIM_Identifier) != ri->a_rd[i].data_size)
+        continue;
+      ae = lookup_revoked_attr (rvk, ri->a_rd[i].data);
+      if ((NULL == ae) || (NULL == ae->new_label))
+        continue;
+      ri->a_rd[i].data = &ae->new_id;
+    }
+  }
+  /** Remove the attributes under their old IDs **/
+  for (ae = rvk->attrs_head; NULL != ae; ae = ae->next)
+  {
+    if (NULL == ae->new_label)
+      continue;
+    ri = &rvk->ri[rvk->ri_count++];
+    ri->a_label = ae->old_label;
+    ri->a_rd_count = 0;
+    ri->a_rd = NULL;
   }
-  GNUNET_RECLAIM_id_generate (&rvk->move_attr->new_id);
-  new_label =
-    GNUNET_STRINGS_data_to_string_alloc (&rvk->move_attr->new_id,
-                                         sizeof (rvk->move_attr->new_id));
+  GNUNET_assert (cnt == rvk->ri_count);
+  store_next_batch (rvk);
+  return;
 
-  attr_data = NULL;
-  // new_rd = *rd;
-  for (int i = 0; i < rd_count; i++)
+deserialize_error:
+  GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+              "Unable to deserialize record set `%s'\n",
+              ri->a_label);
+  rvk->cb (rvk->cb_cls, GNUNET_SYSERR);
+  cleanup_rvk (rvk);
+}
+
+
+/**
+ * Give a revoked attribute a new ID.  Re-encodes every attribute
+ * and credential record of the record set with the new ID and keeps
+ * the serialized result for the bulk store.
+ *
+ * @param ae the revoked attribute
+ * @param rd_count size of record set
+ * @param rd record set (the attribute)
+ */
+static void
+rekey_attribute (struct RevokedAttributeEntry *ae,
+                 unsigned int rd_count,
+                 const struct GNUNET_GNSRECORD_Data *rd)
+{
+  struct GNUNET_GNSRECORD_Data new_rd[GNUNET_NZL (rd_count)];
+  char *attr_data[GNUNET_NZL (rd_count)];
+  ssize_t len;
+
+  GNUNET_RECLAIM_id_generate (&ae->new_id);
+  ae->new_label =
+    GNUNET_STRINGS_data_to_string_alloc (&ae->new_id,
+                                         sizeof (ae->new_id));
+  for (unsigned int i = 0; i < rd_count; i++)
   {
+    new_rd[i] = rd[i];
+    attr_data[i] = NULL;
     if (GNUNET_GNSRECORD_TYPE_RECLAIM_ATTRIBUTE == rd[i].record_type)
     {
       /** find a new place for this attribute **/
       struct GNUNET_RECLAIM_Attribute *claim;
-      GNUNET_RECLAIM_attribute_deserialize (rd[i].data,
-                                            rd[i].data_size,
-                                            &claim);
+
+      if (0 > GNUNET_RECLAIM_attribute_deserialize (rd[i].data,
+                                                    rd[i].data_size,
+                                                    &claim))
+      {
+        GNUNET_break (0);
+        continue;
+      }
       GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                   "Attribute to update: Name=%s\n",
                   claim->name);
-      claim->id = rvk->move_attr->new_id;
-      new_rd[i].data_size = GNUNET_RECLAIM_attribute_serialize_get_size (claim);
-      attr_data = GNUNET_malloc (rd[i].data_size);
+      claim->id = ae->new_id;
+      attr_data[i] =
+        GNUNET_malloc (GNUNET_RECLAIM_attribute_serialize_get_size (claim));
       new_rd[i].data_size = GNUNET_RECLAIM_attribute_serialize (claim,
-                                                                attr_data);
-      new_rd[i].data = attr_data;
-      new_rd[i].record_type = rd[i].record_type;
-      new_rd[i].flags = rd[i].flags;
-      new_rd[i].expiration_time = rd[i].expiration_time;
-      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Adding attribute %s\n", new_label);
+                                                                attr_data[i]);
+      new_rd[i].data = attr_data[i];
       GNUNET_free (claim);
     }
     else if (GNUNET_GNSRECORD_TYPE_RECLAIM_CREDENTIAL == rd[i].record_type)
     {
       struct GNUNET_RECLAIM_Credential *credential;
+
       credential = GNUNET_RECLAIM_credential_deserialize (rd[i].data,
                                                           rd[i].data_size);
+      if (NULL == credential)
+      {
+        GNUNET_break (0);
+        continue;
+      }
       GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                   "Credential to update: Name=%s\n",
                   credential->name);
-      credential->id = rvk->move_attr->new_id;
-      new_rd[i].data_size =
-        GNUNET_RECLAIM_credential_serialize_get_size (credential);
-      attr_data = GNUNET_malloc (rd[i].data_size);
+      credential->id = ae->new_id;
+      attr_data[i] = GNUNET_malloc (
+        GNUNET_RECLAIM_credential_serialize_get_size (credential));
       new_rd[i].data_size = GNUNET_RECLAIM_credential_serialize (credential,
-                                                                 attr_data);
-      new_rd[i].data = attr_data;
-      new_rd[i].record_type = rd[i].record_type;
-      new_rd[i].flags = rd[i].flags;
-      new_rd[i].expiration_time = rd[i].expiration_time;
-      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Adding credential %s\n",
-                  new_label);
+                                                                 attr_data[i]);
+      new_rd[i].data = attr_data[i];
       GNUNET_free (credential);
     }
-    else
-    {
-      memcpy (&new_rd[i], &rd[i], sizeof (struct GNUNET_GNSRECORD_Data));
-    }
   }
-  rvk->ns_qe = GNUNET_NAMESTORE_record_set_store (nsh,
-                                                  &rvk->identity,
-                                                  new_label,
-                                                  rd_count,
-                                                  new_rd,
-                                                  &move_attr_finished,
-                                                  rvk);
-  GNUNET_free (new_label);
-  GNUNET_free (attr_data);
+  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+              "Moving claim %s to %s\n",
+              ae->old_label,
+              ae->new_label);
+  len = GNUNET_GNSRECORD_records_get_size (rd_count, new_rd);
+  GNUNET_assert (0 <= len);
+  ae->data_size = len;
+  ae->data = GNUNET_malloc (GNUNET_NZL (ae->data_size));
+  ae->rd_count = rd_count;
+  GNUNET_assert (len ==
+                 GNUNET_GNSRECORD_records_serialize (rd_count,
+                                                     new_rd,
+                                                     ae->data_size,
+                                                     ae->data));
+  for (unsigned int i = 0; i < rd_count; i++)
+    GNUNET_free (attr_data[i]);
 }
 
 
+/**
+ * We scan the zone once for both the attributes we need to move
+ * and the tickets which reference them.  The attributes are
+ * re-keyed right away; the tickets are only collected as the new
+ * IDs may not be known yet.
+ *
+ * @param cls handle to the operation
+ * @param zone ticket issuer private key
+ * @param label record set label
+ * @param rd_count size of record set
+ * @param rd record set
+ */
 static void
-move_attrs (struct RECLAIM_TICKETS_RevokeHandle *rvk)
+rvk_collect_cb (void *cls,
+                const struct GNUNET_CRYPTO_PrivateKey *zone,
+                const char *label,
+                unsigned int rd_count,
+                const struct GNUNET_GNSRECORD_Data *rd)
 {
-  char *label;
+  struct RECLAIM_TICKETS_RevokeHandle *rvk = cls;
+  struct GNUNET_RECLAIM_Identifier id;
+  struct RevokedAttributeEntry *ae;
+  struct TicketRecordsEntry *le;
+  int has_changed = GNUNET_NO;
 
-  if (NULL == rvk->move_attr)
+  if (GNUNET_OK ==
+      GNUNET_STRINGS_string_to_data (label,
+                                     strlen (label),
+                                     &id,
+                                     sizeof (id)))
   {
-    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Finished moving attributes\n");
-    rvk->ns_it =
-      GNUNET_NAMESTORE_zone_iteration_start (nsh,
-                                             &rvk->identity,
-                                             &rvk_ns_iter_err,
-                                             rvk,
-                                             &rvk_ticket_update,
-                                             rvk,
-                                             &rvk_ticket_update_finished,
-                                             rvk);
-    return;
+    ae = lookup_revoked_attr (rvk, &id);
+    if ((NULL != ae) && (NULL == ae->new_label) && (0 < rd_count))
+    {
+      rekey_attribute (ae, rd_count, rd);
+      GNUNET_NAMESTORE_zone_iterator_next (rvk->ns_it, 1);
+      return;
+    }
   }
-  label = GNUNET_STRINGS_data_to_string_alloc (&rvk->move_attr->old_id,
-                                               sizeof (rvk->move_attr->old_id));
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Moving claim %s\n", label);
-
-  rvk->ns_qe = GNUNET_NAMESTORE_records_lookup (nsh,
-                                                &rvk->identity,
-                                                label,
-                                                &rvk_ns_err,
-                                                rvk,
-                                                &rvk_move_attr_cb,
-                                                rvk);
-  GNUNET_free (label);
+  /** Let everything point to the old record **/
+  for (unsigned int i = 0; i < rd_count; i++)
+  {
+    if (GNUNET_GNSRECORD_TYPE_RECLAIM_ATTRIBUTE_REF != rd[i].record_type)
+      continue;
+    if (sizeof (id) != rd[i].data_size)
+      continue;
+    if (NULL == lookup_revoked_attr (rvk, rd[i].data))
+      continue;
+    has_changed = GNUNET_YES;
+    break;
+  }
+  if (GNUNET_YES == has_changed)
+  {
+    le = GNUNET_new (struct TicketRecordsEntry);
+    le->data_size = GNUNET_GNSRECORD_records_get_size (rd_count, rd);
+    le->data = GNUNET_malloc (le->data_size);
+    le->rd_count = rd_count;
+    le->label = GNUNET_strdup (label);
+    GNUNET_GNSRECORD_records_serialize (rd_count, rd, le->data_size, le->data);
+    GNUNET_CONTAINER_DLL_insert (rvk->tickets_to_update_head,
+                                 rvk->tickets_to_update_tail,
+                                 le);
+  }
+  GNUNET_NAMESTORE_zone_iterator_next (rvk->ns_it, 1);
 }
 
 
@@ -817,8 +857,7 @@ move_attrs (struct RECLAIM_TICKETS_RevokeHandle *rvk)
  * possible.
  *
  * @param cls handle to the operation
- * @param success Namestore operation return value
- * @param emsg error message (NULL on success)
+ * @param ec Namestore operation return value
  */
 static void
 remove_ticket_cont (void *cls, enum GNUNET_ErrorCode ec)
@@ -843,8 +882,15 @@ remove_ticket_cont (void *cls, enum GNUNET_ErrorCode ec)
     cleanup_rvk (rvk);
     return;
   }
-  rvk->move_attr = rvk->attrs_head;
-  move_attrs (rvk);
+  rvk->ns_it =
+    GNUNET_NAMESTORE_zone_iteration_start (nsh,
+                                           &rvk->identity,
+                                           &rvk_ns_iter_err,
+                                           rvk,
+                                           &rvk_collect_cb,
+                                           rvk,
+                                           &rvk_collect_finished,
+                                           rvk);
 }
 
 
@@ -868,6 +914,7 @@ revoke_attrs_cb (void *cls,
 {
   struct RECLAIM_TICKETS_RevokeHandle *rvk = cls;
   struct RevokedAttributeEntry *le;
+  struct GNUNET_HashCode key;
 
   rvk->ns_qe = NULL;
   /**
@@ -878,8 +925,25 @@ revoke_attrs_cb (void *cls,
   {
     if (GNUNET_GNSRECORD_TYPE_RECLAIM_ATTRIBUTE_REF != rd[i].record_type)
       continue;
+    if (sizeof (le->old_id) != rd[i].data_size)
+    {
+      GNUNET_break_op (0);
+      continue;
+    }
+    if (NULL != lookup_revoked_attr (rvk, rd[i].data))
+      continue;
     le = GNUNET_new (struct RevokedAttributeEntry);
     le->old_id = *((struct GNUNET_RECLAIM_Identifier *) rd[i].data);
+    le->old_label =
+      GNUNET_STRINGS_data_to_string_alloc (&le->old_id,
+                                           sizeof (le->old_id));
+    GNUNET_CRYPTO_hash (&le->old_id, sizeof (le->old_id), &key);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multihashmap_put (
+                     rvk->attrs_map,
+                     &key,
+                     le,
+                     GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST));
     GNUNET_CONTAINER_DLL_insert (rvk->attrs_head, rvk->attrs_tail, le);
     rvk->ticket_attrs++;
   }
@@ -905,6 +969,7 @@ rvk_attrs_err_cb (void *cls)
 {
   struct RECLAIM_TICKETS_RevokeHandle *rvk = cls;
 
+  rvk->ns_qe = NULL;
   rvk->cb (rvk->cb_cls, GNUNET_SYSERR);
   cleanup_rvk (rvk);
 }
@@ -936,6 +1001,8 @@ RECLAIM_TICKETS_revoke (const struct GNUNET_RECLAIM_Ticket *ticket,
   rvk->cb_cls = cb_cls;
   rvk->identity = *identity;
   rvk->ticket = *ticket;
+  rvk->revocation_start_time = GNUNET_TIME_absolute_get ();
+  rvk->attrs_map = GNUNET_CONTAINER_multihashmap_create (8, GNUNET_NO);
   tmp = GNUNET_strdup (ticket->gns_name);
   label = strtok (tmp, ".");
   GNUNET_assert (NULL != label);
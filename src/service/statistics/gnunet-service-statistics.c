@@ -1013,7 +1013,8 @@ run (void *cls,
  */
 GNUNET_SERVICE_MAIN (
   "statistics",
-  GNUNET_SERVICE_OPTION_SOFT_SHUTDOWN,
+  GNUNET_SERVICE_OPTION_SOFT_SHUTDOWN
+  | GNUNET_SERVICE_OPTION_INLINE_CONTINUE,
   &run,
   &client_connect_cb,
   &client_disconnect_cb,
@@ -36,6 +36,7 @@
 #include "gnunet_peerstore_service.h"
 #include "gnunet_statistics_service.h"
 #include "gnunet_transport_application_service.h"
+#include "gnunet-daemon-topology_gossip.h"
 #include <assert.h>
 
 
@@ -74,20 +75,21 @@ struct Peer
   struct GNUNET_MessageHeader *hello;
 
   /**
-   * Bloom filter used to mark which peers already got the HELLO
-   * from this peer.
+   * Handle for advertising @e hello to other peers; NULL if
+   * we do not advertise it.
    */
-  struct GNUNET_CONTAINER_BloomFilter *filter;
+  struct GDT_GOSSIP_Hello *gossip;
 
   /**
-   * Next time we are allowed to transmit a HELLO to this peer?
+   * Handle for advertising HELLOs to this peer; NULL if
+   * the peer is not connected.
    */
-  struct GNUNET_TIME_Absolute next_hello_allowed;
+  struct GDT_GOSSIP_Recipient *recipient;
 
   /**
-   * When should we reset the bloom filter of this entry?
+   * Next time we are allowed to transmit a HELLO to this peer?
    */
-  struct GNUNET_TIME_Absolute filter_expiration;
+  struct GNUNET_TIME_Absolute next_hello_allowed;
 
   /**
    * ID of task we use to wait for the time to send the next HELLO
@@ -235,16 +237,21 @@ free_peer (void *cls, const struct GNUNET_PeerIdentity *pid, void *value)
     GNUNET_TRANSPORT_application_suggest_cancel (pos->ash);
     pos->ash = NULL;
   }
+  if (NULL != pos->recipient)
+  {
+    GDT_GOSSIP_recipient_remove (pos->recipient);
+    pos->recipient = NULL;
+  }
+  if (NULL != pos->gossip)
+  {
+    GDT_GOSSIP_hello_remove (pos->gossip);
+    pos->gossip = NULL;
+  }
   if (NULL != pos->hello)
   {
     GNUNET_free (pos->hello);
     pos->hello = NULL;
   }
-  if (NULL != pos->filter)
-  {
-    GNUNET_CONTAINER_bloomfilter_free (pos->filter);
-    pos->filter = NULL;
-  }
   GNUNET_free (pos);
   return GNUNET_YES;
 }
@@ -327,108 +334,8 @@ make_peer (const struct GNUNET_PeerIdentity *peer,
 
 
 /**
- * Setup bloom filter for the given peer entry.
- *
- * @param peer entry to initialize
- */
-static void
-setup_filter (struct Peer *peer)
-{
-  struct GNUNET_HashCode hc;
-
-  /* 2^{-5} chance of not sending a HELLO to a peer is
-   * acceptably small (if the filter is 50% full);
-   * 64 bytes of memory are small compared to the rest
-   * of the data structure and would only really become
-   * "useless" once a HELLO has been passed on to ~100
-   * other peers, which is likely more than enough in
-   * any case; hence 64, 5 as bloomfilter parameters. */peer->filter = GNUNET_CONTAINER_bloomfilter_init (NULL, 64, 5);
-  peer->filter_expiration =
-    GNUNET_TIME_relative_to_absolute (HELLO_ADVERTISEMENT_MIN_REPEAT_FREQUENCY);
-  /* never send a peer its own HELLO */
-  GNUNET_CRYPTO_hash (&peer->pid, sizeof(struct GNUNET_PeerIdentity), &hc);
-  GNUNET_CONTAINER_bloomfilter_add (peer->filter, &hc);
-}
-
-
-/**
- * Closure for #find_advertisable_hello().
- */
-struct FindAdvHelloContext
-{
-  /**
-   * Peer we want to advertise to.
-   */
-  struct Peer *peer;
-
-  /**
-   * Where to store the result (peer selected for advertising).
-   */
-  struct Peer *result;
-
-  /**
-   * Maximum HELLO size we can use right now.
-   */
-  size_t max_size;
-
-  struct GNUNET_TIME_Relative next_adv;
-};
-
-
-/**
- * Find a peer that would be reasonable for advertising.
- *
- * @param cls closure
- * @param pid identity of a peer
- * @param value 'struct Peer*' for the peer we are considering
- * @return #GNUNET_YES (continue iteration)
- */
-static int
-find_advertisable_hello (void *cls,
-                         const struct GNUNET_PeerIdentity *pid,
-                         void *value)
-{
-  struct FindAdvHelloContext *fah = cls;
-  struct Peer *pos = value;
-  struct GNUNET_TIME_Relative rst_time;
-  struct GNUNET_HashCode hc;
-  size_t hs;
-
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "find_advertisable_hello\n");
-  if (pos == fah->peer)
-    return GNUNET_YES;
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "find_advertisable_hello 2\n");
-  if (pos->hello == NULL)
-    return GNUNET_YES;
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "find_advertisable_hello 3\n");
-  rst_time = GNUNET_TIME_absolute_get_remaining (pos->filter_expiration);
-  if (0 == rst_time.rel_value_us)
-  {
-    /* time to discard... */
-    GNUNET_CONTAINER_bloomfilter_free (pos->filter);
-    setup_filter (pos);
-  }
-  fah->next_adv = GNUNET_TIME_relative_min (rst_time, fah->next_adv);
-  hs = pos->hello->size;
-  if (hs > fah->max_size)
-    return GNUNET_YES;
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "find_advertisable_hello 4\n");
-  GNUNET_CRYPTO_hash (&fah->peer->pid,
-                      sizeof(struct GNUNET_PeerIdentity),
-                      &hc);
-  if (GNUNET_NO == GNUNET_CONTAINER_bloomfilter_test (pos->filter, &hc))
-    fah->result = pos;
-  return GNUNET_YES;
-}
-
-
-/**
- * Calculate when we would like to send the next HELLO to this
- * peer and ask for it.
+ * Send the next HELLO to this peer, if there is one we have not
+ * yet sent to it, and schedule the one after that.
  *
  * @param cls for which peer to schedule the HELLO
  */
@@ -436,41 +343,23 @@ static void
 schedule_next_hello (void *cls)
 {
   struct Peer *pl = cls;
-  struct FindAdvHelloContext fah;
+  struct Peer *result;
   struct GNUNET_MQ_Envelope *env;
-  size_t want;
   struct GNUNET_TIME_Relative delay;
-  struct GNUNET_HashCode hc;
 
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "schedule_next_hello\n");
   pl->hello_delay_task = NULL;
   GNUNET_assert (NULL != pl->mq);
-  /* find applicable HELLOs */
-  fah.peer = pl;
-  fah.result = NULL;
-  fah.max_size = GNUNET_MAX_MESSAGE_SIZE - 1;
-  fah.next_adv = GNUNET_TIME_UNIT_FOREVER_REL;
-  GNUNET_CONTAINER_multipeermap_iterate (peers, &find_advertisable_hello, &fah);
-  if (NULL == fah.result)
-  {
-    pl->hello_delay_task =
-      GNUNET_SCHEDULER_add_delayed (fah.next_adv, &schedule_next_hello, pl);
-
-    return;
-  }
-  want = ntohs (fah.result->hello->size);
+  result = GDT_GOSSIP_recipient_next (pl->recipient);
+  if (NULL == result)
+    return; /* wake_recipient() will be called once there is a new HELLO */
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Sending HELLO with %u bytes for peer %s\n",
-              (unsigned int) want,
+              (unsigned int) ntohs (result->hello->size),
               GNUNET_i2s (&pl->pid));
-  env = GNUNET_MQ_msg_copy (fah.result->hello);
+  env = GNUNET_MQ_msg_copy (result->hello);
   GNUNET_MQ_send (pl->mq, env);
-
-  /* avoid sending this one again soon */
-  GNUNET_CRYPTO_hash (&pl->pid, sizeof(struct GNUNET_PeerIdentity), &hc);
-  GNUNET_CONTAINER_bloomfilter_add (fah.result->filter, &hc);
-
   GNUNET_STATISTICS_update (stats,
                             gettext_noop ("# HELLO messages gossipped"),
                             1,
@@ -485,38 +374,26 @@ schedule_next_hello (void *cls)
 
 
 /**
- * Cancel existing requests for sending HELLOs to this peer
- * and recalculate when we should send HELLOs to it based
- * on our current state (something changed!).
+ * A peer we already sent all our HELLOs to has a new HELLO to
+ * pick from; schedule sending it within the HELLO send rate.
  *
- * @param cls closure `struct Peer` to skip, or NULL
- * @param pid identity of a peer
- * @param value `struct Peer *` for the peer
- * @return #GNUNET_YES (always)
+ * @param cls NULL
+ * @param recipient_cls the `struct Peer` to send to
  */
-static int
-reschedule_hellos (void *cls,
-                   const struct GNUNET_PeerIdentity *pid,
-                   void *value)
+static void
+wake_recipient (void *cls,
+                void *recipient_cls)
 {
-  struct Peer *peer = value;
-  (void) cls;
+  struct Peer *peer = recipient_cls;
+  struct GNUNET_TIME_Relative delay;
 
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "Reschedule for `%s'\n",
-              GNUNET_i2s (&peer->pid));
-  if (NULL == peer->mq)
-    return GNUNET_YES;
+  (void) cls;
   if (NULL != peer->hello_delay_task)
-  {
-    GNUNET_SCHEDULER_cancel (peer->hello_delay_task);
-    peer->hello_delay_task = NULL;
-  }
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "Schedule_next_hello\n");
-  peer->hello_delay_task =
-    GNUNET_SCHEDULER_add_now (&schedule_next_hello, peer);
-  return GNUNET_YES;
+    return;
+  delay = GNUNET_TIME_absolute_get_remaining (peer->next_hello_allowed);
+  peer->hello_delay_task = GNUNET_SCHEDULER_add_delayed (delay,
+                                                         &schedule_next_hello,
+                                                         peer);
 }
 
 
@@ -556,7 +433,11 @@ connect_notify (void *cls,
     GNUNET_assert (NULL == pos->mq);
   }
   pos->mq = mq;
-  reschedule_hellos (NULL, peer, pos);
+  pos->recipient = GDT_GOSSIP_recipient_add (peer,
+                                             pos);
+  GNUNET_assert (NULL == pos->hello_delay_task);
+  pos->hello_delay_task = GNUNET_SCHEDULER_add_now (&schedule_next_hello,
+                                                    pos);
   return pos;
 }
 
@@ -619,6 +500,8 @@ disconnect_notify (void *cls,
   }
   pos->mq = NULL;
   connection_count--;
+  GDT_GOSSIP_recipient_remove (pos->recipient);
+  pos->recipient = NULL;
   if (NULL != pos->hello_delay_task)
   {
     GNUNET_SCHEDULER_cancel (pos->hello_delay_task);
@@ -728,15 +611,13 @@ consider_for_advertising (const struct GNUNET_MessageHeader *hello)
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Found HELLO from peer `%s' for advertising\n",
               GNUNET_i2s (pid));
-  if (NULL != peer->filter)
-  {
-    GNUNET_CONTAINER_bloomfilter_free (peer->filter);
-    peer->filter = NULL;
-  }
-  setup_filter (peer);
-  /* since we have a new HELLO to pick from, re-schedule all
-   * HELLO requests that are not bound by the HELLO send rate! */
-  GNUNET_CONTAINER_multipeermap_iterate (peers, &reschedule_hellos, NULL);
+  /* offer the new HELLO to everyone; peers that already got all
+   * other HELLOs are woken up via wake_recipient() */
+  if (NULL == peer->gossip)
+    peer->gossip = GDT_GOSSIP_hello_add (&peer->pid,
+                                         peer);
+  else
+    GDT_GOSSIP_hello_reset (peer->gossip);
   GNUNET_HELLO_parser_free (parser);
 }
 
@@ -807,10 +688,10 @@ process_peer (void *cls,
     {
       GNUNET_free (pos->hello);
       pos->hello = NULL;
-      if (NULL != pos->filter)
+      if (NULL != pos->gossip)
       {
-        GNUNET_CONTAINER_bloomfilter_free (pos->filter);
-        pos->filter = NULL;
+        GDT_GOSSIP_hello_remove (pos->gossip);
+        pos->gossip = NULL;
       }
       if (NULL == pos->mq)
         free_peer (NULL, &pos->pid, pos);
@@ -992,6 +873,7 @@ cleaning_task (void *cls)
   GNUNET_CONTAINER_multipeermap_iterate (peers, &free_peer, NULL);
   GNUNET_CONTAINER_multipeermap_destroy (peers);
   peers = NULL;
+  GDT_GOSSIP_done ();
   if (NULL != transport)
   {
     GNUNET_TRANSPORT_application_done (transport);
@@ -1045,6 +927,9 @@ run (void *cls,
                                              &opt))
     opt = 16;
   target_connection_count = (unsigned int) opt;
+  GDT_GOSSIP_init (HELLO_ADVERTISEMENT_MIN_REPEAT_FREQUENCY,
+                   &wake_recipient,
+                   NULL);
   peers = GNUNET_CONTAINER_multipeermap_create (target_connection_count * 2,
                                                 GNUNET_NO);
   transport = GNUNET_TRANSPORT_application_init (cfg);
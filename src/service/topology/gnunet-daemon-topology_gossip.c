@@ -0,0 +1,428 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file topology/gnunet-daemon-topology_gossip.c
+ * @brief selection of the HELLOs the topology daemon gossips
+ *
+ * All HELLOs are kept in one list, ordered by the time their Bloom
+ * filter of recipients was last reset (and thus by the time it
+ * expires): new and reset HELLOs are appended.  Every recipient has
+ * a cursor into this list, pointing at the last HELLO it looked at.
+ * Everything before the cursor was either sent to the recipient or
+ * is not to be sent to it since the last reset of the HELLO, so
+ * picking the next HELLO only needs to look after the cursor.  When
+ * a HELLO is moved or removed, the recipients pointing to it are
+ * moved to its predecessor.  Recipients whose cursor reached the end
+ * are idle and are woken up when a HELLO is appended.
+ */
+#include "platform.h"
+#include "gnunet-daemon-topology_gossip.h"
+
+
+/**
+ * A HELLO we may advertise.
+ */
+struct GDT_GOSSIP_Hello
+{
+  /**
+   * Kept in a DLL ordered by @e filter_expiration.
+   */
+  struct GDT_GOSSIP_Hello *next;
+
+  /**
+   * Kept in a DLL ordered by @e filter_expiration.
+   */
+  struct GDT_GOSSIP_Hello *prev;
+
+  /**
+   * Recipients whose cursor is this HELLO.
+   */
+  struct GDT_GOSSIP_Recipient *cursor_head;
+
+  /**
+   * Recipients whose cursor is this HELLO.
+   */
+  struct GDT_GOSSIP_Recipient *cursor_tail;
+
+  /**
+   * Bloom filter of the recipients that already got the HELLO.
+   */
+  struct GNUNET_CONTAINER_BloomFilter *filter;
+
+  /**
+   * Closure to return to the caller.
+   */
+  void *cls;
+
+  /**
+   * When should we reset @e filter?
+   */
+  struct GNUNET_TIME_Absolute filter_expiration;
+
+  /**
+   * Hash of the identity of the peer the HELLO is from.
+   */
+  struct GNUNET_HashCode pid_hash;
+};
+
+
+/**
+ * A peer we advertise HELLOs to.
+ */
+struct GDT_GOSSIP_Recipient
+{
+  /**
+   * Kept in a DLL at @e cursor.
+   */
+  struct GDT_GOSSIP_Recipient *next;
+
+  /**
+   * Kept in a DLL at @e cursor.
+   */
+  struct GDT_GOSSIP_Recipient *prev;
+
+  /**
+   * Kept in the DLL of idle recipients if @e idle.
+   */
+  struct GDT_GOSSIP_Recipient *next_idle;
+
+  /**
+   * Kept in the DLL of idle recipients if @e idle.
+   */
+  struct GDT_GOSSIP_Recipient *prev_idle;
+
+  /**
+   * Last HELLO we looked at, NULL to start from the beginning.
+   */
+  struct GDT_GOSSIP_Hello *cursor;
+
+  /**
+   * Closure for the #GDT_GOSSIP_WakeCallback.
+   */
+  void *cls;
+
+  /**
+   * Hash of the identity of the peer, as added to the filters.
+   */
+  struct GNUNET_HashCode pid_hash;
+
+  /**
+   * Did we look at all HELLOs?
+   */
+  bool idle;
+};
+
+
+/**
+ * HELLOs, ordered by the expiration of their filter.
+ */
+static struct GDT_GOSSIP_Hello *hello_head;
+
+/**
+ * HELLOs, ordered by the expiration of their filter.
+ */
+static struct GDT_GOSSIP_Hello *hello_tail;
+
+/**
+ * Recipients that looked at all HELLOs.
+ */
+static struct GDT_GOSSIP_Recipient *idle_head;
+
+/**
+ * Recipients that looked at all HELLOs.
+ */
+static struct GDT_GOSSIP_Recipient *idle_tail;
+
+/**
+ * Task resetting the filter of the HELLO at #hello_head.
+ */
+static struct GNUNET_SCHEDULER_Task *expire_task;
+
+/**
+ * After how long do we reset the filters?
+ */
+static struct GNUNET_TIME_Relative filter_lifetime;
+
+/**
+ * Function to call when idle recipients have new HELLOs.
+ */
+static GDT_GOSSIP_WakeCallback wake_cb;
+
+/**
+ * Closure for #wake_cb.
+ */
+static void *wake_cb_cls;
+
+
+/**
+ * Point the cursor of @a r to @a h.
+ *
+ * @param r recipient to update
+ * @param h new cursor, can be NULL
+ */
+static void
+set_cursor (struct GDT_GOSSIP_Recipient *r,
+            struct GDT_GOSSIP_Hello *h)
+{
+  if (NULL != r->cursor)
+    GNUNET_CONTAINER_DLL_remove (r->cursor->cursor_head,
+                                 r->cursor->cursor_tail,
+                                 r);
+  r->cursor = h;
+  if (NULL != h)
+    GNUNET_CONTAINER_DLL_insert (h->cursor_head,
+                                 h->cursor_tail,
+                                 r);
+}
+
+
+/**
+ * Remove @a h from the list, moving the recipients pointing
+ * to it to its predecessor, so they look at its successor next.
+ *
+ * @param h HELLO to unlink
+ */
+static void
+unlink_hello (struct GDT_GOSSIP_Hello *h)
+{
+  struct GDT_GOSSIP_Recipient *r;
+
+  while (NULL != (r = h->cursor_head))
+    set_cursor (r,
+                h->prev);
+  GNUNET_CONTAINER_DLL_remove (hello_head,
+                               hello_tail,
+                               h);
+}
+
+
+/**
+ * Reschedule #expire_task for the HELLO at #hello_head.
+ */
+static void
+schedule_expire (void);
+
+
+/**
+ * Give @a h a fresh filter and append it to the list.  Wakes
+ * up the idle recipients.
+ *
+ * @param h HELLO to append
+ */
+static void
+append_hello (struct GDT_GOSSIP_Hello *h)
+{
+  struct GDT_GOSSIP_Recipient *r;
+
+  if (NULL != h->filter)
+    GNUNET_CONTAINER_bloomfilter_free (h->filter);
+  /* 2^{-5} chance of not sending a HELLO to a peer is
+   * acceptably small (if the filter is 50% full);
+   * 64 bytes of memory are small compared to the rest
+   * of the data structure and would only really become
+   * "useless" once a HELLO has been passed on to ~100
+   * other peers, which is likely more than enough in
+   * any case; hence 64, 5 as bloomfilter parameters. */
+  h->filter = GNUNET_CONTAINER_bloomfilter_init (NULL,
+                                                 64,
+                                                 5);
+  /* never send a peer its own HELLO */
+  GNUNET_CONTAINER_bloomfilter_add (h->filter,
+                                    &h->pid_hash);
+  h->filter_expiration = GNUNET_TIME_relative_to_absolute (filter_lifetime);
+  GNUNET_CONTAINER_DLL_insert_tail (hello_head,
+                                    hello_tail,
+                                    h);
+  if (NULL == expire_task)
+    schedule_expire ();
+  while (NULL != (r = idle_head))
+  {
+    GNUNET_CONTAINER_MDLL_remove (idle,
+                                  idle_head,
+                                  idle_tail,
+                                  r);
+    r->idle = false;
+    wake_cb (wake_cb_cls,
+             r->cls);
+  }
+}
+
+
+/**
+ * Reset the filters of the HELLOs that expired.
+ *
+ * @param cls NULL
+ */
+static void
+expire_filters (void *cls)
+{
+  struct GDT_GOSSIP_Hello *h;
+
+  (void) cls;
+  expire_task = NULL;
+  while ( (NULL != (h = hello_head)) &&
+          GNUNET_TIME_absolute_is_past (h->filter_expiration) )
+  {
+    unlink_hello (h);
+    append_hello (h);
+  }
+  schedule_expire ();
+}
+
+
+static void
+schedule_expire (void)
+{
+  if (NULL != expire_task)
+    GNUNET_SCHEDULER_cancel (expire_task);
+  expire_task = NULL;
+  if (NULL == hello_head)
+    return;
+  expire_task = GNUNET_SCHEDULER_add_at (hello_head->filter_expiration,
+                                         &expire_filters,
+                                         NULL);
+}
+
+
+void
+GDT_GOSSIP_init (struct GNUNET_TIME_Relative repeat_freq,
+                 GDT_GOSSIP_WakeCallback cb,
+                 void *cb_cls)
+{
+  filter_lifetime = repeat_freq;
+  wake_cb = cb;
+  wake_cb_cls = cb_cls;
+}
+
+
+void
+GDT_GOSSIP_done ()
+{
+  GNUNET_break (NULL == hello_head);
+  GNUNET_break (NULL == idle_head);
+  if (NULL != expire_task)
+  {
+    GNUNET_SCHEDULER_cancel (expire_task);
+    expire_task = NULL;
+  }
+}
+
+
+struct GDT_GOSSIP_Hello *
+GDT_GOSSIP_hello_add (const struct GNUNET_PeerIdentity *pid,
+                      void *cls)
+{
+  struct GDT_GOSSIP_Hello *h;
+
+  h = GNUNET_new (struct GDT_GOSSIP_Hello);
+  h->cls = cls;
+  GNUNET_CRYPTO_hash (pid,
+                      sizeof (*pid),
+                      &h->pid_hash);
+  append_hello (h);
+  return h;
+}
+
+
+void
+GDT_GOSSIP_hello_reset (struct GDT_GOSSIP_Hello *h)
+{
+  bool was_head = (h == hello_head);
+
+  unlink_hello (h);
+  append_hello (h);
+  if (was_head)
+    schedule_expire ();
+}
+
+
+void
+GDT_GOSSIP_hello_remove (struct GDT_GOSSIP_Hello *h)
+{
+  bool was_head = (h == hello_head);
+
+  unlink_hello (h);
+  GNUNET_CONTAINER_bloomfilter_free (h->filter);
+  GNUNET_free (h);
+  if (was_head)
+    schedule_expire ();
+}
+
+
+struct GDT_GOSSIP_Recipient *
+GDT_GOSSIP_recipient_add (const struct GNUNET_PeerIdentity *pid,
+                          void *cls)
+{
+  struct GDT_GOSSIP_Recipient *r;
+
+  r = GNUNET_new (struct GDT_GOSSIP_Recipient);
+  r->cls = cls;
+  GNUNET_CRYPTO_hash (pid,
+                      sizeof (*pid),
+                      &r->pid_hash);
+  return r;
+}
+
+
+void
+GDT_GOSSIP_recipient_remove (struct GDT_GOSSIP_Recipient *r)
+{
+  set_cursor (r,
+              NULL);
+  if (r->idle)
+    GNUNET_CONTAINER_MDLL_remove (idle,
+                                  idle_head,
+                                  idle_tail,
+                                  r);
+  GNUNET_free (r);
+}
+
+
+void *
+GDT_GOSSIP_recipient_next (struct GDT_GOSSIP_Recipient *r)
+{
+  struct GDT_GOSSIP_Hello *h;
+
+  if (r->idle)
+    return NULL;
+  while (NULL != (h = (NULL == r->cursor) ? hello_head : r->cursor->next))
+  {
+    set_cursor (r,
+                h);
+    if (GNUNET_YES ==
+        GNUNET_CONTAINER_bloomfilter_test (h->filter,
+                                           &r->pid_hash))
+      continue;
+    /* avoid sending this one again soon */
+    GNUNET_CONTAINER_bloomfilter_add (h->filter,
+                                      &r->pid_hash);
+    return h->cls;
+  }
+  r->idle = true;
+  GNUNET_CONTAINER_MDLL_insert (idle,
+                                idle_head,
+                                idle_tail,
+                                r);
+  return NULL;
+}
+
+
+/* end of gnunet-daemon-topology_gossip.c */
@@ -0,0 +1,139 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file topology/gnunet-daemon-topology_gossip.h
+ * @brief selection of the HELLOs the topology daemon gossips
+ */
+#ifndef GNUNET_DAEMON_TOPOLOGY_GOSSIP_H
+#define GNUNET_DAEMON_TOPOLOGY_GOSSIP_H
+
+#include "gnunet_util_lib.h"
+
+
+/**
+ * A HELLO we may advertise.
+ */
+struct GDT_GOSSIP_Hello;
+
+/**
+ * A peer we advertise HELLOs to.
+ */
+struct GDT_GOSSIP_Recipient;
+
+
+/**
+ * Function called when a recipient that had already been given all
+ * HELLOs it should get has new HELLOs to pick from.
+ *
+ * @param cls closure
+ * @param recipient_cls closure of the recipient
+ */
+typedef void
+(*GDT_GOSSIP_WakeCallback)(void *cls,
+                           void *recipient_cls);
+
+
+/**
+ * Initialize the HELLO selection.
+ *
+ * @param repeat_freq after how long may a HELLO be sent to the same
+ *        peer again
+ * @param cb function to call when idle recipients have new HELLOs
+ * @param cb_cls closure for @a cb
+ */
+void
+GDT_GOSSIP_init (struct GNUNET_TIME_Relative repeat_freq,
+                 GDT_GOSSIP_WakeCallback cb,
+                 void *cb_cls);
+
+
+/**
+ * Shut down the HELLO selection.  All HELLOs and recipients must
+ * have been removed.
+ */
+void
+GDT_GOSSIP_done (void);
+
+
+/**
+ * Add a HELLO we may advertise.
+ *
+ * @param pid peer the HELLO is from, it is never sent to this peer
+ * @param cls closure returned by #GDT_GOSSIP_recipient_next()
+ * @return handle for the HELLO
+ */
+struct GDT_GOSSIP_Hello *
+GDT_GOSSIP_hello_add (const struct GNUNET_PeerIdentity *pid,
+                      void *cls);
+
+
+/**
+ * The HELLO changed, offer it to all recipients again.
+ *
+ * @param h the HELLO
+ */
+void
+GDT_GOSSIP_hello_reset (struct GDT_GOSSIP_Hello *h);
+
+
+/**
+ * Stop advertising a HELLO.
+ *
+ * @param h the HELLO
+ */
+void
+GDT_GOSSIP_hello_remove (struct GDT_GOSSIP_Hello *h);
+
+
+/**
+ * Add a peer we advertise HELLOs to.
+ *
+ * @param pid the peer
+ * @param cls closure for the #GDT_GOSSIP_WakeCallback
+ * @return handle for the recipient
+ */
+struct GDT_GOSSIP_Recipient *
+GDT_GOSSIP_recipient_add (const struct GNUNET_PeerIdentity *pid,
+                          void *cls);
+
+
+/**
+ * Stop advertising HELLOs to a peer.
+ *
+ * @param r the recipient
+ */
+void
+GDT_GOSSIP_recipient_remove (struct GDT_GOSSIP_Recipient *r);
+
+
+/**
+ * Pick the next HELLO to send to a recipient, and remember that
+ * it was sent.  If there is none, the recipient is idle until the
+ * #GDT_GOSSIP_WakeCallback is called for it.
+ *
+ * @param r the recipient
+ * @return closure of the HELLO, NULL if there is nothing to send
+ */
+void *
+GDT_GOSSIP_recipient_next (struct GDT_GOSSIP_Recipient *r);
+
+
+#endif
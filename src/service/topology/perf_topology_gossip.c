@@ -0,0 +1,304 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file topology/perf_topology_gossip.c
+ * @brief measure picking the next HELLO to gossip with thousands of
+ *        peers, comparing a scan over all peers (as the topology daemon
+ *        used to do) with the cursors of gnunet-daemon-topology_gossip.c
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "gnunet-daemon-topology_gossip.h"
+
+/**
+ * Number of peers we have HELLOs from.
+ */
+#define NUM_HELLOS 4096
+
+/**
+ * Number of connected peers we gossip to.
+ */
+#define NUM_RECIPIENTS 64
+
+/**
+ * Number of HELLOs each recipient is sent in the comparison.
+ */
+#define ROUNDS 16
+
+/**
+ * Every how many picks is a HELLO replaced by a new one?
+ */
+#define CHURN 8
+
+
+/**
+ * A peer with a HELLO.
+ */
+struct PerfHello
+{
+  struct GNUNET_PeerIdentity pid;
+
+  /**
+   * Filter for the scan.
+   */
+  struct GNUNET_CONTAINER_BloomFilter *filter;
+
+  /**
+   * Handle for the cursors.
+   */
+  struct GDT_GOSSIP_Hello *gh;
+};
+
+
+/**
+ * A peer we gossip to.
+ */
+struct PerfRecipient
+{
+  struct GNUNET_PeerIdentity pid;
+
+  /**
+   * Handle for the cursors.
+   */
+  struct GDT_GOSSIP_Recipient *gr;
+
+  /**
+   * Number of HELLOs the recipient got.
+   */
+  unsigned int received;
+
+  /**
+   * Did the recipient become idle and was woken up again?
+   */
+  bool woken;
+};
+
+
+static struct PerfHello hellos[NUM_HELLOS];
+
+static struct PerfRecipient recipients[NUM_RECIPIENTS];
+
+static unsigned int wakes;
+
+
+static void
+report (const char *mode,
+        struct GNUNET_TIME_Absolute start,
+        unsigned long long ops)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s: %llu HELLOs picked in %s (%llu/s)\n",
+          mode,
+          ops,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          ops * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us));
+}
+
+
+/**
+ * Give the scan a fresh filter for @a h.
+ */
+static void
+scan_reset (struct PerfHello *h)
+{
+  struct GNUNET_HashCode hc;
+
+  if (NULL != h->filter)
+    GNUNET_CONTAINER_bloomfilter_free (h->filter);
+  h->filter = GNUNET_CONTAINER_bloomfilter_init (NULL,
+                                                 64,
+                                                 5);
+  GNUNET_CRYPTO_hash (&h->pid,
+                      sizeof (h->pid),
+                      &hc);
+  GNUNET_CONTAINER_bloomfilter_add (h->filter,
+                                    &hc);
+}
+
+
+/**
+ * Pick a HELLO for @a r by looking at all of them, hashing
+ * the identity of the recipient for every candidate.
+ */
+static struct PerfHello *
+scan_next (struct PerfRecipient *r)
+{
+  struct PerfHello *result = NULL;
+  struct GNUNET_HashCode hc;
+
+  for (unsigned int i = 0; i < NUM_HELLOS; i++)
+  {
+    GNUNET_CRYPTO_hash (&r->pid,
+                        sizeof (r->pid),
+                        &hc);
+    if (GNUNET_NO ==
+        GNUNET_CONTAINER_bloomfilter_test (hellos[i].filter,
+                                           &hc))
+      result = &hellos[i];
+  }
+  if (NULL != result)
+    GNUNET_CONTAINER_bloomfilter_add (result->filter,
+                                      &hc);
+  return result;
+}
+
+
+static void
+perf_scan (void)
+{
+  struct GNUNET_TIME_Absolute start;
+  unsigned long long ops = 0;
+
+  for (unsigned int i = 0; i < NUM_HELLOS; i++)
+    scan_reset (&hellos[i]);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int round = 0; round < ROUNDS; round++)
+    for (unsigned int j = 0; j < NUM_RECIPIENTS; j++)
+    {
+      GNUNET_assert (NULL != scan_next (&recipients[j]));
+      if (0 == ++ops % CHURN)
+        scan_reset (&hellos[GNUNET_CRYPTO_random_u32 (
+                                GNUNET_CRYPTO_QUALITY_WEAK,
+                                NUM_HELLOS)]);
+    }
+  report ("scan",
+          start,
+          ops);
+  for (unsigned int i = 0; i < NUM_HELLOS; i++)
+  {
+    GNUNET_CONTAINER_bloomfilter_free (hellos[i].filter);
+    hellos[i].filter = NULL;
+  }
+}
+
+
+static void
+wake_cb (void *cls,
+         void *recipient_cls)
+{
+  struct PerfRecipient *r = recipient_cls;
+
+  (void) cls;
+  r->woken = true;
+  wakes++;
+}
+
+
+static void
+perf_cursor (void *cls)
+{
+  struct GNUNET_TIME_Absolute start;
+  unsigned long long ops = 0;
+  unsigned long long total = 0;
+  unsigned int got = 0;
+
+  (void) cls;
+  GDT_GOSSIP_init (GNUNET_TIME_UNIT_HOURS,
+                   &wake_cb,
+                   NULL);
+  for (unsigned int i = 0; i < NUM_HELLOS; i++)
+    hellos[i].gh = GDT_GOSSIP_hello_add (&hellos[i].pid,
+                                         &hellos[i]);
+  for (unsigned int j = 0; j < NUM_RECIPIENTS; j++)
+    recipients[j].gr = GDT_GOSSIP_recipient_add (&recipients[j].pid,
+                                                 &recipients[j]);
+  start = GNUNET_TIME_absolute_get ();
+  for (unsigned int round = 0; round < ROUNDS; round++)
+    for (unsigned int j = 0; j < NUM_RECIPIENTS; j++)
+    {
+      GNUNET_assert (NULL != GDT_GOSSIP_recipient_next (recipients[j].gr));
+      recipients[j].received++;
+      if (0 == ++ops % CHURN)
+        GDT_GOSSIP_hello_reset (hellos[GNUNET_CRYPTO_random_u32 (
+                                         GNUNET_CRYPTO_QUALITY_WEAK,
+                                         NUM_HELLOS)].gh);
+    }
+  report ("cursor",
+          start,
+          ops);
+
+  /* send everything that is left */
+  start = GNUNET_TIME_absolute_get ();
+  ops = 0;
+  for (unsigned int j = 0; j < NUM_RECIPIENTS; j++)
+    while (NULL != GDT_GOSSIP_recipient_next (recipients[j].gr))
+    {
+      recipients[j].received++;
+      ops++;
+    }
+  report ("cursor, until idle",
+          start,
+          ops);
+  for (unsigned int j = 0; j < NUM_RECIPIENTS; j++)
+  {
+    /* the Bloom filters may make us skip a few */
+    GNUNET_assert (recipients[j].received >= (NUM_HELLOS - 1) * 9 / 10);
+    total += recipients[j].received;
+  }
+  printf ("%llu HELLOs sent to %u peers\n",
+          total,
+          (unsigned int) NUM_RECIPIENTS);
+
+  /* a new HELLO wakes everyone up, and everyone gets it */
+  GDT_GOSSIP_hello_reset (hellos[0].gh);
+  GNUNET_assert (NUM_RECIPIENTS == wakes);
+  for (unsigned int j = 0; j < NUM_RECIPIENTS; j++)
+  {
+    GNUNET_assert (recipients[j].woken);
+    if (&hellos[0] == GDT_GOSSIP_recipient_next (recipients[j].gr))
+      got++;
+    GNUNET_assert (NULL == GDT_GOSSIP_recipient_next (recipients[j].gr));
+  }
+  GNUNET_assert (got >= NUM_RECIPIENTS * 9 / 10);
+
+  for (unsigned int j = 0; j < NUM_RECIPIENTS; j++)
+    GDT_GOSSIP_recipient_remove (recipients[j].gr);
+  for (unsigned int i = 0; i < NUM_HELLOS; i++)
+    GDT_GOSSIP_hello_remove (hellos[i].gh);
+  GDT_GOSSIP_done ();
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  GNUNET_log_setup ("perf-topology-gossip",
+                    "WARNING",
+                    NULL);
+  for (unsigned int i = 0; i < NUM_HELLOS; i++)
+    GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_WEAK,
+                                &hellos[i].pid,
+                                sizeof (hellos[i].pid));
+  /* we also gossip to peers we have HELLOs from */
+  for (unsigned int j = 0; j < NUM_RECIPIENTS; j++)
+    recipients[j].pid = hellos[j].pid;
+  perf_scan ();
+  GNUNET_SCHEDULER_run (&perf_cursor,
+                        NULL);
+  return 0;
+}
+
+
+/* end of perf_topology_gossip.c */
@@ -51,6 +51,19 @@
  */
 #define NUM_LONG_POLL 16
 
+/**
+ * Path of the request whose request and response bodies carry a
+ * stream of messages instead of one message each.
+ */
+#define STREAM_PATH "/stream"
+
+/**
+ * How many bytes may be written to a streamed body without being
+ * acknowledged by the peer before we stop taking messages from the
+ * MQ.
+ */
+#define STREAM_WINDOW (256 * 1024)
+
 /**
  * Defines some error types related to network errors.
  */
@@ -138,6 +151,12 @@ static struct GNUNET_STATISTICS_Handle *stats;
  */
 static gnutls_certificate_credentials_t cred;
 
+/**
+ * Do we carry our messages in the bodies of one long-lived request
+ * instead of one request (or long polling response) per message?
+ */
+static int streaming;
+
 /**
  * Information of a stream.
  */
@@ -197,6 +216,44 @@ struct Stream
    * The length of request authority.
    */
   size_t authoritylen;
+
+  /**
+   * Tokenizer for the messages received in the body of the streamed
+   * request, NULL for all other streams.
+   */
+  struct GNUNET_MessageStreamTokenizer *mst;
+
+  /**
+   * Messages written to the body of the streamed request that the
+   * peer did not acknowledge yet.
+   */
+  struct HTTP_Message *tx_head;
+
+  /**
+   * Tail of the messages written to the streamed body.
+   */
+  struct HTTP_Message *tx_tail;
+
+  /**
+   * First message in the list that was not passed to nghttp3 yet.
+   */
+  struct HTTP_Message *tx_unread;
+
+  /**
+   * Number of bytes of @e tx_head the peer already acknowledged.
+   */
+  size_t tx_acked;
+
+  /**
+   * Number of bytes in the list not acknowledged yet.
+   */
+  size_t tx_pending;
+
+  /**
+   * Number of bytes of the peer identity at the start of a received
+   * streamed body we are still waiting for.
+   */
+  size_t id_missing;
 };
 
 /**
@@ -400,6 +457,18 @@ struct Connection
    * length of long polling struct queue.
    */
   size_t long_poll_len;
+
+  /**
+   * The streamed request carrying our messages, NULL if we
+   * use one request per message.
+   */
+  struct Stream *tx_stream;
+
+  /**
+   * Is the MQ waiting for the peer to acknowledge data of
+   * the streamed body before it may send the next message?
+   */
+  int mq_blocked;
 };
 
 
@@ -683,6 +752,45 @@ create_stream (struct Connection *connection, int64_t stream_id)
 }
 
 
+/**
+ * Release the messages queued for the streamed body of @a stream.
+ * If the MQ was waiting for them to be acknowledged, let it
+ * continue; the peer will not see them anymore.
+ *
+ * @param stream the stream.
+ */
+static void
+stream_free_tx (struct Stream *stream)
+{
+  struct Connection *connection = stream->connection;
+  struct HTTP_Message *msg;
+
+  while (NULL != (msg = stream->tx_head))
+  {
+    stream->tx_head = msg->next;
+    GNUNET_free (msg->buf);
+    GNUNET_free (msg);
+  }
+  stream->tx_tail = NULL;
+  stream->tx_unread = NULL;
+  stream->tx_pending = 0;
+  if (NULL != stream->mst)
+  {
+    GNUNET_MST_destroy (stream->mst);
+    stream->mst = NULL;
+  }
+  if (stream != connection->tx_stream)
+    return;
+  connection->tx_stream = NULL;
+  if ((GNUNET_YES == connection->mq_blocked) &&
+      (NULL != connection->d_mq))
+  {
+    connection->mq_blocked = GNUNET_NO;
+    GNUNET_MQ_impl_send_continue (connection->d_mq);
+  }
+}
+
+
 /**
  * Remove the stream with the specified @a stream_id in @a connection.
  *
@@ -721,6 +829,7 @@ remove_stream (struct Connection *connection, int64_t stream_id)
   {
     GNUNET_free (stream->authority);
   }
+  stream_free_tx (stream);
   GNUNET_free (stream);
 }
 
@@ -863,6 +972,7 @@ get_stream_delete_it (void *cls,
   {
     GNUNET_free (stream->authority);
   }
+  stream_free_tx (stream);
   GNUNET_free (stream);
   return GNUNET_OK;
 }
@@ -988,6 +1098,103 @@ read_data (nghttp3_conn *conn, int64_t stream_id, nghttp3_vec *vec,
 }
 
 
+/**
+ * The callback function to generate a streamed body.  Passes the
+ * queued messages to nghttp3, which references them until they are
+ * acknowledged, and never ends the body.
+ */
+static nghttp3_ssize
+read_stream_data (nghttp3_conn *conn, int64_t stream_id, nghttp3_vec *vec,
+                  size_t veccnt, uint32_t *pflags, void *user_data,
+                  void *stream_user_data)
+{
+  struct Stream *stream = stream_user_data;
+  size_t n;
+
+  n = 0;
+  while (NULL != stream->tx_unread &&
+         n < veccnt)
+  {
+    vec[n].base = (uint8_t *) stream->tx_unread->buf;
+    vec[n].len = stream->tx_unread->size;
+    stream->tx_unread = stream->tx_unread->next;
+    n++;
+  }
+  if (0 == n)
+    return NGHTTP3_ERR_WOULDBLOCK;
+  return n;
+}
+
+
+/**
+ * Append a message to the streamed body of @a stream.
+ *
+ * @param stream the streamed request.
+ * @param data the data to send.
+ * @param datalen the length of @a data.
+ */
+static void
+stream_queue (struct Stream *stream,
+              const void *data,
+              size_t datalen)
+{
+  struct HTTP_Message *msg;
+  int rv;
+
+  msg = GNUNET_new (struct HTTP_Message);
+  msg->buf = GNUNET_memdup (data, datalen);
+  msg->size = datalen;
+  if (NULL == stream->tx_tail)
+    stream->tx_head = msg;
+  else
+    stream->tx_tail->next = msg;
+  stream->tx_tail = msg;
+  if (NULL == stream->tx_unread)
+    stream->tx_unread = msg;
+  stream->tx_pending += datalen;
+  rv = nghttp3_conn_resume_stream (stream->connection->h3_conn,
+                                   stream->stream_id);
+  if (0 != rv)
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "nghttp3_conn_resume_stream: %s\n",
+                nghttp3_strerror (rv));
+  }
+}
+
+
+/**
+ * Pass a message received in a streamed body to the transport.
+ *
+ * @param cls the `struct Stream`
+ * @param hdr the message
+ * @return #GNUNET_OK on success, #GNUNET_SYSERR to stop
+ */
+static int
+stream_deliver_cb (void *cls,
+                   const struct GNUNET_MessageHeader *hdr)
+{
+  struct Stream *stream = cls;
+  struct Connection *connection = stream->connection;
+  int rv;
+
+  rv = GNUNET_TRANSPORT_communicator_receive (ch,
+                                              &connection->target,
+                                              hdr,
+                                              ADDRESS_VALIDITY_PERIOD,
+                                              NULL,
+                                              NULL);
+  if (GNUNET_SYSERR == rv)
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                "GNUNET_TRANSPORT_communicator_receive:%d, hdr->len = %u, init = %d\n",
+                rv, ntohs (hdr->size), connection->is_initiator);
+    return GNUNET_SYSERR;
+  }
+  return GNUNET_OK;
+}
+
+
 /**
  * Submit the post request, send our data.
  *
@@ -1099,6 +1306,70 @@ submit_get_request (struct Connection *connection,
 }
 
 
+/**
+ * Client side opens the request whose bodies carry our messages
+ * in both directions.  The request body starts with our identity.
+ *
+ * @param connection the connection.
+ *
+ * @return #GNUNET_NO if success, #GNUENT_SYSERR if failed.
+ */
+static int
+submit_stream_request (struct Connection *connection)
+{
+  nghttp3_nv nva[6];
+  nghttp3_data_reader dr = {};
+  struct Stream *stream;
+  int64_t stream_id;
+  int rv;
+
+  rv = ngtcp2_conn_open_bidi_stream (connection->conn, &stream_id, NULL);
+  if (0 != rv)
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "ngtcp2_conn_open_bidi_stream: %s\n",
+                ngtcp2_strerror (rv));
+    return GNUNET_SYSERR;
+  }
+  stream = create_stream (connection, stream_id);
+
+  nva[0] = make_nv (":method", "POST",
+                    NGHTTP3_NV_FLAG_NO_COPY_NAME
+                    | NGHTTP3_NV_FLAG_NO_COPY_VALUE);
+  nva[1] = make_nv (":scheme", "https",
+                    NGHTTP3_NV_FLAG_NO_COPY_NAME
+                    | NGHTTP3_NV_FLAG_NO_COPY_VALUE);
+  nva[2] = make_nv (":authority",
+                    GNUNET_a2s (connection->address, connection->address_len),
+                    NGHTTP3_NV_FLAG_NO_COPY_NAME);
+  nva[3] = make_nv (":path", STREAM_PATH,
+                    NGHTTP3_NV_FLAG_NO_COPY_NAME
+                    | NGHTTP3_NV_FLAG_NO_COPY_VALUE);
+  nva[4] = make_nv ("user-agent", "nghttp3/ngtcp2 client",
+                    NGHTTP3_NV_FLAG_NO_COPY_NAME
+                    | NGHTTP3_NV_FLAG_NO_COPY_VALUE);
+  nva[5] = make_nv ("content-type", "application/octet-stream",
+                    NGHTTP3_NV_FLAG_NO_COPY_NAME
+                    | NGHTTP3_NV_FLAG_NO_COPY_VALUE);
+
+  dr.read_data = read_stream_data;
+  rv = nghttp3_conn_submit_request (connection->h3_conn,
+                                    stream->stream_id,
+                                    nva, 6, &dr, stream);
+  if (0 != rv)
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "nghttp3_conn_submit_request: %s\n",
+                nghttp3_strerror (rv));
+    return GNUNET_SYSERR;
+  }
+  stream->mst = GNUNET_MST_create (&stream_deliver_cb, stream);
+  connection->tx_stream = stream;
+  stream_queue (stream, &my_identity, sizeof (my_identity));
+  return GNUNET_NO;
+}
+
+
 /**
  * Timeout callback function in the long polling struct.
  *
@@ -1208,6 +1479,58 @@ stream_send_data (struct Stream *stream,
 }
 
 
+/**
+ * Server side answers the streamed request of the client as soon
+ * as its headers are complete.  The response body carries our
+ * messages for as long as the connection lives.
+ *
+ * @param connection the connection.
+ * @param stream the stream of the streamed request.
+ *
+ * @return #GNUNET_NO if success, #GNUENT_SYSERR if failed.
+ */
+static int
+stream_start_streaming (struct Connection *connection, struct Stream *stream)
+{
+  nghttp3_nv nva[3];
+  nghttp3_data_reader dr = {};
+  int rv;
+
+  if (NULL != connection->tx_stream)
+  {
+    GNUNET_break_op (0);
+    return GNUNET_SYSERR;
+  }
+  nva[0] = make_nv (":status", "200",
+                    NGHTTP3_NV_FLAG_NO_COPY_NAME
+                    | NGHTTP3_NV_FLAG_NO_COPY_VALUE);
+  nva[1] = make_nv ("server", "nghttp3/ngtcp2 server",
+                    NGHTTP3_NV_FLAG_NO_COPY_NAME
+                    | NGHTTP3_NV_FLAG_NO_COPY_VALUE);
+  nva[2] = make_nv ("content-type", "application/octet-stream",
+                    NGHTTP3_NV_FLAG_NO_COPY_NAME
+                    | NGHTTP3_NV_FLAG_NO_COPY_VALUE);
+
+  dr.read_data = read_stream_data;
+  rv = nghttp3_conn_submit_response (connection->h3_conn,
+                                     stream->stream_id,
+                                     nva, 3, &dr);
+  if (0 != rv)
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "nghttp3_conn_submit_response: %s\n",
+                nghttp3_strerror (rv));
+    return GNUNET_SYSERR;
+  }
+  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+              "server recv streamed request\n");
+  stream->mst = GNUNET_MST_create (&stream_deliver_cb, stream);
+  stream->id_missing = sizeof (struct GNUNET_PeerIdentity);
+  connection->tx_stream = stream;
+  return GNUNET_NO;
+}
+
+
 /**
  * Make response to the request.
  *
@@ -1389,6 +1712,21 @@ mq_send_d (struct GNUNET_MQ_Handle *mq,
   }
   reschedule_peer_timeout (connection);
 
+  if (NULL != connection->tx_stream)
+  {
+    stream_queue (connection->tx_stream, msg, msize);
+    connection_write (connection);
+    if ((NULL != connection->tx_stream) &&
+        (connection->tx_stream->tx_pending >= STREAM_WINDOW))
+    {
+      /* continue once the peer acknowledged enough */
+      connection->mq_blocked = GNUNET_YES;
+      return;
+    }
+    GNUNET_MQ_impl_send_continue (mq);
+    return;
+  }
+
   // If we are client side.
   if (GNUNET_YES == connection->is_initiator)
   {
@@ -1563,8 +1901,10 @@ setup_connection_mq (struct Connection *connection)
     GNUNET_assert (0);
     break;
   }
-  /* MTU == base_mtu */
+  /* MTU == base_mtu, unless messages are streamed */
   connection->d_mtu = base_mtu;
+  if (NULL != connection->tx_stream)
+    connection->d_mtu = UINT16_MAX;
 
   if (NULL == connection->d_mq)
     connection->d_mq = GNUNET_MQ_queue_for_callbacks (&mq_send_d,
@@ -1578,7 +1918,9 @@ setup_connection_mq (struct Connection *connection)
     GNUNET_TRANSPORT_communicator_mq_add (ch,
                                           &connection->target,
                                           connection->foreign_addr,
-                                          1080,
+                                          (NULL != connection->tx_stream)
+                                          ? UINT16_MAX /* no MTU */
+                                          : 1080,
                                           GNUNET_TRANSPORT_QUEUE_LENGTH_UNLIMITED,
                                           0, /* Priority */
                                           connection->nt,
@@ -1627,6 +1969,59 @@ http_stream_close_cb (nghttp3_conn *conn, int64_t stream_id,
 }
 
 
+/**
+ * Handle data received in a streamed body.  The server expects the
+ * identity of the client first, followed by a stream of messages.
+ *
+ * @param connection the connection.
+ * @param stream the streamed request.
+ * @param data the received data.
+ * @param datalen the length of @a data.
+ *
+ * @return 0 on success, #NGHTTP3_ERR_CALLBACK_FAILURE if failed.
+ */
+static int
+stream_recv_data (struct Connection *connection,
+                  struct Stream *stream,
+                  const uint8_t *data,
+                  size_t datalen)
+{
+  size_t n;
+
+  if (0 < stream->id_missing)
+  {
+    n = GNUNET_MIN (stream->id_missing, datalen);
+    GNUNET_memcpy ((char *) &connection->target
+                   + sizeof (connection->target) - stream->id_missing,
+                   data,
+                   n);
+    stream->id_missing -= n;
+    data += n;
+    datalen -= n;
+    if (0 == stream->id_missing &&
+        GNUNET_NO == connection->id_rcvd)
+    {
+      connection->id_rcvd = GNUNET_YES;
+      setup_connection_mq (connection);
+    }
+  }
+  if (0 == datalen)
+    return 0;
+  if (GNUNET_OK != GNUNET_MST_from_buffer (stream->mst,
+                                           (const char *) data,
+                                           datalen,
+                                           GNUNET_NO,
+                                           GNUNET_NO))
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                "malformed message in streamed body, init = %d\n",
+                connection->is_initiator);
+    return NGHTTP3_ERR_CALLBACK_FAILURE;
+  }
+  return 0;
+}
+
+
 /**
  * The callback of nghttp3_callback.recv_data
  */
@@ -1637,12 +2032,16 @@ http_recv_data_cb (nghttp3_conn *conn, int64_t stream_id, const uint8_t *data,
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "http_recv_data_cb\n");
   struct Connection *connection = user_data;
+  struct Stream *stream = stream_user_data;
   struct GNUNET_PeerIdentity *pid;
   struct GNUNET_MessageHeader *hdr;
   int rv;
 
   http_consume (connection, stream_id, datalen);
 
+  if (NULL != stream && NULL != stream->mst)
+    return stream_recv_data (connection, stream, data, datalen);
+
   if (GNUNET_NO == connection->is_initiator &&
       GNUNET_NO == connection->id_rcvd)
   {
@@ -1759,6 +2158,72 @@ http_recv_header_cb (nghttp3_conn *conn, int64_t stream_id, int32_t token,
 }
 
 
+/**
+ * The callback of nghttp3_callback.end_headers
+ */
+static int
+http_end_headers_cb (nghttp3_conn *conn, int64_t stream_id, int fin,
+                     void *user_data, void *stream_user_data)
+{
+  struct Connection *connection = user_data;
+  struct Stream *stream = stream_user_data;
+
+  if (GNUNET_YES == connection->is_initiator ||
+      NULL == stream ||
+      strlen (STREAM_PATH) != stream->urilen ||
+      0 != memcmp (stream->uri, STREAM_PATH, stream->urilen))
+  {
+    return 0;
+  }
+  if (GNUNET_NO != stream_start_streaming (connection, stream))
+  {
+    return NGHTTP3_ERR_CALLBACK_FAILURE;
+  }
+  return 0;
+}
+
+
+/**
+ * The callback of nghttp3_callback.acked_stream_data
+ */
+static int
+http_acked_stream_data_cb (nghttp3_conn *conn, int64_t stream_id,
+                           uint64_t datalen, void *user_data,
+                           void *stream_user_data)
+{
+  struct Connection *connection = user_data;
+  struct Stream *stream = stream_user_data;
+  struct HTTP_Message *msg;
+
+  if (NULL == stream ||
+      stream != connection->tx_stream)
+  {
+    return 0;
+  }
+  GNUNET_assert (datalen <= stream->tx_pending);
+  stream->tx_pending -= datalen;
+  datalen += stream->tx_acked;
+  while (NULL != (msg = stream->tx_head) &&
+         datalen >= msg->size)
+  {
+    datalen -= msg->size;
+    stream->tx_head = msg->next;
+    GNUNET_free (msg->buf);
+    GNUNET_free (msg);
+  }
+  if (NULL == stream->tx_head)
+    stream->tx_tail = NULL;
+  stream->tx_acked = datalen;
+  if (GNUNET_YES == connection->mq_blocked &&
+      stream->tx_pending < STREAM_WINDOW)
+  {
+    connection->mq_blocked = GNUNET_NO;
+    GNUNET_MQ_impl_send_continue (connection->d_mq);
+  }
+  return 0;
+}
+
+
 /**
  * The callback of nghttp3_callback.stop_sending
  */
@@ -1799,6 +2264,11 @@ http_end_stream_cb (nghttp3_conn *conn, int64_t stream_id, void *user_data,
 
   if (GNUNET_NO == connection->is_initiator)
   {
+    /* the streamed request was answered with its headers */
+    if (stream == connection->tx_stream)
+    {
+      return 0;
+    }
     // Send response
     rv = stream_start_response (connection, stream);
     if (0 != rv)
@@ -1889,6 +2359,8 @@ setup_httpconn (struct Connection *connection)
     .stop_sending = http_stop_sending_cb,
     .end_stream = http_end_stream_cb,
     .reset_stream = http_reset_stream_cb,
+    .end_headers = http_end_headers_cb,
+    .acked_stream_data = http_acked_stream_data_cb,
   };
   int rv;
 
@@ -2322,7 +2794,19 @@ recv_rx_key_cb (ngtcp2_conn *conn, ngtcp2_encryption_level level,
   }
 
   if (GNUNET_YES == connection->is_initiator &&
-      GNUNET_NO == connection->id_sent)
+      GNUNET_NO == connection->id_sent &&
+      GNUNET_YES == streaming)
+  {
+    rv = submit_stream_request (connection);
+    if (GNUNET_NO != rv)
+    {
+      return NGTCP2_ERR_CALLBACK_FAILURE;
+    }
+    connection->id_sent = GNUNET_YES;
+    setup_connection_mq (connection);
+  }
+  else if (GNUNET_YES == connection->is_initiator &&
+           GNUNET_NO == connection->id_sent)
   {
     stream = create_stream (connection, -1);
     rv = ngtcp2_conn_open_bidi_stream (conn, &stream->stream_id, NULL);
@@ -3737,6 +4221,10 @@ run (void *cls,
     GNUNET_OS_process_destroy (cert_creation);
   }
 
+  streaming =
+    GNUNET_CONFIGURATION_get_value_yesno (cfg,
+                                          COMMUNICATOR_CONFIG_SECTION,
+                                          "STREAMING");
   disable_v6 = GNUNET_NO;
   if ((GNUNET_NO == GNUNET_NETWORK_test_pf (PF_INET6)) ||
       (GNUNET_YES ==
@@ -27,18 +27,17 @@
  * TODO:
  * - Automatically generate self-signed x509 certificates and load from config
  * - Figure out MTU and how we have to handle fragmentation in Quiche.
- * - Mandate timeouts
  * - Setup stats handler properly
  * - Doxygen documentation of methods
  * - Refactor code shared with UDP and TCP communicator
  * - Performance testing
  * - Check for memory leaks with coverity/valgrind
  */
+#include "platform.h"
 #include "gnunet_common.h"
 #include "gnunet_util_lib.h"
 #include "gnunet_core_service.h"
 #include "quiche.h"
-#include "platform.h"
 #include "gnunet_protocols.h"
 #include "gnunet_signatures.h"
 #include "gnunet_constants.h"
@@ -48,11 +47,26 @@
 #include "gnunet_nat_service.h"
 #include "stdint.h"
 #include "inttypes.h"
+#ifdef LINUX
+#include <netinet/udp.h>
+#endif
 
 #define COMMUNICATOR_CONFIG_SECTION "communicator-quic"
 #define COMMUNICATOR_ADDRESS_PREFIX "quic"
 #define MAX_DATAGRAM_SIZE 1350
 
+/**
+ * How many packets do we hand to the kernel in one system call?
+ * Bounded by the 64 KiB limit of a GSO super-packet.
+ */
+#define MAX_SEND_BATCH 32
+
+/**
+ * Packets whose pacing time is less than this far in the future
+ * are sent right away, the scheduler cannot wait more precisely.
+ */
+#define PACING_GRANULARITY GNUNET_TIME_UNIT_MILLISECONDS
+
 
 /* FIXME: Review all static lengths/contents below. Maybe this can be done smarter */
 /* Currently equivalent to QUICHE_MAX_CONN_ID_LEN */
@@ -232,6 +246,68 @@ struct PeerAddress
    */
   int peer_destroy_called;
 
+  /**
+   * Task driving quiche's loss detection and idle timers.
+   */
+  struct GNUNET_SCHEDULER_Task *timeout_task;
+
+  /**
+   * Task sending @e paced_buf once quiche's pacer allows it.
+   */
+  struct GNUNET_SCHEDULER_Task *pacing_task;
+
+  /**
+   * Packet produced by quiche that must not be sent before the
+   * time quiche gave for it, or that must wait for @e blocked_buf.
+   */
+  uint8_t paced_buf[MAX_DATAGRAM_SIZE];
+
+  /**
+   * Number of bytes in @e paced_buf, 0 if none.
+   */
+  size_t paced_len;
+
+  /**
+   * Destination of @e paced_buf.
+   */
+  struct sockaddr_storage paced_to;
+
+  /**
+   * Length of @e paced_to.
+   */
+  socklen_t paced_to_len;
+
+  /**
+   * Task sending @e blocked_buf once the socket is writable again.
+   */
+  struct GNUNET_SCHEDULER_Task *write_task;
+
+  /**
+   * Packets the kernel did not take because the socket buffer was
+   * full, allocated on first use.
+   */
+  uint8_t (*blocked_buf)[MAX_DATAGRAM_SIZE];
+
+  /**
+   * Sizes of the packets in @e blocked_buf.
+   */
+  size_t blocked_len[MAX_SEND_BATCH];
+
+  /**
+   * Number of packets in @e blocked_buf, 0 if none.
+   */
+  unsigned int blocked_count;
+
+  /**
+   * Destination of the packets in @e blocked_buf.
+   */
+  struct sockaddr_storage blocked_to;
+
+  /**
+   * Length of @e blocked_to.
+   */
+  socklen_t blocked_to_len;
+
   /**
    * FIXME implementation missing
    * Entry in sender expiration heap.
@@ -260,6 +336,12 @@ static struct GNUNET_NT_InterfaceScanner *is;
  */
 static struct GNUNET_STATISTICS_Handle *stats;
 
+/**
+ * Do we (still) try UDP generic segmentation offload?  Reset
+ * if the kernel or the device refuses it.
+ */
+static int gso_enabled = GNUNET_YES;
+
 /**
  * QUIC connection object. A connection has a unique SCID/DCID pair. Here we store our SCID
  * (incoming packet DCID field == outgoing packet SCID field) for a given connection. This
@@ -488,18 +570,420 @@ create_conn (uint8_t *scid, size_t scid_len,
 }
 
 
+/**
+ * Send a batch of packets that quiche produced for @a to in as few
+ * system calls as possible: one GSO super-packet if the kernel
+ * supports it and the sizes permit, otherwise sendmmsg().
+ *
+ * @param bufs packets to send
+ * @param lens sizes of the packets in @a bufs
+ * @param n number of packets
+ * @param to destination
+ * @param to_len length of @a to
+ * @return number of packets at the start of @a bufs that were sent
+ *         (or dropped, like a lost datagram), less than @a n if the
+ *         socket buffer is full
+ */
+static unsigned int
+send_batch (uint8_t bufs[][MAX_DATAGRAM_SIZE],
+            const size_t *lens,
+            unsigned int n,
+            const struct sockaddr_storage *to,
+            socklen_t to_len)
+{
+#ifdef LINUX
+  int fd = GNUNET_NETWORK_get_fd (udp_sock);
+  struct iovec iov[MAX_SEND_BATCH];
+
+  GNUNET_assert (n <= MAX_SEND_BATCH);
+  for (unsigned int i = 0; i < n; i++)
+  {
+    iov[i].iov_base = bufs[i];
+    iov[i].iov_len = lens[i];
+  }
+#ifdef UDP_SEGMENT
+  if ((n > 1) &&
+      (GNUNET_YES == gso_enabled))
+  {
+    int same_size = GNUNET_YES;
+
+    /* GSO cuts the payload into segments of equal size,
+       only the last one may be shorter */
+    for (unsigned int i = 1; i < n; i++)
+      if ((lens[i] > lens[0]) ||
+          ((lens[i] != lens[0]) && (i != n - 1)))
+        same_size = GNUNET_NO;
+    if (GNUNET_YES == same_size)
+    {
+      struct msghdr mh;
+      union
+      {
+        char buf[CMSG_SPACE (sizeof (uint16_t))];
+        struct cmsghdr align;
+      } control;
+      struct cmsghdr *cm;
+      uint16_t segment = lens[0];
+
+      memset (&mh,
+              0,
+              sizeof (mh));
+      mh.msg_name = (void *) to;
+      mh.msg_namelen = to_len;
+      mh.msg_iov = iov;
+      mh.msg_iovlen = n;
+      mh.msg_control = control.buf;
+      mh.msg_controllen = sizeof (control.buf);
+      cm = CMSG_FIRSTHDR (&mh);
+      cm->cmsg_level = SOL_UDP;
+      cm->cmsg_type = UDP_SEGMENT;
+      cm->cmsg_len = CMSG_LEN (sizeof (segment));
+      GNUNET_memcpy (CMSG_DATA (cm),
+                     &segment,
+                     sizeof (segment));
+      if (0 <= sendmsg (fd,
+                        &mh,
+                        MSG_DONTWAIT))
+        return n;
+      if ((EAGAIN == errno) ||
+          (EWOULDBLOCK == errno))
+        return 0;
+      if ((EIO != errno) &&
+          (EINVAL != errno) &&
+          (ENOPROTOOPT != errno) &&
+          (EOPNOTSUPP != errno))
+      {
+        GNUNET_log_strerror (GNUNET_ERROR_TYPE_DEBUG,
+                             "sendmsg");
+        return n;
+      }
+      GNUNET_log (GNUNET_ERROR_TYPE_INFO,
+                  "UDP GSO not available, using sendmmsg\n");
+      gso_enabled = GNUNET_NO;
+    }
+  }
+#endif
+  {
+    struct mmsghdr msgs[MAX_SEND_BATCH];
+    unsigned int off;
+
+    memset (msgs,
+            0,
+            sizeof (struct mmsghdr) * n);
+    for (unsigned int i = 0; i < n; i++)
+    {
+      msgs[i].msg_hdr.msg_name = (void *) to;
+      msgs[i].msg_hdr.msg_namelen = to_len;
+      msgs[i].msg_hdr.msg_iov = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    off = 0;
+    while (off < n)
+    {
+      int ret;
+
+      ret = sendmmsg (fd,
+                      &msgs[off],
+                      n - off,
+                      MSG_DONTWAIT);
+      if (ret < 0)
+      {
+        if (EINTR == errno)
+          continue;
+        if ((EAGAIN == errno) ||
+            (EWOULDBLOCK == errno))
+          return off;
+        /* like a lost datagram, quiche retransmits */
+        GNUNET_log_strerror (GNUNET_ERROR_TYPE_DEBUG,
+                             "sendmmsg");
+        return n;
+      }
+      off += ret;
+    }
+  }
+#else
+  for (unsigned int i = 0; i < n; i++)
+  {
+    ssize_t sent;
+
+    sent = GNUNET_NETWORK_socket_sendto (udp_sock,
+                                         bufs[i],
+                                         lens[i],
+                                         (const struct sockaddr *) to,
+                                         to_len);
+    if ((-1 == sent) &&
+        ((EAGAIN == errno) ||
+         (EWOULDBLOCK == errno)))
+      return i;
+    if (sent != lens[i])
+    {
+      GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                  "quiche failed to send data to peer\n");
+      return n;
+    }
+  }
+#endif
+  return n;
+}
+
+
+/**
+ * How long until quiche's pacer wants a packet to go out?
+ *
+ * @param at the time quiche gave for the packet
+ * @return zero if the packet should be sent now
+ */
+static struct GNUNET_TIME_Relative
+pacing_delay (const struct timespec *at)
+{
+  struct timespec now;
+  int64_t delta_us;
+
+  if ((0 == at->tv_sec) &&
+      (0 == at->tv_nsec))
+    return GNUNET_TIME_UNIT_ZERO;
+  /* quiche's timestamps are taken from the monotonic clock */
+  GNUNET_assert (0 == clock_gettime (CLOCK_MONOTONIC,
+                                     &now));
+  delta_us = ((int64_t) at->tv_sec - (int64_t) now.tv_sec) * 1000000LL
+             + ((int64_t) at->tv_nsec - (int64_t) now.tv_nsec) / 1000;
+  if (delta_us < (int64_t) PACING_GRANULARITY.rel_value_us)
+    return GNUNET_TIME_UNIT_ZERO;
+  return GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MICROSECONDS,
+                                        delta_us);
+}
+
+
+static void
+peer_destroy (struct PeerAddress *peer);
+
+
+static void
+flush_egress (struct PeerAddress *peer);
+
+
+/**
+ * Let quiche handle an expired loss detection or idle timer.
+ *
+ * @param cls the `struct PeerAddress`
+ */
+static void
+handle_conn_timeout (void *cls)
+{
+  struct PeerAddress *peer = cls;
+
+  peer->timeout_task = NULL;
+  quiche_conn_on_timeout (peer->conn->conn);
+  flush_egress (peer);
+  if (quiche_conn_is_closed (peer->conn->conn))
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "connection to `%s' closed after timeout\n",
+                peer->foreign_addr);
+    peer_destroy (peer);
+  }
+}
+
+
+/**
+ * (Re)arm the task for the next timer deadline of quiche.  Must be
+ * called whenever quiche processed input or produced output.
+ *
+ * @param peer peer whose connection to check
+ */
 static void
-flush_egress (struct quic_conn *conn)
+update_conn_timeout (struct PeerAddress *peer)
 {
-  static uint8_t out[MAX_DATAGRAM_SIZE];
-  quiche_send_info send_info;
+  uint64_t ns;
+
+  if (NULL != peer->timeout_task)
+  {
+    GNUNET_SCHEDULER_cancel (peer->timeout_task);
+    peer->timeout_task = NULL;
+  }
+  ns = quiche_conn_timeout_as_nanos (peer->conn->conn);
+  if (UINT64_MAX == ns)
+    return;
+  /* round up, firing early would just re-arm the same deadline */
+  peer->timeout_task
+    = GNUNET_SCHEDULER_add_delayed (
+        GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MICROSECONDS,
+                                       (ns + 999) / 1000),
+        &handle_conn_timeout,
+        peer);
+}
+
+
+/**
+ * Continue sending once the pacer allows the held packet to go out.
+ *
+ * @param cls the `struct PeerAddress`
+ */
+static void
+pacing_cb (void *cls)
+{
+  struct PeerAddress *peer = cls;
+
+  peer->pacing_task = NULL;
+  flush_egress (peer);
+}
+
+
+/**
+ * Send the packets the kernel did not take earlier, then continue
+ * sending what quiche has for the peer.
+ *
+ * @param cls the `struct PeerAddress`
+ */
+static void
+write_cb (void *cls)
+{
+  struct PeerAddress *peer = cls;
+  unsigned int sent;
+
+  peer->write_task = NULL;
+  sent = send_batch (peer->blocked_buf,
+                     peer->blocked_len,
+                     peer->blocked_count,
+                     &peer->blocked_to,
+                     peer->blocked_to_len);
+  if (sent < peer->blocked_count)
+  {
+    peer->blocked_count -= sent;
+    memmove (peer->blocked_buf[0],
+             peer->blocked_buf[sent],
+             peer->blocked_count * MAX_DATAGRAM_SIZE);
+    memmove (&peer->blocked_len[0],
+             &peer->blocked_len[sent],
+             peer->blocked_count * sizeof (size_t));
+    peer->write_task
+      = GNUNET_SCHEDULER_add_write_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                        udp_sock,
+                                        &write_cb,
+                                        peer);
+    return;
+  }
+  peer->blocked_count = 0;
+  flush_egress (peer);
+}
 
+
+/**
+ * Keep the packets @a off to @a n of a batch that the kernel did
+ * not take, and send them once the socket is writable again.
+ *
+ * @param peer peer the packets are for
+ * @param bufs packets of the batch
+ * @param lens sizes of the packets in @a bufs
+ * @param off first packet that was not sent
+ * @param n number of packets in the batch
+ * @param to destination
+ * @param to_len length of @a to
+ */
+static void
+hold_blocked (struct PeerAddress *peer,
+              uint8_t bufs[][MAX_DATAGRAM_SIZE],
+              const size_t *lens,
+              unsigned int off,
+              unsigned int n,
+              const struct sockaddr_storage *to,
+              socklen_t to_len)
+{
+  GNUNET_assert (0 == peer->blocked_count);
+  GNUNET_assert (NULL == peer->write_task);
+  if (NULL == peer->blocked_buf)
+    peer->blocked_buf = GNUNET_malloc (MAX_SEND_BATCH * MAX_DATAGRAM_SIZE);
+  for (unsigned int i = off; i < n; i++)
+  {
+    GNUNET_memcpy (peer->blocked_buf[i - off],
+                   bufs[i],
+                   lens[i]);
+    peer->blocked_len[i - off] = lens[i];
+  }
+  peer->blocked_count = n - off;
+  peer->blocked_to = *to;
+  peer->blocked_to_len = to_len;
+  GNUNET_STATISTICS_update (stats,
+                            "# packets held for a full socket buffer",
+                            n - off,
+                            GNUNET_NO);
+  peer->write_task
+    = GNUNET_SCHEDULER_add_write_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                      udp_sock,
+                                      &write_cb,
+                                      peer);
+}
+
+
+/**
+ * Send everything quiche wants to send on the connection of @a peer,
+ * honoring the pacing time of each packet, and re-arm the timers.
+ * If the socket buffer is full, we stop asking quiche for packets
+ * until write_cb() sent the ones the kernel did not take.
+ *
+ * @param peer peer whose connection to flush
+ */
+static void
+flush_egress (struct PeerAddress *peer)
+{
+  static uint8_t out[MAX_SEND_BATCH][MAX_DATAGRAM_SIZE];
+  static size_t out_len[MAX_SEND_BATCH];
+  quiche_send_info send_info;
+  struct sockaddr_storage to;
+  socklen_t to_len;
+  unsigned int n;
+  unsigned int sent;
   ssize_t written;
-  ssize_t sent;
 
+  if ((NULL != peer->pacing_task) ||
+      (NULL != peer->write_task))
+  {
+    /* still waiting for the pacer or the socket, pacing_cb() or
+       write_cb() continues */
+    update_conn_timeout (peer);
+    return;
+  }
+  n = 0;
+  to_len = 0;
+  if (0 != peer->paced_len)
+  {
+    GNUNET_memcpy (out[0],
+                   peer->paced_buf,
+                   peer->paced_len);
+    out_len[0] = peer->paced_len;
+    to = peer->paced_to;
+    to_len = peer->paced_to_len;
+    peer->paced_len = 0;
+    n = 1;
+  }
   while (1)
   {
-    written = quiche_conn_send (conn->conn, out, sizeof(out), &send_info);
+    struct GNUNET_TIME_Relative delay;
+
+    if (MAX_SEND_BATCH == n)
+    {
+      sent = send_batch (out,
+                         out_len,
+                         n,
+                         &to,
+                         to_len);
+      if (sent < n)
+      {
+        hold_blocked (peer,
+                      out,
+                      out_len,
+                      sent,
+                      n,
+                      &to,
+                      to_len);
+        n = 0;
+        break;
+      }
+      n = 0;
+    }
+    written = quiche_conn_send (peer->conn->conn,
+                                out[n],
+                                MAX_DATAGRAM_SIZE,
+                                &send_info);
     if (QUICHE_ERR_DONE == written)
     {
       GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "done writing quic packets\n");
@@ -510,19 +994,81 @@ flush_egress (struct quic_conn *conn)
       GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
                   "quiche failed to create packet. quiche error: %zd\n",
                   written);
-      return;
+      break;
     }
-    sent = GNUNET_NETWORK_socket_sendto (udp_sock, out, written,
-                                         (struct sockaddr *) &send_info.to,
-                                         send_info.to_len);
-    if (sent != written)
+    if ((n > 0) &&
+        ((send_info.to_len != to_len) ||
+         (0 != memcmp (&send_info.to,
+                       &to,
+                       to_len))))
     {
-      GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
-                  "quiche failed to send data to peer\n");
-      return;
+      /* new destination (path migration), flush what we have */
+      sent = send_batch (out,
+                         out_len,
+                         n,
+                         &to,
+                         to_len);
+      if (sent < n)
+      {
+        hold_blocked (peer,
+                      out,
+                      out_len,
+                      sent,
+                      n,
+                      &to,
+                      to_len);
+        /* the new packet goes out after the ones we hold */
+        GNUNET_memcpy (peer->paced_buf,
+                       out[n],
+                       written);
+        peer->paced_len = written;
+        peer->paced_to = send_info.to;
+        peer->paced_to_len = send_info.to_len;
+        n = 0;
+        break;
+      }
+      memmove (out[0],
+               out[n],
+               written);
+      n = 0;
     }
-    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "sent %zd bytes\n", sent);
+    to = send_info.to;
+    to_len = send_info.to_len;
+    delay = pacing_delay (&send_info.at);
+    if (! GNUNET_TIME_relative_is_zero (delay))
+    {
+      /* hold the packet until quiche wants it on the wire */
+      GNUNET_memcpy (peer->paced_buf,
+                     out[n],
+                     written);
+      peer->paced_len = written;
+      peer->paced_to = to;
+      peer->paced_to_len = to_len;
+      peer->pacing_task = GNUNET_SCHEDULER_add_delayed (delay,
+                                                        &pacing_cb,
+                                                        peer);
+      break;
+    }
+    out_len[n++] = written;
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "queued %zd bytes\n", written);
+  }
+  if (n > 0)
+  {
+    sent = send_batch (out,
+                       out_len,
+                       n,
+                       &to,
+                       to_len);
+    if (sent < n)
+      hold_blocked (peer,
+                    out,
+                    out_len,
+                    sent,
+                    n,
+                    &to,
+                    to_len);
   }
+  update_conn_timeout (peer);
 }
 
 
@@ -555,6 +1101,21 @@ peer_destroy (struct PeerAddress *peer)
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Disconnecting peer for peer `%s'\n",
               GNUNET_i2s (&peer->target));
+  if (NULL != peer->timeout_task)
+  {
+    GNUNET_SCHEDULER_cancel (peer->timeout_task);
+    peer->timeout_task = NULL;
+  }
+  if (NULL != peer->pacing_task)
+  {
+    GNUNET_SCHEDULER_cancel (peer->pacing_task);
+    peer->pacing_task = NULL;
+  }
+  if (NULL != peer->write_task)
+  {
+    GNUNET_SCHEDULER_cancel (peer->write_task);
+    peer->write_task = NULL;
+  }
   if (NULL != peer->d_qh)
   {
     GNUNET_TRANSPORT_communicator_mq_del (peer->d_qh);
@@ -579,6 +1140,7 @@ peer_destroy (struct PeerAddress *peer)
   quiche_conn_free (peer->conn->conn);
   GNUNET_free (peer->address);
   GNUNET_free (peer->foreign_addr);
+  GNUNET_free (peer->blocked_buf);
   GNUNET_free (peer->conn);
   GNUNET_free (peer);
 }
@@ -655,7 +1217,7 @@ mq_send_d (struct GNUNET_MQ_Handle *mq,
                 "tried to send message and quiche returned %zd", send_len);
     return;
   }
-  flush_egress (peer->conn);
+  flush_egress (peer);
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "sent a message of %zd bytes\n", send_len);
   GNUNET_MQ_impl_send_continue (mq);
@@ -1141,7 +1703,7 @@ mq_init (void *cls, const struct GNUNET_PeerIdentity *peer_id, const
                                  local_addr,
                                  local_in_len, peer->address, peer->address_len,
                                  config);
-  flush_egress (peer->conn);
+  flush_egress (peer);
   GNUNET_free (local_addr);
   return GNUNET_OK;
   /**
@@ -1525,7 +2087,7 @@ sock_read (void *cls)
                     send_len);
         return;
       }
-      flush_egress (peer->conn);
+      flush_egress (peer);
       GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "peer identity sent to peer\n");
       peer->id_sent = GNUNET_YES;
       GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "setting up peer mq\n");
@@ -1558,7 +2120,7 @@ sock_read (void *cls)
     quiche_stats stats;
     quiche_path_stats path_stats;
 
-    flush_egress (peer->conn);
+    flush_egress (peer);
 
     if (quiche_conn_is_closed (peer->conn->conn))
     {
@@ -1731,6 +2293,7 @@ run (void *cls,
                                               &mq_init,
                                               NULL,
                                               &notify_cb,
+                                              NULL,
                                               NULL);
   is = GNUNET_NT_scanner_init ();
   nat = GNUNET_NAT_register (cfg,
@@ -64,7 +64,8 @@
 #define BROADCAST_FREQUENCY GNUNET_TIME_UNIT_MINUTES
 
 /**
- * How often do we scan for changes to our network interfaces?
+ * How often do we scan for changes to our network interfaces if
+ * we are not notified about them?
  */
 #define INTERFACE_SCAN_FREQUENCY \
         GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MINUTES, 5)
@@ -715,7 +716,8 @@ struct BroadcastInterface
   struct BroadcastInterface *prev;
 
   /**
-   * Task for this broadcast interface.
+   * Task for this broadcast interface, NULL if we only joined
+   * the multicast group.
    */
   struct GNUNET_SCHEDULER_Task *broadcast_task;
 
@@ -746,9 +748,9 @@ struct BroadcastInterface
   socklen_t salen;
 
   /**
-   * Was this interface found in the last #iface_proc() scan?
+   * Number of our interfaces having this address.
    */
-  int found;
+  unsigned int ifc_count;
 };
 
 /**
@@ -777,9 +779,9 @@ static struct GNUNET_SCHEDULER_Task *read_task;
 static struct GNUNET_SCHEDULER_Task *timeout_task;
 
 /**
- * ID of master broadcast task
+ * Monitor of our interfaces, for broadcasting.
  */
-static struct GNUNET_SCHEDULER_Task *broadcast_task;
+static struct GNUNET_OS_NetworkInterfaceMonitor *ifc_mon;
 
 /**
  * For logging statistics.
@@ -927,7 +929,8 @@ bi_destroy (struct BroadcastInterface *bi)
     }
   }
   GNUNET_CONTAINER_DLL_remove (bi_head, bi_tail, bi);
-  GNUNET_SCHEDULER_cancel (bi->broadcast_task);
+  if (NULL != bi->broadcast_task)
+    GNUNET_SCHEDULER_cancel (bi->broadcast_task);
   GNUNET_free (bi->sa);
   GNUNET_free (bi->ba);
   GNUNET_free (bi);
@@ -3125,13 +3128,13 @@ do_shutdown (void *cls)
     GNUNET_NAT_unregister (nat);
     nat = NULL;
   }
-  while (NULL != bi_head)
-    bi_destroy (bi_head);
-  if (NULL != broadcast_task)
+  if (NULL != ifc_mon)
   {
-    GNUNET_SCHEDULER_cancel (broadcast_task);
-    broadcast_task = NULL;
+    GNUNET_OS_network_interfaces_monitor_stop (ifc_mon);
+    ifc_mon = NULL;
   }
+  while (NULL != bi_head)
+    bi_destroy (bi_head);
   if (NULL != timeout_task)
   {
     GNUNET_SCHEDULER_cancel (timeout_task);
@@ -3385,27 +3388,28 @@ ifc_broadcast (void *cls)
 
 
 /**
- * Callback function invoked for each interface found.
- * Activates/deactivates broadcast interfaces.
+ * Callback function invoked whenever the addresses of our interfaces
+ * change.  Activates/deactivates broadcast interfaces.
  *
  * @param cls NULL
+ * @param change what happened
  * @param name name of the interface (can be NULL for unknown)
  * @param isDefault is this presumably the default interface
- * @param addr address of this interface (can be NULL for unknown or unassigned)
+ * @param addr address of this interface
  * @param broadcast_addr the broadcast address (can be NULL for unknown or
  * unassigned)
  * @param netmask the network mask (can be NULL for unknown or unassigned)
  * @param addrlen length of the address
- * @return #GNUNET_OK to continue iteration, #GNUNET_SYSERR to abort
  */
-static int
-iface_proc (void *cls,
-            const char *name,
-            int isDefault,
-            const struct sockaddr *addr,
-            const struct sockaddr *broadcast_addr,
-            const struct sockaddr *netmask,
-            socklen_t addrlen)
+static void
+iface_change_cb (void *cls,
+                 enum GNUNET_OS_NetworkInterfaceChange change,
+                 const char *name,
+                 int isDefault,
+                 const struct sockaddr *addr,
+                 const struct sockaddr *broadcast_addr,
+                 const struct sockaddr *netmask,
+                 socklen_t addrlen)
 {
   struct BroadcastInterface *bi;
   enum GNUNET_NetworkType network;
@@ -3413,27 +3417,36 @@ iface_proc (void *cls,
 
   (void) cls;
   (void) netmask;
-  if (NULL == addr)
-    return GNUNET_YES; /* need to know our address! */
+  if (GNUNET_OS_NIC_SYNCED == change)
+    return;
+  for (bi = bi_head; NULL != bi; bi = bi->next)
+    if ((bi->salen == addrlen) && (0 == memcmp (addr, bi->sa, addrlen)))
+      break;
+  if (GNUNET_OS_NIC_REMOVED == change)
+  {
+    if (NULL == bi)
+      return;
+    if (0 < --bi->ifc_count)
+      return; /* still on another interface */
+    bi_destroy (bi);
+    return;
+  }
+  if (NULL != bi)
+  {
+    /* same address on another interface */
+    bi->ifc_count++;
+    return;
+  }
   network = GNUNET_NT_scanner_get_type (is, addr, addrlen);
   if (GNUNET_NT_LOOPBACK == network)
   {
     /* Broadcasting on loopback does not make sense */
-    return GNUNET_YES;
-  }
-  for (bi = bi_head; NULL != bi; bi = bi->next)
-  {
-    if ((bi->salen == addrlen) && (0 == memcmp (addr, bi->sa, addrlen)))
-    {
-      bi->found = GNUNET_YES;
-      return GNUNET_OK;
-    }
+    return;
   }
-
   if ((AF_INET6 == addr->sa_family) && (NULL == broadcast_addr))
-    return GNUNET_OK; /* broadcast_addr is required for IPv6! */
+    return; /* broadcast_addr is required for IPv6! */
   if ((AF_INET6 == addr->sa_family) && (GNUNET_YES != have_v6_socket))
-    return GNUNET_OK; /* not using IPv6 */
+    return; /* not using IPv6 */
 
   bi = GNUNET_new (struct BroadcastInterface);
   bi->sa = GNUNET_memdup (addr,
@@ -3449,7 +3462,7 @@ iface_proc (void *cls,
     bi->ba = (struct sockaddr *) ba;
   }
   bi->salen = addrlen;
-  bi->found = GNUNET_YES;
+  bi->ifc_count = 1;
   bi->bcm.sender = my_identity;
   ubs.purpose.purpose = htonl (
     GNUNET_SIGNATURE_PURPOSE_COMMUNICATOR_UDP_BROADCAST);
@@ -3463,10 +3476,8 @@ iface_proc (void *cls,
                             &ubs,
                             &bi->bcm.sender_sig);
   if (NULL != bi->ba)
-  {
     bi->broadcast_task = GNUNET_SCHEDULER_add_now (&ifc_broadcast, bi);
-    GNUNET_CONTAINER_DLL_insert (bi_head, bi_tail, bi);
-  }
+  GNUNET_CONTAINER_DLL_insert (bi_head, bi_tail, bi);
   if ((AF_INET6 == addr->sa_family) && (NULL != broadcast_addr))
   {
     /* Create IPv6 multicast request */
@@ -3499,33 +3510,6 @@ iface_proc (void *cls,
       GNUNET_log_strerror (GNUNET_ERROR_TYPE_WARNING, "setsockopt");
     }
   }
-  return GNUNET_OK;
-}
-
-
-/**
- * Scan interfaces to broadcast our presence on the LAN.
- *
- * @param cls NULL, unused
- */
-static void
-do_broadcast (void *cls)
-{
-  struct BroadcastInterface *bin;
-
-  (void) cls;
-  for (struct BroadcastInterface *bi = bi_head; NULL != bi; bi = bi->next)
-    bi->found = GNUNET_NO;
-  GNUNET_OS_network_interfaces_list (&iface_proc, NULL);
-  for (struct BroadcastInterface *bi = bi_head; NULL != bi; bi = bin)
-  {
-    bin = bi->next;
-    if (GNUNET_NO == bi->found)
-      bi_destroy (bi);
-  }
-  broadcast_task = GNUNET_SCHEDULER_add_delayed (INTERFACE_SCAN_FREQUENCY,
-                                                 &do_broadcast,
-                                                 NULL);
 }
 
 
@@ -3786,7 +3770,10 @@ run (void *cls,
                                             COMMUNICATOR_CONFIG_SECTION,
                                             "DISABLE_BROADCAST"))
   {
-    broadcast_task = GNUNET_SCHEDULER_add_now (&do_broadcast, NULL);
+    ifc_mon = GNUNET_OS_network_interfaces_monitor_start (
+      INTERFACE_SCAN_FREQUENCY,
+      &iface_change_cb,
+      NULL);
   }
   nat = GNUNET_NAT_register (cfg,
                              COMMUNICATOR_CONFIG_SECTION,
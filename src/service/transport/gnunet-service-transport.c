@@ -319,6 +319,19 @@
  */
 #define QUEUE_LENGTH_LIMIT 32
 
+/**
+ * Number of size classes by which we index the pending messages of a
+ * virtual link that may be transmitted now: four per power of two,
+ * up to 64 KiB (see #get_ready_list()).
+ */
+#define PENDING_SIZE_CLASSES 44
+
+/**
+ * Number of ready lists per virtual link: one per size class for DV
+ * boxes we forward, and one per size class for all other messages.
+ */
+#define PENDING_READY_LISTS (2 * PENDING_SIZE_CLASSES)
+
 /**
  *
  */
@@ -1410,6 +1423,26 @@ struct VirtualLink
    */
   struct PendingMessage *pending_msg_tail;
 
+  /**
+   * Heads of the lists of messages pending for this VL that may be
+   * transmitted now, one per size class, each in the order in which
+   * the messages became ready.
+   */
+  struct PendingMessage *ready_head[PENDING_READY_LISTS];
+
+  /**
+   * Tails of the lists of messages pending for this VL that may be
+   * transmitted now.
+   */
+  struct PendingMessage *ready_tail[PENDING_READY_LISTS];
+
+  /**
+   * Heap with the messages pending for this VL that we must not
+   * (re)transmit before their `next_attempt`.  May be NULL if we
+   * never had such a message (lazy initialization).
+   */
+  struct GNUNET_CONTAINER_Heap *pending_wait_heap;
+
   /**
    * Kept in a DLL to clear @e vl in case @e vl is lost.
    */
@@ -2264,6 +2297,16 @@ struct PendingMessage
    */
   struct PendingMessage *prev_vl;
 
+  /**
+   * Kept in a ready list of @a vl if we may transmit this message now.
+   */
+  struct PendingMessage *next_ready;
+
+  /**
+   * Kept in a ready list of @a vl if we may transmit this message now.
+   */
+  struct PendingMessage *prev_ready;
+
   /**
    * Kept in a MDLL of messages from this @a client (if @e pmt is #PMT_CORE)
    */
@@ -2353,6 +2396,17 @@ struct PendingMessage
    */
   struct GNUNET_TIME_Absolute next_attempt;
 
+  /**
+   * Entry in the `pending_wait_heap` of @e vl while it is too early
+   * to (re)transmit this message, otherwise NULL.
+   */
+  struct GNUNET_CONTAINER_HeapNode *wait_hn;
+
+  /**
+   * Since when is this message in a ready list of @e vl?
+   */
+  struct GNUNET_TIME_Absolute ready_time;
+
   /**
    * UUID to use for this message (used for reassembly of fragments, only
    * initialized if @e msg_uuid_set is #GNUNET_YES).
@@ -2396,6 +2450,11 @@ struct PendingMessage
    */
   uint32_t frags_in_flight;
 
+  /**
+   * Is this message in a ready list of @e vl?
+   */
+  int ready;
+
   /**
    * The round we are (re)-sending fragments.
    */
@@ -3190,6 +3249,192 @@ free_fragment_tree (struct PendingMessage *root)
 }
 
 
+/**
+ * Determine the ready list of its virtual link in which @a pm
+ * belongs: by size class, in steps of a quarter of a power of two,
+ * with DV boxes in lists of their own.
+ *
+ * @param pm a top-level pending message
+ * @return index into the `ready_head` of the virtual link
+ */
+static unsigned int
+get_ready_list (const struct PendingMessage *pm)
+{
+  unsigned int size = pm->bytes_msg;
+  unsigned int sc;
+
+  if (size < 64)
+  {
+    sc = size / 16;
+  }
+  else
+  {
+    unsigned int bits = 6;
+
+    while (0 != (size >> (bits + 1)))
+      bits++;
+    sc = 4 + 4 * (bits - 6) + ((size >> (bits - 2)) & 3);
+  }
+  GNUNET_assert (sc < PENDING_SIZE_CLASSES);
+  if (PMT_DV_BOX == pm->pmt)
+    sc += PENDING_SIZE_CLASSES;
+  return sc;
+}
+
+
+/**
+ * Append @a pm to its ready list.
+ *
+ * @param pm a top-level pending message that may be transmitted now
+ * @param now the current time
+ */
+static void
+add_ready_pending_message (struct PendingMessage *pm,
+                           struct GNUNET_TIME_Absolute now)
+{
+  struct VirtualLink *vl = pm->vl;
+  unsigned int rl = get_ready_list (pm);
+
+  pm->ready = GNUNET_YES;
+  pm->ready_time = now;
+  GNUNET_CONTAINER_MDLL_insert_tail (ready,
+                                     vl->ready_head[rl],
+                                     vl->ready_tail[rl],
+                                     pm);
+}
+
+
+/**
+ * Remove @a pm from the transmission index of its virtual link.
+ *
+ * @param pm a top-level pending message
+ */
+static void
+unindex_pending_message (struct PendingMessage *pm)
+{
+  struct VirtualLink *vl = pm->vl;
+
+  if (GNUNET_YES == pm->ready)
+  {
+    unsigned int rl = get_ready_list (pm);
+
+    GNUNET_CONTAINER_MDLL_remove (ready,
+                                  vl->ready_head[rl],
+                                  vl->ready_tail[rl],
+                                  pm);
+    pm->ready = GNUNET_NO;
+  }
+  if (NULL != pm->wait_hn)
+  {
+    GNUNET_CONTAINER_heap_remove_node (pm->wait_hn);
+    pm->wait_hn = NULL;
+  }
+}
+
+
+/**
+ * (Re)index @a pm for transmission after it was added to its virtual
+ * link or its `next_attempt`, `frags_in_flight` or `qe` changed.  If
+ * we may transmit it now, it goes to (or stays in) its ready list;
+ * otherwise it waits in the `pending_wait_heap` for its next attempt.
+ * Messages that are being given to a communicator are not indexed.
+ *
+ * @param pm a top-level pending message
+ */
+static void
+index_pending_message (struct PendingMessage *pm)
+{
+  struct VirtualLink *vl = pm->vl;
+  struct GNUNET_TIME_Absolute now;
+
+  if (NULL != pm->qe)
+  {
+    unindex_pending_message (pm);
+    return;
+  }
+  now = GNUNET_TIME_absolute_get ();
+  if ((GNUNET_YES == pm->frags_in_flight) ||
+      (pm->next_attempt.abs_value_us <= now.abs_value_us))
+  {
+    if (GNUNET_YES == pm->ready)
+      return; /* keep our place in the ready list */
+    unindex_pending_message (pm);
+    add_ready_pending_message (pm,
+                               now);
+    return;
+  }
+  if (NULL != pm->wait_hn)
+  {
+    GNUNET_CONTAINER_heap_update_cost (pm->wait_hn,
+                                       pm->next_attempt.abs_value_us);
+    return;
+  }
+  unindex_pending_message (pm);
+  if (NULL == vl->pending_wait_heap)
+    vl->pending_wait_heap =
+      GNUNET_CONTAINER_heap_create (GNUNET_CONTAINER_HEAP_ORDER_MIN);
+  pm->wait_hn = GNUNET_CONTAINER_heap_insert (vl->pending_wait_heap,
+                                              pm,
+                                              pm->next_attempt.abs_value_us);
+}
+
+
+/**
+ * Move the messages of @a vl whose next attempt is due from the
+ * `pending_wait_heap` to their ready lists.
+ *
+ * @param vl virtual link to update
+ * @param now the current time
+ */
+static void
+wake_pending_messages (struct VirtualLink *vl,
+                       struct GNUNET_TIME_Absolute now)
+{
+  void *element;
+  GNUNET_CONTAINER_HeapCostType next_attempt;
+
+  if (NULL == vl->pending_wait_heap)
+    return;
+  while ((GNUNET_YES ==
+          GNUNET_CONTAINER_heap_peek2 (vl->pending_wait_heap,
+                                       &element,
+                                       &next_attempt)) &&
+         (next_attempt <= now.abs_value_us))
+  {
+    struct PendingMessage *pm = element;
+
+    GNUNET_CONTAINER_heap_remove_root (vl->pending_wait_heap);
+    pm->wait_hn = NULL;
+    add_ready_pending_message (pm,
+                               now);
+  }
+}
+
+
+/**
+ * Find a message pending on @a vl that is not being given to a
+ * communicator right now, preferring small messages we may transmit
+ * now.
+ *
+ * @param vl virtual link to check
+ * @return NULL if there is no such message
+ */
+static struct PendingMessage *
+peek_pending_message (struct VirtualLink *vl)
+{
+  for (unsigned int sc = 0; sc < PENDING_SIZE_CLASSES; sc++)
+  {
+    if (NULL != vl->ready_head[sc])
+      return vl->ready_head[sc];
+    if (NULL != vl->ready_head[PENDING_SIZE_CLASSES + sc])
+      return vl->ready_head[PENDING_SIZE_CLASSES + sc];
+  }
+  if (NULL == vl->pending_wait_heap)
+    return NULL;
+  return GNUNET_CONTAINER_heap_peek (vl->pending_wait_heap);
+}
+
+
 /**
  * Release memory associated with @a pm and remove @a pm from associated
  * data structures.  @a pm must be a top-level pending message and not
@@ -3219,6 +3464,7 @@ free_pending_message (struct PendingMessage *pm)
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                 "Removing pm %" PRIu64 "\n",
                 pm->logging_uuid);
+    unindex_pending_message (pm);
     GNUNET_CONTAINER_MDLL_remove (vl,
                                   vl->pending_msg_head,
                                   vl->pending_msg_tail,
@@ -3376,6 +3622,11 @@ free_virtual_link (struct VirtualLink *vl)
   }
   while (NULL != (pm = vl->pending_msg_head))
     free_pending_message (pm);
+  if (NULL != vl->pending_wait_heap)
+  {
+    GNUNET_CONTAINER_heap_destroy (vl->pending_wait_heap);
+    vl->pending_wait_heap = NULL;
+  }
   GNUNET_assert (GNUNET_YES ==
                  GNUNET_CONTAINER_multipeermap_remove (links, &vl->target, vl));
   if (NULL != vl->visibility_task)
@@ -4052,6 +4303,8 @@ free_queue (struct Queue *queue)
     {
       GNUNET_assert (qe == qe->pm->qe);
       qe->pm->qe = NULL;
+      if (NULL == qe->pm->frag_parent)
+        index_pending_message (qe->pm);
     }
     GNUNET_free (qe);
   }
@@ -4818,6 +5071,8 @@ queue_send_msg (struct Queue *queue,
         pm->qe->pm = NULL;
       }
       pm->qe = qe;
+      if (NULL == pm->frag_parent)
+        index_pending_message (pm);
     }
     GNUNET_assert (CT_COMMUNICATOR == queue->tc->type);
     if (0 == queue->q_capacity)
@@ -4831,6 +5086,8 @@ queue_send_msg (struct Queue *queue,
                     pm->logging_uuid,
                     pm->pmt);
         pm->qe = NULL;
+        if (NULL == pm->frag_parent)
+          index_pending_message (pm);
       }
       GNUNET_free (env);
       GNUNET_free (qe);
@@ -5555,9 +5812,8 @@ consider_sending_fc (void *cls)
 
 
 /**
- * There is a message at the head of the pending messages for @a vl
- * which may be ready for transmission. Check if a queue is ready to
- * take it.
+ * There may be a message pending for @a vl which is ready for
+ * transmission. Check if a queue is ready to take it.
  *
  * This function must (1) check for flow control to ensure that we can
  * right now send to @a vl, (2) check that the pending message in the
@@ -5577,6 +5833,7 @@ check_vl_transmission (struct VirtualLink *vl)
   struct DistanceVector *dv = vl->dv;
   struct GNUNET_TIME_Absolute now;
   struct VirtualLink *vl_next_hop;
+  struct PendingMessage *pm;
   int elig;
 
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
@@ -5584,121 +5841,115 @@ check_vl_transmission (struct VirtualLink *vl)
               GNUNET_i2s (&vl->target));
   /* Check that we have an eligible pending message!
      (cheaper than having #transmit_on_queue() find out!) */
+  pm = peek_pending_message (vl);
+  if (NULL == pm)
+    return;
   elig = GNUNET_NO;
-  for (struct PendingMessage *pm = vl->pending_msg_head; NULL != pm;
-       pm = pm->next_vl)
+  if (pm->bytes_msg + vl->outbound_fc_window_size_used >
+      vl->outbound_fc_window_size)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                "check_vl_transmission loop\n");
-    if (NULL != pm->qe)
-      continue;   /* not eligible, is in a queue! */
-    if (pm->bytes_msg + vl->outbound_fc_window_size_used >
-        vl->outbound_fc_window_size)
-    {
-      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                  "Stalled message %" PRIu64
-                  " transmission on VL %s due to flow control: %llu < %llu\n",
-                  pm->logging_uuid,
-                  GNUNET_i2s (&vl->target),
-                  (unsigned long long) vl->outbound_fc_window_size,
-                  (unsigned long long) (pm->bytes_msg
-                                        + vl->outbound_fc_window_size_used));
-      consider_sending_fc (vl);
-      return;     /* We have a message, but flow control says "nope" */
-    }
-    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                "Target window on VL %s not stalled. Scheduling transmission on queue\n",
-                GNUNET_i2s (&vl->target));
-    /* Notify queues at direct neighbours that we are interested */
-    now = GNUNET_TIME_absolute_get ();
-    if (NULL != n)
+                "Stalled message %" PRIu64
+                " transmission on VL %s due to flow control: %llu < %llu\n",
+                pm->logging_uuid,
+                GNUNET_i2s (&vl->target),
+                (unsigned long long) vl->outbound_fc_window_size,
+                (unsigned long long) (pm->bytes_msg
+                                      + vl->outbound_fc_window_size_used));
+    consider_sending_fc (vl);
+    return;     /* We have a message, but flow control says "nope" */
+  }
+  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+              "Target window on VL %s not stalled. Scheduling transmission on queue\n",
+              GNUNET_i2s (&vl->target));
+  /* Notify queues at direct neighbours that we are interested */
+  now = GNUNET_TIME_absolute_get ();
+  if (NULL != n)
+  {
+    for (struct Queue *queue = n->queue_head; NULL != queue;
+         queue = queue->next_neighbour)
     {
-      for (struct Queue *queue = n->queue_head; NULL != queue;
-           queue = queue->next_neighbour)
+      if ((GNUNET_YES == queue->idle) &&
+          (queue->validated_until.abs_value_us > now.abs_value_us))
       {
-        if ((GNUNET_YES == queue->idle) &&
-            (queue->validated_until.abs_value_us > now.abs_value_us))
-        {
-          GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                      "Direct neighbour %s not stalled\n",
-                      GNUNET_i2s (&n->pid));
-          schedule_transmit_on_queue (GNUNET_TIME_UNIT_ZERO,
-                                      queue,
-                                      GNUNET_SCHEDULER_PRIORITY_DEFAULT);
-          elig = GNUNET_YES;
-        }
-        else
-          GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                      "Neighbour Queue QID: %u (%u) busy or invalid\n",
-                      queue->qid,
-                      queue->idle);
+        GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                    "Direct neighbour %s not stalled\n",
+                    GNUNET_i2s (&n->pid));
+        schedule_transmit_on_queue (GNUNET_TIME_UNIT_ZERO,
+                                    queue,
+                                    GNUNET_SCHEDULER_PRIORITY_DEFAULT);
+        elig = GNUNET_YES;
       }
+      else
+        GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                    "Neighbour Queue QID: %u (%u) busy or invalid\n",
+                    queue->qid,
+                    queue->idle);
     }
-    /* Notify queues via DV that we are interested */
-    if (NULL != dv)
+  }
+  /* Notify queues via DV that we are interested */
+  if (NULL != dv)
+  {
+    /* Do DV with lower scheduler priority, which effectively means that
+       IF a neighbour exists and is available, we prefer it. */
+    for (struct DistanceVectorHop *pos = dv->dv_head; NULL != pos;
+         pos = pos->next_dv)
     {
-      /* Do DV with lower scheduler priority, which effectively means that
-         IF a neighbour exists and is available, we prefer it. */
-      for (struct DistanceVectorHop *pos = dv->dv_head; NULL != pos;
-           pos = pos->next_dv)
-      {
-        struct Neighbour *nh_iter = pos->next_hop;
+      struct Neighbour *nh_iter = pos->next_hop;
 
 
-        if (pos->path_valid_until.abs_value_us <= now.abs_value_us)
-          continue;   /* skip this one: path not validated */
-        else
+      if (pos->path_valid_until.abs_value_us <= now.abs_value_us)
+        continue;   /* skip this one: path not validated */
+      else
+      {
+        vl_next_hop = lookup_virtual_link (&nh_iter->pid);
+        GNUNET_assert (NULL != vl_next_hop);
+        if (pm->bytes_msg + vl_next_hop->outbound_fc_window_size_used >
+            vl_next_hop->outbound_fc_window_size)
         {
-          vl_next_hop = lookup_virtual_link (&nh_iter->pid);
-          GNUNET_assert (NULL != vl_next_hop);
-          if (pm->bytes_msg + vl_next_hop->outbound_fc_window_size_used >
-              vl_next_hop->outbound_fc_window_size)
+          GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                      "Stalled message %" PRIu64
+                      " transmission on next hop %s due to flow control: %llu < %llu\n",
+                      pm->logging_uuid,
+                      GNUNET_i2s (&vl_next_hop->target),
+                      (unsigned long
+                       long) vl_next_hop->outbound_fc_window_size,
+                      (unsigned long long) (pm->bytes_msg
+                                            + vl_next_hop->
+                                            outbound_fc_window_size_used));
+          consider_sending_fc (vl_next_hop);
+          continue; /* We have a message, but flow control says "nope" for the first hop of this path */
+        }
+        for (struct Queue *queue = nh_iter->queue_head; NULL != queue;
+             queue = queue->next_neighbour)
+          if ((GNUNET_YES == queue->idle) &&
+              (queue->validated_until.abs_value_us > now.abs_value_us))
           {
             GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                        "Stalled message %" PRIu64
-                        " transmission on next hop %s due to flow control: %llu < %llu\n",
-                        pm->logging_uuid,
-                        GNUNET_i2s (&vl_next_hop->target),
-                        (unsigned long
-                         long) vl_next_hop->outbound_fc_window_size,
-                        (unsigned long long) (pm->bytes_msg
-                                              + vl_next_hop->
-                                              outbound_fc_window_size_used));
-            consider_sending_fc (vl_next_hop);
-            continue; /* We have a message, but flow control says "nope" for the first hop of this path */
+                        "Next hop neighbour %s not stalled\n",
+                        GNUNET_i2s (&nh_iter->pid));
+            schedule_transmit_on_queue (GNUNET_TIME_UNIT_ZERO,
+                                        queue,
+                                        GNUNET_SCHEDULER_PRIORITY_BACKGROUND);
+            elig = GNUNET_YES;
           }
-          for (struct Queue *queue = nh_iter->queue_head; NULL != queue;
-               queue = queue->next_neighbour)
-            if ((GNUNET_YES == queue->idle) &&
-                (queue->validated_until.abs_value_us > now.abs_value_us))
-            {
-              GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                          "Next hop neighbour %s not stalled\n",
-                          GNUNET_i2s (&nh_iter->pid));
-              schedule_transmit_on_queue (GNUNET_TIME_UNIT_ZERO,
-                                          queue,
-                                          GNUNET_SCHEDULER_PRIORITY_BACKGROUND);
-              elig = GNUNET_YES;
-            }
-            else
-              GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                          "DV Queue QID: %u (%u) busy or invalid\n",
-                          queue->qid,
-                          queue->idle);
-        }
+          else
+            GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                        "DV Queue QID: %u (%u) busy or invalid\n",
+                        queue->qid,
+                        queue->idle);
       }
     }
-    if (GNUNET_YES == elig)
-      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                  "Eligible message %" PRIu64 " of size %u to %s: %llu/%llu\n",
-                  pm->logging_uuid,
-                  pm->bytes_msg,
-                  GNUNET_i2s (&vl->target),
-                  (unsigned long long) vl->outbound_fc_window_size,
-                  (unsigned long long) (pm->bytes_msg
-                                        + vl->outbound_fc_window_size_used));
-    break;
   }
+  if (GNUNET_YES == elig)
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "Eligible message %" PRIu64 " of size %u to %s: %llu/%llu\n",
+                pm->logging_uuid,
+                pm->bytes_msg,
+                GNUNET_i2s (&vl->target),
+                (unsigned long long) vl->outbound_fc_window_size,
+                (unsigned long long) (pm->bytes_msg
+                                      + vl->outbound_fc_window_size_used));
 }
 
 
@@ -5766,6 +6017,7 @@ handle_client_send (void *cls, const struct OutboundMessage *obm)
                                 vl->pending_msg_head,
                                 vl->pending_msg_tail,
                                 pm);
+  index_pending_message (pm);
   check_vl_transmission (vl);
   GNUNET_SERVICE_client_continue (tc->client);
 }
@@ -7319,7 +7571,7 @@ send_msg_from_cache (struct VirtualLink *vl)
                                       vl->pending_msg_head,
                                       vl->pending_msg_tail,
                                       pm);
-
+        index_pending_message (pm);
         check_vl_transmission (vl);
       }
       else
@@ -8464,7 +8716,7 @@ forward_dv_box (struct Neighbour *next_hop,
                                     vl->pending_msg_head,
                                     vl->pending_msg_tail,
                                     pm);
-
+      index_pending_message (pm);
       check_vl_transmission (vl);
     }
     else
@@ -10525,30 +10777,6 @@ reliability_box_message (struct Queue *queue,
 }
 
 
-static void
-reorder_root_pm (struct PendingMessage *pm,
-                 struct GNUNET_TIME_Absolute next_attempt)
-{
-  struct VirtualLink *vl = pm->vl;
-  struct PendingMessage *pos;
-
-  /* re-insert sort in neighbour list */
-  GNUNET_CONTAINER_MDLL_remove (vl,
-                                vl->pending_msg_head,
-                                vl->pending_msg_tail,
-                                pm);
-  pos = vl->pending_msg_tail;
-  while ((NULL != pos) &&
-         (next_attempt.abs_value_us > pos->next_attempt.abs_value_us))
-    pos = pos->prev_vl;
-  GNUNET_CONTAINER_MDLL_insert_after (vl,
-                                      vl->pending_msg_head,
-                                      vl->pending_msg_tail,
-                                      pos,
-                                      pm);
-}
-
-
 static unsigned int
 check_next_attempt_tree (struct PendingMessage *pm, struct PendingMessage *root)
 {
@@ -10590,8 +10818,8 @@ harmonize_flight_round (struct PendingMessage *pm)
 
 /**
  * Change the value of the `next_attempt` field of @a pm
- * to @a next_attempt and re-order @a pm in the transmission
- * list as required by the new timestamp.
+ * to @a next_attempt and re-index the top-level message of
+ * @a pm for transmission as required by the new timestamp.
  *
  * @param pm a pending message to update
  * @param next_attempt timestamp to use
@@ -10607,7 +10835,7 @@ update_pm_next_attempt (struct PendingMessage *pm,
                 "Next attempt for message <%" PRIu64 "> set to %" PRIu64 "\n",
                 pm->logging_uuid,
                 next_attempt.abs_value_us);
-    reorder_root_pm (pm, next_attempt);
+    index_pending_message (pm);
   }
   else if ((PMT_RELIABILITY_BOX == pm->pmt) || (PMT_DV_BOX == pm->pmt))// || (PMT_FRAGMENT_BOX == pm->pmt))
   {
@@ -10620,7 +10848,7 @@ update_pm_next_attempt (struct PendingMessage *pm,
                 root->logging_uuid,
                 GNUNET_STRINGS_absolute_time_to_string (next_attempt));
     root->next_attempt = next_attempt;
-    reorder_root_pm (root, next_attempt);
+    index_pending_message (root);
   }
   else
   {
@@ -10662,9 +10890,10 @@ update_pm_next_attempt (struct PendingMessage *pm,
                   ", reorder root! Next attempt is %" PRIu64 "\n",
                   root->logging_uuid,
                   root->next_attempt.abs_value_us);
-      if (PMT_DV_BOX == root->pmt)
+      if ((PMT_DV_BOX == root->pmt) &&
+          (NULL != root->frag_parent))
         root = root->frag_parent;
-      reorder_root_pm (root, root->next_attempt);
+      index_pending_message (root);
       // root->next_attempt = GNUNET_TIME_UNIT_ZERO_ABS;
     }
     else
@@ -10692,6 +10921,11 @@ update_pm_next_attempt (struct PendingMessage *pm,
                   ", do not reorder root! Actual next attempt %" PRIu64 "\n",
                   root->logging_uuid,
                   root->next_attempt.abs_value_us);
+      /* with fragments in flight, a top-level message may be picked
+         regardless of its next attempt */
+      if ((NULL == root->frag_parent) &&
+          (GNUNET_YES != root->ready))
+        index_pending_message (root);
     }
   }
 }
@@ -10717,6 +10951,17 @@ struct PendingMessageScoreContext
    */
   size_t real_overhead;
 
+  /**
+   * Largest message (plus overhead) that another queue to the same
+   * neighbour can transmit without fragmentation, 0 for none.
+   */
+  size_t other_mtu;
+
+  /**
+   * Score of @e best, lower is better.
+   */
+  long long score;
+
   /**
    * Number of pending messages we seriously considered this time.
    */
@@ -10737,11 +10982,6 @@ struct PendingMessageScoreContext
    */
   int to_early;
 
-  /**
-   * There is a pending messages we are sending fragments at the moment.
-   */
-  unsigned int frags_in_flight;
-
   /**
    * When will we try to transmit the message again for which it was to early to retry.
    */
@@ -10749,10 +10989,93 @@ struct PendingMessageScoreContext
 };
 
 
+/**
+ * Determine how @a pm would have to be transmitted via @a queue.
+ *
+ * @param pm top-level pending message to check
+ * @param queue the queue that would be used for transmission
+ * @param overhead number of bytes of overhead to be expected
+ *        from DV encapsulation (0 for without DV)
+ * @param[out] frag set to #GNUNET_YES if we have to fragment
+ * @param[out] relb set to #GNUNET_YES if we have to reliability box
+ * @return the estimated total overhead
+ */
+static size_t
+get_transmission_overhead (const struct PendingMessage *pm,
+                           const struct Queue *queue,
+                           size_t overhead,
+                           int *frag,
+                           int *relb)
+{
+  size_t real_overhead = overhead;
+
+  /* determine if we have to fragment, if so add fragmentation
+     overhead! */
+  *frag = GNUNET_NO;
+  *relb = GNUNET_NO;
+  if (((0 != queue->mtu) &&
+       (pm->bytes_msg + real_overhead > queue->mtu)) ||
+      (pm->bytes_msg > UINT16_MAX - sizeof(struct
+                                           GNUNET_TRANSPORT_SendMessageTo))
+      ||
+      (NULL != pm->head_frag /* fragments already exist, should
+                                respect that even if MTU is UINT16_MAX for
+                                this queue */))
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "fragment msg with size %u, realoverhead is %lu\n",
+                pm->bytes_msg,
+                real_overhead);
+    *frag = GNUNET_YES;
+    if (GNUNET_TRANSPORT_CC_RELIABLE == queue->tc->details.communicator.cc)
+    {
+      /* FIXME-FRAG-REL-UUID: we could use an optimized, shorter fragmentation
+         header without the ACK UUID when using a *reliable* channel! */
+    }
+    return overhead + sizeof(struct TransportFragmentBoxMessage);
+  }
+  /* determine if we have to reliability-box, if so add reliability box
+     overhead */
+  if ((0 == (pm->prefs & GNUNET_MQ_PREF_UNRELIABLE)) &&
+      (GNUNET_TRANSPORT_CC_RELIABLE != queue->tc->details.communicator.cc))
+  {
+    real_overhead += sizeof(struct TransportReliabilityBoxMessage);
+
+    if ((0 != queue->mtu) && (pm->bytes_msg + real_overhead > queue->mtu))
+    {
+      *frag = GNUNET_YES;
+      real_overhead = overhead + sizeof(struct TransportFragmentBoxMessage);
+    }
+    else
+    {
+      *relb = GNUNET_YES;
+    }
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "Create reliability box of msg with size %u, realoverhead is %lu %u %u %u\n",
+                pm->bytes_msg,
+                real_overhead,
+                queue->mtu,
+                *frag,
+                *relb);
+  }
+  return real_overhead;
+}
+
+
 /**
  * Select the best pending message from @a vl for transmission
  * via @a queue.
  *
+ * Only the oldest message of each ready list competes, so the cost
+ * does not depend on how many messages are pending.  Messages are
+ * scored as follows (lower is better): fragmenting costs 40 and
+ * reliability boxing 20 on top of the overhead; a message that fits
+ * the MTU of @a queue is charged the space it leaves unused, so the
+ * best fit wins; a message we would have to fragment but that another
+ * queue of the neighbour takes as a whole is charged the MTU, so it
+ * waits for that queue.  Every millisecond a message has been ready
+ * earns it a point, ten if it prefers low latency.
+ *
  * @param[in,out] sc best message so far (NULL for none), plus scoring data
  * @param queue the queue that will be used for transmission
  * @param vl the virtual link providing the messages
@@ -10768,160 +11091,82 @@ select_best_pending_from_link (struct PendingMessageScoreContext *sc,
                                size_t overhead)
 {
   struct GNUNET_TIME_Absolute now;
+  /* DV messages must not be DV-routed to next hop! */
+  unsigned int lists = (NULL == dvh)
+                       ? PENDING_READY_LISTS
+                       : PENDING_SIZE_CLASSES;
 
   now = GNUNET_TIME_absolute_get ();
-  sc->to_early = GNUNET_NO;
-  sc->frags_in_flight = GNUNET_NO;
-  for (struct PendingMessage *pos = vl->pending_msg_head; NULL != pos;
-       pos = pos->next_vl)
-  {
-    size_t real_overhead = overhead;
+  wake_pending_messages (vl,
+                         now);
+  for (unsigned int rl = 0; rl < lists; rl++)
+  {
+    struct PendingMessage *pos = vl->ready_head[rl];
+    size_t real_overhead;
+    long long score;
+    long long age;
     int frag;
     int relb;
 
-    if ((NULL != dvh) && (PMT_DV_BOX == pos->pmt))
-    {
-      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                  "DV messages must not be DV-routed to next hop!\n");
-      continue;   /* DV messages must not be DV-routed to next hop! */
-    }
-    if (pos->next_attempt.abs_value_us > now.abs_value_us)
-    {
-      if (GNUNET_YES == pos->frags_in_flight)
-      {
-        sc->frags_in_flight = GNUNET_YES;
-        GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                    "Fragments in flight for message %" PRIu64 "\n",
-                    pos->logging_uuid);
-      }
-      else
-      {
-        GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                    "Maybe too early, because message are sorted by next_attempt, if there are no fragments in flight.Checked message %"
-                    PRIu64 "\n",
-                    pos->logging_uuid);
-        sc->to_early = GNUNET_YES;
-        sc->to_early_retry_delay = GNUNET_TIME_absolute_get_remaining (
-          pos->next_attempt);
-        continue;
-      }
-      // break;   /* too early for all messages, they are sorted by next_attempt */
-    }
-    if (NULL != pos->qe)
-    {
-      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                  "not eligible\n");
-      continue;   /* not eligible */
-    }
+    if (NULL == pos)
+      continue;
+    GNUNET_assert (NULL == pos->qe);
     sc->consideration_counter++;
-    /* determine if we have to fragment, if so add fragmentation
-       overhead! */
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                 "check %" PRIu64 " for sc->best\n",
                 pos->logging_uuid);
-    frag = GNUNET_NO;
-    if (((0 != queue->mtu) &&
-         (pos->bytes_msg + real_overhead > queue->mtu)) ||
-        (pos->bytes_msg > UINT16_MAX - sizeof(struct
-                                              GNUNET_TRANSPORT_SendMessageTo))
-        ||
-        (NULL != pos->head_frag /* fragments already exist, should
-                                     respect that even if MTU is UINT16_MAX for
-                                     this queue */))
-    {
-      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                  "fragment msg with size %u, realoverhead is %lu\n",
-                  pos->bytes_msg,
-                  real_overhead);
-      frag = GNUNET_YES;
-      if (GNUNET_TRANSPORT_CC_RELIABLE == queue->tc->details.communicator.cc)
-      {
-        /* FIXME-FRAG-REL-UUID: we could use an optimized, shorter fragmentation
-           header without the ACK UUID when using a *reliable* channel! */
-      }
-      real_overhead = overhead + sizeof(struct TransportFragmentBoxMessage);
-    }
-    /* determine if we have to reliability-box, if so add reliability box
-       overhead */
-    relb = GNUNET_NO;
-    if ((GNUNET_NO == frag) &&
-        (0 == (pos->prefs & GNUNET_MQ_PREF_UNRELIABLE)) &&
-        (GNUNET_TRANSPORT_CC_RELIABLE != queue->tc->details.communicator.cc))
+    real_overhead = get_transmission_overhead (pos,
+                                               queue,
+                                               overhead,
+                                               &frag,
+                                               &relb);
+    score = frag * 40 + relb * 20 + real_overhead;
+    if ((0 != queue->mtu) &&
+        (queue->mtu >= real_overhead + pos->bytes_msg))
+      score += queue->mtu - (real_overhead + pos->bytes_msg);
+    if ((GNUNET_YES == frag) &&
+        (NULL == pos->head_frag) &&
+        (sc->other_mtu >= overhead + pos->bytes_msg))
+      score += queue->mtu;
+    age = GNUNET_TIME_absolute_get_difference (pos->ready_time,
+                                               now).rel_value_us / 1000LL;
+    if (0 != (pos->prefs & GNUNET_MQ_PREF_LOW_LATENCY))
+      age *= 10;
+    score -= age;
+    if ((NULL != sc->best) &&
+        (score >= sc->score))
     {
-      real_overhead += sizeof(struct TransportReliabilityBoxMessage);
-
-      if ((0 != queue->mtu) && (pos->bytes_msg + real_overhead > queue->mtu))
-      {
-        frag = GNUNET_YES;
-        real_overhead = overhead + sizeof(struct TransportFragmentBoxMessage);
-      }
-      else
-      {
-        relb = GNUNET_YES;
-      }
       GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                  "Create reliability box of msg with size %u, realoverhead is %lu %u %u %u\n",
-                  pos->bytes_msg,
-                  real_overhead,
-                  queue->mtu,
-                  frag,
-                  relb);
-    }
-
-    /* Finally, compare to existing 'best' in sc to see if this 'pos' pending
-       message would beat it! */
-    if (GNUNET_NO == sc->frags_in_flight && NULL != sc->best)
-    {
-      /* CHECK if pos fits queue BETTER (=smaller) than pm, if not: continue;
-         OPTIMIZE-ME: This is a heuristic, which so far has NOT been
-         experimentally validated. There may be some huge potential for
-         improvement here. Also, we right now only compare how well the
-         given message fits _this_ queue, and do not consider how well other
-         queues might suit the message. Taking other queues into consideration
-         may further improve the result, but could also be expensive
-         in terms of CPU time.  */
-      long long sc_score = sc->frag * 40 + sc->relb * 20 + sc->real_overhead;
-      long long pm_score = frag * 40 + relb * 20 + real_overhead;
-      long long time_delta =
-        (sc->best->next_attempt.abs_value_us - pos->next_attempt.abs_value_us)
-        / 1000LL;
-
-      /* "time_delta" considers which message has been 'ready' for transmission
-         for longer, if a message has a preference for low latency, increase
-         the weight of the time_delta by 10x if it is favorable for that message */
-      if ((0 != (pos->prefs & GNUNET_MQ_PREF_LOW_LATENCY)) &&
-          (0 != (sc->best->prefs & GNUNET_MQ_PREF_LOW_LATENCY)))
-        time_delta *= 10;     /* increase weight (always, both are low latency) */
-      else if ((0 != (pos->prefs & GNUNET_MQ_PREF_LOW_LATENCY)) &&
-               (time_delta > 0))
-        time_delta *= 10;     /* increase weight, favors 'pos', which is low latency */
-      else if ((0 != (sc->best->prefs & GNUNET_MQ_PREF_LOW_LATENCY)) &&
-               (time_delta < 0))
-        time_delta *= 10;     /* increase weight, favors 'sc->best', which is low latency */
-      if (0 != queue->mtu)
-      {
-        /* Grant bonus if we are below MTU, larger bonus the closer we will
-           be to the MTU */
-        if (queue->mtu > sc->real_overhead + sc->best->bytes_msg)
-          sc_score -= queue->mtu - (sc->real_overhead + sc->best->bytes_msg);
-        if (queue->mtu > real_overhead + pos->bytes_msg)
-          pm_score -= queue->mtu - (real_overhead + pos->bytes_msg);
-      }
-      if (sc_score + time_delta > pm_score)
-      {
-        GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                    "sc_score of %" PRIu64 " larger, keep sc->best %" PRIu64
-                    "\n",
-                    pos->logging_uuid,
-                    sc->best->logging_uuid);
-        continue;     /* sc_score larger, keep sc->best */
-      }
+                  "score of %" PRIu64 " not lower, keep sc->best %" PRIu64
+                  "\n",
+                  pos->logging_uuid,
+                  sc->best->logging_uuid);
+      continue;
     }
     sc->best = pos;
     sc->dvh = dvh;
     sc->frag = frag;
     sc->relb = relb;
     sc->real_overhead = real_overhead;
+    sc->score = score;
+  }
+  if ((NULL != vl->pending_wait_heap) &&
+      (0 < GNUNET_CONTAINER_heap_get_size (vl->pending_wait_heap)))
+  {
+    struct PendingMessage *next = GNUNET_CONTAINER_heap_peek (
+      vl->pending_wait_heap);
+    struct GNUNET_TIME_Relative delay =
+      GNUNET_TIME_absolute_get_remaining (next->next_attempt);
+
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "Too early for message %" PRIu64 "\n",
+                next->logging_uuid);
+    if ((GNUNET_NO == sc->to_early) ||
+        (GNUNET_TIME_relative_cmp (delay,
+                                   <,
+                                   sc->to_early_retry_delay)))
+      sc->to_early_retry_delay = delay;
+    sc->to_early = GNUNET_YES;
   }
 }
 
@@ -10994,6 +11239,7 @@ transmit_on_queue (void *cls)
   struct Neighbour *n = queue->neighbour;
   struct PendingMessageScoreContext sc;
   struct PendingMessage *pm;
+  struct GNUNET_TIME_Absolute now;
 
   queue->transmit_task = NULL;
   if (NULL == n->vl)
@@ -11006,6 +11252,21 @@ transmit_on_queue (void *cls)
     return;
   }
   memset (&sc, 0, sizeof(sc));
+  /* Messages too big for this queue may fit another one */
+  now = GNUNET_TIME_absolute_get ();
+  for (struct Queue *q = n->queue_head; NULL != q; q = q->next_neighbour)
+  {
+    size_t mtu;
+
+    if ((q == queue) ||
+        (q->validated_until.abs_value_us <= now.abs_value_us))
+      continue;
+    mtu = (0 == q->mtu)
+          ? UINT16_MAX - sizeof(struct GNUNET_TRANSPORT_SendMessageTo)
+          : q->mtu;
+    sc.other_mtu = GNUNET_MAX (sc.other_mtu,
+                               mtu);
+  }
   select_best_pending_from_link (&sc, queue, n->vl, NULL, 0);
   if (NULL == sc.best)
   {
@@ -11357,10 +11618,11 @@ free_queue_entry (struct QueueEntry *qe,
     if (NULL == pm->frag_parent)
     {
       vl = pm->vl;
-      if ((NULL != vl) &&
-          (NULL != vl->pending_msg_head) &&
-          (vl->pending_msg_head == pm))
+      if (NULL != vl)
+      {
+        index_pending_message (pm);
         check_vl_transmission (vl);
+      }
     }
   }
   GNUNET_free (qe);
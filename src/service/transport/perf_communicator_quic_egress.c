@@ -0,0 +1,373 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file transport/perf_communicator_quic_egress.c
+ * @brief measure how fast the QUIC communicator puts packets on the
+ *        wire: a fake connection hands #NUM_PACKETS packets to
+ *        flush_egress(), with at most #WINDOW of them unacknowledged,
+ *        and a socket in this process receives them over the loopback
+ *        device; with GSO and with sendmmsg(), and with the kernel
+ *        refusing part of the batches as with a full socket buffer,
+ *        in which case every packet must still arrive, in order
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "quiche.h"
+
+/**
+ * Number of packets we send per run.
+ */
+#define NUM_PACKETS 200000
+
+/**
+ * Number of packets that may be in flight, well below what the
+ * receive buffer holds.
+ */
+#define WINDOW 64
+
+/**
+ * Every how many calls does the kernel refuse to take packets?
+ */
+#define EAGAIN_EVERY 3
+
+/**
+ * At most how many packets does sendmmsg() take when we refuse
+ * part of the batches?
+ */
+#define PARTIAL_BATCH 5
+
+
+static struct sockaddr_in receiver_addr;
+
+static unsigned int produced;
+
+static unsigned int received;
+
+static int refuse;
+
+static unsigned int send_calls;
+
+static unsigned long long refused;
+
+
+/**
+ * Kernel that refuses every #EAGAIN_EVERY-th batch and takes at most
+ * #PARTIAL_BATCH packets of the others if @e refuse is set.
+ */
+static int
+perf_sendmmsg (int fd,
+               struct mmsghdr *msgs,
+               unsigned int vlen,
+               int flags)
+{
+  if (refuse)
+  {
+    if (0 == ++send_calls % EAGAIN_EVERY)
+    {
+      refused++;
+      errno = EAGAIN;
+      return -1;
+    }
+    vlen = GNUNET_MIN (vlen,
+                       PARTIAL_BATCH);
+  }
+  return sendmmsg (fd,
+                   msgs,
+                   vlen,
+                   flags);
+}
+
+
+/**
+ * Kernel that refuses every #EAGAIN_EVERY-th GSO super-packet if
+ * @e refuse is set.
+ */
+static ssize_t
+perf_sendmsg (int fd,
+              const struct msghdr *mh,
+              int flags)
+{
+  if ( (refuse) &&
+       (0 == ++send_calls % EAGAIN_EVERY) )
+  {
+    refused++;
+    errno = EAGAIN;
+    return -1;
+  }
+  return sendmsg (fd,
+                  mh,
+                  flags);
+}
+
+
+/**
+ * Connection that has #NUM_PACKETS full-sized packets to send, at
+ * most #WINDOW of them unacknowledged; each starts with its number.
+ */
+static ssize_t
+perf_quiche_conn_send (quiche_conn *conn,
+                       uint8_t *out,
+                       size_t out_len,
+                       quiche_send_info *out_info)
+{
+  uint32_t seq;
+
+  if ( (NUM_PACKETS == produced) ||
+       (produced - received >= WINDOW) )
+    return QUICHE_ERR_DONE;
+  memset (out,
+          0,
+          out_len);
+  seq = htonl (produced++);
+  GNUNET_memcpy (out,
+                 &seq,
+                 sizeof (seq));
+  memset (out_info,
+          0,
+          sizeof (*out_info));
+  GNUNET_memcpy (&out_info->to,
+                 &receiver_addr,
+                 sizeof (receiver_addr));
+  out_info->to_len = sizeof (receiver_addr);
+  return out_len;
+}
+
+
+static uint64_t
+perf_quiche_conn_timeout_as_nanos (const quiche_conn *conn)
+{
+  return UINT64_MAX;
+}
+
+
+/* our connection does no QUIC and our kernel may refuse packets */
+#define quiche_conn_send perf_quiche_conn_send
+#define quiche_conn_timeout_as_nanos perf_quiche_conn_timeout_as_nanos
+#define sendmmsg perf_sendmmsg
+#define sendmsg perf_sendmsg
+
+/* we drive the communicator from here, so we need our own main() */
+#define main gnunet_communicator_quic_main
+#include "gnunet-communicator-quic.c"
+#undef main
+
+
+static struct PeerAddress perf_peer;
+
+static struct quic_conn perf_conn;
+
+static struct GNUNET_NETWORK_Handle *recv_sock;
+
+static struct GNUNET_SCHEDULER_Task *recv_task;
+
+static struct GNUNET_SCHEDULER_Task *stall_task;
+
+static struct GNUNET_TIME_Absolute start;
+
+static int global_ret;
+
+
+static void
+report (void)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("%s%s: %u packets in %s (%llu/s), %llu batches refused\n",
+          (GNUNET_YES == gso_enabled) ? "GSO" : "sendmmsg",
+          refuse ? ", kernel refusing" : "",
+          NUM_PACKETS,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          NUM_PACKETS * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us),
+          refused);
+}
+
+
+static void
+stalled (void *cls)
+{
+  stall_task = NULL;
+  fprintf (stderr,
+           "%u of %u packets lost\n",
+           produced - received,
+           produced);
+  global_ret = 1;
+  GNUNET_SCHEDULER_shutdown ();
+}
+
+
+/**
+ * Receive what the communicator sent, and let the connection send
+ * more as the packets arrive.
+ */
+static void
+receive_packets (void *cls)
+{
+  uint8_t buf[UINT16_MAX];
+  ssize_t rcvd;
+  uint32_t seq;
+
+  recv_task = NULL;
+  while (0 < (rcvd = GNUNET_NETWORK_socket_recv (recv_sock,
+                                                 buf,
+                                                 sizeof (buf))))
+  {
+    GNUNET_memcpy (&seq,
+                   buf,
+                   sizeof (seq));
+    if ( (MAX_DATAGRAM_SIZE != rcvd) ||
+         (received != ntohl (seq)) )
+    {
+      fprintf (stderr,
+               "got packet %u of %zd bytes, wanted packet %u\n",
+               ntohl (seq),
+               rcvd,
+               received);
+      global_ret = 1;
+      GNUNET_SCHEDULER_shutdown ();
+      return;
+    }
+    received++;
+  }
+  if (NUM_PACKETS == received)
+  {
+    report ();
+    GNUNET_SCHEDULER_shutdown ();
+    return;
+  }
+  flush_egress (&perf_peer);
+  recv_task = GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                             recv_sock,
+                                             &receive_packets,
+                                             NULL);
+}
+
+
+static void
+cleanup (void *cls)
+{
+  if (NULL != recv_task)
+  {
+    GNUNET_SCHEDULER_cancel (recv_task);
+    recv_task = NULL;
+  }
+  if (NULL != stall_task)
+  {
+    GNUNET_SCHEDULER_cancel (stall_task);
+    stall_task = NULL;
+  }
+  if (NULL != perf_peer.write_task)
+  {
+    GNUNET_SCHEDULER_cancel (perf_peer.write_task);
+    perf_peer.write_task = NULL;
+  }
+  if (NULL != perf_peer.pacing_task)
+  {
+    GNUNET_SCHEDULER_cancel (perf_peer.pacing_task);
+    perf_peer.pacing_task = NULL;
+  }
+  GNUNET_free (perf_peer.blocked_buf);
+  GNUNET_break (GNUNET_OK ==
+                GNUNET_NETWORK_socket_close (recv_sock));
+  GNUNET_break (GNUNET_OK ==
+                GNUNET_NETWORK_socket_close (udp_sock));
+}
+
+
+static void
+perf_egress (void *cls)
+{
+  socklen_t addr_len = sizeof (receiver_addr);
+  int rcvbuf = 4 * 1024 * 1024;
+
+  produced = 0;
+  received = 0;
+  send_calls = 0;
+  refused = 0;
+  memset (&perf_peer,
+          0,
+          sizeof (perf_peer));
+  perf_conn.conn = (quiche_conn *) &perf_conn;
+  perf_peer.conn = &perf_conn;
+  memset (&receiver_addr,
+          0,
+          sizeof (receiver_addr));
+  receiver_addr.sin_family = AF_INET;
+  receiver_addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  recv_sock = GNUNET_NETWORK_socket_create (AF_INET,
+                                            SOCK_DGRAM,
+                                            0);
+  udp_sock = GNUNET_NETWORK_socket_create (AF_INET,
+                                           SOCK_DGRAM,
+                                           0);
+  GNUNET_assert ( (NULL != recv_sock) &&
+                  (NULL != udp_sock) );
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_NETWORK_socket_bind (recv_sock,
+                                             (const struct sockaddr *) &
+                                             receiver_addr,
+                                             sizeof (receiver_addr)));
+  GNUNET_assert (0 ==
+                 getsockname (GNUNET_NETWORK_get_fd (recv_sock),
+                              (struct sockaddr *) &receiver_addr,
+                              &addr_len));
+  GNUNET_break (GNUNET_OK ==
+                GNUNET_NETWORK_socket_setsockopt (recv_sock,
+                                                  SOL_SOCKET,
+                                                  SO_RCVBUF,
+                                                  &rcvbuf,
+                                                  sizeof (rcvbuf)));
+  GNUNET_SCHEDULER_add_shutdown (&cleanup,
+                                 NULL);
+  stall_task = GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_UNIT_MINUTES,
+                                             &stalled,
+                                             NULL);
+  recv_task = GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
+                                             recv_sock,
+                                             &receive_packets,
+                                             NULL);
+  start = GNUNET_TIME_absolute_get ();
+  flush_egress (&perf_peer);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  GNUNET_log_setup ("perf-communicator-quic-egress",
+                    "WARNING",
+                    NULL);
+  for (int gso = GNUNET_YES; gso >= GNUNET_NO; gso--)
+  {
+    for (refuse = 0; refuse <= 1; refuse++)
+    {
+      gso_enabled = gso;
+      GNUNET_SCHEDULER_run (&perf_egress,
+                            NULL);
+    }
+  }
+  return global_ret;
+}
+
+
+/* end of perf_communicator_quic_egress.c */
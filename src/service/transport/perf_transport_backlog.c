@@ -0,0 +1,344 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2026 GNUnet e.V.
+
+     GNUnet is free software: you can redistribute it and/or modify it
+     under the terms of the GNU Affero General Public License as published
+     by the Free Software Foundation, either version 3 of the License,
+     or (at your option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Affero General Public License for more details.
+
+     You should have received a copy of the GNU Affero General Public License
+     along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+     SPDX-License-Identifier: AGPL3.0-or-later
+ */
+
+/**
+ * @file transport/perf_transport_backlog.c
+ * @brief measure how fast the transport service drains a large backlog
+ *        of messages to a neighbour through two local communicators,
+ *        one with a small MTU and one without; the communicators live
+ *        in this process and acknowledge every message right away, so
+ *        that we only measure how the service picks the next message
+ *        for a queue
+ */
+
+/* we drive the service from here, so we need our own main() */
+#define main gnunet_service_transport_main
+#include "gnunet-service-transport.c"
+#undef main
+
+/**
+ * MTU of the first communicator.
+ */
+#define SMALL_MTU 1400
+
+/**
+ * Every how many messages is one too big for #SMALL_MTU?
+ */
+#define LARGE_EVERY 5
+
+/**
+ * Maximum size of the messages that are too big for #SMALL_MTU.
+ */
+#define LARGE_MAX 8192
+
+
+/**
+ * One of our local communicators.
+ */
+struct Communicator
+{
+  /**
+   * The communicator as the service sees it.
+   */
+  struct TransportClient tc;
+
+  /**
+   * Our queue to the neighbour.
+   */
+  struct Queue queue;
+
+  /**
+   * Number of messages given to us.
+   */
+  unsigned long long messages;
+
+  /**
+   * Number of fragments among @e messages.
+   */
+  unsigned long long fragments;
+};
+
+
+static struct Communicator comms[2];
+
+static struct Neighbour neighbour;
+
+static struct VirtualLink *vl;
+
+static unsigned int backlog;
+
+static unsigned long long large_messages;
+
+static struct GNUNET_TIME_Absolute start;
+
+static int global_ret;
+
+
+static void
+report (void)
+{
+  struct GNUNET_TIME_Relative dur;
+
+  dur = GNUNET_TIME_absolute_get_duration (start);
+  printf ("backlog of %u (%llu large): drained in %s (%llu/s); %llu"
+          " messages and %llu fragments via MTU %u, %llu via no MTU\n",
+          backlog,
+          large_messages,
+          GNUNET_STRINGS_relative_time_to_string (dur,
+                                                  GNUNET_YES),
+          backlog * 1000000LLU / GNUNET_MAX (1, dur.rel_value_us),
+          comms[0].messages - comms[0].fragments,
+          comms[0].fragments,
+          SMALL_MTU,
+          comms[1].messages);
+}
+
+
+static void
+ack_message (void *cls)
+{
+  struct Communicator *comm = cls;
+
+  GNUNET_assert (NULL != comm->queue.queue_head);
+  free_queue_entry (comm->queue.queue_head,
+                    &comm->tc);
+  if ((NULL == vl->pending_msg_head) &&
+      (NULL == comms[0].queue.queue_head) &&
+      (NULL == comms[1].queue.queue_head))
+  {
+    report ();
+    GNUNET_SCHEDULER_shutdown ();
+  }
+}
+
+
+/**
+ * The service gives a message to a communicator, which acknowledges
+ * it as soon as possible.
+ */
+static void
+communicator_send (struct GNUNET_MQ_Handle *mq,
+                   const struct GNUNET_MessageHeader *msg,
+                   void *impl_state)
+{
+  struct Communicator *comm = impl_state;
+  const struct GNUNET_TRANSPORT_SendMessageTo *smt =
+    (const struct GNUNET_TRANSPORT_SendMessageTo *) msg;
+  const struct GNUNET_MessageHeader *payload =
+    (const struct GNUNET_MessageHeader *) &smt[1];
+
+  GNUNET_assert (GNUNET_MESSAGE_TYPE_TRANSPORT_SEND_MSG == ntohs (msg->type));
+  comm->messages++;
+  if (GNUNET_MESSAGE_TYPE_TRANSPORT_FRAGMENT == ntohs (payload->type))
+    comm->fragments++;
+  else if ((0 != comm->queue.mtu) &&
+           (ntohs (msg->size) - sizeof (*smt) > comm->queue.mtu))
+    global_ret = 1;
+  GNUNET_MQ_impl_send_continue (mq);
+  GNUNET_SCHEDULER_add_now (&ack_message,
+                            comm);
+}
+
+
+static void
+communicator_destroy (struct GNUNET_MQ_Handle *mq,
+                      void *impl_state)
+{
+}
+
+
+static void
+communicator_cancel (struct GNUNET_MQ_Handle *mq,
+                     void *impl_state)
+{
+  GNUNET_assert (0);
+}
+
+
+static void
+setup_communicator (struct Communicator *comm,
+                    const char *prefix,
+                    uint32_t qid,
+                    uint32_t mtu)
+{
+  memset (comm,
+          0,
+          sizeof (*comm));
+  comm->tc.type = CT_COMMUNICATOR;
+  comm->tc.details.communicator.address_prefix = (char *) prefix;
+  comm->tc.details.communicator.cc = GNUNET_TRANSPORT_CC_RELIABLE;
+  comm->tc.mq = GNUNET_MQ_queue_for_callbacks (&communicator_send,
+                                               &communicator_destroy,
+                                               &communicator_cancel,
+                                               comm,
+                                               NULL,
+                                               NULL,
+                                               NULL);
+  comm->queue.tc = &comm->tc;
+  comm->queue.neighbour = &neighbour;
+  comm->queue.address = prefix;
+  comm->queue.qid = qid;
+  comm->queue.mtu = mtu;
+  comm->queue.unlimited_length = GNUNET_YES;
+  comm->queue.q_capacity = UINT64_MAX;
+  comm->queue.idle = GNUNET_YES;
+  comm->queue.validated_until = GNUNET_TIME_UNIT_FOREVER_ABS;
+  comm->queue.pd.aged_rtt = GNUNET_TIME_UNIT_FOREVER_REL;
+  GNUNET_CONTAINER_MDLL_insert (client,
+                                comm->tc.details.communicator.queue_head,
+                                comm->tc.details.communicator.queue_tail,
+                                &comm->queue);
+  GNUNET_CONTAINER_MDLL_insert (neighbour,
+                                neighbour.queue_head,
+                                neighbour.queue_tail,
+                                &comm->queue);
+}
+
+
+/**
+ * Queue a message from CORE, as #handle_client_send() does.
+ */
+static void
+add_message (uint16_t size)
+{
+  struct PendingMessage *pm;
+  struct GNUNET_MessageHeader *hdr;
+
+  pm = GNUNET_malloc (sizeof (struct PendingMessage) + size);
+  pm->logging_uuid = logging_uuid_gen++;
+  pm->prefs = GNUNET_MQ_PRIO_BEST_EFFORT;
+  pm->vl = vl;
+  pm->bytes_msg = size;
+  hdr = (struct GNUNET_MessageHeader *) &pm[1];
+  hdr->size = htons (size);
+  hdr->type = htons (GNUNET_MESSAGE_TYPE_DUMMY);
+  GNUNET_CONTAINER_MDLL_insert (vl,
+                                vl->pending_msg_head,
+                                vl->pending_msg_tail,
+                                pm);
+  index_pending_message (pm);
+}
+
+
+static void
+cleanup (void *cls)
+{
+  GNUNET_CONTAINER_multiuuidmap_iterate (pending_acks,
+                                         &free_pending_ack_cb,
+                                         NULL);
+  for (unsigned int i = 0; i < 2; i++)
+  {
+    if (NULL != comms[i].queue.transmit_task)
+    {
+      GNUNET_SCHEDULER_cancel (comms[i].queue.transmit_task);
+      comms[i].queue.transmit_task = NULL;
+    }
+    if (NULL != comms[i].tc.details.communicator.free_queue_entry_task)
+    {
+      GNUNET_SCHEDULER_cancel (
+        comms[i].tc.details.communicator.free_queue_entry_task);
+      comms[i].tc.details.communicator.free_queue_entry_task = NULL;
+    }
+    GNUNET_MQ_destroy (comms[i].tc.mq);
+  }
+  while (NULL != vl->pending_msg_head)
+  {
+    global_ret = 1;
+    free_pending_message (vl->pending_msg_head);
+  }
+  if (NULL != vl->pending_wait_heap)
+    GNUNET_CONTAINER_heap_destroy (vl->pending_wait_heap);
+  GNUNET_free (vl);
+}
+
+
+static void
+perf_backlog (void *cls)
+{
+  memset (&neighbour,
+          0,
+          sizeof (neighbour));
+  GNUNET_CRYPTO_random_block (GNUNET_CRYPTO_QUALITY_WEAK,
+                              &neighbour.pid,
+                              sizeof (neighbour.pid));
+  vl = GNUNET_new (struct VirtualLink);
+  vl->target = neighbour.pid;
+  vl->n = &neighbour;
+  vl->confirmed = GNUNET_YES;
+  vl->outbound_fc_window_size = UINT64_MAX / 2;
+  neighbour.vl = vl;
+  setup_communicator (&comms[0],
+                      "perf-small-mtu",
+                      1,
+                      SMALL_MTU);
+  setup_communicator (&comms[1],
+                      "perf-no-mtu",
+                      2,
+                      0);
+  large_messages = 0;
+  for (unsigned int i = 0; i < backlog; i++)
+  {
+    if (0 == i % LARGE_EVERY)
+    {
+      add_message (SMALL_MTU
+                   + GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                               LARGE_MAX - SMALL_MTU));
+      large_messages++;
+    }
+    else
+    {
+      add_message (sizeof (struct GNUNET_MessageHeader)
+                   + GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                               SMALL_MTU / 2));
+    }
+  }
+  GNUNET_SCHEDULER_add_shutdown (&cleanup,
+                                 NULL);
+  start = GNUNET_TIME_absolute_get ();
+  check_vl_transmission (vl);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  static const unsigned int backlogs[] = {
+    1000,
+    10000,
+    50000
+  };
+
+  GNUNET_log_setup ("perf-transport-backlog",
+                    "WARNING",
+                    NULL);
+  pending_acks = GNUNET_CONTAINER_multiuuidmap_create (32768,
+                                                       GNUNET_YES);
+  for (unsigned int i = 0; i < sizeof (backlogs) / sizeof (backlogs[0]); i++)
+  {
+    backlog = backlogs[i];
+    GNUNET_SCHEDULER_run (&perf_backlog,
+                          NULL);
+  }
+  GNUNET_CONTAINER_multiuuidmap_destroy (pending_acks);
+  return global_ret;
+}
+
+
+/* end of perf_transport_backlog.c */
@@ -210,10 +210,26 @@ struct ChannelState
   struct GNUNET_REGEX_Search *search;
 
   /**
-   * Entry for this entry in the channel_heap, NULL as long as this
-   * channel state is not fully bound.
+   * Next entry in the #channel_lru_head clock list.
    */
-  struct GNUNET_CONTAINER_HeapNode *heap_node;
+  struct ChannelState *next_lru;
+
+  /**
+   * Previous entry in the #channel_lru_head clock list.
+   */
+  struct ChannelState *prev_lru;
+
+  /**
+   * #GNUNET_YES once this channel state is bound to an IP/port tuple,
+   * that is, it is in the #channel_map and the clock list.
+   */
+  int is_bound;
+
+  /**
+   * #GNUNET_YES if we saw traffic on this channel since the clock
+   * hand last passed over it (second-chance bit).
+   */
+  int lru_referenced;
 
   /**
    * Head of list of messages scheduled for transmission.
@@ -332,10 +348,22 @@ static struct GNUNET_CONTAINER_Heap *destination_heap;
 static struct GNUNET_CONTAINER_MultiHashMap *channel_map;
 
 /**
- * Min-Heap sorted by activity time to expire old mappings; values are
- * of type 'struct ChannelState'.
+ * Head of the clock list used to expire old mappings.  Bound channels
+ * are appended at the tail; the clock hand starts at the head and gives
+ * recently used channels a second chance.
+ */
+static struct ChannelState *channel_lru_head;
+
+/**
+ * Tail of the clock list used to expire old mappings.
+ */
+static struct ChannelState *channel_lru_tail;
+
+/**
+ * Random key for #GNUNET_TUN_flow_hash(), so that remote parties cannot
+ * predict which flows end up in the same #channel_map bucket.
  */
-static struct GNUNET_CONTAINER_Heap *channel_heap;
+static uint64_t flow_hash_key;
 
 /**
  * Statistics.
@@ -421,12 +449,16 @@ get_channel_key_from_ips (int af,
                           uint16_t destination_port,
                           struct GNUNET_HashCode *key)
 {
+  char *start;
   char *off;
+  uint32_t bucket;
 
   memset (key, 0, sizeof(struct GNUNET_HashCode));
-  /* the GNUnet hashmap only uses the first sizeof(unsigned int) of the hash,
-     so we put the ports in there (and hope for few collisions) */
-  off = (char *) key;
+  /* the GNUnet hashmap only uses the first sizeof(unsigned int) of the hash
+     to pick a bucket, so we put a keyed hash of the tuple there; the rest
+     of the key is the tuple itself, so distinct flows never compare equal */
+  start = ((char *) key) + sizeof(uint32_t);
+  off = start;
   GNUNET_memcpy (off, &source_port, sizeof(uint16_t));
   off += sizeof(uint16_t);
   GNUNET_memcpy (off, &destination_port, sizeof(uint16_t));
@@ -452,7 +484,24 @@ get_channel_key_from_ips (int af,
     break;
   }
   GNUNET_memcpy (off, &protocol, sizeof(uint8_t));
-  /* off += sizeof (uint8_t);  */
+  off += sizeof(uint8_t);
+  bucket = GNUNET_TUN_flow_hash (flow_hash_key,
+                                 start,
+                                 off - start);
+  GNUNET_memcpy (key, &bucket, sizeof(uint32_t));
+}
+
+
+/**
+ * Mark a channel as recently used, so that the clock hand in
+ * #expire_channel() skips it once.
+ *
+ * @param ts channel that saw traffic
+ */
+static void
+touch_channel (struct ChannelState *ts)
+{
+  ts->lru_referenced = GNUNET_YES;
 }
 
 
@@ -536,10 +585,13 @@ free_channel_state (struct ChannelState *ts)
     GNUNET_REGEX_search_cancel (ts->search);
     ts->search = NULL;
   }
-  if (NULL != ts->heap_node)
+  if (GNUNET_YES == ts->is_bound)
   {
-    GNUNET_CONTAINER_heap_remove_node (ts->heap_node);
-    ts->heap_node = NULL;
+    GNUNET_CONTAINER_MDLL_remove (lru,
+                                  channel_lru_head,
+                                  channel_lru_tail,
+                                  ts);
+    ts->is_bound = GNUNET_NO;
     get_channel_key_from_ips (ts->af,
                               ts->protocol,
                               &ts->source_ip,
@@ -704,7 +756,7 @@ check_icmp_back (void *cls, const struct GNUNET_EXIT_IcmpToVPNMessage *i2v)
 {
   struct ChannelState *ts = cls;
 
-  if (NULL == ts->heap_node)
+  if (GNUNET_YES != ts->is_bound)
   {
     GNUNET_break_op (0);
     return GNUNET_SYSERR;
@@ -1061,8 +1113,7 @@ handle_icmp_back (void *cls, const struct GNUNET_EXIT_IcmpToVPNMessage *i2v)
   default:
     GNUNET_assert (0);
   }
-  GNUNET_CONTAINER_heap_update_cost (ts->heap_node,
-                                     GNUNET_TIME_absolute_get ().abs_value_us);
+  touch_channel (ts);
   GNUNET_CADET_receive_done (ts->channel);
 }
 
@@ -1080,7 +1131,7 @@ check_udp_back (void *cls, const struct GNUNET_EXIT_UdpReplyMessage *reply)
 {
   struct ChannelState *ts = cls;
 
-  if (NULL == ts->heap_node)
+  if (GNUNET_YES != ts->is_bound)
   {
     GNUNET_break_op (0);
     return GNUNET_SYSERR;
@@ -1211,8 +1262,7 @@ handle_udp_back (void *cls, const struct GNUNET_EXIT_UdpReplyMessage *reply)
   default:
     GNUNET_assert (0);
   }
-  GNUNET_CONTAINER_heap_update_cost (ts->heap_node,
-                                     GNUNET_TIME_absolute_get ().abs_value_us);
+  touch_channel (ts);
   GNUNET_CADET_receive_done (ts->channel);
 }
 
@@ -1230,7 +1280,7 @@ check_tcp_back (void *cls, const struct GNUNET_EXIT_TcpDataMessage *data)
 {
   struct ChannelState *ts = cls;
 
-  if (NULL == ts->heap_node)
+  if (GNUNET_YES != ts->is_bound)
   {
     GNUNET_break_op (0);
     return GNUNET_SYSERR;
@@ -1345,8 +1395,7 @@ handle_tcp_back (void *cls, const struct GNUNET_EXIT_TcpDataMessage *data)
     }
     break;
   }
-  GNUNET_CONTAINER_heap_update_cost (ts->heap_node,
-                                     GNUNET_TIME_absolute_get ().abs_value_us);
+  touch_channel (ts);
   GNUNET_CADET_receive_done (ts->channel);
 }
 
@@ -1543,7 +1592,9 @@ create_channel_to_destination (struct DestinationChannel *dt, int client_af)
 
 
 /**
- * We have too many active channels.  Clean up the oldest channel.
+ * We have too many active channels.  Clean up the least recently used
+ * channel, approximated by advancing the clock hand over the channel
+ * list until we find one that saw no traffic since the last pass.
  *
  * @param except channel that must NOT be cleaned up, even if it is the oldest
  */
@@ -1552,13 +1603,30 @@ expire_channel (struct ChannelState *except)
 {
   struct ChannelState *ts;
 
-  ts = GNUNET_CONTAINER_heap_peek (channel_heap);
-  GNUNET_assert (NULL != ts);
-  if (except == ts)
-    return; /* can't do this */
+  while (1)
+  {
+    ts = channel_lru_head;
+    GNUNET_assert (NULL != ts);
+    if ((except == ts) &&
+        (channel_lru_head == channel_lru_tail))
+      return; /* nothing else to clean up */
+    if ((except != ts) &&
+        (GNUNET_YES != ts->lru_referenced))
+      break;
+    /* give it a second chance; never clean up @a except */
+    ts->lru_referenced = GNUNET_NO;
+    GNUNET_CONTAINER_MDLL_remove (lru,
+                                  channel_lru_head,
+                                  channel_lru_tail,
+                                  ts);
+    GNUNET_CONTAINER_MDLL_insert_tail (lru,
+                                       channel_lru_head,
+                                       channel_lru_tail,
+                                       ts);
+  }
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Tearing down expired channel to %s\n",
-              print_channel_destination (&except->destination));
+              print_channel_destination (&ts->destination));
   free_channel_state (ts);
 }
 
@@ -1784,10 +1852,11 @@ route_packet (struct DestinationEntry *destination,
     }
     ts->source_port = source_port;
     ts->destination_port = destination_port;
-    ts->heap_node =
-      GNUNET_CONTAINER_heap_insert (channel_heap,
-                                    ts,
-                                    GNUNET_TIME_absolute_get ().abs_value_us);
+    ts->is_bound = GNUNET_YES;
+    GNUNET_CONTAINER_MDLL_insert_tail (lru,
+                                       channel_lru_head,
+                                       channel_lru_tail,
+                                       ts);
     GNUNET_assert (GNUNET_YES ==
                    GNUNET_CONTAINER_multihashmap_put (
                      channel_map,
@@ -1798,15 +1867,14 @@ route_packet (struct DestinationEntry *destination,
                               gettext_noop ("# Active channels"),
                               1,
                               GNUNET_NO);
-    while (GNUNET_CONTAINER_multihashmap_size (channel_map) >
-           max_channel_mappings)
+    while ((GNUNET_CONTAINER_multihashmap_size (channel_map) >
+            max_channel_mappings) &&
+           (channel_lru_head != channel_lru_tail))
       expire_channel (ts);
   }
   else
   {
-    GNUNET_CONTAINER_heap_update_cost (ts->heap_node,
-                                       GNUNET_TIME_absolute_get ()
-                                       .abs_value_us);
+    touch_channel (ts);
   }
   if (NULL == ts->channel)
   {
@@ -2859,11 +2927,6 @@ cleanup (void *cls)
     GNUNET_CONTAINER_multihashmap_destroy (channel_map);
     channel_map = NULL;
   }
-  if (NULL != channel_heap)
-  {
-    GNUNET_CONTAINER_heap_destroy (channel_heap);
-    channel_heap = NULL;
-  }
   if (NULL != cadet_handle)
   {
     GNUNET_CADET_disconnect (cadet_handle);
@@ -2979,7 +3042,8 @@ run (void *cls,
     GNUNET_CONTAINER_heap_create (GNUNET_CONTAINER_HEAP_ORDER_MIN);
   channel_map =
     GNUNET_CONTAINER_multihashmap_create (max_channel_mappings * 2, GNUNET_NO);
-  channel_heap = GNUNET_CONTAINER_heap_create (GNUNET_CONTAINER_HEAP_ORDER_MIN);
+  flow_hash_key = GNUNET_CRYPTO_random_u64 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                            UINT64_MAX);
 
 
   vpn_argv[0] = GNUNET_strdup ("vpn-gnunet");